@@ -5,11 +5,52 @@ layout(location = 1) in vec2 inUV;
 
 uniform mat4 gMVP;
 
+// joints of GPU skinned models relative to the bind pose, three rows per joint
+layout(std140) uniform gSkinJoints {
+    vec4 gJoints[256 * 3];
+};
+
+uniform int gSkinning;
+
+layout(location = 6) in vec4 inJointIndexes;
+layout(location = 7) in vec4 inJointWeights;
+
+// blends the rows of the joint matrices that influence the vertex
+void SkinningRows(out vec4 row0, out vec4 row1, out vec4 row2) {
+    ivec4 joints = ivec4(inJointIndexes) * 3;
+
+    row0 = gJoints[joints.x + 0] * inJointWeights.x + gJoints[joints.y + 0] * inJointWeights.y
+         + gJoints[joints.z + 0] * inJointWeights.z + gJoints[joints.w + 0] * inJointWeights.w;
+    row1 = gJoints[joints.x + 1] * inJointWeights.x + gJoints[joints.y + 1] * inJointWeights.y
+         + gJoints[joints.z + 1] * inJointWeights.z + gJoints[joints.w + 1] * inJointWeights.w;
+    row2 = gJoints[joints.x + 2] * inJointWeights.x + gJoints[joints.y + 2] * inJointWeights.y
+         + gJoints[joints.z + 2] * inJointWeights.z + gJoints[joints.w + 2] * inJointWeights.w;
+}
+
+vec3 SkinPoint(vec4 row0, vec4 row1, vec4 row2, vec3 p) {
+    vec4 p4 = vec4(p, 1.0f);
+    return vec3(dot(row0, p4), dot(row1, p4), dot(row2, p4));
+}
+
+vec3 SkinVector(vec4 row0, vec4 row1, vec4 row2, vec3 v) {
+    return vec3(dot(row0.xyz, v), dot(row1.xyz, v), dot(row2.xyz, v));
+}
+
+// the depth, unlit and interaction passes have to end up with the same depth
+invariant gl_Position;
+
 out vec2 v2fUV;
 
 void main() {
+    vec3 pos = inPos;
+    if (gSkinning != 0) {
+        vec4 row0, row1, row2;
+        SkinningRows(row0, row1, row2);
+        pos = SkinPoint(row0, row1, row2, inPos);
+    }
+
     v2fUV = inUV;
-    gl_Position = gMVP * vec4(inPos, 1.0f);
+    gl_Position = gMVP * vec4(pos, 1.0f);
 }
 
 #endif // VERTEX_SHADER
@@ -7,6 +7,30 @@ struct Vertex2Fragment {
     vec2 uvDiffuse;
     vec2 uvSpecular;
     vec4 Color;
+    vec3 WorldPos;
+};
+
+// per draw parameters, the renderer uploads these for all
+// interactions of a light at once (gl33InteractionParms_t)
+layout(std140) uniform gInteractionParms {
+    mat4 gMVP;
+    mat4 gModelMatrix;
+    vec4 gLightOrigin;
+    vec4 gViewOrigin;
+    vec4 gLightProject_S;
+    vec4 gLightProject_T;
+    vec4 gLightProject_Q;
+    vec4 gLightFalloff_S;
+    vec4 gBumpMatrix_S;
+    vec4 gBumpMatrix_T;
+    vec4 gDiffuseMatrix_S;
+    vec4 gDiffuseMatrix_T;
+    vec4 gSpecularMatrix_S;
+    vec4 gSpecularMatrix_T;
+    vec4 gColorMod;
+    vec4 gColorAdd;
+    vec4 gDiffuseModifier;
+    vec4 gSpecularModifier;
 };
 
 #ifdef VERTEX_SHADER
@@ -18,34 +42,64 @@ layout(location = 3) in vec3 inTangent;
 layout(location = 4) in vec3 inBinormal;
 layout(location = 5) in vec4 inColor;
 
-uniform mat4 gMVP;
-uniform mat4 gModel;
-
-uniform vec4 gLightOrigin;
-uniform vec4 gViewOrigin;
-uniform vec4 gLightProject_S;
-uniform vec4 gLightProject_T;
-uniform vec4 gLightProject_Q;
-uniform vec4 gLightFalloff_S;
-uniform vec4 gBumpMatrix_S;
-uniform vec4 gBumpMatrix_T;
-uniform vec4 gDiffuseMatrix_S;
-uniform vec4 gDiffuseMatrix_T;
-uniform vec4 gSpecularMatrix_S;
-uniform vec4 gSpecularMatrix_T;
-uniform vec4 gColorMod;
-uniform vec4 gColorAdd;
+// joints of GPU skinned models relative to the bind pose, three rows per joint
+layout(std140) uniform gSkinJoints {
+    vec4 gJoints[256 * 3];
+};
+
+uniform int gSkinning;
+
+layout(location = 6) in vec4 inJointIndexes;
+layout(location = 7) in vec4 inJointWeights;
+
+// blends the rows of the joint matrices that influence the vertex
+void SkinningRows(out vec4 row0, out vec4 row1, out vec4 row2) {
+    ivec4 joints = ivec4(inJointIndexes) * 3;
+
+    row0 = gJoints[joints.x + 0] * inJointWeights.x + gJoints[joints.y + 0] * inJointWeights.y
+         + gJoints[joints.z + 0] * inJointWeights.z + gJoints[joints.w + 0] * inJointWeights.w;
+    row1 = gJoints[joints.x + 1] * inJointWeights.x + gJoints[joints.y + 1] * inJointWeights.y
+         + gJoints[joints.z + 1] * inJointWeights.z + gJoints[joints.w + 1] * inJointWeights.w;
+    row2 = gJoints[joints.x + 2] * inJointWeights.x + gJoints[joints.y + 2] * inJointWeights.y
+         + gJoints[joints.z + 2] * inJointWeights.z + gJoints[joints.w + 2] * inJointWeights.w;
+}
+
+vec3 SkinPoint(vec4 row0, vec4 row1, vec4 row2, vec3 p) {
+    vec4 p4 = vec4(p, 1.0f);
+    return vec3(dot(row0, p4), dot(row1, p4), dot(row2, p4));
+}
+
+vec3 SkinVector(vec4 row0, vec4 row1, vec4 row2, vec3 v) {
+    return vec3(dot(row0.xyz, v), dot(row1.xyz, v), dot(row2.xyz, v));
+}
+
+// the depth, unlit and interaction passes have to end up with the same depth
+invariant gl_Position;
 
 out Vertex2Fragment v2f;
 
 void main() {
-    vec4 vPos = vec4(inPos, 1.0f);
+    vec3 pos = inPos;
+    vec3 normal = inNormal;
+    vec3 tangent = inTangent;
+    vec3 binormal = inBinormal;
+
+    if (gSkinning != 0) {
+        vec4 row0, row1, row2;
+        SkinningRows(row0, row1, row2);
+        pos = SkinPoint(row0, row1, row2, inPos);
+        normal = SkinVector(row0, row1, row2, inNormal);
+        tangent = SkinVector(row0, row1, row2, inTangent);
+        binormal = SkinVector(row0, row1, row2, inBinormal);
+    }
 
-    vec3 toLight = normalize(gLightOrigin.xyz - inPos);
-    vec3 toViewer = normalize(gViewOrigin.xyz - inPos);
+    vec4 vPos = vec4(pos, 1.0f);
+
+    vec3 toLight = normalize(gLightOrigin.xyz - pos);
+    vec3 toViewer = normalize(gViewOrigin.xyz - pos);
 
     // put toViewer vec to tangent space
-    mat3 TBN = mat3(inTangent, inBinormal, inNormal);
+    mat3 TBN = mat3(tangent, binormal, normal);
     v2f.ToLight = toLight * TBN;
 
     vec4 tcV4 = vec4(inUV, 0.0f, 1.0f);
@@ -71,6 +125,8 @@ void main() {
 
     v2f.Color = inColor * gColorMod + gColorAdd;
 
+    v2f.WorldPos = (gModelMatrix * vPos).xyz;
+
     gl_Position = gMVP * vPos;
 }
 
@@ -87,13 +143,61 @@ uniform sampler2D   gTexDiffuse;
 uniform sampler2D   gTexSpecular;
 uniform sampler2D   gTexSpecularLUT;
 
-uniform vec4        gDiffuseModifier;
-uniform vec4        gSpecularModifier;
-uniform vec4        gLocalLightOrigin;
-uniform vec4        gLocalViewOrigin;
+// shadow maps of the light, gShadowMode is 0 = none, 1 = projected, 2 = cascades, 3 = cube
+uniform int                 gShadowMode;
+uniform mat4                gShadowMatrices[4];     // global position to atlas coordinates and depth
+uniform vec4                gShadowCascadeSplits;   // view distance where each cascade ends
+uniform vec4                gShadowViewPlane;       // view distance of a global position
+uniform vec4                gShadowLightOrigin;     // global origin of point lights
+uniform vec4                gShadowParms;           // cube near, cube far, filter offset, number of cascades
+uniform sampler2DShadow     gTexShadowAtlas;
+uniform samplerCubeShadow   gTexShadowCube;
 
 in Vertex2Fragment v2f;
 
+float ShadowAtlas(mat4 shadowMatrix) {
+    vec4 coord = shadowMatrix * vec4(v2f.WorldPos, 1.0f);
+    if (gShadowParms.z == 0.0f) {
+        return textureProj(gTexShadowAtlas, coord);
+    }
+
+    // four filtered samples around the position
+    vec3 c = coord.xyz / coord.w;
+    float o = gShadowParms.z;
+    return 0.25f * (texture(gTexShadowAtlas, vec3(c.x - o, c.y - o, c.z))
+                  + texture(gTexShadowAtlas, vec3(c.x + o, c.y - o, c.z))
+                  + texture(gTexShadowAtlas, vec3(c.x - o, c.y + o, c.z))
+                  + texture(gTexShadowAtlas, vec3(c.x + o, c.y + o, c.z)));
+}
+
+float Shadow() {
+    if (gShadowMode == 1) {
+        return ShadowAtlas(gShadowMatrices[0]);
+    }
+
+    if (gShadowMode == 2) {
+        // the first cascade that reaches past the fragment
+        float dist = dot(gShadowViewPlane.xyz, v2f.WorldPos) + gShadowViewPlane.w;
+        int cascade = int(dot(step(gShadowCascadeSplits, vec4(dist)), vec4(1.0f)));
+        if (cascade >= int(gShadowParms.w)) {
+            return 1.0f;
+        }
+        return ShadowAtlas(gShadowMatrices[cascade]);
+    }
+
+    if (gShadowMode == 3) {
+        // the depth the face of the major axis has stored
+        vec3 dir = v2f.WorldPos - gShadowLightOrigin.xyz;
+        float z = max(abs(dir.x), max(abs(dir.y), abs(dir.z)));
+        float n = gShadowParms.x;
+        float f = gShadowParms.y;
+        float depth = (f + n) / (f - n) - 2.0f * f * n / ((f - n) * z);
+        return texture(gTexShadowCube, vec4(dir, depth * 0.5f + 0.5f));
+    }
+
+    return 1.0f;
+}
+
 out vec4 oRT0;
 
 void main() {
@@ -124,6 +228,9 @@ void main() {
     // modulate by the light falloff
     light *= texture(gTexLightFalloff, v2f.uvLightFalloff);
 
+    // modulate by the shadow maps
+    light *= Shadow();
+
     //
     // the light will be modulated by the diffuse and
     // specular surface characteristics
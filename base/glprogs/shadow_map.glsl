@@ -0,0 +1,54 @@
+#ifdef VERTEX_SHADER
+
+layout(location = 0) in vec3 inPos;
+
+uniform mat4 gMVP;
+
+// joints of GPU skinned models relative to the bind pose, three rows per joint
+layout(std140) uniform gSkinJoints {
+    vec4 gJoints[256 * 3];
+};
+
+uniform int gSkinning;
+
+layout(location = 6) in vec4 inJointIndexes;
+layout(location = 7) in vec4 inJointWeights;
+
+// blends the rows of the joint matrices that influence the vertex
+void SkinningRows(out vec4 row0, out vec4 row1, out vec4 row2) {
+    ivec4 joints = ivec4(inJointIndexes) * 3;
+
+    row0 = gJoints[joints.x + 0] * inJointWeights.x + gJoints[joints.y + 0] * inJointWeights.y
+         + gJoints[joints.z + 0] * inJointWeights.z + gJoints[joints.w + 0] * inJointWeights.w;
+    row1 = gJoints[joints.x + 1] * inJointWeights.x + gJoints[joints.y + 1] * inJointWeights.y
+         + gJoints[joints.z + 1] * inJointWeights.z + gJoints[joints.w + 1] * inJointWeights.w;
+    row2 = gJoints[joints.x + 2] * inJointWeights.x + gJoints[joints.y + 2] * inJointWeights.y
+         + gJoints[joints.z + 2] * inJointWeights.z + gJoints[joints.w + 2] * inJointWeights.w;
+}
+
+vec3 SkinPoint(vec4 row0, vec4 row1, vec4 row2, vec3 p) {
+    vec4 p4 = vec4(p, 1.0f);
+    return vec3(dot(row0, p4), dot(row1, p4), dot(row2, p4));
+}
+
+void main() {
+    vec3 pos = inPos;
+    if (gSkinning != 0) {
+        vec4 row0, row1, row2;
+        SkinningRows(row0, row1, row2);
+        pos = SkinPoint(row0, row1, row2, inPos);
+    }
+
+    gl_Position = gMVP * vec4(pos, 1.0f);
+}
+
+#endif // VERTEX_SHADER
+
+
+#ifdef FRAGMENT_SHADER
+
+// only the depth of the shadow casters is written
+void main() {
+}
+
+#endif // FRAGMENT_SHADER
@@ -194,6 +194,7 @@ int				g_thread_count;
 
 void			Sys_CreateThread( xthread_t function, void *parms, xthreadPriority priority, xthreadInfo &info, const char *name, xthreadInfo *threads[MAX_THREADS], int *thread_count ) {}
 void			Sys_DestroyThread( xthreadInfo& info ) {}
+void			Sys_WaitThread( xthreadInfo& info ) {}
 
 void			Sys_EnterCriticalSection( int index ) {}
 void			Sys_LeaveCriticalSection( int index ) {}
@@ -3339,6 +3339,7 @@ idCollisionModelManagerLocal::LoadMap
 ================
 */
 void idCollisionModelManagerLocal::LoadMap( const idMapFile *mapFile ) {
+	idScopedMemTag	memTag( MEM_TAG_COLLISION );
 
 	if ( mapFile == NULL ) {
 		common->Error( "idCollisionModelManagerLocal::LoadMap: NULL mapFile" );
@@ -361,6 +361,10 @@ void idCommonLocal::VPrintf( const char *fmt, va_list args ) {
 		return;
 	}
 
+	// level load jobs may print while the main thread does, so
+	// keep the console and log output of every print together
+	Sys_EnterCriticalSection( CRITICAL_SECTION_FOUR );
+
 	// echo to console buffer
 	console->Print( msg );
 
@@ -370,6 +374,8 @@ void idCommonLocal::VPrintf( const char *fmt, va_list args ) {
 	// echo to dedicated console and early console
 	Sys_Printf( "%s", msg );
 
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_FOUR );
+
 	// print to script debugger server
 	// DebuggerServerPrint( msg );
 
@@ -412,13 +418,16 @@ void idCommonLocal::VPrintf( const char *fmt, va_list args ) {
 			Printf( "log file '%s' opened on %s\n", fileName, asctime( newtime ) );
 		}
 		if ( logFile ) {
+			Sys_EnterCriticalSection( CRITICAL_SECTION_FOUR );
 			logFile->Write( msg, strlen( msg ) );
 			logFile->Flush();	// ForceFlush doesn't help a whole lot
+			Sys_LeaveCriticalSection( CRITICAL_SECTION_FOUR );
 		}
 	}
 
-	// don't trigger any updates if we are in the process of doing a fatal error
-	if ( com_errorEntered != ERP_FATAL ) {
+	// don't trigger any updates if we are in the process of doing a fatal error,
+	// or on a job thread, which must never draw
+	if ( com_errorEntered != ERP_FATAL && parallelJobManager->GetThreadSlot() <= 0 ) {
 		// update the console if we are in a long-running command, like dmap
 		if ( com_refreshOnPrint ) {
 			session->UpdateScreen();
@@ -534,9 +543,11 @@ void idCommonLocal::Warning( const char *fmt, ... ) {
 
 	Printf( S_COLOR_YELLOW "WARNING: " S_COLOR_RED "%s\n", msg );
 
+	Sys_EnterCriticalSection( CRITICAL_SECTION_FOUR );
 	if ( warningList.Num() < MAX_WARNING_LIST ) {
 		warningList.AddUnique( msg );
 	}
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_FOUR );
 }
 
 /*
@@ -2367,6 +2378,7 @@ void idCommonLocal::InitCommands( void ) {
 	// idLib commands
 	cmdSystem->AddCommand( "memoryDump", Mem_Dump_f, CMD_FL_SYSTEM|CMD_FL_CHEAT, "creates a memory dump" );
 	cmdSystem->AddCommand( "memoryDumpCompressed", Mem_DumpCompressed_f, CMD_FL_SYSTEM|CMD_FL_CHEAT, "creates a compressed memory dump" );
+	cmdSystem->AddCommand( "memoryProfile", Mem_Profile_f, CMD_FL_SYSTEM, "samples allocation call stacks and lists the top allocators" );
 	cmdSystem->AddCommand( "showStringMemory", idStr::ShowMemoryUsage_f, CMD_FL_SYSTEM, "shows memory used by strings" );
 	cmdSystem->AddCommand( "showDictMemory", idDict::ShowMemoryUsage_f, CMD_FL_SYSTEM, "shows memory used by dictionaries" );
 	cmdSystem->AddCommand( "listDictKeys", idDict::ListKeys_f, CMD_FL_SYSTEM|CMD_FL_CHEAT, "lists all keys used by dictionaries" );
@@ -2484,6 +2496,9 @@ void idCommonLocal::Frame( void ) {
 		// set idLib frame number for frame based memory dumps
 		idLib::frameNumber = com_frameNumber;
 
+		// close the per frame statistics of the allocation profiler
+		Mem_ProfileFrame();
+
 		// the FPU stack better be empty at this point or some bad code or compiler bug left values on the stack
 		if ( !Sys_FPU_StackIsEmpty() ) {
 			Printf( Sys_FPU_GetState() );
@@ -2822,6 +2837,9 @@ void idCommonLocal::Init( int argc, const char **argv, const char *cmdline ) {
 		// initialize processor specific SIMD implementation
 		InitSIMD();
 
+		// start the job worker threads
+		parallelJobManager->Init();
+
 		// init commands
 		InitCommands();
 
@@ -2880,6 +2898,9 @@ void idCommonLocal::Shutdown( void ) {
 	// game specific shut down
 	ShutdownGame( false );
 
+	// stop the job worker threads
+	parallelJobManager->Shutdown();
+
 	// shut down non-portable system services
 	Sys_Shutdown();
 
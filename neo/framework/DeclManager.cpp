@@ -2162,6 +2162,8 @@ idDeclLocal::ParseLocal
 void idDeclLocal::ParseLocal( void ) {
 	bool generatedDefaultText = false;
 
+	idScopedMemTag	memTag( MEM_TAG_DECL );
+
 	AllocateSelf();
 
 	// always free data before parsing
@@ -2174,6 +2176,10 @@ void idDeclLocal::ParseLocal( void ) {
 		generatedDefaultText = self->SetDefaultText();
 	}
 
+	// only the outermost parse is timed, the nested ones are part of it
+	bool outermost = ( declManagerLocal.indent == 0 );
+	double start = Sys_GetClockTicks();
+
 	// indent for DEFAULTED or media file references
 	declManagerLocal.indent++;
 
@@ -2181,6 +2187,7 @@ void idDeclLocal::ParseLocal( void ) {
 	if ( textSource == NULL ) {
 		MakeDefault();
 		declManagerLocal.indent--;
+		loadStats.Add( LOAD_DECLS, outermost ? Sys_GetClockTicks() - start : 0.0, 1 );
 		return;
 	}
 
@@ -2199,6 +2206,7 @@ void idDeclLocal::ParseLocal( void ) {
 	}
 
 	declManagerLocal.indent--;
+	loadStats.Add( LOAD_DECLS, outermost ? Sys_GetClockTicks() - start : 0.0, 1 );
 }
 
 /*
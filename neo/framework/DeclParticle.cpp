@@ -1022,9 +1022,11 @@ void idParticleStage::ParticleOrigin( particleGen_t *g, idVec3 &origin ) const {
 /*
 ==================
 idParticleStage::ParticleVerts
+
+If quad is given, the origin, left and up of the quad are stored there instead of setting the xyz.
 ==================
 */
-int	idParticleStage::ParticleVerts( particleGen_t *g, idVec3 origin, idDrawVert *verts ) const {
+int	idParticleStage::ParticleVerts( particleGen_t *g, idVec3 origin, idDrawVert *verts, idVec3 *quad ) const {
 	float	psize = size.Eval( g->frac, g->random );
 	float	paspect = aspect.Eval( g->frac, g->random );
 
@@ -1172,6 +1174,13 @@ int	idParticleStage::ParticleVerts( particleGen_t *g, idVec3 origin, idDrawVert
 	left *= width;
 	up *= height;
 
+	if ( quad ) {
+		quad[0] = origin;
+		quad[1] = left;
+		quad[2] = up;
+		return 4;
+	}
+
 	verts[0].xyz = origin - left + up;
 	verts[1].xyz = origin + left + up;
 	verts[2].xyz = origin - left - up;
@@ -1278,8 +1287,20 @@ Vertex order is:
 ================
 */
 int idParticleStage::CreateParticle( particleGen_t *g, idDrawVert *verts ) const {
+	return CreateParticleQuads( g, verts, NULL );
+}
+
+/*
+================
+idParticleStage::CreateParticleQuads
+================
+*/
+int idParticleStage::CreateParticleQuads( particleGen_t *g, idDrawVert *verts, idVec3 *quads ) const {
 	idVec3	origin;
 
+	// aimed particles are made of trails that are not simple quads
+	assert( quads == NULL || orientation != POR_AIMED );
+
 	verts[0].Clear();
 	verts[1].Clear();
 	verts[2].Clear();
@@ -1296,7 +1317,7 @@ int idParticleStage::CreateParticle( particleGen_t *g, idDrawVert *verts ) const
 
 	ParticleTexCoords( g, verts );
 
-	int	numVerts = ParticleVerts( g, origin, verts );
+	int	numVerts = ParticleVerts( g, origin, verts, quads );
 
 	if ( animationFrames <= 1 ) {
 		return numVerts;
@@ -1322,6 +1343,13 @@ int idParticleStage::CreateParticle( particleGen_t *g, idDrawVert *verts ) const
 		verts[i].color[3] *= iFrac;
 	}
 
+	// the cross faded quad is at the same place
+	if ( quads ) {
+		quads[3] = quads[0];
+		quads[4] = quads[1];
+		quads[5] = quads[2];
+	}
+
 	return numVerts * 2;
 }
 
@@ -110,9 +110,12 @@ public:
 	virtual int				NumQuadsPerParticle() const;	// includes trails and cross faded animations
 	// returns the number of verts created, which will range from 0 to 4*NumQuadsPerParticle()
 	virtual int				CreateParticle( particleGen_t *g, idDrawVert *verts ) const;
+	// same as CreateParticle for stages that are not POR_AIMED, but the xyz of the verts are left
+	// to SIMDProcessor->ParticleQuads, quads gets an origin, left and up vector for each quad
+	int						CreateParticleQuads( particleGen_t *g, idDrawVert *verts, idVec3 *quads ) const;
 
 	void					ParticleOrigin( particleGen_t *g, idVec3 &origin ) const;
-	int						ParticleVerts( particleGen_t *g, const idVec3 origin, idDrawVert *verts ) const;
+	int						ParticleVerts( particleGen_t *g, const idVec3 origin, idDrawVert *verts, idVec3 *quad = NULL ) const;
 	void					ParticleTexCoords( particleGen_t *g, idDrawVert *verts ) const;
 	void					ParticleColors( particleGen_t *g, idDrawVert *verts ) const;
 
@@ -1237,9 +1237,18 @@ idFile_InZip::idFile_InZip
 */
 idFile_InZip::idFile_InZip( void ) {
 	name = "invalid";
-	zipFilePos = 0;
+	view = NULL;
+	viewOffset = 0;
+	viewLength = 0;
+	o = NULL;
+	readBuffer = NULL;
+	data = NULL;
+	dataOffset = 0;
+	compressedSize = 0;
+	compressedPos = 0;
 	fileSize = 0;
-	memset( &z, 0, sizeof( z ) );
+	filePos = 0;
+	z = NULL;
 }
 
 /*
@@ -1248,19 +1257,105 @@ idFile_InZip::~idFile_InZip
 =================
 */
 idFile_InZip::~idFile_InZip( void ) {
-	unzCloseCurrentFile( z );
-	unzClose( z );
+	if ( z ) {
+		unzInflateEnd( z );
+		delete z;
+	}
+	if ( view ) {
+		Sys_UnmapFileView( view, viewOffset, viewLength );
+	}
+	if ( o ) {
+		fclose( o );
+	}
+	if ( readBuffer ) {
+		Mem_Free( readBuffer );
+	}
+}
+
+/*
+=================
+idFile_InZip::RestartInflate
+=================
+*/
+#define ZIP_READ_BUF_SIZE	(1<<14)
+
+void idFile_InZip::RestartInflate( void ) {
+	unzInflateReset( z );
+	if ( view ) {
+		z->next_in = (unsigned char *)data;
+		z->avail_in = compressedSize;
+	} else {
+		if ( !readBuffer ) {
+			readBuffer = (byte *)Mem_Alloc( ZIP_READ_BUF_SIZE );
+		}
+		z->next_in = readBuffer;
+		z->avail_in = 0;
+		compressedPos = 0;
+	}
+	filePos = 0;
+}
+
+/*
+=================
+idFile_InZip::ReadCompressed
+
+inflates from the view, or from compressed data read through stdio
+=================
+*/
+int idFile_InZip::ReadCompressed( void *buffer, int len ) {
+	int err, l;
+
+	z->next_out = (unsigned char *)buffer;
+	z->avail_out = len;
+	while ( z->avail_out > 0 ) {
+		if ( z->avail_in == 0 && !view && compressedPos < compressedSize ) {
+			l = Min( ZIP_READ_BUF_SIZE, compressedSize - compressedPos );
+			fseek( o, dataOffset + compressedPos, SEEK_SET );
+			if ( fread( readBuffer, l, 1, o ) != 1 ) {
+				break;
+			}
+			compressedPos += l;
+			z->next_in = readBuffer;
+			z->avail_in = l;
+		}
+		err = unzInflate( z );
+		if ( err != UNZ_OK ) {
+			break;
+		}
+	}
+	return len - z->avail_out;
 }
 
 /*
 =================
 idFile_InZip::Read
 
-Properly handles partial reads
+Properly handles partial reads.
+Stored files are copied straight out of the mapped view and deflated
+files are inflated from it. Without a view the pak is read through stdio.
 =================
 */
 int idFile_InZip::Read( void *buffer, int len ) {
-	int l = unzReadCurrentFile( z, buffer, len );
+	int l;
+
+	if ( len > fileSize - filePos ) {
+		len = fileSize - filePos;
+	}
+	if ( len <= 0 ) {
+		return 0;
+	}
+
+	if ( z ) {
+		l = ReadCompressed( buffer, len );
+	} else if ( view ) {
+		memcpy( buffer, data + filePos, len );
+		l = len;
+	} else {
+		fseek( o, dataOffset + filePos, SEEK_SET );
+		l = fread( buffer, 1, len, o );
+	}
+
+	filePos += l;
 	fileSystem->AddToReadCount( l );
 	return l;
 }
@@ -1299,7 +1394,7 @@ idFile_InZip::Tell
 =================
 */
 int idFile_InZip::Tell( void ) {
-	return unztell( z );
+	return filePos;
 }
 
 /*
@@ -1325,6 +1420,8 @@ ID_TIME_T idFile_InZip::Timestamp( void ) {
 idFile_InZip::Seek
 
   returns zero on success and -1 on failure
+  stored files seek in place, deflated files restart the
+  inflate stream when seeking backwards
 =================
 */
 #define ZIP_SEEK_BUF_SIZE	(1<<15)
@@ -1336,30 +1433,45 @@ int idFile_InZip::Seek( long offset, fsOrigin_t origin ) {
 	switch( origin ) {
 		case FS_SEEK_END: {
 			offset = fileSize - offset;
+			break;
 		}
 		case FS_SEEK_SET: {
-			// set the file position in the zip file (also sets the current file info)
-			unzSetCurrentFileInfoPosition( z, zipFilePos );
-			unzOpenCurrentFile( z );
-			if ( offset <= 0 ) {
-				return 0;
-			}
+			break;
 		}
 		case FS_SEEK_CUR: {
-			buf = (char *) _alloca16( ZIP_SEEK_BUF_SIZE );
-			for ( i = 0; i < ( offset - ZIP_SEEK_BUF_SIZE ); i += ZIP_SEEK_BUF_SIZE ) {
-				res = unzReadCurrentFile( z, buf, ZIP_SEEK_BUF_SIZE );
-				if ( res < ZIP_SEEK_BUF_SIZE ) {
-					return -1;
-				}
-			}
-			res = i + unzReadCurrentFile( z, buf, offset - i );
-			return ( res == offset ) ? 0 : -1;
+			offset += filePos;
+			break;
 		}
 		default: {
 			common->FatalError( "idFile_InZip::Seek: bad origin for %s\n", name.c_str() );
 			break;
 		}
 	}
-	return -1;
+
+	if ( offset < 0 || offset > fileSize ) {
+		return -1;
+	}
+
+	if ( !z ) {
+		filePos = offset;
+		return 0;
+	}
+
+	if ( offset < filePos ) {
+		RestartInflate();
+	}
+
+	offset -= filePos;
+	if ( offset <= 0 ) {
+		return 0;
+	}
+	buf = (char *) _alloca16( ZIP_SEEK_BUF_SIZE );
+	for ( i = 0; i < ( offset - ZIP_SEEK_BUF_SIZE ); i += ZIP_SEEK_BUF_SIZE ) {
+		res = Read( buf, ZIP_SEEK_BUF_SIZE );
+		if ( res < ZIP_SEEK_BUF_SIZE ) {
+			return -1;
+		}
+	}
+	res = i + Read( buf, offset - i );
+	return ( res == offset ) ? 0 : -1;
 }
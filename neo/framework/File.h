@@ -235,9 +235,21 @@ public:
 private:
 	idStr					name;			// name of the file in the pak
 	idStr					fullPath;		// full file path including pak file name
-	int						zipFilePos;		// zip file info position in pak
+	const byte *			view;			// mapped view of the pak spanning the file, NULL if read through stdio
+	int						viewOffset;		// position of the view in the pak
+	int						viewLength;
+	FILE *					o;				// pak opened for reading if no view could be mapped
+	byte *					readBuffer;		// compressed data read through stdio
+	const byte *			data;			// file data in the view
+	int						dataOffset;		// position of the file data in the pak
+	int						compressedSize;	// size of the data in the pak
+	int						compressedPos;	// compressed data read through stdio so far
 	int						fileSize;		// size of the file
-	void *					z;				// unzip info
+	int						filePos;		// current uncompressed position
+	struct z_stream_s *		z;				// inflate stream, NULL for stored files
+
+	void					RestartInflate( void );
+	int						ReadCompressed( void *buffer, int len );
 };
 
 #endif /* !__FILE_H__ */
@@ -101,6 +101,12 @@ files of the form "pak0.pk4", "pak1.pk4", etc. Zip files are searched in decendi
 from the highest number to the lowest, and will always take precedence over the filesystem.
 This allows a pk4 distributed as a patch to override all existing data.
 
+Files in zip files are read through a view of the zip file that is mapped when the file
+is opened and only spans that file, if no view can be mapped the file is read through
+stdio. The central directories of all zip files are cached in "pk4index.dat" under the
+save path, an entry is reused as long as the size and the modification time of its zip
+file are unchanged.
+
 Because we will have updated executables freely available online, there is no point to
 trying to restrict demo / oem versions of the game with code changes. Demo / oem versions
 should be exactly the same executables as release versions, but with different data that
@@ -252,12 +258,30 @@ public:
 
 static idInitExclusions	initExclusions;
 
-#define MAX_ZIPPED_FILE_NAME	2048
 #define FILE_HASH_SIZE			1024
 
+#define PAK_INDEX_FILE			"pk4index.dat"
+#define PAK_INDEX_ID			( ( 'X' << 24 ) | ( 'D' << 16 ) | ( 'I' << 8 ) | 'P' )
+#define PAK_INDEX_VERSION		2
+
+// zip format
+#define ZIP_LOCAL_HEADER_ID		0x04034b50
+#define ZIP_LOCAL_HEADER_SIZE	30
+#define ZIP_CENTRAL_HEADER_ID	0x02014b50
+#define ZIP_CENTRAL_HEADER_SIZE	46
+#define ZIP_END_HEADER_ID		0x06054b50
+#define ZIP_END_HEADER_SIZE		22
+#define ZIP_MAX_COMMENT			0xffff
+#define ZIP_MAX_NAME_EXTRA		( 2 * 0xffff )			// local header name and extra field
+#define ZIP_STORED				0
+#define ZIP_DEFLATED			8
+
 typedef struct fileInPack_s {
 	idStr				name;						// name of the file
-	unsigned long		pos;						// file info position in zip
+	int					headerOffset;				// position of the local header in the zip
+	int					compressedSize;				// size of the file data in the zip
+	int					size;						// uncompressed size of the file
+	int					method;						// ZIP_STORED or ZIP_DEFLATED
 	struct fileInPack_s * next;						// next file in the hash
 } fileInPack_t;
 
@@ -281,10 +305,11 @@ typedef struct {
 
 typedef struct {
 	idStr				pakFilename;				// c:\doom\base\pak0.pk4
-	unzFile				handle;
+	void *				mapping;					// views of the files are mapped from this, NULL if read through stdio
 	int					checksum;
 	int					numfiles;
 	int					length;
+	ID_TIME_T			timestamp;
 	bool				referenced;
 	binaryStatus_t		binary;
 	bool				addon;						// this is an addon pack - addon_search tells if it's 'active'
@@ -301,6 +326,16 @@ typedef struct {
 	idStr				gamedir;					// base
 } directory_t;
 
+// cached zip contents, keyed by the full zip path, size and modification time
+typedef struct {
+	idStr				pakFilename;
+	int					length;
+	int					timestamp;
+	const byte *		contents;					// serialized contents in the mapped index file
+	int					contentsLength;
+	pack_t *			pack;						// set if the contents have to be written from this pak
+} pakIndexEntry_t;
+
 typedef struct searchpath_s {
 	pack_t *			pack;						// only one of pack / dir will be non NULL
 	directory_t *		dir;
@@ -378,7 +413,7 @@ public:
 	virtual void			CloseFile( idFile *f );
 	virtual void			BackgroundDownload( backgroundDownload_t *bgl );
 	virtual void			ResetReadCount( void ) { readCount = 0; }
-	virtual void			AddToReadCount( int c ) { readCount += c; }
+	virtual void			AddToReadCount( int c ) { Sys_InterlockedAdd( readCount, c ); }
 	virtual int				GetReadCount( void ) { return readCount; }
 	virtual void			FindDLL( const char *basename, char dllPath[ MAX_OSPATH ], bool updateChecksum );
 	virtual void			ClearDirCache( void );
@@ -404,7 +439,7 @@ private:
 	friend dword 			BackgroundDownloadThread( void *parms );
 
 	searchpath_t *			searchPaths;
-	int						readCount;			// total bytes read
+	interlockedInt_t		readCount;			// total bytes read, added to by load jobs
 	int						loadCount;			// total files read
 	int						loadStack;			// total files in memory
 	idStr					gameFolder;			// this will be a single name without separators
@@ -445,6 +480,12 @@ private:
 
 	int						d3xp;	// 0: didn't check, -1: not installed, 1: installed
 
+	bool					pakIndexActive;			// set during Startup while the zip index is in use
+	bool					pakIndexModified;
+	byte *					pakIndexData;			// contents of the index file
+	int						pakIndexLength;
+	idList<pakIndexEntry_t>	pakIndex;
+
 private:
 	void					ReplaceSeparators( idStr &path, char sep = PATHSEPERATOR_CHAR );
 	long					HashFileName( const char *fname ) const;
@@ -459,6 +500,12 @@ private:
 
 	int						GetFileListTree( const char *relativePath, const idStrList &extensions, idStrList &list, idHashIndex &hashIndex, const char* gamedir = NULL );
 	pack_t *				LoadZipFile( const char *zipfile );
+	bool					ParseZipDirectory( pack_t *pack, FILE *f );
+	bool					ReadPakIndexContents( pack_t *pack, const pakIndexEntry_t &entry );
+	void					WritePakIndexContents( idFile *file, const pack_t *pack );
+	void					LoadPakIndex( void );
+	void					WritePakIndex( void );
+	void					FreePakIndex( void );
 	void					AddGameDirectory( const char *path, const char *dir );
 	void					SetupGameDirectories( const char *gameName );
 	void					Startup( void );
@@ -470,6 +517,7 @@ private:
 							// searches all the paks, no pure check
 	pack_t *				FindPakForFileChecksum( const char *relativePath, int fileChecksum, bool bReference );
 	idFile_InZip *			ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath );
+	idFile *				FindFileForRead( const char *relativePath, int searchFlags, pack_t **foundInPak, bool allowCopyFiles, const char* gamedir );
 	int						GetFileChecksum( idFile *file );
 	pureStatus_t			GetPackStatus( pack_t *pak );
 	addonInfo_t *			ParseAddonDef( const char *buf, const int len );
@@ -516,6 +564,10 @@ idFileSystemLocal::idFileSystemLocal( void ) {
 	restartGamePakChecksum = 0;
 	memset( &backgroundThread, 0, sizeof( backgroundThread ) );
 	addonPaks = NULL;
+	pakIndexActive = false;
+	pakIndexModified = false;
+	pakIndexData = NULL;
+	pakIndexLength = 0;
 }
 
 /*
@@ -1044,6 +1096,8 @@ int idFileSystemLocal::ReadFile( const char *relativePath, void **buffer, ID_TIM
 	int			len;
 	bool		isConfig;
 
+	idScopedMemTag	memTag( MEM_TAG_FILESYSTEM );
+
 	if ( !searchPaths ) {
 		common->FatalError( "Filesystem call made without initialization\n" );
 	}
@@ -1284,53 +1338,405 @@ addonInfo_t *idFileSystemLocal::ParseAddonDef( const char *buf, const int len )
 
 /*
 =================
-idFileSystemLocal::LoadZipFile
+ZipShort
 =================
 */
-pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
-	fileInPack_t *	buildBuffer;
-	pack_t *		pack;
-	unzFile			uf;
-	int				err;
-	unz_global_info gi;
-	char			filename_inzip[MAX_ZIPPED_FILE_NAME];
-	unz_file_info	file_info;
-	int				i;
-	long			hash;
+static ID_INLINE int ZipShort( const byte *p ) {
+	return p[0] | ( p[1] << 8 );
+}
+
+/*
+=================
+ZipLong
+=================
+*/
+static ID_INLINE int ZipLong( const byte *p ) {
+	return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( p[3] << 24 );
+}
+
+/*
+=================
+ReadPakIndexString
+
+the length is checked against the index data so a damaged index can't cause huge allocations
+=================
+*/
+static bool ReadPakIndexString( idFile_Memory &file, idStr &string ) {
+	int len;
+
+	if ( file.ReadInt( len ) != sizeof( len ) || len < 0 || len > file.Length() - file.Tell() ) {
+		return false;
+	}
+	string.Fill( ' ', len );
+	file.Read( &string[0], len );
+	return true;
+}
+
+/*
+=================
+idFileSystemLocal::ParseZipDirectory
+
+Fills in the file list and the checksum of a zip file from its central directory,
+which is read with two reads. The local headers are only read when a file is opened.
+=================
+*/
+bool idFileSystemLocal::ParseZipDirectory( pack_t *pack, FILE *f ) {
+	byte *			tail;
+	byte *			dir;
+	const byte *	p;
+	const byte *	end;
+	int				i, tailLength, endPos;
+	int				numEntries, dirSize, dirOffset, bytesBefore;
+	int				nameLen, extraLen, commentLen;
 	int				fs_numHeaderLongs;
 	int *			fs_headerLongs;
-	FILE			*f;
-	int				len;
-	int				confHash;
-	fileInPack_t	*pakFile;
+	fileInPack_t *	file;
 
-	f = OpenOSFile( zipfile, "rb" );
+	// the end of central directory record is followed by a comment of up to 64k
+	tailLength = Min( pack->length, ZIP_END_HEADER_SIZE + ZIP_MAX_COMMENT );
+	if ( tailLength < ZIP_END_HEADER_SIZE ) {
+		return false;
+	}
+	tail = (byte *)Mem_Alloc( tailLength );
+	if ( fseek( f, pack->length - tailLength, SEEK_SET ) != 0 || fread( tail, tailLength, 1, f ) != 1 ) {
+		Mem_Free( tail );
+		return false;
+	}
+	for ( i = tailLength - ZIP_END_HEADER_SIZE; i >= 0; i-- ) {
+		if ( ZipLong( tail + i ) == ZIP_END_HEADER_ID ) {
+			break;
+		}
+	}
+	if ( i < 0 ) {
+		Mem_Free( tail );
+		return false;
+	}
+
+	endPos = pack->length - tailLength + i;
+	numEntries = ZipShort( tail + i + 10 );
+	dirSize = ZipLong( tail + i + 12 );
+	dirOffset = ZipLong( tail + i + 16 );
+	Mem_Free( tail );
+
+	// bytes in front of the zip data, for self extracting archives
+	bytesBefore = endPos - dirOffset - dirSize;
+	if ( dirSize < 0 || dirOffset < 0 || bytesBefore < 0 ) {
+		return false;
+	}
+
+	dir = (byte *)Mem_Alloc( dirSize + 1 );
+	if ( fseek( f, bytesBefore + dirOffset, SEEK_SET ) != 0 || ( dirSize && fread( dir, dirSize, 1, f ) != 1 ) ) {
+		Mem_Free( dir );
+		return false;
+	}
+
+	fs_numHeaderLongs = 0;
+	fs_headerLongs = (int *)Mem_ClearedAlloc( ( numEntries + 1 ) * sizeof(int) );
+	pack->buildBuffer = new fileInPack_t[numEntries];
+	pack->numfiles = numEntries;
+
+	p = dir;
+	end = dir + dirSize;
+	for ( i = 0; i < numEntries; i++ ) {
+		if ( p + ZIP_CENTRAL_HEADER_SIZE > end || ZipLong( p ) != ZIP_CENTRAL_HEADER_ID ) {
+			break;
+		}
+		nameLen = ZipShort( p + 28 );
+		extraLen = ZipShort( p + 30 );
+		commentLen = ZipShort( p + 32 );
+		if ( p + ZIP_CENTRAL_HEADER_SIZE + nameLen > end ) {
+			break;
+		}
+
+		file = &pack->buildBuffer[i];
+		file->method = ZipShort( p + 10 );
+		file->compressedSize = ZipLong( p + 20 );
+		file->size = ZipLong( p + 24 );
+		file->headerOffset = bytesBefore + ZipLong( p + 42 );
+		if ( file->size > 0 ) {
+			fs_headerLongs[fs_numHeaderLongs++] = LittleLong( ZipLong( p + 16 ) );
+		}
+		file->name.Fill( ' ', nameLen );
+		memcpy( &file->name[0], p + ZIP_CENTRAL_HEADER_SIZE, nameLen );
+		file->name.ToLower();
+		file->name.BackSlashesToSlashes();
+
+		if ( file->headerOffset < 0 || file->compressedSize < 0 || file->size < 0 ||
+				file->compressedSize > pack->length - ZIP_LOCAL_HEADER_SIZE - file->headerOffset ) {
+			break;
+		}
+
+		p += ZIP_CENTRAL_HEADER_SIZE + nameLen + extraLen + commentLen;
+	}
+
+	pack->checksum = MD4_BlockChecksum( fs_headerLongs, 4 * fs_numHeaderLongs );
+	pack->checksum = LittleLong( pack->checksum );
+
+	Mem_Free( fs_headerLongs );
+	Mem_Free( dir );
+
+	if ( i < numEntries ) {
+		delete [] pack->buildBuffer;
+		pack->buildBuffer = NULL;
+		return false;
+	}
+	return true;
+}
+
+/*
+=================
+idFileSystemLocal::ReadPakIndexContents
+=================
+*/
+bool idFileSystemLocal::ReadPakIndexContents( pack_t *pack, const pakIndexEntry_t &entry ) {
+	idFile_Memory	file( entry.pakFilename, (const char *)entry.contents, entry.contentsLength );
+	fileInPack_t *	buildBuffer;
+	fileInPack_t *	pakFile;
+	int				i, checksum, numFiles;
+
+	if ( file.ReadInt( checksum ) != sizeof( checksum ) || file.ReadInt( numFiles ) != sizeof( numFiles ) ) {
+		return false;
+	}
+	// every file takes at least five ints
+	if ( numFiles < 0 || numFiles > entry.contentsLength / 20 ) {
+		return false;
+	}
+
+	buildBuffer = new fileInPack_t[numFiles];
+	for ( i = 0; i < numFiles; i++ ) {
+		pakFile = &buildBuffer[i];
+		if ( !ReadPakIndexString( file, pakFile->name ) ) {
+			break;
+		}
+		file.ReadInt( pakFile->headerOffset );
+		file.ReadInt( pakFile->compressedSize );
+		file.ReadInt( pakFile->size );
+		if ( file.ReadInt( pakFile->method ) != sizeof( pakFile->method ) ) {
+			break;
+		}
+		if ( pakFile->headerOffset < 0 || pakFile->compressedSize < 0 || pakFile->size < 0 ||
+				pakFile->compressedSize > pack->length - ZIP_LOCAL_HEADER_SIZE - pakFile->headerOffset ) {
+			break;
+		}
+	}
+	if ( i < numFiles ) {
+		delete [] buildBuffer;
+		return false;
+	}
+
+	pack->checksum = checksum;
+	pack->numfiles = numFiles;
+	pack->buildBuffer = buildBuffer;
+	return true;
+}
+
+/*
+=================
+idFileSystemLocal::WritePakIndexContents
+=================
+*/
+void idFileSystemLocal::WritePakIndexContents( idFile *file, const pack_t *pack ) {
+	int i;
+
+	file->WriteInt( pack->checksum );
+	file->WriteInt( pack->numfiles );
+	for ( i = 0; i < pack->numfiles; i++ ) {
+		const fileInPack_t &pakFile = pack->buildBuffer[i];
+		file->WriteString( pakFile.name );
+		file->WriteInt( pakFile.headerOffset );
+		file->WriteInt( pakFile.compressedSize );
+		file->WriteInt( pakFile.size );
+		file->WriteInt( pakFile.method );
+	}
+}
+
+/*
+=================
+idFileSystemLocal::LoadPakIndex
+
+Reads the index of the zip contents written by a previous startup.
+The index is stored in the base game directory of the save path.
+=================
+*/
+void idFileSystemLocal::LoadPakIndex( void ) {
+	idStr			path;
+	pakIndexEntry_t	entry;
+	FILE *			f;
+	int				i, id, version, numEntries;
+
+	FreePakIndex();
+
+	if ( !fs_savepath.GetString()[0] ) {
+		return;
+	}
+	pakIndexActive = true;
+
+	path = BuildOSPath( fs_savepath.GetString(), BASE_GAMEDIR, PAK_INDEX_FILE );
+	f = OpenOSFile( path, "rb" );
 	if ( !f ) {
-		return NULL;
+		pakIndexModified = true;
+		return;
+	}
+	pakIndexLength = DirectFileLength( f );
+	pakIndexData = (byte *)Mem_Alloc( pakIndexLength + 1 );
+	if ( pakIndexLength && fread( pakIndexData, pakIndexLength, 1, f ) != 1 ) {
+		pakIndexLength = 0;
 	}
-	fseek( f, 0, SEEK_END );
-	len = ftell( f );
 	fclose( f );
 
-	fs_numHeaderLongs = 0;
+	idFile_Memory file( path, (const char *)pakIndexData, pakIndexLength );
+	file.ReadInt( id );
+	file.ReadInt( version );
+	if ( id != PAK_INDEX_ID || version != PAK_INDEX_VERSION || file.ReadInt( numEntries ) != sizeof( numEntries ) ) {
+		common->DPrintf( "%s is out of date\n", path.c_str() );
+		pakIndexModified = true;
+		return;
+	}
+
+	for ( i = 0; i < numEntries; i++ ) {
+		if ( !ReadPakIndexString( file, entry.pakFilename ) ) {
+			break;
+		}
+		file.ReadInt( entry.length );
+		file.ReadInt( entry.timestamp );
+		if ( file.ReadInt( entry.contentsLength ) != sizeof( entry.contentsLength ) ) {
+			break;
+		}
+		if ( entry.contentsLength < 0 || entry.contentsLength > file.Length() - file.Tell() ) {
+			break;
+		}
+		entry.contents = pakIndexData + file.Tell();
+		entry.pack = NULL;
+		file.Seek( entry.contentsLength, FS_SEEK_CUR );
+		pakIndex.Append( entry );
+	}
+	if ( i < numEntries ) {
+		common->Warning( "%s is damaged, rebuilding", path.c_str() );
+		pakIndex.Clear();
+		pakIndexModified = true;
+	}
+}
+
+/*
+=================
+idFileSystemLocal::WritePakIndex
+
+Rewrites the index if a zip file was added or changed.
+Entries of zip files that are not in the current search paths are kept unless the zip is gone.
+=================
+*/
+void idFileSystemLocal::WritePakIndex( void ) {
+	idStr			path;
+	idFile_Memory	index;
+	idFile_Memory	contents;
+	idFile *		file;
+	FILE *			f;
+	int				i, numEntries;
+
+	if ( !pakIndexActive || !pakIndexModified ) {
+		return;
+	}
 
-	uf = unzOpen( zipfile );
-	err = unzGetGlobalInfo( uf, &gi );
+	numEntries = 0;
+	for ( i = 0; i < pakIndex.Num(); i++ ) {
+		if ( !pakIndex[i].pack ) {
+			f = OpenOSFile( pakIndex[i].pakFilename, "rb" );
+			if ( !f ) {
+				pakIndex[i].contents = NULL;
+				continue;
+			}
+			fclose( f );
+		}
+		numEntries++;
+	}
+
+	index.WriteInt( PAK_INDEX_ID );
+	index.WriteInt( PAK_INDEX_VERSION );
+	index.WriteInt( numEntries );
+	for ( i = 0; i < pakIndex.Num(); i++ ) {
+		const pakIndexEntry_t &entry = pakIndex[i];
+		if ( entry.pack ) {
+			contents.Clear( false );
+			WritePakIndexContents( &contents, entry.pack );
+			index.WriteString( entry.pakFilename );
+			index.WriteInt( entry.length );
+			index.WriteInt( entry.timestamp );
+			index.WriteInt( contents.Length() );
+			index.Write( contents.GetDataPtr(), contents.Length() );
+		} else if ( entry.contents ) {
+			index.WriteString( entry.pakFilename );
+			index.WriteInt( entry.length );
+			index.WriteInt( entry.timestamp );
+			index.WriteInt( entry.contentsLength );
+			index.Write( entry.contents, entry.contentsLength );
+		}
+	}
+
+	path = BuildOSPath( fs_savepath.GetString(), BASE_GAMEDIR, PAK_INDEX_FILE );
+	file = OpenExplicitFileWrite( path );
+	if ( !file ) {
+		common->DPrintf( "couldn't write %s\n", path.c_str() );
+		return;
+	}
+	file->Write( index.GetDataPtr(), index.Length() );
+	CloseFile( file );
+
+	common->DPrintf( "wrote %s with %d zip files\n", path.c_str(), numEntries );
+}
+
+/*
+=================
+idFileSystemLocal::FreePakIndex
+=================
+*/
+void idFileSystemLocal::FreePakIndex( void ) {
+	if ( pakIndexData ) {
+		Mem_Free( pakIndexData );
+		pakIndexData = NULL;
+		pakIndexLength = 0;
+	}
+	pakIndex.Clear();
+	pakIndexActive = false;
+	pakIndexModified = false;
+}
+
+/*
+=================
+idFileSystemLocal::LoadZipFile
 
-	if ( err != UNZ_OK ) {
+The contents of the zip file come from the zip index if the entry matches the
+size and the modification time of the file, otherwise the central directory is
+parsed and the index is updated. A file mapping is opened for the views of the
+files, without it the files are read through stdio.
+=================
+*/
+pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
+	pack_t *			pack;
+	pakIndexEntry_t *	entry;
+	FILE *				f;
+	int					i, len;
+	ID_TIME_T			timestamp;
+	long				hash;
+	int					confHash;
+	fileInPack_t *		pakFile;
+
+	f = OpenOSFile( zipfile, "rb" );
+	if ( !f ) {
 		return NULL;
 	}
+	len = DirectFileLength( f );
+	timestamp = Sys_FileTimeStamp( f );
 
-	buildBuffer = new fileInPack_t[gi.number_entry];
 	pack = new pack_t;
 	for( i = 0; i < FILE_HASH_SIZE; i++ ) {
 		pack->hashTable[i] = NULL;
 	}
 
 	pack->pakFilename = zipfile;
-	pack->handle = uf;
-	pack->numfiles = gi.number_entry;
-	pack->buildBuffer = buildBuffer;
+	pack->mapping = NULL;
+	pack->checksum = 0;
+	pack->numfiles = 0;
+	pack->buildBuffer = NULL;
 	pack->referenced = false;
 	pack->binary = BINARY_UNKNOWN;
 	pack->addon = false;
@@ -1340,28 +1746,52 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 	pack->isNew = false;
 
 	pack->length = len;
+	pack->timestamp = timestamp;
 
-	unzGoToFirstFile(uf);
-	fs_headerLongs = (int *)Mem_ClearedAlloc( gi.number_entry * sizeof(int) );
-	for ( i = 0; i < (int)gi.number_entry; i++ ) {
-		err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
-		if ( err != UNZ_OK ) {
-			break;
+	entry = NULL;
+	if ( pakIndexActive ) {
+		for ( i = 0; i < pakIndex.Num(); i++ ) {
+			if ( pakIndex[i].pakFilename.Cmp( zipfile ) == 0 ) {
+				entry = &pakIndex[i];
+				break;
+			}
 		}
-		if ( file_info.uncompressed_size > 0 ) {
-			fs_headerLongs[fs_numHeaderLongs++] = LittleLong( file_info.crc );
+	}
+
+	if ( !entry || !entry->contents || entry->length != len || entry->timestamp != (int)timestamp || !ReadPakIndexContents( pack, *entry ) ) {
+		if ( !ParseZipDirectory( pack, f ) ) {
+			common->Warning( "%s is not a valid zip file", zipfile );
+			fclose( f );
+			delete pack;
+			return NULL;
+		}
+		if ( pakIndexActive ) {
+			if ( !entry ) {
+				entry = &pakIndex.Alloc();
+				entry->pakFilename = zipfile;
+			}
+			entry->length = len;
+			entry->timestamp = (int)timestamp;
+			entry->contents = NULL;
+			entry->contentsLength = 0;
+			pakIndexModified = true;
 		}
-		hash = HashFileName( filename_inzip );
-		buildBuffer[i].name = filename_inzip;
-		buildBuffer[i].name.ToLower();
-		buildBuffer[i].name.BackSlashesToSlashes();
-		// store the file position in the zip
-		unzGetCurrentFileInfoPosition( uf, &buildBuffer[i].pos );
+	}
+	if ( entry ) {
+		entry->pack = pack;
+	}
+	fclose( f );
+
+	pack->mapping = Sys_OpenFileMapping( zipfile );
+	if ( !pack->mapping ) {
+		common->DPrintf( "Couldn't map %s, reading it through stdio\n", zipfile );
+	}
+
+	for ( i = 0; i < pack->numfiles; i++ ) {
+		hash = HashFileName( pack->buildBuffer[i].name );
 		// add the file to the hash
-		buildBuffer[i].next = pack->hashTable[hash];
-		pack->hashTable[hash] = &buildBuffer[i];
-		// go to the next file in the zip
-		unzGoToNextFile(uf);
+		pack->buildBuffer[i].next = pack->hashTable[hash];
+		pack->hashTable[hash] = &pack->buildBuffer[i];
 	}
 
 	// check if this is an addon pak
@@ -1387,11 +1817,6 @@ pack_t *idFileSystemLocal::LoadZipFile( const char *zipfile ) {
 		}
 	}
 
-	pack->checksum = MD4_BlockChecksum( fs_headerLongs, 4 * fs_numHeaderLongs );
-	pack->checksum = LittleLong( pack->checksum );
-
-	Mem_Free( fs_headerLongs );
-
 	return pack;
 }
 
@@ -2245,6 +2670,9 @@ void idFileSystemLocal::Startup( void ) {
 		common->Printf( "restarting filesystem with %d addon pak file(s) to include\n", addonChecksums.Num() );
 	}
 
+	// the zip index is used while the pk4 files are loaded
+	LoadPakIndex();
+
 	SetupGameDirectories( BASE_GAMEDIR );
 
 	// fs_game_base override
@@ -2260,6 +2688,9 @@ void idFileSystemLocal::Startup( void ) {
 		SetupGameDirectories( fs_game.GetString() );
 	}
 
+	WritePakIndex();
+	FreePakIndex();
+
 	// currently all addons are in the search list - deal with filtering out and dependencies now
 	// scan through and deal with dependencies
 	search = &searchPaths;
@@ -2947,7 +3378,9 @@ void idFileSystemLocal::Shutdown( bool reloading ) {
 			next = sp->next;
 
 			if ( sp->pack ) {
-				unzClose( sp->pack->handle );
+				if ( sp->pack->mapping ) {
+					Sys_CloseFileMapping( sp->pack->mapping );
+				}
 				delete [] sp->pack->buildBuffer;
 				if ( sp->pack->addon_info ) {
 					sp->pack->addon_info->mapDecls.DeleteContents( true );
@@ -3101,36 +3534,72 @@ idFileSystemLocal::ReadFileFromZip
 ===========
 */
 idFile_InZip * idFileSystemLocal::ReadFileFromZip( pack_t *pak, fileInPack_t *pakFile, const char *relativePath ) {
-	unz_s *			zfi;
-	FILE *			fp;
-	idFile_InZip *file = new idFile_InZip();
+	idFile_InZip *	file = new idFile_InZip();
+	byte			localHeader[ZIP_LOCAL_HEADER_SIZE];
+	const byte *	header;
 
-	// open a new file on the pakfile
-	file->z = unzReOpen( pak->pakFilename, pak->handle );
-	if ( file->z == NULL ) {
-		common->FatalError( "Couldn't reopen %s", pak->pakFilename.c_str() );
-	}
 	file->name = relativePath;
 	file->fullPath = pak->pakFilename + "/" + relativePath;
-	zfi = (unz_s *)file->z;
-	// in case the file was new
-	fp = zfi->file;
-	// set the file position in the zip file (also sets the current file info)
-	unzSetCurrentFileInfoPosition( pak->handle, pakFile->pos );
-	// copy the file info into the unzip structure
-	memcpy( zfi, pak->handle, sizeof(unz_s) );
-	// we copy this back into the structure
-	zfi->file = fp;
-	// open the file in the zip
-	unzOpenCurrentFile( file->z );
-	file->zipFilePos = pakFile->pos;
-	file->fileSize = zfi->cur_file_info.uncompressed_size;
+	file->compressedSize = pakFile->compressedSize;
+	file->fileSize = pakFile->size;
+
+	// map a view that spans the local header and the file data, this can fail
+	// when the address space runs out, the file is read through stdio then
+	if ( pak->mapping ) {
+		file->viewOffset = pakFile->headerOffset;
+		file->viewLength = Min( pak->length - pakFile->headerOffset, ZIP_LOCAL_HEADER_SIZE + ZIP_MAX_NAME_EXTRA + pakFile->compressedSize );
+		file->view = (const byte *)Sys_MapFileView( pak->mapping, file->viewOffset, file->viewLength );
+	}
+	if ( file->view ) {
+		header = file->view;
+	} else {
+		file->o = OpenOSFile( pak->pakFilename, "rb" );
+		if ( !file->o ) {
+			common->FatalError( "Couldn't reopen %s", pak->pakFilename.c_str() );
+		}
+		if ( fseek( file->o, pakFile->headerOffset, SEEK_SET ) != 0 || fread( localHeader, sizeof( localHeader ), 1, file->o ) != 1 ) {
+			memset( localHeader, 0, sizeof( localHeader ) );
+		}
+		header = localHeader;
+	}
+
+	// the local header can have a different extra field than the central directory
+	file->dataOffset = pakFile->headerOffset + ZIP_LOCAL_HEADER_SIZE + ZipShort( header + 26 ) + ZipShort( header + 28 );
+	if ( ZipLong( header ) != ZIP_LOCAL_HEADER_ID || file->compressedSize > pak->length - file->dataOffset ) {
+		common->Warning( "%s has a bad local header", file->fullPath.c_str() );
+		file->fileSize = 0;
+		return file;
+	}
+	if ( file->view ) {
+		file->data = file->view + ( file->dataOffset - file->viewOffset );
+	}
+
+	switch( pakFile->method ) {
+		case ZIP_STORED: {
+			file->fileSize = Min( pakFile->size, pakFile->compressedSize );
+			break;
+		}
+		case ZIP_DEFLATED: {
+			file->z = new z_stream;
+			memset( file->z, 0, sizeof( z_stream ) );
+			if ( unzInflateInit( file->z ) != UNZ_OK ) {
+				common->FatalError( "Couldn't inflate %s", file->fullPath.c_str() );
+			}
+			file->RestartInflate();
+			break;
+		}
+		default: {
+			common->Warning( "%s uses unsupported compression method %d", file->fullPath.c_str(), pakFile->method );
+			file->fileSize = 0;
+			break;
+		}
+	}
 	return file;
 }
 
 /*
 ===========
-idFileSystemLocal::OpenFileReadFlags
+idFileSystemLocal::FindFileForRead
 
 Finds the file in the search path, following search flag recommendations
 Returns filesize and an open FILE pointer.
@@ -3138,7 +3607,7 @@ Used for streaming data out of either a
 separate file or a ZIP file.
 ===========
 */
-idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int searchFlags, pack_t **foundInPak, bool allowCopyFiles, const char* gamedir ) {
+idFile *idFileSystemLocal::FindFileForRead( const char *relativePath, int searchFlags, pack_t **foundInPak, bool allowCopyFiles, const char* gamedir ) {
 	searchpath_t *	search;
 	idStr			netpath;
 	pack_t *		pak;
@@ -3380,6 +3849,23 @@ idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int sear
 	return NULL;
 }
 
+/*
+===========
+idFileSystemLocal::OpenFileReadFlags
+
+Files are opened by level load jobs while the main thread keeps
+reading, the search is serialized here. Every file in a pak reads
+from its own view or FILE, so reads from the opened files run
+in parallel.
+===========
+*/
+idFile *idFileSystemLocal::OpenFileReadFlags( const char *relativePath, int searchFlags, pack_t **foundInPak, bool allowCopyFiles, const char* gamedir ) {
+	Sys_EnterCriticalSection( CRITICAL_SECTION_THREE );
+	idFile *file = FindFileForRead( relativePath, searchFlags, foundInPak, allowCopyFiles, gamedir );
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_THREE );
+	return file;
+}
+
 /*
 ===========
 idFileSystemLocal::OpenFileRead
@@ -3640,13 +4126,10 @@ dword BackgroundDownloadThread( void *parms ) {
 		bgl->next = NULL;
 
 		if ( bgl->opcode == DLTYPE_FILE ) {
-			// use the low level read function, because fread may allocate memory
-            //#NOTE_SK: fixes compilation
-			#if 0//defined(WIN32)
-				_read( static_cast<idFile_Permanent*>(bgl->f)->GetFilePtr()->_file, bgl->file.buffer, bgl->file.length );
-			#else
-				fread(  bgl->file.buffer, bgl->file.length, 1, static_cast<idFile_Permanent*>(bgl->f)->GetFilePtr() );
-			#endif
+			// the heap is thread safe and every open file has a handle of its own,
+			// so this works for files in pak files as well
+			bgl->f->Seek( bgl->file.position, FS_SEEK_SET );
+			bgl->file.length = bgl->f->Read( bgl->file.buffer, bgl->file.length );
 			bgl->completed = true;
 		} else {
 #if ID_ENABLE_CURL
@@ -3763,27 +4246,11 @@ idFileSystemLocal::BackgroundDownload
 =================
 */
 void idFileSystemLocal::BackgroundDownload( backgroundDownload_t *bgl ) {
-	if ( bgl->opcode == DLTYPE_FILE ) {
-		if ( dynamic_cast<idFile_Permanent *>(bgl->f) ) {
-			// add the bgl to the background download list
-			Sys_EnterCriticalSection();
-			bgl->next = backgroundDownloads;
-			backgroundDownloads = bgl;
-			Sys_TriggerEvent();
-			Sys_LeaveCriticalSection();
-		} else {
-			// read zipped file directly
-			bgl->f->Seek( bgl->file.position, FS_SEEK_SET );
-			bgl->f->Read( bgl->file.buffer, bgl->file.length );
-			bgl->completed = true;
-		}
-	} else {
-		Sys_EnterCriticalSection();
-		bgl->next = backgroundDownloads;
-		backgroundDownloads = bgl;
-		Sys_TriggerEvent();
-		Sys_LeaveCriticalSection();
-	}
+	Sys_EnterCriticalSection();
+	bgl->next = backgroundDownloads;
+	backgroundDownloads = bgl;
+	Sys_TriggerEvent();
+	Sys_LeaveCriticalSection();
 }
 
 /*
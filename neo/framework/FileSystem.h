@@ -105,7 +105,7 @@ typedef struct urlDownload_s {
 
 typedef struct fileDownload_s {
 	int					position;
-	int					length;
+	int					length;			// set to the number of bytes read on completion
 	void *				buffer;
 } fileDownload_t;
 
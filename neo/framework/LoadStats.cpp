@@ -0,0 +1,92 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+static const char *loadCategoryNames[LOAD_NUM_CATEGORIES] = {
+	"map",
+	"game spawn",
+	"decls",
+	"models",
+	"images",
+	" image reads",
+	" image uploads",
+	"sounds"
+};
+
+idLoadStats		loadStats;
+
+/*
+================
+idLoadStats::Clear
+================
+*/
+void idLoadStats::Clear( void ) {
+	for ( int i = 0; i < LOAD_NUM_CATEGORIES; i++ ) {
+		msec[i] = 0.0;
+		counts[i] = 0;
+	}
+}
+
+/*
+================
+idLoadStats::Add
+================
+*/
+void idLoadStats::Add( loadCategory_t category, double ticks, int count ) {
+	msec[category] += ticks * 1000.0 / Sys_ClockTicksPerSecond();
+	counts[category] += count;
+}
+
+/*
+================
+idLoadStats::AddMsec
+================
+*/
+void idLoadStats::AddMsec( loadCategory_t category, double time, int count ) {
+	msec[category] += time;
+	counts[category] += count;
+}
+
+/*
+================
+idLoadStats::Print
+================
+*/
+void idLoadStats::Print( void ) const {
+	common->Printf( "--------- Level Load Times ---------\n" );
+	common->Printf( "category          count       msec\n" );
+	for ( int i = 0; i < LOAD_NUM_CATEGORIES; i++ ) {
+		if ( counts[i] == 0 ) {
+			continue;
+		}
+		common->Printf( "%-16s %6i %10.1f\n", loadCategoryNames[i], counts[i], msec[i] );
+	}
+	common->Printf( "image reads are summed over %i job threads\n", parallelJobManager->GetNumThreads() + 1 );
+}
@@ -0,0 +1,78 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __LOADSTATS_H__
+#define __LOADSTATS_H__
+
+/*
+===============================================================================
+
+	Level load statistics.
+
+	The systems that load media add the time they spend per asset category
+	while a level loads and the session prints a report when it is done.
+	Categories that cause loads of others include their time, entity
+	spawning includes the decls and models it parses and decl parses
+	include the models they load.  Image reads run on job threads and
+	their time is summed over all threads.
+
+	Times are only added from the main thread.
+
+===============================================================================
+*/
+
+typedef enum {
+	LOAD_MAP,					// render and collision world geometry
+	LOAD_GAME,					// entity spawning
+	LOAD_DECLS,					// decl parses
+	LOAD_MODELS,				// render model loads
+	LOAD_IMAGES,				// all image loads at the end of the level load
+	LOAD_IMAGE_READS,			// image file reads, decoding and mip mapping
+	LOAD_IMAGE_UPLOADS,			// image uploads and loads that can't run in a job
+	LOAD_SOUNDS,				// sound samples at the end of the level load
+	LOAD_NUM_CATEGORIES
+} loadCategory_t;
+
+class idLoadStats {
+public:
+					idLoadStats( void ) { Clear(); }
+
+	void			Clear( void );
+					// adds clock ticks
+	void			Add( loadCategory_t category, double ticks, int count );
+	void			AddMsec( loadCategory_t category, double msec, int count );
+	void			Print( void ) const;
+
+private:
+	double			msec[LOAD_NUM_CATEGORIES];
+	int				counts[LOAD_NUM_CATEGORIES];
+};
+
+extern idLoadStats	loadStats;
+
+#endif /* !__LOADSTATS_H__ */
@@ -0,0 +1,674 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+idCVar jobs_numThreads( "jobs_numThreads", "-1", CVAR_SYSTEM | CVAR_INTEGER | CVAR_INIT, "number of job worker threads, -1 = one less than the number of logical processors, 0 = run all jobs on the submitting thread", -1, MAX_JOB_THREADS );
+
+// must be a power of two
+const int JOB_DEQUE_SIZE			= 4096;
+
+// job thread slots, 0 is the main thread and the workers follow it
+const int MAX_JOB_SLOTS				= MAX_JOB_THREADS + 1;
+
+// slot of the calling thread, -1 if it isn't a job thread
+static ID_TLS int jobThreadSlot = -1;
+
+class idParallelJobListLocal;
+
+typedef struct {
+	jobRun_t					function;
+	void *						data;
+	idParallelJobListLocal *	list;
+} job_t;
+
+/*
+===============================================================================
+
+	idJobDeque
+
+	Fixed size work-stealing deque. Only the owning thread may call Push and
+	Pop, any thread may call Steal. The indexes are free running and only
+	ever compared by difference, so they can safely wrap.
+
+===============================================================================
+*/
+
+class idJobDeque {
+public:
+	void						Clear( void ) { top = bottom = 0; }
+	bool						Push( job_t *job );
+	job_t *						Pop( void );
+	job_t *						Steal( void );
+
+private:
+	interlockedInt_t			top;
+	interlockedInt_t			bottom;
+	job_t * volatile			jobs[JOB_DEQUE_SIZE];
+};
+
+/*
+================
+idJobDeque::Push
+================
+*/
+bool idJobDeque::Push( job_t *job ) {
+	int b = bottom;
+	int t = top;
+	if ( b - t >= JOB_DEQUE_SIZE ) {
+		return false;
+	}
+	jobs[b & ( JOB_DEQUE_SIZE - 1 )] = job;
+	// the job pointer has to be visible before the new bottom
+	Sys_InterlockedExchange( bottom, b + 1 );
+	return true;
+}
+
+/*
+================
+idJobDeque::Pop
+================
+*/
+job_t *idJobDeque::Pop( void ) {
+	int b = bottom - 1;
+	// the new bottom has to be visible before top is read, or a thief could take the same job
+	Sys_InterlockedExchange( bottom, b );
+	int t = top;
+	if ( b - t < 0 ) {
+		// the deque was empty
+		bottom = t;
+		return NULL;
+	}
+	job_t *job = jobs[b & ( JOB_DEQUE_SIZE - 1 )];
+	if ( b != t ) {
+		return job;
+	}
+	// last job, race against the thieves for it
+	if ( Sys_InterlockedCompareExchange( top, t, t + 1 ) != t ) {
+		job = NULL;
+	}
+	bottom = t + 1;
+	return job;
+}
+
+/*
+================
+idJobDeque::Steal
+================
+*/
+job_t *idJobDeque::Steal( void ) {
+	int t = top;
+	int b = bottom;
+	if ( b - t <= 0 ) {
+		return NULL;
+	}
+	job_t *job = jobs[t & ( JOB_DEQUE_SIZE - 1 )];
+	if ( Sys_InterlockedCompareExchange( top, t, t + 1 ) != t ) {
+		// lost the race against the owner or another thief
+		return NULL;
+	}
+	return job;
+}
+
+/*
+===============================================================================
+
+	idParallelJobListLocal
+
+===============================================================================
+*/
+
+typedef struct {
+	int							firstJob;
+	int							numJobs;
+} jobSegment_t;
+
+class idParallelJobManagerLocal;
+
+class idParallelJobListLocal : public idParallelJobList {
+public:
+								idParallelJobListLocal( idParallelJobManagerLocal *manager, const char *name );
+	virtual						~idParallelJobListLocal( void );
+
+	virtual const char *		GetName( void ) const { return name.c_str(); }
+
+	virtual void				AddJob( jobRun_t function, void *data );
+	virtual void				InsertSyncPoint( void );
+	virtual void				Clear( void );
+	virtual int					GetNumJobs( void ) const { return jobs.Num(); }
+
+	virtual void				Submit( void );
+	virtual void				Wait( void );
+	virtual bool				IsSubmitted( void ) const { return submitted; }
+	virtual bool				IsDone( void ) const { return done != 0; }
+
+	virtual const jobListStats_t &GetStats( void ) const { return stats; }
+
+	void						RunJob( job_t *job, int slot );
+
+private:
+	idParallelJobManagerLocal *	manager;
+	idStr						name;
+
+	idList<job_t>				jobs;
+	idList<int>					syncPoints;			// number of jobs in front of each sync point
+	idList<jobSegment_t>		segments;			// built from the sync points on Submit
+
+	bool						submitted;
+	interlockedInt_t			done;
+	interlockedInt_t			currentSegment;
+	interlockedInt_t			segmentJobsLeft;
+
+	// job timings, each job thread only writes to its own slot
+	double						submitTicks;
+	double						doneTicks;
+	double						slotTicks[MAX_JOB_SLOTS + 1];
+	double						slotMaxTicks[MAX_JOB_SLOTS + 1];
+	int							slotJobs[MAX_JOB_SLOTS + 1];
+
+	jobListStats_t				stats;
+
+	void						ExecuteJob( job_t *job, int slot );
+	void						FinishSegment( int slot );
+	void						UpdateStats( void );
+};
+
+/*
+===============================================================================
+
+	idParallelJobManagerLocal
+
+===============================================================================
+*/
+
+typedef struct {
+	idParallelJobManagerLocal *	manager;
+	int							slot;
+	char						name[16];
+	xthreadInfo					info;
+	signalHandle_t				signal;
+	interlockedInt_t			sleeping;
+} jobWorker_t;
+
+class idParallelJobManagerLocal : public idParallelJobManager {
+public:
+								idParallelJobManagerLocal( void );
+
+	virtual void				Init( void );
+	virtual void				Shutdown( void );
+
+	virtual idParallelJobList *	AllocJobList( const char *name );
+	virtual void				FreeJobList( idParallelJobList *jobList );
+
+	virtual int					GetNumThreads( void ) const { return numThreads; }
+	virtual int					GetThreadSlot( void ) const { return jobThreadSlot; }
+
+	void						PushJobs( job_t *jobs, int numJobs, int slot );
+	bool						RunOneJob( int slot );
+
+private:
+	int							numThreads;
+	interlockedInt_t			shutdown;
+	idJobDeque					deques[MAX_JOB_SLOTS];
+	jobWorker_t					workers[MAX_JOB_THREADS];
+	idList<idParallelJobListLocal *> jobLists;
+
+	void						WakeWorkers( void );
+	void						WorkerLoop( jobWorker_t &worker );
+
+	static unsigned int			WorkerThread( void *parm );
+	static void					ListJobs_f( const idCmdArgs &args );
+};
+
+idParallelJobManagerLocal		parallelJobManagerLocal;
+idParallelJobManager *			parallelJobManager = &parallelJobManagerLocal;
+
+/*
+================
+TicksToMicroSec
+================
+*/
+static float TicksToMicroSec( double ticks ) {
+	return (float)( ticks * 1000000.0 / Sys_ClockTicksPerSecond() );
+}
+
+/*
+================
+idParallelJobListLocal::idParallelJobListLocal
+================
+*/
+idParallelJobListLocal::idParallelJobListLocal( idParallelJobManagerLocal *manager, const char *name ) {
+	this->manager = manager;
+	this->name = name;
+	jobs.SetGranularity( 64 );
+	submitted = false;
+	done = 1;
+	currentSegment = 0;
+	segmentJobsLeft = 0;
+	submitTicks = doneTicks = 0.0;
+	memset( slotTicks, 0, sizeof( slotTicks ) );
+	memset( slotMaxTicks, 0, sizeof( slotMaxTicks ) );
+	memset( slotJobs, 0, sizeof( slotJobs ) );
+	memset( &stats, 0, sizeof( stats ) );
+}
+
+/*
+================
+idParallelJobListLocal::~idParallelJobListLocal
+================
+*/
+idParallelJobListLocal::~idParallelJobListLocal( void ) {
+	assert( !submitted );
+}
+
+/*
+================
+idParallelJobListLocal::AddJob
+================
+*/
+void idParallelJobListLocal::AddJob( jobRun_t function, void *data ) {
+	assert( !submitted );
+	job_t &job = jobs.Alloc();
+	job.function = function;
+	job.data = data;
+	job.list = this;
+}
+
+/*
+================
+idParallelJobListLocal::InsertSyncPoint
+================
+*/
+void idParallelJobListLocal::InsertSyncPoint( void ) {
+	assert( !submitted );
+	syncPoints.Append( jobs.Num() );
+}
+
+/*
+================
+idParallelJobListLocal::Clear
+================
+*/
+void idParallelJobListLocal::Clear( void ) {
+	assert( !submitted );
+	jobs.SetNum( 0, false );
+	syncPoints.SetNum( 0, false );
+}
+
+/*
+================
+idParallelJobListLocal::Submit
+================
+*/
+void idParallelJobListLocal::Submit( void ) {
+	assert( !submitted );
+
+	// split the jobs into segments, leaving out the empty ones
+	segments.SetNum( 0, false );
+	int first = 0;
+	for ( int i = 0; i <= syncPoints.Num(); i++ ) {
+		int end = ( i < syncPoints.Num() ) ? syncPoints[i] : jobs.Num();
+		if ( end > first ) {
+			jobSegment_t &segment = segments.Alloc();
+			segment.firstJob = first;
+			segment.numJobs = end - first;
+			first = end;
+		}
+	}
+
+	memset( slotTicks, 0, sizeof( slotTicks ) );
+	memset( slotMaxTicks, 0, sizeof( slotMaxTicks ) );
+	memset( slotJobs, 0, sizeof( slotJobs ) );
+
+	submitted = true;
+	submitTicks = Sys_GetClockTicks();
+
+	if ( segments.Num() == 0 ) {
+		doneTicks = submitTicks;
+		done = 1;
+		return;
+	}
+
+	// without workers, or from a thread that doesn't own a deque, simply run everything in order
+	if ( manager->GetNumThreads() == 0 || jobThreadSlot < 0 ) {
+		for ( int i = 0; i < jobs.Num(); i++ ) {
+			ExecuteJob( &jobs[i], jobThreadSlot );
+		}
+		doneTicks = Sys_GetClockTicks();
+		done = 1;
+		return;
+	}
+
+	done = 0;
+	currentSegment = 0;
+	Sys_InterlockedExchange( segmentJobsLeft, segments[0].numJobs );
+	manager->PushJobs( &jobs[segments[0].firstJob], segments[0].numJobs, jobThreadSlot );
+}
+
+/*
+================
+idParallelJobListLocal::Wait
+================
+*/
+void idParallelJobListLocal::Wait( void ) {
+	if ( !submitted ) {
+		return;
+	}
+
+	// help out instead of blocking, this also keeps nested job lists from deadlocking
+	while ( !done ) {
+		if ( jobThreadSlot < 0 || !manager->RunOneJob( jobThreadSlot ) ) {
+			Sys_Yield();
+		}
+	}
+
+	submitted = false;
+	UpdateStats();
+}
+
+/*
+================
+idParallelJobListLocal::ExecuteJob
+================
+*/
+void idParallelJobListLocal::ExecuteJob( job_t *job, int slot ) {
+	double start = Sys_GetClockTicks();
+	job->function( job->data );
+	double ticks = Sys_GetClockTicks() - start;
+
+	// threads outside the job system share the last slot, they never run jobs in parallel
+	int index = ( slot < 0 ) ? MAX_JOB_SLOTS : slot;
+	slotTicks[index] += ticks;
+	if ( ticks > slotMaxTicks[index] ) {
+		slotMaxTicks[index] = ticks;
+	}
+	slotJobs[index]++;
+}
+
+/*
+================
+idParallelJobListLocal::RunJob
+================
+*/
+void idParallelJobListLocal::RunJob( job_t *job, int slot ) {
+	ExecuteJob( job, slot );
+	if ( Sys_InterlockedDecrement( segmentJobsLeft ) == 0 ) {
+		FinishSegment( slot );
+	}
+}
+
+/*
+================
+idParallelJobListLocal::FinishSegment
+
+Called by the thread that completed the last job of the current segment.
+================
+*/
+void idParallelJobListLocal::FinishSegment( int slot ) {
+	int next = currentSegment + 1;
+	if ( next < segments.Num() ) {
+		currentSegment = next;
+		Sys_InterlockedExchange( segmentJobsLeft, segments[next].numJobs );
+		manager->PushJobs( &jobs[segments[next].firstJob], segments[next].numJobs, slot );
+		return;
+	}
+	doneTicks = Sys_GetClockTicks();
+	Sys_InterlockedExchange( done, 1 );
+}
+
+/*
+================
+idParallelJobListLocal::UpdateStats
+================
+*/
+void idParallelJobListLocal::UpdateStats( void ) {
+	double jobTicks = 0.0;
+	double maxTicks = 0.0;
+
+	stats.numJobs = jobs.Num();
+	stats.numSyncs = syncPoints.Num();
+	stats.numThreads = 0;
+	for ( int i = 0; i <= MAX_JOB_SLOTS; i++ ) {
+		if ( slotJobs[i] == 0 ) {
+			continue;
+		}
+		stats.numThreads++;
+		jobTicks += slotTicks[i];
+		if ( slotMaxTicks[i] > maxTicks ) {
+			maxTicks = slotMaxTicks[i];
+		}
+	}
+	stats.wallMicroSec = TicksToMicroSec( doneTicks - submitTicks );
+	stats.jobMicroSec = TicksToMicroSec( jobTicks );
+	stats.maxJobMicroSec = TicksToMicroSec( maxTicks );
+}
+
+/*
+================
+idParallelJobManagerLocal::idParallelJobManagerLocal
+================
+*/
+idParallelJobManagerLocal::idParallelJobManagerLocal( void ) {
+	numThreads = 0;
+	shutdown = 0;
+}
+
+/*
+================
+idParallelJobManagerLocal::Init
+================
+*/
+void idParallelJobManagerLocal::Init( void ) {
+	int i;
+
+	numThreads = jobs_numThreads.GetInteger();
+	if ( numThreads < 0 ) {
+		numThreads = Sys_GetNumLogicalProcessors() - 1;
+	}
+	numThreads = idMath::ClampInt( 0, MAX_JOB_THREADS, numThreads );
+
+	for ( i = 0; i < MAX_JOB_SLOTS; i++ ) {
+		deques[i].Clear();
+	}
+
+	// the thread that initializes the job system is the main thread
+	jobThreadSlot = 0;
+	shutdown = 0;
+
+	for ( i = 0; i < numThreads; i++ ) {
+		jobWorker_t &worker = workers[i];
+		worker.manager = this;
+		worker.slot = i + 1;
+		idStr::snPrintf( worker.name, sizeof( worker.name ), "JobWorker%d", i );
+		worker.signal = Sys_SignalCreate();
+		worker.sleeping = 0;
+		Sys_CreateThread( WorkerThread, &worker, THREAD_NORMAL, worker.info, worker.name, g_threads, &g_thread_count );
+	}
+
+	cmdSystem->AddCommand( "listJobs", ListJobs_f, CMD_FL_SYSTEM, "lists job lists with the timings of their last run" );
+
+	common->Printf( "job system: %d worker threads\n", numThreads );
+}
+
+/*
+================
+idParallelJobManagerLocal::Shutdown
+================
+*/
+void idParallelJobManagerLocal::Shutdown( void ) {
+	Sys_InterlockedExchange( shutdown, 1 );
+	for ( int i = 0; i < numThreads; i++ ) {
+		Sys_SignalRaise( workers[i].signal );
+	}
+	// the workers leave their loop when they see the shutdown flag, they are not
+	// canceled so they never stop while holding the lock of their signal
+	for ( int i = 0; i < numThreads; i++ ) {
+		Sys_WaitThread( workers[i].info );
+		Sys_SignalDestroy( workers[i].signal );
+	}
+	numThreads = 0;
+
+	jobLists.DeleteContents( true );
+
+	cmdSystem->RemoveCommand( "listJobs" );
+}
+
+/*
+================
+idParallelJobManagerLocal::AllocJobList
+================
+*/
+idParallelJobList *idParallelJobManagerLocal::AllocJobList( const char *name ) {
+	idParallelJobListLocal *jobList = new idParallelJobListLocal( this, name );
+	jobLists.Append( jobList );
+	return jobList;
+}
+
+/*
+================
+idParallelJobManagerLocal::FreeJobList
+================
+*/
+void idParallelJobManagerLocal::FreeJobList( idParallelJobList *jobList ) {
+	if ( jobList == NULL ) {
+		return;
+	}
+	jobList->Wait();
+	jobLists.Remove( static_cast<idParallelJobListLocal *>( jobList ) );
+	delete jobList;
+}
+
+/*
+================
+idParallelJobManagerLocal::PushJobs
+================
+*/
+void idParallelJobManagerLocal::PushJobs( job_t *jobs, int numJobs, int slot ) {
+	assert( slot >= 0 && slot <= numThreads );
+
+	for ( int i = 0; i < numJobs; i++ ) {
+		if ( !deques[slot].Push( &jobs[i] ) ) {
+			// the deque is full, let the workers drain it and run this one ourselves
+			WakeWorkers();
+			jobs[i].list->RunJob( &jobs[i], slot );
+		}
+	}
+	WakeWorkers();
+}
+
+/*
+================
+idParallelJobManagerLocal::RunOneJob
+
+Pops a job from the deque of the calling thread or steals one from another thread.
+================
+*/
+bool idParallelJobManagerLocal::RunOneJob( int slot ) {
+	job_t *job = deques[slot].Pop();
+	for ( int i = 1; job == NULL && i <= numThreads; i++ ) {
+		job = deques[( slot + i ) % ( numThreads + 1 )].Steal();
+	}
+	if ( job == NULL ) {
+		return false;
+	}
+	job->list->RunJob( job, slot );
+	return true;
+}
+
+/*
+================
+idParallelJobManagerLocal::WakeWorkers
+================
+*/
+void idParallelJobManagerLocal::WakeWorkers( void ) {
+	for ( int i = 0; i < numThreads; i++ ) {
+		if ( Sys_InterlockedExchange( workers[i].sleeping, 0 ) != 0 ) {
+			Sys_SignalRaise( workers[i].signal );
+		}
+	}
+}
+
+/*
+================
+idParallelJobManagerLocal::WorkerLoop
+================
+*/
+void idParallelJobManagerLocal::WorkerLoop( jobWorker_t &worker ) {
+	jobThreadSlot = worker.slot;
+
+	while ( !shutdown ) {
+		if ( RunOneJob( worker.slot ) ) {
+			continue;
+		}
+
+		// announce that we are going to sleep before checking one last time,
+		// so a thread pushing jobs right now is guaranteed to either see the
+		// flag or have its jobs found here
+		Sys_InterlockedExchange( worker.sleeping, 1 );
+		if ( RunOneJob( worker.slot ) ) {
+			Sys_InterlockedExchange( worker.sleeping, 0 );
+			continue;
+		}
+		if ( shutdown ) {
+			break;
+		}
+		Sys_SignalWait( worker.signal, SIGNAL_WAIT_INFINITE );
+	}
+}
+
+/*
+================
+idParallelJobManagerLocal::WorkerThread
+================
+*/
+unsigned int idParallelJobManagerLocal::WorkerThread( void *parm ) {
+	jobWorker_t *worker = (jobWorker_t *)parm;
+	worker->manager->WorkerLoop( *worker );
+	Mem_ReleaseThreadCache();
+	return 0;
+}
+
+/*
+================
+idParallelJobManagerLocal::ListJobs_f
+================
+*/
+void idParallelJobManagerLocal::ListJobs_f( const idCmdArgs &args ) {
+	idList<idParallelJobListLocal *> &lists = parallelJobManagerLocal.jobLists;
+
+	common->Printf( "%d worker threads\n", parallelJobManagerLocal.numThreads );
+	common->Printf( "jobs syncs threads   wall us    job us    max us name\n" );
+	common->Printf( "---- ----- ------- --------- --------- --------- ----\n" );
+	for ( int i = 0; i < lists.Num(); i++ ) {
+		const jobListStats_t &stats = lists[i]->GetStats();
+		common->Printf( "%4d %5d %7d %9.1f %9.1f %9.1f %s\n", stats.numJobs, stats.numSyncs, stats.numThreads,
+			stats.wallMicroSec, stats.jobMicroSec, stats.maxJobMicroSec, lists[i]->GetName() );
+	}
+	common->Printf( "%d job lists\n", lists.Num() );
+}
@@ -0,0 +1,108 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __PARALLELJOBLIST_H__
+#define __PARALLELJOBLIST_H__
+
+/*
+===============================================================================
+
+	Parallel job lists.
+
+	A job list collects independent jobs which are executed by a pool of
+	worker threads, by default one per logical processor besides the main
+	thread. Every job thread owns a deque, jobs are pushed and popped at the
+	bottom by the owner while idle threads steal them from the top.
+
+	Sync points split a job list into segments. No job added after a sync
+	point is started before all jobs added in front of it have completed.
+
+	Job lists may be submitted from the main thread or from within a job.
+	A list submitted from any other thread is executed in order on that
+	thread before Submit returns.
+
+===============================================================================
+*/
+
+typedef void ( *jobRun_t )( void * );
+
+const int MAX_JOB_THREADS			= 32;
+
+typedef struct {
+	int					numJobs;
+	int					numSyncs;
+	int					numThreads;			// number of threads that executed at least one job
+	float				wallMicroSec;		// from Submit until the last job completed
+	float				jobMicroSec;		// sum of the run time of all jobs
+	float				maxJobMicroSec;		// longest single job
+} jobListStats_t;
+
+class idParallelJobList {
+public:
+	virtual						~idParallelJobList( void ) {}
+
+	virtual const char *		GetName( void ) const = 0;
+
+								// jobs can only be added while the list is not running
+	virtual void				AddJob( jobRun_t function, void *data ) = 0;
+	virtual void				InsertSyncPoint( void ) = 0;
+								// removes all jobs and sync points
+	virtual void				Clear( void ) = 0;
+	virtual int					GetNumJobs( void ) const = 0;
+
+								// a list can be submitted again after Wait returned
+	virtual void				Submit( void ) = 0;
+								// the waiting thread helps executing jobs until the list is done
+	virtual void				Wait( void ) = 0;
+	virtual bool				IsSubmitted( void ) const = 0;
+	virtual bool				IsDone( void ) const = 0;
+
+								// timings of the last run that was waited on
+	virtual const jobListStats_t &GetStats( void ) const = 0;
+};
+
+class idParallelJobManager {
+public:
+	virtual						~idParallelJobManager( void ) {}
+
+	virtual void				Init( void ) = 0;
+	virtual void				Shutdown( void ) = 0;
+
+	virtual idParallelJobList *	AllocJobList( const char *name ) = 0;
+	virtual void				FreeJobList( idParallelJobList *jobList ) = 0;
+
+								// number of worker threads, not counting the main thread
+	virtual int					GetNumThreads( void ) const = 0;
+								// 0 on the main thread, 1 to GetNumThreads() on the workers
+								// and -1 on threads that are not part of the job system
+	virtual int					GetThreadSlot( void ) const = 0;
+};
+
+extern idParallelJobManager *	parallelJobManager;
+
+#endif /* !__PARALLELJOBLIST_H__ */
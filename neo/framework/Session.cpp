@@ -1564,6 +1564,9 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 		currentMapName = fullMapName;
 	}
 
+	// time the loads from here on
+	loadStats.Clear();
+
 	// note which media we are going to need to load
 	if ( !reloadingSameMap ) {
 		declManager->BeginLevelLoad();
@@ -1613,9 +1616,11 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 	common->Printf( "Map: %s\n", mapString.c_str() );
 
 	// let the renderSystem load all the geometry
+	double loadStart = Sys_GetClockTicks();
 	if ( !rw->InitFromMap( fullMapName ) ) {
 		common->Error( "couldn't load %s", fullMapName.c_str() );
 	}
+	loadStats.Add( LOAD_MAP, Sys_GetClockTicks() - loadStart, 1 );
 
 	// for the synchronous networking we needed to roll the angles over from
 	// level to level, but now we can just clear everything
@@ -1629,6 +1634,8 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 	}
 
 	// load and spawn all other entities ( from a savegame possibly )
+	loadStart = Sys_GetClockTicks();
+	memTag_t oldMemTag = Mem_SetTag( MEM_TAG_GAME );
 	if ( loadingSaveGame && savegameFile ) {
 		if ( game->InitFromSaveGame( fullMapName + ".map", rw, sw, savegameFile ) == false ) {
 			// If the loadgame failed, restart the map with the player persistent data
@@ -1643,6 +1650,7 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 		game->SetServerInfo( mapSpawnData.serverInfo );
 		game->InitFromNewMap( fullMapName + ".map", rw, sw, idAsyncNetwork::server.IsActive(), idAsyncNetwork::client.IsActive(), Sys_Milliseconds() );
 	}
+	Mem_SetTag( oldMemTag );
 
 	if ( !idAsyncNetwork::IsActive() && !loadingSaveGame ) {
 		// spawn players
@@ -1650,11 +1658,14 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 			game->SpawnPlayer( i );
 		}
 	}
+	loadStats.Add( LOAD_GAME, Sys_GetClockTicks() - loadStart, 1 );
 
 	// actually purge/load the media
 	if ( !reloadingSameMap ) {
 		renderSystem->EndLevelLoad();
+		loadStart = Sys_GetClockTicks();
 		soundSystem->EndLevelLoad( mapString.c_str() );
+		loadStats.Add( LOAD_SOUNDS, Sys_GetClockTicks() - loadStart, 1 );
 		declManager->EndLevelLoad();
 		SetBytesNeededForMapLoad( mapString.c_str(), fileSystem->GetReadCount() );
 	}
@@ -1671,6 +1682,7 @@ void idSessionLocal::ExecuteMapChange( bool noFadeWipe ) {
 
 	int	msec = Sys_Milliseconds() - start;
 	common->Printf( "%6d msec to load %s\n", msec, mapString.c_str() );
+	loadStats.Print();
 
 	// let the renderSystem generate interactions now that everything is spawned
 	rw->GenerateAllInteractions();
@@ -2774,7 +2786,9 @@ void idSessionLocal::RunGameTic() {
 
 	// run the game logic every player move
 	int	start = Sys_Milliseconds();
+	memTag_t oldMemTag = Mem_SetTag( MEM_TAG_GAME );
 	gameReturn_t	ret = game->RunFrame( &cmd );
+	Mem_SetTag( oldMemTag );
 
 	int end = Sys_Milliseconds();
 	time_gameFrame += end - start;	// note time used for com_speeds
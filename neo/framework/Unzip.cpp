@@ -2237,6 +2237,34 @@ extern int unzGetGlobalComment (unzFile file, char *szComment, uLong uSizeBuf)
 	return (int)uReadThis;
 }
 
+/*
+  Raw inflate of data that is already in memory, used for memory mapped pk4 files.
+  The caller sets up next_in/avail_in and next_out/avail_out of the stream.
+*/
+extern int unzInflateInit (z_stream *stream)
+{
+	stream->zalloc = (alloc_func)0;
+	stream->zfree = (free_func)0;
+	stream->opaque = (voidp)0;
+	stream->total_out = 0;
+	return inflateInit2(stream, -MAX_WBITS);
+}
+
+extern int unzInflate (z_stream *stream)
+{
+	return inflate(stream, Z_SYNC_FLUSH);
+}
+
+extern int unzInflateReset (z_stream *stream)
+{
+	return inflateReset(stream);
+}
+
+extern int unzInflateEnd (z_stream *stream)
+{
+	return inflateEnd(stream);
+}
+
 /* crc32.c -- compute the CRC-32 of a data stream
  * Copyright (C) 1995-1998 Mark Adler
  * For conditions of distribution and use, see copyright notice in zlib.h 
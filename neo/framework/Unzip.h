@@ -170,6 +170,7 @@ typedef struct
 #define UNZ_BADZIPFILE                  (-103)
 #define UNZ_INTERNALERROR               (-104)
 #define UNZ_CRCERROR                    (-105)
+#define UNZ_STREAM_END                  (1)
 
 #define UNZ_CASESENSITIVE		1
 #define UNZ_NOTCASESENSITIVE	2
@@ -343,4 +344,19 @@ extern int unzGetLocalExtrafield (unzFile file, void* buf, unsigned len);
 	the error code
 */
 
+/***************************************************************************/
+/* raw inflate of memory resident data, for reading memory mapped zip files */
+
+extern int unzInflateInit (z_stream *stream);
+extern int unzInflate (z_stream *stream);
+extern int unzInflateReset (z_stream *stream);
+extern int unzInflateEnd (z_stream *stream);
+
+/*
+  The caller sets next_in/avail_in to the compressed data and next_out/avail_out
+    to the output buffer before calling unzInflate.
+  unzInflate returns UNZ_OK if some progress was made, UNZ_STREAM_END at the end
+    of the compressed data, or a zLib error code <0
+*/
+
 #endif /* __UNZIP_H__ */
@@ -41,16 +41,46 @@ If you have questions concerning this license or the applicable additional terms
 //
 //	idHeap
 //
+//	Thread caching allocator. Allocations of up to 32 kB are served
+//	from size class bins. Every thread owns a cache with a free list per
+//	size class, so most allocations and frees never touch shared state.
+//	Blocks move between the thread caches and the shared bins in batches.
+//	The shared bins carve new blocks out of spans allocated from the OS
+//	and each bin is guarded by its own spin lock.
+//
+//	Allocations of up to 1 MB go to malloc, larger ones are mapped
+//	directly from the OS and returned to it when freed.
+//
+//	Every block is preceded by an 8 byte header with the usable size,
+//	the memory tag and the allocation type. All blocks are 16 byte
+//	aligned, so Allocate16 is the same as Allocate.
+//
 //===============================================================
 
-#define SMALL_HEADER_SIZE		( (int) ( sizeof( byte ) + sizeof( byte ) ) )
-#define MEDIUM_HEADER_SIZE		( (int) ( sizeof( mediumHeapEntry_s ) + sizeof( byte ) ) )
-#define LARGE_HEADER_SIZE		( (int) ( sizeof( dword * ) + sizeof( byte ) ) )
-
-#define ALIGN_SIZE( bytes )		( ( (bytes) + ALIGN - 1 ) & ~(ALIGN - 1) )
-#define SMALL_ALIGN( bytes )	( ALIGN_SIZE( (bytes) + SMALL_HEADER_SIZE ) - SMALL_HEADER_SIZE )
-#define MEDIUM_SMALLEST_SIZE	( ALIGN_SIZE( 256 ) + ALIGN_SIZE( MEDIUM_HEADER_SIZE ) )
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sched.h>
+#endif
 
+#define HEAP_HEADER_SIZE		8
+#define HEAP_HEADER( p )		( (idHeap::header_s *) ( ( (byte *) (p) ) - HEAP_HEADER_SIZE ) )
+#define HEAP_NUM_BINS			44
+#define HEAP_MAX_BIN_STRIDE		32768
+#define HEAP_MAX_BIN_SIZE		( HEAP_MAX_BIN_STRIDE - HEAP_HEADER_SIZE )
+#define HEAP_MAX_LARGE_SIZE		( 1 << 20 )
+#define HEAP_MIN_SPAN_SIZE		( 1 << 16 )
+#define HEAP_MAX_BATCH			64
+#define HEAP_PAGE_SIZE			4096
+
+static ID_TLS int				heap_threadTag = MEM_TAG_MISC;
+static ID_TLS void *			heap_threadCache = NULL;
+static ID_TLS int				heap_threadCacheSerial = 0;
+static int						heap_serial = 0;
+
+static int						mem_profileRate = 0;	// allocation profiler sample rate, 0 if off
+static ID_TLS int				mem_profileCountdown = 0;
+static byte						Mem_ProfileSample( void *p, int size, int tag );
+static void						Mem_ProfileFree( void *p );
 
 class idHeap {
 
@@ -67,81 +97,201 @@ public:
 
 	void 			AllocDefragBlock( void );		// hack for huge renderbumps
 
+	void			ReleaseThreadCache( void );		// return the blocks cached by the calling thread to the shared bins
+
+	void			ClearFrameStats( void );
+	void			GetFrameStats( memoryStats_t &allocs, memoryStats_t &frees );
+	void			GetStats( memoryStats_t &stats );
+	void			GetTagStats( int tag, memoryStats_t &stats );
+
 private:
 
 	enum {
-		ALIGN = 8									// memory alignment in bytes
+		INVALID_ALLOC	= 0xdd,
+		SMALL_ALLOC		= 0xaa,						// small allocation from the bins
+		LARGE_ALLOC		= 0xcc,						// large allocation from malloc
+		HUGE_ALLOC		= 0xee						// huge allocation mapped from the OS
 	};
 
-	enum {
-		INVALID_ALLOC	= 0xdd,
-		SMALL_ALLOC		= 0xaa,						// small allocation
-		MEDIUM_ALLOC	= 0xbb,						// medium allocaction
-		LARGE_ALLOC		= 0xcc						// large allocaction
+	struct header_s {								// in front of every block
+		dword				size;					// usable bytes
+		byte				tag;					// memTag_t of the allocation
+		byte				bin;					// size class of small allocations
+		byte				profiled;				// non-zero if the allocation profiler tracks the block
+		byte				type;					// allocation type, last so it is the byte in front of the data
 	};
 
-	struct page_s {									// allocation page
-		void *				data;					// data pointer to allocated memory
-		dword				dataSize;				// number of bytes of memory 'data' points to
-		page_s *			next;					// next free page in same page manager
-		page_s *			prev;					// used only when allocated
-		dword				largestFree;			// this data used by the medium-size heap manager
-		void *				firstFree;				// pointer to first free entry
+	struct bin_s {									// shared blocks of one size class
+		volatile long		lock;					// spin lock
+		int					stride;					// block size including the header
+		int					batch;					// number of blocks moved to or from a thread cache at once
+		int					spanSize;				// bytes per span
+		void *				freeList;				// blocks returned by the thread caches
+		int					numFree;
+		byte *				carve;					// next unused block in the newest span
+		int					carveLeft;				// number of unused blocks in the newest span
+		void *				spans;					// all spans, linked through their first pointer
+		int					numSpans;
 	};
 
-	struct mediumHeapEntry_s {
-		page_s *			page;					// pointer to page
-		dword				size;					// size of block
-		mediumHeapEntry_s *	prev;					// previous block
-		mediumHeapEntry_s *	next;					// next block
-		mediumHeapEntry_s *	prevFree;				// previous free block
-		mediumHeapEntry_s *	nextFree;				// next free block
-		dword				freeBlock;				// non-zero if free block
+	struct threadCache_s {							// blocks and statistics of one thread
+		threadCache_s *		next;					// next in the list of all thread caches
+		bool				inUse;					// false if the owning thread released the cache
+		void *				freeList[HEAP_NUM_BINS];
+		int					numFree[HEAP_NUM_BINS];
+		int					frameCount;				// frame the frame statistics belong to
+		memoryStats_t		totalAllocs;
+		memoryStats_t		frameAllocs;
+		memoryStats_t		frameFrees;
+		memoryStats_t		tagAllocs[MEM_TAG_MAX];
 	};
 
 	// variables
-	void *			smallFirstFree[256/ALIGN+1];	// small heap allocator lists (for allocs of 1-255 bytes)
-	page_s *		smallCurPage;					// current page for small allocations
-	dword			smallCurPageOffset;				// byte offset in current page
-	page_s *		smallFirstUsedPage;				// first used page of the small heap manager
+	bin_s			bins[HEAP_NUM_BINS];
+	byte			binForStride[HEAP_MAX_BIN_STRIDE/16+1];	// size class for a block size in 16 byte units
 
-	page_s *		mediumFirstFreePage;			// first partially free page
-	page_s *		mediumLastFreePage;				// last partially free page
-	page_s *		mediumFirstUsedPage;			// completely used page
+	volatile long	cacheLock;						// guards the list of thread caches
+	threadCache_s *	caches;							// all thread caches, never freed before the heap is destroyed
+	int				serial;							// tells the thread caches of different heaps apart
+	volatile int	frameCount;						// incremented by ClearFrameStats
 
-	page_s *		largeFirstUsedPage;				// first page used by the large heap manager
+	void			*defragBlock;					// a single huge block that can be allocated
+													// at startup, then freed when needed
 
-	page_s *		swapPage;
+	// methods
+	threadCache_s *	GetThreadCache( void ) {		// cache of the calling thread
+						if ( heap_threadCacheSerial == serial ) {
+							return (threadCache_s *) heap_threadCache;
+						}
+						return AcquireThreadCache();
+					}
+	threadCache_s *	AcquireThreadCache( void );
 
-	dword			pagesAllocated;					// number of pages currently allocated
-	dword			pageSize;						// size of one alloc page in bytes
+	void			RefillCache( threadCache_s *cache, int binNum );
+	void			FlushCache( threadCache_s *cache, int binNum, int count );
 
-	dword			pageRequests;					// page requests
-	dword			OSAllocs;						// number of allocs made to the OS
+	void *			SmallAllocate( threadCache_s *cache, dword bytes );	// allocate memory (1-32760 bytes) from the bins
+	void			SmallFree( threadCache_s *cache, void *ptr );		// return memory to the bins
 
-	int				c_heapAllocRunningCount;
+	void *			LargeAllocate( dword bytes );	// allocate memory from malloc
+	void			LargeFree( void *ptr );			// free memory allocated by the large heap manager
 
-	void			*defragBlock;					// a single huge block that can be allocated
-													// at startup, then freed when needed
+	void *			HugeAllocate( dword bytes );	// allocate pages from the OS directly
+	void			HugeFree( void *ptr );			// free memory allocated by the huge heap manager
 
-	// methods
-	page_s *		AllocatePage( dword bytes );	// allocate page from the OS
-	void			FreePage( idHeap::page_s *p );	// free an OS allocated page
+	void			UpdateAllocStats( threadCache_s *cache, int size, int tag );
+	void			UpdateFreeStats( threadCache_s *cache, int size, int tag );
+};
+
+/*
+================
+Heap_Lock
+================
+*/
+static ID_INLINE void Heap_Lock( volatile long *lock ) {
+	int spins = 0;
+#ifdef _WIN32
+	while ( _InterlockedCompareExchange( lock, 1, 0 ) != 0 ) {
+		while ( *lock != 0 ) {
+			if ( ++spins > 64 ) {
+				SwitchToThread();
+				spins = 0;
+			} else {
+				YieldProcessor();
+			}
+		}
+	}
+#else
+	while ( __sync_val_compare_and_swap( lock, 0, 1 ) != 0 ) {
+		while ( *lock != 0 ) {
+			if ( ++spins > 64 ) {
+				sched_yield();
+				spins = 0;
+			}
+		}
+	}
+#endif
+}
+
+/*
+================
+Heap_Unlock
+================
+*/
+static ID_INLINE void Heap_Unlock( volatile long *lock ) {
+#ifdef _WIN32
+	_InterlockedExchange( lock, 0 );
+#else
+	__sync_lock_release( lock );
+#endif
+}
 
-	void *			SmallAllocate( dword bytes );	// allocate memory (1-255 bytes) from small heap manager
-	void			SmallFree( void *ptr );			// free memory allocated by small heap manager
+/*
+================
+Heap_AllocPages
+================
+*/
+static void *Heap_AllocPages( size_t bytes ) {
+#ifdef _WIN32
+	return VirtualAlloc( NULL, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+#else
+	void *p = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+	return ( p != MAP_FAILED ) ? p : NULL;
+#endif
+}
 
-	void *			MediumAllocateFromPage( idHeap::page_s *p, dword sizeNeeded );
-	void *			MediumAllocate( dword bytes );	// allocate memory (256-32768 bytes) from medium heap manager
-	void			MediumFree( void *ptr );		// free memory allocated by medium heap manager
+/*
+================
+Heap_FreePages
+================
+*/
+static void Heap_FreePages( void *p, size_t bytes ) {
+#ifdef _WIN32
+	VirtualFree( p, 0, MEM_RELEASE );
+#else
+	munmap( p, bytes );
+#endif
+}
 
-	void *			LargeAllocate( dword bytes );	// allocate large block from OS directly
-	void			LargeFree( void *ptr );			// free memory allocated by large heap manager
+/*
+================
+Heap_ClearStats
+================
+*/
+static void Heap_ClearStats( memoryStats_t &stats ) {
+	stats.num = 0;
+	stats.minSize = 0x0fffffff;
+	stats.maxSize = -1;
+	stats.totalSize = 0;
+}
 
-	void			ReleaseSwappedPages( void );
-	void			FreePageReal( idHeap::page_s *p );
-};
+/*
+================
+Heap_UpdateStats
+================
+*/
+static ID_INLINE void Heap_UpdateStats( memoryStats_t &stats, int size ) {
+	stats.num++;
+	if ( size < stats.minSize ) {
+		stats.minSize = size;
+	}
+	if ( size > stats.maxSize ) {
+		stats.maxSize = size;
+	}
+	stats.totalSize += size;
+}
 
+/*
+================
+Heap_AddStats
+================
+*/
+static void Heap_AddStats( memoryStats_t &stats, const memoryStats_t &add ) {
+	stats.num += add.num;
+	stats.minSize = Min( stats.minSize, add.minSize );
+	stats.maxSize = Max( stats.maxSize, add.maxSize );
+	stats.totalSize += add.totalSize;
+}
 
 /*
 ================
@@ -149,27 +299,40 @@ idHeap::Init
 ================
 */
 void idHeap::Init () {
-	OSAllocs			= 0;
-	pageRequests		= 0;
-	pageSize			= 65536 - sizeof( idHeap::page_s );
-	pagesAllocated		= 0;								// reset page allocation counter
+	int stride = 16;
+	for ( int i = 0; i < HEAP_NUM_BINS; i++ ) {
+		bin_s &bin = bins[i];
+		memset( &bin, 0, sizeof( bin ) );
+		bin.stride = stride;
+		bin.batch = Max( 2, Min( HEAP_MAX_BATCH, HEAP_MIN_SPAN_SIZE / 2 / stride ) );
+		bin.spanSize = Max( HEAP_MIN_SPAN_SIZE, 8 * stride );
+
+		// 16 byte steps up to 256 bytes, then four steps per power of two
+		if ( stride < 256 ) {
+			stride += 16;
+		} else {
+			int pow2 = 256;
+			while ( pow2 * 2 <= stride ) {
+				pow2 *= 2;
+			}
+			stride += pow2 / 4;
+		}
+	}
+	assert( bins[HEAP_NUM_BINS-1].stride == HEAP_MAX_BIN_STRIDE );
 
-	largeFirstUsedPage	= NULL;								// init large heap manager
-	swapPage			= NULL;
+	for ( int i = 0, binNum = 0; i <= HEAP_MAX_BIN_STRIDE / 16; i++ ) {
+		if ( i * 16 > bins[binNum].stride ) {
+			binNum++;
+		}
+		binForStride[i] = binNum;
+	}
 
-	memset( smallFirstFree, 0, sizeof(smallFirstFree) );	// init small heap manager
-	smallFirstUsedPage	= NULL;
-	smallCurPage		= AllocatePage( pageSize );
-	assert( smallCurPage );
-	smallCurPageOffset	= SMALL_ALIGN( 0 );
+	cacheLock		= 0;
+	caches			= NULL;
+	serial			= ++heap_serial;
+	frameCount		= 0;
 
 	defragBlock = NULL;
-
-	mediumFirstFreePage	= NULL;								// init medium heap manager
-	mediumLastFreePage	= NULL;
-	mediumFirstUsedPage	= NULL;
-
-	c_heapAllocRunningCount = 0;
 }
 
 /*
@@ -190,46 +353,29 @@ idHeap::~idHeap
 */
 idHeap::~idHeap( void ) {
 
-	idHeap::page_s	*p;
-
-	if ( smallCurPage ) {
-		FreePage( smallCurPage );			// free small-heap current allocation page
-	}
-	p = smallFirstUsedPage;					// free small-heap allocated pages 
-	while( p ) {
-		idHeap::page_s *next = p->next;
-		FreePage( p );
-		p= next;
-	}
-
-	p = largeFirstUsedPage;					// free large-heap allocated pages
-	while( p ) {
-		idHeap::page_s *next = p->next;
-		FreePage( p );
-		p = next;
+	for ( int i = 0; i < HEAP_NUM_BINS; i++ ) {
+		bin_s &bin = bins[i];
+		while( bin.spans ) {
+			void *next = *(void **)bin.spans;
+			Heap_FreePages( bin.spans, bin.spanSize );
+			bin.spans = next;
+		}
 	}
 
-	p = mediumFirstFreePage;				// free medium-heap allocated pages
-	while( p ) {
-		idHeap::page_s *next = p->next;
-		FreePage( p );
-		p = next;
+	while( caches ) {
+		threadCache_s *next = caches->next;
+		free( caches );
+		caches = next;
 	}
 
-	p = mediumFirstUsedPage;				// free medium-heap allocated completely used pages
-	while( p ) {
-		idHeap::page_s *next = p->next;
-		FreePage( p );
-		p = next;
+	if ( heap_threadCacheSerial == serial ) {
+		heap_threadCache = NULL;
+		heap_threadCacheSerial = 0;
 	}
 
-	ReleaseSwappedPages();			
-
 	if ( defragBlock ) {
 		free( defragBlock );
 	}
-
-	assert( pagesAllocated == 0 );
 }
 
 /*
@@ -262,18 +408,30 @@ void *idHeap::Allocate( const dword bytes ) {
 	if ( !bytes ) {
 		return NULL;
 	}
-	c_heapAllocRunningCount++;
+
+	threadCache_s *cache = GetThreadCache();
 
 #if USE_LIBC_MALLOC
-	return malloc( bytes );
+	void *p = malloc( bytes );
+	UpdateAllocStats( cache, Msize( p ), MEM_TAG_MISC );
+	return p;
 #else
-	if ( !(bytes & ~255) ) {
-		return SmallAllocate( bytes );
+	void *p;
+	if ( bytes <= HEAP_MAX_BIN_SIZE ) {
+		p = SmallAllocate( cache, bytes );
+	} else if ( bytes <= HEAP_MAX_LARGE_SIZE ) {
+		p = LargeAllocate( bytes );
+	} else {
+		p = HugeAllocate( bytes );
 	}
-	if ( !(bytes & ~32767) ) {
-		return MediumAllocate( bytes );
+	header_s *header = HEAP_HEADER( p );
+	header->tag = heap_threadTag;
+	header->profiled = 0;
+	if ( mem_profileRate && --mem_profileCountdown <= 0 ) {
+		header->profiled = Mem_ProfileSample( p, header->size, header->tag );
 	}
-	return LargeAllocate( bytes );
+	UpdateAllocStats( cache, header->size, header->tag );
+	return p;
 #endif
 }
 
@@ -286,24 +444,33 @@ void idHeap::Free( void *p ) {
 	if ( !p ) {
 		return;
 	}
-	c_heapAllocRunningCount--;
+
+	threadCache_s *cache = GetThreadCache();
 
 #if USE_LIBC_MALLOC
+	UpdateFreeStats( cache, Msize( p ), MEM_TAG_MISC );
 	free( p );
 #else
-	switch( ((byte *)(p))[-1] ) {
+	header_s *header = HEAP_HEADER( p );
+	if ( header->profiled ) {
+		Mem_ProfileFree( p );
+	}
+	switch( header->type ) {
 		case SMALL_ALLOC: {
-			SmallFree( p );
-			break;
-		}
-		case MEDIUM_ALLOC: {
-			MediumFree( p );
+			UpdateFreeStats( cache, header->size, header->tag );
+			SmallFree( cache, p );
 			break;
 		}
 		case LARGE_ALLOC: {
+			UpdateFreeStats( cache, header->size, header->tag );
 			LargeFree( p );
 			break;
 		}
+		case HUGE_ALLOC: {
+			UpdateFreeStats( cache, header->size, header->tag );
+			HugeFree( p );
+			break;
+		}
 		default: {
 			idLib::common->FatalError( "idHeap::Free: invalid memory block (%s)", idLib::sys->GetCallStackCurStr( 4 ) );
 			break;
@@ -318,6 +485,7 @@ idHeap::Allocate16
 ================
 */
 void *idHeap::Allocate16( const dword bytes ) {
+#if USE_LIBC_MALLOC
 	byte *ptr, *alignedPtr;
 
 	ptr = (byte *) malloc( bytes + 16 + 4 );
@@ -326,7 +494,7 @@ void *idHeap::Allocate16( const dword bytes ) {
 			idLib::common->Printf( "Freeing defragBlock on alloc of %i.\n", bytes );
 			free( defragBlock );
 			defragBlock = NULL;
-			ptr = (byte *) malloc( bytes + 16 + 4 );			
+			ptr = (byte *) malloc( bytes + 16 + 4 );
 			AllocDefragBlock();
 		}
 		if ( !ptr ) {
@@ -339,6 +507,9 @@ void *idHeap::Allocate16( const dword bytes ) {
 	}
 	*((int *)(alignedPtr - 4)) = (int) ptr;
 	return (void *) alignedPtr;
+#else
+	return Allocate( bytes );
+#endif
 }
 
 /*
@@ -347,7 +518,11 @@ idHeap::Free16
 ================
 */
 void idHeap::Free16( void *p ) {
+#if USE_LIBC_MALLOC
 	free( (void *) *((int *) (( (byte *) p ) - 4)) );
+#else
+	Free( p );
+#endif
 }
 
 /*
@@ -373,15 +548,12 @@ dword idHeap::Msize( void *p ) {
 		return 0;
 	#endif
 #else
-	switch( ((byte *)(p))[-1] ) {
-		case SMALL_ALLOC: {
-			return SMALL_ALIGN( ((byte *)(p))[-SMALL_HEADER_SIZE] * ALIGN );
-		}
-		case MEDIUM_ALLOC: {
-			return ((mediumHeapEntry_s *)(((byte *)(p)) - ALIGN_SIZE( MEDIUM_HEADER_SIZE )))->size - ALIGN_SIZE( MEDIUM_HEADER_SIZE );
-		}
-		case LARGE_ALLOC: {
-			return ((idHeap::page_s*)(*((dword *)(((byte *)p) - ALIGN_SIZE( LARGE_HEADER_SIZE )))))->dataSize - ALIGN_SIZE( LARGE_HEADER_SIZE );
+	header_s *header = HEAP_HEADER( p );
+	switch( header->type ) {
+		case SMALL_ALLOC:
+		case LARGE_ALLOC:
+		case HUGE_ALLOC: {
+			return header->size;
 		}
 		default: {
 			idLib::common->FatalError( "idHeap::Msize: invalid memory block (%s)", idLib::sys->GetCallStackCurStr( 4 ) );
@@ -399,130 +571,291 @@ idHeap::Dump
 ================
 */
 void idHeap::Dump( void ) {
-	idHeap::page_s	*pg;
+	int totalSpans = 0, totalSpanBytes = 0, numCaches = 0, numCachesInUse = 0;
 
-	for ( pg = smallFirstUsedPage; pg; pg = pg->next ) {
-		idLib::common->Printf( "%p  bytes %-8d  (in use by small heap)\n", pg->data, pg->dataSize);
+	for ( int i = 0; i < HEAP_NUM_BINS; i++ ) {
+		bin_s &bin = bins[i];
+		if ( !bin.numSpans ) {
+			continue;
+		}
+		int numCached = 0;
+		Heap_Lock( &cacheLock );
+		for ( threadCache_s *cache = caches; cache; cache = cache->next ) {
+			numCached += cache->numFree[i];
+		}
+		Heap_Unlock( &cacheLock );
+		idLib::common->Printf( "bin %5d bytes  spans %-4d  span bytes %-8d  shared free %-6d  cached free %d\n",
+			bin.stride - HEAP_HEADER_SIZE, bin.numSpans, bin.numSpans * bin.spanSize, bin.numFree, numCached );
+		totalSpans += bin.numSpans;
+		totalSpanBytes += bin.numSpans * bin.spanSize;
+	}
+
+	Heap_Lock( &cacheLock );
+	for ( threadCache_s *cache = caches; cache; cache = cache->next ) {
+		numCaches++;
+		if ( cache->inUse ) {
+			numCachesInUse++;
+		}
 	}
+	Heap_Unlock( &cacheLock );
 
-	if ( smallCurPage ) {
-		pg = smallCurPage;
-		idLib::common->Printf( "%p  bytes %-8d  (small heap active page)\n", pg->data, pg->dataSize );
-	}
+	idLib::common->Printf( "spans allocated : %d (%d kB)\n", totalSpans, totalSpanBytes >> 10 );
+	idLib::common->Printf( "thread caches   : %d (%d in use)\n", numCaches, numCachesInUse );
+}
 
-	for ( pg = mediumFirstUsedPage; pg; pg = pg->next ) {
-		idLib::common->Printf( "%p  bytes %-8d  (completely used by medium heap)\n", pg->data, pg->dataSize );
-	}
+/*
+================
+idHeap::ReleaseThreadCache
 
-	for ( pg = mediumFirstFreePage; pg; pg = pg->next ) {
-		idLib::common->Printf( "%p  bytes %-8d  (partially used by medium heap)\n", pg->data, pg->dataSize );
+  called by threads before they exit, the cache is reused by the next new thread
+================
+*/
+void idHeap::ReleaseThreadCache( void ) {
+	if ( heap_threadCacheSerial != serial ) {
+		return;
 	}
-	
-	for ( pg = largeFirstUsedPage; pg; pg = pg->next ) {
-		idLib::common->Printf( "%p  bytes %-8d  (fully used by large heap)\n", pg->data, pg->dataSize );
+
+	threadCache_s *cache = (threadCache_s *) heap_threadCache;
+	for ( int i = 0; i < HEAP_NUM_BINS; i++ ) {
+		if ( cache->numFree[i] ) {
+			FlushCache( cache, i, cache->numFree[i] );
+		}
 	}
 
-	idLib::common->Printf( "pages allocated : %d\n", pagesAllocated );
+	Heap_Lock( &cacheLock );
+	cache->inUse = false;
+	Heap_Unlock( &cacheLock );
+
+	heap_threadCache = NULL;
+	heap_threadCacheSerial = 0;
 }
 
 /*
 ================
-idHeap::FreePageReal
+idHeap::ClearFrameStats
+================
+*/
+void idHeap::ClearFrameStats( void ) {
+	// the thread caches reset their frame statistics on their next update
+	frameCount++;
+}
 
-  frees page to be used by the OS
-  p	= page to free
+/*
+================
+idHeap::GetFrameStats
 ================
 */
-void idHeap::FreePageReal( idHeap::page_s *p ) {
-	assert( p );
-	::free( p );
+void idHeap::GetFrameStats( memoryStats_t &allocs, memoryStats_t &frees ) {
+	Heap_ClearStats( allocs );
+	Heap_ClearStats( frees );
+
+	Heap_Lock( &cacheLock );
+	for ( threadCache_s *cache = caches; cache; cache = cache->next ) {
+		if ( cache->frameCount == frameCount ) {
+			Heap_AddStats( allocs, cache->frameAllocs );
+			Heap_AddStats( frees, cache->frameFrees );
+		}
+	}
+	Heap_Unlock( &cacheLock );
 }
 
 /*
 ================
-idHeap::ReleaseSwappedPages
+idHeap::GetStats
+================
+*/
+void idHeap::GetStats( memoryStats_t &stats ) {
+	Heap_ClearStats( stats );
 
-  releases the swap page to OS
+	Heap_Lock( &cacheLock );
+	for ( threadCache_s *cache = caches; cache; cache = cache->next ) {
+		Heap_AddStats( stats, cache->totalAllocs );
+	}
+	Heap_Unlock( &cacheLock );
+}
+
+/*
+================
+idHeap::GetTagStats
 ================
 */
-void idHeap::ReleaseSwappedPages () {
-	if ( swapPage ) {
-		FreePageReal( swapPage );
+void idHeap::GetTagStats( int tag, memoryStats_t &stats ) {
+	Heap_ClearStats( stats );
+
+	Heap_Lock( &cacheLock );
+	for ( threadCache_s *cache = caches; cache; cache = cache->next ) {
+		Heap_AddStats( stats, cache->tagAllocs[tag] );
 	}
-	swapPage = NULL;
+	Heap_Unlock( &cacheLock );
 }
 
 /*
 ================
-idHeap::AllocatePage
+idHeap::UpdateAllocStats
+
+  blocks may be freed by another thread than the one that allocated them,
+  so the counts of a single cache can go negative, only the sums are valid
+================
+*/
+void idHeap::UpdateAllocStats( threadCache_s *cache, int size, int tag ) {
+	if ( cache->frameCount != frameCount ) {
+		cache->frameCount = frameCount;
+		Heap_ClearStats( cache->frameAllocs );
+		Heap_ClearStats( cache->frameFrees );
+	}
+	Heap_UpdateStats( cache->frameAllocs, size );
+	Heap_UpdateStats( cache->totalAllocs, size );
+	Heap_UpdateStats( cache->tagAllocs[tag], size );
+}
 
-  allocates memory from the OS
-  bytes	= page size in bytes
-  returns pointer to page
+/*
+================
+idHeap::UpdateFreeStats
 ================
 */
-idHeap::page_s* idHeap::AllocatePage( dword bytes ) {
-	idHeap::page_s*	p;
+void idHeap::UpdateFreeStats( threadCache_s *cache, int size, int tag ) {
+	if ( cache->frameCount != frameCount ) {
+		cache->frameCount = frameCount;
+		Heap_ClearStats( cache->frameAllocs );
+		Heap_ClearStats( cache->frameFrees );
+	}
+	Heap_UpdateStats( cache->frameFrees, size );
+	cache->totalAllocs.num--;
+	cache->totalAllocs.totalSize -= size;
+	cache->tagAllocs[tag].num--;
+	cache->tagAllocs[tag].totalSize -= size;
+}
+
+//===============================================================
+//
+//	thread caches
+//
+//===============================================================
+
+/*
+================
+idHeap::AcquireThreadCache
 
-	pageRequests++;
+  reuses a cache released by a thread that exited or creates a new one
+================
+*/
+idHeap::threadCache_s *idHeap::AcquireThreadCache( void ) {
+	threadCache_s *cache;
 
-	if ( swapPage && swapPage->dataSize == bytes ) {			// if we've got a swap page somewhere
-		p			= swapPage;
-		swapPage	= NULL;
+	Heap_Lock( &cacheLock );
+	for ( cache = caches; cache; cache = cache->next ) {
+		if ( !cache->inUse ) {
+			break;
+		}
 	}
-	else {
-		dword size;
-
-		size = bytes + sizeof(idHeap::page_s);
-
-		p = (idHeap::page_s *) ::malloc( size + ALIGN - 1 );
-		if ( !p ) {
-			if ( defragBlock ) {
-				idLib::common->Printf( "Freeing defragBlock on alloc of %i.\n", size + ALIGN - 1 );
-				free( defragBlock );
-				defragBlock = NULL;
-				p = (idHeap::page_s *) ::malloc( size + ALIGN - 1 );			
-				AllocDefragBlock();
-			}
-			if ( !p ) {
-				common->FatalError( "malloc failure for %i", bytes );
-			}
+	if ( !cache ) {
+		cache = (threadCache_s *) calloc( 1, sizeof( threadCache_s ) );
+		if ( !cache ) {
+			Heap_Unlock( &cacheLock );
+			idLib::common->FatalError( "idHeap: failed to allocate a thread cache" );
 		}
-
-		p->data		= (void *) ALIGN_SIZE( (int)((byte *)(p)) + sizeof( idHeap::page_s ) );
-		p->dataSize	= size - sizeof(idHeap::page_s);
-		p->firstFree = NULL;
-		p->largestFree = 0;
-		OSAllocs++;
+		Heap_ClearStats( cache->totalAllocs );
+		Heap_ClearStats( cache->frameAllocs );
+		Heap_ClearStats( cache->frameFrees );
+		for ( int i = 0; i < MEM_TAG_MAX; i++ ) {
+			Heap_ClearStats( cache->tagAllocs[i] );
+		}
+		cache->frameCount = frameCount;
+		cache->next = caches;
+		caches = cache;
 	}
+	cache->inUse = true;
+	Heap_Unlock( &cacheLock );
 
-	p->prev = NULL;
-	p->next = NULL;
+	heap_threadCache = cache;
+	heap_threadCacheSerial = serial;
+	return cache;
+}
 
-	pagesAllocated++;
-	
-	return p;
+/*
+================
+idHeap::RefillCache
+
+  moves a batch of blocks from the shared bin to the empty free list of the cache
+================
+*/
+void idHeap::RefillCache( threadCache_s *cache, int binNum ) {
+	bin_s &bin = bins[binNum];
+	void *first = NULL;
+	int count = 0;
+
+	Heap_Lock( &bin.lock );
+
+	// blocks returned by other threads first
+	while( count < bin.batch && bin.freeList ) {
+		void *p = bin.freeList;
+		bin.freeList = *(void **)p;
+		*(void **)p = first;
+		first = p;
+		count++;
+	}
+	bin.numFree -= count;
+
+	// carve the rest out of the newest span
+	while( count < bin.batch ) {
+		if ( !bin.carveLeft ) {
+			byte *span = (byte *) Heap_AllocPages( bin.spanSize );
+			if ( !span ) {
+				Heap_Unlock( &bin.lock );
+				idLib::common->FatalError( "idHeap: failed to allocate a %d byte span", bin.spanSize );
+			}
+			*(void **)span = bin.spans;
+			bin.spans = span;
+			bin.numSpans++;
+			// the span link fits in front of the first header, which keeps the blocks 16 byte aligned
+			bin.carve = span + 16 - HEAP_HEADER_SIZE;
+			bin.carveLeft = ( bin.spanSize - 16 + HEAP_HEADER_SIZE ) / bin.stride;
+		}
+		header_s *header = (header_s *) bin.carve;
+		header->size = bin.stride - HEAP_HEADER_SIZE;
+		header->tag = MEM_TAG_MISC;
+		header->bin = binNum;
+		header->profiled = 0;
+		header->type = INVALID_ALLOC;
+		void *p = bin.carve + HEAP_HEADER_SIZE;
+		*(void **)p = first;
+		first = p;
+		count++;
+		bin.carve += bin.stride;
+		bin.carveLeft--;
+	}
+
+	Heap_Unlock( &bin.lock );
+
+	cache->freeList[binNum] = first;
+	cache->numFree[binNum] = count;
 }
 
 /*
 ================
-idHeap::FreePage
+idHeap::FlushCache
 
-  frees a page back to the operating system
-  p	= pointer to page
+  moves count blocks from the free list of the cache to the shared bin
 ================
 */
-void idHeap::FreePage( idHeap::page_s *p ) {
-	assert( p );
+void idHeap::FlushCache( threadCache_s *cache, int binNum, int count ) {
+	bin_s &bin = bins[binNum];
 
-	if ( p->dataSize == pageSize && !swapPage ) {			// add to swap list?
-		swapPage = p;
-	}
-	else {
-		FreePageReal( p );
+	assert( count > 0 && count <= cache->numFree[binNum] );
+
+	void *first = cache->freeList[binNum];
+	void *last = first;
+	for ( int i = 1; i < count; i++ ) {
+		last = *(void **)last;
 	}
+	cache->freeList[binNum] = *(void **)last;
+	cache->numFree[binNum] -= count;
 
-	pagesAllocated--;
+	Heap_Lock( &bin.lock );
+	*(void **)last = bin.freeList;
+	bin.freeList = first;
+	bin.numFree += count;
+	Heap_Unlock( &bin.lock );
 }
 
 //===============================================================
@@ -535,444 +868,824 @@ void idHeap::FreePage( idHeap::page_s *p ) {
 ================
 idHeap::SmallAllocate
 
-  allocate memory (1-255 bytes) from the small heap manager
-  bytes = number of bytes to allocate
-  returns pointer to allocated memory
+  allocate memory (1-32760 bytes) from the free list of the size class
 ================
 */
-void *idHeap::SmallAllocate( dword bytes ) {
-	// we need the at least sizeof( dword ) bytes for the free list
-	if ( bytes < sizeof( dword ) ) {
-		bytes = sizeof( dword );
+void *idHeap::SmallAllocate( threadCache_s *cache, dword bytes ) {
+	int binNum = binForStride[( bytes + HEAP_HEADER_SIZE + 15 ) >> 4];
+
+	if ( !cache->freeList[binNum] ) {
+		RefillCache( cache, binNum );
 	}
 
-	// increase the number of bytes if necessary to make sure the next small allocation is aligned
-	bytes = SMALL_ALIGN( bytes );
+	void *p = cache->freeList[binNum];
+	cache->freeList[binNum] = *(void **)p;
+	cache->numFree[binNum]--;
+
+	HEAP_HEADER( p )->type = SMALL_ALLOC;
+	return p;
+}
+
+/*
+================
+idHeap::SmallFree
+
+  keeps the block in the cache, half of the cached blocks are returned to
+  the shared bin once the cache holds two batches
+================
+*/
+void idHeap::SmallFree( threadCache_s *cache, void *ptr ) {
+	header_s *header = HEAP_HEADER( ptr );
+	int binNum = header->bin;
 
-	byte *smallBlock = (byte *)(smallFirstFree[bytes / ALIGN]);
-	if ( smallBlock ) {
-		dword *link = (dword *)(smallBlock + SMALL_HEADER_SIZE);
-		smallBlock[1] = SMALL_ALLOC;					// allocation identifier
-		smallFirstFree[bytes / ALIGN] = (void *)(*link);
-		return (void *)(link);
+	header->type = INVALID_ALLOC;
+
+	*(void **)ptr = cache->freeList[binNum];
+	cache->freeList[binNum] = ptr;
+	if ( ++cache->numFree[binNum] >= 2 * bins[binNum].batch ) {
+		FlushCache( cache, binNum, bins[binNum].batch );
 	}
+}
+
+//===============================================================
+//
+//	large heap code
+//
+//===============================================================
+
+/*
+================
+idHeap::LargeAllocate
 
-	dword bytesLeft = (long)(pageSize) - smallCurPageOffset;
-	// if we need to allocate a new page
-	if ( bytes >= bytesLeft ) {
+  allocates a block of memory with malloc, the original pointer is
+  stored in front of the header
+================
+*/
+void *idHeap::LargeAllocate( dword bytes ) {
+	const int overhead = HEAP_HEADER_SIZE + sizeof( void * ) + 15;
 
-		smallCurPage->next	= smallFirstUsedPage;
-		smallFirstUsedPage	= smallCurPage;
-		smallCurPage		= AllocatePage( pageSize );
-		if ( !smallCurPage ) {
-			return NULL;
+	byte *ptr = (byte *) malloc( bytes + overhead );
+	if ( !ptr ) {
+		if ( defragBlock ) {
+			idLib::common->Printf( "Freeing defragBlock on alloc of %i.\n", bytes );
+			free( defragBlock );
+			defragBlock = NULL;
+			ptr = (byte *) malloc( bytes + overhead );
+			AllocDefragBlock();
+		}
+		if ( !ptr ) {
+			idLib::common->FatalError( "malloc failure for %i", bytes );
 		}
-		// make sure the first allocation is aligned
-		smallCurPageOffset	= SMALL_ALIGN( 0 );
 	}
 
-	smallBlock			= ((byte *)smallCurPage->data) + smallCurPageOffset;
-	smallBlock[0]		= (byte)(bytes / ALIGN);		// write # of bytes/ALIGN
-	smallBlock[1]		= SMALL_ALLOC;					// allocation identifier
-	smallCurPageOffset  += bytes + SMALL_HEADER_SIZE;	// increase the offset on the current page
-	return ( smallBlock + SMALL_HEADER_SIZE );			// skip the first two bytes
+	byte *d = (byte *) ( ( (size_t) ptr + HEAP_HEADER_SIZE + sizeof( void * ) + 15 ) & ~15 );
+	((void **)( d - HEAP_HEADER_SIZE ))[-1] = ptr;
+
+	header_s *header = HEAP_HEADER( d );
+	header->size = bytes;
+	header->bin = 0;
+	header->profiled = 0;
+	header->type = LARGE_ALLOC;
+	return d;
 }
 
 /*
 ================
-idHeap::SmallFree
+idHeap::LargeFree
 
-  frees a block of memory allocated by SmallAllocate() call
-  data = pointer to block of memory
+  frees a block of memory allocated by the 'large memory allocator'
+  p	= pointer to allocated memory
 ================
 */
-void idHeap::SmallFree( void *ptr ) {
-	((byte *)(ptr))[-1] = INVALID_ALLOC;
+void idHeap::LargeFree( void *ptr ) {
+	HEAP_HEADER( ptr )->type = INVALID_ALLOC;
+	free( ((void **)( (byte *) ptr - HEAP_HEADER_SIZE ))[-1] );
+}
+
+//===============================================================
+//
+//	huge heap code
+//
+//===============================================================
 
-	byte *d = ( (byte *)ptr ) - SMALL_HEADER_SIZE;
-	dword *dt = (dword *)ptr;
-	// index into the table with free small memory blocks
-	dword ix = *d;
+/*
+================
+idHeap::HugeAllocate
+
+  maps pages from the OS, the block starts 16 bytes into the first page
+================
+*/
+void *idHeap::HugeAllocate( dword bytes ) {
+	size_t mapSize = ( bytes + 16 + HEAP_PAGE_SIZE - 1 ) & ~( HEAP_PAGE_SIZE - 1 );
 
-	// check if the index is correct
-	if ( ix > (256 / ALIGN) ) {
-		idLib::common->FatalError( "SmallFree: invalid memory block" );
+	byte *ptr = (byte *) Heap_AllocPages( mapSize );
+	if ( !ptr ) {
+		if ( defragBlock ) {
+			idLib::common->Printf( "Freeing defragBlock on alloc of %i.\n", bytes );
+			free( defragBlock );
+			defragBlock = NULL;
+			ptr = (byte *) Heap_AllocPages( mapSize );
+			AllocDefragBlock();
+		}
+		if ( !ptr ) {
+			idLib::common->FatalError( "failed to map %i bytes", bytes );
+		}
 	}
 
-	*dt = (dword)smallFirstFree[ix];	// write next index
-	smallFirstFree[ix] = (void *)d;		// link
+	byte *d = ptr + 16;
+	header_s *header = HEAP_HEADER( d );
+	header->size = mapSize - 16;
+	header->bin = 0;
+	header->profiled = 0;
+	header->type = HUGE_ALLOC;
+	return d;
+}
+
+/*
+================
+idHeap::HugeFree
+
+  unmaps the pages of a block allocated by the 'huge memory allocator'
+  p	= pointer to allocated memory
+================
+*/
+void idHeap::HugeFree( void *ptr ) {
+	header_s *header = HEAP_HEADER( ptr );
+	size_t mapSize = header->size + 16;
+	header->type = INVALID_ALLOC;
+	Heap_FreePages( (byte *) ptr - 16, mapSize );
 }
 
 //===============================================================
 //
-//	medium heap code
+//	allocation profiler
 //
-//	Medium-heap allocated pages not returned to OS until heap destructor
-//	called (re-used instead on subsequent medium-size malloc requests).
+//	Every Nth allocation, with some jitter, records the call stack and the
+//	memory tag of the allocation site. The statistics of a site are scaled
+//	by the sample rate when reported. Sampled blocks are tracked until
+//	they are freed, so the live memory per site is known as well.
+//
+//	Only allocations from the heap of the module that runs the console
+//	command are profiled, which is the engine heap.
 //
 //===============================================================
 
+#define MEM_PROFILE_STACK_SKIP		3				// Mem_ProfileSample, idHeap::Allocate and Mem_Alloc
+#define MEM_PROFILE_STACK_DEPTH		10
+#define MEM_PROFILE_MAX_SITES		8192
+#define MEM_PROFILE_MAX_BLOCKS		65536
+#define MEM_PROFILE_DEFAULT_RATE	64
+#define MEM_PROFILE_IDENT			( ( 'P' << 24 ) | ( 'M' << 16 ) | ( 'E' << 8 ) | 'M' )
+#define MEM_PROFILE_VERSION			1
+
+typedef struct {
+	address_t				callStack[MEM_PROFILE_STACK_DEPTH];
+	int						tag;					// -1 if the site is unused
+	int						totalCount;				// samples since the profiler was started
+	int						totalBytes;
+	int						frameCount;				// samples of the current frame
+	int						frameBytes;
+	int						lastFrameCount;			// samples of the last complete frame
+	int						lastFrameBytes;
+	int						liveCount;				// sampled blocks that are not freed yet
+	int						liveBytes;
+} memProfileSite_t;
+
+typedef struct {
+	void *					ptr;					// NULL if the entry is unused
+	int						site;
+	int						size;
+} memProfileBlock_t;
+
+typedef enum {
+	MEM_PROFILE_FRAME,
+	MEM_PROFILE_TOTAL,
+	MEM_PROFILE_LIVE
+} memProfileColumn_t;
+
+typedef struct {
+	idStr					callStack;
+	int						tag;
+	int						count;					// scaled by the sample rate
+	float					bytes;
+} memProfileEntry_t;
+
+static volatile long		mem_profileLock = 0;
+static int					mem_profileFrames = 0;
+static int					mem_profileNumSites = 0;
+static int					mem_profileNumBlocks = 0;
+static int					mem_profileDropped = 0;	// samples that did not fit in the tables
+static memProfileSite_t *	mem_profileSites = NULL;
+static memProfileBlock_t *	mem_profileBlocks = NULL;
+static ID_TLS dword			mem_profileRandom = 0;
+
 /*
-================
-idHeap::MediumAllocateFromPage
+==================
+Mem_ProfileBlockHash
+==================
+*/
+static ID_INLINE int Mem_ProfileBlockHash( const void *p ) {
+	return ( (dword)( (size_t) p >> 4 ) * 2654435761u ) & ( MEM_PROFILE_MAX_BLOCKS - 1 );
+}
 
-  performs allocation using the medium heap manager from a given page
-  p				= page
-  sizeNeeded	= # of bytes needed
-  returns pointer to allocated memory
-================
+/*
+==================
+Mem_ProfileSample
+
+  called by idHeap::Allocate for every Nth allocation, returns 1 if the block is tracked
+==================
 */
-void *idHeap::MediumAllocateFromPage( idHeap::page_s *p, dword sizeNeeded ) {
+static byte Mem_ProfileSample( void *p, int size, int tag ) {
+	address_t callStack[MEM_PROFILE_STACK_SKIP + MEM_PROFILE_STACK_DEPTH];
+	const address_t *siteStack = callStack + MEM_PROFILE_STACK_SKIP;
+
+	// randomize the distance to the next sample to avoid aliasing with allocation patterns
+	int rate = mem_profileRate;
+	if ( rate <= 0 ) {
+		return 0;
+	}
+	mem_profileRandom = mem_profileRandom * 1664525 + 1013904223;
+	mem_profileCountdown = rate / 2 + ( mem_profileRandom >> 8 ) % rate + 1;
 
-	mediumHeapEntry_s	*best,*nw = NULL;
-	byte				*ret;
+	idLib::sys->GetCallStack( callStack, MEM_PROFILE_STACK_SKIP + MEM_PROFILE_STACK_DEPTH );
 
-	best = (mediumHeapEntry_s *)(p->firstFree);			// first block is largest
+	dword hash = tag;
+	for ( int i = 0; i < MEM_PROFILE_STACK_DEPTH; i++ ) {
+		hash = hash * 31 + (dword) siteStack[i];
+	}
 
-	assert( best );
-	assert( best->size == p->largestFree );
-	assert( best->size >= sizeNeeded );
+	Heap_Lock( &mem_profileLock );
 
-	// if we can allocate another block from this page after allocating sizeNeeded bytes
-	if ( best->size >= (dword)( sizeNeeded + MEDIUM_SMALLEST_SIZE ) ) {
-		nw = (mediumHeapEntry_s *)((byte *)best + best->size - sizeNeeded);
-		nw->page		= p;
-		nw->prev		= best;
-		nw->next		= best->next;
-		nw->prevFree	= NULL;
-		nw->nextFree	= NULL;
-		nw->size		= sizeNeeded;
-		nw->freeBlock	= 0;			// used block
-		if ( best->next ) {
-			best->next->prev = nw;
-		}
-		best->next	= nw;
-		best->size	-= sizeNeeded;
-		
-		p->largestFree = best->size;
+	if ( !mem_profileSites ) {
+		Heap_Unlock( &mem_profileLock );
+		return 0;
 	}
-	else {
-		if ( best->prevFree ) {
-			best->prevFree->nextFree = best->nextFree;
-		}
-		else {
-			p->firstFree = (void *)best->nextFree;
+
+	// find or add the allocation site
+	int s = hash & ( MEM_PROFILE_MAX_SITES - 1 );
+	memProfileSite_t *site;
+	while( 1 ) {
+		site = &mem_profileSites[s];
+		if ( site->tag == -1 ) {
+			if ( mem_profileNumSites >= MEM_PROFILE_MAX_SITES * 3 / 4 ) {
+				mem_profileDropped++;
+				Heap_Unlock( &mem_profileLock );
+				return 0;
+			}
+			memset( site, 0, sizeof( *site ) );
+			memcpy( site->callStack, siteStack, sizeof( site->callStack ) );
+			site->tag = tag;
+			mem_profileNumSites++;
+			break;
 		}
-		if ( best->nextFree ) {
-			best->nextFree->prevFree = best->prevFree;
+		if ( site->tag == tag && memcmp( site->callStack, siteStack, sizeof( site->callStack ) ) == 0 ) {
+			break;
 		}
+		s = ( s + 1 ) & ( MEM_PROFILE_MAX_SITES - 1 );
+	}
 
-		best->prevFree  = NULL;
-		best->nextFree  = NULL;
-		best->freeBlock = 0;			// used block
-		nw = best;
+	site->totalCount++;
+	site->totalBytes += size;
+	site->frameCount++;
+	site->frameBytes += size;
 
-		p->largestFree = 0;
+	// track the block so the free can be accounted to the site
+	if ( mem_profileNumBlocks >= MEM_PROFILE_MAX_BLOCKS * 3 / 4 ) {
+		mem_profileDropped++;
+		Heap_Unlock( &mem_profileLock );
+		return 0;
+	}
+	int b = Mem_ProfileBlockHash( p );
+	while( mem_profileBlocks[b].ptr ) {
+		b = ( b + 1 ) & ( MEM_PROFILE_MAX_BLOCKS - 1 );
 	}
+	mem_profileBlocks[b].ptr = p;
+	mem_profileBlocks[b].site = s;
+	mem_profileBlocks[b].size = size;
+	mem_profileNumBlocks++;
 
-	ret		= (byte *)(nw) + ALIGN_SIZE( MEDIUM_HEADER_SIZE );
-	ret[-1] = MEDIUM_ALLOC;		// allocation identifier
+	site->liveCount++;
+	site->liveBytes += size;
 
-	return (void *)(ret);
+	Heap_Unlock( &mem_profileLock );
+	return 1;
 }
 
 /*
-================
-idHeap::MediumAllocate
+==================
+Mem_ProfileFree
 
-  allocate memory (256-32768 bytes) from medium heap manager
-  bytes	= number of bytes to allocate
-  returns pointer to allocated memory
-================
+  called by idHeap::Free for tracked blocks
+==================
 */
-void *idHeap::MediumAllocate( dword bytes ) {
-	idHeap::page_s		*p;
-	void				*data;
+static void Mem_ProfileFree( void *p ) {
+	Heap_Lock( &mem_profileLock );
 
-	dword sizeNeeded = ALIGN_SIZE( bytes ) + ALIGN_SIZE( MEDIUM_HEADER_SIZE );
-
-	// find first page with enough space
-	for ( p = mediumFirstFreePage; p; p = p->next ) {
-		if ( p->largestFree >= sizeNeeded ) {
-			break;
+	// blocks sampled before the profiler was restarted are not found
+	if ( !mem_profileBlocks ) {
+		Heap_Unlock( &mem_profileLock );
+		return;
+	}
+	int i = Mem_ProfileBlockHash( p );
+	while( mem_profileBlocks[i].ptr != p ) {
+		if ( !mem_profileBlocks[i].ptr ) {
+			Heap_Unlock( &mem_profileLock );
+			return;
 		}
+		i = ( i + 1 ) & ( MEM_PROFILE_MAX_BLOCKS - 1 );
 	}
 
-	if ( !p ) {								// need to allocate new page?
-		p = AllocatePage( pageSize );
-		if ( !p ) {
-			return NULL;					// malloc failure!
-		}
-		p->prev		= NULL;
-		p->next		= mediumFirstFreePage;
-		if (p->next) {
-			p->next->prev = p;
-		}
-		else {
-			mediumLastFreePage	= p;
-		}
+	memProfileSite_t *site = &mem_profileSites[mem_profileBlocks[i].site];
+	site->liveCount--;
+	site->liveBytes -= mem_profileBlocks[i].size;
 
-		mediumFirstFreePage		= p;
-		
-		p->largestFree	= pageSize;
-		p->firstFree	= (void *)p->data;
-
-		mediumHeapEntry_s *e;
-		e				= (mediumHeapEntry_s *)(p->firstFree);
-		e->page			= p;
-		// make sure ((byte *)e + e->size) is aligned
-		e->size			= pageSize & ~(ALIGN - 1);
-		e->prev			= NULL;
-		e->next			= NULL;
-		e->prevFree		= NULL;
-		e->nextFree		= NULL;
-		e->freeBlock	= 1;
-	}
-
-	data = MediumAllocateFromPage( p, sizeNeeded );		// allocate data from page
-
-    // if the page can no longer serve memory, move it away from free list
-	// (so that it won't slow down the later alloc queries)
-	// this modification speeds up the pageWalk from O(N) to O(sqrt(N))
-	// a call to free may swap this page back to the free list
-
-	if ( p->largestFree < MEDIUM_SMALLEST_SIZE ) {
-		if ( p == mediumLastFreePage ) {
-			mediumLastFreePage = p->prev;
+	// shift back the following entries of the probe sequence
+	for ( int j = ( i + 1 ) & ( MEM_PROFILE_MAX_BLOCKS - 1 ); mem_profileBlocks[j].ptr; j = ( j + 1 ) & ( MEM_PROFILE_MAX_BLOCKS - 1 ) ) {
+		int k = Mem_ProfileBlockHash( mem_profileBlocks[j].ptr );
+		if ( ( i <= j ) ? ( i < k && k <= j ) : ( i < k || k <= j ) ) {
+			continue;
 		}
+		mem_profileBlocks[i] = mem_profileBlocks[j];
+		i = j;
+	}
+	mem_profileBlocks[i].ptr = NULL;
+	mem_profileNumBlocks--;
 
-		if ( p == mediumFirstFreePage ) {
-			mediumFirstFreePage = p->next;
-		}
+	Heap_Unlock( &mem_profileLock );
+}
 
-		if ( p->prev ) {
-			p->prev->next = p->next;
-		}
-		if ( p->next ) {
-			p->next->prev = p->prev;
-		}
+/*
+==================
+Mem_ProfileStart
+==================
+*/
+void Mem_ProfileStart( int sampleRate ) {
+	Mem_ProfileStop();
+
+	// the tables are allocated with malloc so the profiler never runs into itself
+	memProfileSite_t *sites = (memProfileSite_t *) malloc( MEM_PROFILE_MAX_SITES * sizeof( memProfileSite_t ) );
+	memProfileBlock_t *blocks = (memProfileBlock_t *) calloc( MEM_PROFILE_MAX_BLOCKS, sizeof( memProfileBlock_t ) );
+	if ( !sites || !blocks ) {
+		free( sites );
+		free( blocks );
+		idLib::common->Warning( "Mem_ProfileStart: failed to allocate the profile tables" );
+		return;
+	}
+	for ( int i = 0; i < MEM_PROFILE_MAX_SITES; i++ ) {
+		sites[i].tag = -1;
+	}
 
-		// link to "completely used" list
-		p->prev = NULL;
-		p->next = mediumFirstUsedPage;
-		if ( p->next ) {
-			p->next->prev = p;
-		}
-		mediumFirstUsedPage = p;
-		return data;
-	} 
+	Heap_Lock( &mem_profileLock );
+	mem_profileSites = sites;
+	mem_profileBlocks = blocks;
+	mem_profileFrames = 0;
+	mem_profileNumSites = 0;
+	mem_profileNumBlocks = 0;
+	mem_profileDropped = 0;
+	mem_profileRate = Max( sampleRate, 1 );
+	Heap_Unlock( &mem_profileLock );
+}
 
-	// re-order linked list (so that next malloc query starts from current
-	// matching block) -- this speeds up both the page walks and block walks
+/*
+==================
+Mem_ProfileStop
+==================
+*/
+void Mem_ProfileStop( void ) {
+	Heap_Lock( &mem_profileLock );
+	memProfileSite_t *sites = mem_profileSites;
+	memProfileBlock_t *blocks = mem_profileBlocks;
+	mem_profileRate = 0;
+	mem_profileSites = NULL;
+	mem_profileBlocks = NULL;
+	Heap_Unlock( &mem_profileLock );
+
+	free( sites );
+	free( blocks );
+}
 
-	if ( p != mediumFirstFreePage ) {
-		assert( mediumLastFreePage );
-		assert( mediumFirstFreePage );
-		assert( p->prev);
+/*
+==================
+Mem_ProfileFrame
 
-		mediumLastFreePage->next	= mediumFirstFreePage;
-		mediumFirstFreePage->prev	= mediumLastFreePage;
-		mediumLastFreePage			= p->prev;
-		p->prev->next				= NULL;
-		p->prev						= NULL;
-		mediumFirstFreePage			= p;
+  called once at the end of every frame
+==================
+*/
+void Mem_ProfileFrame( void ) {
+	if ( !mem_profileRate ) {
+		return;
 	}
 
-	return data;
+	Heap_Lock( &mem_profileLock );
+	if ( mem_profileSites ) {
+		for ( int i = 0; i < MEM_PROFILE_MAX_SITES; i++ ) {
+			memProfileSite_t *site = &mem_profileSites[i];
+			if ( site->tag != -1 ) {
+				site->lastFrameCount = site->frameCount;
+				site->lastFrameBytes = site->frameBytes;
+				site->frameCount = 0;
+				site->frameBytes = 0;
+			}
+		}
+		mem_profileFrames++;
+	}
+	Heap_Unlock( &mem_profileLock );
 }
 
 /*
-================
-idHeap::MediumFree
-
-  frees a block allocated by the medium heap manager
-  ptr	= pointer to data block
-================
+==================
+Mem_ProfileCallStackStr
+==================
 */
-void idHeap::MediumFree( void *ptr ) {
-	((byte *)(ptr))[-1] = INVALID_ALLOC;
+static void Mem_ProfileCallStackStr( const address_t *callStack, idStr &str ) {
+	int depth;
 
-	mediumHeapEntry_s	*e = (mediumHeapEntry_s *)((byte *)ptr - ALIGN_SIZE( MEDIUM_HEADER_SIZE ));
-	idHeap::page_s		*p = e->page;
-	bool				isInFreeList;
+	for ( depth = 0; depth < MEM_PROFILE_STACK_DEPTH; depth++ ) {
+		if ( !callStack[depth] ) {
+			break;
+		}
+	}
+	str = idLib::sys->GetCallStackStr( callStack, depth );
+	if ( str.Length() ) {
+		return;
+	}
+
+	// no symbols, use the return addresses, outermost call first like the symbol version
+	for ( int i = depth - 1; i >= 0; i-- ) {
+		str += va( " -> 0x%08x", (dword) callStack[i] );
+	}
+}
 
-	isInFreeList = p->largestFree >= MEDIUM_SMALLEST_SIZE;
+/*
+==================
+Mem_ProfileCopySites
 
-	assert( e->size );
-	assert( e->freeBlock == 0 );
+  copies the sites in use under the lock, returns NULL if the profiler isn't running,
+  the copy is freed by the caller
+==================
+*/
+static memProfileSite_t *Mem_ProfileCopySites( int &numSites, int &rate, int &numFrames ) {
+	memProfileSite_t *sites = (memProfileSite_t *) malloc( MEM_PROFILE_MAX_SITES * sizeof( memProfileSite_t ) );
 
-	mediumHeapEntry_s *prev = e->prev;
+	numSites = 0;
+	if ( !sites ) {
+		return NULL;
+	}
 
-	// if the previous block is free we can merge
-	if ( prev && prev->freeBlock ) {
-		prev->size += e->size;
-		prev->next = e->next;
-		if ( e->next ) {
-			e->next->prev = prev;
+	Heap_Lock( &mem_profileLock );
+	rate = mem_profileRate;
+	numFrames = mem_profileFrames;
+	if ( mem_profileSites ) {
+		for ( int i = 0; i < MEM_PROFILE_MAX_SITES; i++ ) {
+			if ( mem_profileSites[i].tag != -1 ) {
+				sites[numSites++] = mem_profileSites[i];
+			}
 		}
-		e = prev;
 	}
-	else {
-		e->prevFree		= NULL;				// link to beginning of free list
-		e->nextFree		= (mediumHeapEntry_s *)p->firstFree;
-		if ( e->nextFree ) {
-			assert( !(e->nextFree->prevFree) );
-			e->nextFree->prevFree = e;
-		}
+	Heap_Unlock( &mem_profileLock );
 
-		p->firstFree	= e;
-		p->largestFree	= e->size;
-		e->freeBlock	= 1;				// mark block as free
+	if ( !rate ) {
+		free( sites );
+		return NULL;
 	}
-			
-	mediumHeapEntry_s *next = e->next;
+	return sites;
+}
 
-	// if the next block is free we can merge
-	if ( next && next->freeBlock ) {
-		e->size += next->size;
-		e->next = next->next;
-		
-		if ( next->next ) {
-			next->next->prev = e;
-		}
-		
-		if ( next->prevFree ) {
-			next->prevFree->nextFree = next->nextFree;
-		}
-		else {
-			assert( next == p->firstFree );
-			p->firstFree = next->nextFree;
-		}
+/*
+==================
+Mem_ProfileSiteColumn
 
-		if ( next->nextFree ) {
-			next->nextFree->prevFree = next->prevFree;
-		}
+  the statistics of a site scaled by the sample rate
+==================
+*/
+static void Mem_ProfileSiteColumn( const memProfileSite_t &site, memProfileColumn_t column, int rate, int &count, float &bytes ) {
+	switch( column ) {
+		case MEM_PROFILE_FRAME:
+			count = site.lastFrameCount * rate;
+			bytes = (float) site.lastFrameBytes * rate;
+			break;
+		case MEM_PROFILE_TOTAL:
+			count = site.totalCount * rate;
+			bytes = (float) site.totalBytes * rate;
+			break;
+		case MEM_PROFILE_LIVE:
+			count = site.liveCount * rate;
+			bytes = (float) site.liveBytes * rate;
+			break;
 	}
+}
 
-	if ( p->firstFree ) {
-		p->largestFree = ((mediumHeapEntry_s *)(p->firstFree))->size;
+/*
+==================
+Mem_ProfileSnapshot
+
+  copies the statistics of all sites, scaled by the sample rate
+==================
+*/
+static bool Mem_ProfileSnapshot( memProfileColumn_t column, idList<memProfileEntry_t> &entries, int &numFrames ) {
+	int numSites, rate;
+
+	entries.Clear();
+
+	memProfileSite_t *sites = Mem_ProfileCopySites( numSites, rate, numFrames );
+	if ( !sites ) {
+		return false;
 	}
-	else {
-		p->largestFree = 0;
+
+	entries.SetNum( numSites );
+	for ( int i = 0; i < numSites; i++ ) {
+		memProfileEntry_t &entry = entries[i];
+		Mem_ProfileCallStackStr( sites[i].callStack, entry.callStack );
+		entry.tag = sites[i].tag;
+		Mem_ProfileSiteColumn( sites[i], column, rate, entry.count, entry.bytes );
 	}
 
-	// did e become the largest block of the page ?
+	free( sites );
+	return true;
+}
 
-	if ( e->size > p->largestFree ) {
-		assert( e != p->firstFree );
-		p->largestFree = e->size;
+/*
+==================
+Mem_ProfileSortByBytes
+==================
+*/
+static int Mem_ProfileSortByBytes( memProfileEntry_t * const *a, memProfileEntry_t * const *b ) {
+	float d = fabs( (*b)->bytes ) - fabs( (*a)->bytes );
+	return ( d > 0.0f ) ? 1 : ( ( d < 0.0f ) ? -1 : 0 );
+}
 
-		if ( e->prevFree ) {
-			e->prevFree->nextFree = e->nextFree;
-		}
-		if ( e->nextFree ) {
-			e->nextFree->prevFree = e->prevFree;
-		}
-		
-		e->nextFree = (mediumHeapEntry_s *)p->firstFree;
-		e->prevFree = NULL;
-		if ( e->nextFree ) {
-			e->nextFree->prevFree = e;
-		}
-		p->firstFree = e;
-	}
+/*
+==================
+Mem_ProfileSortByCount
+==================
+*/
+static int Mem_ProfileSortByCount( memProfileEntry_t * const *a, memProfileEntry_t * const *b ) {
+	return abs( (*b)->count ) - abs( (*a)->count );
+}
 
-	// if page wasn't in free list (because it was near-full), move it back there
-	if ( !isInFreeList ) {
+/*
+==================
+Mem_ProfilePrint
 
-		// remove from "completely used" list
-		if ( p->prev ) {
-			p->prev->next = p->next;
-		}
-		if ( p->next ) {
-			p->next->prev = p->prev;
-		}
-		if ( p == mediumFirstUsedPage ) {
-			mediumFirstUsedPage = p->next;
-		}
+  the entries are sorted through pointers because qsort can't move an idStr
+==================
+*/
+static void Mem_ProfilePrint( idList<memProfileEntry_t> &entries, int num, idList<memProfileEntry_t *>::cmp_t *compare ) {
+	idList<memProfileEntry_t *> sorted;
 
-		p->next = NULL;
-		p->prev = mediumLastFreePage;
+	sorted.SetNum( entries.Num() );
+	for ( int i = 0; i < entries.Num(); i++ ) {
+		sorted[i] = &entries[i];
+	}
+	sorted.Sort( compare );
 
-		if ( mediumLastFreePage ) {
-			mediumLastFreePage->next = p;
-		}
-		mediumLastFreePage = p;
-		if ( !mediumFirstFreePage ) {
-			mediumFirstFreePage = p;
-		}
-	} 
+	for ( int i = 0; i < sorted.Num() && i < num; i++ ) {
+		const memProfileEntry_t *entry = sorted[i];
+		idLib::common->Printf( "%10.1f %8d %-10s%s\n", entry->bytes / 1024.0f, entry->count, Mem_GetTagName( (memTag_t)entry->tag ), entry->callStack.c_str() );
+	}
 }
 
-//===============================================================
-//
-//	large heap code
-//
-//===============================================================
+/*
+==================
+Mem_ProfileTop
+==================
+*/
+static void Mem_ProfileTop( memProfileColumn_t column, int num ) {
+	static const char *columnNames[] = { "last frame", "total", "live" };
+	idList<memProfileEntry_t> entries;
+	int numFrames;
+
+	if ( !Mem_ProfileSnapshot( column, entries, numFrames ) ) {
+		idLib::common->Printf( "the allocation profiler is not running\n" );
+		return;
+	}
+
+	idLib::common->Printf( "sample rate 1/%d, %d frames, %d sites, %d dropped samples\n", mem_profileRate, numFrames, entries.Num(), mem_profileDropped );
+
+	idLib::common->Printf( "\ntop %d allocation sites by bytes (%s):\n", num, columnNames[column] );
+	idLib::common->Printf( "        kB    count tag       call stack\n" );
+	Mem_ProfilePrint( entries, num, Mem_ProfileSortByBytes );
+
+	idLib::common->Printf( "\ntop %d allocation sites by count (%s):\n", num, columnNames[column] );
+	idLib::common->Printf( "        kB    count tag       call stack\n" );
+	Mem_ProfilePrint( entries, num, Mem_ProfileSortByCount );
+}
 
 /*
-================
-idHeap::LargeAllocate
+==================
+Mem_ProfileWrite
 
-  allocates a block of memory from the operating system
-  bytes	= number of bytes to allocate
-  returns pointer to allocated memory
-================
+  the call stacks are stored as symbol names when available, so dumps of
+  different builds can be compared with Mem_ProfileDiff
+==================
 */
-void *idHeap::LargeAllocate( dword bytes ) {
-	idHeap::page_s *p = AllocatePage( bytes + ALIGN_SIZE( LARGE_HEADER_SIZE ) );
+static void Mem_ProfileWrite( const char *fileName ) {
+	int numSites, rate, numFrames;
+	idStr callStack;
+
+	// all columns come from the same copy so the rows stay consistent
+	memProfileSite_t *sites = Mem_ProfileCopySites( numSites, rate, numFrames );
+	if ( !sites ) {
+		idLib::common->Printf( "the allocation profiler is not running\n" );
+		return;
+	}
 
-	assert( p );
+	idFile *f = idLib::fileSystem->OpenFileWrite( fileName );
+	if ( !f ) {
+		idLib::common->Warning( "couldn't open %s", fileName );
+		free( sites );
+		return;
+	}
 
-	if ( !p ) {
-		return NULL;
+	f->WriteInt( MEM_PROFILE_IDENT );
+	f->WriteInt( MEM_PROFILE_VERSION );
+	f->WriteInt( numFrames );
+	f->WriteInt( numSites );
+	for ( int i = 0; i < numSites; i++ ) {
+		Mem_ProfileCallStackStr( sites[i].callStack, callStack );
+		f->WriteInt( sites[i].tag );
+		f->WriteString( callStack );
+		for ( int j = 0; j < 3; j++ ) {
+			int count;
+			float bytes;
+			Mem_ProfileSiteColumn( sites[i], (memProfileColumn_t)j, rate, count, bytes );
+			f->WriteInt( count );
+			f->WriteFloat( bytes );
+		}
 	}
+	idLib::fileSystem->CloseFile( f );
 
-	byte *	d	= (byte*)(p->data) + ALIGN_SIZE( LARGE_HEADER_SIZE );
-	dword *	dw	= (dword*)(d - ALIGN_SIZE( LARGE_HEADER_SIZE ));
-	dw[0]		= (dword)p;				// write pointer back to page table
-	d[-1]		= LARGE_ALLOC;			// allocation identifier
+	free( sites );
 
-	// link to 'large used page list'
-	p->prev = NULL;
-	p->next = largeFirstUsedPage;
-	if ( p->next ) {
-		p->next->prev = p;
-	}
-	largeFirstUsedPage = p;
+	idLib::common->Printf( "wrote %d allocation sites to %s\n", numSites, fileName );
+}
+
+/*
+==================
+Mem_ProfileRead
+==================
+*/
+static bool Mem_ProfileRead( const char *fileName, memProfileColumn_t column, idList<memProfileEntry_t> &entries, int &numFrames ) {
+	int ident, version, numSites;
 
-	return (void *)(d);
+	entries.Clear();
+
+	idFile *f = idLib::fileSystem->OpenFileRead( fileName );
+	if ( !f ) {
+		idLib::common->Warning( "couldn't open %s", fileName );
+		return false;
+	}
+
+	f->ReadInt( ident );
+	f->ReadInt( version );
+	if ( ident != MEM_PROFILE_IDENT || version != MEM_PROFILE_VERSION ) {
+		idLib::common->Warning( "%s is not a version %d allocation profile", fileName, MEM_PROFILE_VERSION );
+		idLib::fileSystem->CloseFile( f );
+		return false;
+	}
+	f->ReadInt( numFrames );
+	f->ReadInt( numSites );
+
+	// a site is at least its tag, the string length and the three columns
+	const int minSiteSize = 2 * sizeof( int ) + 3 * ( sizeof( int ) + sizeof( float ) );
+	if ( numSites < 0 || numSites > ( f->Length() - f->Tell() ) / minSiteSize ) {
+		idLib::common->Warning( "%s is truncated", fileName );
+		idLib::fileSystem->CloseFile( f );
+		return false;
+	}
+
+	entries.SetNum( numSites );
+	for ( int i = 0; i < numSites; i++ ) {
+		memProfileEntry_t &entry = entries[i];
+		f->ReadInt( entry.tag );
+		f->ReadString( entry.callStack );
+		for ( int j = 0; j < 3; j++ ) {
+			int count;
+			float bytes;
+			f->ReadInt( count );
+			f->ReadFloat( bytes );
+			if ( j == column ) {
+				entry.count = count;
+				entry.bytes = bytes;
+			}
+		}
+	}
+	idLib::fileSystem->CloseFile( f );
+	return true;
 }
 
 /*
-================
-idHeap::LargeFree
+==================
+Mem_ProfileDiff
 
-  frees a block of memory allocated by the 'large memory allocator'
-  p	= pointer to allocated memory
-================
+  lists the allocation sites with the largest change between two dumps
+==================
 */
-void idHeap::LargeFree( void *ptr) {
-	idHeap::page_s*	pg;
+static void Mem_ProfileDiff( const char *oldFileName, const char *newFileName, memProfileColumn_t column, int num ) {
+	idList<memProfileEntry_t> oldEntries, newEntries, diff;
+	idHashIndex hash;
+	int oldFrames, newFrames;
 
-	((byte *)(ptr))[-1] = INVALID_ALLOC;
+	if ( !Mem_ProfileRead( oldFileName, column, oldEntries, oldFrames ) || !Mem_ProfileRead( newFileName, column, newEntries, newFrames ) ) {
+		return;
+	}
+
+	// sites are matched by tag and call stack
+	for ( int i = 0; i < oldEntries.Num(); i++ ) {
+		hash.Add( idStr::Hash( oldEntries[i].callStack ) + oldEntries[i].tag, i );
+	}
 
-	// get page pointer
-	pg = (idHeap::page_s *)(*((dword *)(((byte *)ptr) - ALIGN_SIZE( LARGE_HEADER_SIZE ))));
+	idList<bool> matched;
+	matched.AssureSize( oldEntries.Num(), false );
 
-	// unlink from doubly linked list
-	if ( pg->prev ) {
-		pg->prev->next = pg->next;
+	float oldBytes = 0.0f, newBytes = 0.0f;
+	for ( int i = 0; i < newEntries.Num(); i++ ) {
+		memProfileEntry_t entry = newEntries[i];
+		newBytes += entry.bytes;
+		int key = idStr::Hash( entry.callStack ) + entry.tag;
+		for ( int j = hash.First( key ); j != -1; j = hash.Next( j ) ) {
+			if ( oldEntries[j].tag == entry.tag && oldEntries[j].callStack == entry.callStack ) {
+				entry.count -= oldEntries[j].count;
+				entry.bytes -= oldEntries[j].bytes;
+				matched[j] = true;
+				break;
+			}
+		}
+		diff.Append( entry );
+	}
+	for ( int i = 0; i < oldEntries.Num(); i++ ) {
+		oldBytes += oldEntries[i].bytes;
+		if ( !matched[i] ) {
+			memProfileEntry_t entry = oldEntries[i];
+			entry.count = -entry.count;
+			entry.bytes = -entry.bytes;
+			diff.Append( entry );
+		}
 	}
-	if ( pg->next ) {
-		pg->next->prev = pg->prev;
+
+	idLib::common->Printf( "%s: %d sites, %d frames, %.1f kB\n", oldFileName, oldEntries.Num(), oldFrames, oldBytes / 1024.0f );
+	idLib::common->Printf( "%s: %d sites, %d frames, %.1f kB\n", newFileName, newEntries.Num(), newFrames, newBytes / 1024.0f );
+
+	idLib::common->Printf( "\ntop %d changes by bytes:\n", num );
+	idLib::common->Printf( "     kB +-  count +- tag       call stack\n" );
+	Mem_ProfilePrint( diff, num, Mem_ProfileSortByBytes );
+
+	idLib::common->Printf( "\ntop %d changes by count:\n", num );
+	idLib::common->Printf( "     kB +-  count +- tag       call stack\n" );
+	Mem_ProfilePrint( diff, num, Mem_ProfileSortByCount );
+}
+
+/*
+==================
+Mem_ProfileParseColumn
+==================
+*/
+static memProfileColumn_t Mem_ProfileParseColumn( const char *name ) {
+	if ( !idStr::Icmp( name, "total" ) ) {
+		return MEM_PROFILE_TOTAL;
 	}
-	if ( pg == largeFirstUsedPage ) {
-		largeFirstUsedPage = pg->next;
+	if ( !idStr::Icmp( name, "live" ) ) {
+		return MEM_PROFILE_LIVE;
 	}
-	pg->next = pg->prev = NULL;
+	return MEM_PROFILE_FRAME;
+}
 
-	FreePage(pg);
+/*
+==================
+Mem_Profile_f
+==================
+*/
+void Mem_Profile_f( const idCmdArgs &args ) {
+	const char *cmd = args.Argv( 1 );
+
+	if ( !idStr::Icmp( cmd, "start" ) ) {
+		int rate = ( args.Argc() > 2 ) ? atoi( args.Argv( 2 ) ) : MEM_PROFILE_DEFAULT_RATE;
+		Mem_ProfileStart( rate );
+		idLib::common->Printf( "sampling one of every %d allocations\n", Max( rate, 1 ) );
+	} else if ( !idStr::Icmp( cmd, "stop" ) ) {
+		Mem_ProfileStop();
+	} else if ( !idStr::Icmp( cmd, "top" ) ) {
+		int num = ( args.Argc() > 3 ) ? atoi( args.Argv( 3 ) ) : 20;
+		Mem_ProfileTop( Mem_ProfileParseColumn( args.Argv( 2 ) ), num );
+	} else if ( !idStr::Icmp( cmd, "write" ) && args.Argc() > 2 ) {
+		idStr fileName = args.Argv( 2 );
+		fileName.DefaultFileExtension( ".mprof" );
+		Mem_ProfileWrite( fileName );
+	} else if ( !idStr::Icmp( cmd, "diff" ) && args.Argc() > 3 ) {
+		idStr oldFileName = args.Argv( 2 );
+		idStr newFileName = args.Argv( 3 );
+		oldFileName.DefaultFileExtension( ".mprof" );
+		newFileName.DefaultFileExtension( ".mprof" );
+		int num = ( args.Argc() > 5 ) ? atoi( args.Argv( 5 ) ) : 20;
+		Mem_ProfileDiff( oldFileName, newFileName, Mem_ProfileParseColumn( args.Argv( 4 ) ), num );
+	} else {
+		idLib::common->Printf( "usage:\n"
+			"  memoryProfile start [sample rate]\n"
+			"  memoryProfile stop\n"
+			"  memoryProfile top [frame|total|live] [num sites]\n"
+			"  memoryProfile write <file>\n"
+			"  memoryProfile diff <old file> <new file> [frame|total|live] [num sites]\n" );
+	}
 }
 
 //===============================================================
@@ -984,9 +1697,19 @@ void idHeap::LargeFree( void *ptr) {
 #undef new
 
 static idHeap *			mem_heap = NULL;
-static memoryStats_t	mem_total_allocs = { 0, 0x0fffffff, -1, 0 };
-static memoryStats_t	mem_frame_allocs;
-static memoryStats_t	mem_frame_frees;
+
+static const char *		mem_tagNames[MEM_TAG_MAX] = {
+	"misc",
+	"renderer",
+	"image",
+	"model",
+	"decl",
+	"sound",
+	"collision",
+	"gui",
+	"filesystem",
+	"game"
+};
 
 /*
 ==================
@@ -994,10 +1717,9 @@ Mem_ClearFrameStats
 ==================
 */
 void Mem_ClearFrameStats( void ) {
-	mem_frame_allocs.num = mem_frame_frees.num = 0;
-	mem_frame_allocs.minSize = mem_frame_frees.minSize = 0x0fffffff;
-	mem_frame_allocs.maxSize = mem_frame_frees.maxSize = -1;
-	mem_frame_allocs.totalSize = mem_frame_frees.totalSize = 0;
+	if ( mem_heap ) {
+		mem_heap->ClearFrameStats();
+	}
 }
 
 /*
@@ -1006,8 +1728,12 @@ Mem_GetFrameStats
 ==================
 */
 void Mem_GetFrameStats( memoryStats_t &allocs, memoryStats_t &frees ) {
-	allocs = mem_frame_allocs;
-	frees = mem_frame_frees;
+	if ( !mem_heap ) {
+		Heap_ClearStats( allocs );
+		Heap_ClearStats( frees );
+		return;
+	}
+	mem_heap->GetFrameStats( allocs, frees );
 }
 
 /*
@@ -1016,44 +1742,86 @@ Mem_GetStats
 ==================
 */
 void Mem_GetStats( memoryStats_t &stats ) {
-	stats = mem_total_allocs;
+	if ( !mem_heap ) {
+		Heap_ClearStats( stats );
+		return;
+	}
+	mem_heap->GetStats( stats );
 }
 
 /*
 ==================
-Mem_UpdateStats
+Mem_GetTagStats
 ==================
 */
-void Mem_UpdateStats( memoryStats_t &stats, int size ) {
-	stats.num++;
-	if ( size < stats.minSize ) {
-		stats.minSize = size;
+void Mem_GetTagStats( memTag_t tag, memoryStats_t &stats ) {
+	if ( !mem_heap ) {
+		Heap_ClearStats( stats );
+		return;
 	}
-	if ( size > stats.maxSize ) {
-		stats.maxSize = size;
+	mem_heap->GetTagStats( tag, stats );
+}
+
+/*
+==================
+Mem_SetTag
+==================
+*/
+memTag_t Mem_SetTag( memTag_t tag ) {
+	assert( tag >= 0 && tag < MEM_TAG_MAX );
+	memTag_t oldTag = (memTag_t) heap_threadTag;
+	heap_threadTag = tag;
+	return oldTag;
+}
+
+/*
+==================
+Mem_GetTag
+==================
+*/
+memTag_t Mem_GetTag( void ) {
+	return (memTag_t) heap_threadTag;
+}
+
+/*
+==================
+Mem_GetTagName
+==================
+*/
+const char *Mem_GetTagName( memTag_t tag ) {
+	if ( tag < 0 || tag >= MEM_TAG_MAX ) {
+		return "unknown";
 	}
-	stats.totalSize += size;
+	return mem_tagNames[tag];
 }
 
 /*
 ==================
-Mem_UpdateAllocStats
+Mem_ReleaseThreadCache
 ==================
 */
-void Mem_UpdateAllocStats( int size ) {
-	Mem_UpdateStats( mem_frame_allocs, size );
-	Mem_UpdateStats( mem_total_allocs, size );
+void Mem_ReleaseThreadCache( void ) {
+	if ( mem_heap ) {
+		mem_heap->ReleaseThreadCache();
+	}
 }
 
 /*
 ==================
-Mem_UpdateFreeStats
+Mem_PrintTagStats
 ==================
 */
-void Mem_UpdateFreeStats( int size ) {
-	Mem_UpdateStats( mem_frame_frees, size );
-	mem_total_allocs.num--;
-	mem_total_allocs.totalSize -= size;
+static void Mem_PrintTagStats( void ) {
+	memoryStats_t stats;
+
+	idLib::common->Printf( "tag         blocks     kB\n" );
+	idLib::common->Printf( "---------- ------- ------\n" );
+	for ( int i = 0; i < MEM_TAG_MAX; i++ ) {
+		Mem_GetTagStats( (memTag_t)i, stats );
+		idLib::common->Printf( "%-10s %7d %6d\n", mem_tagNames[i], stats.num, stats.totalSize >> 10 );
+	}
+	Mem_GetStats( stats );
+	idLib::common->Printf( "%-10s %7d %6d\n", "total", stats.num, stats.totalSize >> 10 );
 }
 
 
@@ -1074,9 +1842,7 @@ void *Mem_Alloc( const int size ) {
 #endif
 		return malloc( size );
 	}
-	void *mem = mem_heap->Allocate( size );
-	Mem_UpdateAllocStats( mem_heap->Msize( mem ) );
-	return mem;
+	return mem_heap->Allocate( size );
 }
 
 /*
@@ -1095,7 +1861,6 @@ void Mem_Free( void *ptr ) {
 		free( ptr );
 		return;
 	}
-	Mem_UpdateFreeStats( mem_heap->Msize( ptr ) );
  	mem_heap->Free( ptr );
 }
 
@@ -1180,6 +1945,11 @@ Mem_Dump_f
 ==================
 */
 void Mem_Dump_f( const idCmdArgs &args ) {
+	if ( !mem_heap ) {
+		return;
+	}
+	mem_heap->Dump();
+	Mem_PrintTagStats();
 }
 
 /*
@@ -1583,8 +2353,6 @@ void *Mem_AllocDebugMemory( const int size, const char *fileName, const int line
 		p = mem_heap->Allocate( size + sizeof( debugMemory_t ) );
 	}
 
-	Mem_UpdateAllocStats( size );
-
 	m = (debugMemory_t *) p;
 	m->fileName = fileName;
 	m->lineNumber = lineNumber;
@@ -1628,8 +2396,6 @@ void Mem_FreeDebugMemory( void *p, const char *fileName, const int lineNumber, c
 		idLib::common->FatalError( "memory freed twice, first from %s, now from %s", idLib::sys->GetCallStackStr( m->callStack, MAX_CALLSTACK_DEPTH ), idLib::sys->GetCallStackCurStr( MAX_CALLSTACK_DEPTH ) );
 	}
 
-	Mem_UpdateFreeStats( m->size );
-
 	if ( m->next ) {
 		m->next->prev = m->prev;
 	}
@@ -35,8 +35,11 @@ If you have questions concerning this license or the applicable additional terms
 	Memory Management
 
 	This is a replacement for the compiler heap code (i.e. "C" malloc() and
-	free() calls). On average 2.5-3.0 times faster than MSVC malloc()/free().
-	Worst case performance is 1.65 times faster and best case > 70 times.
+	free() calls). Every thread allocates from its own cache of blocks, so
+	threads only contend when a cache needs to be refilled or flushed.
+
+	Every allocation is accounted to the memory tag that is current on the
+	allocating thread. Each game module has its own heap.
  
 ===============================================================================
 */
@@ -49,6 +52,20 @@ typedef struct {
 	int		totalSize;
 } memoryStats_t;
 
+typedef enum {
+	MEM_TAG_MISC,
+	MEM_TAG_RENDERER,
+	MEM_TAG_IMAGE,
+	MEM_TAG_MODEL,
+	MEM_TAG_DECL,
+	MEM_TAG_SOUND,
+	MEM_TAG_COLLISION,
+	MEM_TAG_GUI,
+	MEM_TAG_FILESYSTEM,
+	MEM_TAG_GAME,
+	MEM_TAG_MAX
+} memTag_t;
+
 
 void		Mem_Init( void );
 void		Mem_Shutdown( void );
@@ -59,6 +76,23 @@ void		Mem_GetStats( memoryStats_t &stats );
 void		Mem_Dump_f( const class idCmdArgs &args );
 void		Mem_DumpCompressed_f( const class idCmdArgs &args );
 void		Mem_AllocDefragBlock( void );
+void		Mem_GetTagStats( memTag_t tag, memoryStats_t &stats );
+memTag_t	Mem_SetTag( memTag_t tag );		// sets the tag of the calling thread and returns the previous one
+memTag_t	Mem_GetTag( void );
+const char *Mem_GetTagName( memTag_t tag );
+void		Mem_ReleaseThreadCache( void );	// call before a thread that allocated memory exits
+void		Mem_ProfileStart( int sampleRate );	// samples the call stack of every Nth allocation
+void		Mem_ProfileStop( void );
+void		Mem_ProfileFrame( void );		// call once per frame
+void		Mem_Profile_f( const class idCmdArgs &args );
+
+class idScopedMemTag {
+public:
+				idScopedMemTag( memTag_t tag ) { oldTag = Mem_SetTag( tag ); }
+				~idScopedMemTag( void ) { Mem_SetTag( oldTag ); }
+private:
+	memTag_t	oldTag;
+};
 
 
 #ifndef ID_DEBUG_MEMORY
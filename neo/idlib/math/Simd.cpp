@@ -2833,6 +2833,204 @@ void TestOverlayPointCull( void ) {
 	PrintClocks( va( "   simd->OverlayPointCull() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
 }
 
+/*
+============
+TestShadowPointCull
+============
+*/
+void TestShadowPointCull( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( idPlane planes[6] );
+	ALIGN16( idDrawVert drawVerts[COUNT] );
+	ALIGN16( unsigned short cullBits1[COUNT] );
+	ALIGN16( unsigned short cullBits2[COUNT] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	planes[0].SetNormal( idVec3(  1,  0,  0 ) );
+	planes[1].SetNormal( idVec3( -1,  0,  0 ) );
+	planes[2].SetNormal( idVec3(  0,  1,  0 ) );
+	planes[3].SetNormal( idVec3(  0, -1,  0 ) );
+	planes[4].SetNormal( idVec3(  0,  0,  1 ) );
+	planes[5].SetNormal( idVec3(  0,  0, -1 ) );
+	planes[0][3] = -5.3f;
+	planes[1][3] = 5.3f;
+	planes[2][3] = -4.4f;
+	planes[3][3] = 4.4f;
+	planes[4][3] = -3.5f;
+	planes[5][3] = 3.5f;
+
+	for ( i = 0; i < COUNT; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			drawVerts[i].xyz[j] = srnd.CRandomFloat() * 10.0f;
+		}
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->ShadowPointCull( cullBits1, planes, drawVerts, COUNT, 0.1f );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->ShadowPointCull()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->ShadowPointCull( cullBits2, planes, drawVerts, COUNT, 0.1f );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		if ( cullBits1[i] != cullBits2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= COUNT ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->ShadowPointCull() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestCullBounds
+============
+*/
+void TestCullBounds( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( idPlane planes[5] );
+	ALIGN16( float boundsData[6][COUNT] );
+	ALIGN16( byte cullBits1[COUNT] );
+	ALIGN16( byte cullBits2[COUNT] );
+	const float *bounds[6];
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < 5; i++ ) {
+		idVec3 normal( srnd.CRandomFloat(), srnd.CRandomFloat(), srnd.CRandomFloat() );
+		normal.Normalize();
+		planes[i].SetNormal( normal );
+		planes[i][3] = -srnd.RandomFloat() * 5.0f;
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			float center = srnd.CRandomFloat() * 10.0f;
+			float extent = srnd.RandomFloat() * 2.0f;
+			boundsData[j][i] = center - extent;
+			boundsData[j+3][i] = center + extent;
+		}
+	}
+	for ( j = 0; j < 6; j++ ) {
+		bounds[j] = boundsData[j];
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->CullBounds( cullBits1, planes, 5, bounds, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->CullBounds()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->CullBounds( cullBits2, planes, 5, bounds, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		if ( cullBits1[i] != cullBits2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= COUNT ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->CullBounds() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestDepthSpan
+============
+*/
+void TestDepthSpan( void ) {
+	int i;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( float depthSrc[COUNT] );
+	ALIGN16( float depth1[COUNT] );
+	ALIGN16( float depth2[COUNT] );
+	const char *result;
+	bool visible1, visible2;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < COUNT; i++ ) {
+		depthSrc[i] = srnd.RandomFloat();
+	}
+
+	// odd span lengths and unaligned starts exercise the tails
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		memcpy( depth1, depthSrc, sizeof( depth1 ) );
+		StartRecordTime( start );
+		p_generic->DepthSpanMax( depth1 + 1, 0.25f, 0.0003f, COUNT - 2 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->DepthSpanMax()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		memcpy( depth2, depthSrc, sizeof( depth2 ) );
+		StartRecordTime( start );
+		p_simd->DepthSpanMax( depth2 + 1, 0.25f, 0.0003f, COUNT - 2 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		if ( depth1[i] != depth2[i] ) {
+			break;
+		}
+	}
+	result = ( i >= COUNT ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->DepthSpanMax() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+
+	// only the last element is behind the tested depth
+	for ( i = 0; i < COUNT; i++ ) {
+		depth1[i] = 1.0f;
+	}
+	depth1[COUNT - 1] = 0.5f;
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		visible1 = p_generic->DepthSpanTest( depth1, 0.75f, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->DepthSpanTest()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		visible2 = p_simd->DepthSpanTest( depth1, 0.75f, COUNT );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	result = ( visible1 == visible2 && visible1 && !p_simd->DepthSpanTest( depth1, 0.75f, COUNT - 1 ) ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->DepthSpanTest() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
 /*
 ============
 TestDeriveTriPlanes
@@ -3115,6 +3313,125 @@ void TestNormalizeTangents( void ) {
 	PrintClocks( va( "   simd->NormalizeTangents() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
 }
 
+/*
+============
+TestAutospriteVerts
+============
+*/
+void TestAutospriteVerts( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( idDrawVert srcVerts[COUNT] );
+	ALIGN16( idDrawVert drawVerts1[COUNT] );
+	ALIGN16( idDrawVert drawVerts2[COUNT] );
+	idVec3 leftDir, upDir;
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < COUNT; i++ ) {
+		srcVerts[i].Clear();
+		for ( j = 0; j < 3; j++ ) {
+			srcVerts[i].xyz[j] = srnd.CRandomFloat() * 10.0f;
+		}
+		srcVerts[i].st[0] = srnd.CRandomFloat();
+		srcVerts[i].st[1] = srnd.CRandomFloat();
+	}
+	leftDir.Set( 0.0f, 1.0f, 0.0f );
+	upDir.Set( 0.0f, 0.0f, 1.0f );
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->AutospriteVerts( drawVerts1, srcVerts, COUNT, leftDir, upDir );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->AutospriteVerts()", COUNT, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->AutospriteVerts( drawVerts2, srcVerts, COUNT, leftDir, upDir );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		if ( !drawVerts1[i].xyz.Compare( drawVerts2[i].xyz, 1e-2f ) ) {
+			break;
+		}
+		if ( !drawVerts1[i].st.Compare( drawVerts2[i].st ) ) {
+			break;
+		}
+		if ( !drawVerts1[i].normal.Compare( drawVerts2[i].normal ) || drawVerts1[i].GetColor() != drawVerts2[i].GetColor() ) {
+			break;
+		}
+		if ( !drawVerts1[i].tangents[0].Compare( drawVerts2[i].tangents[0] ) || !drawVerts1[i].tangents[1].Compare( drawVerts2[i].tangents[1] ) ) {
+			break;
+		}
+	}
+	result = ( i >= COUNT ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->AutospriteVerts() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
+/*
+============
+TestParticleQuads
+============
+*/
+void TestParticleQuads( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( idVec3 quads[COUNT/4*3] );
+	ALIGN16( idDrawVert drawVerts1[COUNT] );
+	ALIGN16( idDrawVert drawVerts2[COUNT] );
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < COUNT/4*3; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			quads[i][j] = srnd.CRandomFloat() * 10.0f;
+		}
+	}
+	for ( i = 0; i < COUNT; i++ ) {
+		for ( j = 0; j < 2; j++ ) {
+			drawVerts1[i].st[j] = srnd.CRandomFloat();
+		}
+		drawVerts2[i] = drawVerts1[i];
+	}
+
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->ParticleQuads( drawVerts1, quads, COUNT/4 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->ParticleQuads()", COUNT/4, bestClocksGeneric );
+
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->ParticleQuads( drawVerts2, quads, COUNT/4 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	for ( i = 0; i < COUNT; i++ ) {
+		if ( !drawVerts1[i].xyz.Compare( drawVerts2[i].xyz, 1e-4f ) ) {
+			break;
+		}
+		// the texture coordinates after the xyz are left alone
+		if ( !drawVerts1[i].st.Compare( drawVerts2[i].st ) ) {
+			break;
+		}
+	}
+	result = ( i >= COUNT ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->ParticleQuads() %s", result ), COUNT/4, bestClocksSIMD, bestClocksGeneric );
+}
+
 /*
 ============
 TestGetTextureSpaceLightVectors
@@ -3634,6 +3951,101 @@ void TestSoundMixing( void ) {
 	PrintClocks( va( "   simd->MixedSoundToSamples() %s", result ), MIXBUFFER_SAMPLES, bestClocksSIMD, bestClocksGeneric );
 }
 
+/*
+============
+TestImageRows
+============
+*/
+void TestImageRows( void ) {
+	int i, j;
+	TIME_TYPE start, end, bestClocksGeneric, bestClocksSIMD;
+	ALIGN16( byte srcRows[4][COUNT*8] );
+	ALIGN16( byte dst1[COUNT*4] );
+	ALIGN16( byte dst2[COUNT*4] );
+	unsigned int offsets0[COUNT], offsets1[COUNT];
+	const char *result;
+
+	idRandom srnd( RANDOM_SEED );
+
+	for ( i = 0; i < 4; i++ ) {
+		for ( j = 0; j < COUNT*8; j++ ) {
+			srcRows[i][j] = srnd.RandomInt( 255 );
+		}
+	}
+
+	// an odd texel count exercises the tails
+	memset( dst1, 0, sizeof( dst1 ) );
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->MipMapRow( dst1, srcRows[0], srcRows[1], COUNT - 1 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->MipMapRow()", COUNT, bestClocksGeneric );
+
+	memset( dst2, 0, sizeof( dst2 ) );
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->MipMapRow( dst2, srcRows[0], srcRows[1], COUNT - 1 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	result = ( memcmp( dst1, dst2, sizeof( dst1 ) ) == 0 ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->MipMapRow() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+
+	memset( dst1, 0, sizeof( dst1 ) );
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->MipMapRow3D( dst1, srcRows[0], srcRows[1], srcRows[2], srcRows[3], COUNT - 1 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->MipMapRow3D()", COUNT, bestClocksGeneric );
+
+	memset( dst2, 0, sizeof( dst2 ) );
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->MipMapRow3D( dst2, srcRows[0], srcRows[1], srcRows[2], srcRows[3], COUNT - 1 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	result = ( memcmp( dst1, dst2, sizeof( dst1 ) ) == 0 ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->MipMapRow3D() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+
+	for ( i = 0; i < COUNT; i++ ) {
+		offsets0[i] = 4 * srnd.RandomInt( COUNT*2 - 1 );
+		offsets1[i] = 4 * srnd.RandomInt( COUNT*2 - 1 );
+	}
+
+	memset( dst1, 0, sizeof( dst1 ) );
+	bestClocksGeneric = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_generic->ResampleRow( dst1, srcRows[0], srcRows[1], offsets0, offsets1, COUNT - 1 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksGeneric );
+	}
+	PrintClocks( "generic->ResampleRow()", COUNT, bestClocksGeneric );
+
+	memset( dst2, 0, sizeof( dst2 ) );
+	bestClocksSIMD = 0;
+	for ( i = 0; i < NUMTESTS; i++ ) {
+		StartRecordTime( start );
+		p_simd->ResampleRow( dst2, srcRows[0], srcRows[1], offsets0, offsets1, COUNT - 1 );
+		StopRecordTime( end );
+		GetBest( start, end, bestClocksSIMD );
+	}
+
+	result = ( memcmp( dst1, dst2, sizeof( dst1 ) ) == 0 ) ? "ok" : S_COLOR_RED"X";
+	PrintClocks( va( "   simd->ResampleRow() %s", result ), COUNT, bestClocksSIMD, bestClocksGeneric );
+}
+
 /*
 ============
 TestMath
@@ -4198,10 +4610,15 @@ void idSIMD::Test_f( const idCmdArgs &args ) {
 	TestTracePointCull();
 	TestDecalPointCull();
 	TestOverlayPointCull();
+	TestShadowPointCull();
+	TestCullBounds();
+	TestDepthSpan();
 	TestDeriveTriPlanes();
 	TestDeriveTangents();
 	TestDeriveUnsmoothedTangents();
 	TestNormalizeTangents();
+	TestAutospriteVerts();
+	TestParticleQuads();
 	TestGetTextureSpaceLightVectors();
 	TestGetSpecularTextureCoords();
 	TestCreateShadowCache();
@@ -4211,6 +4628,10 @@ void idSIMD::Test_f( const idCmdArgs &args ) {
 	TestSoundUpSampling();
 	TestSoundMixing();
 
+	idLib::common->Printf("====================================\n" );
+
+	TestImageRows();
+
 	idLib::common->SetRefreshOnPrint( false );
 
 	if ( p_simd != processor ) {
@@ -179,10 +179,16 @@ public:
 	virtual void VPCALL TracePointCull( byte *cullBits, byte &totalOr, const float radius, const idPlane *planes, const idDrawVert *verts, const int numVerts ) = 0;
 	virtual void VPCALL DecalPointCull( byte *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts ) = 0;
 	virtual void VPCALL OverlayPointCull( byte *cullBits, idVec2 *texCoords, const idPlane *planes, const idDrawVert *verts, const int numVerts ) = 0;
+	virtual void VPCALL ShadowPointCull( unsigned short *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts, const float epsilon ) = 0;
+	virtual void VPCALL CullBounds( byte *cullBits, const idPlane *planes, const int numPlanes, const float * const *bounds, const int numBounds ) = 0;
+	virtual void VPCALL DepthSpanMax( float *depth, const float z, const float dz, const int count ) = 0;
+	virtual bool VPCALL DepthSpanTest( const float *depth, const float z, const int count ) = 0;
 	virtual void VPCALL DeriveTriPlanes( idPlane *planes, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes ) = 0;
 	virtual void VPCALL DeriveTangents( idPlane *planes, idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes ) = 0;
 	virtual void VPCALL DeriveUnsmoothedTangents( idDrawVert *verts, const dominantTri_s *dominantTris, const int numVerts ) = 0;
 	virtual void VPCALL NormalizeTangents( idDrawVert *verts, const int numVerts ) = 0;
+	virtual void VPCALL AutospriteVerts( idDrawVert *verts, const idDrawVert *src, const int numVerts, const idVec3 &leftDir, const idVec3 &upDir ) = 0;
+	virtual void VPCALL ParticleQuads( idDrawVert *verts, const idVec3 *quads, const int numQuads ) = 0;
 	virtual void VPCALL CreateTextureSpaceLightVectors( idVec3 *lightVectors, const idVec3 &lightOrigin, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes ) = 0;
 	virtual void VPCALL CreateSpecularTextureCoords( idVec4 *texCoords, const idVec3 &lightOrigin, const idVec3 &viewOrigin, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes ) = 0;
 	virtual int  VPCALL CreateShadowCache( idVec4 *vertexCache, int *vertRemap, const idVec3 &lightOrigin, const idDrawVert *verts, const int numVerts ) = 0;
@@ -196,6 +202,11 @@ public:
 	virtual void VPCALL MixSoundSixSpeakerMono( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] ) = 0;
 	virtual void VPCALL MixSoundSixSpeakerStereo( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] ) = 0;
 	virtual void VPCALL MixedSoundToSamples( short *samples, const float *mixBuffer, const int numSamples ) = 0;
+
+	// image processing, rows of RGBA texels
+	virtual void VPCALL MipMapRow( byte *dst, const byte *src0, const byte *src1, const int count ) = 0;
+	virtual void VPCALL MipMapRow3D( byte *dst, const byte *src0, const byte *src1, const byte *src2, const byte *src3, const int count ) = 0;
+	virtual void VPCALL ResampleRow( byte *dst, const byte *src0, const byte *src1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) = 0;
 };
 
 // pointer to SIMD processor
@@ -2437,6 +2437,96 @@ void VPCALL idSIMD_Generic::OverlayPointCull( byte *cullBits, idVec2 *texCoords,
 	}
 }
 
+/*
+============
+idSIMD_Generic::ShadowPointCull
+
+	Bits 0-5 are set if the point is on or behind the corresponding plane,
+	bits 6-11 are set if the point is on or in front of the plane.
+============
+*/
+void VPCALL idSIMD_Generic::ShadowPointCull( unsigned short *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts, const float epsilon ) {
+	int i, j;
+
+	for ( i = 0; i < numVerts; i++ ) {
+		int bits;
+		const idVec3 &v = verts[i].xyz;
+
+		bits = 0;
+		for ( j = 0; j < 6; j++ ) {
+			float d = planes[j].Distance( v );
+			bits |= ( d < epsilon ) << j;
+			bits |= ( d > -epsilon ) << ( j + 6 );
+		}
+
+		cullBits[i] = bits;
+	}
+}
+
+/*
+============
+idSIMD_Generic::CullBounds
+
+	The bounds are stored as six arrays, mins x, y, z and maxs x, y, z.
+	Bit j is set if a box is completely in front of plane j.
+============
+*/
+void VPCALL idSIMD_Generic::CullBounds( byte *cullBits, const idPlane *planes, const int numPlanes, const float * const *bounds, const int numBounds ) {
+	int i, j;
+
+	memset( cullBits, 0, numBounds * sizeof( cullBits[0] ) );
+
+	for ( j = 0; j < numPlanes; j++ ) {
+		const idPlane &p = planes[j];
+
+		// the corner of each box that is furthest behind the plane
+		const float *x = bounds[ p[0] > 0.0f ? 0 : 3 ];
+		const float *y = bounds[ p[1] > 0.0f ? 1 : 4 ];
+		const float *z = bounds[ p[2] > 0.0f ? 2 : 5 ];
+
+		for ( i = 0; i < numBounds; i++ ) {
+			float d = p[0] * x[i] + p[1] * y[i] + p[2] * z[i] + p[3];
+			cullBits[i] |= ( d > 0.0f ) << j;
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::DepthSpanMax
+
+	depth[i] = Max( depth[i], z + i * dz )
+============
+*/
+void VPCALL idSIMD_Generic::DepthSpanMax( float *depth, const float z, const float dz, const int count ) {
+	int i;
+
+	for ( i = 0; i < count; i++ ) {
+		float d = z + (float)i * dz;
+		if ( d > depth[i] ) {
+			depth[i] = d;
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::DepthSpanTest
+
+	Returns true if depth[i] <= z for any i.
+============
+*/
+bool VPCALL idSIMD_Generic::DepthSpanTest( const float *depth, const float z, const int count ) {
+	int i;
+
+	for ( i = 0; i < count; i++ ) {
+		if ( depth[i] <= z ) {
+			return true;
+		}
+	}
+	return false;
+}
+
 /*
 ============
 idSIMD_Generic::DeriveTriPlanes
@@ -2704,6 +2794,74 @@ void VPCALL idSIMD_Generic::NormalizeTangents( idDrawVert *verts, const int numV
 	}
 }
 
+/*
+============
+idSIMD_Generic::AutospriteVerts
+
+	Rebuilds each quad of four vertexes as a square facing along the left and up directions.
+	Only the xyz and st are set, the other members are cleared.
+============
+*/
+void VPCALL idSIMD_Generic::AutospriteVerts( idDrawVert *verts, const idDrawVert *src, const int numVerts, const idVec3 &leftDir, const idVec3 &upDir ) {
+
+	for ( int i = 0; i < numVerts - 3; i += 4 ) {
+		const idDrawVert *v = src + i;
+		idDrawVert *dst = verts + i;
+		idVec3 mid, delta, left, up;
+		float radius;
+
+		mid.x = ( v[0].xyz.x + v[1].xyz.x + v[2].xyz.x + v[3].xyz.x ) * 0.25f;
+		mid.y = ( v[0].xyz.y + v[1].xyz.y + v[2].xyz.y + v[3].xyz.y ) * 0.25f;
+		mid.z = ( v[0].xyz.z + v[1].xyz.z + v[2].xyz.z + v[3].xyz.z ) * 0.25f;
+
+		delta = v[0].xyz - mid;
+		radius = idMath::Sqrt( delta.x * delta.x + delta.y * delta.y + delta.z * delta.z ) * 0.707f;	// / sqrt(2)
+
+		left = leftDir * radius;
+		up = upDir * radius;
+
+		dst[0].Clear();
+		dst[1].Clear();
+		dst[2].Clear();
+		dst[3].Clear();
+
+		dst[0].xyz = mid + left + up;
+		dst[0].st[0] = 0.0f;
+		dst[0].st[1] = 0.0f;
+		dst[1].xyz = mid - left + up;
+		dst[1].st[0] = 1.0f;
+		dst[1].st[1] = 0.0f;
+		dst[2].xyz = mid - left - up;
+		dst[2].st[0] = 1.0f;
+		dst[2].st[1] = 1.0f;
+		dst[3].xyz = mid + left - up;
+		dst[3].st[0] = 0.0f;
+		dst[3].st[1] = 1.0f;
+	}
+}
+
+/*
+============
+idSIMD_Generic::ParticleQuads
+
+	Sets the xyz of the particle quads, quads holds an origin, left and up vector for each quad.
+============
+*/
+void VPCALL idSIMD_Generic::ParticleQuads( idDrawVert *verts, const idVec3 *quads, const int numQuads ) {
+
+	for ( int i = 0; i < numQuads; i++ ) {
+		const idVec3 &origin = quads[i*3+0];
+		const idVec3 &left = quads[i*3+1];
+		const idVec3 &up = quads[i*3+2];
+		idDrawVert *dst = verts + i * 4;
+
+		dst[0].xyz = origin - left + up;
+		dst[1].xyz = origin + left + up;
+		dst[2].xyz = origin - left - up;
+		dst[3].xyz = origin + left - up;
+	}
+}
+
 /*
 ============
 idSIMD_Generic::CreateTextureSpaceLightVectors
@@ -3058,3 +3216,63 @@ void VPCALL idSIMD_Generic::MixedSoundToSamples( short *samples, const float *mi
 		}
 	}
 }
+
+/*
+============
+idSIMD_Generic::MipMapRow
+
+	Box filters count RGBA texels of dst from the 2x2 blocks of two source rows,
+	each source row holding 2 * count texels.
+============
+*/
+void VPCALL idSIMD_Generic::MipMapRow( byte *dst, const byte *src0, const byte *src1, const int count ) {
+	int i;
+
+	for ( i = 0; i < count; i++, dst += 4, src0 += 8, src1 += 8 ) {
+		dst[0] = ( src0[0] + src0[4] + src1[0] + src1[4] ) >> 2;
+		dst[1] = ( src0[1] + src0[5] + src1[1] + src1[5] ) >> 2;
+		dst[2] = ( src0[2] + src0[6] + src1[2] + src1[6] ) >> 2;
+		dst[3] = ( src0[3] + src0[7] + src1[3] + src1[7] ) >> 2;
+	}
+}
+
+/*
+============
+idSIMD_Generic::MipMapRow3D
+
+	Box filters count RGBA texels of dst from the 2x2x2 blocks of two rows
+	in each of two source planes.
+============
+*/
+void VPCALL idSIMD_Generic::MipMapRow3D( byte *dst, const byte *src0, const byte *src1, const byte *src2, const byte *src3, const int count ) {
+	int i, j;
+
+	for ( i = 0; i < count; i++, dst += 4, src0 += 8, src1 += 8, src2 += 8, src3 += 8 ) {
+		for ( j = 0; j < 4; j++ ) {
+			dst[j] = ( src0[j] + src0[j+4] + src1[j] + src1[j+4] + src2[j] + src2[j+4] + src3[j] + src3[j+4] ) >> 3;
+		}
+	}
+}
+
+/*
+============
+idSIMD_Generic::ResampleRow
+
+	Each RGBA texel of dst is the average of the texels at the byte offsets
+	offsets0[i] and offsets1[i] in both source rows.
+============
+*/
+void VPCALL idSIMD_Generic::ResampleRow( byte *dst, const byte *src0, const byte *src1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	int i;
+
+	for ( i = 0; i < count; i++, dst += 4 ) {
+		const byte *pix1 = src0 + offsets0[i];
+		const byte *pix2 = src0 + offsets1[i];
+		const byte *pix3 = src1 + offsets0[i];
+		const byte *pix4 = src1 + offsets1[i];
+		dst[0] = ( pix1[0] + pix2[0] + pix3[0] + pix4[0] ) >> 2;
+		dst[1] = ( pix1[1] + pix2[1] + pix3[1] + pix4[1] ) >> 2;
+		dst[2] = ( pix1[2] + pix2[2] + pix3[2] + pix4[2] ) >> 2;
+		dst[3] = ( pix1[3] + pix2[3] + pix3[3] + pix4[3] ) >> 2;
+	}
+}
@@ -116,10 +116,16 @@ public:
 	virtual void VPCALL TracePointCull( byte *cullBits, byte &totalOr, const float radius, const idPlane *planes, const idDrawVert *verts, const int numVerts );
 	virtual void VPCALL DecalPointCull( byte *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts );
 	virtual void VPCALL OverlayPointCull( byte *cullBits, idVec2 *texCoords, const idPlane *planes, const idDrawVert *verts, const int numVerts );
+	virtual void VPCALL ShadowPointCull( unsigned short *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts, const float epsilon );
+	virtual void VPCALL CullBounds( byte *cullBits, const idPlane *planes, const int numPlanes, const float * const *bounds, const int numBounds );
+	virtual void VPCALL DepthSpanMax( float *depth, const float z, const float dz, const int count );
+	virtual bool VPCALL DepthSpanTest( const float *depth, const float z, const int count );
 	virtual void VPCALL DeriveTriPlanes( idPlane *planes, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes );
 	virtual void VPCALL DeriveTangents( idPlane *planes, idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes );
 	virtual void VPCALL DeriveUnsmoothedTangents( idDrawVert *verts, const dominantTri_s *dominantTris, const int numVerts );
 	virtual void VPCALL NormalizeTangents( idDrawVert *verts, const int numVerts );
+	virtual void VPCALL AutospriteVerts( idDrawVert *verts, const idDrawVert *src, const int numVerts, const idVec3 &leftDir, const idVec3 &upDir );
+	virtual void VPCALL ParticleQuads( idDrawVert *verts, const idVec3 *quads, const int numQuads );
 	virtual void VPCALL CreateTextureSpaceLightVectors( idVec3 *lightVectors, const idVec3 &lightOrigin, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes );
 	virtual void VPCALL CreateSpecularTextureCoords( idVec4 *texCoords, const idVec3 &lightOrigin, const idVec3 &viewOrigin, const idDrawVert *verts, const int numVerts, const int *indexes, const int numIndexes );
 	virtual int  VPCALL CreateShadowCache( idVec4 *vertexCache, int *vertRemap, const idVec3 &lightOrigin, const idDrawVert *verts, const int numVerts );
@@ -132,6 +138,10 @@ public:
 	virtual void VPCALL MixSoundSixSpeakerMono( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] );
 	virtual void VPCALL MixSoundSixSpeakerStereo( float *mixBuffer, const float *samples, const int numSamples, const float lastV[6], const float currentV[6] );
 	virtual void VPCALL MixedSoundToSamples( short *samples, const float *mixBuffer, const int numSamples );
+
+	virtual void VPCALL MipMapRow( byte *dst, const byte *src0, const byte *src1, const int count );
+	virtual void VPCALL MipMapRow3D( byte *dst, const byte *src0, const byte *src1, const byte *src2, const byte *src3, const int count );
+	virtual void VPCALL ResampleRow( byte *dst, const byte *src0, const byte *src1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
 };
 
 #endif /* !__MATH_SIMD_GENERIC_H__ */
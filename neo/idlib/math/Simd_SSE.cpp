@@ -13119,6 +13119,167 @@ void VPCALL idSIMD_SSE::OverlayPointCull( byte *cullBits, idVec2 *texCoords, con
 #endif
 }
 
+/*
+============
+idSIMD_SSE::ShadowPointCull
+============
+*/
+#define SHADOW_CULL_BIT( b )	{ 1 << (b), 1 << (b), 1 << (b), 1 << (b) }
+ALIGN16( static unsigned int SIMD_DW_shadowCullBits[12][4] ) = {
+	SHADOW_CULL_BIT( 0 ), SHADOW_CULL_BIT( 1 ), SHADOW_CULL_BIT( 2 ), SHADOW_CULL_BIT( 3 ), SHADOW_CULL_BIT( 4 ), SHADOW_CULL_BIT( 5 ),
+	SHADOW_CULL_BIT( 6 ), SHADOW_CULL_BIT( 7 ), SHADOW_CULL_BIT( 8 ), SHADOW_CULL_BIT( 9 ), SHADOW_CULL_BIT( 10 ), SHADOW_CULL_BIT( 11 )
+};
+#undef SHADOW_CULL_BIT
+
+void VPCALL idSIMD_SSE::ShadowPointCull( unsigned short *cullBits, const idPlane *planes, const idDrawVert *verts, const int numVerts, const float epsilon ) {
+	ALIGN16( unsigned int bits[4] );
+	__m128 px[6], py[6], pz[6], pd[6];
+	int i, j;
+
+	// splat the planes so four points are tested against a plane at once
+	for ( j = 0; j < 6; j++ ) {
+		px[j] = _mm_set_ps1( planes[j][0] );
+		py[j] = _mm_set_ps1( planes[j][1] );
+		pz[j] = _mm_set_ps1( planes[j][2] );
+		pd[j] = _mm_set_ps1( planes[j][3] );
+	}
+
+	const __m128 posEpsilon = _mm_set_ps1( epsilon );
+	const __m128 negEpsilon = _mm_set_ps1( -epsilon );
+
+	for ( i = 0; i < ( numVerts & ~3 ); i += 4 ) {
+		const idDrawVert *v = verts + i;
+
+		__m128 x = _mm_setr_ps( v[0].xyz[0], v[1].xyz[0], v[2].xyz[0], v[3].xyz[0] );
+		__m128 y = _mm_setr_ps( v[0].xyz[1], v[1].xyz[1], v[2].xyz[1], v[3].xyz[1] );
+		__m128 z = _mm_setr_ps( v[0].xyz[2], v[1].xyz[2], v[2].xyz[2], v[3].xyz[2] );
+		__m128 b = _mm_setzero_ps();
+
+		for ( j = 0; j < 6; j++ ) {
+			// same operation order as idPlane::Distance so the results match the generic code
+			__m128 d = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( px[j], x ), _mm_mul_ps( py[j], y ) ), _mm_mul_ps( pz[j], z ) ), pd[j] );
+			b = _mm_or_ps( b, _mm_and_ps( _mm_cmplt_ps( d, posEpsilon ), _mm_load_ps( (float *)SIMD_DW_shadowCullBits[j] ) ) );
+			b = _mm_or_ps( b, _mm_and_ps( _mm_cmpgt_ps( d, negEpsilon ), _mm_load_ps( (float *)SIMD_DW_shadowCullBits[j+6] ) ) );
+		}
+
+		_mm_store_ps( (float *)bits, b );
+		cullBits[i+0] = (unsigned short)bits[0];
+		cullBits[i+1] = (unsigned short)bits[1];
+		cullBits[i+2] = (unsigned short)bits[2];
+		cullBits[i+3] = (unsigned short)bits[3];
+	}
+
+	if ( i < numVerts ) {
+		idSIMD_Generic::ShadowPointCull( cullBits + i, planes, verts + i, numVerts - i, epsilon );
+	}
+}
+
+/*
+============
+idSIMD_SSE::CullBounds
+============
+*/
+void VPCALL idSIMD_SSE::CullBounds( byte *cullBits, const idPlane *planes, const int numPlanes, const float * const *bounds, const int numBounds ) {
+	const float *x[8], *y[8], *z[8];
+	__m128 px[8], py[8], pz[8], pd[8];
+	int i, j;
+
+	assert( numPlanes <= 8 );
+
+	// pick the box corner furthest behind each plane and splat the planes
+	for ( j = 0; j < numPlanes; j++ ) {
+		x[j] = bounds[ planes[j][0] > 0.0f ? 0 : 3 ];
+		y[j] = bounds[ planes[j][1] > 0.0f ? 1 : 4 ];
+		z[j] = bounds[ planes[j][2] > 0.0f ? 2 : 5 ];
+		px[j] = _mm_set_ps1( planes[j][0] );
+		py[j] = _mm_set_ps1( planes[j][1] );
+		pz[j] = _mm_set_ps1( planes[j][2] );
+		pd[j] = _mm_set_ps1( planes[j][3] );
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for ( i = 0; i < ( numBounds & ~3 ); i += 4 ) {
+		int bits0 = 0, bits1 = 0, bits2 = 0, bits3 = 0;
+
+		for ( j = 0; j < numPlanes; j++ ) {
+			// same operation order as the generic code so the results match
+			__m128 d = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( px[j], _mm_loadu_ps( x[j] + i ) ), _mm_mul_ps( py[j], _mm_loadu_ps( y[j] + i ) ) ),
+								_mm_mul_ps( pz[j], _mm_loadu_ps( z[j] + i ) ) ), pd[j] );
+			int mask = _mm_movemask_ps( _mm_cmpgt_ps( d, zero ) );
+			bits0 |= ( ( mask >> 0 ) & 1 ) << j;
+			bits1 |= ( ( mask >> 1 ) & 1 ) << j;
+			bits2 |= ( ( mask >> 2 ) & 1 ) << j;
+			bits3 |= ( ( mask >> 3 ) & 1 ) << j;
+		}
+
+		cullBits[i+0] = (byte)bits0;
+		cullBits[i+1] = (byte)bits1;
+		cullBits[i+2] = (byte)bits2;
+		cullBits[i+3] = (byte)bits3;
+	}
+
+	if ( i < numBounds ) {
+		const float *tail[6];
+		for ( j = 0; j < 6; j++ ) {
+			tail[j] = bounds[j] + i;
+		}
+		idSIMD_Generic::CullBounds( cullBits + i, planes, numPlanes, tail, numBounds - i );
+	}
+}
+
+/*
+============
+idSIMD_SSE::DepthSpanMax
+============
+*/
+void VPCALL idSIMD_SSE::DepthSpanMax( float *depth, const float z, const float dz, const int count ) {
+	int i;
+
+	const __m128 vz = _mm_set_ps1( z );
+	const __m128 vdz = _mm_set_ps1( dz );
+	const __m128 four = _mm_set_ps1( 4.0f );
+	__m128 vi = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+
+	for ( i = 0; i < ( count & ~3 ); i += 4 ) {
+		// same operation order as the generic code so the results match
+		__m128 d = _mm_add_ps( vz, _mm_mul_ps( vi, vdz ) );
+		_mm_storeu_ps( depth + i, _mm_max_ps( _mm_loadu_ps( depth + i ), d ) );
+		vi = _mm_add_ps( vi, four );
+	}
+
+	for ( ; i < count; i++ ) {
+		float d = z + (float)i * dz;
+		if ( d > depth[i] ) {
+			depth[i] = d;
+		}
+	}
+}
+
+/*
+============
+idSIMD_SSE::DepthSpanTest
+============
+*/
+bool VPCALL idSIMD_SSE::DepthSpanTest( const float *depth, const float z, const int count ) {
+	int i;
+
+	const __m128 vz = _mm_set_ps1( z );
+
+	for ( i = 0; i < ( count & ~3 ); i += 4 ) {
+		if ( _mm_movemask_ps( _mm_cmple_ps( _mm_loadu_ps( depth + i ), vz ) ) ) {
+			return true;
+		}
+	}
+
+	for ( ; i < count; i++ ) {
+		if ( depth[i] <= z ) {
+			return true;
+		}
+	}
+	return false;
+}
+
 /*
 ============
 idSIMD_SSE::DeriveTriPlanes
@@ -15540,6 +15701,120 @@ void VPCALL idSIMD_SSE::NormalizeTangents( idDrawVert *verts, const int numVerts
 	}
 }
 
+/*
+============
+idSIMD_SSE::AutospriteVerts
+============
+*/
+void VPCALL idSIMD_SSE::AutospriteVerts( idDrawVert *verts, const idDrawVert *src, const int numVerts, const idVec3 &leftDir, const idVec3 &upDir ) {
+	ALIGN4_INIT4( unsigned long SIMD_DW_xyzMask, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0 );
+
+	assert( sizeof( idDrawVert ) == DRAWVERT_SIZE );
+	assert( (int)&((idDrawVert *)0)->xyz == DRAWVERT_XYZ_OFFSET );
+	assert( (int)&((idDrawVert *)0)->st == DRAWVERT_ST_OFFSET );
+
+	const __m128 xyzMask = _mm_load_ps( (const float *)SIMD_DW_xyzMask );
+	const __m128 quarter = _mm_set_ps1( 0.25f );
+	const __m128 invSqrt2 = _mm_set_ps1( 0.707f );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 vLeft = _mm_set_ps( 0.0f, leftDir.z, leftDir.y, leftDir.x );
+	const __m128 vUp = _mm_set_ps( 0.0f, upDir.z, upDir.y, upDir.x );
+
+	// the s texture coordinate goes into the fourth float after the xyz
+	const __m128 s0 = _mm_set_ps( 0.0f, 0.0f, 0.0f, 0.0f );
+	const __m128 s1 = _mm_set_ps( 1.0f, 0.0f, 0.0f, 0.0f );
+	// t and the normal
+	const __m128 t0 = _mm_set_ps( 0.0f, 0.0f, 0.0f, 0.0f );
+	const __m128 t1 = _mm_set_ps( 0.0f, 0.0f, 0.0f, 1.0f );
+
+	for ( int i = 0; i < numVerts - 3; i += 4 ) {
+		const float *v = src[i].xyz.ToFloatPtr();
+		float *dst = verts[i].xyz.ToFloatPtr();
+
+		__m128 p0 = _mm_and_ps( _mm_loadu_ps( v + 0 * DRAWVERT_SIZE / 4 ), xyzMask );
+		__m128 p1 = _mm_and_ps( _mm_loadu_ps( v + 1 * DRAWVERT_SIZE / 4 ), xyzMask );
+		__m128 p2 = _mm_and_ps( _mm_loadu_ps( v + 2 * DRAWVERT_SIZE / 4 ), xyzMask );
+		__m128 p3 = _mm_and_ps( _mm_loadu_ps( v + 3 * DRAWVERT_SIZE / 4 ), xyzMask );
+
+		__m128 mid = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_add_ps( p0, p1 ), p2 ), p3 ), quarter );
+
+		__m128 delta = _mm_sub_ps( p0, mid );
+		__m128 sqr = _mm_mul_ps( delta, delta );
+		__m128 len = _mm_add_ss( _mm_add_ss( sqr, _mm_shuffle_ps( sqr, sqr, R_SHUFFLEPS( 1, 1, 1, 1 ) ) ), _mm_shuffle_ps( sqr, sqr, R_SHUFFLEPS( 2, 2, 2, 2 ) ) );
+		__m128 radius = _mm_mul_ss( _mm_sqrt_ss( len ), invSqrt2 );
+		radius = _mm_shuffle_ps( radius, radius, R_SHUFFLEPS( 0, 0, 0, 0 ) );
+
+		__m128 left = _mm_mul_ps( vLeft, radius );
+		__m128 up = _mm_mul_ps( vUp, radius );
+
+		__m128 a = _mm_add_ps( mid, left );
+		__m128 b = _mm_sub_ps( mid, left );
+
+		// the fourth float is zero after the masked loads and takes the s
+		// xyz and s, t and normal, tangents, the last tangent and the color
+		_mm_storeu_ps( dst + 0 * DRAWVERT_SIZE / 4 + 0, _mm_or_ps( _mm_add_ps( a, up ), s0 ) );
+		_mm_storeu_ps( dst + 0 * DRAWVERT_SIZE / 4 + 4, t0 );
+		_mm_storeu_ps( dst + 0 * DRAWVERT_SIZE / 4 + 8, zero );
+		_mm_storel_pi( (__m64 *)( dst + 0 * DRAWVERT_SIZE / 4 + 12 ), zero );
+		_mm_store_ss( dst + 0 * DRAWVERT_SIZE / 4 + 14, zero );
+
+		_mm_storeu_ps( dst + 1 * DRAWVERT_SIZE / 4 + 0, _mm_or_ps( _mm_add_ps( b, up ), s1 ) );
+		_mm_storeu_ps( dst + 1 * DRAWVERT_SIZE / 4 + 4, t0 );
+		_mm_storeu_ps( dst + 1 * DRAWVERT_SIZE / 4 + 8, zero );
+		_mm_storel_pi( (__m64 *)( dst + 1 * DRAWVERT_SIZE / 4 + 12 ), zero );
+		_mm_store_ss( dst + 1 * DRAWVERT_SIZE / 4 + 14, zero );
+
+		_mm_storeu_ps( dst + 2 * DRAWVERT_SIZE / 4 + 0, _mm_or_ps( _mm_sub_ps( b, up ), s1 ) );
+		_mm_storeu_ps( dst + 2 * DRAWVERT_SIZE / 4 + 4, t1 );
+		_mm_storeu_ps( dst + 2 * DRAWVERT_SIZE / 4 + 8, zero );
+		_mm_storel_pi( (__m64 *)( dst + 2 * DRAWVERT_SIZE / 4 + 12 ), zero );
+		_mm_store_ss( dst + 2 * DRAWVERT_SIZE / 4 + 14, zero );
+
+		_mm_storeu_ps( dst + 3 * DRAWVERT_SIZE / 4 + 0, _mm_or_ps( _mm_sub_ps( a, up ), s0 ) );
+		_mm_storeu_ps( dst + 3 * DRAWVERT_SIZE / 4 + 4, t1 );
+		_mm_storeu_ps( dst + 3 * DRAWVERT_SIZE / 4 + 8, zero );
+		_mm_storel_pi( (__m64 *)( dst + 3 * DRAWVERT_SIZE / 4 + 12 ), zero );
+		_mm_store_ss( dst + 3 * DRAWVERT_SIZE / 4 + 14, zero );
+	}
+}
+
+/*
+============
+idSIMD_SSE::ParticleQuads
+============
+*/
+void VPCALL idSIMD_SSE::ParticleQuads( idDrawVert *verts, const idVec3 *quads, const int numQuads ) {
+
+	assert( sizeof( idDrawVert ) == DRAWVERT_SIZE );
+	assert( (int)&((idDrawVert *)0)->xyz == DRAWVERT_XYZ_OFFSET );
+
+	for ( int i = 0; i < numQuads; i++ ) {
+		const float *q = quads[i*3].ToFloatPtr();
+		float *dst = verts[i*4].xyz.ToFloatPtr();
+
+		// the fourth floats of the origin and left are not used, up is loaded without reading past the quads
+		__m128 origin = _mm_loadu_ps( q + 0 );
+		__m128 left = _mm_loadu_ps( q + 3 );
+		__m128 up = _mm_shuffle_ps( _mm_loadl_pi( _mm_setzero_ps(), (const __m64 *)( q + 6 ) ), _mm_load_ss( q + 8 ), R_SHUFFLEPS( 0, 1, 0, 1 ) );
+
+		__m128 a = _mm_sub_ps( origin, left );
+		__m128 b = _mm_add_ps( origin, left );
+		__m128 p0 = _mm_add_ps( a, up );
+		__m128 p1 = _mm_add_ps( b, up );
+		__m128 p2 = _mm_sub_ps( a, up );
+		__m128 p3 = _mm_sub_ps( b, up );
+
+		_mm_storel_pi( (__m64 *)( dst + 0 * DRAWVERT_SIZE / 4 ), p0 );
+		_mm_store_ss( dst + 0 * DRAWVERT_SIZE / 4 + 2, _mm_movehl_ps( p0, p0 ) );
+		_mm_storel_pi( (__m64 *)( dst + 1 * DRAWVERT_SIZE / 4 ), p1 );
+		_mm_store_ss( dst + 1 * DRAWVERT_SIZE / 4 + 2, _mm_movehl_ps( p1, p1 ) );
+		_mm_storel_pi( (__m64 *)( dst + 2 * DRAWVERT_SIZE / 4 ), p2 );
+		_mm_store_ss( dst + 2 * DRAWVERT_SIZE / 4 + 2, _mm_movehl_ps( p2, p2 ) );
+		_mm_storel_pi( (__m64 *)( dst + 3 * DRAWVERT_SIZE / 4 ), p3 );
+		_mm_store_ss( dst + 3 * DRAWVERT_SIZE / 4 + 2, _mm_movehl_ps( p3, p3 ) );
+	}
+}
+
 /*
 ============
 idSIMD_SSE::CreateTextureSpaceLightVectors
@@ -247,6 +247,7 @@ void VPCALL idSIMD_SSE2::CmpLT( byte *dst, const byte bitNum, const float *src0,
 #elif defined(_WIN32)
 
 #include <xmmintrin.h>
+#include <emmintrin.h>
 
 #define SHUFFLEPS( x, y, z, w )		(( (x) & 3 ) << 6 | ( (y) & 3 ) << 4 | ( (z) & 3 ) << 2 | ( (w) & 3 ))
 #define R_SHUFFLEPS( x, y, z, w )	(( (w) & 3 ) << 6 | ( (z) & 3 ) << 4 | ( (y) & 3 ) << 2 | ( (x) & 3 ))
@@ -874,4 +875,121 @@ void VPCALL idSIMD_SSE2::MixedSoundToSamples( short *samples, const float *mixBu
 	}
 }
 
+/*
+============
+idSIMD_SSE2::MipMapRow
+============
+*/
+void VPCALL idSIMD_SSE2::MipMapRow( byte *dst, const byte *src0, const byte *src1, const int count ) {
+	int i;
+	__m128i zero = _mm_setzero_si128();
+
+	// four destination texels from eight texels of both source rows
+	for ( i = 0; i + 4 <= count; i += 4 ) {
+		__m128i r0a = _mm_loadu_si128( (const __m128i *)( src0 + i * 8 + 0 ) );
+		__m128i r0b = _mm_loadu_si128( (const __m128i *)( src0 + i * 8 + 16 ) );
+		__m128i r1a = _mm_loadu_si128( (const __m128i *)( src1 + i * 8 + 0 ) );
+		__m128i r1b = _mm_loadu_si128( (const __m128i *)( src1 + i * 8 + 16 ) );
+
+		// vertical sums of the source texels as words, two texels per register
+		__m128i s01 = _mm_add_epi16( _mm_unpacklo_epi8( r0a, zero ), _mm_unpacklo_epi8( r1a, zero ) );
+		__m128i s23 = _mm_add_epi16( _mm_unpackhi_epi8( r0a, zero ), _mm_unpackhi_epi8( r1a, zero ) );
+		__m128i s45 = _mm_add_epi16( _mm_unpacklo_epi8( r0b, zero ), _mm_unpacklo_epi8( r1b, zero ) );
+		__m128i s67 = _mm_add_epi16( _mm_unpackhi_epi8( r0b, zero ), _mm_unpackhi_epi8( r1b, zero ) );
+
+		// add the horizontal neighbours
+		__m128i d01 = _mm_add_epi16( _mm_unpacklo_epi64( s01, s23 ), _mm_unpackhi_epi64( s01, s23 ) );
+		__m128i d23 = _mm_add_epi16( _mm_unpacklo_epi64( s45, s67 ), _mm_unpackhi_epi64( s45, s67 ) );
+
+		d01 = _mm_srli_epi16( d01, 2 );
+		d23 = _mm_srli_epi16( d23, 2 );
+
+		_mm_storeu_si128( (__m128i *)( dst + i * 4 ), _mm_packus_epi16( d01, d23 ) );
+	}
+
+	if ( i < count ) {
+		idSIMD_Generic::MipMapRow( dst + i * 4, src0 + i * 8, src1 + i * 8, count - i );
+	}
+}
+
+/*
+============
+idSIMD_SSE2::MipMapRow3D
+============
+*/
+void VPCALL idSIMD_SSE2::MipMapRow3D( byte *dst, const byte *src0, const byte *src1, const byte *src2, const byte *src3, const int count ) {
+	int i;
+	__m128i zero = _mm_setzero_si128();
+
+	for ( i = 0; i + 4 <= count; i += 4 ) {
+		__m128i r0a = _mm_loadu_si128( (const __m128i *)( src0 + i * 8 + 0 ) );
+		__m128i r0b = _mm_loadu_si128( (const __m128i *)( src0 + i * 8 + 16 ) );
+		__m128i r1a = _mm_loadu_si128( (const __m128i *)( src1 + i * 8 + 0 ) );
+		__m128i r1b = _mm_loadu_si128( (const __m128i *)( src1 + i * 8 + 16 ) );
+		__m128i r2a = _mm_loadu_si128( (const __m128i *)( src2 + i * 8 + 0 ) );
+		__m128i r2b = _mm_loadu_si128( (const __m128i *)( src2 + i * 8 + 16 ) );
+		__m128i r3a = _mm_loadu_si128( (const __m128i *)( src3 + i * 8 + 0 ) );
+		__m128i r3b = _mm_loadu_si128( (const __m128i *)( src3 + i * 8 + 16 ) );
+
+		// the sum of eight bytes still fits in a word
+		__m128i s01 = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( r0a, zero ), _mm_unpacklo_epi8( r1a, zero ) ),
+									_mm_add_epi16( _mm_unpacklo_epi8( r2a, zero ), _mm_unpacklo_epi8( r3a, zero ) ) );
+		__m128i s23 = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( r0a, zero ), _mm_unpackhi_epi8( r1a, zero ) ),
+									_mm_add_epi16( _mm_unpackhi_epi8( r2a, zero ), _mm_unpackhi_epi8( r3a, zero ) ) );
+		__m128i s45 = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( r0b, zero ), _mm_unpacklo_epi8( r1b, zero ) ),
+									_mm_add_epi16( _mm_unpacklo_epi8( r2b, zero ), _mm_unpacklo_epi8( r3b, zero ) ) );
+		__m128i s67 = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( r0b, zero ), _mm_unpackhi_epi8( r1b, zero ) ),
+									_mm_add_epi16( _mm_unpackhi_epi8( r2b, zero ), _mm_unpackhi_epi8( r3b, zero ) ) );
+
+		__m128i d01 = _mm_add_epi16( _mm_unpacklo_epi64( s01, s23 ), _mm_unpackhi_epi64( s01, s23 ) );
+		__m128i d23 = _mm_add_epi16( _mm_unpacklo_epi64( s45, s67 ), _mm_unpackhi_epi64( s45, s67 ) );
+
+		d01 = _mm_srli_epi16( d01, 3 );
+		d23 = _mm_srli_epi16( d23, 3 );
+
+		_mm_storeu_si128( (__m128i *)( dst + i * 4 ), _mm_packus_epi16( d01, d23 ) );
+	}
+
+	if ( i < count ) {
+		idSIMD_Generic::MipMapRow3D( dst + i * 4, src0 + i * 8, src1 + i * 8, src2 + i * 8, src3 + i * 8, count - i );
+	}
+}
+
+/*
+============
+idSIMD_SSE2::ResampleRow
+============
+*/
+#define GATHER_TEXELS( src, offsets )		_mm_setr_epi32( *(const int *)( (src) + (offsets)[0] ), *(const int *)( (src) + (offsets)[1] ), \
+													*(const int *)( (src) + (offsets)[2] ), *(const int *)( (src) + (offsets)[3] ) )
+
+void VPCALL idSIMD_SSE2::ResampleRow( byte *dst, const byte *src0, const byte *src1, const unsigned int *offsets0, const unsigned int *offsets1, const int count ) {
+	int i;
+	__m128i zero = _mm_setzero_si128();
+
+	// there is no gather, the texels are picked up one by one and filtered four at a time
+	for ( i = 0; i + 4 <= count; i += 4 ) {
+		__m128i p1 = GATHER_TEXELS( src0, offsets0 + i );
+		__m128i p2 = GATHER_TEXELS( src0, offsets1 + i );
+		__m128i p3 = GATHER_TEXELS( src1, offsets0 + i );
+		__m128i p4 = GATHER_TEXELS( src1, offsets1 + i );
+
+		__m128i d01 = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( p1, zero ), _mm_unpacklo_epi8( p2, zero ) ),
+									_mm_add_epi16( _mm_unpacklo_epi8( p3, zero ), _mm_unpacklo_epi8( p4, zero ) ) );
+		__m128i d23 = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( p1, zero ), _mm_unpackhi_epi8( p2, zero ) ),
+									_mm_add_epi16( _mm_unpackhi_epi8( p3, zero ), _mm_unpackhi_epi8( p4, zero ) ) );
+
+		d01 = _mm_srli_epi16( d01, 2 );
+		d23 = _mm_srli_epi16( d23, 2 );
+
+		_mm_storeu_si128( (__m128i *)( dst + i * 4 ), _mm_packus_epi16( d01, d23 ) );
+	}
+
+	if ( i < count ) {
+		idSIMD_Generic::ResampleRow( dst + i * 4, src0, src1, offsets0 + i, offsets1 + i, count - i );
+	}
+}
+
+#undef GATHER_TEXELS
+
 #endif /* _WIN32 */
@@ -51,6 +51,10 @@ public:
 
 	virtual void VPCALL MixedSoundToSamples( short *samples, const float *mixBuffer, const int numSamples );
 
+	virtual void VPCALL MipMapRow( byte *dst, const byte *src0, const byte *src1, const int count );
+	virtual void VPCALL MipMapRow3D( byte *dst, const byte *src0, const byte *src1, const byte *src2, const byte *src3, const int count );
+	virtual void VPCALL ResampleRow( byte *dst, const byte *src0, const byte *src1, const unsigned int *offsets0, const unsigned int *offsets1, const int count );
+
 #endif
 };
 
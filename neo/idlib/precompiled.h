@@ -195,6 +195,8 @@ const int MAX_EXPRESSION_REGISTERS = 4096;
 #include "../framework/Console.h"
 #include "../framework/DemoFile.h"
 #include "../framework/Session.h"
+#include "../framework/ParallelJobList.h"
+#include "../framework/LoadStats.h"
 
 // asynchronous networking
 #include "../framework/async/AsyncNetwork.h"
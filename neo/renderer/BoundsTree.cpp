@@ -0,0 +1,541 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+/*
+================
+idBoundsTree::idBoundsTree
+================
+*/
+idBoundsTree::idBoundsTree( void ) {
+	nodes = NULL;
+	numNodes = 0;
+	maxNodes = 0;
+	freeNode = 0;
+	root = 0;
+	numProxies = 0;
+}
+
+/*
+================
+idBoundsTree::~idBoundsTree
+================
+*/
+idBoundsTree::~idBoundsTree( void ) {
+	Clear();
+}
+
+/*
+================
+idBoundsTree::Clear
+================
+*/
+void idBoundsTree::Clear( void ) {
+	Mem_Free( nodes );
+	nodes = NULL;
+	numNodes = 0;
+	maxNodes = 0;
+	freeNode = 0;
+	root = 0;
+	numProxies = 0;
+}
+
+/*
+================
+idBoundsTree::Cost
+
+The surface area, which is proportional to the chance that a random query hits the bounds.
+================
+*/
+float idBoundsTree::Cost( const idBounds &bounds ) {
+	idVec3 d = bounds[1] - bounds[0];
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+/*
+================
+idBoundsTree::AllocNode
+================
+*/
+int idBoundsTree::AllocNode( void ) {
+	int i, node;
+
+	if ( numNodes == maxNodes ) {
+		int newMaxNodes = maxNodes ? maxNodes * 2 : 16;
+		boundsTreeNode_t *newNodes = (boundsTreeNode_t *)Mem_Alloc( newMaxNodes * sizeof( nodes[0] ) );
+		if ( nodes ) {
+			memcpy( newNodes, nodes, maxNodes * sizeof( nodes[0] ) );
+			Mem_Free( nodes );
+		}
+		nodes = newNodes;
+		for ( i = maxNodes; i < newMaxNodes; i++ ) {
+			nodes[i].parent = i + 1;
+			nodes[i].height = -1;
+		}
+		nodes[newMaxNodes - 1].parent = -1;
+		freeNode = maxNodes;
+		maxNodes = newMaxNodes;
+	}
+
+	node = freeNode;
+	freeNode = nodes[node].parent;
+	nodes[node].owner = NULL;
+	nodes[node].parent = -1;
+	nodes[node].children[0] = -1;
+	nodes[node].children[1] = -1;
+	nodes[node].height = 0;
+	numNodes++;
+
+	return node;
+}
+
+/*
+================
+idBoundsTree::FreeNode
+================
+*/
+void idBoundsTree::FreeNode( int node ) {
+	assert( node >= 0 && node < maxNodes && nodes[node].height >= 0 );
+
+	nodes[node].parent = freeNode;
+	nodes[node].height = -1;
+	freeNode = node;
+	numNodes--;
+}
+
+/*
+================
+idBoundsTree::AddProxy
+================
+*/
+int idBoundsTree::AddProxy( const idBounds &bounds, void *owner ) {
+	int leaf;
+
+	assert( owner != NULL );
+
+	if ( numProxies == 0 ) {
+		root = -1;
+	}
+
+	leaf = AllocNode();
+	nodes[leaf].bounds = bounds;
+	nodes[leaf].owner = owner;
+
+	InsertLeaf( leaf );
+	numProxies++;
+
+	return leaf;
+}
+
+/*
+================
+idBoundsTree::RemoveProxy
+================
+*/
+void idBoundsTree::RemoveProxy( int proxy ) {
+	assert( proxy >= 0 && proxy < maxNodes && nodes[proxy].owner != NULL );
+
+	RemoveLeaf( proxy );
+	FreeNode( proxy );
+	numProxies--;
+}
+
+/*
+================
+idBoundsTree::InsertLeaf
+================
+*/
+void idBoundsTree::InsertLeaf( int leaf ) {
+	int node, sibling, oldParent, newParent, child0, child1;
+	float cost, inheritCost, cost0, cost1;
+	idBounds combined;
+
+	if ( root == -1 ) {
+		root = leaf;
+		nodes[leaf].parent = -1;
+		return;
+	}
+
+	const idBounds &leafBounds = nodes[leaf].bounds;
+
+	// descend to the node where the leaf is the cheapest sibling
+	node = root;
+	while ( nodes[node].children[0] != -1 ) {
+		child0 = nodes[node].children[0];
+		child1 = nodes[node].children[1];
+
+		combined = nodes[node].bounds;
+		combined.AddBounds( leafBounds );
+
+		// cost of making a new parent for this node and the leaf
+		cost = 2.0f * Cost( combined );
+
+		// minimum cost of pushing the leaf further down the tree
+		inheritCost = 2.0f * ( Cost( combined ) - Cost( nodes[node].bounds ) );
+
+		combined = nodes[child0].bounds;
+		combined.AddBounds( leafBounds );
+		cost0 = Cost( combined ) + inheritCost;
+		if ( nodes[child0].children[0] != -1 ) {
+			cost0 -= Cost( nodes[child0].bounds );
+		}
+
+		combined = nodes[child1].bounds;
+		combined.AddBounds( leafBounds );
+		cost1 = Cost( combined ) + inheritCost;
+		if ( nodes[child1].children[0] != -1 ) {
+			cost1 -= Cost( nodes[child1].bounds );
+		}
+
+		if ( cost < cost0 && cost < cost1 ) {
+			break;
+		}
+
+		node = ( cost0 < cost1 ) ? child0 : child1;
+	}
+	sibling = node;
+
+	// create a new parent for the sibling and the leaf
+	oldParent = nodes[sibling].parent;
+	newParent = AllocNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].bounds = nodes[sibling].bounds;
+	nodes[newParent].bounds.AddBounds( nodes[leaf].bounds );
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].children[0] = sibling;
+	nodes[newParent].children[1] = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if ( oldParent != -1 ) {
+		if ( nodes[oldParent].children[0] == sibling ) {
+			nodes[oldParent].children[0] = newParent;
+		} else {
+			nodes[oldParent].children[1] = newParent;
+		}
+	} else {
+		root = newParent;
+	}
+
+	// refit and rebalance the ancestors
+	for ( node = nodes[leaf].parent; node != -1; node = nodes[node].parent ) {
+		node = Balance( node );
+
+		child0 = nodes[node].children[0];
+		child1 = nodes[node].children[1];
+
+		nodes[node].height = 1 + Max( nodes[child0].height, nodes[child1].height );
+		nodes[node].bounds = nodes[child0].bounds;
+		nodes[node].bounds.AddBounds( nodes[child1].bounds );
+	}
+}
+
+/*
+================
+idBoundsTree::RemoveLeaf
+================
+*/
+void idBoundsTree::RemoveLeaf( int leaf ) {
+	int node, parent, grandParent, sibling, child0, child1;
+
+	if ( leaf == root ) {
+		root = -1;
+		return;
+	}
+
+	parent = nodes[leaf].parent;
+	grandParent = nodes[parent].parent;
+	sibling = ( nodes[parent].children[0] == leaf ) ? nodes[parent].children[1] : nodes[parent].children[0];
+
+	// the sibling takes the place of the parent
+	FreeNode( parent );
+	if ( grandParent == -1 ) {
+		root = sibling;
+		nodes[sibling].parent = -1;
+		return;
+	}
+
+	if ( nodes[grandParent].children[0] == parent ) {
+		nodes[grandParent].children[0] = sibling;
+	} else {
+		nodes[grandParent].children[1] = sibling;
+	}
+	nodes[sibling].parent = grandParent;
+
+	// refit and rebalance the ancestors
+	for ( node = grandParent; node != -1; node = nodes[node].parent ) {
+		node = Balance( node );
+
+		child0 = nodes[node].children[0];
+		child1 = nodes[node].children[1];
+
+		nodes[node].height = 1 + Max( nodes[child0].height, nodes[child1].height );
+		nodes[node].bounds = nodes[child0].bounds;
+		nodes[node].bounds.AddBounds( nodes[child1].bounds );
+	}
+}
+
+/*
+================
+idBoundsTree::Balance
+
+If one subtree of the node is more than one level higher than the other,
+the higher child is rotated up.  Returns the node that took the place of
+the given node.
+================
+*/
+int idBoundsTree::Balance( int a ) {
+	int b, c, f, g, d, e, balance;
+
+	if ( nodes[a].children[0] == -1 || nodes[a].height < 2 ) {
+		return a;
+	}
+
+	b = nodes[a].children[0];
+	c = nodes[a].children[1];
+	balance = nodes[c].height - nodes[b].height;
+
+	// rotate c up
+	if ( balance > 1 ) {
+		f = nodes[c].children[0];
+		g = nodes[c].children[1];
+
+		// swap a and c
+		nodes[c].children[0] = a;
+		nodes[c].parent = nodes[a].parent;
+		nodes[a].parent = c;
+
+		if ( nodes[c].parent != -1 ) {
+			if ( nodes[nodes[c].parent].children[0] == a ) {
+				nodes[nodes[c].parent].children[0] = c;
+			} else {
+				nodes[nodes[c].parent].children[1] = c;
+			}
+		} else {
+			root = c;
+		}
+
+		// the higher child of c stays with c, the other goes to a
+		if ( nodes[f].height > nodes[g].height ) {
+			nodes[c].children[1] = f;
+			nodes[a].children[1] = g;
+			nodes[g].parent = a;
+		} else {
+			nodes[c].children[1] = g;
+			nodes[a].children[1] = f;
+			nodes[f].parent = a;
+		}
+
+		nodes[a].bounds = nodes[b].bounds;
+		nodes[a].bounds.AddBounds( nodes[nodes[a].children[1]].bounds );
+		nodes[a].height = 1 + Max( nodes[b].height, nodes[nodes[a].children[1]].height );
+
+		nodes[c].bounds = nodes[a].bounds;
+		nodes[c].bounds.AddBounds( nodes[nodes[c].children[1]].bounds );
+		nodes[c].height = 1 + Max( nodes[a].height, nodes[nodes[c].children[1]].height );
+
+		return c;
+	}
+
+	// rotate b up
+	if ( balance < -1 ) {
+		d = nodes[b].children[0];
+		e = nodes[b].children[1];
+
+		// swap a and b
+		nodes[b].children[0] = a;
+		nodes[b].parent = nodes[a].parent;
+		nodes[a].parent = b;
+
+		if ( nodes[b].parent != -1 ) {
+			if ( nodes[nodes[b].parent].children[0] == a ) {
+				nodes[nodes[b].parent].children[0] = b;
+			} else {
+				nodes[nodes[b].parent].children[1] = b;
+			}
+		} else {
+			root = b;
+		}
+
+		// the higher child of b stays with b, the other goes to a
+		if ( nodes[d].height > nodes[e].height ) {
+			nodes[b].children[1] = d;
+			nodes[a].children[0] = e;
+			nodes[e].parent = a;
+		} else {
+			nodes[b].children[1] = e;
+			nodes[a].children[0] = d;
+			nodes[d].parent = a;
+		}
+
+		nodes[a].bounds = nodes[nodes[a].children[0]].bounds;
+		nodes[a].bounds.AddBounds( nodes[c].bounds );
+		nodes[a].height = 1 + Max( nodes[nodes[a].children[0]].height, nodes[c].height );
+
+		nodes[b].bounds = nodes[a].bounds;
+		nodes[b].bounds.AddBounds( nodes[nodes[b].children[1]].bounds );
+		nodes[b].height = 1 + Max( nodes[a].height, nodes[nodes[b].children[1]].height );
+
+		return b;
+	}
+
+	return a;
+}
+
+/*
+================
+idBoundsTree::GetHeight
+================
+*/
+int idBoundsTree::GetHeight( void ) const {
+	if ( numProxies == 0 ) {
+		return 0;
+	}
+	return nodes[root].height;
+}
+
+/*
+================
+idBoundsTree::ProxiesTouchingBounds
+================
+*/
+int idBoundsTree::ProxiesTouchingBounds( const idBounds &bounds, void **owners, int maxCount ) const {
+	int stack[BOUNDS_TREE_MAX_STACK];
+	int stackSize, node, count;
+
+	if ( numProxies == 0 ) {
+		return 0;
+	}
+
+	count = 0;
+	stack[0] = root;
+	stackSize = 1;
+
+	while ( stackSize > 0 ) {
+		node = stack[--stackSize];
+
+		if ( !nodes[node].bounds.IntersectsBounds( bounds ) ) {
+			continue;
+		}
+
+		if ( nodes[node].children[0] == -1 ) {
+			if ( count >= maxCount ) {
+				common->Warning( "idBoundsTree::ProxiesTouchingBounds: max count" );
+				return count;
+			}
+			owners[count++] = nodes[node].owner;
+			continue;
+		}
+
+		assert( stackSize + 2 <= BOUNDS_TREE_MAX_STACK );
+		stack[stackSize++] = nodes[node].children[1];
+		stack[stackSize++] = nodes[node].children[0];
+	}
+
+	return count;
+}
+
+/*
+================
+idBoundsTree::ProxiesTouchingPlanes
+
+Every stack entry keeps the planes its bounds are not completely behind, once a
+subtree is behind all planes its leaves are added without any further tests.
+================
+*/
+int idBoundsTree::ProxiesTouchingPlanes( const idPlane *planes, int numPlanes, void **owners, int maxCount ) const {
+	int stack[BOUNDS_TREE_MAX_STACK];
+	int stackMask[BOUNDS_TREE_MAX_STACK];
+	int stackSize, node, mask, count, i;
+	float d, r;
+	idVec3 center, extents;
+
+	assert( numPlanes <= 31 );
+
+	if ( numProxies == 0 ) {
+		return 0;
+	}
+
+	count = 0;
+	stack[0] = root;
+	stackMask[0] = ( numPlanes > 0 ) ? ( 1 << numPlanes ) - 1 : 0;
+	stackSize = 1;
+
+	while ( stackSize > 0 ) {
+		stackSize--;
+		node = stack[stackSize];
+		mask = stackMask[stackSize];
+
+		if ( mask ) {
+			const idBounds &b = nodes[node].bounds;
+			center = ( b[0] + b[1] ) * 0.5f;
+			extents = b[1] - center;
+
+			for ( i = 0; i < numPlanes; i++ ) {
+				if ( !( mask & ( 1 << i ) ) ) {
+					continue;
+				}
+				const idPlane &p = planes[i];
+				d = p.Distance( center );
+				r = idMath::Fabs( p[0] ) * extents[0] + idMath::Fabs( p[1] ) * extents[1] + idMath::Fabs( p[2] ) * extents[2];
+				if ( d - r > 0.0f ) {
+					break;		// completely at the front of the plane
+				}
+				if ( d + r <= 0.0f ) {
+					mask &= ~( 1 << i );
+				}
+			}
+			if ( i < numPlanes ) {
+				continue;
+			}
+		}
+
+		if ( nodes[node].children[0] == -1 ) {
+			if ( count >= maxCount ) {
+				common->Warning( "idBoundsTree::ProxiesTouchingPlanes: max count" );
+				return count;
+			}
+			owners[count++] = nodes[node].owner;
+			continue;
+		}
+
+		assert( stackSize + 2 <= BOUNDS_TREE_MAX_STACK );
+		stack[stackSize] = nodes[node].children[1];
+		stackMask[stackSize] = mask;
+		stackSize++;
+		stack[stackSize] = nodes[node].children[0];
+		stackMask[stackSize] = mask;
+		stackSize++;
+	}
+
+	return count;
+}
@@ -0,0 +1,99 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __BOUNDSTREE_H__
+#define __BOUNDSTREE_H__
+
+/*
+===============================================================================
+
+	Dynamic bounding volume tree.
+
+	Every proxy is a leaf with a bounds and an owner pointer, the inner nodes
+	bound their two children.  New leaves are put next to the sibling that
+	grows the surface area of the tree the least, and the ancestors of an
+	added or removed leaf are refit and rebalanced with tree rotations, so
+	the height stays logarithmic however the proxies are added or moved.
+
+	Node zero is not special and all zero bytes is a valid empty tree, so a
+	tree can be part of memory that is cleared instead of constructed.
+
+===============================================================================
+*/
+
+const int BOUNDS_TREE_MAX_STACK		= 64;		// enough for any balanced tree that fits in memory
+
+typedef struct {
+	idBounds				bounds;
+	void *					owner;				// NULL for inner nodes
+	int						parent;				// next free node while on the free list
+	int						children[2];		// -1 for leaves
+	int						height;				// 0 for leaves, -1 while on the free list
+} boundsTreeNode_t;
+
+class idBoundsTree {
+public:
+							idBoundsTree( void );
+							~idBoundsTree( void );
+
+							// frees all nodes, the handles of all proxies become invalid
+	void					Clear( void );
+
+							// returns a handle which stays valid until the proxy is removed
+	int						AddProxy( const idBounds &bounds, void *owner );
+	void					RemoveProxy( int proxy );
+
+	const idBounds &		GetProxyBounds( int proxy ) const { return nodes[proxy].bounds; }
+	void *					GetProxyOwner( int proxy ) const { return nodes[proxy].owner; }
+	int						NumProxies( void ) const { return numProxies; }
+	int						GetHeight( void ) const;
+	int						MemoryUsed( void ) const { return maxNodes * sizeof( nodes[0] ); }
+
+							// the owners of all proxies that touch the bounds
+	int						ProxiesTouchingBounds( const idBounds &bounds, void **owners, int maxCount ) const;
+							// the owners of all proxies that are not completely at
+							// the front of one of the planes, the planes face out
+	int						ProxiesTouchingPlanes( const idPlane *planes, int numPlanes, void **owners, int maxCount ) const;
+
+private:
+	boundsTreeNode_t *		nodes;
+	int						numNodes;
+	int						maxNodes;
+	int						freeNode;
+	int						root;
+	int						numProxies;
+
+	int						AllocNode( void );
+	void					FreeNode( int node );
+	void					InsertLeaf( int leaf );
+	void					RemoveLeaf( int leaf );
+	int						Balance( int node );
+	static float			Cost( const idBounds &bounds );
+};
+
+#endif /* !__BOUNDSTREE_H__ */
@@ -0,0 +1,347 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+static const int	BUFFER_ALLOC_ALIGN_SHIFT = 4;
+static const int	BUFFER_ALLOC_SMALL_SIZE = 1 << ( BUFFER_ALLOC_SL_BITS + BUFFER_ALLOC_ALIGN_SHIFT );
+
+/*
+================
+BufferAlloc_LowestBit
+================
+*/
+static ID_INLINE int BufferAlloc_LowestBit( unsigned int bits ) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward( &index, bits );
+	return index;
+#else
+	return __builtin_ctz( bits );
+#endif
+}
+
+/*
+================
+BufferAlloc_HighestBit
+================
+*/
+static ID_INLINE int BufferAlloc_HighestBit( unsigned int bits ) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse( &index, bits );
+	return index;
+#else
+	return 31 - __builtin_clz( bits );
+#endif
+}
+
+/*
+================
+idBufferAllocator::idBufferAllocator
+================
+*/
+idBufferAllocator::idBufferAllocator( void ) {
+	size = 0;
+	allocatedBytes = 0;
+	numAllocs = 0;
+	numFreeRanges = 0;
+	flBitmap = 0;
+	memset( slBitmap, 0, sizeof( slBitmap ) );
+	memset( freeLists, 0, sizeof( freeLists ) );
+	ranges = NULL;
+}
+
+/*
+================
+idBufferAllocator::~idBufferAllocator
+================
+*/
+idBufferAllocator::~idBufferAllocator( void ) {
+	Shutdown();
+}
+
+/*
+================
+idBufferAllocator::Init
+================
+*/
+void idBufferAllocator::Init( int size ) {
+	Shutdown();
+
+	assert( size > 0 && ( size & ( BUFFER_ALLOC_ALIGN - 1 ) ) == 0 );
+	assert( size <= ( 1 << 30 ) );
+
+	this->size = size;
+
+	ranges = rangeAllocator.Alloc();
+	ranges->offset = 0;
+	ranges->size = size;
+	ranges->owner = NULL;
+	ranges->prevPhys = ranges->nextPhys = NULL;
+	InsertFree( ranges );
+}
+
+/*
+================
+idBufferAllocator::Shutdown
+================
+*/
+void idBufferAllocator::Shutdown( void ) {
+	rangeAllocator.Shutdown();
+
+	size = 0;
+	allocatedBytes = 0;
+	numAllocs = 0;
+	numFreeRanges = 0;
+	flBitmap = 0;
+	memset( slBitmap, 0, sizeof( slBitmap ) );
+	memset( freeLists, 0, sizeof( freeLists ) );
+	ranges = NULL;
+}
+
+/*
+================
+idBufferAllocator::Mapping
+
+Returns the size class of a range, sizes below BUFFER_ALLOC_SMALL_SIZE all
+go to the first level and are split linearly
+================
+*/
+void idBufferAllocator::Mapping( int size, int &fl, int &sl ) {
+	if ( size < BUFFER_ALLOC_SMALL_SIZE ) {
+		fl = 0;
+		sl = size >> BUFFER_ALLOC_ALIGN_SHIFT;
+	} else {
+		int t = BufferAlloc_HighestBit( size );
+		fl = t - ( BUFFER_ALLOC_SL_BITS + BUFFER_ALLOC_ALIGN_SHIFT ) + 1;
+		sl = ( size >> ( t - BUFFER_ALLOC_SL_BITS ) ) - BUFFER_ALLOC_SL_COUNT;
+	}
+}
+
+/*
+================
+idBufferAllocator::InsertFree
+================
+*/
+void idBufferAllocator::InsertFree( bufferRange_t *range ) {
+	int fl, sl;
+
+	Mapping( range->size, fl, sl );
+
+	range->free = true;
+	range->prevFree = NULL;
+	range->nextFree = freeLists[fl][sl];
+	if ( range->nextFree ) {
+		range->nextFree->prevFree = range;
+	}
+	freeLists[fl][sl] = range;
+
+	flBitmap |= 1 << fl;
+	slBitmap[fl] |= 1 << sl;
+	numFreeRanges++;
+}
+
+/*
+================
+idBufferAllocator::RemoveFree
+================
+*/
+void idBufferAllocator::RemoveFree( bufferRange_t *range ) {
+	int fl, sl;
+
+	Mapping( range->size, fl, sl );
+
+	if ( range->prevFree ) {
+		range->prevFree->nextFree = range->nextFree;
+	} else {
+		freeLists[fl][sl] = range->nextFree;
+		if ( !freeLists[fl][sl] ) {
+			slBitmap[fl] &= ~( 1 << sl );
+			if ( !slBitmap[fl] ) {
+				flBitmap &= ~( 1 << fl );
+			}
+		}
+	}
+	if ( range->nextFree ) {
+		range->nextFree->prevFree = range->prevFree;
+	}
+
+	range->free = false;
+	range->prevFree = range->nextFree = NULL;
+	numFreeRanges--;
+}
+
+/*
+================
+idBufferAllocator::FindFree
+
+The size is rounded up to the next size class, so any range on the first
+non-empty list found by the bitmaps fits.  If there is none, the ranges in
+the class of the size itself are searched, they may still be large enough.
+================
+*/
+bufferRange_t *idBufferAllocator::FindFree( int size ) {
+	int fl, sl;
+
+	int search = size;
+	if ( search >= BUFFER_ALLOC_SMALL_SIZE ) {
+		search += ( 1 << ( BufferAlloc_HighestBit( search ) - BUFFER_ALLOC_SL_BITS ) ) - 1;
+	}
+	Mapping( search, fl, sl );
+
+	if ( fl < BUFFER_ALLOC_FL_COUNT ) {
+		unsigned int slMap = slBitmap[fl] & ( ~0u << sl );
+		if ( !slMap ) {
+			unsigned int flMap = ( fl + 1 < BUFFER_ALLOC_FL_COUNT ) ? flBitmap & ( ~0u << ( fl + 1 ) ) : 0;
+			if ( flMap ) {
+				fl = BufferAlloc_LowestBit( flMap );
+				slMap = slBitmap[fl];
+			}
+		}
+		if ( slMap ) {
+			return freeLists[fl][BufferAlloc_LowestBit( slMap )];
+		}
+	}
+
+	Mapping( size, fl, sl );
+	for ( bufferRange_t *range = freeLists[fl][sl]; range; range = range->nextFree ) {
+		if ( range->size >= size ) {
+			return range;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+================
+idBufferAllocator::Alloc
+================
+*/
+bufferRange_t *idBufferAllocator::Alloc( int size ) {
+	if ( size <= 0 || size > this->size ) {
+		return NULL;
+	}
+
+	size = ( size + BUFFER_ALLOC_ALIGN - 1 ) & ~( BUFFER_ALLOC_ALIGN - 1 );
+
+	bufferRange_t *range = FindFree( size );
+	if ( !range ) {
+		return NULL;
+	}
+
+	RemoveFree( range );
+
+	// split off the rest
+	if ( range->size > size ) {
+		bufferRange_t *rest = rangeAllocator.Alloc();
+		rest->offset = range->offset + size;
+		rest->size = range->size - size;
+		rest->owner = NULL;
+		rest->prevPhys = range;
+		rest->nextPhys = range->nextPhys;
+		if ( rest->nextPhys ) {
+			rest->nextPhys->prevPhys = rest;
+		}
+		range->nextPhys = rest;
+		range->size = size;
+		InsertFree( rest );
+	}
+
+	range->owner = NULL;
+	allocatedBytes += range->size;
+	numAllocs++;
+
+	return range;
+}
+
+/*
+================
+idBufferAllocator::Free
+================
+*/
+void idBufferAllocator::Free( bufferRange_t *range ) {
+	assert( range && !range->free );
+
+	allocatedBytes -= range->size;
+	numAllocs--;
+	range->owner = NULL;
+
+	// merge with the following range
+	bufferRange_t *next = range->nextPhys;
+	if ( next && next->free ) {
+		RemoveFree( next );
+		range->size += next->size;
+		range->nextPhys = next->nextPhys;
+		if ( range->nextPhys ) {
+			range->nextPhys->prevPhys = range;
+		}
+		rangeAllocator.Free( next );
+	}
+
+	// merge with the preceding range
+	bufferRange_t *prev = range->prevPhys;
+	if ( prev && prev->free ) {
+		RemoveFree( prev );
+		prev->size += range->size;
+		prev->nextPhys = range->nextPhys;
+		if ( prev->nextPhys ) {
+			prev->nextPhys->prevPhys = prev;
+		}
+		rangeAllocator.Free( range );
+		range = prev;
+	}
+
+	InsertFree( range );
+}
+
+/*
+================
+idBufferAllocator::GetLargestFree
+================
+*/
+int idBufferAllocator::GetLargestFree( void ) const {
+	if ( !flBitmap ) {
+		return 0;
+	}
+
+	int fl = BufferAlloc_HighestBit( flBitmap );
+	int sl = BufferAlloc_HighestBit( slBitmap[fl] );
+
+	int largest = 0;
+	for ( const bufferRange_t *range = freeLists[fl][sl]; range; range = range->nextFree ) {
+		if ( range->size > largest ) {
+			largest = range->size;
+		}
+	}
+	return largest;
+}
@@ -0,0 +1,103 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#ifndef __BUFFERALLOCATOR_H__
+#define __BUFFERALLOCATOR_H__
+
+/*
+===============================================================================
+
+	Two level segregated fit allocator for ranges of memory the CPU can't
+	store any bookkeeping in, like buffer objects on the GPU.
+
+	The free ranges are kept in lists by size class, the first level splits
+	the sizes by powers of two and the second level linearly into
+	BUFFER_ALLOC_SL_COUNT parts.  A bitmap for each level finds a suitable
+	free list in constant time.  Adjacent free ranges are merged on Free.
+
+===============================================================================
+*/
+
+const int BUFFER_ALLOC_ALIGN		= 16;		// offsets and sizes are multiples of this
+const int BUFFER_ALLOC_SL_BITS		= 4;
+const int BUFFER_ALLOC_SL_COUNT		= 1 << BUFFER_ALLOC_SL_BITS;
+const int BUFFER_ALLOC_FL_COUNT		= 24;		// up to 1 << 30 bytes
+
+typedef struct bufferRange_s {
+	int						offset;
+	int						size;				// a multiple of BUFFER_ALLOC_ALIGN
+	bool					free;
+	void *					owner;				// not used by the allocator
+	struct bufferRange_s *	prevPhys;			// neighbours in the address space
+	struct bufferRange_s *	nextPhys;
+	struct bufferRange_s *	prevFree;			// on the free list of the size class
+	struct bufferRange_s *	nextFree;
+} bufferRange_t;
+
+class idBufferAllocator {
+public:
+							idBufferAllocator( void );
+							~idBufferAllocator( void );
+
+	void					Init( int size );
+	void					Shutdown( void );
+
+							// returns NULL if there is no free range large enough
+	bufferRange_t *			Alloc( int size );
+	void					Free( bufferRange_t *range );
+
+	int						GetSize( void ) const { return size; }
+	int						GetAllocatedBytes( void ) const { return allocatedBytes; }
+	int						GetFreeBytes( void ) const { return size - allocatedBytes; }
+	int						GetNumAllocs( void ) const { return numAllocs; }
+	int						GetNumFreeRanges( void ) const { return numFreeRanges; }
+	int						GetLargestFree( void ) const;
+
+							// first range in address order, walk with nextPhys
+	bufferRange_t *			GetFirstRange( void ) const { return ranges; }
+
+private:
+	int						size;
+	int						allocatedBytes;
+	int						numAllocs;
+	int						numFreeRanges;
+
+	unsigned int			flBitmap;
+	unsigned int			slBitmap[BUFFER_ALLOC_FL_COUNT];
+	bufferRange_t *			freeLists[BUFFER_ALLOC_FL_COUNT][BUFFER_ALLOC_SL_COUNT];
+
+	bufferRange_t *			ranges;
+	idBlockAlloc<bufferRange_t, 256>	rangeAllocator;
+
+	static void				Mapping( int size, int &fl, int &sl );
+	bufferRange_t *			FindFree( int size );
+	void					InsertFree( bufferRange_t *range );
+	void					RemoveFree( bufferRange_t *range );
+};
+
+#endif /* !__BUFFERALLOCATOR_H__ */
@@ -143,6 +143,62 @@ typedef enum {
 
 #define	MAX_IMAGE_NAME	256
 
+// the mip chain of an image that is ready to be uploaded
+static const int	MAX_IMAGE_LEVELS = 16;
+
+typedef struct {
+	int					numLevels;
+	int					widths[MAX_IMAGE_LEVELS];
+	int					heights[MAX_IMAGE_LEVELS];
+	byte *				levels[MAX_IMAGE_LEVELS];
+} imageLevels_t;
+
+// Everything an image load does besides talking to GL, so it can
+// run on a job thread while the main thread issues the uploads.
+class idImage;
+
+typedef struct {
+	idImage *			image;
+	bool				found;					// false if the source files couldn't be read
+	byte *				precompressed;			// .dds file contents
+	int					precompressedLength;
+	imageLevels_t		levels;					// mip chain built from the source files
+} imageLoad_t;
+
+// the mip levels of a .dds file, each one can be read and uploaded on its own
+typedef struct {
+	int					internalFormat;
+	int					externalFormat;			// 0 for compressed formats
+	int					numLevels;
+	int					widths[MAX_IMAGE_LEVELS];
+	int					heights[MAX_IMAGE_LEVELS];
+	int					offsets[MAX_IMAGE_LEVELS + 1];	// file position of each level and the end of the last one
+} ddsLayout_t;
+
+// A streamed image is a precompressed image of which only the small mip
+// levels are read at load time.  The larger ones are read in the background
+// when the front end wants them, and dropped again to stay within the
+// image_cacheMegs budget.  Levels keep their index in the file, the largest
+// resident one is set as the base level of the texture.
+typedef struct {
+	ddsLayout_t			layout;
+	int					firstLevel;				// largest level allowed by the downsize cvars
+	int					tailLevel;				// this and all smaller levels are always resident
+	int					residentLevel;			// largest uploaded level, numLevels if none
+	int					wantedLevel;			// largest level needed by the views of lastWantedFrame
+	int					lastWantedFrame;
+	int					readLevel;				// first level of the background read, -1 if none
+	backgroundDownload_t	bgl;
+} imageStream_t;
+
+typedef struct {
+	int					reads;					// background reads of larger levels
+	int					readBytes;
+	int					deferredReads;			// reads that didn't fit the budget
+	int					evictions;				// images that had levels dropped
+	int					evictedBytes;
+} imageStreamStats_t;
+
 class idImage {
 public:
 				idImage();
@@ -198,12 +254,32 @@ public:
 	void		GetDownsize( int &scaled_width, int &scaled_height ) const;
 	void		MakeDefault();	// fill with a grid pattern
 	void		SetImageFilterAndRepeat() const;
-	bool		ShouldImageBePartialCached();
-	void		WritePrecompressedImage();
-	bool		CheckPrecompressedImage( bool fullLoad );
+	bool		ShouldImageBeStreamed();
+	void		WritePrecompressedImage( const imageLevels_t &levels );
+	bool		ParsePrecompressedHeader( const byte *data, ddsLayout_t &layout );
 	void		UploadPrecompressedImage( byte *data, int len );
+	void		UploadPrecompressedLevel( const ddsLayout_t &layout, int level, int glLevel, const byte *data );
 	void		ActuallyLoadImage( bool checkForPrecompressed, bool fromBackEnd );
-	void		StartBackgroundImageLoad();
+	bool		CanLoadImageInJob() const;
+	void		LoadImageData( imageLoad_t &load, bool checkForPrecompressed );
+	void		FinishImageLoad( imageLoad_t &load );
+	bool		ReadPrecompressedImage( bool fullLoad, byte **data, int *dataLength );
+	void		BuildImageLevels( const byte *pic, int width, int height, imageLevels_t &levels );
+	void		UploadImageLevels( imageLevels_t &levels );
+
+	// streaming, Image_stream.cpp
+	void		AllocStream();
+	void		FreeStream();
+	void		PurgeStream();
+	bool		ReadStreamedImageTail( idFile *f, byte **data, int *dataLength );
+	void		UploadStreamedImage( const byte *data, int len );
+	void		StreamForScreenSize( float pixels );
+	void		StartStreamRead( int level );
+	void		FinishStreamRead();
+	void		CancelStreamRead();
+	void		EvictStreamedLevels( int level );
+	void		SetStreamedBaseLevel( int level );
+
 	int			BitsForInternalFormat( int internalFormat ) const;
 	GLenum		SelectInternalFormat( const byte **dataPtrs, int numDataPtrs, int width, int height,
 									 textureDepth_t minimumDepth, bool *monochromeResult ) const;
@@ -218,16 +294,12 @@ public:
 	int					bindCount;				// incremented each bind
 
 	// background loading information
-	idImage				*partialImage;			// shrunken, space-saving version
-	bool				isPartialImage;			// true if this is pointed to by another image
-	bool				backgroundLoadInProgress;	// true if another thread is reading the complete d3t file
-	backgroundDownload_t	bgl;
-	idImage *			bglNext;				// linked from tr.backgroundImageLoads
+	imageStream_t *		stream;					// NULL if the image isn't streamed
 
 	// parameters that define this image
 	idStr				imgName;				// game path, including extension (except for cube maps), may be an image program
 	void				(*generatorFunction)( idImage *image );	// NULL for files
-	bool				allowDownSize;			// this also doubles as a don't-partially-load flag
+	bool				allowDownSize;			// this also doubles as a don't-stream flag
 	textureFilter_t		filter;
 	textureRepeat_t		repeat;
 	textureDepth_t		depth;
@@ -248,7 +320,7 @@ public:
 	int					uploadWidth, uploadHeight, uploadDepth;	// after power of two, downsample, and MAX_TEXTURE_SIZE
 	int					internalFormat;
 
-	idImage 			*cacheUsagePrev, *cacheUsageNext;	// for dynamic cache purging of old images
+	idImage 			*cacheUsagePrev, *cacheUsageNext;	// for evicting the levels of streamed images
 
 	idImage *			hashNext;				// for hash chains to speed lookup
 
@@ -257,15 +329,10 @@ public:
 
 ID_INLINE idImage::idImage() {
 	texnum = TEXTURE_NOT_LOADED;
-	partialImage = NULL;
+	stream = NULL;
 	type = TT_DISABLED;
-	isPartialImage = false;
 	frameUsed = 0;
 	classification = 0;
-	backgroundLoadInProgress = false;
-	bgl.opcode = DLTYPE_FILE;
-	bgl.f = NULL;
-	bglNext = NULL;
 	imgName[0] = '\0';
 	generatorFunction = NULL;
 	allowDownSize = false;
@@ -316,9 +383,10 @@ public:
 	// The callback function should call one of the idImage::Generate* functions to fill in the data
 	idImage *			ImageFromFunction( const char *name, void (*generatorFunction)( idImage *image ));
 
-	// called once a frame to allow any background loads that have been completed
-	// to turn into textures.
-	void				CompleteBackgroundImageLoads();
+	// called once a frame by the front end while the back end is idle, uploads
+	// the streamed levels that finished reading, starts the reads the views of
+	// the frame asked for and evicts levels to stay within image_cacheMegs
+	void				UpdateStreamedImages();
 
 	// returns the number of bytes of image data bound in the previous frame
 	int					SumOfUsedImages();
@@ -372,11 +440,11 @@ public:
 	static idCVar		image_useNormalCompression;	// 1 = use 256 color compression for normal maps if available, 2 = use rxgb compression
 	static idCVar		image_useOffLineCompression; // will write a batch file with commands for the offline compression
 	static idCVar		image_preload;				// if 0, dynamically load all images
-	static idCVar		image_cacheMinK;			// maximum K of precompressed files to read at specification time,
-													// the remainder will be dynamically cached
-	static idCVar		image_cacheMegs;			// maximum bytes set aside for temporary loading of full-sized precompressed images
-	static idCVar		image_useCache;				// 1 = do background load image caching
-	static idCVar		image_showBackgroundLoads;	// 1 = print number of outstanding background loads
+	static idCVar		image_cacheMinK;			// maximum K of the small mip levels of a streamed image read at load time,
+													// the larger ones are streamed
+	static idCVar		image_cacheMegs;			// budget for the resident levels of streamed images
+	static idCVar		image_useCache;				// 1 = stream the large mip levels of precompressed images
+	static idCVar		image_showBackgroundLoads;	// 1 = print the streaming statistics of each frame
 	static idCVar		image_forceDownSize;		// allows the ability to force a downsize
 	static idCVar		image_downSizeSpecular;		// downsize specular
 	static idCVar		image_downSizeSpecularLimit;// downsize specular limit
@@ -384,6 +452,8 @@ public:
 	static idCVar		image_downSizeBumpLimit;	// downsize bump limit
 	static idCVar		image_ignoreHighQuality;	// ignore high quality on materials
 	static idCVar		image_downSizeLimit;		// downsize diffuse limit
+	static idCVar		image_loadJobs;				// read and decode level load images on job threads
+	static idCVar		image_processJobs;			// filter the rows of large images on job threads
 
 	// built-in images
 	idImage *			defaultImage;
@@ -411,6 +481,7 @@ public:
 	//--------------------------------------------------------
 	
 	idImage *			AllocImage( const char *name );
+	void				LoadLevelImages( idList<idImage *> &loadList );
 	void				SetNormalPalette();
 	void				ChangeTextureFilter();
 
@@ -431,9 +502,11 @@ public:
 
 	idImage *			imageHashTable[FILE_HASH_SIZE];
 
-	idImage *			backgroundImageLoads;		// chain of images that have background file loads active
-	idImage				cacheLRU;					// head/tail of doubly linked list
-	int					totalCachedImageSize;		// for determining when something should be purged
+	idImage				cacheLRU;					// streamed images, the ones wanted this frame first
+	idImage *			cacheWantedTail;			// the image last added to the ones wanted this frame
+	int					streamedImageSize;			// resident and reading levels of all streamed images
+	imageStreamStats_t	streamStats;				// of the current frame
+	imageStreamStats_t	totalStreamStats;			// since the last level load
 
 	int	numActiveBackgroundImageLoads;
 	const static int MAX_BACKGROUND_IMAGE_LOADS = 8;
@@ -460,6 +533,29 @@ byte *R_MipMapWithAlphaSpecularity( const byte *in, int width, int height );
 byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder );
 byte *R_MipMap3D( const byte *in, int width, int height, int depth, bool preserveBorder );
 
+// a band of rows of an image operation, large images are split into
+// several bands that run in parallel on the job threads
+typedef struct imageRowJob_s {
+	void				(*function)( const struct imageRowJob_s *job );
+	idSIMDProcessor *	simd;
+	const byte *		in;
+	byte *				out;
+	int					inWidth;
+	int					inHeight;
+	int					outWidth;
+	int					outHeight;
+	const unsigned int *offsets0;		// byte offsets of the resampled texels in a source row
+	const unsigned int *offsets1;
+	int					format;			// GL internal format of compressed output
+	int					firstRow;
+	int					numRows;
+} imageRowJob_t;
+
+void R_InitImageProcessJobs( void );
+void R_ShutdownImageProcessJobs( void );
+void R_ProcessImageRows( const imageRowJob_t &work, int numRows, int rowTexels );
+void R_BenchmarkImageProcess_f( const idCmdArgs &args );
+
 // these operate in-place on the provided pixels
 void R_SetBorderTexels( byte *inBase, int width, int height, const byte border[4] );
 void R_SetBorderTexels3D( byte *inBase, int width, int height, int depth, const byte border[4] );
@@ -471,6 +567,18 @@ void R_RotatePic( byte *data, int width );
 /*
 ====================================================================
 
+IMAGECOMPRESS
+
+====================================================================
+*/
+
+// S3TC compression of RGBA texels, deterministic and without GL
+int R_CompressedImageSize( int internalFormat, int width, int height );
+void R_CompressImage( byte *out, const byte *in, int width, int height, int internalFormat );
+
+/*
+====================================================================
+
 IMAGEFILES
 
 ====================================================================
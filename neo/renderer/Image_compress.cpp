@@ -0,0 +1,571 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT   0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT  0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT  0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT  0x83F3
+#endif
+
+/*
+===============================================================================
+
+	S3TC block compression
+
+	Compresses RGBA texels to DXT1, DXT3 and DXT5 blocks on the CPU, so
+	precompressed images can be written without a GL context.  Only integer
+	math is used and every block depends on nothing but its own texels, so
+	the output is identical on every machine and for any number of jobs.
+
+	The color endpoints start at the inset bounding box of the block, along
+	the diagonal that follows the colors.  They are refined with a least
+	squares fit to the selected indices for as long as that lowers the error.
+
+===============================================================================
+*/
+
+const int DXT_REFINE_PASSES		= 2;
+const int DXT_MAX_DIST			= 1 << 30;		// larger than any squared texel distance
+
+/*
+================
+R_DivRound
+================
+*/
+static int R_DivRound( int n, int d ) {
+	if ( n >= 0 ) {
+		return ( n + d / 2 ) / d;
+	}
+	return -( ( -n + d / 2 ) / d );
+}
+
+/*
+================
+R_ColorTo565
+================
+*/
+static int R_ColorTo565( const int color[3] ) {
+	int r = ( color[0] * 31 + 127 ) / 255;
+	int g = ( color[1] * 63 + 127 ) / 255;
+	int b = ( color[2] * 31 + 127 ) / 255;
+	return ( r << 11 ) | ( g << 5 ) | b;
+}
+
+/*
+================
+R_ColorFrom565
+================
+*/
+static void R_ColorFrom565( int c, int color[3] ) {
+	int r = ( c >> 11 ) & 31;
+	int g = ( c >> 5 ) & 63;
+	int b = c & 31;
+	color[0] = ( r << 3 ) | ( r >> 2 );
+	color[1] = ( g << 2 ) | ( g >> 4 );
+	color[2] = ( b << 3 ) | ( b >> 2 );
+}
+
+/*
+================
+R_ExtractBlock
+
+Texels outside the image repeat the last row and column.
+================
+*/
+static void R_ExtractBlock( const byte *in, int width, int height, int x, int y, byte block[64] ) {
+	for ( int j = 0 ; j < 4 ; j++ ) {
+		const byte *row = in + Min( y + j, height - 1 ) * width * 4;
+		for ( int i = 0 ; i < 4 ; i++ ) {
+			const byte *texel = row + Min( x + i, width - 1 ) * 4;
+			byte *dst = block + ( j * 4 + i ) * 4;
+			dst[0] = texel[0];
+			dst[1] = texel[1];
+			dst[2] = texel[2];
+			dst[3] = texel[3];
+		}
+	}
+}
+
+/*
+================
+R_ColorBlockIndices
+
+Selects the nearest palette entry for every texel and returns the
+squared error.  In three color mode transparent texels use index 3.
+================
+*/
+static int R_ColorBlockIndices( const byte *block, int color0, int color1, bool threeColor, unsigned int *indices ) {
+	int		palette[4][3];
+	int		numColors;
+	int		error;
+
+	R_ColorFrom565( color0, palette[0] );
+	R_ColorFrom565( color1, palette[1] );
+	if ( threeColor ) {
+		for ( int c = 0 ; c < 3 ; c++ ) {
+			palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2;
+		}
+		numColors = 3;
+	} else {
+		for ( int c = 0 ; c < 3 ; c++ ) {
+			palette[2][c] = ( 2 * palette[0][c] + palette[1][c] ) / 3;
+			palette[3][c] = ( palette[0][c] + 2 * palette[1][c] ) / 3;
+		}
+		numColors = 4;
+	}
+
+	error = 0;
+	*indices = 0;
+	for ( int i = 0 ; i < 16 ; i++ ) {
+		const byte *texel = block + i * 4;
+
+		if ( threeColor && texel[3] < 128 ) {
+			*indices |= 3 << ( i * 2 );
+			continue;
+		}
+
+		int best = 0;
+		int bestDist = DXT_MAX_DIST;
+		for ( int k = 0 ; k < numColors ; k++ ) {
+			int dr = texel[0] - palette[k][0];
+			int dg = texel[1] - palette[k][1];
+			int db = texel[2] - palette[k][2];
+			int dist = dr * dr + dg * dg + db * db;
+			if ( dist < bestDist ) {
+				bestDist = dist;
+				best = k;
+			}
+		}
+		*indices |= best << ( i * 2 );
+		error += bestDist;
+	}
+	return error;
+}
+
+/*
+================
+R_ColorBoundingBox
+
+Returns false if there are no opaque texels.
+================
+*/
+static bool R_ColorBoundingBox( const byte *block, bool threeColor, int lo[3], int hi[3] ) {
+	int		mins[3], maxs[3], sums[3];
+	int		numTexels;
+
+	mins[0] = mins[1] = mins[2] = 255;
+	maxs[0] = maxs[1] = maxs[2] = 0;
+	sums[0] = sums[1] = sums[2] = 0;
+	numTexels = 0;
+	for ( int i = 0 ; i < 16 ; i++ ) {
+		const byte *texel = block + i * 4;
+		if ( threeColor && texel[3] < 128 ) {
+			continue;
+		}
+		for ( int c = 0 ; c < 3 ; c++ ) {
+			mins[c] = Min( mins[c], (int)texel[c] );
+			maxs[c] = Max( maxs[c], (int)texel[c] );
+			sums[c] += texel[c];
+		}
+		numTexels++;
+	}
+	if ( numTexels == 0 ) {
+		return false;
+	}
+
+	// flip the channels that fall while the one with the largest range rises
+	int axis = 0;
+	for ( int c = 1 ; c < 3 ; c++ ) {
+		if ( maxs[c] - mins[c] > maxs[axis] - mins[axis] ) {
+			axis = c;
+		}
+	}
+	for ( int c = 0 ; c < 3 ; c++ ) {
+		if ( c == axis ) {
+			continue;
+		}
+		int covariance = 0;
+		for ( int i = 0 ; i < 16 ; i++ ) {
+			const byte *texel = block + i * 4;
+			if ( threeColor && texel[3] < 128 ) {
+				continue;
+			}
+			covariance += ( texel[c] * numTexels - sums[c] ) * ( texel[axis] * numTexels - sums[axis] );
+		}
+		if ( covariance < 0 ) {
+			int temp = mins[c];
+			mins[c] = maxs[c];
+			maxs[c] = temp;
+		}
+	}
+
+	// inset the box, the extremes are rarely worth an endpoint
+	for ( int c = 0 ; c < 3 ; c++ ) {
+		int inset = ( maxs[c] - mins[c] ) / 16;
+		hi[c] = maxs[c] - inset;
+		lo[c] = mins[c] + inset;
+	}
+	return true;
+}
+
+/*
+================
+R_FitColorEndpoints
+
+Least squares fit of the endpoints to the texels with the given indices.
+Returns false if all texels use the same weights.
+================
+*/
+static bool R_FitColorEndpoints( const byte *block, unsigned int indices, bool threeColor, int color0[3], int color1[3] ) {
+	static const int weights4[4] = { 3, 0, 2, 1 };
+	static const int weights3[4] = { 2, 0, 1, 0 };
+	const int *weights = threeColor ? weights3 : weights4;
+	int		scale = threeColor ? 2 : 3;
+	int		aa, bb, ab;
+	int		ax[3], bx[3];
+
+	aa = bb = ab = 0;
+	ax[0] = ax[1] = ax[2] = 0;
+	bx[0] = bx[1] = bx[2] = 0;
+	for ( int i = 0 ; i < 16 ; i++ ) {
+		int index = ( indices >> ( i * 2 ) ) & 3;
+		if ( threeColor && index == 3 ) {
+			continue;
+		}
+		const byte *texel = block + i * 4;
+		int a = weights[index];
+		int b = scale - a;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for ( int c = 0 ; c < 3 ; c++ ) {
+			ax[c] += a * texel[c];
+			bx[c] += b * texel[c];
+		}
+	}
+
+	int det = aa * bb - ab * ab;
+	if ( det == 0 ) {
+		return false;
+	}
+	for ( int c = 0 ; c < 3 ; c++ ) {
+		color0[c] = idMath::ClampInt( 0, 255, R_DivRound( scale * ( ax[c] * bb - bx[c] * ab ), det ) );
+		color1[c] = idMath::ClampInt( 0, 255, R_DivRound( scale * ( bx[c] * aa - ax[c] * ab ), det ) );
+	}
+	return true;
+}
+
+/*
+================
+R_WriteColorBlock
+================
+*/
+static void R_WriteColorBlock( byte *out, int color0, int color1, unsigned int indices ) {
+	out[0] = color0 & 255;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 255;
+	out[3] = color1 >> 8;
+	out[4] = indices & 255;
+	out[5] = ( indices >> 8 ) & 255;
+	out[6] = ( indices >> 16 ) & 255;
+	out[7] = indices >> 24;
+}
+
+/*
+================
+R_CompressColorBlock
+
+If allowTransparent is set, blocks with texels below half alpha
+use the three color mode with transparent black.
+================
+*/
+static void R_CompressColorBlock( byte *out, const byte *block, bool allowTransparent ) {
+	bool			threeColor;
+	int				lo[3], hi[3];
+	int				color0, color1;
+	unsigned int	indices;
+	int				error;
+
+	threeColor = false;
+	if ( allowTransparent ) {
+		for ( int i = 0 ; i < 16 ; i++ ) {
+			if ( block[i * 4 + 3] < 128 ) {
+				threeColor = true;
+				break;
+			}
+		}
+	}
+
+	if ( !R_ColorBoundingBox( block, threeColor, lo, hi ) ) {
+		// completely transparent
+		R_WriteColorBlock( out, 0, 0, 0xFFFFFFFF );
+		return;
+	}
+
+	color0 = R_ColorTo565( hi );
+	color1 = R_ColorTo565( lo );
+	error = R_ColorBlockIndices( block, color0, color1, threeColor, &indices );
+
+	for ( int pass = 0 ; pass < DXT_REFINE_PASSES && error > 0 ; pass++ ) {
+		int				fit0[3], fit1[3];
+		unsigned int	fitIndices;
+
+		if ( !R_FitColorEndpoints( block, indices, threeColor, fit0, fit1 ) ) {
+			break;
+		}
+		int fitColor0 = R_ColorTo565( fit0 );
+		int fitColor1 = R_ColorTo565( fit1 );
+		if ( fitColor0 == color0 && fitColor1 == color1 ) {
+			break;
+		}
+		int fitError = R_ColorBlockIndices( block, fitColor0, fitColor1, threeColor, &fitIndices );
+		if ( fitError >= error ) {
+			break;
+		}
+		color0 = fitColor0;
+		color1 = fitColor1;
+		indices = fitIndices;
+		error = fitError;
+	}
+
+	// the order of the endpoints selects the mode
+	if ( threeColor ) {
+		if ( color0 > color1 ) {
+			int temp = color0;
+			color0 = color1;
+			color1 = temp;
+			// swap indices 0 and 1, the average and transparent texels stay
+			for ( int i = 0 ; i < 16 ; i++ ) {
+				if ( ( ( indices >> ( i * 2 ) ) & 3 ) < 2 ) {
+					indices ^= 1 << ( i * 2 );
+				}
+			}
+		}
+	} else {
+		if ( color0 < color1 ) {
+			int temp = color0;
+			color0 = color1;
+			color1 = temp;
+			indices ^= 0x55555555;
+		} else if ( color0 == color1 ) {
+			// would be decoded in three color mode
+			indices = 0;
+		}
+	}
+
+	R_WriteColorBlock( out, color0, color1, indices );
+}
+
+/*
+================
+R_AlphaBlockIndices
+
+Alpha0 > alpha1 selects eight interpolated values, otherwise
+there are six, plus 0 and 255.
+================
+*/
+static int R_AlphaBlockIndices( const byte *block, int alpha0, int alpha1, byte indices[16] ) {
+	int		palette[8];
+	int		error;
+
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	if ( alpha0 > alpha1 ) {
+		for ( int i = 1 ; i < 7 ; i++ ) {
+			palette[i + 1] = ( ( 7 - i ) * alpha0 + i * alpha1 ) / 7;
+		}
+	} else {
+		for ( int i = 1 ; i < 5 ; i++ ) {
+			palette[i + 1] = ( ( 5 - i ) * alpha0 + i * alpha1 ) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	error = 0;
+	for ( int i = 0 ; i < 16 ; i++ ) {
+		int alpha = block[i * 4 + 3];
+		int best = 0;
+		int bestDist = DXT_MAX_DIST;
+		for ( int k = 0 ; k < 8 ; k++ ) {
+			int dist = ( alpha - palette[k] ) * ( alpha - palette[k] );
+			if ( dist < bestDist ) {
+				bestDist = dist;
+				best = k;
+			}
+		}
+		indices[i] = best;
+		error += bestDist;
+	}
+	return error;
+}
+
+/*
+================
+R_CompressAlphaBlock
+
+DXT5 alpha, tries both modes.  The six value mode wins
+for blocks that have fully transparent or opaque texels.
+================
+*/
+static void R_CompressAlphaBlock( byte *out, const byte *block ) {
+	int		minAlpha, maxAlpha, minInner, maxInner;
+	byte	indices8[16], indices6[16];
+	int		alpha0, alpha1;
+	byte	*indices;
+
+	minAlpha = minInner = 255;
+	maxAlpha = maxInner = 0;
+	for ( int i = 0 ; i < 16 ; i++ ) {
+		int alpha = block[i * 4 + 3];
+		minAlpha = Min( minAlpha, alpha );
+		maxAlpha = Max( maxAlpha, alpha );
+		if ( alpha != 0 && alpha != 255 ) {
+			minInner = Min( minInner, alpha );
+			maxInner = Max( maxInner, alpha );
+		}
+	}
+	if ( minInner > maxInner ) {
+		minInner = maxInner = 0;
+	}
+
+	int error8 = R_AlphaBlockIndices( block, maxAlpha, minAlpha, indices8 );
+	int error6 = R_AlphaBlockIndices( block, minInner, maxInner, indices6 );
+	if ( error6 < error8 ) {
+		alpha0 = minInner;
+		alpha1 = maxInner;
+		indices = indices6;
+	} else {
+		alpha0 = maxAlpha;
+		alpha1 = minAlpha;
+		indices = indices8;
+	}
+
+	out[0] = alpha0;
+	out[1] = alpha1;
+	for ( int half = 0 ; half < 2 ; half++ ) {
+		int bits = 0;
+		for ( int i = 0 ; i < 8 ; i++ ) {
+			bits |= indices[half * 8 + i] << ( i * 3 );
+		}
+		out[2 + half * 3 + 0] = bits & 255;
+		out[2 + half * 3 + 1] = ( bits >> 8 ) & 255;
+		out[2 + half * 3 + 2] = ( bits >> 16 ) & 255;
+	}
+}
+
+/*
+================
+R_CompressExplicitAlphaBlock
+
+DXT3 alpha, four bits per texel.
+================
+*/
+static void R_CompressExplicitAlphaBlock( byte *out, const byte *block ) {
+	for ( int i = 0 ; i < 8 ; i++ ) {
+		int lo = ( block[( i * 2 + 0 ) * 4 + 3] * 15 + 127 ) / 255;
+		int hi = ( block[( i * 2 + 1 ) * 4 + 3] * 15 + 127 ) / 255;
+		out[i] = lo | ( hi << 4 );
+	}
+}
+
+/*
+================
+R_CompressBlockRows
+================
+*/
+static void R_CompressBlockRows( const imageRowJob_t *job ) {
+	byte	block[64];
+	int		blockSize = ( job->format <= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ) ? 8 : 16;
+
+	for ( int y = job->firstRow ; y < job->firstRow + job->numRows ; y++ ) {
+		byte *out = job->out + y * job->outWidth * blockSize;
+		for ( int x = 0 ; x < job->outWidth ; x++, out += blockSize ) {
+			R_ExtractBlock( job->in, job->inWidth, job->inHeight, x * 4, y * 4, block );
+
+			switch ( job->format ) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+				R_CompressColorBlock( out, block, false );
+				break;
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+				R_CompressColorBlock( out, block, true );
+				break;
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+				R_CompressExplicitAlphaBlock( out, block );
+				R_CompressColorBlock( out + 8, block, false );
+				break;
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				R_CompressAlphaBlock( out, block );
+				R_CompressColorBlock( out + 8, block, false );
+				break;
+			}
+		}
+	}
+}
+
+/*
+================
+R_CompressedImageSize
+================
+*/
+int R_CompressedImageSize( int internalFormat, int width, int height ) {
+	return ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * ( internalFormat <= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16 );
+}
+
+/*
+================
+R_CompressImage
+
+Compresses RGBA texels to one of the S3TC formats, out must hold
+R_CompressedImageSize bytes.  Large images are compressed by rows
+of blocks on the job threads.
+================
+*/
+void R_CompressImage( byte *out, const byte *in, int width, int height, int internalFormat ) {
+	imageRowJob_t	work;
+
+	assert( internalFormat >= GL_COMPRESSED_RGB_S3TC_DXT1_EXT && internalFormat <= GL_COMPRESSED_RGBA_S3TC_DXT5_EXT );
+
+	memset( &work, 0, sizeof( work ) );
+	work.function = R_CompressBlockRows;
+	work.in = in;
+	work.out = out;
+	work.inWidth = width;
+	work.inHeight = height;
+	work.outWidth = ( width + 3 ) / 4;
+	work.outHeight = ( height + 3 ) / 4;
+	work.format = internalFormat;
+
+	R_ProcessImageRows( work, work.outHeight, width * 4 );
+}
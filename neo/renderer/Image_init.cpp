@@ -65,16 +65,18 @@ idCVar idImageManager::image_writeNormalTGA( "image_writeNormalTGA", "0", CVAR_R
 idCVar idImageManager::image_writeNormalTGAPalletized( "image_writeNormalTGAPalletized", "0", CVAR_RENDERER | CVAR_BOOL, "write .tgas of the final palletized normal maps for debugging" );
 idCVar idImageManager::image_writeTGA( "image_writeTGA", "0", CVAR_RENDERER | CVAR_BOOL, "write .tgas of the non normal maps for debugging" );
 idCVar idImageManager::image_useOffLineCompression( "image_useOfflineCompression", "0", CVAR_RENDERER | CVAR_BOOL, "write a batch file for offline compression of DDS files" );
-idCVar idImageManager::image_cacheMinK( "image_cacheMinK", "200", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "maximum KB of precompressed files to read at specification time" );
-idCVar idImageManager::image_cacheMegs( "image_cacheMegs", "20", CVAR_RENDERER | CVAR_ARCHIVE, "maximum MB set aside for temporary loading of full-sized precompressed images" );
-idCVar idImageManager::image_useCache( "image_useCache", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "1 = do background load image caching" );
-idCVar idImageManager::image_showBackgroundLoads( "image_showBackgroundLoads", "0", CVAR_RENDERER | CVAR_BOOL, "1 = print number of outstanding background loads" );
+idCVar idImageManager::image_cacheMinK( "image_cacheMinK", "200", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "maximum KB of the small mip levels of a streamed image that are read at load time" );
+idCVar idImageManager::image_cacheMegs( "image_cacheMegs", "256", CVAR_RENDERER | CVAR_ARCHIVE, "maximum MB of texture memory used by the mip levels of streamed images" );
+idCVar idImageManager::image_useCache( "image_useCache", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "1 = stream the large mip levels of precompressed images by their size on screen" );
+idCVar idImageManager::image_showBackgroundLoads( "image_showBackgroundLoads", "0", CVAR_RENDERER | CVAR_BOOL, "1 = print the reads and evictions of streamed images each frame" );
 idCVar idImageManager::image_downSizeSpecular( "image_downSizeSpecular", "0", CVAR_RENDERER | CVAR_ARCHIVE, "controls specular downsampling" );
 idCVar idImageManager::image_downSizeBump( "image_downSizeBump", "0", CVAR_RENDERER | CVAR_ARCHIVE, "controls normal map downsampling" );
 idCVar idImageManager::image_downSizeSpecularLimit( "image_downSizeSpecularLimit", "64", CVAR_RENDERER | CVAR_ARCHIVE, "controls specular downsampled limit" );
 idCVar idImageManager::image_downSizeBumpLimit( "image_downSizeBumpLimit", "128", CVAR_RENDERER | CVAR_ARCHIVE, "controls normal map downsample limit" );
 idCVar idImageManager::image_ignoreHighQuality( "image_ignoreHighQuality", "0", CVAR_RENDERER | CVAR_ARCHIVE, "ignore high quality setting on materials" );
 idCVar idImageManager::image_downSizeLimit( "image_downSizeLimit", "256", CVAR_RENDERER | CVAR_ARCHIVE, "controls diffuse map downsample limit" ); 
+idCVar idImageManager::image_loadJobs( "image_loadJobs", "1", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "1 = read and decode level load images on job threads, only the GL uploads are serialized on the main thread" );
+idCVar idImageManager::image_processJobs( "image_processJobs", "1", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_BOOL, "1 = resample and mip map the rows of large images on job threads" );
 // do this with a pointer, in case we want to make the actual manager
 // a private virtual subclass
 idImageManager	imageManager;
@@ -1067,6 +1069,9 @@ void R_ReloadImages_f( const idCmdArgs &args ) {
 	bool	all;
 	bool	checkPrecompressed;
 
+	// the back end may be using the images
+	R_SyncRenderThread();
+
 	// this probably isn't necessary...
 	globalImages->ChangeTextureFilter();
 
@@ -1202,13 +1207,15 @@ void R_ListImages_f( const idCmdArgs &args ) {
 		if ( unloaded && image->texnum != idImage::TEXTURE_NOT_LOADED ) {
 			continue;
 		}
-		if ( partial && !image->isPartialImage ) {
+		// streamed images that miss some levels, that have streamed levels
+		// resident, or that only have the levels read at load time
+		if ( partial && ( !image->stream || image->stream->residentLevel <= image->stream->firstLevel ) ) {
 			continue;
 		}
-		if ( cached && ( !image->partialImage || image->texnum == idImage::TEXTURE_NOT_LOADED ) ) {
+		if ( cached && ( !image->stream || image->stream->residentLevel >= image->stream->tailLevel ) ) {
 			continue;
 		}
-		if ( uncached && ( !image->partialImage || image->texnum != idImage::TEXTURE_NOT_LOADED ) ) {
+		if ( uncached && ( !image->stream || image->stream->residentLevel < image->stream->tailLevel ) ) {
 			continue;
 		}
 
@@ -1260,7 +1267,11 @@ void R_ListImages_f( const idCmdArgs &args ) {
 
 	common->Printf( "%s", header );
 	common->Printf( " %i images (%i total)\n", count, globalImages->images.Num() );
-	common->Printf( " %5.1f total megabytes of images\n\n\n", totalSize / (1024*1024.0) );
+	common->Printf( " %5.1f total megabytes of images\n", totalSize / (1024*1024.0) );
+	const imageStreamStats_t &stats = globalImages->totalStreamStats;
+	common->Printf( " %5.1f of %5.1f megabytes of streamed images resident\n", globalImages->streamedImageSize / (1024*1024.0), globalImages->image_cacheMegs.GetFloat() );
+	common->Printf( " %i streamed reads of %5.1f megabytes, %i deferred, %i evictions of %5.1f megabytes since level load\n\n\n",
+		stats.reads, stats.readBytes / (1024*1024.0), stats.deferredReads, stats.evictions, stats.evictedBytes / (1024*1024.0) );
 
 	if ( byClassification ) {
 
@@ -1527,9 +1538,6 @@ idImage	*idImageManager::ImageFromFile( const char *_name, textureFilter_t filte
 			if ( image->allowDownSize == allowDownSize && image->depth == depth ) {
 				// note that it is used this level load
 				image->levelLoadReferenced = true;
-				if ( image->partialImage != NULL ) {
-					image->partialImage->levelLoadReferenced = true;
-				}
 				return image;
 			}
 
@@ -1544,17 +1552,16 @@ idImage	*idImageManager::ImageFromFile( const char *_name, textureFilter_t filte
 			if ( image->allowDownSize == allowDownSize && image->depth == depth ) {
 				// the already created one is already the highest quality
 				image->levelLoadReferenced = true;
-				if ( image->partialImage != NULL ) {
-					image->partialImage->levelLoadReferenced = true;
-				}
 				return image;
 			}
 
 			image->allowDownSize = allowDownSize;
 			image->depth = depth;
 			image->levelLoadReferenced = true;
-			if ( image->partialImage != NULL ) {
-				image->partialImage->levelLoadReferenced = true;
+			// images that must not be downsized aren't streamed either
+			if ( image->stream && !allowDownSize ) {
+				image->PurgeImage();
+				image->FreeStream();
 			}
 			if ( image_preload.GetBool() && !insideLevelLoad ) {
 				image->referencedOutsideLevelLoad = true;
@@ -1585,36 +1592,10 @@ idImage	*idImageManager::ImageFromFile( const char *_name, textureFilter_t filte
 	
 	image->levelLoadReferenced = true;
 
-	// also create a shrunken version if we are going to dynamically cache the full size image
-	if ( image->ShouldImageBePartialCached() ) {
-		// if we only loaded part of the file, create a new idImage for the shrunken version
-		image->partialImage = new idImage;
-
-		image->partialImage->allowDownSize = allowDownSize;
-		image->partialImage->repeat = repeat;
-		image->partialImage->depth = depth;
-		image->partialImage->type = TT_2D;
-		image->partialImage->cubeFiles = cubeMap;
-		image->partialImage->filter = filter;
-
-		image->partialImage->levelLoadReferenced = true;
-
-		// we don't bother hooking this into the hash table for lookup, but we do add it to the manager
-		// list for listImages
-		globalImages->images.Append( image->partialImage );
-		image->partialImage->imgName = image->imgName;
-		image->partialImage->isPartialImage = true;
-
-		// let the background file loader know that we can load
-		image->precompressedFile = true;
-
-		if ( image_preload.GetBool() && !insideLevelLoad ) {
-			image->partialImage->ActuallyLoadImage( true, false );	// check for precompressed, load is from front end
-			declManager->MediaPrint( "%ix%i %s\n", image->partialImage->uploadWidth, image->partialImage->uploadHeight, image->imgName.c_str() );
-		} else {
-			declManager->MediaPrint( "%s\n", image->imgName.c_str() );
-		}
-		return image;
+	// large precompressed images only load their small mip levels
+	// and stream the others while they are in view
+	if ( image->ShouldImageBeStreamed() ) {
+		image->AllocStream();
 	}
 
 	// load it if we aren't in a level preload
@@ -1776,113 +1757,6 @@ void R_CombineCubeImages_f( const idCmdArgs &args ) {
 }
 
 
-/*
-==================
-idImage::StartBackgroundImageLoad
-==================
-*/
-void idImage::StartBackgroundImageLoad() {
-	if ( imageManager.numActiveBackgroundImageLoads >= idImageManager::MAX_BACKGROUND_IMAGE_LOADS ) {
-		return;
-	}
-	if ( globalImages->image_showBackgroundLoads.GetBool() ) {
-		common->Printf( "idImage::StartBackgroundImageLoad: %s\n", imgName.c_str() );
-	}
-	backgroundLoadInProgress = true;
-
-	if ( !precompressedFile ) {
-		common->Warning( "idImageManager::StartBackgroundImageLoad: %s wasn't a precompressed file", imgName.c_str() );
-		return;
-	}
-
-	bglNext = globalImages->backgroundImageLoads;
-	globalImages->backgroundImageLoads = this;
-
-	char	filename[MAX_IMAGE_NAME];
-	ImageProgramStringToCompressedFileName( imgName, filename );
-
-	bgl.completed = false;
-	bgl.f = fileSystem->OpenFileRead( filename );
-	if ( !bgl.f ) {
-		common->Warning( "idImageManager::StartBackgroundImageLoad: Couldn't load %s", imgName.c_str() );
-		return;
-	}
-	bgl.file.position = 0;
-	bgl.file.length = bgl.f->Length();
-	if ( bgl.file.length < sizeof( ddsFileHeader_t ) ) {
-		common->Warning( "idImageManager::StartBackgroundImageLoad: %s had a bad file length", imgName.c_str() );
-		return;
-	}
-
-	bgl.file.buffer = R_StaticAlloc( bgl.file.length );
-
-	fileSystem->BackgroundDownload( &bgl );
-
-	imageManager.numActiveBackgroundImageLoads++;
-
-	// purge some images if necessary
-	int		totalSize = 0;
-	for ( idImage *check = globalImages->cacheLRU.cacheUsageNext ; check != &globalImages->cacheLRU ; check = check->cacheUsageNext ) {
-		totalSize += check->StorageSize();
-	}
-	int	needed = this->StorageSize();
-
-	while ( ( totalSize + needed ) > globalImages->image_cacheMegs.GetFloat() * 1024 * 1024 ) {
-		// purge the least recently used
-		idImage	*check = globalImages->cacheLRU.cacheUsagePrev;
-		if ( check->texnum != TEXTURE_NOT_LOADED ) {
-			totalSize -= check->StorageSize();
-			if ( globalImages->image_showBackgroundLoads.GetBool() ) {
-				common->Printf( "purging %s\n", check->imgName.c_str() );
-			}
-			check->PurgeImage();
-		}
-		// remove it from the cached list
-		check->cacheUsageNext->cacheUsagePrev = check->cacheUsagePrev;
-		check->cacheUsagePrev->cacheUsageNext = check->cacheUsageNext;
-		check->cacheUsageNext = NULL;
-		check->cacheUsagePrev = NULL;
-	}
-}
-
-/*
-==================
-R_CompleteBackgroundImageLoads
-
-Do we need to worry about vid_restarts here?
-==================
-*/
-void idImageManager::CompleteBackgroundImageLoads() {
-	idImage	*remainingList = NULL;
-	idImage	*next;
-
-	for ( idImage *image = backgroundImageLoads ; image ; image = next ) {
-		next = image->bglNext;
-		if ( image->bgl.completed ) {
-			numActiveBackgroundImageLoads--;
-			fileSystem->CloseFile( image->bgl.f );
-			// upload the image
-			image->UploadPrecompressedImage( (byte *)image->bgl.file.buffer, image->bgl.file.length );
-			R_StaticFree( image->bgl.file.buffer );
-			if ( image_showBackgroundLoads.GetBool() ) {
-				common->Printf( "R_CompleteBackgroundImageLoad: %s\n", image->imgName.c_str() );
-			}
-		} else {
-			image->bglNext = remainingList;
-			remainingList = image;
-		}
-	}
-	if ( image_showBackgroundLoads.GetBool() ) {
-		static int prev;
-		if ( numActiveBackgroundImageLoads != prev ) {
-			prev = numActiveBackgroundImageLoads;
-			common->Printf( "background Loads: %i\n", numActiveBackgroundImageLoads );
-		}
-	}
-
-	backgroundImageLoads = remainingList;
-}
-
 /*
 ===============
 CheckCvars
@@ -1954,6 +1828,11 @@ void idImageManager::Init() {
 	// clear the cached LRU
 	cacheLRU.cacheUsageNext = &cacheLRU;
 	cacheLRU.cacheUsagePrev = &cacheLRU;
+	cacheWantedTail = &cacheLRU;
+	streamedImageSize = 0;
+	numActiveBackgroundImageLoads = 0;
+
+	R_InitImageProcessJobs();
 
 	// set default texture filter modes
 	ChangeTextureFilter();
@@ -1988,6 +1867,7 @@ void idImageManager::Init() {
 	cmdSystem->AddCommand( "reloadImages", R_ReloadImages_f, CMD_FL_RENDERER, "reloads images" );
 	cmdSystem->AddCommand( "listImages", R_ListImages_f, CMD_FL_RENDERER, "lists images" );
 	cmdSystem->AddCommand( "combineCubeImages", R_CombineCubeImages_f, CMD_FL_RENDERER, "combines six images for roq compression" );
+	cmdSystem->AddCommand( "benchmarkImageProcess", R_BenchmarkImageProcess_f, CMD_FL_RENDERER, "resamples and mip maps the TGAs of a directory and reports the throughput" );
 
 	// should forceLoadImages be here?
 }
@@ -1998,7 +1878,14 @@ Shutdown
 ===============
 */
 void idImageManager::Shutdown() {
+	for ( int i = 0 ; i < images.Num() ; i++ ) {
+		if ( images[i]->stream ) {
+			images[i]->FreeStream();
+		}
+	}
 	images.DeleteContents( true );
+
+	R_ShutdownImageProcessJobs();
 }
 
 /*
@@ -2076,31 +1963,140 @@ void idImageManager::EndLevelLoad() {
 	}
 
 	// load the ones we do need, if we are preloading
+	idList<idImage *>	loadList;
+
+	loadList.SetGranularity( 256 );
 	for ( int i = 0 ; i < images.Num() ; i++ ) {
 		idImage	*image = images[ i ];
 		if ( image->generatorFunction ) {
 			continue;
 		}
 
-		if ( image->levelLoadReferenced && image->texnum == idImage::TEXTURE_NOT_LOADED && !image->partialImage ) {
-//			common->Printf( "Loading %s\n", image->imgName.c_str() );
-			loadCount++;
-			image->ActuallyLoadImage( true, false );
+		if ( image->levelLoadReferenced && image->texnum == idImage::TEXTURE_NOT_LOADED ) {
+			loadList.Append( image );
+		}
+	}
+	loadCount = loadList.Num();
+
+	LoadLevelImages( loadList );
 
-			if ( ( loadCount & 15 ) == 0 ) {
-				session->PacifierUpdate();
-			}
+	int streamCount = 0;
+	for ( int i = 0 ; i < images.Num() ; i++ ) {
+		if ( images[i]->stream ) {
+			streamCount++;
 		}
 	}
+	memset( &totalStreamStats, 0, sizeof( totalStreamStats ) );
 
 	int	end = Sys_Milliseconds();
+	loadStats.AddMsec( LOAD_IMAGES, end - start, loadCount );
 	common->Printf( "%5i purged from previous\n", purgeCount );
 	common->Printf( "%5i kept from previous\n", keepCount );
 	common->Printf( "%5i new loaded\n", loadCount );
+	common->Printf( "%5i streamed\n", streamCount );
 	common->Printf( "all images loaded in %5.1f seconds\n", (end-start) * 0.001 );
 	common->Printf( "----------------------------------------\n" );
 }
 
+/*
+===============
+R_LoadImageJob
+===============
+*/
+static void R_LoadImageJob( imageLoad_t *load ) {
+	load->image->LoadImageData( *load, true );
+}
+
+/*
+===============
+idImageManager::LoadLevelImages
+
+Images that can be loaded by jobs are read, decoded and mip mapped on
+the job threads in batches.  While one batch is processed the main
+thread uploads the previous one, so only the GL uploads are serialized.
+The batch size bounds the decoded images that are held in memory.
+===============
+*/
+static const int IMAGE_LOAD_BATCH = 16;
+
+void idImageManager::LoadLevelImages( idList<idImage *> &loadList ) {
+	int		loadCount = 0;
+
+	// the ones the jobs can't take are loaded the old way first
+	idList<idImage *>	jobImages;
+	bool				useJobs = image_loadJobs.GetBool() && parallelJobManager->GetNumThreads() > 0;
+
+	for ( int i = 0 ; i < loadList.Num() ; i++ ) {
+		idImage *image = loadList[i];
+
+		if ( useJobs && image->CanLoadImageInJob() ) {
+			jobImages.Append( image );
+			continue;
+		}
+
+		double start = Sys_GetClockTicks();
+		loadCount++;
+		image->ActuallyLoadImage( true, false );
+		loadStats.Add( LOAD_IMAGE_UPLOADS, Sys_GetClockTicks() - start, 1 );
+
+		if ( ( loadCount & 15 ) == 0 ) {
+			session->PacifierUpdate();
+		}
+	}
+
+	if ( !jobImages.Num() ) {
+		return;
+	}
+
+	imageLoad_t *loads = (imageLoad_t *)R_StaticAlloc( jobImages.Num() * sizeof( loads[0] ) );
+	idParallelJobList *jobLists[2];
+	jobLists[0] = parallelJobManager->AllocJobList( "R_ImageLoad0" );
+	jobLists[1] = parallelJobManager->AllocJobList( "R_ImageLoad1" );
+
+	int numBatches = ( jobImages.Num() + IMAGE_LOAD_BATCH - 1 ) / IMAGE_LOAD_BATCH;
+
+	for ( int batch = 0 ; batch <= numBatches ; batch++ ) {
+		// start reading the next batch
+		if ( batch < numBatches ) {
+			idParallelJobList *jobList = jobLists[batch & 1];
+			int first = batch * IMAGE_LOAD_BATCH;
+			int last = Min( first + IMAGE_LOAD_BATCH, jobImages.Num() );
+
+			jobList->Clear();
+			for ( int i = first ; i < last ; i++ ) {
+				loads[i].image = jobImages[i];
+				jobList->AddJob( (jobRun_t)R_LoadImageJob, &loads[i] );
+			}
+			jobList->Submit();
+		}
+
+		// upload the previous one while it runs
+		if ( batch > 0 ) {
+			idParallelJobList *jobList = jobLists[( batch - 1 ) & 1];
+			int first = ( batch - 1 ) * IMAGE_LOAD_BATCH;
+			int last = Min( first + IMAGE_LOAD_BATCH, jobImages.Num() );
+
+			jobList->Wait();
+			loadStats.AddMsec( LOAD_IMAGE_READS, jobList->GetStats().jobMicroSec * 0.001f, last - first );
+
+			double start = Sys_GetClockTicks();
+			for ( int i = first ; i < last ; i++ ) {
+				loads[i].image->FinishImageLoad( loads[i] );
+
+				loadCount++;
+				if ( ( loadCount & 15 ) == 0 ) {
+					session->PacifierUpdate();
+				}
+			}
+			loadStats.Add( LOAD_IMAGE_UPLOADS, Sys_GetClockTicks() - start, last - first );
+		}
+	}
+
+	parallelJobManager->FreeJobList( jobLists[0] );
+	parallelJobManager->FreeJobList( jobLists[1] );
+	R_StaticFree( loads );
+}
+
 /*
 ===============
 idImageManager::StartBuild
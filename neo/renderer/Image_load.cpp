@@ -440,10 +440,7 @@ There is no way to specify explicit mip map levels
 void idImage::GenerateImage( const byte *pic, int width, int height, 
 					   textureFilter_t filterParm, bool allowDownSizeParm, 
 					   textureRepeat_t repeatParm, textureDepth_t depthParm ) {
-	bool	preserveBorder;
-	byte		*scaledBuffer;
-	int			scaled_width, scaled_height;
-	byte		*shrunk;
+	imageLevels_t	levels;
 
 	PurgeImage();
 
@@ -460,6 +457,25 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 		return;
 	}
 
+	BuildImageLevels( pic, width, height, levels );
+	UploadImageLevels( levels );
+}
+
+/*
+================
+BuildImageLevels
+
+The part of GenerateImage that doesn't touch GL, it selects the internal
+format, resamples and builds the complete mip chain using the current
+filter, repeat and depth parms.  Level loads run it on job threads.
+================
+*/
+void idImage::BuildImageLevels( const byte *pic, int width, int height, imageLevels_t &levels ) {
+	bool	preserveBorder;
+	byte		*scaledBuffer;
+	int			scaled_width, scaled_height;
+	byte		*shrunk;
+
 	// don't let mip mapping smear the texture into the clamped border
 	if ( repeat == TR_CLAMP_TO_ZERO ) {
 		preserveBorder = true;
@@ -480,9 +496,6 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 
 	scaledBuffer = NULL;
 
-	// generate the texture number
-	glGenTextures( 1, &texnum );
-
 	// select proper internal format before we resample
 	internalFormat = SelectInternalFormat( &pic, 1, width, height, depth, &isMonochrome );
 
@@ -587,19 +600,17 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 			scaledBuffer[ i ] = 0;
 		}
 	}
-	// upload the main image level
-	Bind();
 
-	glTexImage2D( GL_TEXTURE_2D, 0, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer );
-
-	// create and upload the mip map levels, which we do in all cases, even if we don't think they are needed
-	int		miplevel;
+	// the main image level
+	levels.numLevels = 1;
+	levels.widths[0] = scaled_width;
+	levels.heights[0] = scaled_height;
+	levels.levels[0] = scaledBuffer;
 
-	miplevel = 0;
+	// create the mip map levels, which we do in all cases, even if we don't think they are needed
 	while ( scaled_width > 1 || scaled_height > 1 ) {
 		// preserve the border after mip map unless repeating
 		shrunk = R_MipMap( scaledBuffer, scaled_width, scaled_height, preserveBorder );
-		R_StaticFree( scaledBuffer );
 		scaledBuffer = shrunk;
 
 		scaled_width >>= 1;
@@ -610,23 +621,42 @@ void idImage::GenerateImage( const byte *pic, int width, int height,
 		if ( scaled_height < 1 ) {
 			scaled_height = 1;
 		}
-		miplevel++;
 
 		// this is a visualization tool that shades each mip map
 		// level with a different color so you can see the
 		// rasterizer's texture level selection algorithm
 		// Changing the color doesn't help with lumminance/alpha/intensity formats...
 		if ( depth == TD_DIFFUSE && globalImages->image_colorMipLevels.GetBool() ) {
-			R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[miplevel] );
+			R_BlendOverTexture( (byte *)scaledBuffer, scaled_width * scaled_height, mipBlendColors[levels.numLevels] );
 		}
 
-		// upload the mip map
-		glTexImage2D(GL_TEXTURE_2D, miplevel, internalFormat, scaled_width, scaled_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, scaledBuffer);
+		levels.widths[levels.numLevels] = scaled_width;
+		levels.heights[levels.numLevels] = scaled_height;
+		levels.levels[levels.numLevels] = scaledBuffer;
+		levels.numLevels++;
 	}
+}
 
-	if ( scaledBuffer != 0 ) {
-		R_StaticFree( scaledBuffer );
+/*
+================
+UploadImageLevels
+
+Creates the texture object and uploads a mip chain built by
+BuildImageLevels, the levels are freed.
+================
+*/
+void idImage::UploadImageLevels( imageLevels_t &levels ) {
+	// generate the texture number
+	glGenTextures( 1, &texnum );
+
+	// upload the main image level and the mip map levels
+	Bind();
+
+	for ( int i = 0 ; i < levels.numLevels ; i++ ) {
+		glTexImage2D( GL_TEXTURE_2D, i, internalFormat, levels.widths[i], levels.heights[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, levels.levels[i] );
+		R_StaticFree( levels.levels[i] );
 	}
+	levels.numLevels = 0;
 
 	SetImageFilterAndRepeat();
 
@@ -942,49 +972,53 @@ int	idImage::NumLevelsForImageSize( int width, int height ) const {
 	return numLevels;
 }
 
+/*
+================
+R_WritingPrecompressedImages
+================
+*/
+static bool R_WritingPrecompressedImages( void ) {
+	// Always write the precompressed image if we're making a build
+	if ( com_makingBuild.GetBool() ) {
+		return true;
+	}
+	return globalImages->image_writePrecompressedTextures.GetBool() && globalImages->image_usePrecompressedTextures.GetBool();
+}
+
 /*
 ================
 WritePrecompressedImage
 
 When we are happy with our source data, we can write out precompressed
 versions of everything to speed future load times.
+
+The levels are compressed or converted on the CPU, so this doesn't need
+a GL context and the files don't depend on the driver.
 ================
 */
-void idImage::WritePrecompressedImage() {
+void idImage::WritePrecompressedImage( const imageLevels_t &levels ) {
 
-	// Always write the precompressed image if we're making a build
-	if ( !com_makingBuild.GetBool() ) {
-		if ( !globalImages->image_writePrecompressedTextures.GetBool() || !globalImages->image_usePrecompressedTextures.GetBool() ) {
-			return;
-		}
+	if ( !R_WritingPrecompressedImages() ) {
+		return;
 	}
 
-	if ( !glConfig.isInitialized ) {
+	if ( levels.numLevels == 0 ) {
 		return;
 	}
 
 	char filename[MAX_IMAGE_NAME];
 	ImageProgramStringToCompressedFileName( imgName, filename );
 
-
-
-	int numLevels = NumLevelsForImageSize( uploadWidth, uploadHeight );
+	int numLevels = levels.numLevels;
 	if ( numLevels > MAX_TEXTURE_LEVELS ) {
 		common->Warning( "R_WritePrecompressedImage: level > MAX_TEXTURE_LEVELS for image %s", filename );
 		return;
 	}
 
-	// glGetTexImage only supports a small subset of all the available internal formats
 	// We have to use BGRA because DDS is a windows based format
 	int altInternalFormat = 0;
 	int bitSize = 0;
 	switch ( internalFormat ) {
-		case GL_COLOR_INDEX:
-			// this will not work with dds viewers but we need it in this format to save disk
-			// load speed ( i.e. size ) 
-			altInternalFormat = GL_COLOR_INDEX;
-			bitSize = 24;
-		break;
 		case 1:
 		case GL_INTENSITY8:
 		case GL_LUMINANCE8:
@@ -1012,6 +1046,10 @@ void idImage::WritePrecompressedImage() {
 			}
 	}
 
+	// the red channel of rxgb normal maps has been swapped into alpha
+	bool rxgb = ( depth == TD_BUMP && altInternalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+					&& globalImages->image_useNormalCompression.GetInteger() != 1 );
+
 	if ( globalImages->image_useOffLineCompression.GetBool() && FormatIsDXT( altInternalFormat ) ) {
 		idStr outFile = fileSystem->RelativePathToOSPath( filename, "fs_basepath" );
 		idStr inFile = outFile;
@@ -1088,7 +1126,7 @@ void idImage::WritePrecompressedImage() {
 			header.ddspf.dwFourCC = DDS_MAKEFOURCC('D','X','T','3');
 			break;
 		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-			header.ddspf.dwFourCC = DDS_MAKEFOURCC('D','X','T','5');
+			header.ddspf.dwFourCC = rxgb ? DDS_MAKEFOURCC('R','X','G','B') : DDS_MAKEFOURCC('D','X','T','5');
 			break;
 		}
 	} else {
@@ -1102,7 +1140,6 @@ void idImage::WritePrecompressedImage() {
 			// Fall through
 		case GL_BGR:
 		case GL_LUMINANCE:
-		case GL_COLOR_INDEX:
 			header.ddspf.dwRBitMask = 0x00FF0000;
 			header.ddspf.dwGBitMask = 0x0000FF00;
 			header.ddspf.dwBBitMask = 0x000000FF;
@@ -1127,65 +1164,65 @@ void idImage::WritePrecompressedImage() {
 	f->Write( "DDS ", 4 );
 	f->Write( &header, sizeof(header) );
 
-	// bind to the image so we can read back the contents
-	Bind();
-
-	glPixelStorei( GL_PACK_ALIGNMENT, 1 );	// otherwise small rows get padded to 32 bits
-
-	int uw = uploadWidth;
-	int uh = uploadHeight;
-
-	// Will be allocated first time through the loop
-	byte *data = NULL;
+	// the first level is the largest
+	int size;
+	if ( FormatIsDXT( altInternalFormat ) ) {
+		size = R_CompressedImageSize( altInternalFormat, levels.widths[0], levels.heights[0] );
+	} else {
+		size = levels.widths[0] * levels.heights[0] * ( bitSize / 8 );
+	}
+	byte *data = (byte *)R_StaticAlloc( size );
 
 	for ( int level = 0 ; level < numLevels ; level++ ) {
+		int uw = levels.widths[level];
+		int uh = levels.heights[level];
+		const byte *src = levels.levels[level];
 
-		int size = 0;
 		if ( FormatIsDXT( altInternalFormat ) ) {
-			size = ( ( uw + 3 ) / 4 ) * ( ( uh + 3 ) / 4 ) *
-				(altInternalFormat <= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16);
+			size = R_CompressedImageSize( altInternalFormat, uw, uh );
+			R_CompressImage( data, src, uw, uh, altInternalFormat );
 		} else {
-			size = uw * uh * (bitSize / 8);
-		}
-
-		if (data == NULL) {
-			data = (byte *)R_StaticAlloc( size );
-		}
-
-		if ( FormatIsDXT( altInternalFormat ) ) {
-			glGetCompressedTexImage( GL_TEXTURE_2D, level, data );
-		} else {
-			glGetTexImage( GL_TEXTURE_2D, level, altInternalFormat, GL_UNSIGNED_BYTE, data );
+			int numTexels = uw * uh;
+			byte *dst = data;
+
+			size = numTexels * ( bitSize / 8 );
+			for ( int i = 0 ; i < numTexels ; i++, src += 4 ) {
+				switch ( altInternalFormat ) {
+				case GL_BGRA:
+					*dst++ = src[2];
+					*dst++ = src[1];
+					*dst++ = src[0];
+					*dst++ = src[3];
+					break;
+				case GL_BGR:
+					*dst++ = src[2];
+					*dst++ = src[1];
+					*dst++ = src[0];
+					break;
+				case GL_ALPHA:
+					*dst++ = src[3];
+					break;
+				}
+			}
 		}
 
 		f->Write( data, size );
-
-		uw /= 2;
-		uh /= 2;
-		if (uw < 1) {
-			uw = 1;
-		}
-		if (uh < 1) {
-			uh = 1;
-		}
 	}
 
-	if (data != NULL) {
-		R_StaticFree( data );
-	}
+	R_StaticFree( data );
 
 	fileSystem->CloseFile( f );
 }
 
 /*
 ================
-ShouldImageBePartialCached
+ShouldImageBeStreamed
 
 Returns true if there is a precompressed image, and it is large enough
-to be worth caching
+to be worth streaming
 ================
 */
-bool idImage::ShouldImageBePartialCached() {
+bool idImage::ShouldImageBeStreamed() {
 	if ( !glConfig.textureCompressionAvailable ) {
 		return false;
 	}
@@ -1194,8 +1231,8 @@ bool idImage::ShouldImageBePartialCached() {
 		return false;
 	}
 
-	// the allowDownSize flag does double-duty as don't-partial-load
-	if ( !allowDownSize ) {
+	// the allowDownSize flag does double-duty as don't-stream
+	if ( !allowDownSize || cubeFiles != CF_2D ) {
 		return false;
 	}
 
@@ -1233,18 +1270,22 @@ bool idImage::ShouldImageBePartialCached() {
 		return false;
 	}
 
-	// we do want to do a partial load
+	// we do want to stream it
 	return true;
 }
 
 /*
 ================
-CheckPrecompressedImage
+ReadPrecompressedImage
 
-If fullLoad is false, only the small mip levels of the image will be loaded
+Reads the .dds file of the image if there is a usable one, the caller
+uploads and frees the data.  Doesn't touch GL.
+
+If fullLoad is false, only the header and the small mip levels of the
+streamed image are read.
 ================
 */
-bool idImage::CheckPrecompressedImage( bool fullLoad ) {
+bool idImage::ReadPrecompressedImage( bool fullLoad, byte **data, int *dataLength ) {
 	if ( !glConfig.isInitialized || !glConfig.textureCompressionAvailable ) {
 		return false;
 	}
@@ -1295,169 +1336,152 @@ bool idImage::CheckPrecompressedImage( bool fullLoad ) {
 	}
 
 	int	len = f->Length();
-	if ( len < sizeof( ddsFileHeader_t ) ) {
+	if ( len < 4 + sizeof( ddsFileHeader_t ) ) {
 		fileSystem->CloseFile( f );
 		return false;
 	}
 
-	if ( !fullLoad && len > globalImages->image_cacheMinK.GetInteger() * 1024 ) {
-		len = globalImages->image_cacheMinK.GetInteger() * 1024;
+	if ( !fullLoad ) {
+		bool read = ReadStreamedImageTail( f, data, dataLength );
+		fileSystem->CloseFile( f );
+		return read;
 	}
 
-	byte *data = (byte *)R_StaticAlloc( len );
+	byte *buffer = (byte *)R_StaticAlloc( len );
 
-	f->Read( data, len );
+	f->Read( buffer, len );
 
 	fileSystem->CloseFile( f );
 
-	unsigned long magic = LittleLong( *(unsigned long *)data );
-	ddsFileHeader_t	*_header = (ddsFileHeader_t *)(data + 4);
-	int ddspf_dwFlags = LittleLong( _header->ddspf.dwFlags );
-
-	if ( magic != DDS_MAKEFOURCC('D', 'D', 'S', ' ')) {
-		common->Printf( "CheckPrecompressedImage( %s ): magic != 'DDS '\n", imgName.c_str() );
-		R_StaticFree( data );
+	ddsLayout_t	layout;
+	if ( !ParsePrecompressedHeader( buffer, layout ) || layout.offsets[layout.numLevels] > len ) {
+		R_StaticFree( buffer );
 		return false;
 	}
 
-	// if we don't support color index textures, we must load the full image
-	// should we just expand the 256 color image to 32 bit for upload?
-	if ( ddspf_dwFlags & DDSF_ID_INDEXCOLOR && !glConfig.sharedTexturePaletteAvailable ) {
-		R_StaticFree( data );
-		return false;
-	}
-
-	// upload all the levels
-	UploadPrecompressedImage( data, len );
-
-	R_StaticFree( data );
+	*data = buffer;
+	*dataLength = len;
 
 	return true;
 }
 
 /*
 ===================
-UploadPrecompressedImage
+ParsePrecompressedHeader
 
-This can be called by the front end during nromal loading,
-or by the backend after a background read of the file
-has completed
+Finds the format and the position of every mip level of a .dds file,
+returns false if it can't be used
 ===================
 */
-void idImage::UploadPrecompressedImage( byte *data, int len ) {
-	ddsFileHeader_t	*header = (ddsFileHeader_t *)(data + 4);
+bool idImage::ParsePrecompressedHeader( const byte *data, ddsLayout_t &layout ) {
+	ddsFileHeader_t	header;
 
-	// ( not byte swapping dwReserved1 dwReserved2 )
-	header->dwSize = LittleLong( header->dwSize );
-	header->dwFlags = LittleLong( header->dwFlags );
-	header->dwHeight = LittleLong( header->dwHeight );
-	header->dwWidth = LittleLong( header->dwWidth );
-	header->dwPitchOrLinearSize = LittleLong( header->dwPitchOrLinearSize );
-	header->dwDepth = LittleLong( header->dwDepth );
-	header->dwMipMapCount = LittleLong( header->dwMipMapCount );
-	header->dwCaps1 = LittleLong( header->dwCaps1 );
-	header->dwCaps2 = LittleLong( header->dwCaps2 );
-
-	header->ddspf.dwSize = LittleLong( header->ddspf.dwSize );
-	header->ddspf.dwFlags = LittleLong( header->ddspf.dwFlags );
-	header->ddspf.dwFourCC = LittleLong( header->ddspf.dwFourCC );
-	header->ddspf.dwRGBBitCount = LittleLong( header->ddspf.dwRGBBitCount );
-	header->ddspf.dwRBitMask = LittleLong( header->ddspf.dwRBitMask );
-	header->ddspf.dwGBitMask = LittleLong( header->ddspf.dwGBitMask );
-	header->ddspf.dwBBitMask = LittleLong( header->ddspf.dwBBitMask );
-	header->ddspf.dwABitMask = LittleLong( header->ddspf.dwABitMask );
+	unsigned long magic = LittleLong( *(unsigned long *)data );
+	if ( magic != DDS_MAKEFOURCC('D', 'D', 'S', ' ')) {
+		common->Printf( "ReadPrecompressedImage( %s ): magic != 'DDS '\n", imgName.c_str() );
+		return false;
+	}
 
-	// generate the texture number
-	glGenTextures( 1, &texnum );
+	memcpy( &header, data + 4, sizeof( header ) );
 
-	int externalFormat = 0;
+	// ( not byte swapping dwReserved1 dwReserved2 )
+	header.dwSize = LittleLong( header.dwSize );
+	header.dwFlags = LittleLong( header.dwFlags );
+	header.dwHeight = LittleLong( header.dwHeight );
+	header.dwWidth = LittleLong( header.dwWidth );
+	header.dwPitchOrLinearSize = LittleLong( header.dwPitchOrLinearSize );
+	header.dwDepth = LittleLong( header.dwDepth );
+	header.dwMipMapCount = LittleLong( header.dwMipMapCount );
+	header.dwCaps1 = LittleLong( header.dwCaps1 );
+	header.dwCaps2 = LittleLong( header.dwCaps2 );
+
+	header.ddspf.dwSize = LittleLong( header.ddspf.dwSize );
+	header.ddspf.dwFlags = LittleLong( header.ddspf.dwFlags );
+	header.ddspf.dwFourCC = LittleLong( header.ddspf.dwFourCC );
+	header.ddspf.dwRGBBitCount = LittleLong( header.ddspf.dwRGBBitCount );
+	header.ddspf.dwRBitMask = LittleLong( header.ddspf.dwRBitMask );
+	header.ddspf.dwGBitMask = LittleLong( header.ddspf.dwGBitMask );
+	header.ddspf.dwBBitMask = LittleLong( header.ddspf.dwBBitMask );
+	header.ddspf.dwABitMask = LittleLong( header.ddspf.dwABitMask );
 
-	precompressedFile = true;
+	// if we don't support color index textures, we must load the full image
+	// should we just expand the 256 color image to 32 bit for upload?
+	if ( header.ddspf.dwFlags & DDSF_ID_INDEXCOLOR && !glConfig.sharedTexturePaletteAvailable ) {
+		return false;
+	}
 
-	uploadWidth = header->dwWidth;
-	uploadHeight = header->dwHeight;
-    if ( header->ddspf.dwFlags & DDSF_FOURCC ) {
-        switch ( header->ddspf.dwFourCC ) {
+	layout.externalFormat = 0;
+    if ( header.ddspf.dwFlags & DDSF_FOURCC ) {
+        switch ( header.ddspf.dwFourCC ) {
         case DDS_MAKEFOURCC( 'D', 'X', 'T', '1' ):
-			if ( header->ddspf.dwFlags & DDSF_ALPHAPIXELS ) {
-				internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			if ( header.ddspf.dwFlags & DDSF_ALPHAPIXELS ) {
+				layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
 			} else {
-				internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+				layout.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
 			}
             break;
         case DDS_MAKEFOURCC( 'D', 'X', 'T', '3' ):
-            internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
             break;
         case DDS_MAKEFOURCC( 'D', 'X', 'T', '5' ):
-            internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
             break;
 		case DDS_MAKEFOURCC( 'R', 'X', 'G', 'B' ):
-			internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			layout.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 			break;
         default:
             common->Warning( "Invalid compressed internal format\n" );
-            return;
+            return false;
         }
-    } else if ( ( header->ddspf.dwFlags & DDSF_RGBA ) && header->ddspf.dwRGBBitCount == 32 ) {
-		externalFormat = GL_BGRA;
-		internalFormat = GL_RGBA8;
-    } else if ( ( header->ddspf.dwFlags & DDSF_RGB ) && header->ddspf.dwRGBBitCount == 32 ) {
-        externalFormat = GL_BGRA;
-		internalFormat = GL_RGBA8;
-    } else if ( ( header->ddspf.dwFlags & DDSF_RGB ) && header->ddspf.dwRGBBitCount == 24 ) {
-		externalFormat = GL_BGR;
-		internalFormat = GL_RGB8;
-	} else if ( header->ddspf.dwRGBBitCount == 8 ) {
-		externalFormat = GL_ALPHA;
-		internalFormat = GL_ALPHA8;
+    } else if ( ( header.ddspf.dwFlags & DDSF_RGBA ) && header.ddspf.dwRGBBitCount == 32 ) {
+		layout.externalFormat = GL_BGRA;
+		layout.internalFormat = GL_RGBA8;
+    } else if ( ( header.ddspf.dwFlags & DDSF_RGB ) && header.ddspf.dwRGBBitCount == 32 ) {
+        layout.externalFormat = GL_BGRA;
+		layout.internalFormat = GL_RGBA8;
+    } else if ( ( header.ddspf.dwFlags & DDSF_RGB ) && header.ddspf.dwRGBBitCount == 24 ) {
+		layout.externalFormat = GL_BGR;
+		layout.internalFormat = GL_RGB8;
+	} else if ( header.ddspf.dwRGBBitCount == 8 ) {
+		layout.externalFormat = GL_ALPHA;
+		layout.internalFormat = GL_ALPHA8;
 	} else {
 		common->Warning( "Invalid uncompressed internal format\n" );
-		return;
+		return false;
 	}
 
-	// we need the monochrome flag for the NV20 optimized path
-	if ( header->dwFlags & DDSF_ID_MONOCHROME ) {
-		isMonochrome = true;
+	layout.numLevels = 1;
+	if ( header.dwFlags & DDSF_MIPMAPCOUNT ) {
+		layout.numLevels = header.dwMipMapCount;
 	}
-
-	type = TT_2D;			// FIXME: we may want to support pre-compressed cube maps in the future
-
-	Bind();
-
-	int numMipmaps = 1;
-	if ( header->dwFlags & DDSF_MIPMAPCOUNT ) {
-		numMipmaps = header->dwMipMapCount;
+	if ( layout.numLevels < 1 || layout.numLevels > MAX_IMAGE_LEVELS ) {
+		common->Warning( "%s has %i mip levels", imgName.c_str(), layout.numLevels );
+		return false;
 	}
 
-	int uw = uploadWidth;
-	int uh = uploadHeight;
-
-	// We may skip some mip maps if we are downsizing
-	int skipMip = 0;
-	GetDownsize( uploadWidth, uploadHeight );
+	// we need the monochrome flag for the NV20 optimized path
+	if ( header.dwFlags & DDSF_ID_MONOCHROME ) {
+		isMonochrome = true;
+	}
 
-	byte *imagedata = data + sizeof(ddsFileHeader_t) + 4;
+	int uw = header.dwWidth;
+	int uh = header.dwHeight;
+	int offset = 4 + sizeof( ddsFileHeader_t );
 
-	for ( int i = 0 ; i < numMipmaps; i++ ) {
+	for ( int i = 0 ; i < layout.numLevels; i++ ) {
 		int size = 0;
-		if ( FormatIsDXT( internalFormat ) ) {
+		if ( FormatIsDXT( layout.internalFormat ) ) {
 			size = ( ( uw + 3 ) / 4 ) * ( ( uh + 3 ) / 4 ) *
-				(internalFormat <= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16);
+				(layout.internalFormat <= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16);
 		} else {
-			size = uw * uh * (header->ddspf.dwRGBBitCount / 8);
+			size = uw * uh * (header.ddspf.dwRGBBitCount / 8);
 		}
 
-		if ( uw > uploadWidth || uh > uploadHeight ) {
-			skipMip++;
-		} else {
-			if ( FormatIsDXT( internalFormat ) ) {
-				glCompressedTexImage2D( GL_TEXTURE_2D, i - skipMip, internalFormat, uw, uh, 0, size, imagedata );
-			} else {
-				glTexImage2D( GL_TEXTURE_2D, i - skipMip, internalFormat, uw, uh, 0, externalFormat, GL_UNSIGNED_BYTE, imagedata );
-			}
-		}
+		layout.widths[i] = uw;
+		layout.heights[i] = uh;
+		layout.offsets[i] = offset;
 
-		imagedata += size;
+		offset += size;
 		uw /= 2;
 		uh /= 2;
 		if (uw < 1) {
@@ -1467,10 +1491,72 @@ void idImage::UploadPrecompressedImage( byte *data, int len ) {
 			uh = 1;
 		}
 	}
+	layout.offsets[layout.numLevels] = offset;
+
+	return true;
+}
+
+/*
+===================
+UploadPrecompressedImage
+
+This can be called by the front end during nromal loading,
+or by the backend after a background read of the file
+has completed
+===================
+*/
+void idImage::UploadPrecompressedImage( byte *data, int len ) {
+	ddsLayout_t	layout;
+
+	if ( !ParsePrecompressedHeader( data, layout ) || layout.offsets[layout.numLevels] > len ) {
+		MakeDefault();
+		return;
+	}
+
+	// generate the texture number
+	glGenTextures( 1, &texnum );
+
+	precompressedFile = true;
+	internalFormat = layout.internalFormat;
+
+	type = TT_2D;			// FIXME: we may want to support pre-compressed cube maps in the future
+
+	Bind();
+
+	// We may skip some mip maps if we are downsizing
+	int skipMip = 0;
+	uploadWidth = layout.widths[0];
+	uploadHeight = layout.heights[0];
+	GetDownsize( uploadWidth, uploadHeight );
+
+	for ( int i = 0 ; i < layout.numLevels; i++ ) {
+		if ( layout.widths[i] > uploadWidth || layout.heights[i] > uploadHeight ) {
+			skipMip++;
+		} else {
+			UploadPrecompressedLevel( layout, i, i - skipMip, data + layout.offsets[i] );
+		}
+	}
 
 	SetImageFilterAndRepeat();
 }
 
+/*
+===================
+UploadPrecompressedLevel
+
+Uploads a level of a .dds file to the bound texture
+===================
+*/
+void idImage::UploadPrecompressedLevel( const ddsLayout_t &layout, int level, int glLevel, const byte *data ) {
+	int size = layout.offsets[level + 1] - layout.offsets[level];
+
+	if ( FormatIsDXT( layout.internalFormat ) ) {
+		glCompressedTexImage2D( GL_TEXTURE_2D, glLevel, layout.internalFormat, layout.widths[level], layout.heights[level], 0, size, data );
+	} else {
+		glTexImage2D( GL_TEXTURE_2D, glLevel, layout.internalFormat, layout.widths[level], layout.heights[level], 0, layout.externalFormat, GL_UNSIGNED_BYTE, data );
+	}
+}
+
 /*
 ===============
 ActuallyLoadImage
@@ -1480,8 +1566,9 @@ On exit, the idImage will have a valid OpenGL texture number that can be bound
 ===============
 */
 void	idImage::ActuallyLoadImage( bool checkForPrecompressed, bool fromBackEnd ) {
-	int		width, height;
-	byte	*pic;
+	int		width;
+
+	idScopedMemTag	memTag( MEM_TAG_IMAGE );
 
 	// this is the ONLY place generatorFunction will ever be called
 	if ( generatorFunction ) {
@@ -1489,16 +1576,6 @@ void	idImage::ActuallyLoadImage( bool checkForPrecompressed, bool fromBackEnd )
 		return;
 	}
 
-	// if we are a partial image, we are only going to load from a compressed file
-	if ( isPartialImage ) {
-		if ( CheckPrecompressedImage( false ) ) {
-			return;
-		}
-		// this is an error -- the partial image failed to load
-		MakeDefault();
-		return;
-	}
-
 	//
 	// load the image from disk
 	//
@@ -1523,49 +1600,145 @@ void	idImage::ActuallyLoadImage( bool checkForPrecompressed, bool fromBackEnd )
 			}
 		}
 	} else {
-		// see if we have a pre-generated image file that is
-		// already image processed and compressed
-		if ( checkForPrecompressed && globalImages->image_usePrecompressedTextures.GetBool() ) {
-			if ( CheckPrecompressedImage( true ) ) {
-				// we got the precompressed image
-				return;
-			}
-			// fall through to load the normal image
-		}
+		imageLoad_t	load;
 
-		R_LoadImageProgram( imgName, &pic, &width, &height, &timestamp, &depth );
+		LoadImageData( load, checkForPrecompressed );
+		FinishImageLoad( load );
+	}
+}
 
-		if ( pic == NULL ) {
-			common->Warning( "Couldn't load image: %s", imgName.c_str() );
-			MakeDefault();
+/*
+===============
+CanLoadImageInJob
+
+Level loads read and decode plain 2D file images on job threads
+===============
+*/
+bool idImage::CanLoadImageInJob() const {
+	if ( generatorFunction || cubeFiles != CF_2D ) {
+		return false;
+	}
+	// the debug writes would go to the file system from the job
+	if ( globalImages->image_writeTGA.GetBool() || globalImages->image_writeNormalTGA.GetBool() ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+===============
+LoadImageData
+
+The file reading and processing half of loading a 2D image, which
+doesn't touch GL and only writes to this image and the load.
+===============
+*/
+void idImage::LoadImageData( imageLoad_t &load, bool checkForPrecompressed ) {
+	int		width, height;
+	byte	*pic;
+
+	idScopedMemTag	memTag( MEM_TAG_IMAGE );
+
+	load.image = this;
+	load.found = false;
+	load.precompressed = NULL;
+	load.precompressedLength = 0;
+	load.levels.numLevels = 0;
+
+	// see if we have a pre-generated image file that is
+	// already image processed and compressed, streamed
+	// images only read their small mip levels here
+	if ( checkForPrecompressed && globalImages->image_usePrecompressedTextures.GetBool() ) {
+		if ( ReadPrecompressedImage( stream == NULL, &load.precompressed, &load.precompressedLength ) ) {
+			// we got the precompressed image
+			load.found = true;
 			return;
 		}
+		// fall through to load the normal image
+	}
+
+	R_LoadImageProgram( imgName, &pic, &width, &height, &timestamp, &depth );
+
+	if ( pic == NULL ) {
+		return;
+	}
 /*
-		// swap the red and alpha for rxgb support
-		// do this even on tga normal maps so we only have to use
-		// one fragment program
-		// if the image is precompressed ( either in palletized mode or true rxgb mode )
-		// then it is loaded above and the swap never happens here
-		if ( depth == TD_BUMP && globalImages->image_useNormalCompression.GetInteger() != 1 ) {
-			for ( int i = 0; i < width * height * 4; i += 4 ) {
-				pic[ i + 3 ] = pic[ i ];
-				pic[ i ] = 0;
-			}
+	// swap the red and alpha for rxgb support
+	// do this even on tga normal maps so we only have to use
+	// one fragment program
+	// if the image is precompressed ( either in palletized mode or true rxgb mode )
+	// then it is loaded above and the swap never happens here
+	if ( depth == TD_BUMP && globalImages->image_useNormalCompression.GetInteger() != 1 ) {
+		for ( int i = 0; i < width * height * 4; i += 4 ) {
+			pic[ i + 3 ] = pic[ i ];
+			pic[ i ] = 0;
 		}
+	}
 */
-		// build a hash for checking duplicate image files
-		// NOTE: takes about 10% of image load times (SD)
-		// may not be strictly necessary, but some code uses it, so let's leave it in
-		imageHash = MD4_BlockChecksum( pic, width * height * 4 );
+	// build a hash for checking duplicate image files
+	// NOTE: takes about 10% of image load times (SD)
+	// may not be strictly necessary, but some code uses it, so let's leave it in
+	imageHash = MD4_BlockChecksum( pic, width * height * 4 );
 
-		GenerateImage( pic, width, height, filter, allowDownSize, repeat, depth );
-		timestamp = timestamp;
-		precompressedFile = false;
+	// without a rendering context GenerateImage only records the parms,
+	// unless the null driver is used to write precompressed images
+	if ( glConfig.isInitialized || ( tr.nullDriver && R_WritingPrecompressedImages() ) ) {
+		BuildImageLevels( pic, width, height, load.levels );
+	}
+	load.found = true;
+
+	R_StaticFree( pic );
+}
+
+/*
+===============
+FinishImageLoad
+
+The GL half of loading a 2D image, always on the main thread
+===============
+*/
+void idImage::FinishImageLoad( imageLoad_t &load ) {
+	idScopedMemTag	memTag( MEM_TAG_IMAGE );
+
+	if ( !load.found ) {
+		common->Warning( "Couldn't load image: %s", imgName.c_str() );
+		MakeDefault();
+		return;
+	}
+
+	if ( load.precompressed ) {
+		// upload all the levels, or the small ones of a streamed image
+		if ( stream ) {
+			UploadStreamedImage( load.precompressed, load.precompressedLength );
+		} else {
+			UploadPrecompressedImage( load.precompressed, load.precompressedLength );
+		}
+		R_StaticFree( load.precompressed );
+		load.precompressed = NULL;
+		return;
+	}
+
+	// only precompressed files can be streamed
+	if ( stream ) {
+		FreeStream();
+	}
+
+	PurgeImage();
+	precompressedFile = false;
 
-		R_StaticFree( pic );
+	// write out the precompressed version of this file if needed
+	WritePrecompressedImage( load.levels );
 
-		// write out the precompressed version of this file if needed
-		WritePrecompressedImage();
+	if ( glConfig.isInitialized ) {
+		if ( load.levels.numLevels ) {
+			UploadImageLevels( load.levels );
+		}
+	} else {
+		// the levels were only built to write the precompressed image
+		for ( int i = 0 ; i < load.levels.numLevels ; i++ ) {
+			R_StaticFree( load.levels.levels[i] );
+		}
+		load.levels.numLevels = 0;
 	}
 }
 
@@ -1577,6 +1750,10 @@ PurgeImage
 ===============
 */
 void idImage::PurgeImage() {
+	if ( stream ) {
+		PurgeStream();
+	}
+
 	if ( texnum != TEXTURE_NOT_LOADED ) {
 		glDeleteTextures( 1, &texnum );	// this should be the ONLY place it is ever called!
 		texnum = TEXTURE_NOT_LOADED;
@@ -1602,34 +1779,8 @@ void idImage::Bind() {
 		RB_LogComment( "idImage::Bind( %s )\n", imgName.c_str() );
 	}
 
-	// if this is an image that we are caching, move it to the front of the LRU chain
-	if ( partialImage ) {
-		if ( cacheUsageNext ) {
-			// unlink from old position
-			cacheUsageNext->cacheUsagePrev = cacheUsagePrev;
-			cacheUsagePrev->cacheUsageNext = cacheUsageNext;
-		}
-		// link in at the head of the list
-		cacheUsageNext = globalImages->cacheLRU.cacheUsageNext;
-		cacheUsagePrev = &globalImages->cacheLRU;
-
-		cacheUsageNext->cacheUsagePrev = this;
-		cacheUsagePrev->cacheUsageNext = this;
-	}
-
 	// load the image if necessary (FIXME: not SMP safe!)
 	if ( texnum == TEXTURE_NOT_LOADED ) {
-		if ( partialImage ) {
-			// if we have a partial image, go ahead and use that
-			this->partialImage->Bind();
-
-			// start a background load of the full thing if it isn't already in the queue
-			if ( !backgroundLoadInProgress ) {
-				StartBackgroundImageLoad();
-			}
-			return;
-		}
-
 		// load the image on demand here, which isn't our normal game operating mode
 		ActuallyLoadImage( true, true );	// check for precompressed, load is from back end
 	}
@@ -1698,34 +1849,8 @@ void idImage::BindFragment() {
 		RB_LogComment( "idImage::BindFragment %s )\n", imgName.c_str() );
 	}
 
-	// if this is an image that we are caching, move it to the front of the LRU chain
-	if ( partialImage ) {
-		if ( cacheUsageNext ) {
-			// unlink from old position
-			cacheUsageNext->cacheUsagePrev = cacheUsagePrev;
-			cacheUsagePrev->cacheUsageNext = cacheUsageNext;
-		}
-		// link in at the head of the list
-		cacheUsageNext = globalImages->cacheLRU.cacheUsageNext;
-		cacheUsagePrev = &globalImages->cacheLRU;
-
-		cacheUsageNext->cacheUsagePrev = this;
-		cacheUsagePrev->cacheUsageNext = this;
-	}
-
 	// load the image if necessary (FIXME: not SMP safe!)
 	if ( texnum == TEXTURE_NOT_LOADED ) {
-		if ( partialImage ) {
-			// if we have a partial image, go ahead and use that
-			this->partialImage->BindFragment();
-
-			// start a background load of the full thing if it isn't already in the queue
-			if ( !backgroundLoadInProgress ) {
-				StartBackgroundImageLoad();
-			}
-			return;
-		}
-
 		// load the image on demand here, which isn't our normal game operating mode
 		ActuallyLoadImage( true, true );	// check for precompressed, load is from back end
 	}
@@ -1983,7 +2108,9 @@ Print
 ==================
 */
 void idImage::Print() const {
-	if ( precompressedFile ) {
+	if ( stream ) {
+		common->Printf( "S" );
+	} else if ( precompressedFile ) {
 		common->Printf( "P" );
 	} else if ( generatorFunction ) {
 		common->Printf( "F" );
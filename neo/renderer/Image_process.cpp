@@ -29,6 +29,172 @@ If you have questions concerning this license or the applicable additional terms
 #pragma hdrstop
 
 #include "tr_local.h"
+#include "../idlib/math/Simd_Generic.h"
+
+/*
+===============================================================================
+
+	The resample and mip map filters work on rows of RGBA texels with the
+	SIMD row kernels. Large images are split into bands of rows which are
+	filtered in parallel on the job threads.
+
+===============================================================================
+*/
+
+const int IMAGE_ROWS_PARALLEL_TEXELS	= 64 * 1024;	// smaller images are filtered on the calling thread
+const int IMAGE_ROWS_MIN_BAND			= 8;
+const int MAX_IMAGE_ROW_BANDS			= 64;
+
+static idSIMDProcessor *	imageRowProcessor;			// NULL uses SIMDProcessor, benchmarkImageProcess swaps in the generic loops
+static idParallelJobList *	imageRowJobs[MAX_JOB_THREADS + 1];
+static bool					imageRowJobsBusy[MAX_JOB_THREADS + 1];
+
+/*
+================
+R_InitImageProcessJobs
+
+Every job thread gets its own list, images are also filtered by the level load jobs.
+================
+*/
+void R_InitImageProcessJobs( void ) {
+	for ( int i = 0 ; i <= parallelJobManager->GetNumThreads() ; i++ ) {
+		imageRowJobs[i] = parallelJobManager->AllocJobList( va( "R_ImageRows%i", i ) );
+		imageRowJobsBusy[i] = false;
+	}
+}
+
+/*
+================
+R_ShutdownImageProcessJobs
+================
+*/
+void R_ShutdownImageProcessJobs( void ) {
+	for ( int i = 0 ; i <= MAX_JOB_THREADS ; i++ ) {
+		parallelJobManager->FreeJobList( imageRowJobs[i] );
+		imageRowJobs[i] = NULL;
+	}
+}
+
+/*
+================
+R_ImageRowJob
+================
+*/
+static void R_ImageRowJob( void *data ) {
+	const imageRowJob_t *job = (const imageRowJob_t *)data;
+
+	job->function( job );
+}
+
+/*
+================
+R_ProcessImageRows
+
+Runs the row function over numRows output rows, each of which touches
+rowTexels texels, which decides if it is worth using jobs. The list of the calling
+thread is marked busy while it is submitted, because waiting on it may
+pick up another image job on the same thread, which then filters serially.
+================
+*/
+void R_ProcessImageRows( const imageRowJob_t &work, int numRows, int rowTexels ) {
+	imageRowJob_t	bands[MAX_IMAGE_ROW_BANDS];
+	int				numBands;
+
+	int slot = parallelJobManager->GetThreadSlot();
+
+	numBands = 1;
+	if ( idImageManager::image_processJobs.GetBool() && slot >= 0 && imageRowJobs[slot] != NULL && !imageRowJobsBusy[slot]
+			&& rowTexels * numRows >= IMAGE_ROWS_PARALLEL_TEXELS ) {
+		numBands = Min( numRows / IMAGE_ROWS_MIN_BAND, ( parallelJobManager->GetNumThreads() + 1 ) * 4 );
+		numBands = Min( numBands, MAX_IMAGE_ROW_BANDS );
+	}
+
+	if ( numBands <= 1 ) {
+		bands[0] = work;
+		bands[0].firstRow = 0;
+		bands[0].numRows = numRows;
+		work.function( &bands[0] );
+		return;
+	}
+
+	idParallelJobList *jobList = imageRowJobs[slot];
+	imageRowJobsBusy[slot] = true;
+
+	jobList->Clear();
+	for ( int i = 0 ; i < numBands ; i++ ) {
+		bands[i] = work;
+		bands[i].firstRow = numRows * i / numBands;
+		bands[i].numRows = numRows * ( i + 1 ) / numBands - bands[i].firstRow;
+		jobList->AddJob( R_ImageRowJob, &bands[i] );
+	}
+	jobList->Submit();
+	jobList->Wait();
+
+	imageRowJobsBusy[slot] = false;
+}
+
+/*
+================
+R_InitImageRowJob
+================
+*/
+static void R_InitImageRowJob( imageRowJob_t &work, void (*function)( const imageRowJob_t *job ), const byte *in, int inWidth, int inHeight,
+								byte *out, int outWidth, int outHeight ) {
+	memset( &work, 0, sizeof( work ) );
+	work.function = function;
+	work.simd = ( imageRowProcessor != NULL ) ? imageRowProcessor : SIMDProcessor;
+	work.in = in;
+	work.out = out;
+	work.inWidth = inWidth;
+	work.inHeight = inHeight;
+	work.outWidth = outWidth;
+	work.outHeight = outHeight;
+}
+
+/*
+================
+R_ResampleRows
+================
+*/
+static void R_ResampleRows( const imageRowJob_t *job ) {
+	for ( int i = job->firstRow ; i < job->firstRow + job->numRows ; i++ ) {
+		const byte *inrow = job->in + 4 * job->inWidth * (int)( ( i + 0.25f ) * job->inHeight / job->outHeight );
+		const byte *inrow2 = job->in + 4 * job->inWidth * (int)( ( i + 0.75f ) * job->inHeight / job->outHeight );
+		job->simd->ResampleRow( job->out + i * job->outWidth * 4, inrow, inrow2, job->offsets0, job->offsets1, job->outWidth );
+	}
+}
+
+/*
+================
+R_MipMapRows
+================
+*/
+static void R_MipMapRows( const imageRowJob_t *job ) {
+	int row = job->inWidth * 4;
+
+	for ( int i = job->firstRow ; i < job->firstRow + job->numRows ; i++ ) {
+		const byte *in_p = job->in + i * 2 * row;
+		job->simd->MipMapRow( job->out + i * job->outWidth * 4, in_p, in_p + row, job->outWidth );
+	}
+}
+
+/*
+================
+R_MipMapRows3D
+
+The rows of all output planes are numbered consecutively.
+================
+*/
+static void R_MipMapRows3D( const imageRowJob_t *job ) {
+	int row = job->inWidth * 4;
+	int plane = row * job->inHeight;
+
+	for ( int i = job->firstRow ; i < job->firstRow + job->numRows ; i++ ) {
+		int k = i / job->outHeight;
+		const byte *in_p = job->in + k * 2 * plane + ( i - k * job->outHeight ) * 2 * row;
+		job->simd->MipMapRow3D( job->out + i * job->outWidth * 4, in_p, in_p + row, in_p + plane, in_p + plane + row, job->outWidth );
+	}
+}
 
 /*
 ================
@@ -46,12 +212,11 @@ after resampling to the next lower power of two.
 #define	MAX_DIMENSION	4096
 byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,  
 							int outwidth, int outheight ) {
-	int		i, j;
-	const byte	*inrow, *inrow2;
+	int		i;
 	unsigned int	frac, fracstep;
 	unsigned int	p1[MAX_DIMENSION], p2[MAX_DIMENSION];
-	const byte		*pix1, *pix2, *pix3, *pix4;
-	byte		*out, *out_p;
+	byte		*out;
+	imageRowJob_t	work;
 
 	if ( outwidth > MAX_DIMENSION ) {
 		outwidth = MAX_DIMENSION;
@@ -61,7 +226,6 @@ byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 	}
 
 	out = (byte *)R_StaticAlloc( outwidth * outheight * 4 );
-	out_p = out;
 
 	fracstep = inwidth*0x10000/outwidth;
 
@@ -76,21 +240,10 @@ byte *R_ResampleTexture( const byte *in, int inwidth, int inheight,
 		frac += fracstep;
 	}
 
-	for (i=0 ; i<outheight ; i++, out_p += outwidth*4 ) {
-		inrow = in + 4 * inwidth * (int)( ( i + 0.25f ) * inheight / outheight );
-		inrow2 = in + 4 * inwidth * (int)( ( i + 0.75f ) * inheight / outheight );
-		frac = fracstep >> 1;
-		for (j=0 ; j<outwidth ; j++) {
-			pix1 = inrow + p1[j];
-			pix2 = inrow + p2[j];
-			pix3 = inrow2 + p1[j];
-			pix4 = inrow2 + p2[j];
-			out_p[j*4+0] = (pix1[0] + pix2[0] + pix3[0] + pix4[0])>>2;
-			out_p[j*4+1] = (pix1[1] + pix2[1] + pix3[1] + pix4[1])>>2;
-			out_p[j*4+2] = (pix1[2] + pix2[2] + pix3[2] + pix4[2])>>2;
-			out_p[j*4+3] = (pix1[3] + pix2[3] + pix3[3] + pix4[3])>>2;
-		}
-	}
+	R_InitImageRowJob( work, R_ResampleRows, in, inwidth, inheight, out, outwidth, outheight );
+	work.offsets0 = p1;
+	work.offsets1 = p2;
+	R_ProcessImageRows( work, outheight, outwidth );
 
 	return out;
 }
@@ -394,12 +547,13 @@ smeared clamps...
 ================
 */
 byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
-	int		i, j;
+	int		i;
 	const byte	*in_p;
 	byte	*out, *out_p;
-	int		row;
 	byte	border[4];
+	int		inWidth, inHeight;
 	int		newWidth, newHeight;
+	imageRowJob_t	work;
 
 	if ( width < 1 || height < 1 || ( width + height == 2 ) ) {
 		common->FatalError( "R_MipMap called with size %i,%i", width, height );
@@ -410,8 +564,6 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 	border[2] = in[2];
 	border[3] = in[3];
 
-	row = width * 4;
-
 	newWidth = width >> 1;
 	newHeight = height >> 1;
 	if ( !newWidth ) {
@@ -425,6 +577,8 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 
 	in_p = in;
 
+	inWidth = width;
+	inHeight = height;
 	width >>= 1;
 	height >>= 1;
 
@@ -448,14 +602,8 @@ byte *R_MipMap( const byte *in, int width, int height, bool preserveBorder ) {
 		return out;
 	}
 
-	for (i=0 ; i<height ; i++, in_p+=row) {
-		for (j=0 ; j<width ; j++, out_p+=4, in_p+=8) {
-			out_p[0] = (in_p[0] + in_p[4] + in_p[row+0] + in_p[row+4])>>2;
-			out_p[1] = (in_p[1] + in_p[5] + in_p[row+1] + in_p[row+5])>>2;
-			out_p[2] = (in_p[2] + in_p[6] + in_p[row+2] + in_p[row+6])>>2;
-			out_p[3] = (in_p[3] + in_p[7] + in_p[row+3] + in_p[row+7])>>2;
-		}
-	}
+	R_InitImageRowJob( work, R_MipMapRows, in, inWidth, inHeight, out, width, height );
+	R_ProcessImageRows( work, height, width );
 
 	// copy the old border texel back around if desired
 	if ( preserveBorder ) {
@@ -479,12 +627,10 @@ smeared clamps...
 ================
 */
 byte *R_MipMap3D( const byte *in, int width, int height, int depth, bool preserveBorder ) {
-	int		i, j, k;
-	const byte	*in_p;
-	byte	*out, *out_p;
-	int		row, plane;
+	byte	*out;
 	byte	border[4];
 	int		newWidth, newHeight, newDepth;
+	imageRowJob_t	work;
 
 	if ( depth == 1 ) {
 		return R_MipMap( in, width, height, preserveBorder );
@@ -500,44 +646,18 @@ byte *R_MipMap3D( const byte *in, int width, int height, int depth, bool preserv
 	border[2] = in[2];
 	border[3] = in[3];
 
-	row = width * 4;
-	plane = row * height;
-
 	newWidth = width >> 1;
 	newHeight = height >> 1;
 	newDepth = depth >> 1;
 
 	out = (byte *)R_StaticAlloc( newWidth * newHeight * newDepth * 4 );
-	out_p = out;
 
-	in_p = in;
-
-	width >>= 1;
-	height >>= 1;
-	depth >>= 1;
-
-	for (k=0 ; k<depth ; k++, in_p+=plane) {
-		for (i=0 ; i<height ; i++, in_p+=row) {
-			for (j=0 ; j<width ; j++, out_p+=4, in_p+=8) {
-				out_p[0] = (in_p[0] + in_p[4] + in_p[row+0] + in_p[row+4] +
-					in_p[plane+0] + in_p[plane+4] + in_p[plane+row+0] + in_p[plane+row+4]
-					)>>3;
-				out_p[1] = (in_p[1] + in_p[5] + in_p[row+1] + in_p[row+5] +
-					in_p[plane+1] + in_p[plane+5] + in_p[plane+row+1] + in_p[plane+row+5]
-					)>>3;
-				out_p[2] = (in_p[2] + in_p[6] + in_p[row+2] + in_p[row+6] +
-					in_p[plane+2] + in_p[plane+6] + in_p[plane+row+2] + in_p[plane+row+6]
-					)>>3;
-				out_p[3] = (in_p[3] + in_p[7] + in_p[row+3] + in_p[row+7] +
-					in_p[plane+3] + in_p[plane+6] + in_p[plane+row+3] + in_p[plane+row+6]
-					)>>3;
-			}
-		}
-	}
+	R_InitImageRowJob( work, R_MipMapRows3D, in, width, height, out, newWidth, newHeight );
+	R_ProcessImageRows( work, newHeight * newDepth, newWidth );
 
 	// copy the old border texel back around if desired
 	if ( preserveBorder ) {
-		R_SetBorderTexels3D( out, width, height, depth, border );
+		R_SetBorderTexels3D( out, newWidth, newHeight, newDepth, border );
 	}
 
 	return out;
@@ -619,3 +739,140 @@ void R_RotatePic( byte *data, int width ) {
 	R_StaticFree( temp );
 }
 
+
+/*
+=================
+R_BenchmarkImageProcess_f
+
+Filters every TGA of a directory with the generic loops, the SIMD row
+kernels, and the SIMD row kernels on the job threads, and reports the
+throughput of each kernel in source megabytes per second.
+=================
+*/
+void R_BenchmarkImageProcess_f( const idCmdArgs &args ) {
+	enum { IP_RESAMPLE, IP_MIPMAP, IP_MIPMAP3D, IP_NUM_KERNELS };
+	enum { IP_GENERIC, IP_SIMD, IP_SIMD_JOBS, IP_NUM_PASSES };
+	static const char *kernelNames[IP_NUM_KERNELS] = { "resample", "mipmap", "mipmap3D" };
+	idSIMD_Generic	generic;
+	double			msec[IP_NUM_KERNELS][IP_NUM_PASSES];
+	double			megs[IP_NUM_KERNELS];
+	bool			mismatch[IP_NUM_KERNELS][IP_NUM_PASSES];
+	int				numRuns;
+	int				numImages;
+
+	if ( args.Argc() < 2 ) {
+		common->Printf( "usage: benchmarkImageProcess <directory> [runs]\n" );
+		return;
+	}
+
+	numRuns = 4;
+	if ( args.Argc() > 2 ) {
+		numRuns = Max( 1, atoi( args.Argv( 2 ) ) );
+	}
+
+	idFileList *files = fileSystem->ListFiles( args.Argv( 1 ), ".tga", true, true );
+
+	memset( msec, 0, sizeof( msec ) );
+	memset( megs, 0, sizeof( megs ) );
+	memset( mismatch, 0, sizeof( mismatch ) );
+
+	bool processJobs = idImageManager::image_processJobs.GetBool();
+
+	numImages = 0;
+	for ( int f = 0 ; f < files->GetNumFiles() ; f++ ) {
+		byte	*pic;
+		int		width, height;
+
+		R_LoadImage( files->GetFile( f ), &pic, &width, &height, NULL, true );
+		if ( pic == NULL ) {
+			continue;
+		}
+		numImages++;
+
+		for ( int kernel = 0 ; kernel < IP_NUM_KERNELS ; kernel++ ) {
+			// the volume is the image cut into a stack of up to 8 slices
+			int depth = Min( height / 2, 8 );
+			int resampleWidth = Min( Max( 1, width * 3 / 4 ), MAX_DIMENSION );
+			int resampleHeight = Min( Max( 1, height * 3 / 4 ), MAX_DIMENSION );
+
+			if ( kernel == IP_MIPMAP && width + height <= 2 ) {
+				continue;
+			}
+			if ( kernel == IP_MIPMAP3D && ( width < 2 || depth < 2 ) ) {
+				continue;
+			}
+			megs[kernel] += width * height * 4 / ( 1024.0 * 1024.0 );
+
+			byte *reference = NULL;
+			for ( int pass = 0 ; pass < IP_NUM_PASSES ; pass++ ) {
+				imageRowProcessor = ( pass == IP_GENERIC ) ? &generic : NULL;
+				idImageManager::image_processJobs.SetBool( pass == IP_SIMD_JOBS );
+
+				double best = idMath::INFINITY;
+				for ( int run = 0 ; run < numRuns ; run++ ) {
+					idTimer	timer;
+					byte	*out;
+					int		outSize;
+
+					timer.Start();
+					switch( kernel ) {
+					case IP_RESAMPLE:
+						out = R_ResampleTexture( pic, width, height, resampleWidth, resampleHeight );
+						outSize = resampleWidth * resampleHeight * 4;
+						break;
+					case IP_MIPMAP:
+						out = R_MipMap( pic, width, height, false );
+						outSize = Max( 1, width >> 1 ) * Max( 1, height >> 1 ) * 4;
+						break;
+					default:
+						out = R_MipMap3D( pic, width, height / depth, depth, false );
+						outSize = ( width >> 1 ) * ( height / depth >> 1 ) * ( depth >> 1 ) * 4;
+						break;
+					}
+					timer.Stop();
+
+					best = Min( best, timer.Milliseconds() );
+
+					if ( reference == NULL ) {
+						reference = out;
+					} else {
+						if ( memcmp( reference, out, outSize ) != 0 ) {
+							mismatch[kernel][pass] = true;
+						}
+						R_StaticFree( out );
+					}
+				}
+				msec[kernel][pass] += best;
+			}
+			R_StaticFree( reference );
+		}
+
+		R_StaticFree( pic );
+	}
+
+	imageRowProcessor = NULL;
+	idImageManager::image_processJobs.SetBool( processJobs );
+
+	fileSystem->FreeFileList( files );
+
+	if ( numImages == 0 ) {
+		common->Printf( "No images.\n" );
+		return;
+	}
+
+	common->Printf( "%i images, best of %i runs, %s with %i job threads\n", numImages, numRuns, SIMDProcessor->GetName(), parallelJobManager->GetNumThreads() );
+	common->Printf( "kernel      generic MB/s    simd MB/s       simd + jobs MB/s\n" );
+	for ( int kernel = 0 ; kernel < IP_NUM_KERNELS ; kernel++ ) {
+		double rate[IP_NUM_PASSES];
+
+		if ( megs[kernel] == 0.0 ) {
+			continue;
+		}
+		for ( int pass = 0 ; pass < IP_NUM_PASSES ; pass++ ) {
+			rate[pass] = megs[kernel] * 1000.0 / Max( msec[kernel][pass], 0.001 );
+		}
+		common->Printf( "%-10s %8.1f %12.1f %5.2fx%s %9.1f %5.2fx%s\n", kernelNames[kernel], rate[IP_GENERIC],
+						rate[IP_SIMD], rate[IP_SIMD] / rate[IP_GENERIC], mismatch[kernel][IP_SIMD] ? S_COLOR_RED " X" S_COLOR_DEFAULT : "",
+						rate[IP_SIMD_JOBS], rate[IP_SIMD_JOBS] / rate[IP_GENERIC], mismatch[kernel][IP_SIMD_JOBS] ? S_COLOR_RED " X" S_COLOR_DEFAULT : "" );
+	}
+}
@@ -336,7 +336,8 @@ static void R_ImageAdd( byte *data1, int width1, int height1, byte *data2, int w
 }
 
 
-// we build a canonical token form of the image program here
+// we build a canonical token form of the image program here,
+// loads have a buffer of their own so they can run on job threads
 static char parseBuffer[MAX_IMAGE_NAME];
 
 /*
@@ -344,12 +345,12 @@ static char parseBuffer[MAX_IMAGE_NAME];
 AppendToken
 ===================
 */
-static void AppendToken( idToken &token ) {
+static void AppendToken( char *buffer, idToken &token ) {
 	// add a leading space if not at the beginning
-	if ( parseBuffer[0] ) {
-		idStr::Append( parseBuffer, MAX_IMAGE_NAME, " " );
+	if ( buffer[0] ) {
+		idStr::Append( buffer, MAX_IMAGE_NAME, " " );
 	}
-	idStr::Append( parseBuffer, MAX_IMAGE_NAME, token.c_str() );
+	idStr::Append( buffer, MAX_IMAGE_NAME, token.c_str() );
 }
 
 /*
@@ -357,12 +358,12 @@ static void AppendToken( idToken &token ) {
 MatchAndAppendToken
 ===================
 */
-static void MatchAndAppendToken( idLexer &src, const char *match ) {
+static void MatchAndAppendToken( char *buffer, idLexer &src, const char *match ) {
 	if ( !src.ExpectTokenString( match ) ) {
 		return;
 	}
 	// a matched token won't need a leading space
-	idStr::Append( parseBuffer, MAX_IMAGE_NAME, match );
+	idStr::Append( buffer, MAX_IMAGE_NAME, match );
 }
 
 /*
@@ -374,26 +375,26 @@ If both pic and timestamps are NULL, it will just advance past it, which can be
 used to parse an image program from a text stream.
 ===================
 */
-static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *height,
-								  ID_TIME_T *timestamps, textureDepth_t *depth ) {
+static bool R_ParseImageProgram_r( char *buffer, idLexer &src, byte **pic, int *width, int *height,
+										ID_TIME_T *timestamps, textureDepth_t *depth ) {
 	idToken		token;
 	float		scale;
 	ID_TIME_T		timestamp;
 
 	src.ReadToken( &token );
-	AppendToken( token );
+	AppendToken( buffer, token );
 
 	if ( !token.Icmp( "heightmap" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth ) ) {
 			return false;
 		}
 
-		MatchAndAppendToken( src, "," );
+		MatchAndAppendToken( buffer, src, "," );
 
 		src.ReadToken( &token );
-		AppendToken( token );
+		AppendToken( buffer, token );
 		scale = token.GetFloatValue();
 		
 		// process it
@@ -404,7 +405,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -412,15 +413,15 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		byte	*pic2;
 		int		width2, height2;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth ) ) {
 			return false;
 		}
 
-		MatchAndAppendToken( src, "," );
+		MatchAndAppendToken( buffer, src, "," );
 
-		if ( !R_ParseImageProgram_r( src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth ) ) {
 			if ( pic ) {
 				R_StaticFree( *pic );
 				*pic = NULL;
@@ -437,14 +438,14 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "smoothnormals" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth ) ) {
 			return false;
 		}
 
@@ -455,7 +456,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -463,15 +464,15 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		byte	*pic2;
 		int		width2, height2;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		if ( !R_ParseImageProgram_r( src, pic, width, height, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth ) ) {
 			return false;
 		}
 
-		MatchAndAppendToken( src, "," );
+		MatchAndAppendToken( buffer, src, "," );
 
-		if ( !R_ParseImageProgram_r( src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth ) ) {
+		if ( !R_ParseImageProgram_r( buffer, src, pic ? &pic2 : NULL, &width2, &height2, timestamps, depth ) ) {
 			if ( pic ) {
 				R_StaticFree( *pic );
 				*pic = NULL;
@@ -485,7 +486,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			R_StaticFree( pic2 );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -493,14 +494,14 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 		float	scale[4];
 		int		i;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth );
 
 		for ( i = 0 ; i < 4 ; i++ ) {
-			MatchAndAppendToken( src, "," );
+			MatchAndAppendToken( buffer, src, "," );
 			src.ReadToken( &token );
-			AppendToken( token );
+			AppendToken( buffer, token );
 			scale[i] = token.GetFloatValue();
 		}
 
@@ -509,44 +510,44 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			R_ImageScale( *pic, *width, *height, scale );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "invertAlpha" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth );
 
 		// process it
 		if ( pic ) {
 			R_InvertAlpha( *pic, *width, *height );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "invertColor" ) ) {
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth );
 
 		// process it
 		if ( pic ) {
 			R_InvertColor( *pic, *width, *height );
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "makeIntensity" ) ) {
 		int		i;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth );
 
 		// copy red to green, blue, and alpha
 		if ( pic ) {
@@ -559,16 +560,16 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
 	if ( !token.Icmp( "makeAlpha" ) ) {
 		int		i;
 
-		MatchAndAppendToken( src, "(" );
+		MatchAndAppendToken( buffer, src, "(" );
 
-		R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+		R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth );
 
 		// average RGB into alpha, then set RGB to white
 		if ( pic ) {
@@ -582,7 +583,7 @@ static bool R_ParseImageProgram_r( idLexer &src, byte **pic, int *width, int *he
 			}
 		}
 
-		MatchAndAppendToken( src, ")" );
+		MatchAndAppendToken( buffer, src, ")" );
 		return true;
 	}
 
@@ -617,16 +618,17 @@ R_LoadImageProgram
 */
 void R_LoadImageProgram( const char *name, byte **pic, int *width, int *height, ID_TIME_T *timestamps, textureDepth_t *depth ) {
 	idLexer src;
+	char	buffer[MAX_IMAGE_NAME];
 
 	src.LoadMemory( name, strlen(name), name );
 	src.SetFlags( LEXFL_NOFATALERRORS | LEXFL_NOSTRINGCONCAT | LEXFL_NOSTRINGESCAPECHARS | LEXFL_ALLOWPATHNAMES );
 
-	parseBuffer[0] = 0;
+	buffer[0] = 0;
 	if ( timestamps ) {
 		*timestamps = 0;
 	}
 
-	R_ParseImageProgram_r( src, pic, width, height, timestamps, depth );
+	R_ParseImageProgram_r( buffer, src, pic, width, height, timestamps, depth );
 
 	src.FreeSource();
 }
@@ -638,7 +640,7 @@ R_ParsePastImageProgram
 */
 const char *R_ParsePastImageProgram( idLexer &src ) {
 	parseBuffer[0] = 0;
-	R_ParseImageProgram_r( src, NULL, NULL, NULL, NULL, NULL );
+	R_ParseImageProgram_r( parseBuffer, src, NULL, NULL, NULL, NULL, NULL );
 	return parseBuffer;
 }
 
@@ -0,0 +1,515 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+/*
+===============================================================================
+
+	Image streaming
+
+	With image_useCache, precompressed images larger than image_cacheMinK
+	are streamed.  Level loads only read the tail of their .dds file with
+	the small mip levels that fit into image_cacheMinK, those stay resident
+	as long as the image is loaded.
+
+	The front end tells each image the size on screen of the surfaces that
+	use it, which gives the largest mip level the views of the frame need.
+	Once a frame, while the back end is idle, the levels that finished
+	reading are uploaded and the images that are wanted larger than they
+	are start a background read of the missing levels, in the order they
+	were last wanted.  Reads from pk4 files have to inflate everything in
+	front of the levels, which the background thread takes care of.
+
+	All resident and reading levels count against image_cacheMegs.  When a
+	read doesn't fit, the least recently wanted images drop back to their
+	tail, or to the levels the current frame needs, until it does.
+
+===============================================================================
+*/
+
+/*
+================
+idImage::AllocStream
+================
+*/
+void idImage::AllocStream() {
+	idScopedMemTag	memTag( MEM_TAG_IMAGE );
+
+	stream = new imageStream_t;
+	memset( &stream->layout, 0, sizeof( stream->layout ) );
+	stream->firstLevel = 0;
+	stream->tailLevel = 0;
+	stream->residentLevel = 0;
+	stream->wantedLevel = 0;
+	stream->lastWantedFrame = -1;
+	stream->readLevel = -1;
+	stream->bgl.opcode = DLTYPE_FILE;
+	stream->bgl.f = NULL;
+	stream->bgl.completed = false;
+}
+
+/*
+================
+idImage::FreeStream
+
+The image is loaded like any other one afterwards
+================
+*/
+void idImage::FreeStream() {
+	PurgeStream();
+
+	delete stream;
+	stream = NULL;
+}
+
+/*
+================
+idImage::PurgeStream
+
+Called by PurgeImage, the texture holds no levels afterwards
+================
+*/
+void idImage::PurgeStream() {
+	CancelStreamRead();
+
+	if ( cacheUsageNext ) {
+		if ( globalImages->cacheWantedTail == this ) {
+			globalImages->cacheWantedTail = cacheUsagePrev;
+		}
+		cacheUsageNext->cacheUsagePrev = cacheUsagePrev;
+		cacheUsagePrev->cacheUsageNext = cacheUsageNext;
+		cacheUsageNext = NULL;
+		cacheUsagePrev = NULL;
+	}
+
+	const ddsLayout_t &layout = stream->layout;
+
+	globalImages->streamedImageSize -= layout.offsets[layout.numLevels] - layout.offsets[stream->residentLevel];
+	stream->residentLevel = layout.numLevels;
+}
+
+/*
+================
+idImage::ReadStreamedImageTail
+
+Reads the header and the small mip levels of the .dds file that fit
+into image_cacheMinK, may run on a job thread.  The data is passed to
+UploadStreamedImage.
+================
+*/
+bool idImage::ReadStreamedImageTail( idFile *f, byte **data, int *dataLength ) {
+	const int	headerSize = 4 + sizeof( ddsFileHeader_t );
+	byte		header[4 + sizeof( ddsFileHeader_t )];
+	ddsLayout_t	layout;
+
+	if ( f->Read( header, headerSize ) != headerSize ) {
+		return false;
+	}
+	if ( !ParsePrecompressedHeader( header, layout ) || layout.offsets[layout.numLevels] > f->Length() ) {
+		return false;
+	}
+
+	// nothing is resident until UploadStreamedImage
+	stream->layout = layout;
+	stream->residentLevel = layout.numLevels;
+
+	// never stream the levels the downsize cvars skip
+	int width = layout.widths[0];
+	int height = layout.heights[0];
+	GetDownsize( width, height );
+
+	stream->firstLevel = 0;
+	while ( stream->firstLevel < layout.numLevels - 1
+		&& ( layout.widths[stream->firstLevel] > width || layout.heights[stream->firstLevel] > height ) ) {
+		stream->firstLevel++;
+	}
+
+	// the smallest level is always read, even if it doesn't fit
+	int tailSize = globalImages->image_cacheMinK.GetInteger() * 1024;
+
+	stream->tailLevel = layout.numLevels - 1;
+	while ( stream->tailLevel > stream->firstLevel
+		&& layout.offsets[layout.numLevels] - layout.offsets[stream->tailLevel - 1] <= tailSize ) {
+		stream->tailLevel--;
+	}
+
+	int len = layout.offsets[layout.numLevels] - layout.offsets[stream->tailLevel];
+	byte *buffer = (byte *)R_StaticAlloc( headerSize + len );
+
+	memcpy( buffer, header, headerSize );
+
+	if ( f->Seek( layout.offsets[stream->tailLevel], FS_SEEK_SET ) != 0 || f->Read( buffer + headerSize, len ) != len ) {
+		R_StaticFree( buffer );
+		return false;
+	}
+
+	*data = buffer;
+	*dataLength = headerSize + len;
+
+	return true;
+}
+
+/*
+================
+idImage::UploadStreamedImage
+
+Creates the texture with the levels read by ReadStreamedImageTail
+================
+*/
+void idImage::UploadStreamedImage( const byte *data, int len ) {
+	const ddsLayout_t &layout = stream->layout;
+	const int	headerSize = 4 + sizeof( ddsFileHeader_t );
+
+	if ( len != headerSize + layout.offsets[layout.numLevels] - layout.offsets[stream->tailLevel] ) {
+		MakeDefault();
+		return;
+	}
+
+	// generate the texture number
+	glGenTextures( 1, &texnum );
+
+	precompressedFile = true;
+	internalFormat = layout.internalFormat;
+	type = TT_2D;
+
+	Bind();
+
+	// the levels keep their index in the file
+	const byte *levelData = data + headerSize;
+	for ( int i = stream->tailLevel ; i < layout.numLevels ; i++ ) {
+		UploadPrecompressedLevel( layout, i, i, levelData );
+		levelData += layout.offsets[i + 1] - layout.offsets[i];
+	}
+
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, layout.numLevels - 1 );
+	SetStreamedBaseLevel( stream->tailLevel );
+
+	SetImageFilterAndRepeat();
+
+	globalImages->streamedImageSize += layout.offsets[layout.numLevels] - layout.offsets[stream->tailLevel];
+}
+
+/*
+================
+idImage::SetStreamedBaseLevel
+
+The texture has to be bound
+================
+*/
+void idImage::SetStreamedBaseLevel( int level ) {
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level );
+
+	stream->residentLevel = level;
+
+	// for listImages
+	uploadWidth = stream->layout.widths[level];
+	uploadHeight = stream->layout.heights[level];
+}
+
+/*
+================
+idImage::StreamForScreenSize
+
+Called by the front end for every surface that uses the image with the
+size it covers on screen, in pixels.  Remembers the largest level any
+view of the frame needs.
+================
+*/
+void idImage::StreamForScreenSize( float pixels ) {
+	if ( !stream || stream->residentLevel >= stream->layout.numLevels ) {
+		return;
+	}
+
+	const ddsLayout_t &layout = stream->layout;
+
+	// the smallest level that still has about a texel per pixel
+	int level = stream->firstLevel;
+	while ( level < stream->tailLevel && Max( layout.widths[level + 1], layout.heights[level + 1] ) >= pixels ) {
+		level++;
+	}
+
+	if ( stream->lastWantedFrame == tr.frameCount ) {
+		if ( level < stream->wantedLevel ) {
+			stream->wantedLevel = level;
+		}
+		return;
+	}
+
+	// the images wanted this frame are at the head of the LRU chain in the
+	// order they were first wanted, move this one behind them
+	idImage *prev = globalImages->cacheWantedTail;
+	if ( prev != &globalImages->cacheLRU && prev->stream->lastWantedFrame != tr.frameCount ) {
+		prev = &globalImages->cacheLRU;
+	}
+
+	stream->lastWantedFrame = tr.frameCount;
+	stream->wantedLevel = level;
+
+	if ( cacheUsageNext ) {
+		cacheUsageNext->cacheUsagePrev = cacheUsagePrev;
+		cacheUsagePrev->cacheUsageNext = cacheUsageNext;
+	}
+	cacheUsageNext = prev->cacheUsageNext;
+	cacheUsagePrev = prev;
+
+	cacheUsageNext->cacheUsagePrev = this;
+	cacheUsagePrev->cacheUsageNext = this;
+
+	globalImages->cacheWantedTail = this;
+}
+
+/*
+================
+idImage::StartStreamRead
+
+Reads the levels from level up to the resident ones in the background
+================
+*/
+void idImage::StartStreamRead( int level ) {
+	const ddsLayout_t &layout = stream->layout;
+	char	filename[MAX_IMAGE_NAME];
+
+	idScopedMemTag	memTag( MEM_TAG_IMAGE );
+
+	ImageProgramStringToCompressedFileName( imgName, filename );
+
+	stream->bgl.f = fileSystem->OpenFileRead( filename );
+	if ( !stream->bgl.f ) {
+		common->Warning( "idImage::StartStreamRead: couldn't open %s", filename );
+		// keep the levels we have
+		stream->firstLevel = stream->residentLevel;
+		return;
+	}
+
+	int length = layout.offsets[stream->residentLevel] - layout.offsets[level];
+
+	stream->bgl.opcode = DLTYPE_FILE;
+	stream->bgl.completed = false;
+	stream->bgl.file.position = layout.offsets[level];
+	stream->bgl.file.length = length;
+	stream->bgl.file.buffer = R_StaticAlloc( length );
+	stream->readLevel = level;
+
+	globalImages->streamedImageSize += length;
+	globalImages->numActiveBackgroundImageLoads++;
+	globalImages->streamStats.reads++;
+	globalImages->streamStats.readBytes += length;
+
+	if ( globalImages->image_showBackgroundLoads.GetBool() ) {
+		common->Printf( "idImage::StartStreamRead: %s level %i\n", imgName.c_str(), level );
+	}
+
+	fileSystem->BackgroundDownload( &stream->bgl );
+}
+
+/*
+================
+idImage::FinishStreamRead
+
+Uploads the levels of a completed background read
+================
+*/
+void idImage::FinishStreamRead() {
+	const ddsLayout_t &layout = stream->layout;
+	int length = layout.offsets[stream->residentLevel] - layout.offsets[stream->readLevel];
+
+	fileSystem->CloseFile( stream->bgl.f );
+	stream->bgl.f = NULL;
+	globalImages->numActiveBackgroundImageLoads--;
+
+	if ( stream->bgl.file.length != length ) {
+		common->Warning( "idImage::FinishStreamRead: short read of %s", imgName.c_str() );
+		// keep the levels we have
+		globalImages->streamedImageSize -= length;
+		stream->firstLevel = stream->residentLevel;
+	} else {
+		Bind();
+
+		const byte *levelData = (const byte *)stream->bgl.file.buffer;
+		for ( int i = stream->readLevel ; i < stream->residentLevel ; i++ ) {
+			UploadPrecompressedLevel( layout, i, i, levelData );
+			levelData += layout.offsets[i + 1] - layout.offsets[i];
+		}
+
+		SetStreamedBaseLevel( stream->readLevel );
+	}
+
+	R_StaticFree( stream->bgl.file.buffer );
+	stream->bgl.file.buffer = NULL;
+	stream->readLevel = -1;
+}
+
+/*
+================
+idImage::CancelStreamRead
+
+Throws away the background read if there is one
+================
+*/
+void idImage::CancelStreamRead() {
+	if ( stream->readLevel < 0 ) {
+		return;
+	}
+
+	// the buffer belongs to the background thread until it is done
+	while ( !stream->bgl.completed ) {
+		Sys_Sleep( 1 );
+	}
+
+	const ddsLayout_t &layout = stream->layout;
+
+	fileSystem->CloseFile( stream->bgl.f );
+	stream->bgl.f = NULL;
+	R_StaticFree( stream->bgl.file.buffer );
+	stream->bgl.file.buffer = NULL;
+
+	globalImages->streamedImageSize -= layout.offsets[stream->residentLevel] - layout.offsets[stream->readLevel];
+	globalImages->numActiveBackgroundImageLoads--;
+	stream->readLevel = -1;
+}
+
+/*
+================
+idImage::EvictStreamedLevels
+
+Drops the levels larger than level
+================
+*/
+void idImage::EvictStreamedLevels( int level ) {
+	if ( stream->readLevel >= 0 || level <= stream->residentLevel ) {
+		return;
+	}
+
+	const ddsLayout_t &layout = stream->layout;
+	int size = layout.offsets[level] - layout.offsets[stream->residentLevel];
+	int oldLevel = stream->residentLevel;
+
+	Bind();
+	SetStreamedBaseLevel( level );
+
+	// respecify the dropped levels empty to release their memory, levels
+	// below the base level don't take part in texture completeness
+	for ( int i = oldLevel ; i < level ; i++ ) {
+		glTexImage2D( GL_TEXTURE_2D, i, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+	}
+
+	globalImages->streamedImageSize -= size;
+	globalImages->streamStats.evictions++;
+	globalImages->streamStats.evictedBytes += size;
+
+	if ( globalImages->image_showBackgroundLoads.GetBool() ) {
+		common->Printf( "idImage::EvictStreamedLevels: %s level %i\n", imgName.c_str(), level );
+	}
+}
+
+/*
+==================
+idImageManager::UpdateStreamedImages
+==================
+*/
+void idImageManager::UpdateStreamedImages() {
+	idImage *image;
+
+	memset( &streamStats, 0, sizeof( streamStats ) );
+
+	// upload the levels that finished reading
+	for ( image = cacheLRU.cacheUsageNext ; image != &cacheLRU ; image = image->cacheUsageNext ) {
+		if ( image->stream->readLevel >= 0 && image->stream->bgl.completed ) {
+			image->FinishStreamRead();
+		}
+	}
+
+	if ( !image_useCache.GetBool() ) {
+		return;
+	}
+
+	int		budget = idMath::Ftoi( image_cacheMegs.GetFloat() * 1024 * 1024 );
+	idImage	*evict = cacheLRU.cacheUsagePrev;
+
+	// start the reads of the images this frame wants larger, the
+	// ones that were wanted first come first
+	for ( image = cacheLRU.cacheUsageNext ; image != &cacheLRU ; image = image->cacheUsageNext ) {
+		imageStream_t *stream = image->stream;
+
+		if ( stream->lastWantedFrame != tr.frameCount ) {
+			// nothing further down the chain was wanted this frame
+			break;
+		}
+
+		// never evict the images in front of this one
+		if ( image == evict ) {
+			evict = NULL;
+		}
+
+		if ( stream->readLevel >= 0 || stream->wantedLevel >= stream->residentLevel ) {
+			continue;
+		}
+
+		if ( numActiveBackgroundImageLoads >= MAX_BACKGROUND_IMAGE_LOADS ) {
+			break;
+		}
+
+		int needed = stream->layout.offsets[stream->residentLevel] - stream->layout.offsets[stream->wantedLevel];
+
+		// make room by dropping the levels of the least recently wanted images
+		while ( evict && streamedImageSize + needed > budget ) {
+			const imageStream_t *check = evict->stream;
+
+			evict->EvictStreamedLevels( check->lastWantedFrame == tr.frameCount ? check->wantedLevel : check->tailLevel );
+			evict = evict->cacheUsagePrev;
+
+			if ( evict == image ) {
+				evict = NULL;
+			}
+		}
+
+		if ( streamedImageSize + needed > budget ) {
+			streamStats.deferredReads++;
+			continue;
+		}
+
+		image->StartStreamRead( stream->wantedLevel );
+	}
+
+	totalStreamStats.reads += streamStats.reads;
+	totalStreamStats.readBytes += streamStats.readBytes;
+	totalStreamStats.deferredReads += streamStats.deferredReads;
+	totalStreamStats.evictions += streamStats.evictions;
+	totalStreamStats.evictedBytes += streamStats.evictedBytes;
+
+	if ( image_showBackgroundLoads.GetBool() && ( streamStats.reads || streamStats.evictions || streamStats.deferredReads ) ) {
+		common->Printf( "streaming: %i reads %ik, %i deferred, %i evictions %ik, %i reading, %5.1f of %5.1f megs\n",
+			streamStats.reads, streamStats.readBytes / 1024, streamStats.deferredReads,
+			streamStats.evictions, streamStats.evictedBytes / 1024, numActiveBackgroundImageLoads,
+			streamedImageSize / ( 1024 * 1024.0f ), image_cacheMegs.GetFloat() );
+	}
+}
@@ -449,6 +449,7 @@ idInteraction::idInteraction( void ) {
 	dynamicModelFrameCount	= 0;
 	frustumState			= FRUSTUM_UNINITIALIZED;
 	frustumAreas			= NULL;
+	storeSlot				= -1;
 }
 
 /*
@@ -506,6 +507,8 @@ idInteraction *idInteraction::AllocAndLink( idRenderEntityLocal *edef, idRenderL
 		renderWorld->interactionTable[ index ] = interaction;
 	}
 
+	renderWorld->interactionStore.Add( interaction );
+
 	return interaction;
 }
 
@@ -528,7 +531,11 @@ void idInteraction::FreeSurfaces( void ) {
 				}
 				sint->lightTris = NULL;
 			}
-			if ( sint->shadowTris ) {
+			if ( sint->cachedShadow ) {
+				R_ReleaseCachedShadow( sint->cachedShadow );
+				sint->cachedShadow = NULL;
+				sint->shadowTris = NULL;
+			} else if ( sint->shadowTris ) {
 				// if it doesn't have an entityDef, it is part of a prelight
 				// model, not a generated interaction
 				if ( this->entityDef ) {
@@ -543,6 +550,8 @@ void idInteraction::FreeSurfaces( void ) {
 		this->surfaces = NULL;
 	}
 	this->numSurfaces = -1;
+
+	this->lightDef->world->interactionStore.SetNumSurfaces( this );
 }
 
 /*
@@ -598,6 +607,8 @@ void idInteraction::UnlinkAndFree( void ) {
 		renderWorld->interactionTable[index] = NULL;
 	}
 
+	renderWorld->interactionStore.Remove( this );
+
 	Unlink();
 
 	FreeSurfaces();
@@ -624,6 +635,7 @@ void idInteraction::MakeEmpty( void ) {
 
 	// an empty interaction has no surfaces
 	numSurfaces = 0;
+	lightDef->world->interactionStore.SetNumSurfaces( this );
 
 	Unlink();
 
@@ -709,6 +721,9 @@ idScreenRect idInteraction::CalcInteractionScissorRectangle( const idFrustum &vi
 		areaNumRef_t *area;
 
 		if ( frustumState == idInteraction::FRUSTUM_VALID ) {
+			// the area allocator is shared by all interactions, which may be
+			// culled by parallel front end jobs
+			Sys_EnterCriticalSection( CRITICAL_SECTION_TWO );
 			// retrieve all the areas the interaction frustum touches
 			for ( areaReference_t *ref = entityDef->entityRefs; ref; ref = ref->ownerNext ) {
 				area = entityDef->world->areaNumRefAllocator.Alloc();
@@ -717,6 +732,7 @@ idScreenRect idInteraction::CalcInteractionScissorRectangle( const idFrustum &vi
 				frustumAreas = area;
 			}
 			frustumAreas = tr.viewDef->renderWorld->FloodFrustumAreas( frustum, frustumAreas );
+			Sys_LeaveCriticalSection( CRITICAL_SECTION_TWO );
 			frustumState = idInteraction::FRUSTUM_VALIDAREAS;
 		}
 
@@ -806,6 +822,18 @@ bool idInteraction::CullInteractionByViewFrustum( const idFrustum &viewFrustum )
 	return false;
 }
 
+/*
+====================
+R_ShadowCapsRequired
+
+True if the shadow volume caps must always be drawn, because the
+shadow casting surface can be seen through.
+====================
+*/
+static bool R_ShadowCapsRequired( const idRenderEntityLocal *ent, const idMaterial *shader ) {
+	return ( shader->Coverage() != MC_OPAQUE || ( !r_skipSuppress.GetBool() && ent->parms.suppressSurfaceInViewID ) );
+}
+
 /*
 ====================
 idInteraction::CreateInteraction
@@ -846,11 +874,28 @@ void idInteraction::CreateInteraction( const idRenderModel *model ) {
 		shadowGen = SG_STATIC;
 	}
 
+	// turbo shadow volumes can be shared through the shadow cache
+	bool useShadowCache = ( shadowGen == SG_DYNAMIC && r_useTurboShadow.GetBool() && r_useShadowCache.GetBool() );
+	int shadowCacheFlags = 0;
+	if ( tr.backEndRendererHasVertexPrograms && r_useShadowVertexProgram.GetBool() ) {
+		shadowCacheFlags |= SHADOW_CACHE_VERTEX_PROGRAM;
+	}
+	if ( r_useShadowProjectedCull.GetBool() ) {
+		shadowCacheFlags |= SHADOW_CACHE_PROJECTED_CULL;
+	}
+
 	//
 	// create slots for each of the model's surfaces
 	//
 	numSurfaces = model->NumSurfaces();
 	surfaces = (surfaceInteraction_t *)R_ClearedStaticAlloc( sizeof( *surfaces ) * numSurfaces );
+	lightDef->world->interactionStore.SetNumSurfaces( this );
+
+	// the shadow volumes of all surfaces are created together after the loop
+	shadowVolumeJob_t *shadowJobs = (shadowVolumeJob_t *)_alloca( numSurfaces * sizeof( shadowJobs[0] ) );
+	int *shadowSurfaces = (int *)_alloca( numSurfaces * sizeof( shadowSurfaces[0] ) );
+	shadowCacheKey_t *shadowKeys = (shadowCacheKey_t *)_alloca( numSurfaces * sizeof( shadowKeys[0] ) );
+	int numShadowJobs = 0;
 
 	interactionGenerated = false;
 
@@ -905,29 +950,73 @@ void idInteraction::CreateInteraction( const idRenderModel *model ) {
 		}
 
 		// if the interaction has shadows and this surface casts a shadow
-		if ( HasShadows() && shader->SurfaceCastsShadow() && tri->silEdges != NULL ) {
+		if ( HasShadows() && shader->SurfaceCastsShadow() && R_LightUsesShadowMap( lightDef ) ) {
+
+			// the surface itself is drawn into the shadow maps of the light
+			interactionGenerated = true;
+
+		} else if ( HasShadows() && shader->SurfaceCastsShadow() && tri->silEdges != NULL ) {
 
 			// if the light has an optimized shadow volume, don't create shadows for any models that are part of the base areas
 			if ( lightDef->parms.prelightModel == NULL || !model->IsStaticWorldModel() || !r_useOptimizedShadows.GetBool() ) {
 
-				// this is the only place during gameplay (outside the utilities) that R_CreateShadowVolume() is called
-				sint->shadowTris = R_CreateShadowVolume( entityDef, tri, lightDef, shadowGen, sint->cullInfo );
-				if ( sint->shadowTris ) {
-					if ( shader->Coverage() != MC_OPAQUE || ( !r_skipSuppress.GetBool() && entityDef->parms.suppressSurfaceInViewID ) ) {
-						// if any surface is a shadow-casting perforated or translucent surface, or the
-						// base surface is suppressed in the view (world weapon shadows) we can't use
-						// the external shadow optimizations because we can see through some of the faces
-						sint->shadowTris->numShadowIndexesNoCaps = sint->shadowTris->numIndexes;
-						sint->shadowTris->numShadowIndexesNoFrontCaps = sint->shadowTris->numIndexes;
+				if ( useShadowCache ) {
+					int flags = shadowCacheFlags;
+					if ( R_ShadowCapsRequired( entityDef, shader ) ) {
+						flags |= SHADOW_CACHE_NO_CAPS_OPTIMIZE;
+					}
+					R_ShadowCacheKey( entityDef, tri, lightDef, flags, shadowKeys[numShadowJobs] );
+
+					sint->cachedShadow = R_FindCachedShadow( shadowKeys[numShadowJobs] );
+					if ( sint->cachedShadow ) {
+						sint->shadowTris = R_CachedShadowTris( sint->cachedShadow );
+						interactionGenerated = true;
+						continue;
 					}
 				}
+
+				shadowVolumeJob_t *job = &shadowJobs[numShadowJobs];
+				job->ent = entityDef;
+				job->tri = tri;
+				job->light = lightDef;
+				job->optimize = shadowGen;
+				job->cullInfo = &sint->cullInfo;
+				shadowSurfaces[numShadowJobs] = c;
+				numShadowJobs++;
 				interactionGenerated = true;
 			}
 		}
+	}
+
+	// this is the only place during gameplay (outside the utilities) that shadow volumes are created
+	double shadowTicks = Sys_GetClockTicks();
+	R_CreateShadowVolumes( shadowJobs, numShadowJobs );
+	R_StageTicks( tr.pc.shadowTicks, shadowTicks );
+
+	for ( int i = 0 ; i < numShadowJobs ; i++ ) {
+		surfaceInteraction_t *sint = &surfaces[shadowSurfaces[i]];
+
+		sint->shadowTris = shadowJobs[i].shadowTris;
+		if ( sint->shadowTris ) {
+			if ( R_ShadowCapsRequired( entityDef, sint->shader ) ) {
+				// if any surface is a shadow-casting perforated or translucent surface, or the
+				// base surface is suppressed in the view (world weapon shadows) we can't use
+				// the external shadow optimizations because we can see through some of the faces
+				sint->shadowTris->numShadowIndexesNoCaps = sint->shadowTris->numIndexes;
+				sint->shadowTris->numShadowIndexesNoFrontCaps = sint->shadowTris->numIndexes;
+			}
+		}
 
-		// free the cull information when it's no longer needed
-		if ( sint->lightTris != LIGHT_TRIS_DEFERRED ) {
-			R_FreeInteractionCullInfo( sint->cullInfo );
+		// the cache takes the volume, even if the surface didn't cast a shadow
+		if ( useShadowCache ) {
+			sint->cachedShadow = R_AddCachedShadow( shadowKeys[i], sint->shadowTris );
+		}
+	}
+
+	// free the cull information when it's no longer needed
+	for ( int c = 0 ; c < numSurfaces ; c++ ) {
+		if ( surfaces[c].lightTris != LIGHT_TRIS_DEFERRED ) {
+			R_FreeInteractionCullInfo( surfaces[c].cullInfo );
 		}
 	}
 
@@ -1012,25 +1101,20 @@ static bool R_PotentiallyInsideInfiniteShadow( const srfTriangles_t *occluder,
 
 /*
 ==================
-idInteraction::AddActiveInteraction
+idInteraction::CullActiveInteraction
 
-Create and add any necessary light and shadow triangles
+Returns true if neither the light surfaces nor the shadows of
+the interaction can be visible, otherwise sets the scissor
+rectangle that will be used for the shadows.
 
-If the model doesn't have any surfaces that need interactions
-with this type of light, it can be skipped, but we might need to
-instantiate the dynamic model to find out
+Apart from the locked frustum area flood this only changes
+the interaction itself, so the front end can run it from
+parallel jobs.
 ==================
 */
-void idInteraction::AddActiveInteraction( void ) {
-	viewLight_t *	vLight;
-	viewEntity_t *	vEntity;
-	idScreenRect	shadowScissor;
-	idScreenRect	lightScissor;
-	idVec3			localLightOrigin;
-	idVec3			localViewOrigin;
-
-	vLight = lightDef->viewLight;
-	vEntity = entityDef->viewEntity;
+bool idInteraction::CullActiveInteraction( idScreenRect &shadowScissor ) {
+	const viewLight_t *		vLight = lightDef->viewLight;
+	const viewEntity_t *	vEntity = entityDef->viewEntity;
 
 	// do not waste time culling the interaction frustum if there will be no shadows
 	if ( !HasShadows() ) {
@@ -1050,7 +1134,7 @@ void idInteraction::AddActiveInteraction( void ) {
 		// this will also cull the case where the light origin is inside the
 		// view frustum and the entity bounds are outside the view frustum
 		if ( CullInteractionByViewFrustum( tr.viewDef->viewFrustum ) ) {
-			return;
+			return true;
 		}
 
 		// calculate the shadow scissor rectangle
@@ -1058,10 +1142,100 @@ void idInteraction::AddActiveInteraction( void ) {
 	}
 
 	// get out before making the dynamic model if the shadow scissor rectangle is empty
-	if ( shadowScissor.IsEmpty() ) {
+	return shadowScissor.IsEmpty();
+}
+
+/*
+==================
+idInteraction::AddShadowMapCaster
+
+The same surfaces that would have shadow volumes for other lights
+==================
+*/
+void idInteraction::AddShadowMapCaster( surfaceInteraction_t *sint, const idScreenRect &shadowScissor ) {
+	srfTriangles_t *tri = sint->ambientTris;
+
+	if ( !tri || !sint->shader || !tri->numIndexes ) {
+		return;
+	}
+	if ( !HasShadows() || !sint->shader->SurfaceCastsShadow() ) {
+		return;
+	}
+
+	// "invisible ink" lights and shaders
+	if ( sint->shader->Spectrum() != lightDef->lightShader->Spectrum() ) {
+		return;
+	}
+
+	// check for view specific shadow suppression (player shadows, etc)
+	if ( !r_skipSuppress.GetBool() ) {
+		if ( entityDef->parms.suppressShadowInViewID &&
+			entityDef->parms.suppressShadowInViewID == tr.viewDef->renderView.viewID ) {
+			return;
+		}
+		if ( entityDef->parms.suppressShadowInLightID &&
+			entityDef->parms.suppressShadowInLightID == lightDef->parms.lightId ) {
+			return;
+		}
+	}
+
+	// the lit surface will share the ambient cache, so it needs the same contents
+	if ( !tri->ambientCache ) {
+		if ( !R_CreateAmbientCache( tri, sint->shader->ReceivesLighting() ) ) {
+			// skip if we are out of vertex memory
+			return;
+		}
+	}
+	vertexCache.Touch( tri->ambientCache );
+
+	if ( !tri->indexCache && r_useIndexBuffers.GetBool() ) {
+		vertexCache.Alloc( tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ), &tri->indexCache, true );
+	}
+	if ( tri->indexCache ) {
+		vertexCache.Touch( tri->indexCache );
+	}
+
+	R_LinkLightSurf( &lightDef->viewLight->shadowMapCasters, tri, entityDef->viewEntity, lightDef, NULL, shadowScissor, false );
+}
+
+/*
+==================
+idInteraction::AddActiveInteraction
+
+Create and add any necessary light and shadow triangles
+
+If the model doesn't have any surfaces that need interactions
+with this type of light, it can be skipped, but we might need to
+instantiate the dynamic model to find out
+==================
+*/
+void idInteraction::AddActiveInteraction( void ) {
+	idScreenRect	shadowScissor;
+
+	if ( CullActiveInteraction( shadowScissor ) ) {
 		return;
 	}
 
+	AddActiveInteraction( shadowScissor );
+}
+
+/*
+==================
+idInteraction::AddActiveInteraction
+
+Same as above, with the result of an earlier CullActiveInteraction
+==================
+*/
+void idInteraction::AddActiveInteraction( const idScreenRect &shadowScissor ) {
+	viewLight_t *	vLight;
+	viewEntity_t *	vEntity;
+	idScreenRect	lightScissor;
+	idVec3			localLightOrigin;
+	idVec3			localViewOrigin;
+
+	vLight = lightDef->viewLight;
+	vEntity = entityDef->viewEntity;
+
 	// We will need the dynamic surface created to make interactions, even if the
 	// model itself wasn't visible.  This just returns a cached value after it
 	// has been generated once in the view.
@@ -1125,10 +1299,21 @@ void idInteraction::AddActiveInteraction( void ) {
 
 					// reference the original surface's ambient cache
 					lightTris->ambientCache = tri->ambientCache;
+					lightTris->jointWeightCache = tri->jointWeightCache;
 
 					// touch the ambient surface so it won't get purged
 					vertexCache.Touch( lightTris->ambientCache );
 
+					// fogs and blends are drawn by the fixed function path, which
+					// can't skin the bind pose, so they get the transformed vertexes
+					if ( tri->jointWeightCache && ( lightDef->lightShader->IsFogLight() || lightDef->lightShader->IsBlendLight() ) ) {
+						lightTris->ambientCache = vertexCache.AllocFrameTemp( tri->verts, tri->numVerts * sizeof( tri->verts[0] ) );
+						lightTris->jointWeightCache = NULL;
+						if ( !lightTris->ambientCache ) {
+							continue;
+						}
+					}
+
 					// regenerate the lighting cache (for non-vertex program cards) if it has been purged
 					if ( !lightTris->lightingCache ) {
 						if ( !R_CreateLightingCache( entityDef, lightDef, lightTris ) ) {
@@ -1170,6 +1355,13 @@ void idInteraction::AddActiveInteraction( void ) {
 			}
 		}
 
+		// shadow mapped lights don't have shadow volumes, the surfaces that
+		// cast shadows are drawn into the shadow maps instead
+		if ( vLight->shadowMapType != SHADOWMAP_NONE ) {
+			AddShadowMapCaster( sint, shadowScissor );
+			continue;
+		}
+
 		srfTriangles_t *shadowTris = sint->shadowTris;
 
 		// the shadows will always have to be added, unless we can tell they
@@ -1243,6 +1435,271 @@ void idInteraction::AddActiveInteraction( void ) {
 	}
 }
 
+/*
+===============================================================================
+
+	idInteractionStore
+
+===============================================================================
+*/
+
+#define INTERACTION_CULL_LIGHT		BIT(6)		// the light isn't visible in the view
+#define INTERACTION_CULL_EMPTY		BIT(7)		// the light and entity don't interact
+
+/*
+===============
+idInteractionStore::idInteractionStore
+===============
+*/
+idInteractionStore::idInteractionStore( void ) {
+	num = 0;
+	size = 0;
+	numChecked = 0;
+	interactions = NULL;
+	lightIndexes = NULL;
+	numSurfaces = NULL;
+	for ( int i = 0 ; i < 6 ; i++ ) {
+		bounds[i] = NULL;
+	}
+	cullBits = NULL;
+}
+
+/*
+===============
+idInteractionStore::~idInteractionStore
+===============
+*/
+idInteractionStore::~idInteractionStore( void ) {
+	Clear();
+}
+
+/*
+===============
+idInteractionStore::Clear
+===============
+*/
+void idInteractionStore::Clear( void ) {
+	for ( int i = 0 ; i < num ; i++ ) {
+		interactions[i]->storeSlot = -1;
+	}
+
+	Mem_Free16( interactions );
+	Mem_Free16( lightIndexes );
+	Mem_Free16( numSurfaces );
+	for ( int i = 0 ; i < 6 ; i++ ) {
+		Mem_Free16( bounds[i] );
+		bounds[i] = NULL;
+	}
+	Mem_Free16( cullBits );
+
+	interactions = NULL;
+	lightIndexes = NULL;
+	numSurfaces = NULL;
+	cullBits = NULL;
+	num = 0;
+	size = 0;
+	numChecked = 0;
+}
+
+/*
+===============
+idInteractionStore::Resize
+===============
+*/
+void idInteractionStore::Resize( int newSize ) {
+	idInteraction **newInteractions = (idInteraction **)Mem_Alloc16( newSize * sizeof( interactions[0] ) );
+	int *newLightIndexes = (int *)Mem_Alloc16( newSize * sizeof( lightIndexes[0] ) );
+	int *newNumSurfaces = (int *)Mem_Alloc16( newSize * sizeof( numSurfaces[0] ) );
+	byte *newCullBits = (byte *)Mem_Alloc16( newSize * sizeof( cullBits[0] ) );
+
+	if ( num ) {
+		memcpy( newInteractions, interactions, num * sizeof( interactions[0] ) );
+		memcpy( newLightIndexes, lightIndexes, num * sizeof( lightIndexes[0] ) );
+		memcpy( newNumSurfaces, numSurfaces, num * sizeof( numSurfaces[0] ) );
+		memcpy( newCullBits, cullBits, num * sizeof( cullBits[0] ) );
+	}
+
+	Mem_Free16( interactions );
+	Mem_Free16( lightIndexes );
+	Mem_Free16( numSurfaces );
+	Mem_Free16( cullBits );
+
+	interactions = newInteractions;
+	lightIndexes = newLightIndexes;
+	numSurfaces = newNumSurfaces;
+	cullBits = newCullBits;
+
+	for ( int i = 0 ; i < 6 ; i++ ) {
+		float *newBounds = (float *)Mem_Alloc16( newSize * sizeof( bounds[i][0] ) );
+		if ( num ) {
+			memcpy( newBounds, bounds[i], num * sizeof( bounds[i][0] ) );
+		}
+		Mem_Free16( bounds[i] );
+		bounds[i] = newBounds;
+	}
+
+	size = newSize;
+}
+
+/*
+===============
+R_InteractionCullBounds
+
+World space bounds of everything the interaction can light or shadow.
+A shadow extends from the entity away from the light origin, so on every
+axis the entity bounds are stretched to the light bounds on the side that
+faces away from the light origin.
+===============
+*/
+static void R_InteractionCullBounds( const idInteraction *inter, idBounds &bounds ) {
+	const idRenderEntityLocal *edef = inter->entityDef;
+	const idRenderLightLocal *ldef = inter->lightDef;
+	idBounds lightBounds;
+
+	bounds.FromTransformedBounds( edef->referenceBounds, edef->parms.origin, edef->parms.axis );
+
+	if ( ldef->parms.pointLight ) {
+		lightBounds.FromTransformedBounds( idBounds( -ldef->parms.lightRadius, ldef->parms.lightRadius ), ldef->parms.origin, ldef->parms.axis );
+	} else {
+		lightBounds = ldef->frustumTris->bounds;
+	}
+
+	if ( inter->HasShadows() ) {
+		const idVec3 &origin = ldef->globalLightOrigin;
+		for ( int i = 0 ; i < 3 ; i++ ) {
+			if ( bounds[1][i] > origin[i] ) {
+				bounds[1][i] = lightBounds[1][i];
+			}
+			if ( bounds[0][i] < origin[i] ) {
+				bounds[0][i] = lightBounds[0][i];
+			}
+		}
+	}
+
+	// an inverted box means the entity is outside the light, which can be culled either way
+	bounds.IntersectSelf( lightBounds );
+}
+
+/*
+===============
+idInteractionStore::Add
+===============
+*/
+void idInteractionStore::Add( idInteraction *inter ) {
+	idBounds interBounds;
+
+	if ( num >= size ) {
+		Resize( Max( 1024, size * 2 ) );
+	}
+
+	R_InteractionCullBounds( inter, interBounds );
+
+	int slot = num++;
+	interactions[slot] = inter;
+	lightIndexes[slot] = inter->lightDef->index;
+	numSurfaces[slot] = inter->numSurfaces;
+	for ( int i = 0 ; i < 3 ; i++ ) {
+		bounds[i][slot] = interBounds[0][i];
+		bounds[i+3][slot] = interBounds[1][i];
+	}
+	cullBits[slot] = 0;
+
+	inter->storeSlot = slot;
+}
+
+/*
+===============
+idInteractionStore::Remove
+===============
+*/
+void idInteractionStore::Remove( idInteraction *inter ) {
+	int slot = inter->storeSlot;
+
+	if ( slot < 0 ) {
+		return;
+	}
+	assert( slot < num && interactions[slot] == inter );
+
+	// move the last interaction into the slot
+	int last = --num;
+	if ( slot != last ) {
+		interactions[slot] = interactions[last];
+		lightIndexes[slot] = lightIndexes[last];
+		numSurfaces[slot] = numSurfaces[last];
+		for ( int i = 0 ; i < 6 ; i++ ) {
+			bounds[i][slot] = bounds[i][last];
+		}
+		cullBits[slot] = cullBits[last];
+		interactions[slot]->storeSlot = slot;
+	}
+
+	// the moved interaction may have been added after the view was culled
+	if ( slot < numChecked && last >= numChecked ) {
+		cullBits[slot] = 0;
+	}
+	if ( numChecked > num ) {
+		numChecked = num;
+	}
+
+	inter->storeSlot = -1;
+}
+
+/*
+===============
+idInteractionStore::SetNumSurfaces
+===============
+*/
+void idInteractionStore::SetNumSurfaces( const idInteraction *inter ) {
+	if ( inter->storeSlot < 0 ) {
+		return;
+	}
+	numSurfaces[inter->storeSlot] = inter->numSurfaces;
+}
+
+/*
+===============
+idInteractionStore::CullByView
+
+The bounds of all interactions are culled against the view frustum at once
+and combined with the visibility of the lights and the surface counts.
+===============
+*/
+void idInteractionStore::CullByView( const idRenderWorldLocal *world ) {
+	int i;
+
+	numChecked = num;
+	if ( !num ) {
+		return;
+	}
+
+	if ( r_useInteractionCulling.GetBool() ) {
+		SIMDProcessor->CullBounds( cullBits, tr.viewDef->frustum, 5, bounds, num );
+	} else {
+		memset( cullBits, 0, num * sizeof( cullBits[0] ) );
+	}
+
+	int numLights = world->lightDefs.Num();
+	byte *lightCulled = (byte *)_alloca16( numLights * sizeof( lightCulled[0] ) );
+	for ( i = 0 ; i < numLights ; i++ ) {
+		const idRenderLightLocal *ldef = world->lightDefs[i];
+		lightCulled[i] = ( ldef == NULL || ldef->viewCount != tr.viewCount ) ? INTERACTION_CULL_LIGHT : 0;
+	}
+
+	for ( i = 0 ; i < num ; i++ ) {
+		cullBits[i] |= lightCulled[lightIndexes[i]];
+		cullBits[i] |= ( numSurfaces[i] == 0 ) ? INTERACTION_CULL_EMPTY : 0;
+	}
+}
+
+/*
+===============
+idInteractionStore::MemoryUsed
+===============
+*/
+int idInteractionStore::MemoryUsed( void ) const {
+	return size * ( sizeof( interactions[0] ) + sizeof( lightIndexes[0] ) + sizeof( numSurfaces[0] ) + 6 * sizeof( bounds[0][0] ) + sizeof( cullBits[0] ) );
+}
+
 /*
 ===================
 R_ShowInteractionMemory_f
@@ -1305,4 +1762,5 @@ void R_ShowInteractionMemory_f( const idCmdArgs &args ) {
 	common->Printf( "%i deferred interactions, %i empty interactions\n", deferredInteractions, emptyInteractions );
 	common->Printf( "%5i indexes %5i verts in %5i light tris\n", lightTriIndexes, lightTriVerts, lightTris );
 	common->Printf( "%5i indexes %5i verts in %5i shadow tris\n", shadowTriIndexes, shadowTriVerts, shadowTris );
+	common->Printf( "%i interactions in the interaction store using %ik\n", tr.primaryWorld->interactionStore.Num(), tr.primaryWorld->interactionStore.MemoryUsed() / 1024 );
 }
@@ -61,6 +61,10 @@ typedef struct {
 } srfCullInfo_t;
 
 
+// turbo shadow volume that can be shared between interactions, see R_FindCachedShadow
+typedef struct shadowCacheEntry_s shadowCacheEntry_t;
+
+
 typedef struct {		
 	// if lightTris == LIGHT_TRIS_DEFERRED, then the calculation of the
 	// lightTris has been deferred, and must be done if ambientTris is visible
@@ -69,6 +73,9 @@ typedef struct {
 	// shadow volume triangle surface
 	srfTriangles_t *		shadowTris;
 
+	// if not NULL, shadowTris is owned by the shadow cache
+	shadowCacheEntry_t *	cachedShadow;
+
 	// so we can check ambientViewCount before adding lightTris, and get
 	// at the shared vertex and possibly shadowVertex caches
 	srfTriangles_t *		ambientTris;
@@ -110,6 +117,8 @@ public:
 	idInteraction *			entityNext;				// for entityDef chains
 	idInteraction *			entityPrev;
 
+	int						storeSlot;				// index in the interactionStore of the world
+
 public:
 							idInteraction( void );
 
@@ -145,6 +154,10 @@ public:
 	// makes sure all necessary light surfaces and shadow surfaces are created, and
 	// calls R_LinkLightSurf() for each one
 	void					AddActiveInteraction( void );
+	void					AddActiveInteraction( const idScreenRect &shadowScissor );
+
+	// view culling part of AddActiveInteraction, safe to call from front end jobs
+	bool					CullActiveInteraction( idScreenRect &shadowScissor );
 
 private:
 	enum {
@@ -162,6 +175,9 @@ private:
 	// actually create the interaction
 	void					CreateInteraction( const idRenderModel *model );
 
+	// links a surface that casts a shadow into the shadow maps of the light
+	void					AddShadowMapCaster( surfaceInteraction_t *sint, const idScreenRect &shadowScissor );
+
 	// unlink from entity and light lists
 	void					Unlink( void );
 
@@ -175,6 +191,69 @@ private:
 };
 
 
+/*
+===============================================================================
+
+	Interaction store.
+
+	Keeps the data needed to cull the interactions of a world in flat arrays,
+	so all of them can be culled against the view with a linear scan instead
+	of chasing the interaction lists of every entity.
+
+	Interactions are added and removed as they are allocated and freed, which
+	happens whenever a light or entity moves, so the store is always current.
+	The last interaction is moved into the slot of a removed one.
+
+===============================================================================
+*/
+
+class idRenderWorldLocal;
+
+class idInteractionStore {
+public:
+							idInteractionStore( void );
+							~idInteractionStore( void );
+
+	// frees all memory, the interactions are not changed
+	void					Clear( void );
+
+	int						Num( void ) const { return num; }
+	idInteraction *			GetInteraction( int slot ) const { return interactions[slot]; }
+
+	// adds an interaction and sets its storeSlot
+	void					Add( idInteraction *inter );
+	void					Remove( idInteraction *inter );
+
+	// must be called when the number of surfaces of an interaction changes
+	void					SetNumSurfaces( const idInteraction *inter );
+
+	// culls all interactions against the view and the visible lights of tr.viewDef
+	void					CullByView( const idRenderWorldLocal *world );
+
+	// true if the interaction doesn't need to be considered in the current view
+	bool					IsCulled( const idInteraction *inter ) const;
+
+	int						MemoryUsed( void ) const;
+
+private:
+	int						num;
+	int						size;
+	int						numChecked;				// number of interactions checked by CullByView
+
+	idInteraction **		interactions;
+	int *					lightIndexes;
+	int *					numSurfaces;
+	float *					bounds[6];				// world space, mins x, y, z then maxs x, y, z
+	byte *					cullBits;
+
+	void					Resize( int newSize );
+};
+
+ID_INLINE bool idInteractionStore::IsCulled( const idInteraction *inter ) const {
+	return ( inter->storeSlot < numChecked && cullBits[inter->storeSlot] != 0 );
+}
+
+
 void R_CalcInteractionFacing( const idRenderEntityLocal *ent, const srfTriangles_t *tri, const idRenderLightLocal *light, srfCullInfo_t &cullInfo );
 void R_CalcInteractionCullBits( const idRenderEntityLocal *ent, const srfTriangles_t *tri, const idRenderLightLocal *light, srfCullInfo_t &cullInfo );
 void R_FreeInteractionCullInfo( srfCullInfo_t &cullInfo );
@@ -1865,6 +1865,11 @@ void idMaterial::ParseMaterial( idLexer &src ) {
 			SetMaterialFlag( MF_NOPORTALFOG );
 			continue;
 		}
+		// shadowMap lets a light use shadow maps instead of shadow volumes
+		else if ( !token.Icmp( "shadowMap" ) ) {
+			SetMaterialFlag( MF_SHADOWMAP );
+			continue;
+		}
 		// forceShadows allows nodraw surfaces to cast shadows
 		else if ( !token.Icmp( "forceShadows" ) ) {
 			SetMaterialFlag( MF_FORCESHADOWS );
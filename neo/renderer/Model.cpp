@@ -2134,8 +2134,12 @@ void idRenderModelStatic::FreeVertexCache( void ) {
 			continue;
 		}
 		if ( tri->ambientCache ) {
-			vertexCache.Free( tri->ambientCache );
+			// the bind pose of GPU skinned surfaces is owned by the MD5 model
+			if ( tri->jointWeightCache == NULL ) {
+				vertexCache.Free( tri->ambientCache );
+			}
 			tri->ambientCache = NULL;
+			tri->jointWeightCache = NULL;
 		}
 		// static shadows may be present
 		if ( tri->shadowCache ) {
@@ -80,6 +80,15 @@ typedef struct shadowCache_s {
 	idVec4						xyz;					// we use homogenous coordinate tricks
 } shadowCache_t;
 
+const int MAX_GPU_SKIN_JOINTS	= 256;
+const int MAX_GPU_SKIN_WEIGHTS	= 4;
+
+// joint influences of a vertex for skinning in the vertex shader, unused weights are zero
+typedef struct skinWeight_s {
+	byte						joints[MAX_GPU_SKIN_WEIGHTS];
+	float						weights[MAX_GPU_SKIN_WEIGHTS];
+} skinWeight_t;
+
 const int SHADOW_CAP_INFINITE	= 64;
 
 // our only drawing geometry type
@@ -137,6 +146,8 @@ typedef struct srfTriangles_s {
 	struct vertCache_s *		ambientCache;			// idDrawVert
 	struct vertCache_s *		lightingCache;			// lightingCache_t
 	struct vertCache_s *		shadowCache;			// shadowCache_t
+	struct vertCache_s *		jointWeightCache;		// skinWeight_t, if set the ambientCache holds the bind pose vertexes
+														// of a GPU skinned model, both caches are owned by the model
 } srfTriangles_t;
 
 typedef idList<srfTriangles_t *> idTriList;
@@ -254,6 +254,8 @@ idRenderModel *idRenderModelManagerLocal::GetModel( const char *modelName, bool
 	idStr		canonical;
 	idStr		extension;
 
+	idScopedMemTag	memTag( MEM_TAG_MODEL );
+
 	if ( !modelName || !modelName[0] ) {
 		return NULL;
 	}
@@ -269,7 +271,9 @@ idRenderModel *idRenderModelManagerLocal::GetModel( const char *modelName, bool
 		if ( canonical.Icmp( model->Name() ) == 0 ) {
 			if ( !model->IsLoaded() ) {
 				// reload it if it was purged
+				double start = Sys_GetClockTicks();
 				model->LoadModel();
+				loadStats.Add( LOAD_MODELS, Sys_GetClockTicks() - start, 1 );
 			} else if ( insideLevelLoad && !model->IsLevelLoadReferenced() ) {
 				// we are reusing a model already in memory, but
 				// touch all the materials to make sure they stay
@@ -286,6 +290,7 @@ idRenderModel *idRenderModelManagerLocal::GetModel( const char *modelName, bool
 	// determine which subclass of idRenderModel to initialize
 
 	idRenderModel	*model;
+	double			start = Sys_GetClockTicks();
 
 	canonical.ExtractFileExtension( extension );
 
@@ -324,6 +329,8 @@ idRenderModel *idRenderModelManagerLocal::GetModel( const char *modelName, bool
 		model = smodel;
 	}
 
+	loadStats.Add( LOAD_MODELS, Sys_GetClockTicks() - start, 1 );
+
 	model->SetLevelLoadReferenced( true );
 
 	if ( !createIfNotFound && model->IsDefaultModel() ) {
@@ -550,7 +557,9 @@ void idRenderModelManagerLocal::EndLevelLoad() {
 		if ( model->IsLevelLoadReferenced() && !model->IsLoaded() && model->IsReloadable() ) {
 
 			loadCount++;
+			double loadStart = Sys_GetClockTicks();
 			model->LoadModel();
+			loadStats.Add( LOAD_MODELS, Sys_GetClockTicks() - loadStart, 1 );
 
 			if ( ( loadCount & 15 ) == 0 ) {
 				session->PacifierUpdate();
@@ -143,12 +143,14 @@ public:
 								~idMD5Mesh();
 
  	void						ParseMesh( idLexer &parser, int numJoints, const idJointMat *joints );
-	void						UpdateSurface( const struct renderEntity_s *ent, const idJointMat *joints, modelSurface_t *surf );
+	void						UpdateSurface( const struct renderEntity_s *ent, const idJointMat *joints, modelSurface_t *surf, bool gpuSkinning );
 	idBounds					CalcBounds( const idJointMat *joints );
 	int							NearestJoint( int a, int b, int c ) const;
 	int							NumVerts( void ) const;
 	int							NumTris( void ) const;
 	int							NumWeights( void ) const;
+	bool						CanSkinOnGPU( const struct renderEntity_s *ent, const idMaterial *shader ) const;
+	void						FreeSkinningCaches( void );
 
 private:
 	idList<idVec2>				texCoords;			// texture coordinates
@@ -159,7 +161,12 @@ private:
 	int							numTris;			// number of triangles
 	struct deformInfo_s *		deformInfo;			// used to create srfTriangles_t from base frames and new vertexes
 	int							surfaceNum;			// number of the static surface created for this mesh
+	idDrawVert *				bindPoseVerts;		// deformInfo->numOutputVerts vertexes with tangents, NULL if the mesh can't be skinned on the GPU
+	skinWeight_t *				skinWeights;		// joint influences of the bindPoseVerts
+	struct vertCache_s *		bindPoseCache;
+	struct vertCache_s *		skinWeightCache;
 
+	void						CreateSkinWeights( int numJoints, const idJointMat *joints );
 	void						TransformVerts( idDrawVert *verts, const idJointMat *joints );
 	void						TransformScaledVerts( idDrawVert *verts, const idJointMat *joints, float scale );
 };
@@ -182,11 +189,17 @@ public:
 	virtual const char *		GetJointName( jointHandle_t handle ) const;
 	virtual const idJointQuat *	GetDefaultPose( void ) const;
 	virtual int					NearestJoint( int surfaceNum, int a, int b, int c ) const;
+	virtual void				FreeVertexCache();
+
+								// joint matrices relative to the bind pose for the GPU skinned surfaces of the entity,
+								// allocated from frame memory
+	const idJointMat *			CreateSkinMatrices( const struct renderEntity_s *ent ) const;
 
 private:
 	idList<idMD5Joint>			joints;
 	idList<idJointQuat>			defaultPose;
 	idList<idMD5Mesh>			meshes;
+	idList<idJointMat>			inverseBindPose;	// takes the vertexes of the bind pose back to joint space
 
 	void						CalculateBounds( const idJointMat *joints );
 	void						GetFrameBounds( const renderEntity_t *ent, idBounds &bounds ) const;
@@ -64,6 +64,10 @@ idMD5Mesh::idMD5Mesh() {
 	numTris			= 0;
 	deformInfo		= NULL;
 	surfaceNum		= 0;
+	bindPoseVerts	= NULL;
+	skinWeights		= NULL;
+	bindPoseCache	= NULL;
+	skinWeightCache	= NULL;
 }
 
 /*
@@ -74,6 +78,9 @@ idMD5Mesh::~idMD5Mesh
 idMD5Mesh::~idMD5Mesh() {
 	Mem_Free16( scaledWeights );
 	Mem_Free16( weightIndex );
+	Mem_Free16( bindPoseVerts );
+	Mem_Free16( skinWeights );
+	FreeSkinningCaches();
 	if ( deformInfo ) {
 		R_FreeDeformInfo( deformInfo );
 		deformInfo = NULL;
@@ -243,6 +250,111 @@ void idMD5Mesh::ParseMesh( idLexer &parser, int numJoints, const idJointMat *joi
 	}
 	TransformVerts( verts, joints );
 	deformInfo = R_BuildDeformInfo( texCoords.Num(), verts, tris.Num(), tris.Ptr(), shader->UseUnsmoothedTangents() );
+
+	CreateSkinWeights( numJoints, joints );
+}
+
+/*
+====================
+idMD5Mesh::CreateSkinWeights
+
+Creates the bind pose vertexes and the joint influences for skinning in
+the vertex shader.  Meshes with more joints or more weights per vertex than
+the vertex shader handles are always transformed on the CPU.
+====================
+*/
+void idMD5Mesh::CreateSkinWeights( int numJoints, const idJointMat *joints ) {
+	int i, j, k, base;
+
+	if ( numJoints > MAX_GPU_SKIN_JOINTS ) {
+		return;
+	}
+
+	skinWeights = (skinWeight_t *) Mem_Alloc16( deformInfo->numOutputVerts * sizeof( skinWeights[0] ) );
+	memset( skinWeights, 0, deformInfo->numOutputVerts * sizeof( skinWeights[0] ) );
+
+	for ( i = 0, j = 0; i < texCoords.Num(); i++ ) {
+		for ( k = 0; ; k++, j++ ) {
+			if ( k == MAX_GPU_SKIN_WEIGHTS ) {
+				Mem_Free16( skinWeights );
+				skinWeights = NULL;
+				return;
+			}
+			skinWeights[i].joints[k] = (byte)( weightIndex[j * 2 + 0] / sizeof( idJointMat ) );
+			skinWeights[i].weights[k] = scaledWeights[j].w;
+			if ( weightIndex[j * 2 + 1] ) {
+				j++;
+				break;
+			}
+		}
+	}
+
+	bindPoseVerts = (idDrawVert *) Mem_Alloc16( deformInfo->numOutputVerts * sizeof( bindPoseVerts[0] ) );
+	for ( i = 0; i < deformInfo->numSourceVerts; i++ ) {
+		bindPoseVerts[i].Clear();
+		bindPoseVerts[i].st = texCoords[i];
+	}
+	TransformVerts( bindPoseVerts, joints );
+
+	// replicate the mirror seam vertexes
+	base = deformInfo->numOutputVerts - deformInfo->numMirroredVerts;
+	for ( i = 0; i < deformInfo->numMirroredVerts; i++ ) {
+		bindPoseVerts[base + i] = bindPoseVerts[deformInfo->mirroredVerts[i]];
+		skinWeights[base + i] = skinWeights[deformInfo->mirroredVerts[i]];
+	}
+
+	// the normals and tangents are derived the same way UpdateSurface does it
+	srfTriangles_t tri;
+	memset( &tri, 0, sizeof( tri ) );
+	tri.numVerts = deformInfo->numOutputVerts;
+	tri.verts = bindPoseVerts;
+	tri.numIndexes = deformInfo->numIndexes;
+	tri.indexes = deformInfo->indexes;
+	tri.numMirroredVerts = deformInfo->numMirroredVerts;
+	tri.mirroredVerts = deformInfo->mirroredVerts;
+	tri.numDupVerts = deformInfo->numDupVerts;
+	tri.dupVerts = deformInfo->dupVerts;
+	tri.dominantTris = deformInfo->dominantTris;
+	R_DeriveTangents( &tri, false );
+}
+
+/*
+====================
+idMD5Mesh::FreeSkinningCaches
+====================
+*/
+void idMD5Mesh::FreeSkinningCaches( void ) {
+	vertexCache.Free( bindPoseCache );
+	bindPoseCache = NULL;
+	vertexCache.Free( skinWeightCache );
+	skinWeightCache = NULL;
+}
+
+/*
+====================
+idMD5Mesh::CanSkinOnGPU
+
+The vertex shaders can only skin surfaces that don't need the vertexes
+on the CPU for drawing, the positions are still transformed every time
+the surface is updated for culling, light triangles and shadow volumes.
+====================
+*/
+bool idMD5Mesh::CanSkinOnGPU( const struct renderEntity_s *ent, const idMaterial *shader ) const {
+	if ( bindPoseVerts == NULL || !r_useGPUSkinning.GetBool() || tr.backEndRenderer != BE_GL33 ) {
+		return false;
+	}
+	if ( ent->shaderParms[ SHADERPARM_MD5_SKINSCALE ] != 0.0f ) {
+		return false;
+	}
+	if ( shader->Deform() != DFRM_NONE || shader->Texgen() != TG_EXPLICIT ) {
+		return false;
+	}
+	for ( int i = 0; i < shader->GetNumStages(); i++ ) {
+		if ( shader->GetStage( i )->newStage ) {
+			return false;
+		}
+	}
+	return true;
 }
 
 /*
@@ -272,7 +384,7 @@ void idMD5Mesh::TransformScaledVerts( idDrawVert *verts, const idJointMat *entJo
 idMD5Mesh::UpdateSurface
 ====================
 */
-void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMat *entJoints, modelSurface_t *surf ) {
+void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMat *entJoints, modelSurface_t *surf, bool gpuSkinning ) {
 	int i, base;
 	srfTriangles_t *tri;
 
@@ -336,6 +448,29 @@ void idMD5Mesh::UpdateSurface( const struct renderEntity_s *ent, const idJointMa
 
 	R_BoundTriSurf( tri );
 
+	if ( gpuSkinning ) {
+		// the bind pose and the weights stay in the vertex cache, only the
+		// joint matrices of the view entity have to be sent for drawing
+		if ( !bindPoseCache ) {
+			vertexCache.Alloc( bindPoseVerts, deformInfo->numOutputVerts * sizeof( bindPoseVerts[0] ), &bindPoseCache );
+		}
+		if ( !skinWeightCache ) {
+			vertexCache.Alloc( skinWeights, deformInfo->numOutputVerts * sizeof( skinWeights[0] ), &skinWeightCache );
+		}
+		if ( bindPoseCache && skinWeightCache ) {
+			vertexCache.Touch( bindPoseCache );
+			vertexCache.Touch( skinWeightCache );
+			tri->ambientCache = bindPoseCache;
+			tri->jointWeightCache = skinWeightCache;
+
+			// the normals and tangents are never needed on the CPU
+			if ( !r_useDeferredTangents.GetBool() ) {
+				R_DeriveFacePlanes( tri );
+			}
+			return;
+		}
+	}
+
 	// If a surface is going to be have a lighting interaction generated, it will also have to call
 	// R_DeriveTangents() to get normals, tangents, and face planes.  If it only
 	// needs shadows generated, it will only have to generate face planes.  If it only
@@ -559,6 +694,15 @@ void idRenderModelMD5::LoadModel() {
 	}
 	parser.ExpectTokenString( "}" );
 
+	// the inverse of the bind pose takes the vertexes of the GPU skinned meshes back to joint space
+	inverseBindPose.SetGranularity( 1 );
+	inverseBindPose.SetNum( joints.Num() );
+	for( i = 0; i < joints.Num(); i++ ) {
+		inverseBindPose[ i ].SetRotation( mat3_identity );
+		inverseBindPose[ i ].SetTranslation( vec3_origin );
+		inverseBindPose[ i ] /= poseMat3[ i ];
+	}
+
 	for( i = 0; i < meshes.Num(); i++ ) {
 		parser.ExpectTokenString( "mesh" );
 		meshes[ i ].ParseMesh( parser, defaultPose.Num(), poseMat3 );
@@ -801,7 +945,7 @@ idRenderModel *idRenderModelMD5::InstantiateDynamicModel( const struct renderEnt
 			surf->id = i;
 		}
 
-		mesh->UpdateSurface( ent, ent->joints, surf );
+		mesh->UpdateSurface( ent, ent->joints, surf, mesh->CanSkinOnGPU( ent, shader ) );
 
 		staticModel->bounds.AddPoint( surf->geometry->bounds[0] );
 		staticModel->bounds.AddPoint( surf->geometry->bounds[1] );
@@ -899,6 +1043,40 @@ int idRenderModelMD5::NearestJoint( int surfaceNum, int a, int b, int c ) const
 	return 0;
 }
 
+/*
+====================
+idRenderModelMD5::FreeVertexCache
+====================
+*/
+void idRenderModelMD5::FreeVertexCache() {
+	idRenderModelStatic::FreeVertexCache();
+
+	for ( int i = 0; i < meshes.Num(); i++ ) {
+		meshes[i].FreeSkinningCaches();
+	}
+}
+
+/*
+====================
+idRenderModelMD5::CreateSkinMatrices
+
+The bind pose vertexes are taken back to joint space by the inverse
+bind pose before the joints of the entity are applied.
+====================
+*/
+const idJointMat *idRenderModelMD5::CreateSkinMatrices( const struct renderEntity_s *ent ) const {
+	if ( ent->joints == NULL || ent->numJoints != inverseBindPose.Num() ) {
+		return NULL;
+	}
+
+	idJointMat *skinMatrices = (idJointMat *)R_FrameAlloc( ent->numJoints * sizeof( skinMatrices[0] ) );
+	for ( int i = 0; i < ent->numJoints; i++ ) {
+		skinMatrices[i] = inverseBindPose[i];
+		skinMatrices[i] *= ent->joints[i];
+	}
+	return skinMatrices;
+}
+
 /*
 ====================
 idRenderModelMD5::TouchData
@@ -930,6 +1108,7 @@ void idRenderModelMD5::PurgeModel() {
 	joints.Clear();
 	defaultPose.Clear();
 	meshes.Clear();
+	inverseBindPose.Clear();
 }
 
 /*
@@ -941,7 +1120,7 @@ int	idRenderModelMD5::Memory() const {
 	int		total, i;
 
 	total = sizeof( *this );
-	total += joints.MemoryUsed() + defaultPose.MemoryUsed() + meshes.MemoryUsed();
+	total += joints.MemoryUsed() + defaultPose.MemoryUsed() + meshes.MemoryUsed() + inverseBindPose.MemoryUsed();
 
 	// count up strings
 	for ( i = 0; i < joints.Num(); i++ ) {
@@ -953,6 +1132,9 @@ int	idRenderModelMD5::Memory() const {
 		const idMD5Mesh *mesh = &meshes[i];
 
 		total += mesh->texCoords.MemoryUsed() + mesh->numWeights * ( sizeof( mesh->scaledWeights[0] ) + sizeof( mesh->weightIndex[0] ) * 2 );
+		if ( mesh->bindPoseVerts ) {
+			total += mesh->deformInfo->numOutputVerts * ( sizeof( mesh->bindPoseVerts[0] ) + sizeof( mesh->skinWeights[0] ) );
+		}
 
 		// sum up deform info
 		total += sizeof( mesh->deformInfo );
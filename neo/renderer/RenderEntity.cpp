@@ -43,6 +43,7 @@ idRenderEntityLocal::idRenderEntityLocal() {
 	dynamicModelFrameCount	= 0;
 	cachedDynamicModel		= NULL;
 	referenceBounds			= bounds_zero;
+	areaRefBounds			= bounds_zero;
 	viewCount				= 0;
 	viewEntity				= NULL;
 	visibleCount			= 0;
@@ -43,6 +43,9 @@ only be called when the back end thread is idle.
 =====================
 */
 static void R_PerformanceCounters( void ) {
+	// the front end jobs of the frame are done
+	R_MergeJobCounters();
+
 	if ( r_showPrimitives.GetInteger() != 0 ) {
 		
 		float megaBytes = globalImages->SumOfUsedImages() / ( 1024*1024.0 );
@@ -93,13 +96,22 @@ static void R_PerformanceCounters( void ) {
 	}
 
 	if ( r_showInteractions.GetBool() ) {
-		common->Printf( "createInteractions:%i createLightTris:%i createShadowVolumes:%i\n",
-			tr.pc.c_createInteractions, tr.pc.c_createLightTris, tr.pc.c_createShadowVolumes );
+		common->Printf( "createInteractions:%i createLightTris:%i createShadowVolumes:%i shadowCacheHits:%i shadowCacheMisses:%i\n",
+			tr.pc.c_createInteractions, tr.pc.c_createLightTris, tr.pc.c_createShadowVolumes,
+			tr.pc.c_shadowCacheHits, tr.pc.c_shadowCacheMisses );
  	}
 	if ( r_showDefs.GetBool() ) {
 		common->Printf( "viewEntities:%i  shadowEntities:%i  viewLights:%i\n", tr.pc.c_visibleViewEntities,
 			tr.pc.c_shadowViewEntities, tr.pc.c_viewLights );
 	}
+	if ( r_showOcclusion.GetBool() ) {
+		common->Printf( "occluderTris:%i  entities:%i/%i culled  lights:%i/%i culled\n", tr.pc.c_occluderTris,
+			tr.pc.c_occlusionCulledEntities, tr.pc.c_occlusionTestedEntities,
+			tr.pc.c_occlusionCulledLights, tr.pc.c_occlusionTestedLights );
+	}
+	if ( r_showPortalCache.GetBool() ) {
+		common->Printf( "portalChains: %i flooded  %i reused\n", tr.pc.c_portalChainsFlooded, tr.pc.c_portalChainsReused );
+	}
 	if ( r_showUpdates.GetBool() ) {
 		common->Printf( "entityUpdates:%i  entityRefs:%i  lightUpdates:%i  lightRefs:%i\n", 
 			tr.pc.c_entityUpdates, tr.pc.c_entityReferences,
@@ -107,18 +119,169 @@ static void R_PerformanceCounters( void ) {
 	}
 	if ( r_showMemory.GetBool() ) {
 		int	m1 = frameData ? frameData->memoryHighwater : 0;
-		common->Printf( "frameData: %i (%i)\n", R_CountFrameData(), m1 );
+		int	m2 = frameData ? frameData->memoryCommitted : 0;
+		int	m3 = frameData ? frameData->memoryReserved : 0;
+		common->Printf( "frameData: %i (%i) committed:%i reserved:%i\n", R_CountFrameData(), m1, m2, m3 );
+	}
+	if ( r_showBatches.GetBool() ) {
+		common->Printf( "gl33 draws:%i merged:%i stateChanges:%i uniforms:%i uniformBytes:%ik shadowMapViews:%i shadowMapDraws:%i\n",
+			backEnd.pc.c_gl33Draws, backEnd.pc.c_gl33MergedDraws, backEnd.pc.c_gl33StateChanges,
+			backEnd.pc.c_gl33Uniforms, backEnd.pc.c_gl33UniformBytes / 1024,
+			backEnd.pc.c_gl33ShadowMapViews, backEnd.pc.c_gl33ShadowMapDraws );
 	}
 	if ( r_showLightScale.GetBool() ) {
 		common->Printf( "lightScale: %f\n", backEnd.pc.maxLightValue );
 	}
 
+	R_BenchmarkFrame();
+
 	memset( &tr.pc, 0, sizeof( tr.pc ) );
 	memset( &backEnd.pc, 0, sizeof( backEnd.pc ) );
 }
 
 
 
+/*
+===============================================================================
+
+	Render thread
+
+	With r_useRenderThread the back end runs on a thread of its own that owns
+	the main GL context.  The front end issues the commands of a frame and
+	goes on with the next one while they are executed, which is why there are
+	two sets of frame data and vertex cache temp space.  The front end keeps a
+	context that shares objects with the main one for its buffer and texture
+	uploads, and the back end waits on a fence for them before it draws.
+
+	The back end must not use the heap or the file system while it runs on
+	the render thread, so it is only started when all images are loaded by
+	the front end.  Streamed image levels are uploaded by the front end at
+	the end of the frame, while the back end is idle.
+
+===============================================================================
+*/
+
+typedef struct {
+	const emptyCommand_t *	cmds;
+	GLsync					uploadFence;	// front end uploads the commands depend on
+	int						vertexFrame;	// vertex cache temp space the commands draw from
+} renderThreadCommands_t;
+
+/*
+====================
+RB_RenderThread
+====================
+*/
+static void RB_RenderThread( void ) {
+	while( 1 ) {
+		const renderThreadCommands_t *rtc = (const renderThreadCommands_t *)GLimp_BackEndSleep();
+		if ( !rtc ) {
+			// R_ShutdownRenderThread
+			break;
+		}
+
+		glWaitSync( rtc->uploadFence, 0, GL_TIMEOUT_IGNORED );
+		glDeleteSync( rtc->uploadFence );
+
+		RB_ExecuteBackEndCommands( rtc->cmds );
+
+		vertexCache.FenceFrame( rtc->vertexFrame );
+	}
+
+	Mem_ReleaseThreadCache();
+}
+
+/*
+====================
+R_InitRenderThread
+
+Called at the end of R_InitOpenGL, the back end runs serially if the
+render thread can't be used
+====================
+*/
+void R_InitRenderThread( void ) {
+	tr.renderThreadActive = false;
+
+	if ( !r_useRenderThread.GetBool() ) {
+		return;
+	}
+
+	// the back end would load images on demand
+	if ( !globalImages->image_preload.GetBool() ) {
+		common->Printf( "render thread disabled by image_preload 0\n" );
+		return;
+	}
+
+	if ( !GLimp_SpawnRenderThread( RB_RenderThread ) ) {
+		common->Printf( "render thread not available, running the back end serially\n" );
+		return;
+	}
+
+	common->Printf( "running the back end on the render thread\n" );
+	tr.renderThreadActive = true;
+}
+
+/*
+====================
+R_ShutdownRenderThread
+
+The main context is current on the calling thread again afterwards
+====================
+*/
+void R_ShutdownRenderThread( void ) {
+	if ( !tr.renderThreadActive ) {
+		return;
+	}
+
+	R_SyncRenderThread();
+
+	GLimp_WakeBackEnd( NULL );
+	GLimp_ShutdownRenderThread();
+
+	tr.renderThreadActive = false;
+}
+
+/*
+====================
+R_SyncRenderThread
+
+Waits until the render thread has executed all issued commands.
+Anything that reads back what was drawn, or changes or deletes GL
+objects the back end may be using, has to call this first.
+====================
+*/
+void R_SyncRenderThread( void ) {
+	if ( !tr.renderThreadActive ) {
+		return;
+	}
+
+	GLimp_FrontEndSleep();
+}
+
+/*
+====================
+R_WakeRenderThread
+====================
+*/
+static void R_WakeRenderThread( const emptyCommand_t *cmds ) {
+	R_SyncRenderThread();
+
+	renderThreadCommands_t *rtc = (renderThreadCommands_t *)R_FrameAlloc( sizeof( *rtc ) );
+	rtc->cmds = cmds;
+	rtc->vertexFrame = vertexCache.GetFrameIndex();
+
+	// make the uploads of the front end context visible to the back end
+	rtc->uploadFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	glFlush();
+
+	GLimp_WakeBackEnd( rtc );
+
+	// locked surfaces keep on using the frame data of this frame
+	if ( r_lockSurfaces.GetBool() ) {
+		R_SyncRenderThread();
+	}
+}
+
 /*
 ====================
 R_IssueRenderCommands
@@ -141,8 +304,19 @@ static void R_IssueRenderCommands( void ) {
 
 	// r_skipRender is usually more usefull, because it will still
 	// draw 2D graphics
-	if ( !r_skipBackEnd.GetBool() ) {
-		RB_ExecuteBackEndCommands( frameData->cmdHead );
+
+	// the null driver has no back end at all
+	if ( !r_skipBackEnd.GetBool() && !tr.nullDriver ) {
+		// static vertexes can only be moved while the back end is idle
+		R_SyncRenderThread();
+		vertexCache.Defragment();
+
+		if ( tr.renderThreadActive ) {
+			R_WakeRenderThread( frameData->cmdHead );
+		} else {
+			RB_ExecuteBackEndCommands( frameData->cmdHead );
+			vertexCache.FenceFrame( vertexCache.GetFrameIndex() );
+		}
 	}
 
 	R_ClearCommandChain();
@@ -219,6 +393,7 @@ void	R_AddDrawViewCmd( viewDef_t *parms ) {
 	}
 
 	tr.pc.c_numViews++;
+	tr.pc.c_drawSurfs += parms->numDrawSurfs;
 
 	R_ViewStatistics( parms );
 }
@@ -279,6 +454,14 @@ static void R_CheckCvars( void ) {
 		R_SetColorMappings();
 	}
 
+	// drop the shadow volumes that were cached before the cache was disabled
+	if ( r_useShadowCache.IsModified() ) {
+		r_useShadowCache.ClearModified();
+		if ( !r_useShadowCache.GetBool() ) {
+			R_PurgeShadowCache();
+		}
+	}
+
 	// check for changes to logging state
 	GLimp_EnableLogging( r_logFile.GetInteger() != 0 );
 }
@@ -602,13 +785,16 @@ BeginFrame
 void idRenderSystemLocal::BeginFrame( int windowWidth, int windowHeight ) {
 	setBufferCommand_t	*cmd;
 
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 
 	// determine which back end we will use
 	SetBackEndRenderer();
 
+	// lights switching between shadow maps and shadow volumes need new interactions
+	R_CheckShadowMapMode();
+
 	guiModel->Clear();
 
 	// for the larger-than-window tiled rendering screenshots
@@ -683,10 +869,14 @@ Returns the number of msec spent in the back end
 void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	emptyCommand_t *cmd;
 
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 
+	// the back end of the last frame has to be done before its counters are
+	// read, and before cvar changes affect GL objects it may be using
+	R_SyncRenderThread();
+
 	// close any gui drawing
 	guiModel->EmitFullScreen();
 	guiModel->Clear();
@@ -706,7 +896,15 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	R_CheckCvars();
 
     // check for errors
-	GL_CheckErrors();
+	if ( !tr.nullDriver ) {
+		GL_CheckErrors();
+	}
+
+	// stream image levels while the back end is idle, before the
+	// upload fence of the frame
+	if ( !tr.nullDriver ) {
+		globalImages->UpdateStreamedImages();
+	}
 
 	// add the swapbuffers command
 	cmd = (emptyCommand_t *)R_GetCommandBuffer( sizeof( *cmd ) );
@@ -719,7 +917,8 @@ void idRenderSystemLocal::EndFrame( int *frontEndMsec, int *backEndMsec ) {
 	// may still be rendering into the current buffers
 	R_ToggleSmpFrame();
 
-	// we can now release the vertexes used this frame
+	// we can now release the vertexes used in the frame before,
+	// the back end may still be drawing the ones of this frame
 	vertexCache.EndFrame();
 
 	if ( session->writeDemo ) {
@@ -775,7 +974,7 @@ down, but still valid.
 ================
 */
 void	idRenderSystemLocal::CropRenderSize( int width, int height, bool makePowerOfTwo, bool forceDimensions ) {
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 
@@ -855,7 +1054,7 @@ UnCrop
 ================
 */
 void idRenderSystemLocal::UnCrop() {
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 
@@ -885,7 +1084,7 @@ CaptureRenderToImage
 ================
 */
 void idRenderSystemLocal::CaptureRenderToImage( const char *imageName ) {
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 	guiModel->EmitFullScreen();
@@ -934,6 +1133,7 @@ void idRenderSystemLocal::CaptureRenderToFile( const char *fileName, bool fixAlp
 	guiModel->EmitFullScreen();
 	guiModel->Clear();
 	R_IssueRenderCommands();
+	R_SyncRenderThread();
 
 	glReadBuffer( GL_BACK );
 
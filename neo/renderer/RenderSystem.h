@@ -76,6 +76,9 @@ typedef struct glconfig_s {
 	bool				twoSidedStencilAvailable;
 	bool				textureNonPowerOfTwoAvailable;
 	bool				depthBoundsTestAvailable;
+	bool				bufferStorageAvailable;
+	bool				programBinaryAvailable;
+	bool				parallelShaderCompileAvailable;
 
     // GL33
     bool                glslShadersAvailable;
@@ -40,6 +40,14 @@ If you have questions concerning this license or the applicable additional terms
 
 glconfig_t	glConfig;
 
+qglBufferStorageProc_t	qglBufferStorage;
+qglGetProgramBinaryProc_t	qglGetProgramBinary;
+qglProgramBinaryProc_t		qglProgramBinary;
+qglProgramParameteriProc_t	qglProgramParameteri;
+qglMaxShaderCompilerThreadsProc_t qglMaxShaderCompilerThreads;
+
+void *		GLimp_ExtensionPointer( const char *name );
+
 static void GfxInfo_f( void );
 
 const char *r_rendererArgs[] = { "best", "arb2", "gl33", NULL };
@@ -60,17 +68,23 @@ idCVar r_useConstantMaterials( "r_useConstantMaterials", "1", CVAR_RENDERER | CV
 idCVar r_useTripleTextureARB( "r_useTripleTextureARB", "1", CVAR_RENDERER | CVAR_BOOL, "cards with 3+ texture units do a two pass instead of three pass" );
 idCVar r_useSilRemap( "r_useSilRemap", "1", CVAR_RENDERER | CVAR_BOOL, "consider verts with the same XYZ, but different ST the same for shadows" );
 idCVar r_useNodeCommonChildren( "r_useNodeCommonChildren", "1", CVAR_RENDERER | CVAR_BOOL, "stop pushing reference bounds early when possible" );
+idCVar r_useShadowCache( "r_useShadowCache", "1", CVAR_RENDERER | CVAR_BOOL, "1 = keep turbo shadow volumes for interactions that are created again" );
+idCVar r_shadowCacheSize( "r_shadowCacheSize", "16", CVAR_RENDERER | CVAR_INTEGER, "megabytes of turbo shadow volumes kept in the cache, volumes in use are never evicted", 0, 256 );
 idCVar r_useShadowProjectedCull( "r_useShadowProjectedCull", "1", CVAR_RENDERER | CVAR_BOOL, "discard triangles outside light volume before shadowing" );
 idCVar r_useShadowVertexProgram( "r_useShadowVertexProgram", "1", CVAR_RENDERER | CVAR_BOOL, "do the shadow projection in the vertex program on capable cards" );
 idCVar r_useShadowSurfaceScissor( "r_useShadowSurfaceScissor", "1", CVAR_RENDERER | CVAR_BOOL, "scissor shadows by the scissor rect of the interaction surfaces" );
 idCVar r_useInteractionTable( "r_useInteractionTable", "1", CVAR_RENDERER | CVAR_BOOL, "create a full entityDefs * lightDefs table to make finding interactions faster" );
+idCVar r_useInteractionBatching( "r_useInteractionBatching", "1", CVAR_RENDERER | CVAR_BOOL, "sort the GL 3.3 interactions of a light by state and merge draws with the same parameters, 0 = draw them in order" );
 idCVar r_useTurboShadow( "r_useTurboShadow", "1", CVAR_RENDERER | CVAR_BOOL, "use the infinite projection with W technique for dynamic shadows" );
 idCVar r_useTwoSidedStencil( "r_useTwoSidedStencil", "1", CVAR_RENDERER | CVAR_BOOL, "do stencil shadows in one pass with different ops on each side" );
 idCVar r_useDeferredTangents( "r_useDeferredTangents", "1", CVAR_RENDERER | CVAR_BOOL, "defer tangents calculations after deform" );
+idCVar r_useGPUSkinning( "r_useGPUSkinning", "1", CVAR_RENDERER | CVAR_BOOL, "transform MD5 models with up to 4 weights per vertex in the GL 3.3 vertex shaders, the CPU still transforms them for culling and shadows" );
 idCVar r_useCachedDynamicModels( "r_useCachedDynamicModels", "1", CVAR_RENDERER | CVAR_BOOL, "cache snapshots of dynamic models" );
 
 idCVar r_useVertexBuffers( "r_useVertexBuffers", "1", CVAR_RENDERER | CVAR_INTEGER, "use ARB_vertex_buffer_object for vertexes", 0, 1, idCmdSystem::ArgCompletion_Integer<0,1>  );
 idCVar r_useIndexBuffers( "r_useIndexBuffers", "0", CVAR_RENDERER | CVAR_ARCHIVE | CVAR_INTEGER, "use ARB_vertex_buffer_object for indexes", 0, 1, idCmdSystem::ArgCompletion_Integer<0,1>  );
+idCVar r_usePersistentMapping( "r_usePersistentMapping", "1", CVAR_RENDERER | CVAR_BOOL, "write frame temp vertexes to a persistently mapped ring buffer, takes effect on vid_restart" );
+idCVar r_useProgramBinaryCache( "r_useProgramBinaryCache", "1", CVAR_RENDERER | CVAR_BOOL, "load linked GLSL programs from glprogs/cache when the driver and source match" );
 
 idCVar r_useStateCaching( "r_useStateCaching", "1", CVAR_RENDERER | CVAR_BOOL, "avoid redundant state changes in GL_*() calls" );
 idCVar r_useInfiniteFarZ( "r_useInfiniteFarZ", "1", CVAR_RENDERER | CVAR_BOOL, "use the no-far-clip-plane trick" );
@@ -122,6 +136,32 @@ idCVar r_useEntityCulling( "r_useEntityCulling", "1", CVAR_RENDERER | CVAR_BOOL,
 idCVar r_useEntityScissors( "r_useEntityScissors", "0", CVAR_RENDERER | CVAR_BOOL, "1 = use custom scissor rectangle for each entity" );
 idCVar r_useInteractionCulling( "r_useInteractionCulling", "1", CVAR_RENDERER | CVAR_BOOL, "1 = cull interactions" );
 idCVar r_useInteractionScissors( "r_useInteractionScissors", "2", CVAR_RENDERER | CVAR_INTEGER, "1 = use a custom scissor rectangle for each shadow interaction, 2 = also crop using portal scissors", -2, 2, idCmdSystem::ArgCompletion_Integer<-2,2> );
+idCVar r_useParallelFrontEnd( "r_useParallelFrontEnd", "1", CVAR_RENDERER | CVAR_BOOL, "1 = cull and evaluate lights, entities and interactions with parallel jobs" );
+idCVar r_useParallelShadows( "r_useParallelShadows", "1", CVAR_RENDERER | CVAR_BOOL, "1 = build the clipped shadow volumes of an interaction with parallel jobs" );
+idCVar r_useParallelDeforms( "r_useParallelDeforms", "1", CVAR_RENDERER | CVAR_BOOL, "1 = evaluate the deforms of the view surfaces with parallel jobs" );
+idCVar r_useAreaTrees( "r_useAreaTrees", "1", CVAR_RENDERER | CVAR_BOOL, "1 = query the bounds trees of the areas for entities and lights instead of walking the area lists" );
+idCVar r_areaRefMargin( "r_areaRefMargin", "16", CVAR_RENDERER | CVAR_FLOAT, "entity bounds are expanded by this before they are pushed into the areas, so entities moving less keep their area references", 0.0f, 256.0f );
+idCVar r_useOcclusionCulling( "r_useOcclusionCulling", "1", CVAR_RENDERER | CVAR_BOOL, "1 = cull view entities and lights that are behind the rasterized world occluders" );
+idCVar r_occlusionBufferWidth( "r_occlusionBufferWidth", "256", CVAR_RENDERER | CVAR_INTEGER, "width of the software occlusion depth buffer, the height follows the view aspect", 64, 1024 );
+idCVar r_occluderMinArea( "r_occluderMinArea", "512", CVAR_RENDERER | CVAR_FLOAT, "world triangles with a smaller area are not used as occluders", 0.0f, 65536.0f );
+idCVar r_showOcclusion( "r_showOcclusion", "0", CVAR_RENDERER | CVAR_INTEGER, "1 = print occlusion culling counts, 2 = also draw the bounds of the culled entities and lights", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
+idCVar r_usePortalCache( "r_usePortalCache", "1", CVAR_RENDERER | CVAR_BOOL, "1 = reuse the portal chains of the last views for views that only rotated or barely moved" );
+idCVar r_portalCacheDistance( "r_portalCacheDistance", "1", CVAR_RENDERER | CVAR_FLOAT, "views closer than this to the origin of a cached view flood reuse its portal chains, 0 = only the same origin", 0.0f, 64.0f );
+idCVar r_showPortalCache( "r_showPortalCache", "0", CVAR_RENDERER | CVAR_BOOL, "1 = print the number of flooded and reused portal chains" );
+idCVar r_nullDriver( "r_nullDriver", "0", CVAR_RENDERER | CVAR_BOOL | CVAR_INIT, "1 = run without a window or GL context and discard the back end commands, to benchmark the front end on machines without a GPU" );
+idCVar r_benchmarkLog( "r_benchmarkLog", "", CVAR_RENDERER, "file the front end stage times, drawSurf counts and memory of every frame are written to as comma separated values" );
+idCVar r_shadowMaps( "r_shadowMaps", "0", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "0 = shadow volumes, 1 = shadow maps for lights with shadowMap materials, 2 = shadow maps for all lights, GL 3.3 back end only", 0, 2, idCmdSystem::ArgCompletion_Integer<0,2> );
+idCVar r_shadowMapSize( "r_shadowMapSize", "1024", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "largest shadow map of a projected light, smaller lights on screen get smaller maps" );
+idCVar r_shadowMapMinSize( "r_shadowMapMinSize", "128", CVAR_RENDERER | CVAR_INTEGER, "smallest shadow map in the atlas" );
+idCVar r_shadowMapAtlasSize( "r_shadowMapAtlasSize", "4096", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "size of the shadow map atlas of the projected and parallel lights" );
+idCVar r_shadowMapCubeSize( "r_shadowMapCubeSize", "512", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "size of the shadow cube map faces of point lights" );
+idCVar r_shadowMapCascades( "r_shadowMapCascades", "3", CVAR_RENDERER | CVAR_INTEGER, "number of shadow map cascades of parallel lights", 1, 4, idCmdSystem::ArgCompletion_Integer<1,4> );
+idCVar r_shadowMapCascadeSize( "r_shadowMapCascadeSize", "1024", CVAR_RENDERER | CVAR_INTEGER, "size of each shadow map cascade" );
+idCVar r_shadowMapCascadeDistance( "r_shadowMapCascadeDistance", "4096", CVAR_RENDERER | CVAR_FLOAT, "view distance covered by the shadow map cascades" );
+idCVar r_shadowMapPolygonFactor( "r_shadowMapPolygonFactor", "2", CVAR_RENDERER | CVAR_FLOAT, "polygon offset factor when drawing shadow maps" );
+idCVar r_shadowMapPolygonOffset( "r_shadowMapPolygonOffset", "8", CVAR_RENDERER | CVAR_FLOAT, "polygon offset units when drawing shadow maps" );
+idCVar r_shadowMapFilter( "r_shadowMapFilter", "1", CVAR_RENDERER | CVAR_BOOL, "1 = four filtered shadow map samples instead of one" );
+idCVar r_useRenderThread( "r_useRenderThread", "1", CVAR_RENDERER | CVAR_BOOL | CVAR_ARCHIVE, "1 = run the back end on its own thread, one frame behind the front end, 0 = serial for debugging, takes effect on vid_restart" );
 idCVar r_useShadowCulling( "r_useShadowCulling", "1", CVAR_RENDERER | CVAR_BOOL, "try to cull shadows from partially visible lights" );
 idCVar r_useFrustumFarDistance( "r_useFrustumFarDistance", "0", CVAR_RENDERER | CVAR_FLOAT, "if != 0 force the view frustum far distance to this distance" );
 idCVar r_logFile( "r_logFile", "0", CVAR_RENDERER | CVAR_INTEGER, "number of frames to emit GL logs" );
@@ -188,11 +228,14 @@ idCVar r_showTris( "r_showTris", "0", CVAR_RENDERER | CVAR_INTEGER, "enables wir
 idCVar r_showSurfaceInfo( "r_showSurfaceInfo", "0", CVAR_RENDERER | CVAR_BOOL, "show surface material name under crosshair" );
 idCVar r_showNormals( "r_showNormals", "0", CVAR_RENDERER | CVAR_FLOAT, "draws wireframe normals" );
 idCVar r_showMemory( "r_showMemory", "0", CVAR_RENDERER | CVAR_BOOL, "print frame memory utilization" );
+idCVar r_frameMemoryMB( "r_frameMemoryMB", "64", CVAR_RENDERER | CVAR_INTEGER | CVAR_ARCHIVE, "size of the address range reserved for frame temporary memory, takes effect on vid_restart", 8, 1024 );
+idCVar r_poisonFrameMemory( "r_poisonFrameMemory", "0", CVAR_RENDERER | CVAR_BOOL, "fill frame memory with garbage when it is reset, to find stale and uninitialized frame data" );
 idCVar r_showCull( "r_showCull", "0", CVAR_RENDERER | CVAR_BOOL, "report sphere and box culling stats" );
 idCVar r_showInteractions( "r_showInteractions", "0", CVAR_RENDERER | CVAR_BOOL, "report interaction generation activity" );
 idCVar r_showDepth( "r_showDepth", "0", CVAR_RENDERER | CVAR_BOOL, "display the contents of the depth buffer and the depth range" );
 idCVar r_showSurfaces( "r_showSurfaces", "0", CVAR_RENDERER | CVAR_BOOL, "report surface/light/shadow counts" );
 idCVar r_showPrimitives( "r_showPrimitives", "0", CVAR_RENDERER | CVAR_INTEGER, "report drawsurf/index/vertex counts" );
+idCVar r_showBatches( "r_showBatches", "0", CVAR_RENDERER | CVAR_BOOL, "report draws, state changes and uniform uploads of the GL 3.3 back end" );
 idCVar r_showEdges( "r_showEdges", "0", CVAR_RENDERER | CVAR_BOOL, "draw the sil edges" );
 idCVar r_showTexturePolarity( "r_showTexturePolarity", "0", CVAR_RENDERER | CVAR_BOOL, "shade triangles by texture area polarity" );
 idCVar r_showTangentSpace( "r_showTangentSpace", "0", CVAR_RENDERER | CVAR_INTEGER, "shade triangles by tangent space, 1 = use 1st tangent vector, 2 = use 2nd tangent vector, 3 = use normal vector", 0, 3, idCmdSystem::ArgCompletion_Integer<0,3> );
@@ -305,6 +348,39 @@ static void R_CheckPortableExtensions( void ) {
 
     glConfig.glslShadersAvailable = true;
 
+	// GL_ARB_buffer_storage
+	glConfig.bufferStorageAvailable = false;
+	qglBufferStorage = NULL;
+	if ( R_CheckExtension( "GL_ARB_buffer_storage" ) ) {
+		qglBufferStorage = (qglBufferStorageProc_t)GLimp_ExtensionPointer( "glBufferStorage" );
+		glConfig.bufferStorageAvailable = ( qglBufferStorage != NULL );
+	}
+
+	// GL_ARB_get_program_binary
+	glConfig.programBinaryAvailable = false;
+	qglGetProgramBinary = NULL;
+	qglProgramBinary = NULL;
+	qglProgramParameteri = NULL;
+	if ( R_CheckExtension( "GL_ARB_get_program_binary" ) ) {
+		GLint numFormats = 0;
+		glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats );
+		qglGetProgramBinary = (qglGetProgramBinaryProc_t)GLimp_ExtensionPointer( "glGetProgramBinary" );
+		qglProgramBinary = (qglProgramBinaryProc_t)GLimp_ExtensionPointer( "glProgramBinary" );
+		qglProgramParameteri = (qglProgramParameteriProc_t)GLimp_ExtensionPointer( "glProgramParameteri" );
+		// some drivers expose the extension without any format to save in
+		glConfig.programBinaryAvailable = ( numFormats > 0 && qglGetProgramBinary && qglProgramBinary && qglProgramParameteri );
+	}
+
+	// GL_KHR_parallel_shader_compile, or the ARB version with the same enums
+	glConfig.parallelShaderCompileAvailable = false;
+	qglMaxShaderCompilerThreads = NULL;
+	if ( R_CheckExtension( "GL_KHR_parallel_shader_compile" ) ) {
+		qglMaxShaderCompilerThreads = (qglMaxShaderCompilerThreadsProc_t)GLimp_ExtensionPointer( "glMaxShaderCompilerThreadsKHR" );
+	} else if ( R_CheckExtension( "GL_ARB_parallel_shader_compile" ) ) {
+		qglMaxShaderCompilerThreads = (qglMaxShaderCompilerThreadsProc_t)GLimp_ExtensionPointer( "glMaxShaderCompilerThreadsARB" );
+	}
+	glConfig.parallelShaderCompileAvailable = ( qglMaxShaderCompilerThreads != NULL );
+
     //#NOTE_SK: always trying to get this function
     // Debugging
     if(GLAD_GL_ARB_debug_output) {
@@ -496,6 +572,9 @@ void R_InitOpenGL( void ) {
 	// Reset our gamma
 	R_SetColorMappings();
 
+	// hand the main context over to the render thread if it is used
+	R_InitRenderThread();
+
 #ifdef _WIN32
 	static bool glCheck = false;
 	if ( !glCheck && win32.osversion.dwMajorVersion == 6 ) {
@@ -519,6 +598,44 @@ void R_InitOpenGL( void ) {
 #endif
 }
 
+/*
+==================
+R_InitNullDriver
+
+r_nullDriver runs the renderer without a window or GL context.
+glConfig.isInitialized stays false, so nothing will touch GL, but the
+views are processed and the back end commands are discarded.
+==================
+*/
+static void R_InitNullDriver( void ) {
+	common->Printf( "----- R_InitNullDriver -----\n" );
+
+	tr.viewportOffset[0] = 0;
+	tr.viewportOffset[1] = 0;
+
+	R_GetModeInfo( &glConfig.vidWidth, &glConfig.vidHeight, r_mode.GetInteger() );
+
+	glConfig.vendor_string = "";
+	glConfig.renderer_string = "null driver";
+	glConfig.version_string = "";
+	glConfig.extensions_string = "";
+	glConfig.maxTextureSize = 4096;
+
+	// select the formats of a real card, images are compressed on the CPU
+	// when the null driver is used to write precompressed images
+	glConfig.textureCompressionAvailable = true;
+
+	tr.nullDriver = true;
+
+	// without vertex buffer objects everything is kept in system memory
+	vertexCache.Init();
+
+	r_renderer.SetModified();
+	tr.SetBackEndRenderer();
+
+	R_InitFrameData();
+}
+
 /*
 ==================
 GL_CheckErrors
@@ -767,10 +884,6 @@ void R_ReportImageDuplication_f( const idCmdArgs &args ) {
 	for ( i = 0 ; i < globalImages->images.Num() ; i++ ) {
 		idImage	*image1 = globalImages->images[i];
 
-		if ( image1->isPartialImage ) {
-			// ignore background loading stubs
-			continue;
-		}
 		if ( image1->generatorFunction ) {
 			// ignore procedural images
 			continue;
@@ -790,9 +903,6 @@ void R_ReportImageDuplication_f( const idCmdArgs &args ) {
 		for ( j = 0 ; j < i ; j++ ) {
 			idImage	*image2 = globalImages->images[j];
 
-			if ( image2->isPartialImage ) {
-				continue;
-			}
 			if ( image2->generatorFunction ) {
 				continue;
 			}
@@ -964,6 +1074,7 @@ void R_ReadTiledPixels( int width, int height, byte *buffer, renderView_t *ref =
 			} else {
 				session->UpdateScreen();
 			}
+			R_SyncRenderThread();
 
 			int w = oldWidth;
 			if ( xo + w > width ) {
@@ -1628,6 +1739,9 @@ void R_VidRestart_f( const idCmdArgs &args ) {
 	// this could take a while, so give them the cursor back ASAP
 	Sys_GrabMouseCursor( false );
 
+	// nothing may be freed while the back end is using it
+	R_SyncRenderThread();
+
 	// dump ambient caches
 	renderModelManager->FreeModelVertexCaches();
 
@@ -1649,6 +1763,7 @@ void R_VidRestart_f( const idCmdArgs &args ) {
 		Sys_ShutdownInput();
 		globalImages->PurgeAllImages();
 		// free the context and close the window
+		R_ShutdownRenderThread();
 		GLimp_Shutdown();
 		glConfig.isInitialized = false;
 
@@ -1788,6 +1903,9 @@ void R_InitCommands( void ) {
 	cmdSystem->AddCommand( "envshot", R_EnvShot_f, CMD_FL_RENDERER, "takes an environment shot" );
 	cmdSystem->AddCommand( "makeAmbientMap", R_MakeAmbientMap_f, CMD_FL_RENDERER|CMD_FL_CHEAT, "makes an ambient map" );
 	cmdSystem->AddCommand( "benchmark", R_Benchmark_f, CMD_FL_RENDERER, "benchmark" );
+	cmdSystem->AddCommand( "writeOcclusionBuffer", R_WriteOcclusionBuffer_f, CMD_FL_RENDERER | CMD_FL_CHEAT, "writes the software occlusion depth buffer of the last view to a targa file" );
+	cmdSystem->AddCommand( "benchmarkAreaRefs", R_BenchmarkAreaRefs_f, CMD_FL_RENDERER | CMD_FL_CHEAT, "moves temporary entities through the map and reports the cost of the area references" );
+	cmdSystem->AddCommand( "benchmarkShadows", R_BenchmarkShadows_f, CMD_FL_RENDERER, "regenerates the shadow volumes of the map and reports the throughput" );
 	cmdSystem->AddCommand( "gfxInfo", GfxInfo_f, CMD_FL_RENDERER, "show graphics info" );
 	cmdSystem->AddCommand( "modulateLights", R_ModulateLights_f, CMD_FL_RENDERER | CMD_FL_CHEAT, "modifies shader parms on all lights" );
 	cmdSystem->AddCommand( "testImage", R_TestImage_f, CMD_FL_RENDERER | CMD_FL_CHEAT, "displays the given image centered on screen", idCmdSystem::ArgCompletion_ImageName );
@@ -1796,6 +1914,7 @@ void R_InitCommands( void ) {
 	cmdSystem->AddCommand( "reportImageDuplication", R_ReportImageDuplication_f, CMD_FL_RENDERER, "checks all referenced images for duplications" );
 	cmdSystem->AddCommand( "regenerateWorld", R_RegenerateWorld_f, CMD_FL_RENDERER, "regenerates all interactions" );
 	cmdSystem->AddCommand( "showInteractionMemory", R_ShowInteractionMemory_f, CMD_FL_RENDERER, "shows memory used by interactions" );
+	cmdSystem->AddCommand( "showShadowCache", R_ShowShadowCache_f, CMD_FL_RENDERER, "shows the turbo shadow volume cache" );
 	cmdSystem->AddCommand( "showTriSurfMemory", R_ShowTriSurfMemory_f, CMD_FL_RENDERER, "shows memory used by triangle surfaces" );
 	cmdSystem->AddCommand( "vid_restart", R_VidRestart_f, CMD_FL_RENDERER, "restarts renderSystem" );
 	cmdSystem->AddCommand( "listRenderEntityDefs", R_ListRenderEntityDefs_f, CMD_FL_RENDERER, "lists the entity defs" );
@@ -1843,6 +1962,12 @@ void idRenderSystemLocal::Clear( void ) {
 	guiRecursionLevel = 0;
 	guiModel = NULL;
 	demoGuiModel = NULL;
+	frontEndJobs = NULL;
+	shadowVolumeJobs = NULL;
+	shadowMapMode = 0;
+	renderThreadActive = false;
+	smpFrame = 0;
+	nullDriver = false;
 	memset( gammaTable, 0, sizeof( gammaTable ) );
 	takingScreenshot = false;
 }
@@ -1878,6 +2003,9 @@ void idRenderSystemLocal::Init( void ) {
 	demoGuiModel = new idGuiModel;
 	demoGuiModel->Clear();
 
+	frontEndJobs = parallelJobManager->AllocJobList( "R_FrontEnd" );
+	shadowVolumeJobs = parallelJobManager->AllocJobList( "R_ShadowVolumes" );
+
 	R_InitTriSurfData();
 
 	globalImages->Init();
@@ -1912,6 +2040,9 @@ idRenderSystemLocal::Shutdown
 void idRenderSystemLocal::Shutdown( void ) {	
 	common->Printf( "idRenderSystem::Shutdown()\n" );
 
+	// the main context is needed on this thread for the rest of the shutdown
+	R_ShutdownRenderThread();
+
 	R_DoneFreeType( );
 
 	if ( glConfig.isInitialized ) {
@@ -1931,6 +2062,9 @@ void idRenderSystemLocal::Shutdown( void ) {
 		logFile = 0;
 	}
 
+	// the cached shadows are freed with the deferred triangle surfaces
+	R_PurgeShadowCache();
+
 	// free frame memory
 	R_ShutdownFrameData();
 
@@ -1939,6 +2073,12 @@ void idRenderSystemLocal::Shutdown( void ) {
 
 	R_ShutdownTriSurfData();
 
+	R_ShutdownShadowVolumes();
+
+	R_ShutdownOcclusion();
+
+	R_ShutdownBenchmark();
+
 #ifndef DISABLE_RENDER_DEBUG_TOOLS
 	RB_ShutdownDebugTools();
 #endif // DISABLE_RENDER_DEBUG_TOOLS
@@ -1946,6 +2086,9 @@ void idRenderSystemLocal::Shutdown( void ) {
 	delete guiModel;
 	delete demoGuiModel;
 
+	parallelJobManager->FreeJobList( frontEndJobs );
+	parallelJobManager->FreeJobList( shadowVolumeJobs );
+
 	Clear();
 
 	ShutdownOpenGL();
@@ -1957,8 +2100,11 @@ idRenderSystemLocal::BeginLevelLoad
 ========================
 */
 void idRenderSystemLocal::BeginLevelLoad( void ) {
+	R_SyncRenderThread();
+
 	renderModelManager->BeginLevelLoad();
 	globalImages->BeginLevelLoad();
+	vertexCache.BeginLevelLoad();
 }
 
 /*
@@ -1967,8 +2113,11 @@ idRenderSystemLocal::EndLevelLoad
 ========================
 */
 void idRenderSystemLocal::EndLevelLoad( void ) {
+	R_SyncRenderThread();
+
 	renderModelManager->EndLevelLoad();
 	globalImages->EndLevelLoad();
+	vertexCache.EndLevelLoad();
 	if ( r_forceLoadImages.GetBool() ) {
 		RB_ShowImages();
 	}
@@ -1980,6 +2129,13 @@ idRenderSystemLocal::InitOpenGL
 ========================
 */
 void idRenderSystemLocal::InitOpenGL( void ) {
+	if ( r_nullDriver.GetBool() ) {
+		if ( !tr.nullDriver ) {
+			R_InitNullDriver();
+		}
+		return;
+	}
+
 	// if OpenGL isn't started, start it now
 	if ( !glConfig.isInitialized ) {
 		int	err;
@@ -2002,9 +2158,11 @@ idRenderSystemLocal::ShutdownOpenGL
 */
 void idRenderSystemLocal::ShutdownOpenGL( void ) {
 	// free the context and close the window
+	R_ShutdownRenderThread();
 	R_ShutdownFrameData();
 	GLimp_Shutdown();
 	glConfig.isInitialized = false;
+	tr.nullDriver = false;
 }
 
 /*
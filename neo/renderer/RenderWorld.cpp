@@ -119,6 +119,145 @@ void R_ListRenderEntityDefs_f( const idCmdArgs &args ) {
 	common->Printf( "total active: %i\n", active );
 }
 
+/*
+===================
+R_BenchmarkAreaRefs_f
+
+Adds temporary entities at random places in the areas of the primary world and
+moves them for a number of frames, without and with r_areaRefMargin.  Then finds
+the entities in the areas of every light, without and with r_useAreaTrees.
+===================
+*/
+void R_BenchmarkAreaRefs_f( const idCmdArgs &args ) {
+	idRenderWorldLocal *	rw;
+	idRandom				random;
+	idList<qhandle_t>		handles;
+	idList<idVec3>			origins;
+	idList<idVec3>			velocities;
+	idList<const idBounds *> areaBounds;
+	idList<areaReference_t *> refs;
+	renderEntity_t			re;
+	int						numEntities, numFrames;
+	int						numRefs[2], numFound[2];
+	double					msec[2], queryMsec[2];
+
+	rw = tr.primaryWorld;
+	if ( !rw ) {
+		common->Printf( "No primaryWorld.\n" );
+		return;
+	}
+
+	numEntities = 4096;
+	if ( args.Argc() > 1 ) {
+		numEntities = Max( 1, atoi( args.Argv( 1 ) ) );
+	}
+	numFrames = 32;
+	if ( args.Argc() > 2 ) {
+		numFrames = Max( 1, atoi( args.Argv( 2 ) ) );
+	}
+
+	// the world model entities give the bounds of the areas
+	for ( int i = 0 ; i < rw->numPortalAreas && i < rw->entityDefs.Num() ; i++ ) {
+		if ( rw->entityDefs[i] && !rw->entityDefs[i]->referenceBounds.IsCleared() ) {
+			areaBounds.Append( &rw->entityDefs[i]->referenceBounds );
+		}
+	}
+	if ( areaBounds.Num() == 0 ) {
+		common->Printf( "No area models.\n" );
+		return;
+	}
+
+	R_SyncRenderThread();
+
+	memset( &re, 0, sizeof( re ) );
+	re.hModel = renderModelManager->DefaultModel();
+	re.axis = mat3_identity;
+	re.shaderParms[SHADERPARM_RED] = 1.0f;
+	re.shaderParms[SHADERPARM_GREEN] = 1.0f;
+	re.shaderParms[SHADERPARM_BLUE] = 1.0f;
+	re.shaderParms[SHADERPARM_ALPHA] = 1.0f;
+
+	float areaRefMargin = r_areaRefMargin.GetFloat();
+	bool useAreaTrees = r_useAreaTrees.GetBool();
+
+	handles.SetNum( numEntities );
+	origins.SetNum( numEntities );
+	velocities.SetNum( numEntities );
+
+	for ( int pass = 0 ; pass < 2 ; pass++ ) {
+		r_areaRefMargin.SetFloat( pass == 0 ? 0.0f : ( areaRefMargin > 0.0f ? areaRefMargin : 16.0f ) );
+
+		// the same start positions and paths for both passes
+		random.SetSeed( 0 );
+		for ( int i = 0 ; i < numEntities ; i++ ) {
+			const idBounds &b = *areaBounds[random.RandomInt( areaBounds.Num() )];
+			for ( int j = 0 ; j < 3 ; j++ ) {
+				origins[i][j] = b[0][j] + random.RandomFloat() * ( b[1][j] - b[0][j] );
+				velocities[i][j] = random.CRandomFloat() * 8.0f;
+			}
+			re.origin = origins[i];
+			handles[i] = rw->AddEntityDef( &re );
+		}
+
+		int entityReferences = tr.pc.c_entityReferences;
+
+		idTimer timer;
+		timer.Start();
+		for ( int frame = 0 ; frame < numFrames ; frame++ ) {
+			for ( int i = 0 ; i < numEntities ; i++ ) {
+				// bounce back and forth along the path
+				if ( ( frame / 16 ) & 1 ) {
+					origins[i] -= velocities[i];
+				} else {
+					origins[i] += velocities[i];
+				}
+				re.origin = origins[i];
+				rw->UpdateEntityDef( handles[i], &re );
+			}
+		}
+		timer.Stop();
+
+		msec[pass] = timer.Milliseconds();
+		numRefs[pass] = tr.pc.c_entityReferences - entityReferences;
+
+		// find the entities of every light
+		r_useAreaTrees.SetBool( pass == 1 );
+
+		timer.Clear();
+		timer.Start();
+		numFound[pass] = 0;
+		for ( int i = 0 ; i < rw->lightDefs.Num() ; i++ ) {
+			const idRenderLightLocal *ldef = rw->lightDefs[i];
+			if ( !ldef ) {
+				continue;
+			}
+			for ( const areaReference_t *lref = ldef->references ; lref ; lref = lref->ownerNext ) {
+				refs.SetNum( lref->area->entityTree.NumProxies(), false );
+				numFound[pass] += rw->FindLightAreaEntityRefs( ldef, lref->area, refs.Ptr() );
+			}
+		}
+		timer.Stop();
+
+		queryMsec[pass] = timer.Milliseconds();
+
+		for ( int i = 0 ; i < numEntities ; i++ ) {
+			rw->FreeEntityDef( handles[i] );
+		}
+	}
+
+	r_areaRefMargin.SetFloat( areaRefMargin );
+	r_useAreaTrees.SetBool( useAreaTrees );
+
+	common->Printf( "%i entities moved for %i frames in %i areas\n", numEntities, numFrames, areaBounds.Num() );
+	common->Printf( "no margin:   %7.2f msec, %7.2f usec per update, %8i area refs created\n",
+					msec[0], msec[0] * 1000.0 / ( numEntities * numFrames ), numRefs[0] );
+	common->Printf( "margin %3.0f:  %7.2f msec, %7.2f usec per update, %8i area refs created\n",
+					r_areaRefMargin.GetFloat() > 0.0f ? r_areaRefMargin.GetFloat() : 16.0f,
+					msec[1], msec[1] * 1000.0 / ( numEntities * numFrames ), numRefs[1] );
+	common->Printf( "light lists: %7.2f msec, %8i entity refs\n", queryMsec[0], numFound[0] );
+	common->Printf( "light trees: %7.2f msec, %8i entity refs\n", queryMsec[1], numFound[1] );
+}
+
 /*
 ===================
 idRenderWorldLocal::idRenderWorldLocal
@@ -142,6 +281,8 @@ idRenderWorldLocal::idRenderWorldLocal() {
 	interactionTable = 0;
 	interactionTableWidth = 0;
 	interactionTableHeight = 0;
+
+	ClearViewFloods();
 }
 
 /*
@@ -256,10 +397,11 @@ void idRenderWorldLocal::UpdateEntityDef( qhandle_t entityHandle, const renderEn
 		}
 
 		// save any decals if the model is the same, allowing marks to move with entities
+		// the area references are kept if the new bounds are still inside them
 		if ( def->parms.hModel == re->hModel ) {
-			R_FreeEntityDefDerivedData( def, true, true );
+			R_FreeEntityDefDerivedData( def, true, true, true );
 		} else {
-			R_FreeEntityDefDerivedData( def, false, false );
+			R_FreeEntityDefDerivedData( def, false, false, true );
 		}
 	} else {
 		// creating a new one
@@ -312,7 +454,7 @@ void idRenderWorldLocal::FreeEntityDef( qhandle_t entityHandle ) {
 		return;
 	}
 
-	R_FreeEntityDefDerivedData( def, false, false );
+	R_FreeEntityDefDerivedData( def, false, false, false );
 
 	if ( session->writeDemo && def->archived ) {
 		WriteFreeEntity( entityHandle );
@@ -677,8 +819,9 @@ to handle mirrors,
 void idRenderWorldLocal::RenderScene( const renderView_t *renderView ) {
 #ifndef	ID_DEDICATED
 	renderView_t	copy;
+	idScopedMemTag	memTag( MEM_TAG_RENDERER );
 
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 
@@ -699,6 +842,7 @@ void idRenderWorldLocal::RenderScene( const renderView_t *renderView ) {
 	tr.guiModel->Clear();
 
 	int startTime = Sys_Milliseconds();
+	double startTicks = Sys_GetClockTicks();
 
 	// setup view parms for the initial view
 	//
@@ -779,6 +923,7 @@ void idRenderWorldLocal::RenderScene( const renderView_t *renderView ) {
 	int endTime = Sys_Milliseconds();
 
 	tr.pc.frontEndMsec += endTime - startTime;
+	R_StageTicks( tr.pc.frontEndTicks, startTicks );
 
 	// prepare for any 2D drawing after this
 	tr.guiModel->Clear();
@@ -1406,6 +1551,8 @@ void idRenderWorldLocal::AddEntityRefToArea( idRenderEntityLocal *def, portalAre
 	ref->areaPrev = area->entityRefs.areaPrev;
 	ref->areaNext->areaPrev = ref;
 	ref->areaPrev->areaNext = ref;
+
+	ref->treeProxy = area->entityTree.AddProxy( def->areaRefBounds, ref );
 }
 
 /*
@@ -1430,6 +1577,8 @@ void idRenderWorldLocal::AddLightRefToArea( idRenderLightLocal *light, portalAre
 	lref->areaNext = area->lightRefs.areaNext;
 	lref->areaPrev = &area->lightRefs;
 	area->lightRefs.areaNext = lref;
+
+	lref->treeProxy = area->lightTree.AddProxy( light->frustumTris->bounds, lref );
 }
 
 /*
@@ -1445,7 +1594,7 @@ use it as an oportunity to size the interactionTable
 ===================
 */
 void idRenderWorldLocal::GenerateAllInteractions() {
-	if ( !glConfig.isInitialized ) {
+	if ( !glConfig.isInitialized && !tr.nullDriver ) {
 		return;
 	}
 
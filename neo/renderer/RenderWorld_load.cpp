@@ -62,8 +62,15 @@ void idRenderWorldLocal::FreeWorld() {
 		if ( area->entityRefs.areaNext != &area->entityRefs ) {
 			common->Error( "FreeWorld: unexpected remaining entityRefs" );
 		}
+		area->entityTree.Clear();
+		area->lightTree.Clear();
+
+		R_FreeAreaOccluder( area->occluder );
+		area->occluder = NULL;
 	}
 
+	ClearViewFloods();
+
 	if ( portalAreas ) {
 		R_StaticFree( portalAreas );
 		portalAreas = NULL;
@@ -91,6 +98,7 @@ void idRenderWorldLocal::FreeWorld() {
 	localModels.Clear();
 
 	areaReferenceAllocator.Shutdown();
+	interactionStore.Clear();
 	interactionAllocator.Shutdown();
 	areaNumRefAllocator.Shutdown();
 
@@ -666,6 +674,7 @@ void idRenderWorldLocal::AddWorldModelEntities() {
 		def->parms.axis[2][2] = 1;
 
 		R_AxisToModelMatrix( def->parms.axis, def->parms.origin, def->modelMatrix );
+		def->areaRefBounds.FromTransformedBounds( def->referenceBounds, def->parms.origin, def->parms.axis );
 
 		// in case an explicit shader is used on the world, we don't
 		// want it to have a 0 alpha or color
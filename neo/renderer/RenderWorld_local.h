@@ -62,6 +62,9 @@ typedef struct portalArea_s {
 	portal_t *		portals;		// never changes after load
 	areaReference_t	entityRefs;		// head/tail of doubly linked list, may change
 	areaReference_t	lightRefs;		// head/tail of doubly linked list, may change
+	idBoundsTree	entityTree;		// areaRefBounds of the entityRefs, for frustum and bounds queries
+	idBoundsTree	lightTree;		// light bounds of the lightRefs
+	struct areaOccluder_s *	occluder;	// tagged occluder triangles of the area model, made when first needed
 } portalArea_t;
 
 
@@ -75,6 +78,43 @@ typedef struct {
 } areaNode_t;
 
 
+// a portal chain of a cached view flood, the chains are stored depth first
+typedef struct {
+	int						areaNum;
+	portal_t *				p;				// NULL for the area the view is in
+	int						firstPoint;		// winding of p clipped by the chain, but not by the view frustum
+	int						numPoints;		// 0 if the view was too close to p to clip it
+	int						skipNode;		// first node that doesn't continue this chain
+} viewFloodNode_t;
+
+const int MAX_VIEW_FLOODS		= 4;
+const int MAX_VIEW_FLOOD_NODES	= 8192;
+const int VIEW_FLOOD_STABLE_FRAMES	= 3;	// frames with views at an origin before its chains are flooded
+
+// the portal chains seen from a view origin in every direction, reused by the
+// views closer than r_portalCacheDistance to it, see FlowViewThroughPortals
+typedef struct {
+	int						areaNum;		// -1 if not used
+	idVec3					origin;
+	int						connectedAreaNum;	// the portal states have changed if it differs
+	int						lastUsedView;
+	int						lastUsedFrame;
+	int						numFrames;		// frames that had a view close to origin
+	bool					flooded;		// false while the origin is only a candidate
+	bool					overflowed;		// too many chains, the views at this origin flood without the cache
+	idList<viewFloodNode_t>	nodes;
+	idList<idVec3>			points;
+} viewFlood_t;
+
+
+// an entity that shares an area with a light, gathered by
+// idRenderWorldLocal::FindLightDefInteractions
+typedef struct {
+	idRenderEntityLocal *	entityDef;
+	idInteraction *			inter;				// NULL if there was no interaction yet
+} lightEntityRef_t;
+
+
 class idRenderWorldLocal : public idRenderWorld {
 public:
 							idRenderWorldLocal();
@@ -146,6 +186,8 @@ public:
 
 	idScreenRect *			areaScreenRect;
 
+	viewFlood_t				viewFloods[MAX_VIEW_FLOODS];
+
 	doublePortal_t *		doublePortals;
 	int						numInterAreaPortals;
 
@@ -167,6 +209,9 @@ public:
 	int						interactionTableWidth;		// entityDefs
 	int						interactionTableHeight;		// lightDefs
 
+	// the cull data of all interactions in flat arrays, see idInteractionStore
+	idInteractionStore		interactionStore;
+
 
 	bool					generateAllInteractionsCalled;
 
@@ -194,6 +239,10 @@ public:
 	bool					PortalIsFoggedOut( const portal_t *p );
 	void					FloodViewThroughArea_r( const idVec3 origin, int areaNum, const struct portalStack_s *ps );
 	void					FlowViewThroughPortals( const idVec3 origin, int numPlanes, const idPlane *planes );
+	void					ClearViewFloods( void );
+	viewFlood_t *			FindViewFlood( const idVec3 &origin, int areaNum, bool &reused );
+	bool					BuildViewFlood_r( viewFlood_t *flood, const idVec3 &origin, int areaNum, const idWinding *w, const struct portalStack_s *ps );
+	int						ReplayViewFlood_r( const viewFlood_t *flood, int nodeNum, const idVec3 &origin, int numPlanes, const idPlane *planes, const struct portalStack_s *ps );
 	void					FloodLightThroughArea_r( idRenderLightLocal *light, int areaNum, const struct portalStack_s *ps );
 	void					FlowLightThroughPortals( idRenderLightLocal *light );
 	areaNumRef_t *			FloodFrustumAreas_r( const idFrustum &frustum, const int areaNum, const idBounds &bounds, areaNumRef_t *areas );
@@ -257,6 +306,13 @@ public:
 	//-------------------------------
 	// tr_light.c
 	void					CreateLightDefInteractions( idRenderLightLocal *ldef );
+	int						FindLightAreaEntityRefs( const idRenderLightLocal *ldef, const portalArea_t *area, areaReference_t **refs ) const;
+	// the same split in a part that only reads and can run in front end jobs,
+	// and a part that creates the interactions on the main thread
+	int						FindLightDefInteractions( const idRenderLightLocal *ldef, lightEntityRef_t **refs ) const;
+	void					CreateLightDefInteractions( idRenderLightLocal *ldef, const lightEntityRef_t *refs, int numRefs );
+	void					CreateLightDefInteraction( idRenderLightLocal *ldef, idRenderEntityLocal *edef, idInteraction *inter );
+	idInteraction *			FindInteraction( const idRenderEntityLocal *edef, const idRenderLightLocal *ldef ) const;
 };
 
 #endif /* !__RENDERWORLDLOCAL_H__ */
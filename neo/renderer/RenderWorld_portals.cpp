@@ -166,6 +166,8 @@ void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNu
 	// cull models and lights to the current collection of planes
 	AddAreaRefs( areaNum, ps );
 
+	tr.pc.c_portalChainsFlooded++;
+
 	if ( areaScreenRect[areaNum].IsEmpty() ) {
 		areaScreenRect[areaNum] = ps->rect;
 	} else {
@@ -272,6 +274,338 @@ void idRenderWorldLocal::FloodViewThroughArea_r( const idVec3 origin, int areaNu
 	}
 }
 
+/*
+===================
+ClearViewFloods
+===================
+*/
+void idRenderWorldLocal::ClearViewFloods( void ) {
+	for ( int i = 0 ; i < MAX_VIEW_FLOODS ; i++ ) {
+		viewFloods[i].areaNum = -1;
+		viewFloods[i].lastUsedView = 0;
+		viewFloods[i].lastUsedFrame = 0;
+		viewFloods[i].numFrames = 0;
+		viewFloods[i].flooded = false;
+		viewFloods[i].overflowed = false;
+		viewFloods[i].nodes.Clear();
+		viewFloods[i].points.Clear();
+	}
+}
+
+/*
+===================
+BuildViewFlood_r
+
+Floods the portal chains the same way FloodViewThroughArea_r does, but without
+a view frustum, so the chains are valid for any view direction from the origin.
+Returns false if there are too many chains to cache.
+===================
+*/
+bool idRenderWorldLocal::BuildViewFlood_r( viewFlood_t *flood, const idVec3 &origin, int areaNum,
+								const idWinding *w, const struct portalStack_s *ps ) {
+	portal_t*		p;
+	float			d;
+	const portalStack_t	*check;
+	portalStack_t	newStack;
+	int				i, j;
+	idVec3			v1, v2;
+	int				addPlanes;
+	idFixedWinding	clipped;
+
+	if ( flood->nodes.Num() >= MAX_VIEW_FLOOD_NODES ) {
+		return false;
+	}
+
+	int nodeNum = flood->nodes.Num();
+	viewFloodNode_t &node = flood->nodes.Alloc();
+	node.areaNum = areaNum;
+	node.p = ps->p;
+	node.firstPoint = flood->points.Num();
+	node.numPoints = 0;
+	node.skipNode = 0;
+	if ( w ) {
+		node.numPoints = w->GetNumPoints();
+		for ( i = 0 ; i < w->GetNumPoints() ; i++ ) {
+			flood->points.Append( (*w)[i].ToVec3() );
+		}
+	}
+
+	tr.pc.c_portalChainsFlooded++;
+
+	// go through all the portals
+	for ( p = portalAreas[ areaNum ].portals; p; p = p->next ) {
+		// an enclosing door may have sealed the portal off
+		if ( p->doublePortal->blockingBits & PS_BLOCK_VIEW ) {
+			continue;
+		}
+
+		// make sure this portal is facing away from the view
+		d = p->plane.Distance( origin );
+		if ( d < -0.1f ) {
+			continue;
+		}
+
+		// make sure the portal isn't in our stack trace,
+		// which would cause an infinite loop
+		for ( check = ps; check; check = check->next ) {
+			if ( check->p == p ) {
+				break;		// don't recursively enter a stack
+			}
+		}
+		if ( check ) {
+			continue;	// already in stack
+		}
+
+		// if we are very close to the portal surface, don't bother clipping it
+		if ( d < 1.0f ) {
+			newStack = *ps;
+			newStack.p = p;
+			newStack.next = ps;
+			if ( !BuildViewFlood_r( flood, origin, p->intoArea, NULL, &newStack ) ) {
+				return false;
+			}
+			continue;
+		}
+
+		// clip the portal winding to all of the planes
+		clipped = *p->w;
+		for ( j = 0; j < ps->numPortalPlanes; j++ ) {
+			if ( !clipped.ClipInPlace( -ps->portalPlanes[j], 0 ) ) {
+				break;
+			}
+		}
+		if ( !clipped.GetNumPoints() ) {
+			continue;	// portal not visible
+		}
+
+		// fog depends on the view direction, it is checked when the chain is used
+
+		newStack.p = p;
+		newStack.next = ps;
+
+		addPlanes = clipped.GetNumPoints();
+		if ( addPlanes > MAX_PORTAL_PLANES ) {
+			addPlanes = MAX_PORTAL_PLANES;
+		}
+
+		newStack.numPortalPlanes = 0;
+		for ( i = 0; i < addPlanes; i++ ) {
+			j = i+1;
+			if ( j == clipped.GetNumPoints() ) {
+				j = 0;
+			}
+
+			v1 = origin - clipped[i].ToVec3();
+			v2 = origin - clipped[j].ToVec3();
+
+			newStack.portalPlanes[newStack.numPortalPlanes].Normal().Cross( v2, v1 );
+
+			// if it is degenerate, skip the plane
+			if ( newStack.portalPlanes[newStack.numPortalPlanes].Normalize() < 0.01f ) {
+				continue;
+			}
+			newStack.portalPlanes[newStack.numPortalPlanes].FitThroughPoint( origin );
+
+			newStack.numPortalPlanes++;
+		}
+
+		// the last stack plane is the portal plane
+		newStack.portalPlanes[newStack.numPortalPlanes] = p->plane;
+		newStack.numPortalPlanes++;
+
+		if ( !BuildViewFlood_r( flood, origin, p->intoArea, &clipped, &newStack ) ) {
+			return false;
+		}
+	}
+
+	flood->nodes[nodeNum].skipNode = flood->nodes.Num();
+
+	return true;
+}
+
+/*
+===================
+ReplayViewFlood_r
+
+Adds the area refs of a cached portal chain and everything seen through it.
+The cached portal winding is only clipped by the view planes, the rest of the
+chain has been clipped when the flood was built. Returns the number of chains used.
+===================
+*/
+int idRenderWorldLocal::ReplayViewFlood_r( const viewFlood_t *flood, int nodeNum, const idVec3 &origin,
+								int numPlanes, const idPlane *planes, const struct portalStack_s *ps ) {
+	const viewFloodNode_t *node = &flood->nodes[nodeNum];
+	portalStack_t	newStack;
+	int				i, j;
+	idVec3			v1, v2;
+	int				addPlanes;
+	idFixedWinding	w;
+	int				numChains = 1;
+
+	// cull models and lights to the current collection of planes
+	AddAreaRefs( node->areaNum, ps );
+
+	if ( areaScreenRect[node->areaNum].IsEmpty() ) {
+		areaScreenRect[node->areaNum] = ps->rect;
+	} else {
+		areaScreenRect[node->areaNum].Union( ps->rect );
+	}
+
+	for ( int childNum = nodeNum + 1 ; childNum < node->skipNode ; childNum = flood->nodes[childNum].skipNode ) {
+		const viewFloodNode_t *child = &flood->nodes[childNum];
+
+		if ( !child->numPoints ) {
+			// the view was very close to the portal surface
+			newStack = *ps;
+			newStack.p = child->p;
+			newStack.next = ps;
+			numChains += ReplayViewFlood_r( flood, childNum, origin, numPlanes, planes, &newStack );
+			continue;
+		}
+
+		// clip the cached winding to the view
+		w.Clear();
+		for ( i = 0 ; i < child->numPoints ; i++ ) {
+			w.AddPoint( flood->points[child->firstPoint + i] );
+		}
+		for ( j = 0; j < numPlanes; j++ ) {
+			if ( !w.ClipInPlace( -planes[j], 0 ) ) {
+				break;
+			}
+		}
+		if ( !w.GetNumPoints() ) {
+			continue;	// portal not visible, neither is anything behind it
+		}
+
+		// see if it is fogged out
+		if ( PortalIsFoggedOut( child->p ) ) {
+			continue;
+		}
+
+		newStack.p = child->p;
+		newStack.next = ps;
+
+		// find the screen pixel bounding box of the remaining portal
+		// so we can scissor things outside it
+		newStack.rect = ScreenRectFromWinding( &w, &tr.identitySpace );
+		
+		// slop might have spread it a pixel outside, so trim it back
+		newStack.rect.Intersect( ps->rect );
+
+		addPlanes = w.GetNumPoints();
+		if ( addPlanes > MAX_PORTAL_PLANES ) {
+			addPlanes = MAX_PORTAL_PLANES;
+		}
+
+		newStack.numPortalPlanes = 0;
+		for ( i = 0; i < addPlanes; i++ ) {
+			j = i+1;
+			if ( j == w.GetNumPoints() ) {
+				j = 0;
+			}
+
+			v1 = origin - w[i].ToVec3();
+			v2 = origin - w[j].ToVec3();
+
+			newStack.portalPlanes[newStack.numPortalPlanes].Normal().Cross( v2, v1 );
+
+			// if it is degenerate, skip the plane
+			if ( newStack.portalPlanes[newStack.numPortalPlanes].Normalize() < 0.01f ) {
+				continue;
+			}
+			newStack.portalPlanes[newStack.numPortalPlanes].FitThroughPoint( origin );
+
+			newStack.numPortalPlanes++;
+		}
+
+		// the last stack plane is the portal plane
+		newStack.portalPlanes[newStack.numPortalPlanes] = child->p->plane;
+		newStack.numPortalPlanes++;
+
+		numChains += ReplayViewFlood_r( flood, childNum, origin, numPlanes, planes, &newStack );
+	}
+
+	return numChains;
+}
+
+/*
+===================
+FindViewFlood
+
+Returns the cached portal chains for a view origin, NULL if there are none.
+Flooding in every direction costs more than a single frustum flood, so a new
+origin only becomes a candidate and its chains are flooded once views stayed
+close to it for VIEW_FLOOD_STABLE_FRAMES frames. A camera that keeps moving
+never pays for the cache.
+===================
+*/
+viewFlood_t *idRenderWorldLocal::FindViewFlood( const idVec3 &origin, int areaNum, bool &reused ) {
+	viewFlood_t		*flood;
+	portalStack_t	ps;
+	int				i;
+
+	float maxDist = r_portalCacheDistance.GetFloat();
+
+	reused = false;
+
+	for ( i = 0 ; i < MAX_VIEW_FLOODS ; i++ ) {
+		flood = &viewFloods[i];
+		if ( flood->areaNum != areaNum || flood->connectedAreaNum != connectedAreaNum ) {
+			continue;
+		}
+		if ( ( flood->origin - origin ).LengthSqr() > maxDist * maxDist ) {
+			continue;
+		}
+		flood->lastUsedView = tr.viewCount;
+		if ( flood->lastUsedFrame != tr.frameCount ) {
+			flood->lastUsedFrame = tr.frameCount;
+			flood->numFrames++;
+		}
+		if ( flood->flooded ) {
+			reused = true;
+			return flood;
+		}
+		if ( flood->overflowed || flood->numFrames < VIEW_FLOOD_STABLE_FRAMES ) {
+			return NULL;
+		}
+
+		flood->nodes.SetGranularity( 256 );
+		flood->nodes.SetNum( 0, false );
+		flood->points.SetGranularity( 1024 );
+		flood->points.SetNum( 0, false );
+
+		ps.next = NULL;
+		ps.p = NULL;
+		ps.numPortalPlanes = 0;
+
+		if ( !BuildViewFlood_r( flood, flood->origin, areaNum, NULL, &ps ) ) {
+			flood->overflowed = true;
+			return NULL;
+		}
+		flood->flooded = true;
+		return flood;
+	}
+
+	// replace the least recently used flood with a candidate
+	flood = &viewFloods[0];
+	for ( i = 1 ; i < MAX_VIEW_FLOODS ; i++ ) {
+		if ( viewFloods[i].lastUsedView < flood->lastUsedView ) {
+			flood = &viewFloods[i];
+		}
+	}
+
+	flood->areaNum = areaNum;
+	flood->origin = origin;
+	flood->connectedAreaNum = connectedAreaNum;
+	flood->lastUsedView = tr.viewCount;
+	flood->lastUsedFrame = tr.frameCount;
+	flood->numFrames = 1;
+	flood->flooded = false;
+	flood->overflowed = false;
+
+	return NULL;
+}
+
 /*
 =======================
 FlowViewThroughPortals
@@ -280,6 +614,11 @@ Finds viewLights and viewEntities by flowing from an origin through the visible
 origin point can see into.  The planes array defines a volume (positive
 sides facing in) that should contain the origin, such as a view frustum or a point light box.
 Zero planes assumes an unbounded volume.
+
+With r_usePortalCache the portal chains are flooded once for all view
+directions when the view origin stopped moving and reused by the following
+views from about the same origin, which only have to clip the last portal
+of each chain to their planes.
 =======================
 */
 void idRenderWorldLocal::FlowViewThroughPortals( const idVec3 origin, int numPlanes, const idPlane *planes ) {
@@ -312,6 +651,19 @@ void idRenderWorldLocal::FlowViewThroughPortals( const idVec3 origin, int numPla
 			areaScreenRect[i].Clear();
 		}
 
+		// reuse the portal chains of an earlier view
+		if ( r_usePortalCache.GetBool() ) {
+			bool reused;
+			const viewFlood_t *flood = FindViewFlood( origin, tr.viewDef->areaNum, reused );
+			if ( flood ) {
+				int numChains = ReplayViewFlood_r( flood, 0, origin, numPlanes, planes, &ps );
+				if ( reused ) {
+					tr.pc.c_portalChainsReused += numChains;
+				}
+				return;
+			}
+		}
+
 		// flood out through portals, setting area viewCount
 		FloodViewThroughArea_r( origin, tr.viewDef->areaNum, &ps );
 	}
@@ -589,16 +941,30 @@ have their scissor
 ===================
 */
 void idRenderWorldLocal::AddAreaEntityRefs( int areaNum, const portalStack_t *ps ) {
-	areaReference_t		*ref;
+	areaReference_t		*ref, **refs;
 	idRenderEntityLocal	*entity;
 	portalArea_t		*area;
 	viewEntity_t		*vEnt;
 	idBounds			b;
+	int					i, numRefs;
 
 	area = &portalAreas[ areaNum ];
 
-	for ( ref = area->entityRefs.areaNext ; ref != &area->entityRefs ; ref = ref->areaNext ) {
-		entity = ref->entity;
+	numRefs = area->entityTree.NumProxies();
+	refs = (areaReference_t **)_alloca16( numRefs * sizeof( refs[0] ) );
+
+	if ( r_useAreaTrees.GetBool() && r_useEntityCulling.GetBool() ) {
+		// only the entities with area bounds touching the portal planes
+		numRefs = area->entityTree.ProxiesTouchingPlanes( ps->portalPlanes, ps->numPortalPlanes, (void **)refs, numRefs );
+	} else {
+		numRefs = 0;
+		for ( ref = area->entityRefs.areaNext ; ref != &area->entityRefs ; ref = ref->areaNext ) {
+			refs[numRefs++] = ref;
+		}
+	}
+
+	for ( i = 0 ; i < numRefs ; i++ ) {
+		entity = refs[i]->entity;
 
 		// debug tool to allow viewing of only one entity at a time
 		if ( r_singleEntity.GetInteger() >= 0 && r_singleEntity.GetInteger() != entity->index ) {
@@ -704,7 +1070,7 @@ bool idRenderWorldLocal::CullLightByPortals( const idRenderLightLocal *light, co
 			}
 			if ( j == tri->numVerts ) {
 				// all points were outside one of the planes
-				tr.pc.c_box_cull_out++;
+				R_JobCounters().c_box_cull_out++;
 				return true;
 			}
 		}
@@ -721,15 +1087,29 @@ This is the only point where lights get added to the viewLights list
 ===================
 */
 void idRenderWorldLocal::AddAreaLightRefs( int areaNum, const portalStack_t *ps ) {
-	areaReference_t		*lref;
+	areaReference_t		*lref, **lrefs;
 	portalArea_t		*area;
 	idRenderLightLocal			*light;
 	viewLight_t			*vLight;
+	int					i, numRefs;
 
 	area = &portalAreas[ areaNum ];
 
-	for ( lref = area->lightRefs.areaNext ; lref != &area->lightRefs ; lref = lref->areaNext ) {
-		light = lref->light;
+	numRefs = area->lightTree.NumProxies();
+	lrefs = (areaReference_t **)_alloca16( numRefs * sizeof( lrefs[0] ) );
+
+	if ( r_useAreaTrees.GetBool() && r_useLightCulling.GetInteger() != 0 ) {
+		// only the lights with bounds touching the portal planes, without the near plane
+		numRefs = area->lightTree.ProxiesTouchingPlanes( ps->portalPlanes, ps->numPortalPlanes - 1, (void **)lrefs, numRefs );
+	} else {
+		numRefs = 0;
+		for ( lref = area->lightRefs.areaNext ; lref != &area->lightRefs ; lref = lref->areaNext ) {
+			lrefs[numRefs++] = lref;
+		}
+	}
+
+	for ( i = 0 ; i < numRefs ; i++ ) {
+		light = lrefs[i]->light;
 
 		// debug tool to allow viewing of only one light at a time
 		if ( r_singleLight.GetInteger() >= 0 && r_singleLight.GetInteger() != light->index ) {
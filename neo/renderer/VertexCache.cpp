@@ -33,10 +33,14 @@ If you have questions concerning this license or the applicable additional terms
 
 
 static const int	FRAME_MEMORY_BYTES = 0x200000;
+static const int	RING_MEMORY_BYTES = 0x800000;		// must be a power of two
 static const int	EXPAND_HEADERS = 1024;
+static const GLuint64	FRAME_FENCE_TIMEOUT = 1000000000;	// one second in nanoseconds
+static const float	DEFRAG_MAX_USAGE = 0.5f;			// only buffers used less than this are emptied
 
 idCVar idVertexCache::r_showVertexCache( "r_showVertexCache", "0", CVAR_INTEGER|CVAR_RENDERER, "" );
-idCVar idVertexCache::r_vertexBufferMegs( "r_vertexBufferMegs", "32", CVAR_INTEGER|CVAR_RENDERER, "" );
+idCVar idVertexCache::r_vertexBufferMegs( "r_vertexBufferMegs", "32", CVAR_INTEGER|CVAR_RENDERER, "size of the buffers static vertexes and indexes are sub-allocated from" );
+idCVar idVertexCache::r_vertexCacheDefragKB( "r_vertexCacheDefragKB", "256", CVAR_INTEGER|CVAR_RENDERER, "kilobytes of static vertex data moved per frame to empty sparsely used buffers, 0 = off" );
 
 idVertexCache		vertexCache;
 
@@ -70,16 +74,13 @@ void idVertexCache::ActuallyFree( vertCache_t *block ) {
 		staticAllocTotal -= block->size;
 		staticCountTotal--;
 
-		if ( block->vbo ) {
-#if 0		// this isn't really necessary, it will be reused soon enough
-			// filling with zero length data is the equivalent of freeing
-			glBindBuffer(GL_ARRAY_BUFFER, block->vbo);
-			qglBufferDataARB(GL_ARRAY_BUFFER, 0, 0, GL_DYNAMIC_DRAW_ARB);
-#endif
+		if ( block->range ) {
+			FreeStatic( block );
 		} else if ( block->virtMem ) {
 			Mem_Free( block->virtMem );
 			block->virtMem = NULL;
 		}
+		block->vbo = 0;
 	}
 	block->tag = TAG_FREE;		// mark as free
 
@@ -126,10 +127,14 @@ void *idVertexCache::Position( vertCache_t *buffer ) {
 				common->Printf( "GL_ARRAY_BUFFER = %i (%i bytes)\n", buffer->vbo, buffer->size ); 
 			}
 		}
-		if ( buffer->indexBuffer ) {
-			glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, buffer->vbo );
+		// most static blocks share a few buffers, so the buffer is often still bound
+		int target = buffer->indexBuffer ? 1 : 0;
+		if ( boundBuffers[target] == buffer->vbo ) {
+			bindSkipCount++;
 		} else {
-			glBindBuffer( GL_ARRAY_BUFFER, buffer->vbo );
+			glBindBuffer( buffer->indexBuffer ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER, buffer->vbo );
+			boundBuffers[target] = buffer->vbo;
+			bindCount++;
 		}
 		return (void *)buffer->offset;
 	}
@@ -140,6 +145,19 @@ void *idVertexCache::Position( vertCache_t *buffer ) {
 
 void idVertexCache::UnbindIndex() {
 	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	boundBuffers[1] = 0;
+}
+
+/*
+==============
+idVertexCache::ResetBindings
+
+The front end binds buffers as well, in the same context if the back end
+doesn't run on the render thread
+==============
+*/
+void idVertexCache::ResetBindings() {
+	boundBuffers[0] = boundBuffers[1] = (GLuint)-1;
 }
 
 
@@ -172,8 +190,19 @@ void idVertexCache::Init() {
 	freeStaticHeaders.next = freeStaticHeaders.prev = &freeStaticHeaders;
 	staticHeaders.next = staticHeaders.prev = &staticHeaders;
 	freeDynamicHeaders.next = freeDynamicHeaders.prev = &freeDynamicHeaders;
-	dynamicHeaders.next = dynamicHeaders.prev = &dynamicHeaders;
-	deferredFreeList.next = deferredFreeList.prev = &deferredFreeList;
+	for ( int i = 0 ; i < NUM_VERTEX_FRAMES ; i++ ) {
+		dynamicHeaders[i].next = dynamicHeaders[i].prev = &dynamicHeaders[i];
+		deferredFreeList[i].next = deferredFreeList[i].prev = &deferredFreeList[i];
+		// any fences were made in the context of a previous vid_restart
+		frameFences[i] = NULL;
+	}
+
+	// any static buffers were made in the context of a previous vid_restart
+	staticPages.DeleteContents( true );
+
+	ResetBindings();
+	bindCount = bindSkipCount = lastBindCount = 0;
+	BeginLevelLoad();
 
 	// set up the dynamic frame memory
 	frameBytes = FRAME_MEMORY_BYTES;
@@ -191,9 +220,79 @@ void idVertexCache::Init() {
 	}
 	Mem_Free( junk );
 
+	InitRing();
+
 	EndFrame();
 }
 
+/*
+===========
+idVertexCache::InitRing
+
+The ring is created with immutable storage and mapped once, the temp
+buffers are still used if it isn't available or runs full
+===========
+*/
+void idVertexCache::InitRing() {
+	// any buffer was made in the context of a previous vid_restart
+	ringBuffer = 0;
+	ringMemory = NULL;
+	ringSize = 0;
+	ringWrite = 0;
+	ringRetired = 0;
+	ringAllocThisFrame = 0;
+	for ( int i = 0 ; i < NUM_VERTEX_FRAMES ; i++ ) {
+		ringFrameStart[i] = 0;
+	}
+
+	if ( virtualMemory || !r_usePersistentMapping.GetBool() ) {
+		return;
+	}
+
+	if ( !glConfig.bufferStorageAvailable ) {
+		common->Printf( "persistent vertex mapping needs GL_ARB_buffer_storage\n" );
+		return;
+	}
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers( 1, &ringBuffer );
+	glBindBuffer( GL_ARRAY_BUFFER, ringBuffer );
+	qglBufferStorage( GL_ARRAY_BUFFER, RING_MEMORY_BYTES, NULL, flags );
+	ringMemory = (byte *)glMapBufferRange( GL_ARRAY_BUFFER, 0, RING_MEMORY_BYTES, flags );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+	if ( !ringMemory ) {
+		common->Printf( "WARNING: couldn't map the vertex ring buffer\n" );
+		glDeleteBuffers( 1, &ringBuffer );
+		ringBuffer = 0;
+		return;
+	}
+
+	ringSize = RING_MEMORY_BYTES;
+
+	common->Printf( "using a %ik persistently mapped vertex ring buffer\n", ringSize / 1024 );
+}
+
+/*
+===========
+idVertexCache::ShutdownRing
+===========
+*/
+void idVertexCache::ShutdownRing() {
+	if ( ringMemory ) {
+		glBindBuffer( GL_ARRAY_BUFFER, ringBuffer );
+		glUnmapBuffer( GL_ARRAY_BUFFER );
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		ringMemory = NULL;
+	}
+	if ( ringBuffer ) {
+		glDeleteBuffers( 1, &ringBuffer );
+		ringBuffer = 0;
+	}
+	ringSize = 0;
+}
+
 /*
 ===========
 idVertexCache::PurgeAll
@@ -216,6 +315,20 @@ idVertexCache::Shutdown
 void idVertexCache::Shutdown() {
 //	PurgeAll();	// !@#: also purge the temp buffers
 
+	for ( int i = 0 ; i < NUM_VERTEX_FRAMES ; i++ ) {
+		if ( frameFences[i] ) {
+			glDeleteSync( frameFences[i] );
+			frameFences[i] = NULL;
+		}
+	}
+
+	ShutdownRing();
+
+	for ( int i = 0 ; i < staticPages.Num() ; i++ ) {
+		glDeleteBuffers( 1, &staticPages[i]->vbo );
+	}
+	staticPages.DeleteContents( true );
+
 	headerAllocator.Shutdown();
 }
 
@@ -234,26 +347,8 @@ void idVertexCache::Alloc( void *data, int size, vertCache_t **buffer, bool inde
 	// if we can't find anything, it will be NULL
 	*buffer = NULL;
 
-	// if we don't have any remaining unused headers, allocate some more
-	if ( freeStaticHeaders.next == &freeStaticHeaders ) {
-
-		for ( int i = 0; i < EXPAND_HEADERS; i++ ) {
-			block = headerAllocator.Alloc();
-			block->next = freeStaticHeaders.next;
-			block->prev = &freeStaticHeaders;
-			block->next->prev = block;
-			block->prev->next = block;
-
-			if( !virtualMemory ) {
-				glGenBuffers( 1, & block->vbo );
-			}
-		}
-	}
-
 	// move it from the freeStaticHeaders list to the staticHeaders list
-	block = freeStaticHeaders.next;
-	block->next->prev = block->prev;
-	block->prev->next = block->next;
+	block = GetFreeStaticHeader();
 	block->next = staticHeaders.next;
 	block->prev = &staticHeaders;
 	block->next->prev = block;
@@ -280,22 +375,144 @@ void idVertexCache::Alloc( void *data, int size, vertCache_t **buffer, bool inde
 
 	block->indexBuffer = indexBuffer;
 
+	block->vbo = 0;
+	block->virtMem = NULL;
+	block->page = NULL;
+	block->range = NULL;
+
 	// copy the data
-	if ( block->vbo ) {
-		if ( indexBuffer ) {
-			glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, block->vbo );
-			glBufferData( GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptrARB)size, data, GL_STATIC_DRAW );
-		} else {
-			glBindBuffer( GL_ARRAY_BUFFER, block->vbo );
-			if ( allocatingTempBuffer ) {
-				glBufferData( GL_ARRAY_BUFFER, (GLsizeiptrARB)size, data, GL_STREAM_DRAW );
-			} else {
-				glBufferData( GL_ARRAY_BUFFER, (GLsizeiptrARB)size, data, GL_STATIC_DRAW );
-			}
-		}
-	} else {
+	if ( virtualMemory ) {
 		block->virtMem = Mem_Alloc( size );
 		SIMDProcessor->Memcpy( block->virtMem, data, size );
+	} else if ( allocatingTempBuffer ) {
+		// the temp buffers get a buffer of their own
+		glGenBuffers( 1, &block->vbo );
+		glBindBuffer( GL_ARRAY_BUFFER, block->vbo );
+		glBufferData( GL_ARRAY_BUFFER, (GLsizeiptrARB)size, data, GL_STREAM_DRAW );
+	} else {
+		AllocStatic( block, size, indexBuffer, NULL );
+
+		GLenum target = indexBuffer ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+		glBindBuffer( target, block->vbo );
+		glBufferSubData( target, block->offset, (GLsizeiptrARB)size, data );
+	}
+}
+
+/*
+===========
+idVertexCache::GetFreeStaticHeader
+
+Returns a header unlinked from the freeStaticHeaders list
+===========
+*/
+vertCache_t *idVertexCache::GetFreeStaticHeader() {
+	vertCache_t	*block;
+
+	// if we don't have any remaining unused headers, allocate some more
+	if ( freeStaticHeaders.next == &freeStaticHeaders ) {
+
+		for ( int i = 0; i < EXPAND_HEADERS; i++ ) {
+			block = headerAllocator.Alloc();
+			block->vbo = 0;
+			block->virtMem = NULL;
+			block->page = NULL;
+			block->range = NULL;
+			block->next = freeStaticHeaders.next;
+			block->prev = &freeStaticHeaders;
+			block->next->prev = block;
+			block->prev->next = block;
+		}
+	}
+
+	block = freeStaticHeaders.next;
+	block->next->prev = block->prev;
+	block->prev->next = block->next;
+
+	return block;
+}
+
+/*
+===========
+idVertexCache::AllocStatic
+
+Sub-allocates the block from the first static buffer of the right kind with
+enough room, a new buffer is created if there is none, unless it is about
+to be moved out of the excluded buffer
+===========
+*/
+bool idVertexCache::AllocStatic( vertCache_t *block, int size, bool indexBuffer, vertPage_t *exclude ) {
+	vertPage_t		*page = NULL;
+	bufferRange_t	*range = NULL;
+
+	for ( int i = 0 ; i < staticPages.Num() ; i++ ) {
+		page = staticPages[i];
+		if ( page == exclude || page->indexBuffer != indexBuffer ) {
+			continue;
+		}
+		range = page->allocator.Alloc( size );
+		if ( range ) {
+			break;
+		}
+	}
+
+	if ( !range ) {
+		if ( exclude ) {
+			return false;
+		}
+
+		// data that doesn't fit a regular buffer gets one of its own size
+		int pageSize = r_vertexBufferMegs.GetInteger() * 1024 * 1024;
+		pageSize = Max( pageSize, ( size + BUFFER_ALLOC_ALIGN - 1 ) & ~( BUFFER_ALLOC_ALIGN - 1 ) );
+
+		page = new vertPage_t;
+		page->indexBuffer = indexBuffer;
+		page->allocator.Init( pageSize );
+
+		GLenum target = indexBuffer ? GL_ELEMENT_ARRAY_BUFFER : GL_ARRAY_BUFFER;
+		glGenBuffers( 1, &page->vbo );
+		glBindBuffer( target, page->vbo );
+		glBufferData( target, (GLsizeiptrARB)pageSize, NULL, GL_STATIC_DRAW );
+
+		staticPages.Append( page );
+
+		range = page->allocator.Alloc( size );
+	}
+
+	range->owner = block;
+	block->page = page;
+	block->range = range;
+	block->vbo = page->vbo;
+	block->offset = range->offset;
+
+	return true;
+}
+
+/*
+===========
+idVertexCache::FreeStatic
+
+A buffer that runs empty is released if there is another one of its kind
+===========
+*/
+void idVertexCache::FreeStatic( vertCache_t *block ) {
+	vertPage_t *page = block->page;
+
+	page->allocator.Free( block->range );
+	block->page = NULL;
+	block->range = NULL;
+
+	if ( page->allocator.GetNumAllocs() > 0 ) {
+		return;
+	}
+
+	for ( int i = 0 ; i < staticPages.Num() ; i++ ) {
+		if ( staticPages[i] != page && staticPages[i]->indexBuffer == page->indexBuffer ) {
+			glDeleteBuffers( 1, &page->vbo );
+			staticPages.Remove( page );
+			delete page;
+			levelPagesReleased++;
+			return;
+		}
 	}
 }
 
@@ -352,37 +569,55 @@ void idVertexCache::Free( vertCache_t *block ) {
 	block->next->prev = block->prev;
 	block->prev->next = block->next;
 
-	block->next = deferredFreeList.next;
-	block->prev = &deferredFreeList;
-	deferredFreeList.next->prev = block;
-	deferredFreeList.next = block;
+	block->next = deferredFreeList[listNum].next;
+	block->prev = &deferredFreeList[listNum];
+	deferredFreeList[listNum].next->prev = block;
+	deferredFreeList[listNum].next = block;
 }
 
 /*
 ===========
-idVertexCache::AllocFrameTemp
+idVertexCache::AllocRing
 
-A frame temp allocation must never be allowed to fail due to overflow.
-We can't simply sync with the GPU and overwrite what we have, because
-there may still be future references to dynamically created surfaces.
+Returns the offset of size bytes in the ring buffer, or -1 if the ring isn't
+used or the GPU may still read all the space that is left
 ===========
 */
-vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size ) {
-	vertCache_t	*block;
+int idVertexCache::AllocRing( int size ) {
+	if ( !ringMemory ) {
+		return -1;
+	}
 
-	if ( size <= 0 ) {
-		common->Error( "idVertexCache::AllocFrameTemp: size = %i\n", size );
+	// keep the vertexes 16 byte aligned for the SIMD code and the GPU
+	size = ( size + 15 ) & ~15;
+
+	unsigned int offset = ringWrite & ( ringSize - 1 );
+	unsigned int pad = 0;
+
+	// a block can't wrap around the end of the buffer, the rest of it is skipped
+	if ( offset + size > (unsigned int)ringSize ) {
+		pad = ringSize - offset;
+		offset = 0;
 	}
 
-	if ( dynamicAllocThisFrame + size > frameBytes ) {
-		// if we don't have enough room in the temp block, allocate a static block,
-		// but immediately free it so it will get freed at the next frame
-		tempOverflow = true;
-		Alloc( data, size, &block );
-		Free( block);
-		return block;
+	if ( ringWrite + pad + size - ringRetired > (unsigned int)ringSize ) {
+		return -1;
 	}
 
+	ringWrite += pad + size;
+	ringAllocThisFrame += pad + size;
+
+	return offset;
+}
+
+/*
+===========
+idVertexCache::AllocFrameTempHeader
+===========
+*/
+vertCache_t *idVertexCache::AllocFrameTempHeader( int size ) {
+	vertCache_t	*block;
+
 	// this data is just going on the shared dynamic list
 
 	// if we don't have any remaining unused headers, allocate some more
@@ -401,19 +636,62 @@ vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size ) {
 	block = freeDynamicHeaders.next;
 	block->next->prev = block->prev;
 	block->prev->next = block->next;
-	block->next = dynamicHeaders.next;
-	block->prev = &dynamicHeaders;
+	block->next = dynamicHeaders[listNum].next;
+	block->prev = &dynamicHeaders[listNum];
 	block->next->prev = block;
 	block->prev->next = block;
 
 	block->size = size;
 	block->tag = TAG_TEMP;
 	block->indexBuffer = false;
-	block->offset = dynamicAllocThisFrame;
-	dynamicAllocThisFrame += block->size;
-	dynamicCountThisFrame++;
 	block->user = NULL;
 	block->frameUsed = 0;
+	block->page = NULL;
+	block->range = NULL;
+	dynamicCountThisFrame++;
+
+	return block;
+}
+
+/*
+===========
+idVertexCache::AllocFrameTemp
+
+A frame temp allocation must never be allowed to fail due to overflow.
+We can't simply sync with the GPU and overwrite what we have, because
+there may still be future references to dynamically created surfaces.
+===========
+*/
+vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size ) {
+	vertCache_t	*block;
+
+	if ( size <= 0 ) {
+		common->Error( "idVertexCache::AllocFrameTemp: size = %i\n", size );
+	}
+
+	// the mapped ring just needs a copy, no GL call at all
+	int ringOffset = AllocRing( size );
+	if ( ringOffset >= 0 ) {
+		block = AllocFrameTempHeader( size );
+		block->vbo = ringBuffer;
+		block->virtMem = NULL;
+		block->offset = ringOffset;
+		SIMDProcessor->Memcpy( ringMemory + ringOffset, data, size );
+		return block;
+	}
+
+	if ( dynamicAllocThisFrame + size > frameBytes ) {
+		// if we don't have enough room in the temp block, allocate a static block,
+		// but immediately free it so it will get freed at the next frame
+		tempOverflow = true;
+		Alloc( data, size, &block );
+		Free( block);
+		return block;
+	}
+
+	block = AllocFrameTempHeader( size );
+	block->offset = dynamicAllocThisFrame;
+	dynamicAllocThisFrame += block->size;
 
 	// copy the data
 	block->virtMem = tempBuffers[listNum]->virtMem;
@@ -429,6 +707,36 @@ vertCache_t	*idVertexCache::AllocFrameTemp( void *data, int size ) {
 	return block;
 }
 
+/*
+===========
+idVertexCache::AllocFrameTempMapped
+
+The returned memory is usually write combined, it should be filled
+sequentially and never be read back
+===========
+*/
+vertCache_t	*idVertexCache::AllocFrameTempMapped( int size, void **data ) {
+	*data = NULL;
+
+	if ( size <= 0 ) {
+		common->Error( "idVertexCache::AllocFrameTempMapped: size = %i\n", size );
+	}
+
+	int ringOffset = AllocRing( size );
+	if ( ringOffset < 0 ) {
+		return NULL;
+	}
+
+	vertCache_t	*block = AllocFrameTempHeader( size );
+	block->vbo = ringBuffer;
+	block->virtMem = NULL;
+	block->offset = ringOffset;
+
+	*data = ringMemory + ringOffset;
+
+	return block;
+}
+
 /*
 ===========
 idVertexCache::EndFrame
@@ -449,11 +757,13 @@ void idVertexCache::EndFrame() {
 
 		const char *frameOverflow = tempOverflow ? "(OVERFLOW)" : "";
 
-		common->Printf( "vertex dynamic:%i=%ik%s, static alloc:%i=%ik used:%i=%ik total:%i=%ik\n",
-			dynamicCountThisFrame, dynamicAllocThisFrame/1024, frameOverflow,
+		common->Printf( "vertex dynamic:%i=%ik ring:%ik%s, static alloc:%i=%ik used:%i=%ik total:%i=%ik buffers:%i binds:%i\n",
+			dynamicCountThisFrame, dynamicAllocThisFrame/1024, ringAllocThisFrame/1024, frameOverflow,
 			staticCountThisFrame, staticAllocThisFrame/1024,
 			staticUseCount, staticUseSize/1024,
-			staticCountTotal, staticAllocTotal/1024 );
+			staticCountTotal, staticAllocTotal/1024,
+			staticPages.Num(), bindCount - lastBindCount );
+		lastBindCount = bindCount;
 	}
 
 #if 0
@@ -473,30 +783,244 @@ void idVertexCache::EndFrame() {
 
 
 	currentFrame = tr.frameCount;
-	listNum = currentFrame % NUM_VERTEX_FRAMES;
+	// alternate even if frames were skipped, the other temp space may still be in use
+	listNum = ( listNum + 1 ) % NUM_VERTEX_FRAMES;
 	staticAllocThisFrame = 0;
 	staticCountThisFrame = 0;
 	dynamicAllocThisFrame = 0;
 	dynamicCountThisFrame = 0;
+	ringAllocThisFrame = 0;
 	tempOverflow = false;
 
+	// the headers of the frame that used this temp space last are released now,
+	// not at the end of the frame that used them, because with the render thread
+	// the back end executes that frame after the front end has moved on
+	vertCache_t	*deferred = &deferredFreeList[listNum];
+	vertCache_t	*dynamic = &dynamicHeaders[listNum];
+
+	// wait until the GPU is done with the temp space of that frame
+	if ( frameFences[listNum] ) {
+		GLenum result;
+		do {
+			result = glClientWaitSync( frameFences[listNum], 0, FRAME_FENCE_TIMEOUT );
+		} while ( result == GL_TIMEOUT_EXPIRED );
+		glDeleteSync( frameFences[listNum] );
+		frameFences[listNum] = NULL;
+	}
+
+	// the frame that used this slot is done, so is everything written to the ring
+	// before the oldest frame the GPU may still be drawing from was started
+	ringRetired = ringFrameStart[( listNum + 1 ) % NUM_VERTEX_FRAMES];
+	ringFrameStart[listNum] = ringWrite;
+
 	// free all the deferred free headers
-	while( deferredFreeList.next != &deferredFreeList ) {
-		ActuallyFree( deferredFreeList.next );
+	while( deferred->next != deferred ) {
+		ActuallyFree( deferred->next );
 	}
 
 	// free all the frame temp headers
-	vertCache_t	*block = dynamicHeaders.next;
-	if ( block != &dynamicHeaders ) {
+	vertCache_t	*block = dynamic->next;
+	if ( block != dynamic ) {
 		block->prev = &freeDynamicHeaders;
-		dynamicHeaders.prev->next = freeDynamicHeaders.next;
-		freeDynamicHeaders.next->prev = dynamicHeaders.prev;
+		dynamic->prev->next = freeDynamicHeaders.next;
+		freeDynamicHeaders.next->prev = dynamic->prev;
 		freeDynamicHeaders.next = block;
 
-		dynamicHeaders.next = dynamicHeaders.prev = &dynamicHeaders;
+		dynamic->next = dynamic->prev = dynamic;
 	}
 }
 
+/*
+===========
+idVertexCache::FenceFrame
+
+The back end calls this after each frame, on the render thread if it is
+active.  The front end and the render thread are synced between frames, so
+the slot of the frame that is drawn is never accessed by EndFrame at the
+same time.
+===========
+*/
+void idVertexCache::FenceFrame( int frameIndex ) {
+	if ( virtualMemory ) {
+		return;
+	}
+
+	if ( frameFences[frameIndex] ) {
+		glDeleteSync( frameFences[frameIndex] );
+	}
+	frameFences[frameIndex] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+	// the front end waits for it from its own context
+	glFlush();
+}
+
+/*
+===========
+idVertexCache::Defragment
+
+Picks the least used static buffer that the other buffers of its kind have
+room for, and copies blocks out of it on the GPU until the per frame budget
+is spent.  The old range is kept by a header on the deferred free list,
+because earlier frames may still draw from it, and the buffer is released
+when the last of those is freed.
+===========
+*/
+void idVertexCache::Defragment() {
+	if ( virtualMemory || r_vertexCacheDefragKB.GetInteger() <= 0 ) {
+		return;
+	}
+
+	vertPage_t	*victim = NULL;
+	float		victimUsage = DEFRAG_MAX_USAGE;
+
+	for ( int i = 0 ; i < staticPages.Num() ; i++ ) {
+		vertPage_t *page = staticPages[i];
+
+		int otherFree = 0;
+		for ( int j = 0 ; j < staticPages.Num() ; j++ ) {
+			if ( j != i && staticPages[j]->indexBuffer == page->indexBuffer ) {
+				otherFree += staticPages[j]->allocator.GetFreeBytes();
+			}
+		}
+
+		float usage = (float)page->allocator.GetAllocatedBytes() / page->allocator.GetSize();
+		if ( usage < victimUsage && page->allocator.GetAllocatedBytes() <= otherFree ) {
+			victim = page;
+			victimUsage = usage;
+		}
+	}
+
+	if ( !victim ) {
+		return;
+	}
+
+	int budget = r_vertexCacheDefragKB.GetInteger() * 1024;
+
+	for ( bufferRange_t *range = victim->allocator.GetFirstRange() ; range && budget > 0 ; range = range->nextPhys ) {
+		if ( range->free ) {
+			continue;
+		}
+
+		// blocks waiting on the deferred free list, including the ones
+		// that keep the old data of moved blocks, aren't worth moving
+		vertCache_t *block = (vertCache_t *)range->owner;
+		if ( !block->user ) {
+			continue;
+		}
+
+		GLuint	oldVbo = block->vbo;
+		int		oldOffset = block->offset;
+
+		if ( !AllocStatic( block, block->size, block->indexBuffer, victim ) ) {
+			break;
+		}
+
+		glBindBuffer( GL_COPY_READ_BUFFER, oldVbo );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, block->vbo );
+		glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, oldOffset, block->offset, block->size );
+
+		// let the old range expire like a freed block
+		vertCache_t *old = GetFreeStaticHeader();
+		old->vbo = oldVbo;
+		old->virtMem = NULL;
+		old->indexBuffer = block->indexBuffer;
+		old->offset = oldOffset;
+		old->size = block->size;
+		old->tag = TAG_USED;
+		old->user = NULL;
+		old->frameUsed = currentFrame;
+		old->page = victim;
+		old->range = range;
+		range->owner = old;
+
+		old->next = deferredFreeList[listNum].next;
+		old->prev = &deferredFreeList[listNum];
+		deferredFreeList[listNum].next->prev = old;
+		deferredFreeList[listNum].next = old;
+
+		staticCountTotal++;
+		staticAllocTotal += old->size;
+
+		budget -= block->size;
+		levelDefragMoves++;
+		levelDefragBytes += block->size;
+	}
+
+	glBindBuffer( GL_COPY_READ_BUFFER, 0 );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+/*
+===========
+idVertexCache::BeginLevelLoad
+===========
+*/
+void idVertexCache::BeginLevelLoad() {
+	levelBindCount = bindCount;
+	levelBindSkipCount = bindSkipCount;
+	levelDefragMoves = 0;
+	levelDefragBytes = 0;
+	levelPagesReleased = 0;
+}
+
+/*
+===========
+idVertexCache::EndLevelLoad
+===========
+*/
+void idVertexCache::EndLevelLoad() {
+	if ( virtualMemory ) {
+		return;
+	}
+	PrintStaticStats();
+}
+
+/*
+=============
+idVertexCache::PrintStaticStats
+=============
+*/
+void idVertexCache::PrintStaticStats() {
+	int	numVertexPages = 0;
+	int	numIndexPages = 0;
+	int	totalBytes = 0;
+	int	allocatedBytes = 0;
+	int	dataBytes = 0;
+	int	freeBytes = 0;
+	int	largestFreeBytes = 0;
+	int	numFreeRanges = 0;
+
+	for ( int i = 0 ; i < staticPages.Num() ; i++ ) {
+		const vertPage_t *page = staticPages[i];
+
+		if ( page->indexBuffer ) {
+			numIndexPages++;
+		} else {
+			numVertexPages++;
+		}
+		totalBytes += page->allocator.GetSize();
+		allocatedBytes += page->allocator.GetAllocatedBytes();
+		freeBytes += page->allocator.GetFreeBytes();
+		largestFreeBytes += page->allocator.GetLargestFree();
+		numFreeRanges += page->allocator.GetNumFreeRanges();
+
+		for ( const bufferRange_t *range = page->allocator.GetFirstRange() ; range ; range = range->nextPhys ) {
+			if ( !range->free ) {
+				dataBytes += ( (const vertCache_t *)range->owner )->size;
+			}
+		}
+	}
+
+	// the part of the free space that is not in the largest range of its buffer
+	int fragmentation = freeBytes ? idMath::FtoiFast( 100.0f * ( freeBytes - largestFreeBytes ) / freeBytes ) : 0;
+
+	common->Printf( "%i static vertex buffers and %i static index buffers of %ik\n", numVertexPages, numIndexPages, totalBytes / 1024 );
+	common->Printf( "%ik used, %ik lost to alignment, %ik free in %i ranges, %i%% fragmented\n",
+		allocatedBytes / 1024, ( allocatedBytes - dataBytes ) / 1024, freeBytes / 1024, numFreeRanges, fragmentation );
+	common->Printf( "this level: %i buffer binds, %i skipped, %i blocks = %ik moved, %i buffers released\n",
+		bindCount - levelBindCount, bindSkipCount - levelBindSkipCount, levelDefragMoves, levelDefragBytes / 1024, levelPagesReleased );
+}
+
 /*
 =============
 idVertexCache::List
@@ -529,13 +1053,19 @@ void idVertexCache::List( void ) {
 		numFreeDynamicHeaders++;
 	}
 
-	common->Printf( "%i megs working set\n", r_vertexBufferMegs.GetInteger() );
+	common->Printf( "%i megs per static buffer\n", r_vertexBufferMegs.GetInteger() );
 	common->Printf( "%i dynamic temp buffers of %ik\n", NUM_VERTEX_FRAMES, frameBytes / 1024 );
+	if ( ringMemory ) {
+		common->Printf( "%ik persistently mapped ring, %ik in flight\n", ringSize / 1024, ( ringWrite - ringRetired ) / 1024 );
+	} else {
+		common->Printf( "no persistently mapped ring\n" );
+	}
 	common->Printf( "%5i active static headers\n", numActive );
 	common->Printf( "%5i free static headers\n", numFreeStaticHeaders );
 	common->Printf( "%5i free dynamic headers\n", numFreeDynamicHeaders );
 
 	if ( !virtualMemory  ) {
+		PrintStaticStats();
 		common->Printf( "Vertex cache is in ARB_vertex_buffer_object memory (FAST).\n");
 	} else {
 		common->Printf( "Vertex cache is in virtual memory (SLOW)\n" );
@@ -37,6 +37,13 @@ typedef enum {
 	TAG_TEMP		// in frame temp area, not static area
 } vertBlockTag_t;
 
+// static vertexes and indexes are sub-allocated from a few large buffers
+typedef struct vertPage_s {
+	GLuint				vbo;
+	bool				indexBuffer;
+	idBufferAllocator	allocator;
+} vertPage_t;
+
 typedef struct vertCache_s {
 	GLuint			vbo;
 	void			*virtMem;			// only one of vbo / virtMem will be set
@@ -49,6 +56,8 @@ typedef struct vertCache_s {
 	struct vertCache_s	**	user;				// will be set to zero when purged
 	struct vertCache_s *next, *prev;	// may be on the static list or one of the frame lists
 	int				frameUsed;			// it can't be purged if near the current frame
+	vertPage_t *	page;				// static buffer the block lives in, NULL for
+	bufferRange_t *	range;				// temp blocks and virtual memory
 } vertCache_t;
 
 
@@ -79,6 +88,10 @@ public:
 	// an indexCache, this must be called to reset GL_ELEMENT_ARRAY_BUFFER
 	void			UnbindIndex();
 
+	// called by the back end before each command list, Position skips
+	// binding a buffer again that is still bound in the back end context
+	void			ResetBindings();
+
 	// automatically freed at the end of the next frame
 	// used for specular texture coordinates and gui drawing, which
 	// will change every frame.
@@ -86,6 +99,13 @@ public:
 	// As with Position(), this may not actually be a pointer you can access.
 	vertCache_t	*	AllocFrameTemp( void *data, int bytes );
 
+	// returns a frame temp block in the persistently mapped ring buffer and
+	// sets data to the memory the caller has to fill before the frame is issued,
+	// this avoids building the vertexes somewhere else and copying them over.
+	// will return NULL if the ring isn't used or is full, the caller has to
+	// build the data itself and use AllocFrameTemp then
+	vertCache_t	*	AllocFrameTempMapped( int bytes, void **data );
+
 	// notes that a buffer is used this frame, so it can't be purged
 	// out from under the GPU
 	void			Touch( vertCache_t *buffer );
@@ -100,15 +120,41 @@ public:
 	// Also prints debugging info when enabled
 	void			EndFrame();
 
+	// the temp space and the deferred frees of the current frame
+	int				GetFrameIndex() const { return listNum; }
+
+	// called by the back end after it issued the draws of a frame, EndFrame
+	// waits for the fence before the front end writes to the same temp space
+	// or the same part of the ring buffer again
+	void			FenceFrame( int frameIndex );
+
+	// moves a limited amount of static data out of sparsely used buffers,
+	// so they can be released.  The back end must be idle, the blocks get
+	// a new buffer and offset
+	void			Defragment();
+
+	// the static buffer statistics are tracked per level
+	void			BeginLevelLoad();
+	void			EndLevelLoad();
+
 	// listVertexCache calls this
 	void			List();
 
 private:
 	void			InitMemoryBlocks( int size );
 	void			ActuallyFree( vertCache_t *block );
+	vertCache_t *	AllocFrameTempHeader( int size );
+	int				AllocRing( int size );
+	void			InitRing();
+	void			ShutdownRing();
+	vertCache_t *	GetFreeStaticHeader();
+	bool			AllocStatic( vertCache_t *block, int size, bool indexBuffer, vertPage_t *exclude );
+	void			FreeStatic( vertCache_t *block );
+	void			PrintStaticStats();
 
 	static idCVar	r_showVertexCache;
 	static idCVar	r_vertexBufferMegs;
+	static idCVar	r_vertexCacheDefragKB;
 
 	int				staticCountTotal;
 	int				staticAllocTotal;		// for end of frame purging
@@ -119,7 +165,7 @@ private:
 	int				dynamicCountThisFrame;
 
 	int				currentFrame;			// for purgable block tracking
-	int				listNum;				// currentFrame % NUM_VERTEX_FRAMES, determines which tempBuffers to use
+	int				listNum;				// alternates every frame, determines which tempBuffers to use
 
 	bool			virtualMemory;			// not fast stuff
 
@@ -132,12 +178,38 @@ private:
 
 	vertCache_t		freeStaticHeaders;		// head of doubly linked list
 	vertCache_t		freeDynamicHeaders;		// head of doubly linked list
-	vertCache_t		dynamicHeaders;			// head of doubly linked list
-	vertCache_t		deferredFreeList;		// head of doubly linked list
+	vertCache_t		dynamicHeaders[NUM_VERTEX_FRAMES];		// head of doubly linked list
+	vertCache_t		deferredFreeList[NUM_VERTEX_FRAMES];	// head of doubly linked list
 	vertCache_t		staticHeaders;			// head of doubly linked list in MRU order,
 											// staticHeaders.next is most recently used
 
 	int				frameBytes;				// for each of NUM_VERTEX_FRAMES frames
+
+	idList<vertPage_t *>	staticPages;	// in creation order, filled first to last
+
+	GLuint			boundBuffers[2];		// back end bindings, array and element array buffer
+	int				bindCount;				// glBindBuffer calls by Position, never reset
+	int				bindSkipCount;			// binds Position could skip, never reset
+	int				lastBindCount;			// for r_showVertexCache
+	int				levelBindCount;			// bindCount at BeginLevelLoad
+	int				levelBindSkipCount;
+	int				levelDefragMoves;		// blocks moved by Defragment since BeginLevelLoad
+	int				levelDefragBytes;
+	int				levelPagesReleased;
+
+	// GL_ARB_buffer_storage ring for the frame temp allocations, it stays
+	// mapped for the lifetime of the buffer, so vertexes are written straight
+	// into memory the GPU reads from.  The offsets are cumulative and only
+	// wrapped with ringSize - 1 when used, a frame is reclaimed after its fence
+	GLuint			ringBuffer;
+	byte *			ringMemory;				// NULL if the ring isn't used
+	int				ringSize;				// power of two
+	unsigned int	ringWrite;				// next free byte
+	unsigned int	ringRetired;			// everything before this is no longer used by the GPU
+	unsigned int	ringFrameStart[NUM_VERTEX_FRAMES];	// ringWrite when the frame started
+	int				ringAllocThisFrame;		// debug counter
+
+	GLsync			frameFences[NUM_VERTEX_FRAMES];		// set by FenceFrame
 };
 
 extern	idVertexCache	vertexCache;
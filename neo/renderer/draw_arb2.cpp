@@ -516,6 +516,9 @@ void R_ReloadARBPrograms_f( const idCmdArgs &args ) {
 #ifndef DISABLE_ARB2
 	int		i;
 
+	// the back end may be using the programs
+	R_SyncRenderThread();
+
 	common->Printf( "----- R_ReloadARBPrograms -----\n" );
 	for ( i = 0 ; progs[i].name[0] ; i++ ) {
 		R_LoadARBProgram( i );
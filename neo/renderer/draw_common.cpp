@@ -516,6 +516,7 @@ void RB_STD_FillDepthBuffer( drawSurf_t **drawSurfs, int numDrawSurfs ) {
 
         case BE_GL33:
             RB_RenderDrawSurfListWithFunction(drawSurfs, numDrawSurfs, RB_GL33_FillDepthBuffer);
+            R_GL33_UnbindProgram();
         break;
     }
 
@@ -716,6 +717,9 @@ int RB_STD_DrawShaderPasses( drawSurf_t **drawSurfs, int numDrawSurfs ) {
         RB_GL33_RenderShaderPasses(drawSurfs[i]);
 	}
 
+	// the passes leave their program bound for the next surface
+	R_GL33_UnbindProgram();
+
 	GL_Cull( CT_FRONT_SIDED );
 	glColor3f( 1, 1, 1 );
 
@@ -29,6 +29,7 @@ enum E_VERTEX_UNIFORMS {
     EVU_SpecularMatrix_T,
     EVU_ColorMod,
     EVU_ColorAdd,
+    EVU_Skinning,
 
     EVU_Last
 };
@@ -57,6 +58,7 @@ static const char* sVertexUniforms[EVU_Last] = {
     "gSpecularMatrix_T",
     "gColorMod",
     "gColorAdd",
+    "gSkinning",
 };
 
 enum E_FRAGMENT_UNIFORMS {
@@ -77,6 +79,16 @@ enum E_FRAGMENT_UNIFORMS {
     EFU_LocalLightOrigin,
     EFU_LocalViewOrigin,
 
+    // shadow maps of the light
+    EFU_TexShadowAtlas,
+    EFU_TexShadowCube,
+    EFU_ShadowMode,
+    EFU_ShadowMatrices,
+    EFU_ShadowCascadeSplits,
+    EFU_ShadowViewPlane,
+    EFU_ShadowLightOrigin,
+    EFU_ShadowParms,
+
     EFU_Last
 };
 
@@ -97,6 +109,16 @@ static const char* sFragmentUniforms[EFU_Last] = {
     "gSpecularModifier",
     "gLocalLightOrigin",
     "gLocalViewOrigin",
+
+    // shadow maps of the light
+    "gTexShadowAtlas",
+    "gTexShadowCube",
+    "gShadowMode",
+    "gShadowMatrices",
+    "gShadowCascadeSplits",
+    "gShadowViewPlane",
+    "gShadowLightOrigin",
+    "gShadowParms",
 };
 
 
@@ -106,23 +128,30 @@ typedef struct {
     GLint   vulocs[EVU_Last];   // vertex shader uniforms locations
     GLint   fulocs[EFU_Last];   // fragment shader uniforms locations
     char    name[64];
+    bool    hasParmBlock;       // reads the per draw parameters from gInteractionParms
+    bool    hasSkinBlock;       // can skin the vertexes with the joints in gSkinJoints
+    int     skinning;           // current value of the gSkinning uniform
 } glslProg_t;
 
 static  const int   MAX_GLPROGS = 256;
 
 // a single file can have both a vertex program and a fragment program
 static glslProg_t glslProgs[MAX_GLPROGS] = {
-    { VPROG_TEST,           0, {-1}, {-1}, "test.glsl" },
-    { VPROG_INTERACTION,    0, {-1}, {-1}, "interaction.glsl" },
-    { GLPROG_DEPTH_PASS,    0, {-1}, {-1}, "depth_pass.glsl" },
-    { GLPROG_UNLIT_PASS,    0, {-1}, {-1}, "unlit_pass.glsl" },
-    { GLPROG_ENVIRONMENT,   0, {-1}, {-1}, "environment.glsl" },
+    { VPROG_TEST,           0, {-1}, {-1}, "test.glsl",        false, false, 0 },
+    { VPROG_INTERACTION,    0, {-1}, {-1}, "interaction.glsl", false, false, 0 },
+    { GLPROG_DEPTH_PASS,    0, {-1}, {-1}, "depth_pass.glsl",  false, false, 0 },
+    { GLPROG_UNLIT_PASS,    0, {-1}, {-1}, "unlit_pass.glsl",  false, false, 0 },
+    { GLPROG_ENVIRONMENT,   0, {-1}, {-1}, "environment.glsl", false, false, 0 },
+    { GLPROG_SHADOW_MAP,    0, {-1}, {-1}, "shadow_map.glsl",  false, false, 0 },
 
 // additional programs can be dynamically specified in materials
 };
 
 int gLastProgIdx = -1;
 
+// the program that is currently bound, to skip redundant glUseProgram calls
+static GLuint gCurrentProgram = 0;
+
 
 enum E_VERTEX_ATTRIBS {
     EVA_Pos = 0,
@@ -130,9 +159,103 @@ enum E_VERTEX_ATTRIBS {
     EVA_Normal,
     EVA_Tangent,
     EVA_Binormal,
-    EVA_Color
+    EVA_Color,
+    EVA_JointIndexes,
+    EVA_JointWeights
+};
+
+
+// the per draw parameters of the interactions live in a uniform buffer, so all
+// interactions of a light can be uploaded at once and drawn sorted by state
+static const char*  INTERACTION_PARM_BLOCK = "gInteractionParms";
+static const int    INTERACTION_PARM_BINDING = 0;
+
+// std140 layout of the gInteractionParms block in interaction.glsl
+typedef struct {
+    float   mvp[16];
+    float   modelMatrix[16];
+    float   lightOrigin[4];
+    float   viewOrigin[4];
+    float   lightProjectS[4];
+    float   lightProjectT[4];
+    float   lightProjectQ[4];
+    float   lightFalloffS[4];
+    float   bumpMatrixS[4];
+    float   bumpMatrixT[4];
+    float   diffuseMatrixS[4];
+    float   diffuseMatrixT[4];
+    float   specularMatrixS[4];
+    float   specularMatrixT[4];
+    float   colorMod[4];
+    float   colorAdd[4];
+    float   diffuseModifier[4];
+    float   specularModifier[4];
+} gl33InteractionParms_t;
+
+// texture units 1 - 5 of the interaction program
+static const int NUM_INTERACTION_IMAGES = 5;
+
+typedef struct {
+    const srfTriangles_t*   tri;
+    const viewEntity_t*     space;
+    const idJointMat*       skinMatrices;   // NULL if the surface isn't skinned on the GPU
+    idImage*                images[NUM_INTERACTION_IMAGES];
+    GLuint                  vbo;            // 0 if the vertexes are in virtual memory
+    const void*             vertexes;       // attrib pointer base, the offset into vbo modulo the vertex size
+    int                     baseVertex;     // added to all indexes
+    GLuint                  indexVbo;       // 0 if the indexes are in client memory
+    const void*             indexes;
+    idScreenRect            scissor;
+    bool                    weaponDepthHack;
+    float                   modelDepthHack;
+    int                     parms;          // index into gInteractionParms
+    int                     slot;           // index into the uploaded uniform buffer
+} gl33InteractionDraw_t;
+
+static GLuint   gInteractionParmBuffer = 0;
+static int      gInteractionParmStride = 0; // sizeof(gl33InteractionParms_t) rounded up to the buffer offset alignment
+
+static idList<gl33InteractionParms_t>   gInteractionParms;
+static idList<gl33InteractionDraw_t>    gInteractionDraws;
+static idList<gl33InteractionDraw_t*>   gSortedInteractionDraws;
+static idList<byte>                     gInteractionParmUpload;
+
+// arguments of glMultiDrawElementsBaseVertex
+static idList<GLsizei>                  gMultiDrawCounts;
+static idList<const void*>              gMultiDrawIndexes;
+static idList<GLint>                    gMultiDrawBaseVertexes;
+
+
+// the joint matrices of GPU skinned surfaces, only uploaded when the
+// view entity changes, three vec4 rows of an idJointMat per joint
+static const char*  SKIN_JOINT_BLOCK = "gSkinJoints";
+static const int    SKIN_JOINT_BINDING = 1;
+
+static GLuint               gSkinJointBuffer = 0;
+static const idJointMat*    gSkinJointMatrices = NULL;  // the joints in gSkinJointBuffer, reset at the end of each pass
+static bool                 gSkinAttribsEnabled = false;
+
+
+// the shadow maps of the lights, the projected and parallel lights share the
+// atlas which is drawn before all interactions, the cube map is drawn again
+// right before the interactions of each point light
+static const int    SHADOW_ATLAS_UNIT = 8;      // past the units the images keep track of
+static const int    SHADOW_CUBE_UNIT = 9;
+
+enum E_SHADOW_MODES {
+    ESM_None = 0,
+    ESM_Projected,
+    ESM_Cascades,
+    ESM_Cube
 };
 
+static GLuint               gShadowFramebuffer = 0;
+static GLuint               gShadowAtlasImage = 0;
+static GLuint               gShadowCubeImage = 0;
+static int                  gShadowAtlasSize = 0;
+static int                  gShadowCubeSize = 0;
+static const viewLight_t*   gShadowMapLight = NULL;     // the interactions sample the shadow maps of this light
+
 
 
 static void GL_SelectTextureNoClient(const int unit) {
@@ -142,11 +265,54 @@ static void GL_SelectTextureNoClient(const int unit) {
 }
 
 
+// linked programs are saved to glprogs/cache, they are only valid for the
+// driver that created them and the source they were compiled from
+static const int    GLSL_BINARY_MAGIC = ('G' << 24) | ('L' << 16) | ('P' << 8) | 'B';
+static const int    GLSL_BINARY_VERSION = 1;
+
+typedef struct {
+    int             magic;
+    int             version;
+    unsigned int    driverChecksum;     // vendor, renderer and version strings
+    unsigned int    sourceChecksum;
+    int             format;
+    int             length;
+} glslBinaryHeader_t;
+
+// a program that is loaded in two steps, so all programs can be
+// started before waiting for the first one to link
+typedef struct {
+    GLuint          program;
+    GLuint          shaders[2];         // 0 if the program came from the cache
+    unsigned int    sourceChecksum;
+    bool            started;            // false if there is nothing to finish
+} glslPendingProg_t;
+
+typedef struct {
+    idTimer         read;
+    idTimer         cache;
+    idTimer         compile;
+    idTimer         link;
+    idTimer         save;
+    int             numCached;
+    int             numCompiled;
+    int             numFailed;
+} glslLoadStats_t;
+
+static glslLoadStats_t  gLoadStats;
+static unsigned int     gDriverChecksum = 0;
+
+
+/*
+=================
+R_CompileGLSLShader
+
+Doesn't wait for the result, R_CheckGLSLShader does
+=================
+*/
 static GLuint R_CompileGLSLShader(const char* src, int len, const bool isFragment) {
     GLuint shader = glCreateShader(isFragment ? GL_FRAGMENT_SHADER : GL_VERTEX_SHADER);
     if (shader) {
-        GLint status = 0;
-
         const char* sources[3] = {
             "#version 330\n",
             (isFragment ? "#define FRAGMENT_SHADER\n" : "#define VERTEX_SHADER\n"),
@@ -161,58 +327,162 @@ static GLuint R_CompileGLSLShader(const char* src, int len, const bool isFragmen
 
         glShaderSource(shader, 3, sources, lengthes);
         glCompileShader(shader);
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-
-        // we grab the log anyway
-        GLint infoLen = 0;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
-        if (infoLen > 1) {
-            char* log = (char *)_alloca(infoLen + 1);
-            glGetShaderInfoLog(shader, infoLen, NULL, log);
-            common->Printf("GLSL shader compilation failed:\n%s\n", log);
-        }
+    }
+    return shader;
+}
 
+/*
+=================
+R_CheckGLSLShader
+=================
+*/
+static bool R_CheckGLSLShader(GLuint shader) {
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    // we grab the log anyway
+    GLint infoLen = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
+    if (infoLen > 1) {
+        char* log = (char *)_alloca(infoLen + 1);
+        glGetShaderInfoLog(shader, infoLen, NULL, log);
+        common->Printf("GLSL shader compilation failed:\n%s\n", log);
+    }
+
+    return status != 0;
+}
+
+/*
+=================
+R_GLSLBinaryPath
+=================
+*/
+static void R_GLSLBinaryPath(int progIndex, idStr& path) {
+    idStr name = glslProgs[progIndex].name;
+    name.StripFileExtension();
+
+    path = "glprogs/cache/";
+    path += name;
+    path += ".bin";
+}
+
+/*
+=================
+R_LoadGLSLProgramBinary
+
+Returns 0 if there is no matching binary or the driver refuses it
+=================
+*/
+static GLuint R_LoadGLSLProgramBinary(int progIndex, unsigned int sourceChecksum) {
+    if (!glConfig.programBinaryAvailable || !r_useProgramBinaryCache.GetBool()) {
+        return 0;
+    }
+
+    idStr path;
+    R_GLSLBinaryPath(progIndex, path);
+
+    byte* buffer;
+    int len = fileSystem->ReadFile(path.c_str(), (void **)&buffer, NULL);
+    if (!buffer) {
+        return 0;
+    }
+
+    const glslBinaryHeader_t* header = (const glslBinaryHeader_t *)buffer;
+    if (len < (int)sizeof(glslBinaryHeader_t) || header->magic != GLSL_BINARY_MAGIC || header->version != GLSL_BINARY_VERSION
+        || header->driverChecksum != gDriverChecksum || header->sourceChecksum != sourceChecksum
+        || header->length != len - (int)sizeof(glslBinaryHeader_t)) {
+        fileSystem->FreeFile(buffer);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (program) {
+        qglProgramBinary(program, header->format, buffer + sizeof(glslBinaryHeader_t), header->length);
+
+        GLint status = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
         if (!status) {
-            glDeleteShader(shader);
-            shader = 0;
+            glDeleteProgram(program);
+            program = 0;
         }
     }
-    return shader;
+
+    fileSystem->FreeFile(buffer);
+    return program;
 }
 
+/*
+=================
+R_SaveGLSLProgramBinary
+=================
+*/
+static void R_SaveGLSLProgramBinary(int progIndex, GLuint program, unsigned int sourceChecksum) {
+    if (!glConfig.programBinaryAvailable || !r_useProgramBinaryCache.GetBool()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    byte* buffer = (byte *)Mem_Alloc(sizeof(glslBinaryHeader_t) + length);
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    qglGetProgramBinary(program, length, &written, &format, buffer + sizeof(glslBinaryHeader_t));
+
+    if (written > 0) {
+        glslBinaryHeader_t* header = (glslBinaryHeader_t *)buffer;
+        header->magic = GLSL_BINARY_MAGIC;
+        header->version = GLSL_BINARY_VERSION;
+        header->driverChecksum = gDriverChecksum;
+        header->sourceChecksum = sourceChecksum;
+        header->format = format;
+        header->length = written;
+
+        idStr path;
+        R_GLSLBinaryPath(progIndex, path);
+        fileSystem->WriteFile(path.c_str(), buffer, sizeof(glslBinaryHeader_t) + written);
+    }
+
+    Mem_Free(buffer);
+}
 
 /*
 =================
-R_LoadGLSLProgram
+R_BeginGLSLProgram
+
+Starts loading the program from the cache or compiling it,
+R_FinishGLSLProgram installs it
 =================
 */
-void R_LoadGLSLProgram(int progIndex) {
+static void R_BeginGLSLProgram(int progIndex, glslPendingProg_t& pending) {
     int     fileLen;
     idStr   fullPath = "glprogs/";
     fullPath += glslProgs[progIndex].name;
     char*   fileBuffer;
 
+    memset(&pending, 0, sizeof(pending));
+
     if (!glConfig.isInitialized || !glConfig.glslShadersAvailable) {
         return;
     }
 
-    common->Printf("%s", fullPath.c_str());
-
     // load the program even if we don't support it, so
     // fs_copyfiles can generate cross-platform data dumps
+    gLoadStats.read.Start();
     fileLen = fileSystem->ReadFile(fullPath.c_str(), (void **)&fileBuffer, NULL);
+    gLoadStats.read.Stop();
     if (!fileBuffer) {
-        common->Printf(": File not found\n");
+        common->Printf("%s: File not found\n", fullPath.c_str());
         glslProgs[progIndex].ident = -1;
         return;
     }
 
-    GLuint oldShader = glslProgs[progIndex].handle;
-
-    GLuint vertexShader = R_CompileGLSLShader(fileBuffer, fileLen, false);
-    GLuint fragmentShader = R_CompileGLSLShader(fileBuffer, fileLen, true);
-
-    fileSystem->FreeFile(fileBuffer);
+    pending.sourceChecksum = CRC32_BlockChecksum(fileBuffer, fileLen);
+    pending.started = true;
 
     //
     // submit the program string at start to GL
@@ -222,49 +492,172 @@ void R_LoadGLSLProgram(int progIndex) {
         glslProgs[progIndex].ident = PROG_USER + progIndex;
     }
 
-    if (vertexShader && fragmentShader) {
-        GLuint shader = glCreateProgram();
-        if (shader) {
-            glAttachShader(shader, vertexShader);
-            glAttachShader(shader, fragmentShader);
-            glLinkProgram(shader);
+    gLoadStats.cache.Start();
+    pending.program = R_LoadGLSLProgramBinary(progIndex, pending.sourceChecksum);
+    gLoadStats.cache.Stop();
+
+    if (!pending.program) {
+        gLoadStats.compile.Start();
+        pending.shaders[0] = R_CompileGLSLShader(fileBuffer, fileLen, false);
+        pending.shaders[1] = R_CompileGLSLShader(fileBuffer, fileLen, true);
+
+        if (pending.shaders[0] && pending.shaders[1]) {
+            pending.program = glCreateProgram();
+            if (pending.program) {
+                glAttachShader(pending.program, pending.shaders[0]);
+                glAttachShader(pending.program, pending.shaders[1]);
+                if (glConfig.programBinaryAvailable) {
+                    qglProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+                }
+                glLinkProgram(pending.program);
+            }
+        }
+        gLoadStats.compile.Stop();
+    }
+
+    fileSystem->FreeFile(fileBuffer);
+}
+
+/*
+=================
+R_GLSLProgramCompleted
+
+With parallel shader compile, tells if the driver is done with the
+program, so R_FinishGLSLProgram won't block
+=================
+*/
+static bool R_GLSLProgramCompleted(const glslPendingProg_t& pending) {
+    GLint done = GL_TRUE;
+
+    for (int i = 0; i < 2 && done; ++i) {
+        if (pending.shaders[i]) {
+            glGetShaderiv(pending.shaders[i], GL_COMPLETION_STATUS_KHR, &done);
+        }
+    }
+    if (done && pending.program) {
+        glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done);
+    }
+    return done != GL_FALSE;
+}
+
+/*
+=================
+R_FinishGLSLProgram
+=================
+*/
+static void R_FinishGLSLProgram(int progIndex, glslPendingProg_t& pending) {
+    const bool fromCache = pending.program && !pending.shaders[0];
+    bool compiled = true;
+
+    if (!pending.started) {
+        return;
+    }
 
-            // we don't need our shaders anymore
-            glDeleteShader(vertexShader);
-            glDeleteShader(fragmentShader);
+    // this is where we wait for the driver
+    gLoadStats.link.Start();
+    for (int i = 0; i < 2; ++i) {
+        if (pending.shaders[i]) {
+            compiled &= R_CheckGLSLShader(pending.shaders[i]);
+            // flagged for deletion until the program is deleted
+            glDeleteShader(pending.shaders[i]);
+        }
+    }
 
+    GLint status = 0;
+    if (pending.program) {
+        if (!fromCache) {
             // we grab the log anyway
             GLint infoLen = 0;
-            glGetProgramiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
+            glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &infoLen);
             if (infoLen > 1) {
                 char* log = (char *)_alloca(infoLen + 1);
-                glGetProgramInfoLog(shader, infoLen, NULL, log);
+                glGetProgramInfoLog(pending.program, infoLen, NULL, log);
                 common->Printf("GLSL program link failed:\n%s\n", log);
             }
+        }
+        glGetProgramiv(pending.program, GL_LINK_STATUS, &status);
+    }
+    gLoadStats.link.Stop();
 
-            GLint status = 0;
-            glGetProgramiv(shader, GL_LINK_STATUS, &status);
-            if (!status) {
-                glDeleteProgram(shader);
-            } else {
-                if (oldShader) {
-                    glDeleteProgram(oldShader);
-                }
+    if (!compiled || !status) {
+        if (pending.program) {
+            glDeleteProgram(pending.program);
+        }
+        common->Printf("glprogs/%s: failed\n", glslProgs[progIndex].name);
+        gLoadStats.numFailed++;
+        return;
+    }
+
+    if (fromCache) {
+        gLoadStats.numCached++;
+    } else {
+        gLoadStats.numCompiled++;
 
-                glslProgs[progIndex].handle = shader;
+        gLoadStats.save.Start();
+        R_SaveGLSLProgramBinary(progIndex, pending.program, pending.sourceChecksum);
+        gLoadStats.save.Stop();
+    }
 
-                // collect uniforms
-                for (int i = 0; i < EVU_Last; ++i) {
-                    glslProgs[progIndex].vulocs[i] = glGetUniformLocation(shader, sVertexUniforms[i]);
-                }
-                for (int i = 0; i < EFU_Last; ++i) {
-                    glslProgs[progIndex].fulocs[i] = glGetUniformLocation(shader, sFragmentUniforms[i]);
-                }
-            }
-        }
+    GLuint shader = pending.program;
+
+    if (glslProgs[progIndex].handle) {
+        glDeleteProgram(glslProgs[progIndex].handle);
+    }
+
+    glslProgs[progIndex].handle = shader;
+
+    // collect uniforms
+    for (int i = 0; i < EVU_Last; ++i) {
+        glslProgs[progIndex].vulocs[i] = glGetUniformLocation(shader, sVertexUniforms[i]);
+    }
+    for (int i = 0; i < EFU_Last; ++i) {
+        glslProgs[progIndex].fulocs[i] = glGetUniformLocation(shader, sFragmentUniforms[i]);
+    }
+
+    // programs with the parameter block can be drawn in batches
+    GLuint block = glGetUniformBlockIndex(shader, INTERACTION_PARM_BLOCK);
+    glslProgs[progIndex].hasParmBlock = (block != GL_INVALID_INDEX);
+    if (glslProgs[progIndex].hasParmBlock) {
+        glUniformBlockBinding(shader, block, INTERACTION_PARM_BINDING);
+    }
+
+    // programs with the joint block can draw GPU skinned surfaces
+    block = glGetUniformBlockIndex(shader, SKIN_JOINT_BLOCK);
+    glslProgs[progIndex].hasSkinBlock = (block != GL_INVALID_INDEX);
+    if (glslProgs[progIndex].hasSkinBlock) {
+        glUniformBlockBinding(shader, block, SKIN_JOINT_BINDING);
     }
+    glslProgs[progIndex].skinning = 0;
+
+    common->Printf("glprogs/%s%s\n", glslProgs[progIndex].name, fromCache ? " (cached)" : "");
+}
+
+/*
+=================
+R_ClearGLSLLoadStats
+=================
+*/
+static void R_ClearGLSLLoadStats() {
+    gLoadStats.read.Clear();
+    gLoadStats.cache.Clear();
+    gLoadStats.compile.Clear();
+    gLoadStats.link.Clear();
+    gLoadStats.save.Clear();
+    gLoadStats.numCached = 0;
+    gLoadStats.numCompiled = 0;
+    gLoadStats.numFailed = 0;
+}
+
+/*
+=================
+R_LoadGLSLProgram
+=================
+*/
+void R_LoadGLSLProgram(int progIndex) {
+    glslPendingProg_t pending;
 
-    common->Printf("\n");
+    R_BeginGLSLProgram(progIndex, pending);
+    R_FinishGLSLProgram(progIndex, pending);
 }
 
 /*
@@ -314,10 +707,59 @@ R_ReloadGLSLPrograms_f
 ==================
 */
 void R_ReloadGLSLPrograms_f(const idCmdArgs &args) {
+    static glslPendingProg_t pending[MAX_GLPROGS];
+    idTimer total;
+    int i;
+
+    // the back end may be using the programs
+    R_SyncRenderThread();
+
     common->Printf("----- R_ReloadGLSLPrograms -----\n");
-    for (int i = 0; glslProgs[i].name[0]; ++i) {
-        R_LoadGLSLProgram(i);
+    R_ClearGLSLLoadStats();
+    total.Start();
+
+    if (glConfig.parallelShaderCompileAvailable) {
+        // the driver compiles on its own threads, so start all
+        // programs before waiting for the first one
+        int numPending = 0;
+        for (i = 0; glslProgs[i].name[0]; ++i) {
+            R_BeginGLSLProgram(i, pending[i]);
+            if (pending[i].started) {
+                numPending++;
+            }
+        }
+
+        // install the programs in the order the driver completes them, so
+        // the first ones are saved to the cache while the others compile
+        while (numPending > 0) {
+            bool finished = false;
+            for (int j = 0; glslProgs[j].name[0]; ++j) {
+                if (pending[j].started && R_GLSLProgramCompleted(pending[j])) {
+                    R_FinishGLSLProgram(j, pending[j]);
+                    pending[j].started = false;
+                    numPending--;
+                    finished = true;
+                }
+            }
+            if (!finished) {
+                gLoadStats.link.Start();
+                Sys_Yield();
+                gLoadStats.link.Stop();
+            }
+        }
+    } else {
+        for (i = 0; glslProgs[i].name[0]; ++i) {
+            R_LoadGLSLProgram(i);
+        }
     }
+    R_GL33_UnbindProgram();
+
+    total.Stop();
+    common->Printf("%i programs: %i cached, %i compiled, %i failed\n", i,
+        gLoadStats.numCached, gLoadStats.numCompiled, gLoadStats.numFailed);
+    common->Printf("read %.1f ms, cache %.1f ms, compile %.1f ms, link %.1f ms, save %.1f ms, total %.1f ms\n",
+        gLoadStats.read.Milliseconds(), gLoadStats.cache.Milliseconds(), gLoadStats.compile.Milliseconds(),
+        gLoadStats.link.Milliseconds(), gLoadStats.save.Milliseconds(), total.Milliseconds());
     common->Printf("-------------------------------\n");
 }
 
@@ -340,6 +782,47 @@ void R_GL33_Init() {
 
     common->Printf("Available.\n");
 
+    // the buffer belongs to the current context, so it is recreated on vid_restart
+    GLint align = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    if (align < 16) {
+        align = 16;
+    }
+    gInteractionParmStride = ((sizeof(gl33InteractionParms_t) + align - 1) / align) * align;
+    glGenBuffers(1, &gInteractionParmBuffer);
+    gCurrentProgram = 0;
+
+    glGenBuffers(1, &gSkinJointBuffer);
+    gSkinJointMatrices = NULL;
+    gSkinAttribsEnabled = false;
+
+    // the shadow map images are created when they are first drawn
+    glGenFramebuffers(1, &gShadowFramebuffer);
+    gShadowAtlasImage = 0;
+    gShadowCubeImage = 0;
+    gShadowAtlasSize = 0;
+    gShadowCubeSize = 0;
+    gShadowMapLight = NULL;
+
+    common->Printf("Interaction parms: %i bytes per draw\n", gInteractionParmStride);
+
+    // program binaries are only valid for the driver that saved them
+    unsigned long crc;
+    CRC32_InitChecksum(crc);
+    CRC32_UpdateChecksum(crc, glConfig.vendor_string, (int)strlen(glConfig.vendor_string));
+    CRC32_UpdateChecksum(crc, glConfig.renderer_string, (int)strlen(glConfig.renderer_string));
+    CRC32_UpdateChecksum(crc, glConfig.version_string, (int)strlen(glConfig.version_string));
+    CRC32_FinishChecksum(crc);
+    gDriverChecksum = crc;
+
+    common->Printf("Program binary cache: %s\n", glConfig.programBinaryAvailable ? "yes" : "no");
+
+    // let the driver use as many compiler threads as it likes
+    if (glConfig.parallelShaderCompileAvailable) {
+        qglMaxShaderCompilerThreads(0xFFFFFFFF);
+    }
+    common->Printf("Parallel shader compile: %s\n", glConfig.parallelShaderCompileAvailable ? "yes" : "no");
+
     common->Printf("---------------------------------\n");
 
     glConfig.allowGL33Path = true;
@@ -348,12 +831,21 @@ void R_GL33_Init() {
 static void SetUniformVec4(const int loc, const float* v) {
     if (loc >= 0) {
         glUniform4fv(loc, 1, v);
+        backEnd.pc.c_gl33Uniforms++;
     }
 }
 
 static void SetUniformMat4(const int loc, const float* v) {
     if (loc >= 0) {
         glUniformMatrix4fv(loc, 1, GL_FALSE, v);
+        backEnd.pc.c_gl33Uniforms++;
+    }
+}
+
+static void SetUniformInt(const int loc, const int i) {
+    if (loc >= 0) {
+        glUniform1i(loc, i);
+        backEnd.pc.c_gl33Uniforms++;
     }
 }
 
@@ -364,7 +856,11 @@ int R_GL33_UseProgram(const int ident) {
         for (int i = 0; glslProgs[i].name[0]; ++i) {
             if (glslProgs[i].ident == ident) {
                 gLastProgIdx = i;
-                glUseProgram(glslProgs[i].handle);
+                if (glslProgs[i].handle != gCurrentProgram) {
+                    gCurrentProgram = glslProgs[i].handle;
+                    glUseProgram(gCurrentProgram);
+                    backEnd.pc.c_gl33StateChanges++;
+                }
                 break;
             }
         }
@@ -373,9 +869,103 @@ int R_GL33_UseProgram(const int ident) {
     return gLastProgIdx;
 }
 
+/*
+==================
+R_GL33_UnbindProgram
+
+Called at the end of each pass, the fixed function code in between
+expects no program to be bound
+==================
+*/
+void R_GL33_UnbindProgram() {
+    if (gCurrentProgram) {
+        gCurrentProgram = 0;
+        glUseProgram(0);
+        backEnd.pc.c_gl33StateChanges++;
+    }
+
+    // the joints are in frame memory, the next frame may get the same address
+    gSkinJointMatrices = NULL;
+}
+
+/*
+==================
+RB_GL33_DisableSkinning
+==================
+*/
+static void RB_GL33_DisableSkinning() {
+    if (gSkinAttribsEnabled) {
+        glDisableVertexAttribArray(EVA_JointIndexes);
+        glDisableVertexAttribArray(EVA_JointWeights);
+        gSkinAttribsEnabled = false;
+    }
+}
+
+/*
+==================
+RB_GL33_SetSkinning
+
+Surfaces with a jointWeightCache have the bind pose in their ambientCache,
+the vertex shader transforms it with the joints of the view entity.
+Must be called with the program bound, after the vertex pointers are set.
+==================
+*/
+static void RB_GL33_SetSkinning(glslProg_t& prog, const srfTriangles_t* tri, const viewEntity_t* space) {
+    const int skinning = (prog.hasSkinBlock && tri->jointWeightCache && space->skinMatrices) ? 1 : 0;
+
+    if (prog.skinning != skinning) {
+        prog.skinning = skinning;
+        SetUniformInt(prog.vulocs[EVU_Skinning], skinning);
+    }
+
+    if (!skinning) {
+        RB_GL33_DisableSkinning();
+        return;
+    }
+
+    if (!gSkinAttribsEnabled) {
+        glEnableVertexAttribArray(EVA_JointIndexes);
+        glEnableVertexAttribArray(EVA_JointWeights);
+        gSkinAttribsEnabled = true;
+    }
+
+    const skinWeight_t* weights = (const skinWeight_t *)vertexCache.Position(tri->jointWeightCache);
+    glVertexAttribPointer(EVA_JointIndexes, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(skinWeight_t), weights->joints);
+    glVertexAttribPointer(EVA_JointWeights, 4, GL_FLOAT,         GL_FALSE, sizeof(skinWeight_t), weights->weights);
+
+    if (space->skinMatrices != gSkinJointMatrices) {
+        const int size = space->numSkinMatrices * sizeof(idJointMat);
+
+        // orphan the old joints, earlier draws may still read them
+        glBindBuffer(GL_UNIFORM_BUFFER, gSkinJointBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_GPU_SKIN_JOINTS * sizeof(idJointMat), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, size, space->skinMatrices);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, SKIN_JOINT_BINDING, gSkinJointBuffer);
+
+        gSkinJointMatrices = space->skinMatrices;
+        backEnd.pc.c_gl33UniformBytes += size;
+        backEnd.pc.c_gl33StateChanges++;
+    }
+}
+
+/*
+==================
+RB_GL33_DrawElements
+
+Same as RB_DrawElementsWithCounters, also counting the draw calls
+==================
+*/
+static void RB_GL33_DrawElements(const srfTriangles_t* tri) {
+    backEnd.pc.c_gl33Draws++;
+    RB_DrawElementsWithCounters(tri);
+}
+
 /*
 ==================
 RB_GL33_DrawInteraction
+
+For programs without the parameter block, draws immediately
 ==================
 */
 void RB_GL33_DrawInteraction(const drawInteraction_t* din) {
@@ -450,7 +1040,635 @@ void RB_GL33_DrawInteraction(const drawInteraction_t* din) {
     din->specularImage->Bind();
 
     // draw it
-    RB_DrawElementsWithCounters(din->surf->geo);
+    RB_GL33_DrawElements(din->surf->geo);
+}
+
+/*
+==================
+RB_GL33_AddInteraction
+
+Records the interaction for RB_GL33_FlushInteractions
+==================
+*/
+static void RB_GL33_AddInteraction(const drawInteraction_t* din) {
+    static const float zero[4] = { 0, 0, 0, 0 };
+    static const float one[4] = { 1, 1, 1, 1 };
+    static const float negOne[4] = { -1, -1, -1, -1 };
+
+    const drawSurf_t* surf = din->surf;
+    const srfTriangles_t* tri = surf->geo;
+
+    gl33InteractionDraw_t& draw = gInteractionDraws.Alloc();
+    draw.tri = tri;
+    draw.space = surf->space;
+    draw.skinMatrices = tri->jointWeightCache ? surf->space->skinMatrices : NULL;
+    draw.images[EFU_TexBumpMap - 1] = din->bumpImage;
+    draw.images[EFU_TexLightFalloff - 1] = din->lightFalloffImage;
+    draw.images[EFU_TexLight - 1] = din->lightImage;
+    draw.images[EFU_TexDiffuse - 1] = din->diffuseImage;
+    draw.images[EFU_TexSpecular - 1] = din->specularImage;
+
+    // vbo draws point the attribs at the start of the vertex inside the buffer
+    // and add the rest as base vertex, so draws from the same buffer can be merged,
+    // the base vertex would also move the joint weights of skinned draws
+    const vertCache_t* ac = tri->ambientCache;
+    draw.vbo = ac->vbo;
+    if (ac->vbo && !draw.skinMatrices) {
+        draw.vertexes = (const void *)(ac->offset % (int)sizeof(idDrawVert));
+        draw.baseVertex = ac->offset / (int)sizeof(idDrawVert);
+    } else if (ac->vbo) {
+        draw.vertexes = (const void *)ac->offset;
+        draw.baseVertex = 0;
+    } else {
+        draw.vertexes = (byte *)ac->virtMem + ac->offset;
+        draw.baseVertex = 0;
+    }
+
+    if (tri->indexCache && r_useIndexBuffers.GetBool() && tri->indexCache->vbo) {
+        draw.indexVbo = tri->indexCache->vbo;
+        draw.indexes = (const void *)tri->indexCache->offset;
+    } else {
+        draw.indexVbo = 0;
+        draw.indexes = tri->indexes;
+    }
+
+    draw.scissor = surf->scissorRect;
+    draw.weaponDepthHack = surf->space->weaponDepthHack;
+    draw.modelDepthHack = surf->space->modelDepthHack;
+    draw.parms = gInteractionParms.Num();
+    draw.slot = -1;
+
+    gl33InteractionParms_t& parms = gInteractionParms.Alloc();
+    memcpy(parms.mvp,              din->modelViewProj.ToFloatPtr(),     sizeof(parms.mvp));
+    memcpy(parms.modelMatrix,      surf->space->modelMatrix.ToFloatPtr(), sizeof(parms.modelMatrix));
+    memcpy(parms.lightOrigin,      din->localLightOrigin.ToFloatPtr(),  sizeof(parms.lightOrigin));
+    memcpy(parms.viewOrigin,       din->localViewOrigin.ToFloatPtr(),   sizeof(parms.viewOrigin));
+    memcpy(parms.lightProjectS,    din->lightProjection[0].ToFloatPtr(), sizeof(parms.lightProjectS));
+    memcpy(parms.lightProjectT,    din->lightProjection[1].ToFloatPtr(), sizeof(parms.lightProjectT));
+    memcpy(parms.lightProjectQ,    din->lightProjection[2].ToFloatPtr(), sizeof(parms.lightProjectQ));
+    memcpy(parms.lightFalloffS,    din->lightProjection[3].ToFloatPtr(), sizeof(parms.lightFalloffS));
+    memcpy(parms.bumpMatrixS,      din->bumpMatrix[0].ToFloatPtr(),     sizeof(parms.bumpMatrixS));
+    memcpy(parms.bumpMatrixT,      din->bumpMatrix[1].ToFloatPtr(),     sizeof(parms.bumpMatrixT));
+    memcpy(parms.diffuseMatrixS,   din->diffuseMatrix[0].ToFloatPtr(),  sizeof(parms.diffuseMatrixS));
+    memcpy(parms.diffuseMatrixT,   din->diffuseMatrix[1].ToFloatPtr(),  sizeof(parms.diffuseMatrixT));
+    memcpy(parms.specularMatrixS,  din->specularMatrix[0].ToFloatPtr(), sizeof(parms.specularMatrixS));
+    memcpy(parms.specularMatrixT,  din->specularMatrix[1].ToFloatPtr(), sizeof(parms.specularMatrixT));
+    memcpy(parms.diffuseModifier,  din->diffuseColor.ToFloatPtr(),      sizeof(parms.diffuseModifier));
+    memcpy(parms.specularModifier, din->specularColor.ToFloatPtr(),     sizeof(parms.specularModifier));
+
+    switch (din->vertexColor) {
+        case SVC_IGNORE:
+            memcpy(parms.colorMod, zero, sizeof(parms.colorMod));
+            memcpy(parms.colorAdd, one, sizeof(parms.colorAdd));
+            break;
+        case SVC_MODULATE:
+            memcpy(parms.colorMod, one, sizeof(parms.colorMod));
+            memcpy(parms.colorAdd, zero, sizeof(parms.colorAdd));
+            break;
+        case SVC_INVERSE_MODULATE:
+            memcpy(parms.colorMod, negOne, sizeof(parms.colorMod));
+            memcpy(parms.colorAdd, one, sizeof(parms.colorAdd));
+            break;
+    }
+}
+
+/*
+==================
+RB_GL33_CompareInteractionState
+
+Orders by the cost of the state change, the light textures change the least
+==================
+*/
+static int RB_GL33_CompareInteractionState(const gl33InteractionDraw_t* a, const gl33InteractionDraw_t* b) {
+    static const int imageOrder[NUM_INTERACTION_IMAGES] = {
+        EFU_TexLight - 1, EFU_TexLightFalloff - 1, EFU_TexDiffuse - 1, EFU_TexBumpMap - 1, EFU_TexSpecular - 1
+    };
+
+    for (int i = 0; i < NUM_INTERACTION_IMAGES; ++i) {
+        const int image = imageOrder[i];
+        if (a->images[image] != b->images[image]) {
+            return a->images[image] < b->images[image] ? -1 : 1;
+        }
+    }
+    if (a->vbo != b->vbo) {
+        return a->vbo < b->vbo ? -1 : 1;
+    }
+    if (a->vertexes != b->vertexes) {
+        return a->vertexes < b->vertexes ? -1 : 1;
+    }
+    if (a->skinMatrices != b->skinMatrices) {
+        return a->skinMatrices < b->skinMatrices ? -1 : 1;
+    }
+    if (a->indexVbo != b->indexVbo) {
+        return a->indexVbo < b->indexVbo ? -1 : 1;
+    }
+    if (a->weaponDepthHack != b->weaponDepthHack) {
+        return a->weaponDepthHack ? 1 : -1;
+    }
+    if (a->modelDepthHack != b->modelDepthHack) {
+        return a->modelDepthHack < b->modelDepthHack ? -1 : 1;
+    }
+    return memcmp(&a->scissor, &b->scissor, sizeof(a->scissor));
+}
+
+/*
+==================
+R_SortInteractionDraws
+
+Equal parameters are kept together so they can share a multi draw,
+the recording order breaks the remaining ties to keep the sort stable
+==================
+*/
+static int R_SortInteractionDraws(const void* a, const void* b) {
+    const gl33InteractionDraw_t* da = *(const gl33InteractionDraw_t **)a;
+    const gl33InteractionDraw_t* db = *(const gl33InteractionDraw_t **)b;
+
+    int c = RB_GL33_CompareInteractionState(da, db);
+    if (c) {
+        return c;
+    }
+    c = memcmp(&gInteractionParms[da->parms], &gInteractionParms[db->parms], sizeof(gl33InteractionParms_t));
+    if (c) {
+        return c;
+    }
+    return da->parms - db->parms;
+}
+
+/*
+==================
+RB_GL33_SetInteractionVertexes
+==================
+*/
+static void RB_GL33_SetInteractionVertexes(glslProg_t& prog, const gl33InteractionDraw_t* draw) {
+    // binds the buffer
+    vertexCache.Position(draw->tri->ambientCache);
+
+    const idDrawVert* ac = (const idDrawVert *)draw->vertexes;
+    glVertexAttribPointer(EVA_Pos,      3, GL_FLOAT,         false, sizeof(idDrawVert), ac->xyz.ToFloatPtr());
+    glVertexAttribPointer(EVA_UV,       2, GL_FLOAT,         false, sizeof(idDrawVert), ac->st.ToFloatPtr());
+    glVertexAttribPointer(EVA_Normal,   3, GL_FLOAT,         false, sizeof(idDrawVert), ac->normal.ToFloatPtr());
+    glVertexAttribPointer(EVA_Tangent,  3, GL_FLOAT,         false, sizeof(idDrawVert), ac->tangents[0].ToFloatPtr());
+    glVertexAttribPointer(EVA_Binormal, 3, GL_FLOAT,         false, sizeof(idDrawVert), ac->tangents[1].ToFloatPtr());
+    glVertexAttribPointer(EVA_Color,    4, GL_UNSIGNED_BYTE, true,  sizeof(idDrawVert), ac->color);
+
+    RB_GL33_SetSkinning(prog, draw->tri, draw->space);
+}
+
+/*
+==================
+RB_GL33_FlushInteractions
+
+Uploads the parameters of all recorded interactions in one buffer, then
+draws them sorted by state. Consecutive draws with the same state and the
+same parameters from the same vertex buffer become a single multi draw.
+The interactions are additive, so the order doesn't change the result.
+GPU skinned draws are never merged, the joints of each need to be bound.
+==================
+*/
+static void RB_GL33_FlushInteractions(glslProg_t& prog) {
+    const int numDraws = gInteractionDraws.Num();
+    if (!numDraws) {
+        return;
+    }
+
+    const bool sort = r_useInteractionBatching.GetBool();
+
+    gSortedInteractionDraws.SetNum(numDraws, false);
+    for (int i = 0; i < numDraws; ++i) {
+        gSortedInteractionDraws[i] = &gInteractionDraws[i];
+    }
+    if (sort) {
+        qsort(gSortedInteractionDraws.Ptr(), numDraws, sizeof(gl33InteractionDraw_t*), R_SortInteractionDraws);
+    }
+
+    // equal parameters next to each other share a slot
+    gInteractionParmUpload.SetNum(numDraws * gInteractionParmStride, false);
+    int numSlots = 0;
+    const gl33InteractionParms_t* prevParms = NULL;
+    for (int i = 0; i < numDraws; ++i) {
+        gl33InteractionDraw_t* draw = gSortedInteractionDraws[i];
+        const gl33InteractionParms_t* parms = &gInteractionParms[draw->parms];
+        if (!prevParms || memcmp(parms, prevParms, sizeof(*parms))) {
+            memcpy(gInteractionParmUpload.Ptr() + numSlots * gInteractionParmStride, parms, sizeof(*parms));
+            numSlots++;
+        }
+        draw->slot = numSlots - 1;
+        prevParms = parms;
+    }
+
+    const int uploadSize = numSlots * gInteractionParmStride;
+    glBindBuffer(GL_UNIFORM_BUFFER, gInteractionParmBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, uploadSize, gInteractionParmUpload.Ptr(), GL_STREAM_DRAW);
+    backEnd.pc.c_gl33UniformBytes += uploadSize;
+
+    const gl33InteractionDraw_t* last = NULL;
+    bool depthHacked = false;
+
+    for (int i = 0; i < numDraws; ) {
+        const gl33InteractionDraw_t* draw = gSortedInteractionDraws[i];
+
+        // find the draws that can go with this one
+        int end = i + 1;
+        if (sort && draw->vbo && !draw->skinMatrices) {
+            while (end < numDraws && gSortedInteractionDraws[end]->slot == draw->slot
+                && !RB_GL33_CompareInteractionState(draw, gSortedInteractionDraws[end])) {
+                end++;
+            }
+        }
+
+        // only change the state that differs from the previous draw
+        for (int j = 0; j < NUM_INTERACTION_IMAGES; ++j) {
+            if (!last || last->images[j] != draw->images[j]) {
+                GL_SelectTextureNoClient(j + 1);
+                draw->images[j]->Bind();
+                backEnd.pc.c_gl33StateChanges++;
+            }
+        }
+
+        if (!last || last->vbo != draw->vbo || last->vertexes != draw->vertexes || last->skinMatrices != draw->skinMatrices) {
+            RB_GL33_SetInteractionVertexes(prog, draw);
+            backEnd.pc.c_gl33StateChanges++;
+        }
+
+        if (draw->indexVbo) {
+            vertexCache.Position(draw->tri->indexCache);
+        } else if (r_useIndexBuffers.GetBool()) {
+            vertexCache.UnbindIndex();
+        }
+
+        if (r_useScissor.GetBool() && !backEnd.currentScissor.Equals(draw->scissor)) {
+            backEnd.currentScissor = draw->scissor;
+            glScissor(backEnd.viewDef->viewport.x1 + backEnd.currentScissor.x1,
+                backEnd.viewDef->viewport.y1 + backEnd.currentScissor.y1,
+                backEnd.currentScissor.x2 + 1 - backEnd.currentScissor.x1,
+                backEnd.currentScissor.y2 + 1 - backEnd.currentScissor.y1);
+            backEnd.pc.c_gl33StateChanges++;
+        }
+
+        if (!last || last->weaponDepthHack != draw->weaponDepthHack || last->modelDepthHack != draw->modelDepthHack) {
+            if (depthHacked) {
+                RB_LeaveDepthHack();
+                depthHacked = false;
+            }
+            if (draw->weaponDepthHack) {
+                RB_EnterWeaponDepthHack();
+                depthHacked = true;
+            }
+            if (draw->modelDepthHack != 0.0f) {
+                RB_EnterModelDepthHack(draw->modelDepthHack);
+                depthHacked = true;
+            }
+            backEnd.pc.c_gl33StateChanges++;
+        }
+
+        if (!last || last->slot != draw->slot) {
+            glBindBufferRange(GL_UNIFORM_BUFFER, INTERACTION_PARM_BINDING, gInteractionParmBuffer,
+                draw->slot * gInteractionParmStride, sizeof(gl33InteractionParms_t));
+            backEnd.pc.c_gl33Uniforms++;
+        }
+
+        for (int j = i; j < end; ++j) {
+            const srfTriangles_t* tri = gSortedInteractionDraws[j]->tri;
+            backEnd.pc.c_drawElements++;
+            backEnd.pc.c_drawIndexes += tri->numIndexes;
+            backEnd.pc.c_drawVertexes += tri->numVerts;
+            if (draw->indexVbo) {
+                backEnd.pc.c_vboIndexes += tri->numIndexes;
+            }
+        }
+
+        const int count = r_singleTriangle.GetBool() ? 3 : draw->tri->numIndexes;
+        if (end - i > 1) {
+            gMultiDrawCounts.SetNum(0, false);
+            gMultiDrawIndexes.SetNum(0, false);
+            gMultiDrawBaseVertexes.SetNum(0, false);
+            for (int j = i; j < end; ++j) {
+                const gl33InteractionDraw_t* merged = gSortedInteractionDraws[j];
+                gMultiDrawCounts.Append(r_singleTriangle.GetBool() ? 3 : merged->tri->numIndexes);
+                gMultiDrawIndexes.Append(merged->indexes);
+                gMultiDrawBaseVertexes.Append(merged->baseVertex);
+            }
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, gMultiDrawCounts.Ptr(), GL_INDEX_TYPE,
+                gMultiDrawIndexes.Ptr(), end - i, gMultiDrawBaseVertexes.Ptr());
+            backEnd.pc.c_gl33MergedDraws += end - i;
+        } else if (draw->vbo) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_INDEX_TYPE, draw->indexes, draw->baseVertex);
+        } else {
+            glDrawElements(GL_TRIANGLES, count, GL_INDEX_TYPE, draw->indexes);
+        }
+        backEnd.pc.c_gl33Draws++;
+
+        last = draw;
+        i = end;
+    }
+
+    if (depthHacked) {
+        RB_LeaveDepthHack();
+    }
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, INTERACTION_PARM_BINDING, 0);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    gInteractionDraws.SetNum(0, false);
+    gInteractionParms.SetNum(0, false);
+}
+
+/*
+==================
+RB_GL33_CreateShadowMapImage
+
+A depth texture that compares against the reference depth when sampled,
+bound on its own unit so the images don't lose track of their bindings
+==================
+*/
+static void RB_GL33_CreateShadowMapImage(GLuint& image, const GLenum target, const int unit, const int size) {
+    if (!image) {
+        glGenTextures(1, &image);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, image);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        for (int i = 0; i < 6; ++i) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+        }
+    } else {
+        glTexImage2D(target, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, NULL);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(target, 0);
+
+    if (backEnd.glState.currenttmu >= 0) {
+        glActiveTexture(GL_TEXTURE0 + backEnd.glState.currenttmu);
+    }
+}
+
+/*
+==================
+RB_GL33_ShadowMode
+
+Lights without any casters are drawn unshadowed, their maps aren't drawn
+==================
+*/
+static int RB_GL33_ShadowMode(const viewLight_t* vLight) {
+    if (!vLight || !vLight->numShadowMapViews || !vLight->shadowMapCasters) {
+        return ESM_None;
+    }
+    switch (vLight->shadowMapType) {
+        case SHADOWMAP_PROJECTED:
+            return ESM_Projected;
+        case SHADOWMAP_CASCADES:
+            return ESM_Cascades;
+        case SHADOWMAP_CUBE:
+            return ESM_Cube;
+        default:
+            return ESM_None;
+    }
+}
+
+/*
+==================
+RB_GL33_BeginShadowMaps
+==================
+*/
+static void RB_GL33_BeginShadowMaps() {
+    glBindFramebuffer(GL_FRAMEBUFFER, gShadowFramebuffer);
+
+    // only depth is drawn, the surfaces of both sides cast shadows
+    GL_State(GLS_COLORMASK | GLS_ALPHAMASK | GLS_DEPTHFUNC_LESS);
+    GL_Cull(CT_TWO_SIDED);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(r_shadowMapPolygonFactor.GetFloat(), r_shadowMapPolygonOffset.GetFloat());
+
+    glEnableVertexAttribArray(EVA_Pos);
+}
+
+/*
+==================
+RB_GL33_EndShadowMaps
+
+Back to drawing the view
+==================
+*/
+static void RB_GL33_EndShadowMaps(const int cull) {
+    glDisableVertexAttribArray(EVA_Pos);
+    RB_GL33_DisableSkinning();
+    R_GL33_UnbindProgram();
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    GL_Cull(cull);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glViewport(tr.viewportOffset[0] + backEnd.viewDef->viewport.x1,
+        tr.viewportOffset[1] + backEnd.viewDef->viewport.y1,
+        backEnd.viewDef->viewport.x2 + 1 - backEnd.viewDef->viewport.x1,
+        backEnd.viewDef->viewport.y2 + 1 - backEnd.viewDef->viewport.y1);
+    glScissor(backEnd.viewDef->viewport.x1 + backEnd.currentScissor.x1,
+        backEnd.viewDef->viewport.y1 + backEnd.currentScissor.y1,
+        backEnd.currentScissor.x2 + 1 - backEnd.currentScissor.x1,
+        backEnd.currentScissor.y2 + 1 - backEnd.currentScissor.y1);
+}
+
+/*
+==================
+RB_GL33_DrawShadowMapView
+
+Draws the casters of the light into one atlas tile or cube map face
+==================
+*/
+static void RB_GL33_DrawShadowMapView(const viewLight_t* vLight, const shadowMapView_t* view) {
+    const int progIdx = R_GL33_UseProgram(GLPROG_SHADOW_MAP);
+    if (progIdx < 0) {
+        return;
+    }
+    glslProg_t& prog = glslProgs[progIdx];
+
+    glViewport(view->x, view->y, view->size, view->size);
+    glScissor(view->x, view->y, view->size, view->size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    backEnd.pc.c_gl33ShadowMapViews++;
+
+    for (const drawSurf_t* surf = vLight->shadowMapCasters; surf; surf = surf->nextOnLight) {
+        const srfTriangles_t* tri = surf->geo;
+
+        if (view->numCullPlanes && R_CullLocalBox(tri->bounds, surf->space->modelMatrix.ToFloatPtr(), view->numCullPlanes, view->cullPlanes)) {
+            continue;
+        }
+
+        idMat4 mvp = surf->space->modelMatrix * view->viewProjection;
+        SetUniformMat4(prog.vulocs[EVU_MVP], mvp.ToFloatPtr());
+
+        const idDrawVert* ac = (const idDrawVert *)vertexCache.Position(tri->ambientCache);
+        glVertexAttribPointer(EVA_Pos, 3, GL_FLOAT, GL_FALSE, sizeof(idDrawVert), ac->xyz.ToFloatPtr());
+
+        RB_GL33_SetSkinning(prog, tri, surf->space);
+
+        RB_GL33_DrawElements(tri);
+        backEnd.pc.c_gl33ShadowMapDraws++;
+    }
+}
+
+/*
+==================
+RB_GL33_DrawShadowMapAtlas
+
+The views of all projected and parallel lights, before any interaction is drawn
+==================
+*/
+static void RB_GL33_DrawShadowMapAtlas() {
+    const viewLight_t* vLight;
+
+    for (vLight = backEnd.viewDef->viewLights; vLight; vLight = vLight->next) {
+        const int mode = RB_GL33_ShadowMode(vLight);
+        if (mode == ESM_Projected || mode == ESM_Cascades) {
+            break;
+        }
+    }
+    if (!vLight) {
+        return;
+    }
+
+    const int size = backEnd.viewDef->shadowMapAtlasSize;
+    if (gShadowAtlasSize != size) {
+        RB_GL33_CreateShadowMapImage(gShadowAtlasImage, GL_TEXTURE_2D, SHADOW_ATLAS_UNIT, size);
+        gShadowAtlasSize = size;
+    }
+
+    const int cull = backEnd.glState.faceCulling;
+    RB_GL33_BeginShadowMaps();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gShadowAtlasImage, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    for (; vLight; vLight = vLight->next) {
+        const int mode = RB_GL33_ShadowMode(vLight);
+        if (mode != ESM_Projected && mode != ESM_Cascades) {
+            continue;
+        }
+        for (int i = 0; i < vLight->numShadowMapViews; ++i) {
+            RB_GL33_DrawShadowMapView(vLight, &vLight->shadowMapViews[i]);
+        }
+    }
+
+    RB_GL33_EndShadowMaps(cull);
+}
+
+/*
+==================
+RB_GL33_DrawShadowCube
+
+All point lights share the cube map, it is drawn right before the interactions
+==================
+*/
+static void RB_GL33_DrawShadowCube(const viewLight_t* vLight) {
+    if (RB_GL33_ShadowMode(vLight) != ESM_Cube) {
+        return;
+    }
+
+    const int size = vLight->shadowMapViews[0].size;
+    if (gShadowCubeSize != size) {
+        RB_GL33_CreateShadowMapImage(gShadowCubeImage, GL_TEXTURE_CUBE_MAP, SHADOW_CUBE_UNIT, size);
+        gShadowCubeSize = size;
+    }
+
+    const int cull = backEnd.glState.faceCulling;
+    RB_GL33_BeginShadowMaps();
+
+    for (int i = 0; i < 6; ++i) {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, gShadowCubeImage, 0);
+        if (!i) {
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+        RB_GL33_DrawShadowMapView(vLight, &vLight->shadowMapViews[i]);
+    }
+
+    RB_GL33_EndShadowMaps(cull);
+}
+
+/*
+==================
+RB_GL33_SetShadowUniforms
+
+The shadow maps the interactions of gShadowMapLight sample
+==================
+*/
+static void RB_GL33_SetShadowUniforms(glslProg_t& prog) {
+    const viewLight_t* vLight = gShadowMapLight;
+    const int mode = RB_GL33_ShadowMode(vLight);
+
+    // samplers of different types can't share a unit, even when they aren't used
+    SetUniformInt(prog.fulocs[EFU_TexShadowAtlas], SHADOW_ATLAS_UNIT);
+    SetUniformInt(prog.fulocs[EFU_TexShadowCube], SHADOW_CUBE_UNIT);
+    SetUniformInt(prog.fulocs[EFU_ShadowMode], mode);
+
+    if (mode == ESM_None) {
+        return;
+    }
+
+    float parms[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    if (mode == ESM_Cube) {
+        const idVec4 origin(vLight->globalLightOrigin.x, vLight->globalLightOrigin.y, vLight->globalLightOrigin.z, 1.0f);
+        SetUniformVec4(prog.fulocs[EFU_ShadowLightOrigin], origin.ToFloatPtr());
+        parms[0] = vLight->shadowMapDepthRange[0];
+        parms[1] = vLight->shadowMapDepthRange[1];
+
+        glActiveTexture(GL_TEXTURE0 + SHADOW_CUBE_UNIT);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, gShadowCubeImage);
+    } else {
+        float matrices[MAX_SHADOWMAP_CASCADES * 16];
+        const int numMatrices = Min(vLight->numShadowMapViews, MAX_SHADOWMAP_CASCADES);
+        for (int i = 0; i < numMatrices; ++i) {
+            memcpy(matrices + i * 16, vLight->shadowMapViews[i].textureMatrix.ToFloatPtr(), 16 * sizeof(float));
+        }
+        if (prog.fulocs[EFU_ShadowMatrices] >= 0) {
+            glUniformMatrix4fv(prog.fulocs[EFU_ShadowMatrices], numMatrices, GL_FALSE, matrices);
+            backEnd.pc.c_gl33Uniforms++;
+        }
+        SetUniformVec4(prog.fulocs[EFU_ShadowCascadeSplits], vLight->shadowMapCascadeSplits);
+        SetUniformVec4(prog.fulocs[EFU_ShadowViewPlane], vLight->shadowMapViewPlane.ToFloatPtr());
+
+        // the four samples are a texel apart
+        parms[2] = r_shadowMapFilter.GetBool() ? 1.0f / gShadowAtlasSize : 0.0f;
+        parms[3] = (float)numMatrices;
+
+        glActiveTexture(GL_TEXTURE0 + SHADOW_ATLAS_UNIT);
+        glBindTexture(GL_TEXTURE_2D, gShadowAtlasImage);
+    }
+
+    SetUniformVec4(prog.fulocs[EFU_ShadowParms], parms);
+    backEnd.pc.c_gl33StateChanges++;
+
+    if (backEnd.glState.currenttmu >= 0) {
+        glActiveTexture(GL_TEXTURE0 + backEnd.glState.currenttmu);
+    }
+}
+
+/*
+==================
+RB_GL33_UnbindShadowMaps
+==================
+*/
+static void RB_GL33_UnbindShadowMaps() {
+    if (RB_GL33_ShadowMode(gShadowMapLight) == ESM_None) {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + SHADOW_ATLAS_UNIT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0 + SHADOW_CUBE_UNIT);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    if (backEnd.glState.currenttmu >= 0) {
+        glActiveTexture(GL_TEXTURE0 + backEnd.glState.currenttmu);
+    }
 }
 
 /*
@@ -478,11 +1696,13 @@ void RB_GL33_CreateDrawInteractions(const drawSurf_t* surf) {
 
     // we pre-assign sampler uniforms
     for (int i = 0; i < EFU_Last; ++i) {
-        if (i <= EFU_TexSpecularLUT && glslProgs[progIdx].fulocs[i] >= 0) {
-            glUniform1i(glslProgs[progIdx].fulocs[i], i);
+        if (i <= EFU_TexSpecularLUT) {
+            SetUniformInt(glslProgs[progIdx].fulocs[i], i);
         }
     }
 
+    RB_GL33_SetShadowUniforms(glslProgs[progIdx]);
+
     // enable the vertex arrays
     glEnableVertexAttribArray(EVA_Pos);
     glEnableVertexAttribArray(EVA_UV);
@@ -508,21 +1728,31 @@ void RB_GL33_CreateDrawInteractions(const drawSurf_t* surf) {
     //}
 
 
-    for (; surf; surf = surf->nextOnLight) {
-        // perform setup here that will not change over multiple interaction passes
-
-        // set the vertex pointers
-        idDrawVert* ac = (idDrawVert *)vertexCache.Position(surf->geo->ambientCache);
-        glVertexAttribPointer(EVA_Pos,      3, GL_FLOAT,         false, sizeof(idDrawVert), ac->xyz.ToFloatPtr());
-        glVertexAttribPointer(EVA_UV,       2, GL_FLOAT,         false, sizeof(idDrawVert), ac->st.ToFloatPtr());
-        glVertexAttribPointer(EVA_Normal,   3, GL_FLOAT,         false, sizeof(idDrawVert), ac->normal.ToFloatPtr());
-        glVertexAttribPointer(EVA_Tangent,  3, GL_FLOAT,         false, sizeof(idDrawVert), ac->tangents[0].ToFloatPtr());
-        glVertexAttribPointer(EVA_Binormal, 3, GL_FLOAT,         false, sizeof(idDrawVert), ac->tangents[1].ToFloatPtr());
-        glVertexAttribPointer(EVA_Color,    4, GL_UNSIGNED_BYTE, true,  sizeof(idDrawVert), ac->color);
-
-        // this may cause RB_GL33_DrawInteraction to be exacuted multiple
-        // times with different colors and images if the surface or light have multiple layers
-        RB_CreateSingleDrawInteractions(surf, RB_GL33_DrawInteraction);
+    if (glslProgs[progIdx].hasParmBlock) {
+        // collect all interactions of the chain, then draw them sorted by state
+        for (; surf; surf = surf->nextOnLight) {
+            RB_DecomposeSingleDrawInteractions(surf, RB_GL33_AddInteraction);
+        }
+        RB_GL33_FlushInteractions(glslProgs[progIdx]);
+    } else {
+        for (; surf; surf = surf->nextOnLight) {
+            // perform setup here that will not change over multiple interaction passes
+
+            // set the vertex pointers
+            idDrawVert* ac = (idDrawVert *)vertexCache.Position(surf->geo->ambientCache);
+            glVertexAttribPointer(EVA_Pos,      3, GL_FLOAT,         false, sizeof(idDrawVert), ac->xyz.ToFloatPtr());
+            glVertexAttribPointer(EVA_UV,       2, GL_FLOAT,         false, sizeof(idDrawVert), ac->st.ToFloatPtr());
+            glVertexAttribPointer(EVA_Normal,   3, GL_FLOAT,         false, sizeof(idDrawVert), ac->normal.ToFloatPtr());
+            glVertexAttribPointer(EVA_Tangent,  3, GL_FLOAT,         false, sizeof(idDrawVert), ac->tangents[0].ToFloatPtr());
+            glVertexAttribPointer(EVA_Binormal, 3, GL_FLOAT,         false, sizeof(idDrawVert), ac->tangents[1].ToFloatPtr());
+            glVertexAttribPointer(EVA_Color,    4, GL_UNSIGNED_BYTE, true,  sizeof(idDrawVert), ac->color);
+
+            RB_GL33_SetSkinning(glslProgs[progIdx], surf->geo, surf->space);
+
+            // this may cause RB_GL33_DrawInteraction to be exacuted multiple
+            // times with different colors and images if the surface or light have multiple layers
+            RB_CreateSingleDrawInteractions(surf, RB_GL33_DrawInteraction);
+        }
     }
 
     glDisableVertexAttribArray(EVA_Pos);
@@ -531,6 +1761,7 @@ void RB_GL33_CreateDrawInteractions(const drawSurf_t* surf) {
     glDisableVertexAttribArray(EVA_Tangent);
     glDisableVertexAttribArray(EVA_Binormal);
     glDisableVertexAttribArray(EVA_Color);
+    RB_GL33_DisableSkinning();
 
     // disable features
     GL_SelectTextureNoClient(EFU_TexSpecularLUT);
@@ -551,12 +1782,54 @@ void RB_GL33_CreateDrawInteractions(const drawSurf_t* surf) {
     GL_SelectTextureNoClient(EFU_TexBumpMap);
     globalImages->BindNull();
 
+    RB_GL33_UnbindShadowMaps();
+
     backEnd.glState.currenttmu = -1;
     GL_SelectTexture(0);
 
-    glUseProgram(0);
+    R_GL33_UnbindProgram();
 }
 
+/*
+==================
+RB_GL33_DrawStencilShadowedInteractions
+==================
+*/
+static void RB_GL33_DrawStencilShadowedInteractions(const viewLight_t* vLight) {
+    // clear the stencil buffer if needed
+    if (vLight->globalShadows || vLight->localShadows) {
+        backEnd.currentScissor = vLight->scissorRect;
+        if (r_useScissor.GetBool()) {
+            glScissor(backEnd.viewDef->viewport.x1 + backEnd.currentScissor.x1,
+                backEnd.viewDef->viewport.y1 + backEnd.currentScissor.y1,
+                backEnd.currentScissor.x2 + 1 - backEnd.currentScissor.x1,
+                backEnd.currentScissor.y2 + 1 - backEnd.currentScissor.y1);
+        }
+        glClear(GL_STENCIL_BUFFER_BIT);
+    } else {
+        // no shadows, so no need to read or write the stencil buffer
+        // we might in theory want to use GL_ALWAYS instead of disabling
+        // completely, to satisfy the invarience rules
+        glStencilFunc(GL_ALWAYS, 128, 255);
+    }
+
+   /* if (r_useShadowVertexProgram.GetBool()) {
+        glEnable(GL_VERTEX_PROGRAM_ARB);
+        qglBindProgramARB(GL_VERTEX_PROGRAM_ARB, VPROG_STENCIL_SHADOW);
+        RB_StencilShadowPass(vLight->globalShadows);
+        RB_ARB2_CreateDrawInteractions(vLight->localInteractions);
+        glEnable(GL_VERTEX_PROGRAM_ARB);
+        qglBindProgramARB(GL_VERTEX_PROGRAM_ARB, VPROG_STENCIL_SHADOW);
+        RB_StencilShadowPass(vLight->localShadows);
+        RB_ARB2_CreateDrawInteractions(vLight->globalInteractions);
+        glDisable(GL_VERTEX_PROGRAM_ARB);	// if there weren't any globalInteractions, it would have stayed on
+    } else*/ {
+        RB_StencilShadowPass(vLight->globalShadows);
+        RB_GL33_CreateDrawInteractions(vLight->localInteractions);
+        RB_StencilShadowPass(vLight->localShadows);
+        RB_GL33_CreateDrawInteractions(vLight->globalInteractions);
+    }
+}
 
 /*
 ==================
@@ -573,6 +1846,9 @@ void RB_GL33_DrawInteractions() {
 
     GL_SelectTexture(0);
 
+    // the shadow maps of the projected and parallel lights share the atlas
+    RB_GL33_DrawShadowMapAtlas();
+
     //
     // for each light, perform adding and shadowing
     //
@@ -594,38 +1870,19 @@ void RB_GL33_DrawInteractions() {
 
         lightShader = vLight->lightShader;
 
-        // clear the stencil buffer if needed
-        if (vLight->globalShadows || vLight->localShadows) {
-            backEnd.currentScissor = vLight->scissorRect;
-            if (r_useScissor.GetBool()) {
-                glScissor(backEnd.viewDef->viewport.x1 + backEnd.currentScissor.x1,
-                    backEnd.viewDef->viewport.y1 + backEnd.currentScissor.y1,
-                    backEnd.currentScissor.x2 + 1 - backEnd.currentScissor.x1,
-                    backEnd.currentScissor.y2 + 1 - backEnd.currentScissor.y1);
-            }
-            glClear(GL_STENCIL_BUFFER_BIT);
-        } else {
-            // no shadows, so no need to read or write the stencil buffer
-            // we might in theory want to use GL_ALWAYS instead of disabling
-            // completely, to satisfy the invarience rules
+        if (vLight->shadowMapType != SHADOWMAP_NONE) {
+            // no shadow volumes, the interactions sample the shadow maps instead
+            RB_GL33_DrawShadowCube(vLight);
             glStencilFunc(GL_ALWAYS, 128, 255);
-        }
 
-       /* if (r_useShadowVertexProgram.GetBool()) {
-            glEnable(GL_VERTEX_PROGRAM_ARB);
-            qglBindProgramARB(GL_VERTEX_PROGRAM_ARB, VPROG_STENCIL_SHADOW);
-            RB_StencilShadowPass(vLight->globalShadows);
-            RB_ARB2_CreateDrawInteractions(vLight->localInteractions);
-            glEnable(GL_VERTEX_PROGRAM_ARB);
-            qglBindProgramARB(GL_VERTEX_PROGRAM_ARB, VPROG_STENCIL_SHADOW);
-            RB_StencilShadowPass(vLight->localShadows);
-            RB_ARB2_CreateDrawInteractions(vLight->globalInteractions);
-            glDisable(GL_VERTEX_PROGRAM_ARB);	// if there weren't any globalInteractions, it would have stayed on
-        } else*/ {
-            RB_StencilShadowPass(vLight->globalShadows);
+            // the shadow maps can't tell the casters apart, so the noSelfShadow
+            // surfaces would shadow themselves, they are left unshadowed
             RB_GL33_CreateDrawInteractions(vLight->localInteractions);
-            RB_StencilShadowPass(vLight->localShadows);
+            gShadowMapLight = vLight;
             RB_GL33_CreateDrawInteractions(vLight->globalInteractions);
+            gShadowMapLight = NULL;
+        } else {
+            RB_GL33_DrawStencilShadowedInteractions(vLight);
         }
 
         // translucent surfaces never get stencil shadowed
@@ -721,14 +1978,14 @@ void RB_GL33_FillDepthBuffer(const drawSurf_t *surf) {
         return;
     }
 
-    const glslProg_t& prog = glslProgs[progIdx];
+    glslProg_t& prog = glslProgs[progIdx];
 
     idMat4 mvp = surf->space->modelViewMatrix * backEnd.viewDef->projectionMatrix;
 
     // load all the vertex program uniforms
     SetUniformMat4(prog.vulocs[EVU_MVP], mvp.ToFloatPtr());
 
-    glUniform1i(prog.fulocs[EFU_TexDiffuse], 0);
+    SetUniformInt(prog.fulocs[EFU_TexDiffuse], 0);
 
     // set polygon offset if necessary
     if (shader->TestMaterialFlag(MF_POLYGONOFFSET)) {
@@ -758,6 +2015,8 @@ void RB_GL33_FillDepthBuffer(const drawSurf_t *surf) {
     glVertexAttribPointer(EVA_Pos, 3, GL_FLOAT, GL_FALSE, sizeof(idDrawVert), ac->xyz.ToFloatPtr());
     glVertexAttribPointer(EVA_UV,  2, GL_FLOAT, GL_FALSE, sizeof(idDrawVert), ac->st.ToFloatPtr());
 
+    RB_GL33_SetSkinning(prog, tri, surf->space);
+
     bool drawSolid = false;
 
     if (shader->Coverage() == MC_OPAQUE) {
@@ -808,7 +2067,7 @@ void RB_GL33_FillDepthBuffer(const drawSurf_t *surf) {
             //RB_PrepareStageTexturing(pStage, surf, ac);
 
             // draw it
-            RB_DrawElementsWithCounters(tri);
+            RB_GL33_DrawElements(tri);
 
             //RB_FinishStageTexturing(pStage, surf, ac);
         }
@@ -826,13 +2085,12 @@ void RB_GL33_FillDepthBuffer(const drawSurf_t *surf) {
         globalImages->whiteImage->Bind();
 
         // draw it
-        RB_DrawElementsWithCounters(tri);
+        RB_GL33_DrawElements(tri);
     }
 
-    glUseProgram(0);
-
     glDisableVertexAttribArray(EVA_Pos);
     glDisableVertexAttribArray(EVA_UV);
+    RB_GL33_DisableSkinning();
 
     // reset polygon offset
     if (shader->TestMaterialFlag(MF_POLYGONOFFSET)) {
@@ -1015,9 +2273,9 @@ void RB_GL33_RenderShaderPasses(const drawSurf_t *surf) {
                     GL_SelectTexture(i);
                     newStage->fragmentProgramImages[i]->Bind();
 
-                    glUniform1i(prog->fulocs[EFU_Textures] + i, i);
+                    SetUniformInt(prog->fulocs[EFU_Textures] + i, i);
                 } else {
-                    glUniform1i(prog->fulocs[EFU_Textures] + i, 0);
+                    SetUniformInt(prog->fulocs[EFU_Textures] + i, 0);
                 }
             }
 
@@ -1042,7 +2300,7 @@ void RB_GL33_RenderShaderPasses(const drawSurf_t *surf) {
             SetUniformVec4(prog->fulocs[EFU_FParams] + 1, fparm.ToFloatPtr());
 
             // draw it
-            RB_DrawElementsWithCounters(tri);
+            RB_GL33_DrawElements(tri);
 
             for (int i = 1; i < newStage->numFragmentProgramImages; ++i) {
                 if (newStage->fragmentProgramImages[i]) {
@@ -1055,8 +2313,6 @@ void RB_GL33_RenderShaderPasses(const drawSurf_t *surf) {
             }
 
             GL_SelectTexture(0);
-
-            glUseProgram(0);
             continue;
         }
 
@@ -1092,7 +2348,9 @@ void RB_GL33_RenderShaderPasses(const drawSurf_t *surf) {
             SetUniformVec4(prog->vulocs[EVU_ViewOrigin], localEyePos.ToFloatPtr());
         }
 
-        glUniform1i(prog->fulocs[EFU_TexDiffuse], 0);
+        SetUniformInt(prog->fulocs[EFU_TexDiffuse], 0);
+
+        RB_GL33_SetSkinning(glslProgs[progIdx], tri, surf->space);
 
         idVec4 colorMod, colorAdd;
         colorMod.Set(1.0f, 1.0f, 1.0f, 1.0f);
@@ -1154,7 +2412,7 @@ void RB_GL33_RenderShaderPasses(const drawSurf_t *surf) {
         //RB_PrepareStageTexturing(pStage, surf, ac);
 
         // draw it
-        RB_DrawElementsWithCounters(tri);
+        RB_GL33_DrawElements(tri);
 
         //RB_FinishStageTexturing(pStage, surf, ac);
     }
@@ -1167,12 +2425,11 @@ void RB_GL33_RenderShaderPasses(const drawSurf_t *surf) {
         RB_LeaveDepthHack();
     }
 
-    glUseProgram(0);
-
     glDisableVertexAttribArray(EVA_Pos);
     glDisableVertexAttribArray(EVA_UV);
     glDisableVertexAttribArray(EVA_Normal);
     glDisableVertexAttribArray(EVA_Tangent);
     glDisableVertexAttribArray(EVA_Binormal);
     glDisableVertexAttribArray(EVA_Color);
+    RB_GL33_DisableSkinning();
 }
@@ -0,0 +1,208 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+/*
+==============================================================================
+
+	Front end benchmark.
+
+	With r_benchmarkLog set, every frame that rendered a 3D view appends a
+	line of comma separated values to that file: the front end time of the
+	frame split into its stages, the number of views, drawSurfs, view
+	entities and lights, the interactions and shadow volumes that were
+	created, and the frame and heap memory in use.  A summary is printed
+	when the log is closed.
+
+	Together with r_nullDriver, which runs the renderer without a window or
+	GL context and discards the back end commands, a recorded demo can be
+	timed on machines without a GPU:
+
+	doom +set r_nullDriver 1 +set r_benchmarkLog bench.csv +timeDemoQuit demo1
+
+==============================================================================
+*/
+
+typedef enum {
+	BS_FRONTEND,
+	BS_PORTALS,
+	BS_OCCLUSION,
+	BS_LIGHTS,
+	BS_MODELS,
+	BS_SHADOWS,
+	BS_DEFORMS,
+	BS_SORT,
+	NUM_BENCHMARK_STAGES
+} benchmarkStage_t;
+
+static const char *benchmarkStageNames[NUM_BENCHMARK_STAGES] = {
+	"frontEnd", "portals", "occlusion", "lights", "models", "shadows", "deforms", "sort"
+};
+
+static idFile *			benchmarkFile;
+static int				benchmarkFrames;
+static double			benchmarkStageSum[NUM_BENCHMARK_STAGES];	// usec
+static idList<float>	benchmarkFrontEnd;							// usec of each frame, for the percentiles
+
+/*
+=================
+R_OpenBenchmarkLog
+=================
+*/
+static bool R_OpenBenchmarkLog( void ) {
+	benchmarkFile = fileSystem->OpenFileWrite( r_benchmarkLog.GetString() );
+	if ( !benchmarkFile ) {
+		common->Warning( "couldn't open benchmark log %s", r_benchmarkLog.GetString() );
+		r_benchmarkLog.SetString( "" );
+		r_benchmarkLog.ClearModified();
+		return false;
+	}
+
+	benchmarkFrames = 0;
+	memset( benchmarkStageSum, 0, sizeof( benchmarkStageSum ) );
+	benchmarkFrontEnd.SetGranularity( 1024 );
+	benchmarkFrontEnd.SetNum( 0, false );
+
+	benchmarkFile->Printf( "frame,views,drawSurfs,viewEntities,viewLights,interactions,shadowVolumes" );
+	for ( int i = 0 ; i < NUM_BENCHMARK_STAGES ; i++ ) {
+		benchmarkFile->Printf( ",%sUsec", benchmarkStageNames[i] );
+	}
+	benchmarkFile->Printf( ",frameMemory,heapMemory,heapBlocks\n" );
+
+	common->Printf( "writing front end benchmark to %s\n", r_benchmarkLog.GetString() );
+	return true;
+}
+
+/*
+=================
+R_BenchmarkFrame
+
+Called by R_PerformanceCounters before the counters of the frame are cleared
+=================
+*/
+void R_BenchmarkFrame( void ) {
+	double			stageUsec[NUM_BENCHMARK_STAGES];
+	memoryStats_t	heap;
+	int				i;
+
+	if ( r_benchmarkLog.IsModified() ) {
+		R_ShutdownBenchmark();
+		r_benchmarkLog.ClearModified();
+	}
+
+	if ( !r_benchmarkLog.GetString()[0] ) {
+		return;
+	}
+
+	// only frames with a 3D view, not the loading screen or the console
+	if ( !tr.pc.c_numViews ) {
+		return;
+	}
+
+	if ( !benchmarkFile && !R_OpenBenchmarkLog() ) {
+		return;
+	}
+
+	double toUsec = 1000000.0 / Sys_ClockTicksPerSecond();
+
+	stageUsec[BS_FRONTEND] = tr.pc.frontEndTicks * toUsec;
+	stageUsec[BS_PORTALS] = tr.pc.portalTicks * toUsec;
+	stageUsec[BS_OCCLUSION] = tr.pc.occlusionTicks * toUsec;
+	stageUsec[BS_LIGHTS] = tr.pc.lightSurfTicks * toUsec;
+	stageUsec[BS_MODELS] = tr.pc.modelSurfTicks * toUsec;
+	stageUsec[BS_SHADOWS] = tr.pc.shadowTicks * toUsec;
+	stageUsec[BS_DEFORMS] = tr.pc.deformTicks * toUsec;
+	stageUsec[BS_SORT] = tr.pc.sortTicks * toUsec;
+
+	Mem_GetStats( heap );
+
+	benchmarkFile->Printf( "%i,%i,%i,%i,%i,%i,%i", tr.frameCount, tr.pc.c_numViews, tr.pc.c_drawSurfs,
+		tr.pc.c_visibleViewEntities, tr.pc.c_viewLights, tr.pc.c_createInteractions, tr.pc.c_createShadowVolumes );
+	for ( i = 0 ; i < NUM_BENCHMARK_STAGES ; i++ ) {
+		benchmarkFile->Printf( ",%.1f", stageUsec[i] );
+		benchmarkStageSum[i] += stageUsec[i];
+	}
+	benchmarkFile->Printf( ",%i,%i,%i\n", R_CountFrameData(), heap.totalSize, heap.num );
+
+	benchmarkFrontEnd.Append( stageUsec[BS_FRONTEND] );
+	benchmarkFrames++;
+}
+
+/*
+=================
+R_SortFloat
+=================
+*/
+static int R_SortFloat( const float *a, const float *b ) {
+	if ( *a < *b ) {
+		return -1;
+	}
+	if ( *a > *b ) {
+		return 1;
+	}
+	return 0;
+}
+
+/*
+=================
+R_ShutdownBenchmark
+
+Closes the benchmark log and prints the summary of the frames written to it
+=================
+*/
+void R_ShutdownBenchmark( void ) {
+	if ( !benchmarkFile ) {
+		return;
+	}
+
+	common->Printf( "closing benchmark log %s\n", benchmarkFile->GetName() );
+	fileSystem->CloseFile( benchmarkFile );
+	benchmarkFile = NULL;
+
+	if ( !benchmarkFrames ) {
+		return;
+	}
+
+	benchmarkFrontEnd.Sort( R_SortFloat );
+
+	common->Printf( "%i frames, front end usec: median %.1f  95%% %.1f  max %.1f\n", benchmarkFrames,
+		benchmarkFrontEnd[benchmarkFrames / 2], benchmarkFrontEnd[( benchmarkFrames * 95 ) / 100],
+		benchmarkFrontEnd[benchmarkFrames - 1] );
+	common->Printf( "average usec:" );
+	for ( int i = 0 ; i < NUM_BENCHMARK_STAGES ; i++ ) {
+		common->Printf( " %s %.1f", benchmarkStageNames[i], benchmarkStageSum[i] / benchmarkFrames );
+	}
+	common->Printf( "\n" );
+
+	benchmarkFrontEnd.Clear();
+	benchmarkFrames = 0;
+}
@@ -32,6 +32,48 @@ If you have questions concerning this license or the applicable additional terms
 #include "tr_local.h"
 
 
+/*
+===============================================================================
+
+	Deform jobs
+
+	With r_useParallelDeforms the deforms of the surfaces added by the
+	model surfaces of a view are not evaluated when the drawSurf is added.
+	The vertex cache space of the deformed surface and the drawSurfs of the
+	particle stages are reserved on the main thread in the order the surfaces
+	are added, so the sort order doesn't change, and the vertexes are built
+	by jobs that write them straight into the mapped vertex cache ring.
+	R_FinishDeformJobs waits for the jobs and links the deformed geometry.
+
+	Flares and eyeballs are only a few vertexes and are always deformed
+	right away, just like surfaces that are invalid for their deform.
+
+===============================================================================
+*/
+
+#define	INITIAL_DEFORM_JOBS		64
+
+typedef struct deformJob_s {
+	drawSurf_t *			surf;				// the deformed surface, or the drawSurf of a particle stage
+	bool					parallel;			// false if the deform is evaluated when the surface is added
+
+	// particle stages
+	const drawSurf_t *		source;				// the surface the particles are emitted from
+	const idParticleStage *	stage;
+	int						sourceTri;			// -1 to select the triangles by area
+	const float *			sourceTriAreas;
+	float					totalArea;
+	int						totalParticles;
+
+	// reserved on the main thread, NULL if the ring buffer isn't used or is full
+	int						maxVerts;
+	vertCache_t *			mappedCache;
+	idDrawVert *			mappedVerts;
+
+	srfTriangles_t *		newTri;				// NULL if the surface is drawn as it is
+	idDrawVert *			verts;				// newTri vertexes that still have to be put in the vertex cache
+} deformJob_t;
+
 /*
 =================
 R_FinishDeform
@@ -40,7 +82,9 @@ The ambientCache is on the stack, so we don't want to leave a reference
 to it that would try to be freed later.  Create the ambientCache immediately.
 =================
 */
-static void R_FinishDeform( drawSurf_t *drawSurf, srfTriangles_t *newTri, idDrawVert *ac ) {
+static void R_FinishDeform( deformJob_t *job, srfTriangles_t *newTri, idDrawVert *ac ) {
+	drawSurf_t *drawSurf = job->surf;
+
 	if ( !newTri ) {
 		return;
 	}
@@ -57,6 +101,19 @@ static void R_FinishDeform( drawSurf_t *drawSurf, srfTriangles_t *newTri, idDraw
 		newTri->verts = NULL;
 	}
 
+	if ( job->parallel ) {
+		// the vertex cache can only be allocated from on the main thread
+		if ( job->mappedVerts && newTri->numVerts <= job->maxVerts ) {
+			SIMDProcessor->Memcpy( job->mappedVerts, ac, newTri->numVerts * sizeof( idDrawVert ) );
+			newTri->ambientCache = job->mappedCache;
+		} else {
+			job->verts = (idDrawVert *)R_FrameAlloc( newTri->numVerts * sizeof( idDrawVert ) );
+			SIMDProcessor->Memcpy( job->verts, ac, newTri->numVerts * sizeof( idDrawVert ) );
+		}
+		job->newTri = newTri;
+		return;
+	}
+
 	newTri->ambientCache = vertexCache.AllocFrameTemp( ac, newTri->numVerts * sizeof( idDrawVert ) );
 	// if we are out of vertex cache, leave it the way it is
 	if ( newTri->ambientCache ) {
@@ -72,12 +129,9 @@ Assuming all the triangles for this shader are independant
 quads, rebuild them as forward facing sprites
 =====================
 */
-static void R_AutospriteDeform( drawSurf_t *surf ) {
+static void R_AutospriteDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	int		i;
-	const idDrawVert	*v;
-	idVec3	mid, delta;
-	float	radius;
-	idVec3	left, up;
 	idVec3	leftDir, upDir;
 	const srfTriangles_t	*tri;
 	srfTriangles_t	*newTri;
@@ -109,33 +163,9 @@ static void R_AutospriteDeform( drawSurf_t *surf ) {
 
 	idDrawVert	*ac = (idDrawVert *)_alloca16( newTri->numVerts * sizeof( idDrawVert ) );
 
-	for ( i = 0 ; i < tri->numVerts ; i+=4 ) {
-		// find the midpoint
-		v = &tri->verts[i];
-
-		mid[0] = 0.25 * (v->xyz[0] + (v+1)->xyz[0] + (v+2)->xyz[0] + (v+3)->xyz[0]);
-		mid[1] = 0.25 * (v->xyz[1] + (v+1)->xyz[1] + (v+2)->xyz[1] + (v+3)->xyz[1]);
-		mid[2] = 0.25 * (v->xyz[2] + (v+1)->xyz[2] + (v+2)->xyz[2] + (v+3)->xyz[2]);
-
-		delta = v->xyz - mid;
-		radius = delta.Length() * 0.707;		// / sqrt(2)
-
-		left = leftDir * radius;
-		up = upDir * radius;
-
-		ac[i+0].xyz = mid + left + up;
-		ac[i+0].st[0] = 0;
-		ac[i+0].st[1] = 0;
-		ac[i+1].xyz = mid - left + up;
-		ac[i+1].st[0] = 1;
-		ac[i+1].st[1] = 0;
-		ac[i+2].xyz = mid - left - up;
-		ac[i+2].st[0] = 1;
-		ac[i+2].st[1] = 1;
-		ac[i+3].xyz = mid + left - up;
-		ac[i+3].st[0] = 0;
-		ac[i+3].st[1] = 1;
+	SIMDProcessor->AutospriteVerts( ac, tri->verts, tri->numVerts, leftDir, upDir );
 
+	for ( i = 0 ; i < tri->numVerts ; i+=4 ) {
 		newTri->indexes[6*(i>>2)+0] = i;
 		newTri->indexes[6*(i>>2)+1] = i+1;
 		newTri->indexes[6*(i>>2)+2] = i+2;
@@ -145,7 +175,7 @@ static void R_AutospriteDeform( drawSurf_t *surf ) {
 		newTri->indexes[6*(i>>2)+5] = i+3;
 	}
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 /*
@@ -160,7 +190,8 @@ Make sure this is used with twosided translucent shaders, because the exact side
 order may not be correct.
 =====================
 */
-static void R_TubeDeform( drawSurf_t *surf ) {
+static void R_TubeDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	int		i, j;
 	int		indexes;
 	const srfTriangles_t *tri;
@@ -273,7 +304,7 @@ static int edgeVerts[6][2] = {
 		}
 	}
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 /*
@@ -506,7 +537,8 @@ static void R_FlareDeform( drawSurf_t *surf ) {
 }
 */
 
-static void R_FlareDeform( drawSurf_t *surf ) {
+static void R_FlareDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	const srfTriangles_t *tri;
 	srfTriangles_t		*newTri;
 	idPlane	plane;
@@ -686,7 +718,7 @@ static void R_FlareDeform( drawSurf_t *surf ) {
 
 	memcpy( newTri->indexes, triIndexes, sizeof( triIndexes ) );
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 
@@ -698,7 +730,8 @@ R_ExpandDeform
 Expands the surface along it's normals by a shader amount
 =====================
 */
-static void R_ExpandDeform( drawSurf_t *surf ) {
+static void R_ExpandDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	int		i;
 	const srfTriangles_t	*tri;
 	srfTriangles_t	*newTri;
@@ -720,7 +753,7 @@ static void R_ExpandDeform( drawSurf_t *surf ) {
 		ac[i].xyz = tri->verts[i].xyz + tri->verts[i].normal * dist;
 	}
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 /*
@@ -730,7 +763,8 @@ R_MoveDeform
 Moves the surface along the X axis, mostly just for demoing the deforms
 =====================
 */
-static void  R_MoveDeform( drawSurf_t *surf ) {
+static void  R_MoveDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	int		i;
 	const srfTriangles_t	*tri;
 	srfTriangles_t	*newTri;
@@ -752,7 +786,7 @@ static void  R_MoveDeform( drawSurf_t *surf ) {
 		ac[i].xyz[0] += dist;
 	}
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 //=====================================================================================
@@ -764,7 +798,8 @@ R_TurbulentDeform
 Turbulently deforms the XYZ, S, and T values
 =====================
 */
-static void  R_TurbulentDeform( drawSurf_t *surf ) {
+static void  R_TurbulentDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	int		i;
 	const srfTriangles_t	*tri;
 	srfTriangles_t	*newTri;
@@ -798,7 +833,7 @@ static void  R_TurbulentDeform( drawSurf_t *surf ) {
 		ac[i].st[1] += range * table->TableLookup( f + tOfs );
 	}
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 //=====================================================================================
@@ -867,7 +902,8 @@ Each eyeball surface should have an separate upright triangle behind it, long en
 pointing out the eye, and another single triangle in front of the eye for the focus point.
 =====================
 */
-static void R_EyeballDeform( drawSurf_t *surf ) {
+static void R_EyeballDeform( deformJob_t *job ) {
+	drawSurf_t *surf = job->surf;
 	int		i, j, k;
 	const srfTriangles_t	*tri;
 	srfTriangles_t	*newTri;
@@ -1002,22 +1038,212 @@ static void R_EyeballDeform( drawSurf_t *surf ) {
 		}
 	}
 
-	R_FinishDeform( surf, newTri, ac );
+	R_FinishDeform( job, newTri, ac );
 }
 
 //==========================================================================================
 
 
+/*
+=====================
+R_CreateStageParticles
+
+Emits the particles of a stage into the srfTriangles R_ParticleDeform made for it
+=====================
+*/
+static void R_CreateStageParticles( deformJob_t *job ) {
+	const drawSurf_t *surf = job->source;
+	const idParticleStage *stage = job->stage;
+	const struct renderEntity_s *renderEntity = &surf->space->entityDef->parms;
+	const srfTriangles_t *srcTri = surf->geo;
+	srfTriangles_t *tri = job->newTri;
+	int		totalParticles = job->totalParticles;
+	idVec3 *quads = NULL;
+
+	//
+	// create the particles almost exactly the way idRenderModelPrt does
+	//
+	particleGen_t g;
+
+	g.renderEnt = renderEntity;
+	g.renderView = &tr.viewDef->renderView;
+	g.origin.Zero();
+	g.axis = mat3_identity;
+
+	// the quads of particles that are not aimed are placed all at once
+	if ( stage->orientation != POR_AIMED ) {
+		quads = (idVec3 *)R_FrameAlloc( totalParticles * stage->NumQuadsPerParticle() * 3 * sizeof( quads[0] ) );
+	}
+
+	tri->numVerts = 0;
+
+	idRandom	steppingRandom, steppingRandom2;
+
+	int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
+	int	stageCycle = stageAge / stage->cycleMsec;
+	int	inCycleTime = stageAge - stageCycle * stage->cycleMsec;
+
+	// some particles will be in this cycle, some will be in the previous cycle
+	steppingRandom.SetSeed( (( stageCycle << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+	steppingRandom2.SetSeed( (( (stageCycle-1) << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+
+	for ( int index = 0 ; index < totalParticles ; index++ ) {
+		g.index = index;
+
+		// bump the random
+		steppingRandom.RandomInt();
+		steppingRandom2.RandomInt();
+
+		// calculate local age for this index 
+		int	bunchOffset = stage->particleLife * 1000 * stage->spawnBunching * index / totalParticles;
+
+		int particleAge = stageAge - bunchOffset;
+		int	particleCycle = particleAge / stage->cycleMsec;
+		if ( particleCycle < 0 ) {
+			// before the particleSystem spawned
+			continue;
+		}
+		if ( stage->cycles && particleCycle >= stage->cycles ) {
+			// cycled systems will only run cycle times
+			continue;
+		}
+
+		if ( particleCycle == stageCycle ) {
+			g.random = steppingRandom;
+		} else {
+			g.random = steppingRandom2;
+		}
+
+		int	inCycleTime = particleAge - particleCycle * stage->cycleMsec;
+
+		if ( renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME] && 
+			g.renderView->time - inCycleTime >= renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME]*1000 ) {
+			// don't fire any more particles
+			continue;
+		}
+
+		// supress particles before or after the age clamp
+		g.frac = (float)inCycleTime / ( stage->particleLife * 1000 );
+		if ( g.frac < 0 ) {
+			// yet to be spawned
+			continue;
+		}
+		if ( g.frac > 1.0 ) {
+			// this particle is in the deadTime band
+			continue;
+		}
+
+		//---------------
+		// locate the particle origin and axis somewhere on the surface
+		//---------------
+
+		int pointTri = job->sourceTri;
+
+		if ( pointTri < 0 ) {
+			// select a triangle based on an even area distribution
+			pointTri = idBinSearch_LessEqual<float>( job->sourceTriAreas, srcTri->numIndexes / 3, g.random.RandomFloat() * job->totalArea );
+		}
+
+		// now pick a random point inside pointTri
+		const idDrawVert *v1 = &srcTri->verts[ srcTri->indexes[ pointTri * 3 + 0 ] ];
+		const idDrawVert *v2 = &srcTri->verts[ srcTri->indexes[ pointTri * 3 + 1 ] ];
+		const idDrawVert *v3 = &srcTri->verts[ srcTri->indexes[ pointTri * 3 + 2 ] ];
+
+		float	f1 = g.random.RandomFloat();
+		float	f2 = g.random.RandomFloat();
+		float	f3 = g.random.RandomFloat();
+
+		float	ft = 1.0f / ( f1 + f2 + f3 + 0.0001f );
+
+		f1 *= ft;
+		f2 *= ft;
+		f3 *= ft;
+
+		g.origin = v1->xyz * f1 + v2->xyz * f2 + v3->xyz * f3;
+		g.axis[0] = v1->tangents[0] * f1 + v2->tangents[0] * f2 + v3->tangents[0] * f3;
+		g.axis[1] = v1->tangents[1] * f1 + v2->tangents[1] * f2 + v3->tangents[1] * f3;
+		g.axis[2] = v1->normal * f1 + v2->normal * f2 + v3->normal * f3;
+
+		//-----------------------
+
+		// this is needed so aimed particles can calculate origins at different times
+		g.originalRandom = g.random;
+
+		g.age = g.frac * stage->particleLife;
+
+		// if the particle doesn't get drawn because it is faded out or beyond a kill region,
+		// don't increment the verts
+		if ( quads ) {
+			tri->numVerts += stage->CreateParticleQuads( &g, tri->verts + tri->numVerts, quads + ( tri->numVerts >> 2 ) * 3 );
+		} else {
+			tri->numVerts += stage->CreateParticle( &g, tri->verts + tri->numVerts );
+		}
+	}
+
+	if ( tri->numVerts == 0 ) {
+		return;
+	}
+
+	if ( quads ) {
+		SIMDProcessor->ParticleQuads( tri->verts, quads, tri->numVerts >> 2 );
+	}
+
+	// build the index list
+	int	indexes = 0;
+	for ( int i = 0 ; i < tri->numVerts ; i += 4 ) {
+		tri->indexes[indexes+0] = i;
+		tri->indexes[indexes+1] = i+2;
+		tri->indexes[indexes+2] = i+3;
+		tri->indexes[indexes+3] = i;
+		tri->indexes[indexes+4] = i+3;
+		tri->indexes[indexes+5] = i+1;
+		indexes += 6;
+	}
+	tri->numIndexes = indexes;
+
+	if ( job->parallel && job->mappedVerts ) {
+		SIMDProcessor->Memcpy( job->mappedVerts, tri->verts, tri->numVerts * sizeof( tri->verts[0] ) );
+		tri->ambientCache = job->mappedCache;
+	}
+}
+
+/*
+=====================
+R_AllocDeformJob
+=====================
+*/
+static deformJob_t *R_AllocDeformJob( void ) {
+	viewDef_t *viewDef = tr.viewDef;
+	deformJob_t *job;
+
+	// if it doesn't fit, resize the list
+	if ( viewDef->numDeformJobs == viewDef->maxDeformJobs ) {
+		deformJob_t	*old = viewDef->deformJobs;
+
+		viewDef->maxDeformJobs = ( viewDef->maxDeformJobs == 0 ) ? INITIAL_DEFORM_JOBS : viewDef->maxDeformJobs * 2;
+		viewDef->deformJobs = (deformJob_t *)R_FrameAlloc( viewDef->maxDeformJobs * sizeof( viewDef->deformJobs[0] ) );
+		if ( old ) {
+			memcpy( viewDef->deformJobs, old, viewDef->numDeformJobs * sizeof( viewDef->deformJobs[0] ) );
+		}
+	}
+
+	job = &viewDef->deformJobs[viewDef->numDeformJobs++];
+	memset( job, 0, sizeof( *job ) );
+	job->parallel = true;
+
+	return job;
+}
+
 /*
 =====================
 R_ParticleDeform
 
-Emit particles from the surface instead of drawing it
+Emit particles from the surface instead of drawing it.
+If parallel is set the particles are emitted by deform jobs.
 =====================
 */
-static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
+static void R_ParticleDeform( drawSurf_t *surf, bool useArea, bool parallel ) {
 	const struct renderEntity_s *renderEntity = &surf->space->entityDef->parms;
-	const struct viewDef_s *viewDef = tr.viewDef;
 	const idDeclParticle *particleSystem = (idDeclParticle *)surf->material->GetDeformDecl();
 
 	if ( r_skipParticles.GetBool() ) {
@@ -1041,7 +1267,8 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 	const srfTriangles_t	*srcTri = surf->geo;
 
 	if ( useArea ) {
-		sourceTriAreas = (float *)_alloca( sizeof( *sourceTriAreas ) * numSourceTris );
+		// the jobs read them after this returns
+		sourceTriAreas = (float *)R_FrameAlloc( sizeof( *sourceTriAreas ) * numSourceTris );
 		int	triNum = 0;
 		for ( int i = 0 ; i < srcTri->numIndexes ; i += 3, triNum++ ) {
 			float	area;
@@ -1051,16 +1278,6 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 		}
 	}
 
-	//
-	// create the particles almost exactly the way idRenderModelPrt does
-	//
-	particleGen_t g;
-
-	g.renderEnt = renderEntity;
-	g.renderView = &viewDef->renderView;
-	g.origin.Zero();
-	g.axis = mat3_identity;
-
 	for ( int currentTri = 0; currentTri < ( ( useArea ) ? 1 : numSourceTris ); currentTri++ ) {
 
 		for ( int stageNum = 0 ; stageNum < particleSystem->stages.Num() ; stageNum++ ) {
@@ -1082,6 +1299,10 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 
 			int	count = totalParticles * stage->NumQuadsPerParticle();
 
+			if ( count <= 0 ) {
+				continue;
+			}
+
 			// allocate a srfTriangles in temp memory that can hold all the particles
 			srfTriangles_t	*tri;
 
@@ -1094,131 +1315,240 @@ static void R_ParticleDeform( drawSurf_t *surf, bool useArea ) {
 			// just always draw the particles
 			tri->bounds = stage->bounds;
 
-			tri->numVerts = 0;
-
-			idRandom	steppingRandom, steppingRandom2;
+			deformJob_t	serialJob;
+			deformJob_t	*job;
 
-			int stageAge = g.renderView->time + renderEntity->shaderParms[SHADERPARM_TIMEOFFSET] * 1000 - stage->timeOffset * 1000;
-			int	stageCycle = stageAge / stage->cycleMsec;
-			int	inCycleTime = stageAge - stageCycle * stage->cycleMsec;
+			if ( parallel ) {
+				// the drawSurf is added now to keep its place in the sort order,
+				// R_FinishDeformJobs removes it again if no particle is visible
+				int surfNum = tr.viewDef->numDrawSurfs;
+				R_AddDrawSurf( tri, surf->space, renderEntity, stage->material, surf->scissorRect );
 
-			// some particles will be in this cycle, some will be in the previous cycle
-			steppingRandom.SetSeed( (( stageCycle << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
-			steppingRandom2.SetSeed( (( (stageCycle-1) << 10 ) & idRandom::MAX_RAND) ^ (int)( renderEntity->shaderParms[SHADERPARM_DIVERSITY] * idRandom::MAX_RAND )  );
+				job = R_AllocDeformJob();
+				job->surf = tr.viewDef->drawSurfs[surfNum];
+				job->maxVerts = tri->numVerts;
+				job->mappedCache = vertexCache.AllocFrameTempMapped( tri->numVerts * sizeof( tri->verts[0] ), (void **)&job->mappedVerts );
+			} else {
+				job = &serialJob;
+				memset( job, 0, sizeof( *job ) );
+			}
 
-			for ( int index = 0 ; index < totalParticles ; index++ ) {
-				g.index = index;
+			job->source = surf;
+			job->stage = stage;
+			job->sourceTri = ( useArea ) ? -1 : currentTri;
+			job->sourceTriAreas = sourceTriAreas;
+			job->totalArea = totalArea;
+			job->totalParticles = totalParticles;
+			job->newTri = tri;
 
-				// bump the random
-				steppingRandom.RandomInt();
-				steppingRandom2.RandomInt();
+			if ( parallel ) {
+				continue;
+			}
 
-				// calculate local age for this index 
-				int	bunchOffset = stage->particleLife * 1000 * stage->spawnBunching * index / totalParticles;
+			R_CreateStageParticles( job );
 
-				int particleAge = stageAge - bunchOffset;
-				int	particleCycle = particleAge / stage->cycleMsec;
-				if ( particleCycle < 0 ) {
-					// before the particleSystem spawned
-					continue;
-				}
-				if ( stage->cycles && particleCycle >= stage->cycles ) {
-					// cycled systems will only run cycle times
-					continue;
+			if ( tri->numVerts > 0 ) {
+				tri->ambientCache = vertexCache.AllocFrameTemp( tri->verts, tri->numVerts * sizeof( idDrawVert ) );
+				if ( tri->ambientCache ) {
+					// add the drawsurf
+					R_AddDrawSurf( tri, surf->space, renderEntity, stage->material, surf->scissorRect );
 				}
+			}
+		}
+	}
+}
 
-				if ( particleCycle == stageCycle ) {
-					g.random = steppingRandom;
-				} else {
-					g.random = steppingRandom2;
-				}
+//========================================================================================
 
-				int	inCycleTime = particleAge - particleCycle * stage->cycleMsec;
+/*
+=================
+R_DeformJob
+=================
+*/
+static void R_DeformJob( deformJob_t *job ) {
+	if ( job->stage ) {
+		R_CreateStageParticles( job );
+		return;
+	}
 
-				if ( renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME] && 
-					g.renderView->time - inCycleTime >= renderEntity->shaderParms[SHADERPARM_PARTICLE_STOPTIME]*1000 ) {
-					// don't fire any more particles
-					continue;
-				}
+	switch ( job->surf->material->Deform() ) {
+	case DFRM_SPRITE:
+		R_AutospriteDeform( job );
+		break;
+	case DFRM_TUBE:
+		R_TubeDeform( job );
+		break;
+	case DFRM_EXPAND:
+		R_ExpandDeform( job );
+		break;
+	case DFRM_MOVE:
+		R_MoveDeform( job );
+		break;
+	case DFRM_TURB:
+		R_TurbulentDeform( job );
+		break;
+	default:
+		// the other deforms are never queued
+		break;
+	}
+}
 
-				// supress particles before or after the age clamp
-				g.frac = (float)inCycleTime / ( stage->particleLife * 1000 );
-				if ( g.frac < 0 ) {
-					// yet to be spawned
-					continue;
-				}
-				if ( g.frac > 1.0 ) {
-					// this particle is in the deadTime band
-					continue;
-				}
+/*
+=================
+R_MaterialAllowsDeformJob
 
-				//---------------
-				// locate the particle origin and axis somewhere on the surface
-				//---------------
+The skybox texgens and the guis are made from the geometry of the drawSurf when it is added
+=================
+*/
+static bool R_MaterialAllowsDeformJob( const idMaterial *material ) {
+	if ( material->Texgen() == TG_SKYBOX_CUBE || material->Texgen() == TG_WOBBLESKY_CUBE ) {
+		return false;
+	}
+	if ( material->HasGui() ) {
+		return false;
+	}
+	return true;
+}
 
-				int pointTri = currentTri;
+/*
+=================
+R_QueueDeform
 
-				if ( useArea ) {
-					// select a triangle based on an even area distribution
-					pointTri = idBinSearch_LessEqual<float>( sourceTriAreas, numSourceTris, g.random.RandomFloat() * totalArea );
-				}
+Returns false if the deform has to be evaluated right away
+=================
+*/
+static bool R_QueueDeform( drawSurf_t *drawSurf ) {
+	const idMaterial *material = drawSurf->material;
+	const srfTriangles_t *tri = drawSurf->geo;
+
+	if ( !R_MaterialAllowsDeformJob( material ) ) {
+		return false;
+	}
+
+	switch ( material->Deform() ) {
+	case DFRM_SPRITE:
+	case DFRM_TUBE:
+		// bad surfaces are reported on this thread
+		if ( ( tri->numVerts & 3 ) || tri->numIndexes != ( tri->numVerts >> 2 ) * 6 ) {
+			return false;
+		}
+		break;
+	case DFRM_EXPAND:
+	case DFRM_MOVE:
+	case DFRM_TURB:
+		break;
+	case DFRM_PARTICLE:
+	case DFRM_PARTICLE2: {
+		const idDeclParticle *particleSystem = (idDeclParticle *)material->GetDeformDecl();
+		for ( int i = 0 ; i < particleSystem->stages.Num() ; i++ ) {
+			const idMaterial *stageMaterial = particleSystem->stages[i]->material;
+			if ( stageMaterial && ( stageMaterial->Deform() != DFRM_NONE || !R_MaterialAllowsDeformJob( stageMaterial ) ) ) {
+				return false;
+			}
+		}
+		R_ParticleDeform( drawSurf, ( material->Deform() == DFRM_PARTICLE ), true );
+		return true;
+	}
+	default:
+		return false;
+	}
 
-				// now pick a random point inside pointTri
-				const idDrawVert *v1 = &srcTri->verts[ srcTri->indexes[ pointTri * 3 + 0 ] ];
-				const idDrawVert *v2 = &srcTri->verts[ srcTri->indexes[ pointTri * 3 + 1 ] ];
-				const idDrawVert *v3 = &srcTri->verts[ srcTri->indexes[ pointTri * 3 + 2 ] ];
+	if ( tri->numVerts <= 0 ) {
+		return false;
+	}
 
-				float	f1 = g.random.RandomFloat();
-				float	f2 = g.random.RandomFloat();
-				float	f3 = g.random.RandomFloat();
+	deformJob_t *job = R_AllocDeformJob();
+	job->surf = drawSurf;
+	job->maxVerts = tri->numVerts;
+	job->mappedCache = vertexCache.AllocFrameTempMapped( tri->numVerts * sizeof( idDrawVert ), (void **)&job->mappedVerts );
 
-				float	ft = 1.0f / ( f1 + f2 + f3 + 0.0001f );
+	return true;
+}
 
-				f1 *= ft;
-				f2 *= ft;
-				f3 *= ft;
+/*
+=================
+R_BeginDeformJobs
 
-				g.origin = v1->xyz * f1 + v2->xyz * f2 + v3->xyz * f3;
-				g.axis[0] = v1->tangents[0] * f1 + v2->tangents[0] * f2 + v3->tangents[0] * f3;
-				g.axis[1] = v1->tangents[1] * f1 + v2->tangents[1] * f2 + v3->tangents[1] * f3;
-				g.axis[2] = v1->normal * f1 + v2->normal * f2 + v3->normal * f3;
+The deforms of the surfaces added until R_FinishDeformJobs are evaluated with parallel jobs
+=================
+*/
+void R_BeginDeformJobs( void ) {
+	tr.viewDef->deformJobs = NULL;
+	tr.viewDef->numDeformJobs = 0;
+	tr.viewDef->maxDeformJobs = 0;
+
+	// the tangents of the deformed surfaces are counted in the shared performance counters
+	tr.viewDef->parallelDeforms = r_useParallelDeforms.GetBool() && parallelJobManager->GetNumThreads() > 0
+									&& !r_skipDeforms.GetBool() && !r_showDynamic.GetBool();
+}
 
-				//-----------------------
+/*
+=================
+R_FinishDeformJobs
+=================
+*/
+void R_FinishDeformJobs( void ) {
+	viewDef_t	*viewDef = tr.viewDef;
+	bool		removeSurfs;
+	int			i, j;
 
-				// this is needed so aimed particles can calculate origins at different times
-				g.originalRandom = g.random;
+	if ( !viewDef->parallelDeforms ) {
+		return;
+	}
+	viewDef->parallelDeforms = false;
 
-				g.age = g.frac * stage->particleLife;
+	if ( viewDef->numDeformJobs == 0 ) {
+		return;
+	}
 
-				// if the particle doesn't get drawn because it is faded out or beyond a kill region,
-				// don't increment the verts
-				tri->numVerts += stage->CreateParticle( &g, tri->verts + tri->numVerts );
-			}
-	
-			if ( tri->numVerts > 0 ) {
-				// build the index list
-				int	indexes = 0;
-				for ( int i = 0 ; i < tri->numVerts ; i += 4 ) {
-					tri->indexes[indexes+0] = i;
-					tri->indexes[indexes+1] = i+2;
-					tri->indexes[indexes+2] = i+3;
-					tri->indexes[indexes+3] = i;
-					tri->indexes[indexes+4] = i+3;
-					tri->indexes[indexes+5] = i+1;
-					indexes += 6;
-				}
-				tri->numIndexes = indexes;
+	tr.frontEndJobs->Clear();
+	for ( i = 0 ; i < viewDef->numDeformJobs ; i++ ) {
+		tr.frontEndJobs->AddJob( (jobRun_t)R_DeformJob, &viewDef->deformJobs[i] );
+	}
+	tr.frontEndJobs->Submit();
+	tr.frontEndJobs->Wait();
+
+	removeSurfs = false;
+	for ( i = 0 ; i < viewDef->numDeformJobs ; i++ ) {
+		deformJob_t *job = &viewDef->deformJobs[i];
+		srfTriangles_t *tri = job->newTri;
+
+		if ( job->stage ) {
+			// the ring buffer was full
+			if ( tri->numVerts > 0 && !tri->ambientCache ) {
 				tri->ambientCache = vertexCache.AllocFrameTemp( tri->verts, tri->numVerts * sizeof( idDrawVert ) );
-				if ( tri->ambientCache ) {
-					// add the drawsurf
-					R_AddDrawSurf( tri, surf->space, renderEntity, stage->material, surf->scissorRect );
-				}
 			}
+			if ( tri->numVerts == 0 || !tri->ambientCache ) {
+				job->surf->geo = NULL;
+				removeSurfs = true;
+			}
+			continue;
+		}
+
+		if ( !tri ) {
+			continue;
+		}
+		if ( !tri->ambientCache ) {
+			tri->ambientCache = vertexCache.AllocFrameTemp( job->verts, tri->numVerts * sizeof( idDrawVert ) );
+		}
+		// if we are out of vertex cache, leave it the way it is
+		if ( tri->ambientCache ) {
+			job->surf->geo = tri;
 		}
 	}
-}
 
-//========================================================================================
+	// remove the drawSurfs of the particle stages without visible particles
+	if ( removeSurfs ) {
+		for ( i = j = 0 ; i < viewDef->numDrawSurfs ; i++ ) {
+			if ( viewDef->drawSurfs[i]->geo ) {
+				viewDef->drawSurfs[j++] = viewDef->drawSurfs[i];
+			}
+		}
+		viewDef->numDrawSurfs = j;
+	}
+
+	viewDef->numDeformJobs = 0;
+}
 
 /*
 =================
@@ -1226,6 +1556,8 @@ R_DeformDrawSurf
 =================
 */
 void R_DeformDrawSurf( drawSurf_t *drawSurf ) {
+	deformJob_t	job;
+
 	if ( !drawSurf->material ) {
 		return;
 	}
@@ -1233,35 +1565,47 @@ void R_DeformDrawSurf( drawSurf_t *drawSurf ) {
 	if ( r_skipDeforms.GetBool() ) {
 		return;
 	}
+
+	if ( drawSurf->material->Deform() == DFRM_NONE ) {
+		return;
+	}
+
+	if ( tr.viewDef->parallelDeforms && R_QueueDeform( drawSurf ) ) {
+		return;
+	}
+
+	memset( &job, 0, sizeof( job ) );
+	job.surf = drawSurf;
+
 	switch ( drawSurf->material->Deform() ) {
 	case DFRM_NONE:
 		return;
 	case DFRM_SPRITE:
-		R_AutospriteDeform( drawSurf );
+		R_AutospriteDeform( &job );
 		break;
 	case DFRM_TUBE:
-		R_TubeDeform( drawSurf );
+		R_TubeDeform( &job );
 		break;
 	case DFRM_FLARE:
-		R_FlareDeform( drawSurf );
+		R_FlareDeform( &job );
 		break;
 	case DFRM_EXPAND:
-		R_ExpandDeform( drawSurf );
+		R_ExpandDeform( &job );
 		break;
 	case DFRM_MOVE:
-		R_MoveDeform( drawSurf );
+		R_MoveDeform( &job );
 		break;
 	case DFRM_TURB:
-		R_TurbulentDeform( drawSurf );
+		R_TurbulentDeform( &job );
 		break;
 	case DFRM_EYEBALL:
-		R_EyeballDeform( drawSurf );
+		R_EyeballDeform( &job );
 		break;
 	case DFRM_PARTICLE:
-		R_ParticleDeform( drawSurf, true );
+		R_ParticleDeform( drawSurf, true, false );
 		break;
 	case DFRM_PARTICLE2:
-		R_ParticleDeform( drawSurf, false );
+		R_ParticleDeform( drawSurf, false, false );
 		break;
 	}
 }
@@ -30,6 +30,7 @@ If you have questions concerning this license or the applicable additional terms
 #pragma hdrstop
 
 #include "tr_local.h"
+#include "Model_local.h"
 
 static const float CHECK_BOUNDS_EPSILON = 1.0f;
 
@@ -198,7 +199,13 @@ void R_SkyboxTexGen( drawSurf_t *surf, const idVec3 &viewOrg ) {
 
 	int numVerts = surf->geo->numVerts;
 	int size = numVerts * sizeof( idVec3 );
-	idVec3 *texCoords = (idVec3 *) _alloca16( size );
+
+	// write straight to the mapped vertex ring if possible
+	idVec3 *texCoords;
+	surf->dynamicTexCoords = vertexCache.AllocFrameTempMapped( size, (void **)&texCoords );
+	if ( !surf->dynamicTexCoords ) {
+		texCoords = (idVec3 *) _alloca16( size );
+	}
 
 	const idDrawVert *verts = surf->geo->verts;
 	for ( i = 0; i < numVerts; i++ ) {
@@ -207,7 +214,9 @@ void R_SkyboxTexGen( drawSurf_t *surf, const idVec3 &viewOrg ) {
 		texCoords[i][2] = verts[i].xyz[2] - localViewOrigin[2];
 	}
 
-	surf->dynamicTexCoords = vertexCache.AllocFrameTemp( texCoords, size );
+	if ( !surf->dynamicTexCoords ) {
+		surf->dynamicTexCoords = vertexCache.AllocFrameTemp( texCoords, size );
+	}
 }
 
 /*
@@ -276,7 +285,13 @@ void R_WobbleskyTexGen( drawSurf_t *surf, const idVec3 &viewOrg ) {
 
 	int numVerts = surf->geo->numVerts;
 	int size = numVerts * sizeof( idVec3 );
-	idVec3 *texCoords = (idVec3 *) _alloca16( size );
+
+	// write straight to the mapped vertex ring if possible
+	idVec3 *texCoords;
+	surf->dynamicTexCoords = vertexCache.AllocFrameTempMapped( size, (void **)&texCoords );
+	if ( !surf->dynamicTexCoords ) {
+		texCoords = (idVec3 *) _alloca16( size );
+	}
 
 	const idDrawVert *verts = surf->geo->verts;
 	for ( i = 0; i < numVerts; i++ ) {
@@ -289,7 +304,9 @@ void R_WobbleskyTexGen( drawSurf_t *surf, const idVec3 &viewOrg ) {
 		R_LocalPointToGlobal( transform, v, texCoords[i] );
 	}
 
-	surf->dynamicTexCoords = vertexCache.AllocFrameTemp( texCoords, size );
+	if ( !surf->dynamicTexCoords ) {
+		surf->dynamicTexCoords = vertexCache.AllocFrameTemp( texCoords, size );
+	}
 }
 
 //=======================================================================================================
@@ -467,39 +484,22 @@ Both shadow and light surfaces have been generated.  Either or both surfaces may
 =================
 */
 void idRenderWorldLocal::CreateLightDefInteractions( idRenderLightLocal *ldef ) {
-	areaReference_t		*eref;
 	areaReference_t		*lref;
+	areaReference_t		**erefs;
 	idRenderEntityLocal		*edef;
-	portalArea_t	*area;
-	idInteraction	*inter;
+	int					i, numRefs, maxRefs;
 
+	maxRefs = 0;
 	for ( lref = ldef->references ; lref ; lref = lref->ownerNext ) {
-		area = lref->area;
+		maxRefs = Max( maxRefs, lref->area->entityTree.NumProxies() );
+	}
+	erefs = (areaReference_t **)_alloca16( maxRefs * sizeof( erefs[0] ) );
 
+	for ( lref = ldef->references ; lref ; lref = lref->ownerNext ) {
 		// check all the models in this area
-		for ( eref = area->entityRefs.areaNext ; eref != &area->entityRefs ; eref = eref->areaNext ) {
-			edef = eref->entity;
-
-			// if the entity doesn't have any light-interacting surfaces, we could skip this,
-			// but we don't want to instantiate dynamic models yet, so we can't check that on
-			// most things
-
-			// if the entity isn't viewed
-			if ( tr.viewDef && edef->viewCount != tr.viewCount ) {
-				// if the light doesn't cast shadows, skip
-				if ( !ldef->lightShader->LightCastsShadows() ) {
-					continue;
-				}
-				// if we are suppressing its shadow in this view, skip
-				if ( !r_skipSuppress.GetBool() ) {
-					if ( edef->parms.suppressShadowInViewID && edef->parms.suppressShadowInViewID == tr.viewDef->renderView.viewID ) {
-						continue;
-					}
-					if ( edef->parms.suppressShadowInLightID && edef->parms.suppressShadowInLightID == ldef->parms.lightId ) {
-						continue;
-					}
-				}
-			}
+		numRefs = FindLightAreaEntityRefs( ldef, lref->area, erefs );
+		for ( i = 0 ; i < numRefs ; i++ ) {
+			edef = erefs[i]->entity;
 
 			// some big outdoor meshes are flagged to not create any dynamic interactions
 			// when the level designer knows that nearby moving lights shouldn't actually hit them
@@ -507,73 +507,199 @@ void idRenderWorldLocal::CreateLightDefInteractions( idRenderLightLocal *ldef )
 				continue;
 			}
 
-			// if any of the edef's interaction match this light, we don't
-			// need to consider it. 
-			if ( r_useInteractionTable.GetBool() && this->interactionTable ) {
-				// allocating these tables may take several megs on big maps, but it saves 3% to 5% of
-				// the CPU time.  The table is updated at interaction::AllocAndLink() and interaction::UnlinkAndFree()
-				int index = ldef->index * this->interactionTableWidth + edef->index;
-				inter = this->interactionTable[ index ];
-				if ( inter ) {
-					// if this entity wasn't in view already, the scissor rect will be empty,
-					// so it will only be used for shadow casting
-					if ( !inter->IsEmpty() ) {
-						R_SetEntityDefViewEntity( edef );
-					}
-					continue;
-				}
-			} else {
-				// scan the doubly linked lists, which may have several dozen entries
+			CreateLightDefInteraction( ldef, edef, NULL );
+		}
+	}
+}
 
-				// we could check either model refs or light refs for matches, but it is
-				// assumed that there will be less lights in an area than models
-				// so the entity chains should be somewhat shorter (they tend to be fairly close).
-				for ( inter = edef->firstInteraction; inter != NULL; inter = inter->entityNext ) {
-					if ( inter->lightDef == ldef ) {
-						break;
-					}
-				}
+/*
+=================
+idRenderWorldLocal::FindLightAreaEntityRefs
 
-				// if we already have an interaction, we don't need to do anything
-				if ( inter != NULL ) {
-					// if this entity wasn't in view already, the scissor rect will be empty,
-					// so it will only be used for shadow casting
-					if ( !inter->IsEmpty() ) {
-						R_SetEntityDefViewEntity( edef );
-					}
-					continue;
-				}
-			}
+Gathers the entityRefs of an area that may touch the light frustum, the
+entities outside it would only get empty interactions.  The refs must
+have room for all the entityRefs of the area.
+=================
+*/
+int idRenderWorldLocal::FindLightAreaEntityRefs( const idRenderLightLocal *ldef, const portalArea_t *area, areaReference_t **refs ) const {
+	areaReference_t	*eref;
+	int				numRefs;
 
-			//
-			// create a new interaction, but don't do any work other than bbox to frustum culling
-			//
-			idInteraction *inter = idInteraction::AllocAndLink( edef, ldef );
+	if ( r_useAreaTrees.GetBool() ) {
+		return area->entityTree.ProxiesTouchingPlanes( ldef->frustum, 6, (void **)refs, area->entityTree.NumProxies() );
+	}
 
-			// do a check of the entity reference bounds against the light frustum,
-			// trying to avoid creating a viewEntity if it hasn't been already
-			idMat4 modelMatrix;
-			idMat4* m;
+	numRefs = 0;
+	for ( eref = area->entityRefs.areaNext ; eref != &area->entityRefs ; eref = eref->areaNext ) {
+		refs[numRefs++] = eref;
+	}
+	return numRefs;
+}
 
-			if ( edef->viewCount == tr.viewCount ) {
-				m = &(edef->viewEntity->modelMatrix);
-			} else {
-				R_AxisToModelMatrix( edef->parms.axis, edef->parms.origin, modelMatrix.ToFloatPtr() );
-				m = &modelMatrix;
-			}
+/*
+=================
+idRenderWorldLocal::FindLightDefInteractions
+
+Gathers the entities in the areas of the light, in the order CreateLightDefInteractions
+would visit them, together with their current interaction with the light.
+
+Nothing is changed, so the front end can do this for all view lights in parallel
+and pass the result to CreateLightDefInteractions afterwards.
+=================
+*/
+int idRenderWorldLocal::FindLightDefInteractions( const idRenderLightLocal *ldef, lightEntityRef_t **refs ) const {
+	const areaReference_t	*lref;
+	areaReference_t			**erefs;
+	idRenderEntityLocal		*edef;
+	int						i, numRefs, numAreaRefs, maxRefs, maxAreaRefs;
+
+	maxRefs = 0;
+	maxAreaRefs = 0;
+	for ( lref = ldef->references ; lref ; lref = lref->ownerNext ) {
+		maxRefs += lref->area->entityTree.NumProxies();
+		maxAreaRefs = Max( maxAreaRefs, lref->area->entityTree.NumProxies() );
+	}
+
+	*refs = (lightEntityRef_t *)R_FrameAlloc( maxRefs * sizeof( **refs ) );
+	erefs = (areaReference_t **)R_FrameAlloc( maxAreaRefs * sizeof( erefs[0] ) );
+
+	numRefs = 0;
+	for ( lref = ldef->references ; lref ; lref = lref->ownerNext ) {
+		numAreaRefs = FindLightAreaEntityRefs( ldef, lref->area, erefs );
+		for ( i = 0 ; i < numAreaRefs ; i++ ) {
+			edef = erefs[i]->entity;
 
-			if ( R_CullLocalBox( edef->referenceBounds, m->ToFloatPtr(), 6, ldef->frustum ) ) {
-				inter->MakeEmpty();
+			if ( edef->parms.noDynamicInteractions && edef->world->generateAllInteractionsCalled ) {
 				continue;
 			}
 
-			// we will do a more precise per-surface check when we are checking the entity
+			(*refs)[numRefs].entityDef = edef;
+			(*refs)[numRefs].inter = FindInteraction( edef, ldef );
+			numRefs++;
+		}
+	}
+
+	return numRefs;
+}
+
+/*
+=================
+idRenderWorldLocal::CreateLightDefInteractions
+
+Same as the version above, for entities gathered earlier by FindLightDefInteractions
+=================
+*/
+void idRenderWorldLocal::CreateLightDefInteractions( idRenderLightLocal *ldef, const lightEntityRef_t *refs, int numRefs ) {
+	for ( int i = 0 ; i < numRefs ; i++ ) {
+		CreateLightDefInteraction( ldef, refs[i].entityDef, refs[i].inter );
+	}
+}
+
+/*
+=================
+idRenderWorldLocal::CreateLightDefInteraction
+
+Makes sure there is an interaction between the light and an entity in one of its
+areas, and adds a viewEntity for the entity if the interaction isn't empty.
+
+If inter is NULL it is looked up again, an entity that touches several areas of the
+light is visited more than once and may already have been given an interaction.
+=================
+*/
+void idRenderWorldLocal::CreateLightDefInteraction( idRenderLightLocal *ldef, idRenderEntityLocal *edef, idInteraction *inter ) {
+	// if the entity doesn't have any light-interacting surfaces, we could skip this,
+	// but we don't want to instantiate dynamic models yet, so we can't check that on
+	// most things
+
+	// if the entity isn't viewed
+	if ( tr.viewDef && edef->viewCount != tr.viewCount ) {
+		// if the light doesn't cast shadows, skip
+		if ( !ldef->lightShader->LightCastsShadows() ) {
+			return;
+		}
+		// if we are suppressing its shadow in this view, skip
+		if ( !r_skipSuppress.GetBool() ) {
+			if ( edef->parms.suppressShadowInViewID && edef->parms.suppressShadowInViewID == tr.viewDef->renderView.viewID ) {
+				return;
+			}
+			if ( edef->parms.suppressShadowInLightID && edef->parms.suppressShadowInLightID == ldef->parms.lightId ) {
+				return;
+			}
+		}
+	}
+
+	// if any of the edef's interaction match this light, we don't
+	// need to consider it. 
+	if ( inter == NULL ) {
+		inter = FindInteraction( edef, ldef );
+	}
 
-			// if this entity wasn't in view already, the scissor rect will be empty,
-			// so it will only be used for shadow casting
+	// if we already have an interaction, we don't need to do anything
+	if ( inter != NULL ) {
+		// if this entity wasn't in view already, the scissor rect will be empty,
+		// so it will only be used for shadow casting
+		if ( !inter->IsEmpty() ) {
 			R_SetEntityDefViewEntity( edef );
 		}
+		return;
+	}
+
+	//
+	// create a new interaction, but don't do any work other than bbox to frustum culling
+	//
+	inter = idInteraction::AllocAndLink( edef, ldef );
+
+	// do a check of the entity reference bounds against the light frustum,
+	// trying to avoid creating a viewEntity if it hasn't been already
+	idMat4 modelMatrix;
+	idMat4* m;
+
+	if ( edef->viewCount == tr.viewCount ) {
+		m = &(edef->viewEntity->modelMatrix);
+	} else {
+		R_AxisToModelMatrix( edef->parms.axis, edef->parms.origin, modelMatrix.ToFloatPtr() );
+		m = &modelMatrix;
+	}
+
+	if ( R_CullLocalBox( edef->referenceBounds, m->ToFloatPtr(), 6, ldef->frustum ) ) {
+		inter->MakeEmpty();
+		return;
 	}
+
+	// we will do a more precise per-surface check when we are checking the entity
+
+	// if this entity wasn't in view already, the scissor rect will be empty,
+	// so it will only be used for shadow casting
+	R_SetEntityDefViewEntity( edef );
+}
+
+/*
+=================
+idRenderWorldLocal::FindInteraction
+=================
+*/
+idInteraction *idRenderWorldLocal::FindInteraction( const idRenderEntityLocal *edef, const idRenderLightLocal *ldef ) const {
+	idInteraction	*inter;
+
+	if ( r_useInteractionTable.GetBool() && this->interactionTable ) {
+		// allocating these tables may take several megs on big maps, but it saves 3% to 5% of
+		// the CPU time.  The table is updated at interaction::AllocAndLink() and interaction::UnlinkAndFree()
+		int index = ldef->index * this->interactionTableWidth + edef->index;
+		return this->interactionTable[ index ];
+	}
+
+	// scan the doubly linked lists, which may have several dozen entries
+
+	// we could check either model refs or light refs for matches, but it is
+	// assumed that there will be less lights in an area than models
+	// so the entity chains should be somewhat shorter (they tend to be fairly close).
+	for ( inter = edef->firstInteraction; inter != NULL; inter = inter->entityNext ) {
+		if ( inter->lightDef == ldef ) {
+			break;
+		}
+	}
+
+	return inter;
 }
 
 //===============================================================================================================
@@ -773,6 +899,141 @@ idScreenRect	R_CalcLightScissorRectangle( viewLight_t *vLight ) {
 	return r;
 }
 
+/*
+=================
+R_UseParallelFrontEnd
+
+Debugging options that draw or print from inside the culling,
+or count through the shared performance counters, fall back to
+the serial path.
+=================
+*/
+static bool R_UseParallelFrontEnd( void ) {
+	if ( !r_useParallelFrontEnd.GetBool() || parallelJobManager->GetNumThreads() == 0 ) {
+		return false;
+	}
+	if ( r_showLightScissors.GetBool() || r_showEntityScissors.GetBool() || r_showInteractionScissors.GetInteger()
+		|| r_showInteractionFrustums.GetInteger() || r_checkBounds.GetBool() || r_showCull.GetBool() ) {
+		return false;
+	}
+	// the shadow bounds code behind the negative scissor modes fills its
+	// function static lookup tables on first use, which isn't thread safe
+	if ( r_useInteractionScissors.GetInteger() < 0 ) {
+		return false;
+	}
+	// the override material is looked up by name
+	if ( r_materialOverride.GetString()[0] != '\0' ) {
+		return false;
+	}
+	return true;
+}
+
+typedef struct {
+	viewLight_t *			vLight;
+	bool					removed;			// suppressed in this view, or doesn't add any light
+	int						numEntityRefs;
+	lightEntityRef_t *		entityRefs;
+} viewLightJob_t;
+
+/*
+=================
+R_PrepareViewLight
+
+Evaluates the light shader and scissor, and gathers the entities the light may
+interact with.  Only the viewLight itself is changed, so this runs as a front end job.
+=================
+*/
+static void R_PrepareViewLight( viewLightJob_t *job ) {
+	viewLight_t			*vLight = job->vLight;
+	idRenderLightLocal	*light = vLight->lightDef;
+	const idMaterial	*lightShader = light->lightShader;
+
+	job->removed = true;
+	job->numEntityRefs = 0;
+	job->entityRefs = NULL;
+
+	// see if we are suppressing the light in this view
+	if ( !r_skipSuppress.GetBool() ) {
+		if ( light->parms.suppressLightInViewID
+		&& light->parms.suppressLightInViewID == tr.viewDef->renderView.viewID ) {
+			return;
+		}
+		if ( light->parms.allowLightInViewID 
+		&& light->parms.allowLightInViewID != tr.viewDef->renderView.viewID ) {
+			return;
+		}
+	}
+
+	// evaluate the light shader registers
+	float *lightRegs =(float *)R_FrameAlloc( lightShader->GetNumRegisters() * sizeof( float ) );
+	vLight->shaderRegisters = lightRegs;
+	lightShader->EvaluateRegisters( lightRegs, light->parms.shaderParms, tr.viewDef, light->parms.referenceSound );
+
+	// if this is a purely additive light and no stage in the light shader evaluates
+	// to a positive light value, we can completely skip the light
+	if ( !lightShader->IsFogLight() && !lightShader->IsBlendLight() ) {
+		int lightStageNum;
+		for ( lightStageNum = 0 ; lightStageNum < lightShader->GetNumStages() ; lightStageNum++ ) {
+			const shaderStage_t	*lightStage = lightShader->GetStage( lightStageNum );
+
+			// ignore stages that fail the condition
+			if ( !lightRegs[ lightStage->conditionRegister ] ) {
+				continue;
+			}
+
+			const int *registers = lightStage->color.registers;
+
+			// snap tiny values to zero to avoid lights showing up with the wrong color
+			if ( lightRegs[ registers[0] ] < 0.001f ) {
+				lightRegs[ registers[0] ] = 0.0f;
+			}
+			if ( lightRegs[ registers[1] ] < 0.001f ) {
+				lightRegs[ registers[1] ] = 0.0f;
+			}
+			if ( lightRegs[ registers[2] ] < 0.001f ) {
+				lightRegs[ registers[2] ] = 0.0f;
+			}
+
+			// FIXME:	when using the following values the light shows up bright red when using nvidia drivers/hardware
+			//			this seems to have been fixed ?
+			//lightRegs[ registers[0] ] = 1.5143074e-005f;
+			//lightRegs[ registers[1] ] = 1.5483369e-005f;
+			//lightRegs[ registers[2] ] = 1.7014690e-005f;
+
+			if ( lightRegs[ registers[0] ] > 0.0f ||
+					lightRegs[ registers[1] ] > 0.0f ||
+						lightRegs[ registers[2] ] > 0.0f ) {
+				break;
+			}
+		}
+		if ( lightStageNum == lightShader->GetNumStages() ) {
+			// we went through all the stages and didn't find one that adds anything
+			return;
+		}
+	}
+
+	if ( r_useLightScissors.GetBool() ) {
+		// calculate the screen area covered by the light frustum
+		// which will be used to crop the stencil cull
+		idScreenRect scissorRect = R_CalcLightScissorRectangle( vLight );
+		// intersect with the portal crossing scissor rectangle
+		vLight->scissorRect.Intersect( scissorRect );
+	}
+
+#if 0
+	// this never happens, because CullLightByPortals() does a more precise job
+	if ( vLight->scissorRect.IsEmpty() ) {
+		// this light doesn't touch anything on screen, so remove it from the list
+		return;
+	}
+#endif
+
+	job->removed = false;
+
+	// find the entities the light may touch, the interactions are created on the main thread
+	job->numEntityRefs = tr.viewDef->renderWorld->FindLightDefInteractions( light, &job->entityRefs );
+}
+
 /*
 =================
 R_AddLightSurfaces
@@ -789,113 +1050,71 @@ turned off, or completely off screen.
 
 Create any new interactions needed between the viewLights
 and the viewEntitys due to game movement
+
+The light shaders, scissors and interaction lookups are evaluated
+with parallel jobs if r_useParallelFrontEnd is set, everything else
+is done in the order of the viewLight list.
 =================
 */
 void R_AddLightSurfaces( void ) {
 	viewLight_t		*vLight;
 	idRenderLightLocal *light;
 	viewLight_t		**ptr;
+	viewLightJob_t	*jobs;
+	int				numLights;
+	bool			parallel;
 
-	// go through each visible light, possibly removing some from the list
-	ptr = &tr.viewDef->viewLights;
-	while ( *ptr ) {
-		vLight = *ptr;
-		light = vLight->lightDef;
-
-		const idMaterial	*lightShader = light->lightShader;
-		if ( !lightShader ) {
+	numLights = 0;
+	for ( vLight = tr.viewDef->viewLights ; vLight ; vLight = vLight->next ) {
+		if ( !vLight->lightDef->lightShader ) {
 			common->Error( "R_AddLightSurfaces: NULL lightShader" );
 		}
+		numLights++;
+	}
 
-		// see if we are suppressing the light in this view
-		if ( !r_skipSuppress.GetBool() ) {
-			if ( light->parms.suppressLightInViewID
-			&& light->parms.suppressLightInViewID == tr.viewDef->renderView.viewID ) {
-				*ptr = vLight->next;
-				light->viewCount = -1;
-				continue;
-			}
-			if ( light->parms.allowLightInViewID 
-			&& light->parms.allowLightInViewID != tr.viewDef->renderView.viewID ) {
-				*ptr = vLight->next;
-				light->viewCount = -1;
-				continue;
-			}
-		}
-
-		// evaluate the light shader registers
-		float *lightRegs =(float *)R_FrameAlloc( lightShader->GetNumRegisters() * sizeof( float ) );
-		vLight->shaderRegisters = lightRegs;
-		lightShader->EvaluateRegisters( lightRegs, light->parms.shaderParms, tr.viewDef, light->parms.referenceSound );
-
-		// if this is a purely additive light and no stage in the light shader evaluates
-		// to a positive light value, we can completely skip the light
-		if ( !lightShader->IsFogLight() && !lightShader->IsBlendLight() ) {
-			int lightStageNum;
-			for ( lightStageNum = 0 ; lightStageNum < lightShader->GetNumStages() ; lightStageNum++ ) {
-				const shaderStage_t	*lightStage = lightShader->GetStage( lightStageNum );
+	jobs = (viewLightJob_t *)R_FrameAlloc( numLights * sizeof( jobs[0] ) );
 
-				// ignore stages that fail the condition
-				if ( !lightRegs[ lightStage->conditionRegister ] ) {
-					continue;
-				}
+	numLights = 0;
+	for ( vLight = tr.viewDef->viewLights ; vLight ; vLight = vLight->next ) {
+		jobs[numLights++].vLight = vLight;
+	}
 
-				const int *registers = lightStage->color.registers;
+	parallel = R_UseParallelFrontEnd();
+	if ( parallel ) {
+		tr.frontEndJobs->Clear();
+		for ( int i = 0 ; i < numLights ; i++ ) {
+			tr.frontEndJobs->AddJob( (jobRun_t)R_PrepareViewLight, &jobs[i] );
+		}
+		tr.frontEndJobs->Submit();
+		tr.frontEndJobs->Wait();
+	}
 
-				// snap tiny values to zero to avoid lights showing up with the wrong color
-				if ( lightRegs[ registers[0] ] < 0.001f ) {
-					lightRegs[ registers[0] ] = 0.0f;
-				}
-				if ( lightRegs[ registers[1] ] < 0.001f ) {
-					lightRegs[ registers[1] ] = 0.0f;
-				}
-				if ( lightRegs[ registers[2] ] < 0.001f ) {
-					lightRegs[ registers[2] ] = 0.0f;
-				}
+	// go through each visible light, possibly removing some from the list
+	ptr = &tr.viewDef->viewLights;
+	for ( int i = 0 ; i < numLights ; i++ ) {
+		viewLightJob_t *job = &jobs[i];
 
-				// FIXME:	when using the following values the light shows up bright red when using nvidia drivers/hardware
-				//			this seems to have been fixed ?
-				//lightRegs[ registers[0] ] = 1.5143074e-005f;
-				//lightRegs[ registers[1] ] = 1.5483369e-005f;
-				//lightRegs[ registers[2] ] = 1.7014690e-005f;
+		vLight = job->vLight;
+		light = vLight->lightDef;
 
-				if ( lightRegs[ registers[0] ] > 0.0f ||
-						lightRegs[ registers[1] ] > 0.0f ||
-							lightRegs[ registers[2] ] > 0.0f ) {
-					break;
-				}
-			}
-			if ( lightStageNum == lightShader->GetNumStages() ) {
-				// we went through all the stages and didn't find one that adds anything
-				// remove the light from the viewLights list, and change its frame marker
-				// so interaction generation doesn't think the light is visible and
-				// create a shadow for it
-				*ptr = vLight->next;
-				light->viewCount = -1;
-				continue;
-			}
+		if ( !parallel ) {
+			R_PrepareViewLight( job );
 		}
 
-		if ( r_useLightScissors.GetBool() ) {
-			// calculate the screen area covered by the light frustum
-			// which will be used to crop the stencil cull
-			idScreenRect scissorRect = R_CalcLightScissorRectangle( vLight );
-			// intersect with the portal crossing scissor rectangle
-			vLight->scissorRect.Intersect( scissorRect );
-
-			if ( r_showLightScissors.GetBool() ) {
-				R_ShowColoredScreenRect( vLight->scissorRect, light->index );
-			}
-		}
+		const idMaterial	*lightShader = light->lightShader;
 
-#if 0
-		// this never happens, because CullLightByPortals() does a more precise job
-		if ( vLight->scissorRect.IsEmpty() ) {
-			// this light doesn't touch anything on screen, so remove it from the list
+		if ( job->removed ) {
+			// remove the light from the viewLights list, and change its frame marker
+			// so interaction generation doesn't think the light is visible and
+			// create a shadow for it
 			*ptr = vLight->next;
+			light->viewCount = -1;
 			continue;
 		}
-#endif
+
+		if ( r_useLightScissors.GetBool() && r_showLightScissors.GetBool() ) {
+			R_ShowColoredScreenRect( vLight->scissorRect, light->index );
+		}
 
 		// this one stays on the list
 		ptr = &vLight->next;
@@ -903,15 +1122,18 @@ void R_AddLightSurfaces( void ) {
 		// if we are doing a soft-shadow novelty test, regenerate the light with
 		// a random offset every time
 		if ( r_lightSourceRadius.GetFloat() != 0.0f ) {
-			for ( int i = 0 ; i < 3 ; i++ ) {
-				light->globalLightOrigin[i] += r_lightSourceRadius.GetFloat() * ( -1 + 2 * (rand()&0xfff)/(float)0xfff );
+			for ( int j = 0 ; j < 3 ; j++ ) {
+				light->globalLightOrigin[j] += r_lightSourceRadius.GetFloat() * ( -1 + 2 * (rand()&0xfff)/(float)0xfff );
 			}
 		}
 
+		// shadow mapped lights link their casters instead of shadow volumes
+		R_SetupShadowMapViews( vLight );
+
 		// create interactions with all entities the light may touch, and add viewEntities
 		// that may cast shadows, even if they aren't directly visible.  Any real work
 		// will be deferred until we walk through the viewEntities
-		tr.viewDef->renderWorld->CreateLightDefInteractions( light );
+		tr.viewDef->renderWorld->CreateLightDefInteractions( light, job->entityRefs, job->numEntityRefs );
 		tr.pc.c_viewLights++;
 
 		// fog lights will need to draw the light frustum triangles, so make sure they
@@ -928,7 +1150,7 @@ void R_AddLightSurfaces( void ) {
 		}
 
 		// add the prelight shadows for the static world geometry
-		if ( light->parms.prelightModel && r_useOptimizedShadows.GetBool() ) {
+		if ( light->parms.prelightModel && r_useOptimizedShadows.GetBool() && !R_LightUsesShadowMap( light ) ) {
 
 			if ( !light->parms.prelightModel->NumSurfaces() ) {
 				common->Error( "no surfs in prelight model '%s'", light->parms.prelightModel->Name() );
@@ -967,6 +1189,9 @@ void R_AddLightSurfaces( void ) {
 			R_LinkLightSurf( &vLight->globalShadows, tri, NULL, light, NULL, vLight->scissorRect, true /* FIXME? */ );
 		}
 	}
+
+	// place the shadow maps of the remaining lights
+	R_AllocShadowMapAtlas();
 }
 
 //===============================================================================================================
@@ -1094,13 +1319,65 @@ idRenderModel *R_EntityDefDynamicModel( idRenderEntityLocal *def ) {
 	return def->dynamicModel;
 }
 
+/*
+=================
+R_StreamSurfaceImages
+
+Tells the streamed images of the surface's material how many pixels the
+surface covers, estimated from its bounding sphere
+=================
+*/
+static void R_StreamSurfaceImages( const drawSurf_t *drawSurf ) {
+	if ( !globalImages->image_useCache.GetBool() || !drawSurf->geo ) {
+		return;
+	}
+
+	const idMaterial *shader = drawSurf->material;
+	float pixels;
+
+	if ( tr.viewDef->projectionMatrix.At( 15 ) != 0.0f ) {
+		// 2D views draw at full size
+		pixels = idMath::INFINITY;
+	} else {
+		idVec3	center;
+		float	radius = drawSurf->geo->bounds.GetRadius( drawSurf->geo->bounds.GetCenter() );
+
+		R_LocalPointToGlobal( drawSurf->space->modelMatrix.ToFloatPtr(), drawSurf->geo->bounds.GetCenter(), center );
+		float dist = ( center - tr.viewDef->renderView.vieworg ).Length();
+
+		if ( dist <= radius ) {
+			pixels = idMath::INFINITY;
+		} else {
+			pixels = radius / dist * ( tr.viewDef->viewport.x2 - tr.viewDef->viewport.x1 + 1 ) * tr.viewDef->projectionMatrix.At( 0 );
+		}
+	}
+
+	for ( int i = 0 ; i < shader->GetNumStages() ; i++ ) {
+		const shaderStage_t *stage = shader->GetStage( i );
+
+		if ( stage->texture.image ) {
+			stage->texture.image->StreamForScreenSize( pixels );
+		}
+		if ( stage->newStage ) {
+			for ( int j = 0 ; j < stage->newStage->numFragmentProgramImages ; j++ ) {
+				if ( stage->newStage->fragmentProgramImages[j] ) {
+					stage->newStage->fragmentProgramImages[j]->StreamForScreenSize( pixels );
+				}
+			}
+		}
+	}
+}
+
 /*
 =================
 R_AddDrawSurf
+
+shaderRegisters can be passed in if they have already been
+evaluated by a front end job.
 =================
 */
 void R_AddDrawSurf( const srfTriangles_t *tri, const viewEntity_t *space, const renderEntity_t *renderEntity,
-					const idMaterial *shader, const idScreenRect &scissor ) {
+					const idMaterial *shader, const idScreenRect &scissor, const float *shaderRegisters ) {
 	drawSurf_t		*drawSurf;
 	const float		*shaderParms;
 	static float	refRegs[MAX_EXPRESSION_REGISTERS];	// don't put on stack, or VC++ will do a page touch
@@ -1138,7 +1415,10 @@ void R_AddDrawSurf( const srfTriangles_t *tri, const viewEntity_t *space, const
 
 	// process the shader expressions for conditionals / color / texcoords
 	const float	*constRegs = shader->ConstantRegisters();
-	if ( constRegs ) {
+	if ( shaderRegisters ) {
+		// already evaluated
+		drawSurf->shaderRegisters = shaderRegisters;
+	} else if ( constRegs ) {
 		// shader only uses constant values
 		drawSurf->shaderRegisters = constRegs;
 	} else {
@@ -1189,6 +1469,9 @@ void R_AddDrawSurf( const srfTriangles_t *tri, const viewEntity_t *space, const
 	// check for deformations
 	R_DeformDrawSurf( drawSurf );
 
+	// let streamed images know how large they are on screen
+	R_StreamSurfaceImages( drawSurf );
+
 	// skybox surfaces need a dynamic texgen
 	switch( shader->Texgen() ) {
 		case TG_SKYBOX_CUBE:
@@ -1242,22 +1525,100 @@ void R_AddDrawSurf( const srfTriangles_t *tri, const viewEntity_t *space, const
 	// adds for this view
 }
 
+typedef struct {
+	srfTriangles_t *		tri;
+	const idMaterial *		shader;
+	const float *			shaderRegisters;	// NULL if they have to be evaluated on the main thread
+} ambientSurfJob_t;
+
+typedef struct {
+	idInteraction *			inter;
+	bool					culled;
+	idScreenRect			shadowScissor;
+} interactionJob_t;
+
+typedef struct {
+	viewEntity_t *			vEntity;
+	bool					skipped;			// not in this view, or without a model
+	bool					visible;			// false if only casting shadows
+	int						numAmbientSurfs;
+	ambientSurfJob_t *		ambientSurfs;		// surfaces inside the view frustum
+	int						numInteractions;
+	interactionJob_t *		interactions;		// interactions with visible lights
+} viewEntityJob_t;
+
 /*
 ===============
-R_AddAmbientDrawsurfs
+R_EnterEntityTimeGroup
 
-Adds surfaces for the given viewEntity
-Walks through the viewEntitys list and creates drawSurf_t for each surface of
-each viewEntity that has a non-empty scissorRect
+Entities in a time group evaluate their shaders and models with the time of the group
+===============
+*/
+static void R_EnterEntityTimeGroup( const idRenderEntityLocal *def, float &oldFloatTime, int &oldTime ) {
+	game->SelectTimeGroup( def->parms.timeGroup );
+
+	if ( def->parms.timeGroup ) {
+		oldFloatTime = tr.viewDef->floatTime;
+		oldTime = tr.viewDef->renderView.time;
+
+		tr.viewDef->floatTime = game->GetTimeGroupTime( def->parms.timeGroup ) * 0.001;
+		tr.viewDef->renderView.time = game->GetTimeGroupTime( def->parms.timeGroup );
+	}
+}
+
+/*
+===============
+R_LeaveEntityTimeGroup
+===============
+*/
+static void R_LeaveEntityTimeGroup( const idRenderEntityLocal *def, float oldFloatTime, int oldTime ) {
+	if ( def->parms.timeGroup ) {
+		tr.viewDef->floatTime = oldFloatTime;
+		tr.viewDef->renderView.time = oldTime;
+	}
+}
+
+/*
+===============
+R_PrepareShaderRegisters
+
+Evaluates the shader registers of an ambient surface in a front end job.
+Reference shaders and time groups need state that may only be changed on
+the main thread, those are left to R_AddDrawSurf.
 ===============
 */
-static void R_AddAmbientDrawsurfs( viewEntity_t *vEntity ) {
+static const float *R_PrepareShaderRegisters( const idMaterial *shader, const viewEntity_t *space, const renderEntity_t *renderEntity ) {
+	const float	*constRegs = shader->ConstantRegisters();
+	if ( constRegs ) {
+		return constRegs;
+	}
+
+	if ( renderEntity->referenceShader || ( space->entityDef && space->entityDef->parms.timeGroup ) ) {
+		return NULL;
+	}
+
+	float *regs = (float *)R_FrameAlloc( shader->GetNumRegisters() * sizeof( float ) );
+	shader->EvaluateRegisters( regs, renderEntity->shaderParms, tr.viewDef, renderEntity->referenceSound );
+	return regs;
+}
+
+/*
+===============
+R_PrepareAmbientDrawsurfs
+
+Culls the surfaces of the viewEntity and evaluates their shader registers,
+the drawSurfs are created by R_AddAmbientDrawsurfs
+===============
+*/
+static void R_PrepareAmbientDrawsurfs( viewEntityJob_t *job ) {
 	int					i, total;
+	viewEntity_t		*vEntity;
 	idRenderEntityLocal	*def;
 	srfTriangles_t		*tri;
 	idRenderModel		*model;
 	const idMaterial	*shader;
 
+	vEntity = job->vEntity;
 	def = vEntity->entityDef;
 
 	if ( def->dynamicModel ) {
@@ -1266,8 +1627,11 @@ static void R_AddAmbientDrawsurfs( viewEntity_t *vEntity ) {
 		model = def->parms.hModel;
 	}
 
-	// add all the surfaces
 	total = model->NumSurfaces();
+	job->numAmbientSurfs = 0;
+	job->ambientSurfs = (ambientSurfJob_t *)R_FrameAlloc( total * sizeof( job->ambientSurfs[0] ) );
+
+	// add all the surfaces
 	for ( i = 0 ; i < total ; i++ ) {
 		const modelSurface_t	*surf = model->Surface( i );
 
@@ -1318,31 +1682,57 @@ static void R_AddAmbientDrawsurfs( viewEntity_t *vEntity ) {
 		}
 
 		if ( !R_CullLocalBox( tri->bounds, vEntity->modelMatrix.ToFloatPtr(), 5, tr.viewDef->frustum ) ) {
+			ambientSurfJob_t *ambientSurf = &job->ambientSurfs[job->numAmbientSurfs++];
+			ambientSurf->tri = tri;
+			ambientSurf->shader = shader;
+			ambientSurf->shaderRegisters = R_PrepareShaderRegisters( shader, vEntity, &def->parms );
+		}
+	}
+}
 
-			def->visibleCount = tr.viewCount;
+/*
+===============
+R_AddAmbientDrawsurfs
 
-			// make sure we have an ambient cache
-			if ( !R_CreateAmbientCache( tri, shader->ReceivesLighting() ) ) {
-				// don't add anything if the vertex cache was too full to give us an ambient cache
-				return;
-			}
-			// touch it so it won't get purged
-			vertexCache.Touch( tri->ambientCache );
+Adds surfaces for the given viewEntity
+Walks through the viewEntitys list and creates drawSurf_t for each surface of
+each viewEntity that has a non-empty scissorRect
+===============
+*/
+static void R_AddAmbientDrawsurfs( viewEntityJob_t *job ) {
+	viewEntity_t		*vEntity;
+	idRenderEntityLocal	*def;
 
-			if ( r_useIndexBuffers.GetBool() && !tri->indexCache ) {
-				vertexCache.Alloc( tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ), &tri->indexCache, true );
-			}
-			if ( tri->indexCache ) {
-				vertexCache.Touch( tri->indexCache );
-			}
+	vEntity = job->vEntity;
+	def = vEntity->entityDef;
+
+	for ( int i = 0 ; i < job->numAmbientSurfs ; i++ ) {
+		const ambientSurfJob_t	*ambientSurf = &job->ambientSurfs[i];
+		srfTriangles_t			*tri = ambientSurf->tri;
 
-			// add the surface for drawing
-			R_AddDrawSurf( tri, vEntity, &vEntity->entityDef->parms, shader, vEntity->scissorRect );
+		def->visibleCount = tr.viewCount;
 
-			// ambientViewCount is used to allow light interactions to be rejected
-			// if the ambient surface isn't visible at all
-			tri->ambientViewCount = tr.viewCount;
+		// make sure we have an ambient cache
+		if ( !R_CreateAmbientCache( tri, ambientSurf->shader->ReceivesLighting() ) ) {
+			// don't add anything if the vertex cache was too full to give us an ambient cache
+			return;
 		}
+		// touch it so it won't get purged
+		vertexCache.Touch( tri->ambientCache );
+
+		if ( r_useIndexBuffers.GetBool() && !tri->indexCache ) {
+			vertexCache.Alloc( tri->indexes, tri->numIndexes * sizeof( tri->indexes[0] ), &tri->indexCache, true );
+		}
+		if ( tri->indexCache ) {
+			vertexCache.Touch( tri->indexCache );
+		}
+
+		// add the surface for drawing
+		R_AddDrawSurf( tri, vEntity, &def->parms, ambientSurf->shader, vEntity->scissorRect, ambientSurf->shaderRegisters );
+
+		// ambientViewCount is used to allow light interactions to be rejected
+		// if the ambient surface isn't visible at all
+		tri->ambientViewCount = tr.viewCount;
 	}
 
 	// add the lightweight decal surfaces
@@ -1365,6 +1755,170 @@ idScreenRect R_CalcEntityScissorRectangle( viewEntity_t *vEntity ) {
 	return R_ScreenRectFromViewFrustumBounds( bounds );
 }
 
+/*
+===================
+R_EntityDefSkinMatrices
+
+The joint matrices are created for every view, because a cached snapshot
+of the dynamic model may be drawn for many frames.
+===================
+*/
+static const idJointMat *R_EntityDefSkinMatrices( const idRenderEntityLocal *def, idRenderModel *model ) {
+	for ( int i = 0 ; i < model->NumSurfaces() ; i++ ) {
+		const srfTriangles_t *tri = model->Surface( i )->geometry;
+		if ( tri && tri->jointWeightCache ) {
+			const idRenderModelMD5 *md5 = dynamic_cast<const idRenderModelMD5 *>( def->parms.hModel );
+			return md5 ? md5->CreateSkinMatrices( &def->parms ) : NULL;
+		}
+	}
+	return NULL;
+}
+
+/*
+===================
+R_InstantiateViewEntity
+
+Calculates the entity scissor and instantiates the dynamic model if the entity
+is visible.  Entity callbacks call into the game code, so this is always done
+on the main thread.
+
+Returns false if the entity doesn't need to be added to the view.
+===================
+*/
+static bool R_InstantiateViewEntity( viewEntityJob_t *job ) {
+	viewEntity_t		*vEntity = job->vEntity;
+	idRenderEntityLocal	*def = vEntity->entityDef;
+	idRenderModel		*model;
+	float				oldFloatTime;
+	int					oldTime;
+
+	job->skipped = true;
+	job->visible = false;
+	job->numAmbientSurfs = 0;
+	job->numInteractions = 0;
+
+	if ( r_useEntityScissors.GetBool() ) {
+		// calculate the screen area covered by the entity
+		idScreenRect scissorRect = R_CalcEntityScissorRectangle( vEntity );
+		// intersect with the portal crossing scissor rectangle
+		vEntity->scissorRect.Intersect( scissorRect );
+
+		if ( r_showEntityScissors.GetBool() ) {
+			R_ShowColoredScreenRect( vEntity->scissorRect, def->index );
+		}
+	}
+
+	if ( tr.viewDef->isXraySubview && def->parms.xrayIndex == 1 ) {
+		return false;
+	} else if ( !tr.viewDef->isXraySubview && def->parms.xrayIndex == 2 ) {
+		return false;
+	}
+
+	// the ambient surface is added if it has a visible rectangle
+	if ( !vEntity->scissorRect.IsEmpty() ) {
+		R_EnterEntityTimeGroup( def, oldFloatTime, oldTime );
+		model = R_EntityDefDynamicModel( def );
+		R_LeaveEntityTimeGroup( def, oldFloatTime, oldTime );
+
+		if ( model == NULL || model->NumSurfaces() <= 0 ) {
+			return false;
+		}
+
+		vEntity->skinMatrices = R_EntityDefSkinMatrices( def, model );
+		vEntity->numSkinMatrices = vEntity->skinMatrices ? def->parms.numJoints : 0;
+
+		job->visible = true;
+		tr.pc.c_visibleViewEntities++;
+	} else {
+		tr.pc.c_shadowViewEntities++;
+	}
+
+	job->skipped = false;
+	return true;
+}
+
+/*
+===================
+R_PrepareViewEntity
+
+Culls the ambient surfaces and the interactions with the visible lights.
+Only the entity, its interactions and frame memory are changed, so this
+runs as a front end job.
+===================
+*/
+static void R_PrepareViewEntity( viewEntityJob_t *job ) {
+	idRenderEntityLocal	*def = job->vEntity->entityDef;
+	const idInteractionStore &store = tr.viewDef->renderWorld->interactionStore;
+	idInteraction		*inter;
+	int					count;
+
+	if ( job->visible ) {
+		R_PrepareAmbientDrawsurfs( job );
+	}
+
+	//
+	// for all the entity / light interactions on this entity, add them to the view
+	//
+	if ( tr.viewDef->isXraySubview && def->parms.xrayIndex != 2 ) {
+		return;
+	}
+
+	// all empty interactions are at the end of the list so once the
+	// first is encountered all the remaining interactions are empty
+	count = 0;
+	for ( inter = def->firstInteraction; inter != NULL && !inter->IsEmpty(); inter = inter->entityNext ) {
+		count++;
+	}
+
+	job->interactions = (interactionJob_t *)R_FrameAlloc( count * sizeof( job->interactions[0] ) );
+
+	for ( inter = def->firstInteraction; inter != NULL && !inter->IsEmpty(); inter = inter->entityNext ) {
+		// skip interactions that can't light or shadow anything in the view
+		if ( store.IsCulled( inter ) ) {
+			continue;
+		}
+
+		// skip any lights that aren't currently visible
+		// this is run after any lights that are turned off have already
+		// been removed from the viewLights list, and had their viewCount cleared
+		if ( inter->lightDef->viewCount != tr.viewCount ) {
+			continue;
+		}
+
+		interactionJob_t *interJob = &job->interactions[job->numInteractions++];
+		interJob->inter = inter;
+		interJob->culled = inter->CullActiveInteraction( interJob->shadowScissor );
+	}
+}
+
+/*
+===================
+R_AddViewEntity
+
+Creates the drawSurfs and light surfaces of a prepared viewEntity
+===================
+*/
+static void R_AddViewEntity( viewEntityJob_t *job ) {
+	idRenderEntityLocal	*def = job->vEntity->entityDef;
+	float				oldFloatTime;
+	int					oldTime;
+
+	R_EnterEntityTimeGroup( def, oldFloatTime, oldTime );
+
+	if ( job->visible ) {
+		R_AddAmbientDrawsurfs( job );
+	}
+
+	for ( int i = 0 ; i < job->numInteractions ; i++ ) {
+		const interactionJob_t *interJob = &job->interactions[i];
+		if ( !interJob->culled ) {
+			interJob->inter->AddActiveInteraction( interJob->shadowScissor );
+		}
+	}
+
+	R_LeaveEntityTimeGroup( def, oldFloatTime, oldTime );
+}
+
 /*
 ===================
 R_AddModelSurfaces
@@ -1374,110 +1928,64 @@ interactions get created.  This is all done on a sort-by-model basis
 to keep source data in cache (most likely L2) as any interactions and
 shadows are generated, since dynamic models will typically be lit by
 two or more lights.
+
+If r_useParallelFrontEnd is set, all dynamic models are instantiated
+first, then the surface and interaction culling and the shader register
+evaluation is done with a job per entity.  The drawSurfs and light
+surfaces are still added in the order of the viewEntity list, so the
+result is the same as on the serial path.
 ===================
 */
 void R_AddModelSurfaces( void ) {
 	viewEntity_t		*vEntity;
-	idInteraction		*inter, *next;
-	idRenderModel		*model;
+	viewEntityJob_t		*jobs;
+	int					numEntities, i;
 
 	// clear the ambient surface list
 	tr.viewDef->numDrawSurfs = 0;
 	tr.viewDef->maxDrawSurfs = 0;	// will be set to INITIAL_DRAWSURFS on R_AddDrawSurf
 
-	// go through each entity that is either visible to the view, or to
-	// any light that intersects the view (for shadows)
+	numEntities = 0;
 	for ( vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next ) {
+		numEntities++;
+	}
 
-		if ( r_useEntityScissors.GetBool() ) {
-			// calculate the screen area covered by the entity
-			idScreenRect scissorRect = R_CalcEntityScissorRectangle( vEntity );
-			// intersect with the portal crossing scissor rectangle
-			vEntity->scissorRect.Intersect( scissorRect );
-
-			if ( r_showEntityScissors.GetBool() ) {
-				R_ShowColoredScreenRect( vEntity->scissorRect, vEntity->entityDef->index );
-			}
-		}
-
-		float oldFloatTime;
-		int oldTime;
-
-		game->SelectTimeGroup( vEntity->entityDef->parms.timeGroup );
-
-		if ( vEntity->entityDef->parms.timeGroup ) {
-			oldFloatTime = tr.viewDef->floatTime;
-			oldTime = tr.viewDef->renderView.time;
+	jobs = (viewEntityJob_t *)R_FrameAlloc( numEntities * sizeof( jobs[0] ) );
 
-			tr.viewDef->floatTime = game->GetTimeGroupTime( vEntity->entityDef->parms.timeGroup ) * 0.001;
-			tr.viewDef->renderView.time = game->GetTimeGroupTime( vEntity->entityDef->parms.timeGroup );
-		}
+	// cull all interactions of the world against the view and the visible lights at once
+	tr.viewDef->renderWorld->interactionStore.CullByView( tr.viewDef->renderWorld );
 
-		if ( tr.viewDef->isXraySubview && vEntity->entityDef->parms.xrayIndex == 1 ) {
-			if ( vEntity->entityDef->parms.timeGroup ) {
-				tr.viewDef->floatTime = oldFloatTime;
-				tr.viewDef->renderView.time = oldTime;
-			}
-			continue;
-		} else if ( !tr.viewDef->isXraySubview && vEntity->entityDef->parms.xrayIndex == 2 ) {
-			if ( vEntity->entityDef->parms.timeGroup ) {
-				tr.viewDef->floatTime = oldFloatTime;
-				tr.viewDef->renderView.time = oldTime;
+	// go through each entity that is either visible to the view, or to
+	// any light that intersects the view (for shadows)
+	if ( !R_UseParallelFrontEnd() ) {
+		for ( i = 0, vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next, i++ ) {
+			jobs[i].vEntity = vEntity;
+			if ( R_InstantiateViewEntity( &jobs[i] ) ) {
+				R_PrepareViewEntity( &jobs[i] );
+				R_AddViewEntity( &jobs[i] );
 			}
-			continue;
 		}
+		return;
+	}
 
-		// add the ambient surface if it has a visible rectangle
-		if ( !vEntity->scissorRect.IsEmpty() ) {
-			model = R_EntityDefDynamicModel( vEntity->entityDef );
-			if ( model == NULL || model->NumSurfaces() <= 0 ) {
-				if ( vEntity->entityDef->parms.timeGroup ) {
-					tr.viewDef->floatTime = oldFloatTime;
-					tr.viewDef->renderView.time = oldTime;
-				}
-				continue;
-			}
-
-			R_AddAmbientDrawsurfs( vEntity );
-			tr.pc.c_visibleViewEntities++;
-		} else {
-			tr.pc.c_shadowViewEntities++;
-		}
+	for ( i = 0, vEntity = tr.viewDef->viewEntitys; vEntity; vEntity = vEntity->next, i++ ) {
+		jobs[i].vEntity = vEntity;
+		R_InstantiateViewEntity( &jobs[i] );
+	}
 
-		//
-		// for all the entity / light interactions on this entity, add them to the view
-		//
-		if ( tr.viewDef->isXraySubview ) {
-			if ( vEntity->entityDef->parms.xrayIndex == 2 ) {
-				for ( inter = vEntity->entityDef->firstInteraction; inter != NULL && !inter->IsEmpty(); inter = next ) {
-					next = inter->entityNext;
-					if ( inter->lightDef->viewCount != tr.viewCount ) {
-						continue;
-					}
-					inter->AddActiveInteraction();
-				}
-			}
-		} else {
-			// all empty interactions are at the end of the list so once the
-			// first is encountered all the remaining interactions are empty
-			for ( inter = vEntity->entityDef->firstInteraction; inter != NULL && !inter->IsEmpty(); inter = next ) {
-				next = inter->entityNext;
-
-				// skip any lights that aren't currently visible
-				// this is run after any lights that are turned off have already
-				// been removed from the viewLights list, and had their viewCount cleared
-				if ( inter->lightDef->viewCount != tr.viewCount ) {
-					continue;
-				}
-				inter->AddActiveInteraction();
-			}
+	tr.frontEndJobs->Clear();
+	for ( i = 0 ; i < numEntities ; i++ ) {
+		if ( !jobs[i].skipped ) {
+			tr.frontEndJobs->AddJob( (jobRun_t)R_PrepareViewEntity, &jobs[i] );
 		}
+	}
+	tr.frontEndJobs->Submit();
+	tr.frontEndJobs->Wait();
 
-		if ( vEntity->entityDef->parms.timeGroup ) {
-			tr.viewDef->floatTime = oldFloatTime;
-			tr.viewDef->renderView.time = oldTime;
+	for ( i = 0 ; i < numEntities ; i++ ) {
+		if ( !jobs[i].skipped ) {
+			R_AddViewEntity( &jobs[i] );
 		}
-
 	}
 }
 
@@ -155,6 +155,30 @@ void R_ModulateLights_f( const idCmdArgs &args ) {
 //======================================================================================
 
 
+/*
+===============
+R_FreeEntityDefRefs
+
+Unlinks the entityRefs from the areas and their bounds trees
+===============
+*/
+static void R_FreeEntityDefRefs( idRenderEntityLocal *def ) {
+	areaReference_t	*ref, *next;
+
+	for ( ref = def->entityRefs ; ref ; ref = next ) {
+		next = ref->ownerNext;
+
+		// unlink from the area
+		ref->areaNext->areaPrev = ref->areaPrev;
+		ref->areaPrev->areaNext = ref->areaNext;
+		ref->area->entityTree.RemoveProxy( ref->treeProxy );
+
+		// put it back on the free list for reuse
+		def->world->areaReferenceAllocator.Free( ref );
+	}	
+	def->entityRefs = NULL;
+}
+
 /*
 ===============
 R_CreateEntityRefs
@@ -162,13 +186,18 @@ R_CreateEntityRefs
 Creates all needed model references in portal areas,
 chaining them to both the area and the entityDef.
 
+The global axial bounds are expanded by r_areaRefMargin and pushed
+into the areas, entityRefs kept from the last update are reused as
+long as the entity stays inside them.
+
 Bumps tr.viewCount.
 ===============
 */
 void R_CreateEntityRefs( idRenderEntityLocal *def ) {
 	int			i;
 	idVec3		transformed[8];
-	idVec3		v;
+	idBounds	globalBounds;
+	float		margin;
 
 	if ( !def->parms.hModel ) {
 		def->parms.hModel = renderModelManager->DefaultModel();
@@ -184,6 +213,7 @@ void R_CreateEntityRefs( idRenderEntityLocal *def ) {
 
 	// some models, like empty particles, may not need to be added at all
 	if ( def->referenceBounds.IsCleared() ) {
+		R_FreeEntityDefRefs( def );
 		return;
 	}
 
@@ -194,12 +224,33 @@ void R_CreateEntityRefs( idRenderEntityLocal *def ) {
 						def->referenceBounds[1][1] - def->referenceBounds[0][1] );
 	}
 
-	for (i = 0 ; i < 8 ; i++) {
-		v[0] = def->referenceBounds[i&1][0];
-		v[1] = def->referenceBounds[(i>>1)&1][1];
-		v[2] = def->referenceBounds[(i>>2)&1][2];
+	globalBounds.FromTransformedBounds( def->referenceBounds, def->parms.origin, def->parms.axis );
 
-		R_LocalPointToGlobal( def->modelMatrix, v, transformed[i] ); 
+	// the areas touched by the expanded bounds are still valid
+	if ( def->entityRefs ) {
+		for ( i = 0; i < 3; i++ ) {
+			if ( globalBounds[0][i] < def->areaRefBounds[0][i] || globalBounds[1][i] > def->areaRefBounds[1][i] ) {
+				break;
+			}
+		}
+		if ( i == 3 ) {
+			return;
+		}
+		R_FreeEntityDefRefs( def );
+	}
+
+	// the refs have to cover all of areaRefBounds, even without a margin,
+	// or a rotation inside it could reach areas that have no ref
+	margin = r_areaRefMargin.GetFloat();
+	if ( margin > 0.0f ) {
+		def->areaRefBounds = globalBounds.Expand( margin );
+	} else {
+		def->areaRefBounds = globalBounds;
+	}
+	for ( i = 0 ; i < 8 ; i++ ) {
+		transformed[i][0] = def->areaRefBounds[i&1][0];
+		transformed[i][1] = def->areaRefBounds[(i>>1)&1][1];
+		transformed[i][2] = def->areaRefBounds[(i>>2)&1][2];
 	}
 
 	// bump the view count so we can tell if an
@@ -613,6 +664,7 @@ void R_FreeLightDefDerivedData( idRenderLightLocal *ldef ) {
 		// unlink from the area
 		lref->areaNext->areaPrev = lref->areaPrev;
 		lref->areaPrev->areaNext = lref->areaNext;
+		lref->area->lightTree.RemoveProxy( lref->treeProxy );
 
 		// put it back on the free list for reuse
 		ldef->world->areaReferenceAllocator.Free( lref );
@@ -630,9 +682,8 @@ Used by both RE_FreeEntityDef and RE_UpdateEntityDef
 Does not actually free the entityDef.
 ===================
 */
-void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel ) {
+void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel, bool keepEntityRefs ) {
 	int i;
-	areaReference_t	*ref, *next;
 
 	// demo playback needs to free the joints, while normal play
 	// leaves them in the control of the game
@@ -673,18 +724,11 @@ void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool
 		def->cachedDynamicModel = NULL;
 	}
 
-	// free the entityRefs from the areas
-	for ( ref = def->entityRefs ; ref ; ref = next ) {
-		next = ref->ownerNext;
-
-		// unlink from the area
-		ref->areaNext->areaPrev = ref->areaPrev;
-		ref->areaPrev->areaNext = ref->areaNext;
-
-		// put it back on the free list for reuse
-		def->world->areaReferenceAllocator.Free( ref );
-	}	
-	def->entityRefs = NULL;
+	// free the entityRefs from the areas, R_CreateEntityRefs
+	// decides if the kept ones are still valid
+	if ( !keepEntityRefs ) {
+		R_FreeEntityDefRefs( def );
+	}
 }
 
 /*
@@ -764,7 +808,7 @@ void R_FreeDerivedData( void ) {
 			if ( !def ) {
 				continue;
 			}
-			R_FreeEntityDefDerivedData( def, false, false );
+			R_FreeEntityDefDerivedData( def, false, false, false );
 		}
 
 		for ( i = 0; i < rw->lightDefs.Num(); i++ ) {
@@ -798,7 +842,7 @@ void R_CheckForEntityDefsUsingModel( idRenderModel *model ) {
 			if ( def->parms.hModel == model ) {
 				//assert( 0 );
 				// this should never happen but Radiant messes it up all the time so just free the derived data
-				R_FreeEntityDefDerivedData( def, false, false );
+				R_FreeEntityDefDerivedData( def, false, false, false );
 			}
 		}
 	}
@@ -37,7 +37,7 @@ class idRenderWorldLocal;
 // everything that is needed by the backend needs
 // to be double buffered to allow it to run in
 // parallel on a dual cpu machine
-const int SMP_FRAMES = 1;
+const int SMP_FRAMES = 2;
 
 const int FALLOFF_TEXTURE_SIZE =	64;
 
@@ -96,6 +96,7 @@ SURFACES
 #include "ModelDecal.h"
 #include "ModelOverlay.h"
 #include "Interaction.h"
+#include "BoundsTree.h"
 
 
 // drawSurf_t structures command the back end to render surfaces
@@ -145,6 +146,7 @@ typedef struct areaReference_s {
 	idRenderEntityLocal *	entity;					// only one of entity / light will be non-NULL
 	idRenderLightLocal *	light;					// only one of entity / light will be non-NULL
 	struct portalArea_s	*	area;					// so owners can find all the areas they are in
+	int						treeProxy;				// in the entity or light tree of the area
 } areaReference_t;
 
 
@@ -266,6 +268,7 @@ public:
 	idRenderModel *			cachedDynamicModel;
 
 	idBounds				referenceBounds;		// the local bounds used to place entityRefs, either from parms or a model
+	idBounds				areaRefBounds;			// global bounds the entityRefs were made for, expanded by r_areaRefMargin
 
 	// a viewEntity_t is created whenever a idRenderEntityLocal is considered for inclusion
 	// in a given view, even if it turns out to not be visible
@@ -295,6 +298,25 @@ public:
 // which the front end may be modifying simultaniously if running in SMP mode.
 // a viewLight may exist even without any surfaces, and may be relevent for fogging,
 // but should never exist if its volume does not intersect the view frustum
+// shadow maps, see r_shadowMaps
+typedef enum {
+	SHADOWMAP_NONE,
+	SHADOWMAP_PROJECTED,		// a perspective view in the shadow map atlas
+	SHADOWMAP_CASCADES,			// orthographic views in the atlas, split along the view distance
+	SHADOWMAP_CUBE				// the six faces of the shadow cube map
+} shadowMapType_t;
+
+const int MAX_SHADOWMAP_CASCADES	= 4;
+const int MAX_SHADOWMAP_VIEWS		= 6;
+
+typedef struct {
+	idMat4					viewProjection;			// global to clip space, same layout as viewEntity_t::modelMatrix
+	idMat4					textureMatrix;			// global to atlas coordinates and depth, 0 to 1
+	int						numCullPlanes;
+	idPlane					cullPlanes[4];			// global space, positive side facing out
+	int						x, y, size;				// viewport in the atlas or cube map face
+} shadowMapView_t;
+
 typedef struct viewLight_s {
 	struct viewLight_s *	next;
 
@@ -332,6 +354,15 @@ typedef struct viewLight_s {
 	const struct drawSurf_s	*localShadows;				// don't shadow local Surfaces
 	const struct drawSurf_s	*globalInteractions;		// get shadows from everything
 	const struct drawSurf_s	*translucentInteractions;	// get shadows from everything
+
+	// lights with shadow maps don't have any shadow volumes
+	shadowMapType_t			shadowMapType;
+	int						numShadowMapViews;
+	shadowMapView_t *		shadowMapViews;				// frame allocated
+	float					shadowMapCascadeSplits[MAX_SHADOWMAP_CASCADES];	// view distance where each cascade ends
+	idPlane					shadowMapViewPlane;			// view distance of a global point
+	float					shadowMapDepthRange[2];		// near and far of the cube map faces
+	const struct drawSurf_s	*shadowMapCasters;			// surfaces rendered into the shadow maps
 } viewLight_t;
 
 
@@ -359,6 +390,11 @@ typedef struct viewEntity_s {
 
 	idMat4				modelMatrix;		// local coords to global coords
 	idMat4				modelViewMatrix;	// local coords to eye coords
+
+	// joint matrices relative to the bind pose for the surfaces
+	// that have a jointWeightCache, NULL if there aren't any
+	const idJointMat *	skinMatrices;
+	int					numSkinMatrices;
 } viewEntity_t;
 
 
@@ -412,6 +448,12 @@ typedef struct viewDef_s {
 	int					numDrawSurfs;			// it is allocated in frame temporary memory
 	int					maxDrawSurfs;			// may be resized
 
+	// deforms evaluated by jobs at the end of R_AddModelSurfaces, see r_useParallelDeforms
+	struct deformJob_s *deformJobs;
+	int					numDeformJobs;
+	int					maxDeformJobs;
+	bool				parallelDeforms;
+
 	struct viewLight_s	*viewLights;			// chain of all viewLights effecting view
 	struct viewEntity_s	*viewEntitys;			// chain of all viewEntities effecting view, including off screen ones casting shadows
 	// we use viewEntities as a check to see if a given view consists solely
@@ -428,6 +470,8 @@ typedef struct viewDef_s {
 	// crossing a closed door.  This is used to avoid drawing interactions
 	// when the light is behind a closed door.
 
+	int					shadowMapAtlasSize;		// the atlas the shadowMapViews of the lights are placed in
+
 } viewDef_t;
 
 
@@ -510,29 +554,22 @@ typedef struct {
 // in a given view, but it will automatically grow if needed
 const int	INITIAL_DRAWSURFS =			0x4000;
 
-// a request for frame memory will never fail
-// (until malloc fails), but it may force the
-// allocation of a new memory block that will
-// be discontinuous with the existing memory
-typedef struct frameMemoryBlock_s {
-	struct frameMemoryBlock_s *next;
-	int		size;
-	int		used;
-	int		poop;			// so that base is 16 byte aligned
-	byte	base[4];	// dynamically allocated as [size]
-} frameMemoryBlock_t;
+// frame memory is bump allocated from a single range of address
+// space that is reserved at init and committed as it is used.
+// Allocating is lock free, so front end jobs can use it, but a
+// request will fail if the reserved range is exhausted
+const int	FRAME_MEMORY_COMMIT_SIZE =	0x10000;
 
 // all of the information needed by the back end must be
 // contained in a frameData_t.  This entire structure is
 // duplicated so the front and back end can run in parallel
-// on an SMP machine (OBSOLETE: this capability has been removed)
+// on an SMP machine, see r_useRenderThread
 typedef struct {
-	// one or more blocks of memory for all frame
-	// temporary allocations
-	frameMemoryBlock_t	*memory;
-
-	// alloc will point somewhere into the memory chain
-	frameMemoryBlock_t	*alloc;
+	// all frame temporary allocations
+	byte *				memory;
+	int					memoryReserved;		// r_frameMemoryMB
+	interlockedInt_t	memoryUsed;			// advanced atomically by R_FrameAlloc
+	interlockedInt_t	memoryCommitted;	// only grows, in FRAME_MEMORY_COMMIT_SIZE steps
 
 	srfTriangles_t *	firstDeferredFreeTriSurf;
 	srfTriangles_t *	lastDeferredFreeTriSurf;
@@ -577,12 +614,19 @@ typedef struct {
 	int		c_createInteractions;	// number of calls to idInteraction::CreateInteraction
 	int		c_createLightTris;
 	int		c_createShadowVolumes;
+	int		c_shadowCacheHits;		// turbo shadow volumes taken from the shadow cache
+	int		c_shadowCacheMisses;
 	int		c_generateMd5;
 	int		c_entityDefCallbacks;
 	int		c_alloc, c_free;	// counts for R_StaticAllc/R_StaticFree
 	int		c_visibleViewEntities;
 	int		c_shadowViewEntities;
 	int		c_viewLights;
+	int		c_occluderTris;				// occluder triangles rasterized by R_OcclusionCull
+	int		c_occlusionTestedEntities, c_occlusionCulledEntities;
+	int		c_occlusionTestedLights, c_occlusionCulledLights;
+	int		c_portalChainsFlooded;		// portal chains clipped by FlowViewThroughPortals
+	int		c_portalChainsReused;		// portal chains taken from a cached view flood
 	int		c_numViews;			// number of total views rendered
 	int		c_deformedSurfaces;	// idMD5Mesh::GenerateSurface
 	int		c_deformedVerts;	// idMD5Mesh::GenerateSurface
@@ -591,8 +635,38 @@ typedef struct {
 	int		c_entityUpdates, c_lightUpdates, c_entityReferences, c_lightReferences;
 	int		c_guiSurfs;
 	int		frontEndMsec;		// sum of time in all RE_RenderScene's in a frame
+	int		c_drawSurfs;		// drawSurfs of all views
+
+	// clock ticks of the front end stages summed over all views, see r_benchmarkLog
+	double	frontEndTicks;		// all of RenderScene
+	double	portalTicks;		// FindViewLightsAndEntities
+	double	occlusionTicks;		// R_OcclusionCull
+	double	lightSurfTicks;		// R_AddLightSurfaces
+	double	modelSurfTicks;		// R_AddModelSurfaces, including the interactions it creates
+	double	shadowTicks;		// R_CreateShadowVolumes, part of the light and model surfaces
+	double	deformTicks;		// R_FinishDeformJobs
+	double	sortTicks;			// R_RemoveUnecessaryViewLights and R_SortDrawSurfs
 } performanceCounters_t;
 
+/*
+** jobCounters_t
+**
+** performance counters that front end jobs update, every job thread adds to its
+** own copy so they don't race, R_MergeJobCounters adds them to tr.pc
+*/
+typedef struct {
+	int		c_box_cull_in, c_box_cull_out;
+	int		c_tangentIndexes;	// R_DeriveTangents() in deform jobs
+	int		padding[13];		// keeps the copies of the threads on separate cache lines
+} jobCounters_t;
+
+// adds the ticks since start to a stage time and returns the current ticks
+ID_INLINE double R_StageTicks( double &stageTicks, double start ) {
+	double now = Sys_GetClockTicks();
+	stageTicks += now - start;
+	return now;
+}
+
 
 typedef struct {
 	int		current2DMap;
@@ -633,6 +707,14 @@ typedef struct {
 	int		c_vboIndexes;
 	float	c_overDraw;	
 
+	int		c_gl33Draws;			// draw calls of the GL 3.3 back end, a multi draw counts once
+	int		c_gl33MergedDraws;		// surfaces drawn by a multi draw together with others
+	int		c_gl33StateChanges;		// program, texture, vertex layout, scissor and depth range changes
+	int		c_gl33Uniforms;			// uniform calls and uniform buffer range binds
+	int		c_gl33UniformBytes;		// uploaded to the interaction uniform buffer
+	int		c_gl33ShadowMapViews;	// atlas tiles and cube map faces drawn
+	int		c_gl33ShadowMapDraws;	// surfaces drawn into the shadow maps
+
 	float	maxLightValue;	// for light scale
 	int		msec;			// total msec for backend run
 } backEndCounters_t;
@@ -786,6 +868,7 @@ public:
 	viewDef_t *				viewDef;
 
 	performanceCounters_t	pc;					// performance counters
+	jobCounters_t			jobCounters[MAX_JOB_THREADS + 1];	// indexed by the job thread slot
 
 	drawSurfsCommand_t		lockSurfacesCmd;	// use this when r_lockSurfaces = 1
 
@@ -802,13 +885,62 @@ public:
 	class idGuiModel *		guiModel;
 	class idGuiModel *		demoGuiModel;
 
+	// light and entity culling jobs, see r_useParallelFrontEnd
+	idParallelJobList *		frontEndJobs;
+	// shadow volume creation jobs, see r_useParallelShadows
+	idParallelJobList *		shadowVolumeJobs;
+
+	// 0 = shadow volumes for all lights, otherwise r_shadowMaps as used by the interactions
+	int						shadowMapMode;
+
+	// the back end executes the commands of the last frame on the render
+	// thread while the front end builds the next one, see r_useRenderThread
+	bool					renderThreadActive;
+	int						smpFrame;			// index of frameData in the smp frames
+
+	// r_nullDriver, there is no GL context but the views are still processed
+	bool					nullDriver;
+
 	unsigned short			gammaTable[256];	// brightness / gamma modify this
 };
 
 extern backEndState_t		backEnd;
 extern idRenderSystemLocal	tr;
+
+// the counters of the calling thread, threads outside of the job system share the main thread's
+ID_INLINE jobCounters_t &R_JobCounters( void ) {
+	return tr.jobCounters[ Max( parallelJobManager->GetThreadSlot(), 0 ) ];
+}
 extern glconfig_t			glConfig;		// outside of TR since it shouldn't be cleared during ref re-init
 
+// GL_ARB_buffer_storage is core in GL 4.4, which the glad loader doesn't cover
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT		0x0040
+#define GL_MAP_COHERENT_BIT			0x0080
+#endif
+
+typedef void ( APIENTRYP qglBufferStorageProc_t )( GLenum target, GLsizeiptr size, const void *data, GLbitfield flags );
+extern qglBufferStorageProc_t		qglBufferStorage;		// NULL without glConfig.bufferStorageAvailable
+
+// GL_ARB_get_program_binary and GL_KHR_parallel_shader_compile aren't covered either
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT	0x8257
+#define GL_PROGRAM_BINARY_LENGTH			0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS		0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR			0x91B1
+#endif
+
+typedef void ( APIENTRYP qglGetProgramBinaryProc_t )( GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary );
+typedef void ( APIENTRYP qglProgramBinaryProc_t )( GLuint program, GLenum binaryFormat, const void *binary, GLsizei length );
+typedef void ( APIENTRYP qglProgramParameteriProc_t )( GLuint program, GLenum pname, GLint value );
+typedef void ( APIENTRYP qglMaxShaderCompilerThreadsProc_t )( GLuint count );
+extern qglGetProgramBinaryProc_t	qglGetProgramBinary;	// NULL without glConfig.programBinaryAvailable
+extern qglProgramBinaryProc_t		qglProgramBinary;
+extern qglProgramParameteriProc_t	qglProgramParameteri;
+extern qglMaxShaderCompilerThreadsProc_t qglMaxShaderCompilerThreads;	// NULL without glConfig.parallelShaderCompileAvailable
+
 
 //
 // cvars
@@ -851,6 +983,7 @@ extern idCVar r_useTripleTextureARB;	// 1 = cards with 3+ texture units do a two
 extern idCVar r_useShadowSurfaceScissor;// 1 = scissor shadows by the scissor rect of the interaction surfaces
 extern idCVar r_useConstantMaterials;	// 1 = use pre-calculated material registers if possible
 extern idCVar r_useInteractionTable;	// create a full entityDefs * lightDefs table to make finding interactions faster
+extern idCVar r_useInteractionBatching;	// sort the GL 3.3 interactions of a light by state and merge draws
 extern idCVar r_useNodeCommonChildren;	// stop pushing reference bounds early when possible
 extern idCVar r_useSilRemap;			// 1 = consider verts with the same XYZ, but different ST the same for shadows
 extern idCVar r_useCulling;				// 0 = none, 1 = sphere, 2 = sphere + box
@@ -861,6 +994,32 @@ extern idCVar r_useEntityCulling;		// 0 = none, 1 = box
 extern idCVar r_useEntityScissors;		// 1 = use custom scissor rectangle for each entity
 extern idCVar r_useInteractionCulling;	// 1 = cull interactions
 extern idCVar r_useInteractionScissors;	// 1 = use a custom scissor rectangle for each interaction
+extern idCVar r_useParallelFrontEnd;	// 1 = cull and evaluate lights, entities and interactions with parallel jobs
+extern idCVar r_useParallelShadows;	// 1 = build the clipped shadow volumes of an interaction with parallel jobs
+extern idCVar r_useParallelDeforms;	// 1 = evaluate the deforms of the view surfaces with parallel jobs
+extern idCVar r_useAreaTrees;			// 1 = query the bounds trees of the areas for entities and lights instead of walking the area lists
+extern idCVar r_areaRefMargin;			// entities moving less than this keep their area references
+extern idCVar r_useOcclusionCulling;	// 1 = cull view entities and lights behind the rasterized world occluders
+extern idCVar r_occlusionBufferWidth;	// width of the software occlusion depth buffer
+extern idCVar r_occluderMinArea;		// smallest world triangle that is rasterized as an occluder
+extern idCVar r_showOcclusion;			// 1 = print occlusion culling counts, 2 = also draw the culled bounds
+extern idCVar r_usePortalCache;			// 1 = reuse the portal chains of a view flood for views that barely moved
+extern idCVar r_portalCacheDistance;	// views closer than this to a cached view flood reuse it
+extern idCVar r_showPortalCache;		// 1 = print the number of flooded and reused portal chains
+extern idCVar r_nullDriver;				// 1 = no window or GL context, the back end commands are discarded
+extern idCVar r_benchmarkLog;			// file the front end stage times of each frame are written to
+extern idCVar r_shadowMaps;				// 0 = shadow volumes, 1 = shadow maps for lights with shadowMap materials, 2 = shadow maps for all lights
+extern idCVar r_shadowMapSize;			// largest shadow map of a projected light
+extern idCVar r_shadowMapMinSize;		// smallest shadow map in the atlas
+extern idCVar r_shadowMapAtlasSize;		// size of the shadow map atlas
+extern idCVar r_shadowMapCubeSize;		// size of the shadow cube map faces of point lights
+extern idCVar r_shadowMapCascades;		// number of cascades of parallel lights
+extern idCVar r_shadowMapCascadeSize;	// size of each cascade
+extern idCVar r_shadowMapCascadeDistance;	// view distance covered by the cascades
+extern idCVar r_shadowMapPolygonFactor;	// polygon offset factor when drawing shadow maps
+extern idCVar r_shadowMapPolygonOffset;	// polygon offset units when drawing shadow maps
+extern idCVar r_shadowMapFilter;		// 1 = four shadow map samples instead of one
+extern idCVar r_useRenderThread;		// 1 = run the back end on its own thread, one frame behind the front end
 extern idCVar r_useFrustumFarDistance;	// if != 0 force the view frustum far distance to this distance
 extern idCVar r_useShadowCulling;		// try to cull shadows from partially visible lights
 extern idCVar r_usePreciseTriangleInteractions;	// 1 = do winding clipping to determine if each ambiguous tri should be lit
@@ -868,8 +1027,11 @@ extern idCVar r_useTurboShadow;			// 1 = use the infinite projection with W tech
 extern idCVar r_useExternalShadows;		// 1 = skip drawing caps when outside the light volume
 extern idCVar r_useOptimizedShadows;	// 1 = use the dmap generated static shadow volumes
 extern idCVar r_useShadowVertexProgram;	// 1 = do the shadow projection in the vertex program on capable cards
+extern idCVar r_useShadowCache;			// 1 = keep turbo shadow volumes for interactions that are created again
+extern idCVar r_shadowCacheSize;			// megabytes of turbo shadow volumes kept in the cache
 extern idCVar r_useShadowProjectedCull;	// 1 = discard triangles outside light volume before shadowing
 extern idCVar r_useDeferredTangents;	// 1 = don't always calc tangents after deform
+extern idCVar r_useGPUSkinning;			// transform MD5 models with simple materials in the GL 3.3 vertex shaders
 extern idCVar r_useCachedDynamicModels;	// 1 = cache snapshots of dynamic models
 extern idCVar r_useTwoSidedStencil;		// 1 = do stencil shadows in one pass with different ops on each side
 extern idCVar r_useInfiniteFarZ;		// 1 = use the no-far-clip-plane trick
@@ -879,6 +1041,8 @@ extern idCVar r_useStateCaching;		// avoid redundant state changes in GL_*() cal
 extern idCVar r_useCombinerDisplayLists;// if 1, put all nvidia register combiner programming in display lists
 extern idCVar r_useVertexBuffers;		// if 0, don't use ARB_vertex_buffer_object for vertexes
 extern idCVar r_useIndexBuffers;		// if 0, don't use ARB_vertex_buffer_object for indexes
+extern idCVar r_usePersistentMapping;	// if 0, don't write frame temp vertexes to a persistently mapped ring buffer
+extern idCVar r_useProgramBinaryCache;	// if 0, always compile the GLSL programs from source
 extern idCVar r_useEntityCallbacks;		// if 0, issue the callback immediately at update time, rather than defering
 extern idCVar r_lightAllBackFaces;		// light all the back faces, even when they would be shadowed
 extern idCVar r_useDepthBoundsTest;     // use depth bounds test to reduce shadow fill
@@ -946,10 +1110,13 @@ extern idCVar r_showEntityScissors;		// show entity scissor rectangles
 extern idCVar r_showInteractionFrustums;// show a frustum for each interaction
 extern idCVar r_showInteractionScissors;// show screen rectangle which contains the interaction frustum
 extern idCVar r_showMemory;				// print frame memory utilization
+extern idCVar r_frameMemoryMB;			// size of the address range reserved for frame memory
+extern idCVar r_poisonFrameMemory;		// fill frame memory with garbage when it is reset
 extern idCVar r_showCull;				// report sphere and box culling stats
 extern idCVar r_showInteractions;		// report interaction generation activity
 extern idCVar r_showSurfaces;			// report surface/light/shadow counts
 extern idCVar r_showPrimitives;			// report vertex/index/draw counts
+extern idCVar r_showBatches;			// report draws, state changes and uniform uploads of the GL 3.3 back end
 extern idCVar r_showPortals;			// draw portal outlines in color based on passed / not passed
 extern idCVar r_showAlloc;				// report alloc/free counts
 extern idCVar r_showSkel;				// draw the skeleton when model animates
@@ -1098,13 +1265,19 @@ void		GLimp_SetGamma( unsigned short red[256],
 
 
 bool		GLimp_SpawnRenderThread( void (*function)( void ) );
-// Returns false if the system only has a single processor
+// Returns false if the system only has a single processor, or if no
+// context could be created for the front end.  The render thread owns
+// the main context, the calling thread gets one that shares objects with it
 
 void *		GLimp_BackEndSleep( void );
 void		GLimp_FrontEndSleep( void );
 void		GLimp_WakeBackEnd( void *data );
 // these functions implement the dual processor syncronization
 
+void		GLimp_ShutdownRenderThread( void );
+// Waits for the render thread function to return and makes the
+// main context current on the calling thread again
+
 void		GLimp_ActivateContext( void );
 void		GLimp_DeactivateContext( void );
 // These are used for managing SMP handoffs of the OpenGL context
@@ -1128,6 +1301,9 @@ MAIN
 
 void R_RenderView( viewDef_t *parms );
 
+// adds the counters of the job threads to tr.pc, only called while no front end jobs run
+void R_MergeJobCounters( void );
+
 // performs radius cull first, then corner cull
 bool R_CullLocalBox( const idBounds &bounds, const float* modelMatrix, int numPlanes, const idPlane *planes );
 bool R_RadiusCullLocalBox( const idBounds &bounds, const float* modelMatrix, int numPlanes, const idPlane *planes );
@@ -1167,6 +1343,7 @@ LIGHT
 
 void R_ListRenderLightDefs_f( const idCmdArgs &args );
 void R_ListRenderEntityDefs_f( const idCmdArgs &args );
+void R_BenchmarkAreaRefs_f( const idCmdArgs &args );
 
 bool R_IssueEntityDefCallback( idRenderEntityLocal *def );
 idRenderModel *R_EntityDefDynamicModel( idRenderEntityLocal *def );
@@ -1175,7 +1352,7 @@ viewEntity_t *R_SetEntityDefViewEntity( idRenderEntityLocal *def );
 viewLight_t *R_SetLightDefViewLight( idRenderLightLocal *def );
 
 void R_AddDrawSurf( const srfTriangles_t *tri, const viewEntity_t *space, const renderEntity_t *renderEntity,
-					const idMaterial *shader, const idScreenRect &scissor );
+					const idMaterial *shader, const idScreenRect &scissor, const float *shaderRegisters = NULL );
 
 void R_LinkLightSurf( const drawSurf_t **link, const srfTriangles_t *tri, const viewEntity_t *space, 
 				   const idRenderLightLocal *light, const idMaterial *shader, const idScreenRect &scissor, bool viewInsideShadow );
@@ -1215,7 +1392,7 @@ void R_FreeLightDefDerivedData( idRenderLightLocal *light );
 void R_CheckForEntityDefsUsingModel( idRenderModel *model );
 
 void R_ClearEntityDefDynamicModel( idRenderEntityLocal *def );
-void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel );
+void R_FreeEntityDefDerivedData( idRenderEntityLocal *def, bool keepDecals, bool keepCachedDynamicModel, bool keepEntityRefs );
 void R_FreeEntityDefCachedDynamicModel( idRenderEntityLocal *def );
 void R_FreeEntityDefDecals( idRenderEntityLocal *def );
 void R_FreeEntityDefOverlay( idRenderEntityLocal *def );
@@ -1255,6 +1432,7 @@ void RB_DrawShaderPasses( drawSurf_t **drawSurfs, int numDrawSurfs );
 void RB_LoadShaderTextureMatrix( const float *shaderRegisters, const textureStage_t *texture );
 void RB_GetShaderTextureMatrix( const float *shaderRegisters, const textureStage_t *texture, float matrix[16] );
 void RB_CreateSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInteraction)(const drawInteraction_t *) );
+void RB_DecomposeSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInteraction)(const drawInteraction_t *) );
 
 const shaderStage_t *RB_SetLightTexture( const idRenderLightLocal *light );
 
@@ -1302,6 +1480,7 @@ int     R_FindGLSLProgram(const char* program);
 void    RB_GL33_DrawInteractions();
 void    RB_GL33_FillDepthBuffer(const drawSurf_t* surf);
 void    RB_GL33_RenderShaderPasses(const drawSurf_t* surf);
+void    R_GL33_UnbindProgram();
 
 
 typedef enum {
@@ -1324,6 +1503,7 @@ typedef enum {
     GLPROG_UNLIT_PASS,          //
     GLPROG_ENVIRONMENT,         // cubemap reflection
     GLPROG_BUMPY_ENVIRONMENT,   // cubemap reflection with normalmap
+    GLPROG_SHADOW_MAP,          // depth of the shadow casters
 
 	PROG_USER
 } program_t;
@@ -1400,6 +1580,79 @@ srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
 									 const srfTriangles_t *tri, const idRenderLightLocal *light,
 									 shadowGen_t optimize, srfCullInfo_t &cullInfo );
 
+typedef struct {
+	const idRenderEntityLocal *	ent;
+	const srfTriangles_t *		tri;
+	const idRenderLightLocal *	light;
+	shadowGen_t					optimize;
+	srfCullInfo_t *				cullInfo;
+
+	srfTriangles_t *			shadowTris;		// NULL if the surface doesn't cast a shadow
+
+	// built by a job and moved to shadowTris on the calling thread
+	idVec4 *					shadowVerts;
+	glIndex_t *					shadowIndexes;
+	int							numShadowVerts;
+	int							numShadowIndexes;
+	int							numShadowIndexesNoCaps;
+	int							numShadowIndexesNoFrontCaps;
+	int							shadowCapPlaneBits;
+} shadowVolumeJob_t;
+
+// creates the shadow volumes of several surfaces at once, see r_useParallelShadows
+void R_CreateShadowVolumes( shadowVolumeJob_t *jobs, int numJobs );
+void R_ShutdownShadowVolumes( void );
+void R_BenchmarkShadows_f( const idCmdArgs &args );
+
+/*
+============================================================
+
+TR_SHADOWMAP
+
+Shadow maps as an alternative to the shadow volumes in the GL 3.3 back end
+
+============================================================
+*/
+
+void R_CheckShadowMapMode( void );
+bool R_LightUsesShadowMap( const idRenderLightLocal *light );
+void R_SetupShadowMapViews( viewLight_t *vLight );
+void R_AllocShadowMapAtlas( void );
+
+/*
+============================================================
+
+TR_OCCLUSION
+
+Software rasterized occluders of the world areas
+
+============================================================
+*/
+
+typedef struct areaOccluder_s {
+	int						numVerts;
+	idVec3 *				verts;
+	int						numIndexes;
+	int *					indexes;
+	idPlane *				planes;				// one for each triangle, the positive side is the front
+} areaOccluder_t;
+
+void R_OcclusionCull( void );
+void R_FreeAreaOccluder( areaOccluder_t *occluder );
+void R_ShutdownOcclusion( void );
+void R_WriteOcclusionBuffer_f( const idCmdArgs &args );
+
+/*
+============================================================
+
+TR_BENCHMARK
+
+============================================================
+*/
+
+void R_BenchmarkFrame( void );
+void R_ShutdownBenchmark( void );
+
 /*
 ============================================================
 
@@ -1421,6 +1674,31 @@ srfTriangles_t *R_CreateTurboShadowVolume( const idRenderEntityLocal *ent,
 									 const srfTriangles_t *tri, const idRenderLightLocal *light,
 									 srfCullInfo_t &cullInfo );
 
+// flags of a cached turbo shadow volume
+#define SHADOW_CACHE_VERTEX_PROGRAM		BIT(0)	// R_CreateVertexProgramTurboShadowVolume
+#define SHADOW_CACHE_PROJECTED_CULL		BIT(1)	// r_useShadowProjectedCull
+#define SHADOW_CACHE_NO_CAPS_OPTIMIZE	BIT(2)	// the caps are always drawn
+
+typedef struct {
+	const srfTriangles_t *	tri;
+	int						generation;			// dynamicModelFrameCount of the entity
+	int						flags;
+	idVec3					localLightOrigin;
+	idPlane					localClipPlanes[6];
+} shadowCacheKey_t;
+
+void				R_ShadowCacheKey( const idRenderEntityLocal *ent, const srfTriangles_t *tri, const idRenderLightLocal *light, int flags, shadowCacheKey_t &key );
+// the returned entry is referenced until R_ReleaseCachedShadow
+shadowCacheEntry_t *R_FindCachedShadow( const shadowCacheKey_t &key );
+// the cache takes ownership of shadowTris, which may be NULL if the surface casts no shadow
+shadowCacheEntry_t *R_AddCachedShadow( const shadowCacheKey_t &key, srfTriangles_t *shadowTris );
+srfTriangles_t *	R_CachedShadowTris( const shadowCacheEntry_t *entry );
+void				R_ReleaseCachedShadow( shadowCacheEntry_t *entry );
+// removes the shadows of a surface that is freed
+void				R_PurgeCachedShadows( const srfTriangles_t *tri );
+void				R_PurgeShadowCache( void );
+void				R_ShowShadowCache_f( const idCmdArgs &args );
+
 /*
 ============================================================
 
@@ -1558,6 +1836,9 @@ void R_InitFrameData( void );
 void R_ShutdownFrameData( void );
 int R_CountFrameData( void );
 void R_ToggleSmpFrame( void );
+void R_InitRenderThread( void );
+void R_ShutdownRenderThread( void );
+void R_SyncRenderThread( void );
 void *R_FrameAlloc( int bytes );
 void *R_ClearedFrameAlloc( int bytes );
 void R_FrameFree( void *data );
@@ -1646,6 +1927,9 @@ TR_DEFORM
 */
 
 void R_DeformDrawSurf( drawSurf_t *drawSurf );
+// the deforms of the drawSurfs added between these are evaluated with parallel jobs
+void R_BeginDeformJobs( void );
+void R_FinishDeformJobs( void );
 
 /*
 =============================================================
@@ -1683,6 +1967,7 @@ idScreenRect R_CalcIntersectionScissor( const idRenderLightLocal * lightDef,
 
 #include "RenderWorld_local.h"
 #include "GuiModel.h"
+#include "BufferAllocator.h"
 #include "VertexCache.h"
 
 #endif /* !__TR_LOCAL_H__ */
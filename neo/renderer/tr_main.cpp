@@ -176,42 +176,55 @@ void R_ShowColoredScreenRect( const idScreenRect &rect, int colorIndex ) {
 	}
 }
 
+// written over the memory of the last frame if r_poisonFrameMemory is set
+#define	FRAME_MEMORY_POISON		0xdd
+
+static frameData_t *	smpFrameData[SMP_FRAMES];
+
 /*
 ====================
 R_ToggleSmpFrame
+
+When the back end runs on the render thread it is still executing the
+commands that were just issued, so the front end continues with the other
+frame.  The render thread was synced after it executed that frame, so its
+memory and deferred frees can be released.
 ====================
 */
 void R_ToggleSmpFrame( void ) {
 	if ( r_lockSurfaces.GetBool() ) {
 		return;
 	}
-	R_FreeDeferredTriSurfs( frameData );
 
 	// clear frame-temporary data
 	frameData_t		*frame;
-	frameMemoryBlock_t	*block;
 
 	// update the highwater mark
 	R_CountFrameData();
 
+	if ( tr.renderThreadActive ) {
+		tr.smpFrame = ( tr.smpFrame + 1 ) % SMP_FRAMES;
+	}
+	frameData = smpFrameData[tr.smpFrame];
 	frame = frameData;
 
-	// reset the memory allocation to the first block
-	frame->alloc = frame->memory;
+	R_FreeDeferredTriSurfs( frame );
 
-	// clear all the blocks
-	for ( block = frame->memory ; block ; block = block->next ) {
-		block->used = 0;
+	// fill the memory of the last frame with garbage, so anything that still
+	// references it or expects new frame memory to be cleared stands out
+	if ( r_poisonFrameMemory.GetBool() ) {
+		memset( frame->memory, FRAME_MEMORY_POISON, frame->memoryUsed );
 	}
 
+	// reset the memory allocation to the start of the range
+	frame->memoryUsed = 0;
+
 	R_ClearCommandChain();
 }
 
 
 //=====================================================
 
-#define	MEMORY_BLOCK_SIZE	0x100000
-
 /*
 =====================
 R_ShutdownFrameData
@@ -219,49 +232,51 @@ R_ShutdownFrameData
 */
 void R_ShutdownFrameData( void ) {
 	frameData_t *frame;
-	frameMemoryBlock_t *block;
 
 	// free any current data
-	frame = frameData;
-	if ( !frame ) {
-		return;
-	}
+	for ( int i = 0 ; i < SMP_FRAMES ; i++ ) {
+		frame = smpFrameData[i];
+		if ( !frame ) {
+			continue;
+		}
 
-	R_FreeDeferredTriSurfs( frame );
+		R_FreeDeferredTriSurfs( frame );
 
-	frameMemoryBlock_t *nextBlock;
-	for ( block = frame->memory ; block ; block = nextBlock ) {
-		nextBlock = block->next;
-		Mem_Free( block );
+		Sys_ReleaseMemory( frame->memory, frame->memoryReserved );
+		Mem_Free( frame );
+		smpFrameData[i] = NULL;
 	}
-	Mem_Free( frame );
 	frameData = NULL;
+	tr.smpFrame = 0;
 }
 
 /*
 =====================
 R_InitFrameData
+
+The address range of every smp frame is reserved up front, but
+only the frames that are used get memory committed.
 =====================
 */
 void R_InitFrameData( void ) {
-	int size;
 	frameData_t *frame;
-	frameMemoryBlock_t *block;
 
 	R_ShutdownFrameData();
 
-	frameData = (frameData_t *)Mem_ClearedAlloc( sizeof( *frameData ));
-	frame = frameData;
-	size = MEMORY_BLOCK_SIZE;
-	block = (frameMemoryBlock_t *)Mem_Alloc( size + sizeof( *block ) );
-	if ( !block ) {
-		common->FatalError( "R_InitFrameData: Mem_Alloc() failed" );
+	for ( int i = 0 ; i < SMP_FRAMES ; i++ ) {
+		frame = (frameData_t *)Mem_ClearedAlloc( sizeof( *frame ) );
+		frame->memoryReserved = r_frameMemoryMB.GetInteger() * 1024 * 1024;
+		frame->memory = (byte *)Sys_ReserveMemory( frame->memoryReserved );
+		if ( !frame->memory ) {
+			common->FatalError( "R_InitFrameData: couldn't reserve %i MB of address space", r_frameMemoryMB.GetInteger() );
+		}
+		frame->memoryUsed = 0;
+		frame->memoryCommitted = 0;
+		frame->memoryHighwater = 0;
+		smpFrameData[i] = frame;
 	}
-	block->size = size;
-	block->used = 0;
-	block->next = NULL;
-	frame->memory = block;
-	frame->memoryHighwater = 0;
+	frameData = smpFrameData[0];
+	tr.smpFrame = 0;
 
 	R_ToggleSmpFrame();
 }
@@ -273,20 +288,18 @@ R_CountFrameData
 */
 int R_CountFrameData( void ) {
 	frameData_t		*frame;
-	frameMemoryBlock_t	*block;
 	int				count;
 
-	count = 0;
 	frame = frameData;
-	for ( block = frame->memory ; block ; block=block->next ) {
-		count += block->used;
-		if ( block == frame->alloc ) {
-			break;
-		}
-	}
+	count = frame->memoryUsed;
 
 	// note if this is a new highwater mark
 	if ( count > frame->memoryHighwater ) {
+		// warn once when the reserved range is getting tight
+		int warnSize = frame->memoryReserved / 4 * 3;
+		if ( count > warnSize && frame->memoryHighwater <= warnSize ) {
+			common->Warning( "frame memory highwater at %i of %i bytes, consider raising r_frameMemoryMB", count, frame->memoryReserved );
+		}
 		frame->memoryHighwater = count;
 	}
 
@@ -337,6 +350,40 @@ void R_StaticFree( void *data ) {
     Mem_Free( data );
 }
 
+/*
+================
+R_CommitFrameMemory
+
+Commits the reserved range up to at least end.  Threads that cross
+the committed size at the same time are serialized, the committed size
+is read again under the lock and only the missing pages are committed.
+================
+*/
+static void R_CommitFrameMemory( frameData_t *frame, int end ) {
+	int newCommitted = ( end + FRAME_MEMORY_COMMIT_SIZE - 1 ) & ~( FRAME_MEMORY_COMMIT_SIZE - 1 );
+	if ( newCommitted > frame->memoryReserved ) {
+		newCommitted = frame->memoryReserved;
+	}
+
+	Sys_EnterCriticalSection( CRITICAL_SECTION_FIVE );
+
+	int committed = frame->memoryCommitted;
+	if ( newCommitted <= committed ) {
+		// another thread committed it first
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_FIVE );
+		return;
+	}
+
+	if ( !Sys_CommitMemory( frame->memory + committed, newCommitted - committed ) ) {
+		// printing the error takes the console lock
+		Sys_LeaveCriticalSection( CRITICAL_SECTION_FIVE );
+		common->FatalError( "R_FrameAlloc: couldn't commit %i bytes of frame memory", newCommitted );
+	}
+	frame->memoryCommitted = newCommitted;
+
+	Sys_LeaveCriticalSection( CRITICAL_SECTION_FIVE );
+}
+
 /*
 ================
 R_FrameAlloc
@@ -354,59 +401,33 @@ different frameData than the front end is using.
 All temporary data, like dynamic tesselations
 and local spaces are allocated here.
 
-The memory will not move, but it may not be
-contiguous with previous allocations even
-from this frame.
+The memory will not move, but allocations made
+by other threads may end up in between allocations
+of the same thread.
 
 The memory is NOT zero filled.
-Should part of this be inlined in a macro?
+
+This is lock free and can be called from front end jobs.
 ================
 */
 void *R_FrameAlloc( int bytes ) {
 	frameData_t		*frame;
-	frameMemoryBlock_t	*block;
-	void			*buf;
-    
+	int				end;
+
 	bytes = (bytes+16)&~15;
-	// see if it can be satisfied in the current block
+
 	frame = frameData;
-	block = frame->alloc;
+	end = Sys_InterlockedAdd( frame->memoryUsed, bytes );
 
-	if ( block->size - block->used >= bytes ) {
-		buf = block->base + block->used;
-		block->used += bytes;
-		return buf;
+	if ( end > frame->memoryReserved ) {
+		common->FatalError( "R_FrameAlloc: out of frame memory, raise r_frameMemoryMB (%i)", r_frameMemoryMB.GetInteger() );
 	}
 
-	// advance to the next memory block if available
-	block = block->next;
-	// create a new block if we are at the end of
-	// the chain
-	if ( !block ) {
-		int		size;
-
-		size = MEMORY_BLOCK_SIZE;
-		block = (frameMemoryBlock_t *)Mem_Alloc( size + sizeof( *block ) );
-		if ( !block ) {
-			common->FatalError( "R_FrameAlloc: Mem_Alloc() failed" );
-		}
-		block->size = size;
-		block->used = 0;
-		block->next = NULL;
-		frame->alloc->next = block;
+	if ( end > frame->memoryCommitted ) {
+		R_CommitFrameMemory( frame, end );
 	}
 
-	// we could fix this if we needed to...
-	if ( bytes > block->size ) {
-		common->FatalError( "R_FrameAlloc of %i exceeded MEMORY_BLOCK_SIZE",
-			bytes );
-	}
-
-	frame->alloc = block;
-
-	block->used = bytes;
-
-	return block->base;
+	return frame->memory + end - bytes;
 }
 
 /*
@@ -654,12 +675,12 @@ bool R_CornerCullLocalBox( const idBounds &bounds, const float* modelMatrix, int
 		}
 		if ( j == 8 ) {
 			// all points were behind one of the planes
-			tr.pc.c_box_cull_out++;
+			R_JobCounters().c_box_cull_out++;
 			return true;
 		}
 	}
 
-	tr.pc.c_box_cull_in++;
+	R_JobCounters().c_box_cull_in++;
 
 	return false;		// not culled
 }
@@ -1083,6 +1104,21 @@ static void R_SortDrawSurfs( void ) {
 
 
 
+/*
+================
+R_MergeJobCounters
+================
+*/
+void R_MergeJobCounters( void ) {
+	for ( int i = 0 ; i <= MAX_JOB_THREADS ; i++ ) {
+		jobCounters_t &counters = tr.jobCounters[i];
+		tr.pc.c_box_cull_in += counters.c_box_cull_in;
+		tr.pc.c_box_cull_out += counters.c_box_cull_out;
+		tr.pc.c_tangentIndexes += counters.c_tangentIndexes;
+		memset( &counters, 0, sizeof( counters ) );
+	}
+}
+
 /*
 ================
 R_RenderView
@@ -1120,9 +1156,16 @@ void R_RenderView( viewDef_t *parms ) {
 	// portal-to-screen scissor box calculations
 	R_SetupProjection();
 
+	double ticks = Sys_GetClockTicks();
+
 	// identify all the visible portalAreas, and the entityDefs and
 	// lightDefs that are in them and pass culling.
 	static_cast<idRenderWorldLocal *>(parms->renderWorld)->FindViewLightsAndEntities();
+	ticks = R_StageTicks( tr.pc.portalTicks, ticks );
+
+	// remove the entities and lights that are hidden behind the world
+	R_OcclusionCull();
+	ticks = R_StageTicks( tr.pc.occlusionTicks, ticks );
 
 	// constrain the view frustum to the view lights and entities
 	R_ConstrainViewFrustum();
@@ -1131,16 +1174,22 @@ void R_RenderView( viewDef_t *parms ) {
 	// that are visible
 	// add any pre-generated light shadows, and calculate the light shader values
 	R_AddLightSurfaces();
+	ticks = R_StageTicks( tr.pc.lightSurfTicks, ticks );
 
 	// adds ambient surfaces and create any necessary interaction surfaces to add to the light
-	// lists
+	// lists, the deforms of the surfaces are evaluated by jobs afterwards
+	R_BeginDeformJobs();
 	R_AddModelSurfaces();
+	ticks = R_StageTicks( tr.pc.modelSurfTicks, ticks );
+	R_FinishDeformJobs();
+	ticks = R_StageTicks( tr.pc.deformTicks, ticks );
 
 	// any viewLight that didn't have visible surfaces can have it's shadows removed
 	R_RemoveUnecessaryViewLights();
 
 	// sort all the ambient surfaces for translucency ordering
 	R_SortDrawSurfs();
+	R_StageTicks( tr.pc.sortTicks, ticks );
 
 	// generate any subviews (mirrors, cameras, etc) before adding this view
 	if ( R_GenerateSubViews() ) {
@@ -0,0 +1,623 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+/*
+==============================================================================
+
+	Software occlusion culling.
+
+	The large opaque front sided triangles of the world area models are
+	tagged as occluders the first time their area is visible.  After the
+	portal flow found the view entities and lights, the occluders of all
+	visible areas are rasterized into a small depth buffer that keeps the
+	nearest 1/w of each pixel, and every view entity and light whose bounds
+	are behind the buffer over their whole screen rectangle is removed from
+	the view again.  Entities removed this way can still come back as
+	shadow casters when the interactions of the remaining lights are made.
+
+	The test is conservative: an occluder only writes the pixels it covers
+	completely, at the farthest depth of the triangle inside the pixel, so
+	gaps between occluders and pixels on their edges stay open.
+
+==============================================================================
+*/
+
+static float *			occlusionBuffer;
+static int				occlusionWidth;
+static int				occlusionHeight;
+static int				occlusionBufferSize;		// number of floats allocated
+static idList<idVec3>	occlusionVerts;				// clip space x, y and w of the occluder verts
+
+static idMat4			occlusionMatrix;
+static float			occlusionNear;
+
+/*
+==================
+R_FreeAreaOccluder
+==================
+*/
+void R_FreeAreaOccluder( areaOccluder_t *occluder ) {
+	// the arrays are in the same allocation
+	R_StaticFree( occluder );
+}
+
+/*
+==================
+R_OccluderShaderIsTagged
+
+Only surfaces that always hide everything behind them are used.
+==================
+*/
+static bool R_OccluderShaderIsTagged( const idMaterial *shader ) {
+	if ( shader == NULL || !shader->IsDrawn() ) {
+		return false;
+	}
+	if ( shader->Coverage() != MC_OPAQUE || shader->GetSort() != SS_OPAQUE ) {
+		return false;
+	}
+	if ( shader->GetCullType() != CT_FRONT_SIDED || shader->Deform() != DFRM_NONE || shader->HasSubview() ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+==================
+R_CreateAreaOccluder
+
+Collects the occluder triangles of the area model, the planes are stored for back face culling.
+An area without any gets an empty occluder so it is only checked once.
+==================
+*/
+static areaOccluder_t *R_CreateAreaOccluder( const idRenderModel *model ) {
+	int				i, j, s;
+	int				numVerts, numIndexes;
+	float			minArea;
+	int *			vertRemap;
+	areaOccluder_t *occluder;
+	byte *			data;
+
+	minArea = r_occluderMinArea.GetFloat();
+
+	// count the triangles and verts that are used
+	numVerts = 0;
+	numIndexes = 0;
+	for ( s = 0; s < model->NumSurfaces(); s++ ) {
+		const modelSurface_t *surf = model->Surface( s );
+		const srfTriangles_t *tri = surf->geometry;
+
+		if ( tri == NULL || !R_OccluderShaderIsTagged( surf->shader ) ) {
+			continue;
+		}
+		for ( i = 0; i < tri->numIndexes; i += 3 ) {
+			const idVec3 &a = tri->verts[tri->indexes[i+0]].xyz;
+			const idVec3 &b = tri->verts[tri->indexes[i+1]].xyz;
+			const idVec3 &c = tri->verts[tri->indexes[i+2]].xyz;
+			if ( 0.5f * ( ( b - a ).Cross( c - a ) ).Length() >= minArea ) {
+				numIndexes += 3;
+			}
+		}
+		numVerts += tri->numVerts;
+	}
+
+	data = (byte *)R_StaticAlloc( sizeof( *occluder ) + numVerts * sizeof( idVec3 ) +
+								numIndexes * sizeof( int ) + ( numIndexes / 3 ) * sizeof( idPlane ) );
+
+	occluder = (areaOccluder_t *)data;
+	occluder->verts = (idVec3 *)( occluder + 1 );
+	occluder->indexes = (int *)( occluder->verts + numVerts );
+	occluder->planes = (idPlane *)( occluder->indexes + numIndexes );
+	occluder->numVerts = 0;
+	occluder->numIndexes = 0;
+
+	if ( numIndexes == 0 ) {
+		return occluder;
+	}
+
+	for ( s = 0; s < model->NumSurfaces(); s++ ) {
+		const modelSurface_t *surf = model->Surface( s );
+		const srfTriangles_t *tri = surf->geometry;
+
+		if ( tri == NULL || !R_OccluderShaderIsTagged( surf->shader ) ) {
+			continue;
+		}
+
+		vertRemap = (int *)R_StaticAlloc( tri->numVerts * sizeof( vertRemap[0] ) );
+		memset( vertRemap, -1, tri->numVerts * sizeof( vertRemap[0] ) );
+
+		for ( i = 0; i < tri->numIndexes; i += 3 ) {
+			const idVec3 &a = tri->verts[tri->indexes[i+0]].xyz;
+			const idVec3 &b = tri->verts[tri->indexes[i+1]].xyz;
+			const idVec3 &c = tri->verts[tri->indexes[i+2]].xyz;
+
+			idVec3 d0 = b - a;
+			idVec3 d1 = c - a;
+			idVec3 n = d1.Cross( d0 );
+			if ( 0.5f * n.Length() < minArea ) {
+				continue;
+			}
+
+			// same facing as R_CalcInteractionFacing, the positive side is the visible side
+			idPlane &plane = occluder->planes[occluder->numIndexes / 3];
+			n.Normalize();
+			plane.SetNormal( n );
+			plane.FitThroughPoint( a );
+
+			for ( j = 0; j < 3; j++ ) {
+				int v = tri->indexes[i+j];
+				if ( vertRemap[v] == -1 ) {
+					vertRemap[v] = occluder->numVerts;
+					occluder->verts[occluder->numVerts++] = tri->verts[v].xyz;
+				}
+				occluder->indexes[occluder->numIndexes++] = vertRemap[v];
+			}
+		}
+
+		R_StaticFree( vertRemap );
+	}
+
+	return occluder;
+}
+
+/*
+==================
+R_AreaOccluder
+==================
+*/
+static const areaOccluder_t *R_AreaOccluder( idRenderWorldLocal *rw, int areaNum ) {
+	portalArea_t *area = &rw->portalAreas[areaNum];
+
+	if ( area->occluder == NULL ) {
+		// the world model entities are the first entityDefs, one for each area
+		const idRenderEntityLocal *def = ( areaNum < rw->entityDefs.Num() ) ? rw->entityDefs[areaNum] : NULL;
+		if ( def == NULL || def->parms.hModel == NULL || !def->parms.hModel->IsStaticWorldModel() ) {
+			return NULL;
+		}
+		area->occluder = R_CreateAreaOccluder( def->parms.hModel );
+	}
+
+	return area->occluder;
+}
+
+/*
+==================
+R_OcclusionClipPoint
+==================
+*/
+static ID_INLINE void R_OcclusionClipPoint( const idVec3 &point, idVec3 &clip ) {
+	const float *m = occlusionMatrix.ToFloatPtr();
+
+	clip[0] = point[0] * m[0*4+0] + point[1] * m[1*4+0] + point[2] * m[2*4+0] + m[3*4+0];
+	clip[1] = point[0] * m[0*4+1] + point[1] * m[1*4+1] + point[2] * m[2*4+1] + m[3*4+1];
+	clip[2] = point[0] * m[0*4+3] + point[1] * m[1*4+3] + point[2] * m[2*4+3] + m[3*4+3];
+}
+
+/*
+==================
+R_OcclusionClipToScreen
+
+Clip space x, y, w to buffer x, y and 1/w
+==================
+*/
+static ID_INLINE void R_OcclusionClipToScreen( const idVec3 &clip, idVec3 &screen ) {
+	float invW = 1.0f / clip[2];
+
+	screen[0] = ( clip[0] * invW * 0.5f + 0.5f ) * occlusionWidth;
+	screen[1] = ( clip[1] * invW * 0.5f + 0.5f ) * occlusionHeight;
+	screen[2] = invW;
+}
+
+/*
+==================
+R_OcclusionEdgeX
+==================
+*/
+static ID_INLINE float R_OcclusionEdgeX( const idVec3 &p, const idVec3 &q, float y ) {
+	if ( q[1] == p[1] ) {
+		return q[0];
+	}
+	return p[0] + ( q[0] - p[0] ) * ( y - p[1] ) / ( q[1] - p[1] );
+}
+
+/*
+==================
+R_OcclusionSpan
+
+x range of the y sorted triangle at y
+==================
+*/
+static ID_INLINE void R_OcclusionSpan( const idVec3 &v0, const idVec3 &v1, const idVec3 &v2, float y, float &xa, float &xb ) {
+	// the long edge and one of the short edges
+	xa = R_OcclusionEdgeX( v0, v2, y );
+	if ( y <= v1[1] ) {
+		xb = R_OcclusionEdgeX( v0, v1, y );
+	} else {
+		xb = R_OcclusionEdgeX( v1, v2, y );
+	}
+	if ( xa > xb ) {
+		float f = xa; xa = xb; xb = f;
+	}
+}
+
+/*
+==================
+R_RasterizeOcclusionTriangle
+
+Scan converts a screen space triangle, only pixels that are completely inside are covered.
+The triangle is convex, so the span covered by a whole pixel row is the intersection of
+the spans at the top and the bottom of the row.
+==================
+*/
+static void R_RasterizeOcclusionTriangle( const idVec3 &a, const idVec3 &b, const idVec3 &c ) {
+	const idVec3 *v0, *v1, *v2, *t;
+	float area, dzdx, dzdy, bias;
+	int y, y0, y1, x0, x1;
+
+	area = ( b[0] - a[0] ) * ( c[1] - a[1] ) - ( c[0] - a[0] ) * ( b[1] - a[1] );
+	if ( idMath::Fabs( area ) < 1e-4f ) {
+		return;
+	}
+
+	// 1/w is linear in screen space
+	dzdx = ( ( b[2] - a[2] ) * ( c[1] - a[1] ) - ( c[2] - a[2] ) * ( b[1] - a[1] ) ) / area;
+	dzdy = ( ( c[2] - a[2] ) * ( b[0] - a[0] ) - ( b[2] - a[2] ) * ( c[0] - a[0] ) ) / area;
+
+	// the farthest depth of the plane inside a pixel
+	bias = 0.5f * ( idMath::Fabs( dzdx ) + idMath::Fabs( dzdy ) );
+
+	// sort by y
+	v0 = &a;
+	v1 = &b;
+	v2 = &c;
+	if ( (*v1)[1] < (*v0)[1] ) { t = v0; v0 = v1; v1 = t; }
+	if ( (*v2)[1] < (*v1)[1] ) { t = v1; v1 = v2; v2 = t; }
+	if ( (*v1)[1] < (*v0)[1] ) { t = v0; v0 = v1; v1 = t; }
+
+	// rows that are completely inside the y range of the triangle
+	y0 = Max( 0, (int)idMath::Ceil( (*v0)[1] ) );
+	y1 = Min( occlusionHeight, (int)idMath::Floor( (*v2)[1] ) );
+
+	for ( y = y0; y < y1; y++ ) {
+		float xa, xb, xc, xd;
+
+		R_OcclusionSpan( *v0, *v1, *v2, (float)y, xa, xb );
+		R_OcclusionSpan( *v0, *v1, *v2, (float)( y + 1 ), xc, xd );
+
+		x0 = (int)idMath::Ceil( Max( Max( xa, xc ), 0.0f ) );
+		x1 = (int)idMath::Floor( Min( Min( xb, xd ), (float)occlusionWidth ) );
+		if ( x1 <= x0 ) {
+			continue;
+		}
+
+		float z = a[2] + dzdx * ( x0 + 0.5f - a[0] ) + dzdy * ( y + 0.5f - a[1] ) - bias;
+		SIMDProcessor->DepthSpanMax( occlusionBuffer + y * occlusionWidth + x0, z, dzdx, x1 - x0 );
+	}
+}
+
+/*
+==================
+R_RasterizeOccluder
+==================
+*/
+static void R_RasterizeOccluder( const areaOccluder_t *occluder, const idVec3 &viewOrigin ) {
+	int		i, j, k, numClipped;
+	float	d[3];
+	idVec3	clipped[4], screen[4];
+
+	occlusionVerts.SetNum( occluder->numVerts, false );
+	idVec3 *clip = occlusionVerts.Ptr();
+
+	for ( i = 0; i < occluder->numVerts; i++ ) {
+		R_OcclusionClipPoint( occluder->verts[i], clip[i] );
+	}
+
+	for ( i = 0; i < occluder->numIndexes; i += 3 ) {
+		// skip back faces
+		if ( occluder->planes[i / 3].Distance( viewOrigin ) <= 0.0f ) {
+			continue;
+		}
+
+		const idVec3 *v[3] = { &clip[occluder->indexes[i+0]], &clip[occluder->indexes[i+1]], &clip[occluder->indexes[i+2]] };
+
+		// clip to the near plane
+		numClipped = 0;
+		for ( j = 0; j < 3; j++ ) {
+			d[j] = (*v[j])[2] - occlusionNear;
+		}
+		for ( j = 0; j < 3; j++ ) {
+			k = ( j + 1 ) % 3;
+			if ( d[j] >= 0.0f ) {
+				clipped[numClipped++] = *v[j];
+			}
+			if ( ( d[j] >= 0.0f ) != ( d[k] >= 0.0f ) ) {
+				float f = d[j] / ( d[j] - d[k] );
+				clipped[numClipped++] = *v[j] + ( *v[k] - *v[j] ) * f;
+			}
+		}
+		if ( numClipped < 3 ) {
+			continue;
+		}
+
+		tr.pc.c_occluderTris++;
+
+		for ( j = 0; j < numClipped; j++ ) {
+			R_OcclusionClipToScreen( clipped[j], screen[j] );
+		}
+		for ( j = 2; j < numClipped; j++ ) {
+			R_RasterizeOcclusionTriangle( screen[0], screen[j-1], screen[j] );
+		}
+	}
+}
+
+/*
+==================
+R_OcclusionTestPoints
+
+Returns true if the box spanned by the points is completely behind the occluders.
+==================
+*/
+static bool R_OcclusionTestPoints( const idVec3 points[8] ) {
+	int		i, y, x0, x1, y0, y1;
+	float	z;
+	idVec3	clip, screen;
+	idBounds rect;
+
+	rect.Clear();
+	z = 0.0f;
+	for ( i = 0; i < 8; i++ ) {
+		R_OcclusionClipPoint( points[i], clip );
+
+		// crossing the near plane
+		if ( clip[2] < occlusionNear ) {
+			return false;
+		}
+
+		R_OcclusionClipToScreen( clip, screen );
+		rect.AddPoint( screen );
+		z = Max( z, screen[2] );
+	}
+
+	x0 = (int)idMath::Floor( Max( rect[0][0], 0.0f ) );
+	x1 = (int)idMath::Floor( Min( rect[1][0], occlusionWidth - 1.0f ) );
+	y0 = (int)idMath::Floor( Max( rect[0][1], 0.0f ) );
+	y1 = (int)idMath::Floor( Min( rect[1][1], occlusionHeight - 1.0f ) );
+
+	// off screen boxes are left to the frustum culling
+	if ( x1 < x0 || y1 < y0 ) {
+		return false;
+	}
+
+	for ( y = y0; y <= y1; y++ ) {
+		if ( SIMDProcessor->DepthSpanTest( occlusionBuffer + y * occlusionWidth + x0, z, x1 - x0 + 1 ) ) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+==================
+R_OcclusionCull
+
+Removes the view entities and lights that are hidden behind the world.
+==================
+*/
+void R_OcclusionCull( void ) {
+	int					i;
+	idVec3				points[8];
+	idRenderWorldLocal *rw;
+
+	if ( !r_useOcclusionCulling.GetBool() ) {
+		return;
+	}
+
+	rw = static_cast<idRenderWorldLocal *>( tr.viewDef->renderWorld );
+
+	// mirrors clip away the geometry between the view and the mirror
+	if ( rw == NULL || tr.viewDef->areaNum < 0 || tr.viewDef->isMirror || tr.viewDef->isXraySubview || tr.viewDef->numClipPlanes > 0 ) {
+		return;
+	}
+
+	// the occluders are tagged again with a different size
+	if ( r_occluderMinArea.IsModified() ) {
+		r_occluderMinArea.ClearModified();
+		for ( int j = 0; j < tr.worlds.Num(); j++ ) {
+			idRenderWorldLocal *world = tr.worlds[j];
+			for ( i = 0; i < world->numPortalAreas; i++ ) {
+				R_FreeAreaOccluder( world->portalAreas[i].occluder );
+				world->portalAreas[i].occluder = NULL;
+			}
+		}
+	}
+
+	// the buffer has the aspect ratio of the viewport
+	int viewWidth = tr.viewDef->viewport.x2 - tr.viewDef->viewport.x1 + 1;
+	int viewHeight = tr.viewDef->viewport.y2 - tr.viewDef->viewport.y1 + 1;
+	occlusionWidth = Min( r_occlusionBufferWidth.GetInteger(), viewWidth );
+	occlusionHeight = Max( 1, occlusionWidth * viewHeight / Max( viewWidth, 1 ) );
+
+	if ( occlusionWidth * occlusionHeight > occlusionBufferSize ) {
+		Mem_Free16( occlusionBuffer );
+		occlusionBufferSize = occlusionWidth * occlusionHeight;
+		occlusionBuffer = (float *)Mem_Alloc16( occlusionBufferSize * sizeof( occlusionBuffer[0] ) );
+	}
+	SIMDProcessor->Memset( occlusionBuffer, 0, occlusionWidth * occlusionHeight * sizeof( occlusionBuffer[0] ) );
+
+	occlusionMatrix = tr.viewDef->worldSpace.modelViewMatrix * tr.viewDef->projectionMatrix;
+	occlusionNear = r_znear.GetFloat();
+	if ( tr.viewDef->renderView.cramZNear ) {
+		occlusionNear *= 0.25f;
+	}
+
+	// rasterize the occluders of the areas the portal flow reached
+	bool haveOccluders = false;
+	for ( i = 0; i < rw->numPortalAreas; i++ ) {
+		if ( rw->portalAreas[i].viewCount != tr.viewCount ) {
+			continue;
+		}
+		const areaOccluder_t *occluder = R_AreaOccluder( rw, i );
+		if ( occluder == NULL || occluder->numIndexes == 0 ) {
+			continue;
+		}
+		R_RasterizeOccluder( occluder, tr.viewDef->renderView.vieworg );
+		haveOccluders = true;
+	}
+	if ( !haveOccluders ) {
+		return;
+	}
+
+	// entities, the occluders themselves and weapons are never culled
+	viewEntity_t **prevEntity = &tr.viewDef->viewEntitys;
+	while ( *prevEntity ) {
+		viewEntity_t *vEntity = *prevEntity;
+		idRenderEntityLocal *def = vEntity->entityDef;
+
+		if ( def->index < rw->numPortalAreas || def->parms.weaponDepthHack || def->parms.modelDepthHack != 0.0f ) {
+			prevEntity = &vEntity->next;
+			continue;
+		}
+
+		tr.pc.c_occlusionTestedEntities++;
+
+		for ( i = 0; i < 8; i++ ) {
+			idVec3 v( def->referenceBounds[i&1][0], def->referenceBounds[(i>>1)&1][1], def->referenceBounds[(i>>2)&1][2] );
+			R_LocalPointToGlobal( def->modelMatrix, v, points[i] );
+		}
+		if ( !R_OcclusionTestPoints( points ) ) {
+			prevEntity = &vEntity->next;
+			continue;
+		}
+
+		tr.pc.c_occlusionCulledEntities++;
+
+		if ( r_showOcclusion.GetInteger() >= 2 ) {
+			idBounds bounds;
+			bounds.FromTransformedBounds( def->referenceBounds, def->parms.origin, def->parms.axis );
+			rw->DebugBounds( colorRed, bounds );
+		}
+
+		// a light may still add it back as a shadow caster
+		*prevEntity = vEntity->next;
+		def->viewCount = tr.viewCount - 1;
+		def->viewEntity = NULL;
+	}
+
+	viewLight_t **prevLight = &tr.viewDef->viewLights;
+	while ( *prevLight ) {
+		viewLight_t *vLight = *prevLight;
+		idRenderLightLocal *light = vLight->lightDef;
+
+		tr.pc.c_occlusionTestedLights++;
+
+		// nothing the light touches can be seen if its whole volume is hidden
+		const idBounds &bounds = light->frustumTris->bounds;
+		for ( i = 0; i < 8; i++ ) {
+			points[i].Set( bounds[i&1][0], bounds[(i>>1)&1][1], bounds[(i>>2)&1][2] );
+		}
+		if ( !R_OcclusionTestPoints( points ) ) {
+			prevLight = &vLight->next;
+			continue;
+		}
+
+		tr.pc.c_occlusionCulledLights++;
+
+		if ( r_showOcclusion.GetInteger() >= 2 ) {
+			rw->DebugBounds( colorMagenta, bounds );
+		}
+
+		*prevLight = vLight->next;
+		light->viewCount = tr.viewCount - 1;
+		light->viewLight = NULL;
+	}
+}
+
+/*
+==================
+R_ShutdownOcclusion
+==================
+*/
+void R_ShutdownOcclusion( void ) {
+	Mem_Free16( occlusionBuffer );
+	occlusionBuffer = NULL;
+	occlusionBufferSize = 0;
+	occlusionWidth = 0;
+	occlusionHeight = 0;
+	occlusionVerts.Clear();
+}
+
+/*
+==================
+R_WriteOcclusionBuffer_f
+
+Writes the occlusion depth buffer of the last culled view as a gray scale image, nearer is brighter.
+==================
+*/
+void R_WriteOcclusionBuffer_f( const idCmdArgs &args ) {
+	int		i, numPixels;
+	float	maxDepth, scale;
+	byte *	rgba;
+	idStr	fileName;
+
+	if ( occlusionBuffer == NULL || occlusionWidth == 0 ) {
+		common->Printf( "No occlusion buffer.\n" );
+		return;
+	}
+
+	fileName = ( args.Argc() > 1 ) ? args.Argv( 1 ) : "occlusion";
+	fileName.DefaultFileExtension( ".tga" );
+
+	numPixels = occlusionWidth * occlusionHeight;
+
+	maxDepth = 0.0f;
+	for ( i = 0; i < numPixels; i++ ) {
+		maxDepth = Max( maxDepth, occlusionBuffer[i] );
+	}
+	scale = ( maxDepth > 0.0f ) ? 255.0f / maxDepth : 0.0f;
+
+	rgba = (byte *)R_StaticAlloc( numPixels * 4 );
+	for ( i = 0; i < numPixels; i++ ) {
+		byte b = (byte)idMath::FtoiFast( Max( occlusionBuffer[i], 0.0f ) * scale );
+		rgba[i*4+0] = b;
+		rgba[i*4+1] = b;
+		rgba[i*4+2] = b;
+		rgba[i*4+3] = 255;
+	}
+
+	// the first row is the bottom of the view
+	R_WriteTGA( fileName, rgba, occlusionWidth, occlusionHeight, true );
+
+	R_StaticFree( rgba );
+
+	common->Printf( "Wrote %s, %i x %i\n", fileName.c_str(), occlusionWidth, occlusionHeight );
+}
@@ -631,19 +631,12 @@ interaction into primitive interactions
 =============
 */
 void RB_CreateSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInteraction)(const drawInteraction_t *) ) {
-	const idMaterial	*surfaceShader = surf->material;
-	const float			*surfaceRegs = surf->shaderRegisters;
-	const viewLight_t	*vLight = backEnd.vLight;
-	const idMaterial	*lightShader = vLight->lightShader;
-	const float			*lightRegs = vLight->shaderRegisters;
-	drawInteraction_t	inter;
-
 	if ( r_skipInteractions.GetBool() || !surf->geo || !surf->geo->ambientCache ) {
 		return;
 	}
 
 	if ( tr.logFile ) {
-		RB_LogComment( "---------- RB_CreateSingleDrawInteractions %s on %s ----------\n", lightShader->GetName(), surfaceShader->GetName() );
+		RB_LogComment( "---------- RB_CreateSingleDrawInteractions %s on %s ----------\n", backEnd.vLight->lightShader->GetName(), surf->material->GetName() );
 	}
 
 	// change the matrix and light projection vectors if needed
@@ -652,8 +645,6 @@ void RB_CreateSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInterac
         //#TODO_SK: upload surf->space->modelViewMatrix ??? 
 	}
 
-    inter.modelViewProj = surf->space->modelViewMatrix * backEnd.viewDef->projectionMatrix;
-
 	// change the scissor if needed
 	if ( r_useScissor.GetBool() && !backEnd.currentScissor.Equals( surf->scissorRect ) ) {
 		backEnd.currentScissor = surf->scissorRect;
@@ -672,6 +663,36 @@ void RB_CreateSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInterac
 		RB_EnterModelDepthHack( surf->space->modelDepthHack );
 	}
 
+	RB_DecomposeSingleDrawInteractions( surf, DrawInteraction );
+
+	// unhack depth range if needed
+	if ( surf->space->weaponDepthHack || surf->space->modelDepthHack != 0.0f ) {
+		RB_LeaveDepthHack();
+	}
+}
+
+/*
+=============
+RB_DecomposeSingleDrawInteractions
+
+Only generates the primitive interactions, without setting the scissor or
+depth range of the surface, for back ends that defer the drawing
+=============
+*/
+void RB_DecomposeSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInteraction)(const drawInteraction_t *) ) {
+	const idMaterial	*surfaceShader = surf->material;
+	const float			*surfaceRegs = surf->shaderRegisters;
+	const viewLight_t	*vLight = backEnd.vLight;
+	const idMaterial	*lightShader = vLight->lightShader;
+	const float			*lightRegs = vLight->shaderRegisters;
+	drawInteraction_t	inter;
+
+	if ( r_skipInteractions.GetBool() || !surf->geo || !surf->geo->ambientCache ) {
+		return;
+	}
+
+    inter.modelViewProj = surf->space->modelViewMatrix * backEnd.viewDef->projectionMatrix;
+
 	inter.surf = surf;
 	inter.lightFalloffImage = vLight->falloffImage;
 
@@ -780,11 +801,6 @@ void RB_CreateSingleDrawInteractions( const drawSurf_t *surf, void (*DrawInterac
 		// draw the final interaction
 		RB_SubmittInteraction( &inter, DrawInteraction );
 	}
-
-	// unhack depth range if needed
-	if ( surf->space->weaponDepthHack || surf->space->modelDepthHack != 0.0f ) {
-		RB_LeaveDepthHack();
-	}
 }
 
 /*
@@ -0,0 +1,535 @@
+/*
+===========================================================================
+
+Doom 3 GPL Source Code
+Copyright (C) 1999-2011 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Doom 3 GPL Source Code (?Doom 3 Source Code?).  
+
+Doom 3 Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Doom 3 Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Doom 3 Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Doom 3 Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Doom 3 Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+#include "../idlib/precompiled.h"
+#pragma hdrstop
+
+#include "tr_local.h"
+
+/*
+
+Shadow maps are only drawn by the GL 3.3 back end. The interactions of a shadow
+mapped light don't create any shadow volumes, instead the surfaces that would have
+cast them are linked on viewLight_t::shadowMapCasters and drawn into the depth maps
+of the light right before its interactions.
+
+Projected lights get a single perspective view, parallel lights get up to
+MAX_SHADOWMAP_CASCADES orthographic views that each cover a part of the view
+distance. Both are placed in a shared atlas. Point lights use the six faces of a
+cube map, which is drawn again for every point light.
+
+*/
+
+// the cube map faces in GL order, the direction they look at and their up vector
+static const float shadowCubeFaces[6][2][3] = {
+	{ {  1,  0,  0 }, { 0, -1,  0 } },
+	{ { -1,  0,  0 }, { 0, -1,  0 } },
+	{ {  0,  1,  0 }, { 0,  0,  1 } },
+	{ {  0, -1,  0 }, { 0,  0, -1 } },
+	{ {  0,  0,  1 }, { 0, -1,  0 } },
+	{ {  0,  0, -1 }, { 0, -1,  0 } }
+};
+
+// fraction of the cascade splits that is logarithmic instead of linear
+static const float SHADOWMAP_CASCADE_LOG_SPLIT = 0.75f;
+
+/*
+====================
+R_CheckShadowMapMode
+
+Interactions of shadow mapped lights don't have shadow volumes, so they
+have to be regenerated when the lights switch between the two
+====================
+*/
+void R_CheckShadowMapMode( void ) {
+	int mode = r_shadowMaps.GetInteger();
+	if ( mode < 0 || mode > 2 || tr.backEndRenderer != BE_GL33 ) {
+		mode = 0;
+	}
+
+	if ( mode == tr.shadowMapMode ) {
+		return;
+	}
+	tr.shadowMapMode = mode;
+
+	if ( tr.worlds.Num() ) {
+		// the back end may still be drawing the old interactions
+		R_SyncRenderThread();
+		R_RegenerateWorld_f( idCmdArgs() );
+	}
+}
+
+/*
+====================
+R_LightUsesShadowMap
+
+The light material can request shadow maps with the "shadowMap" keyword
+====================
+*/
+bool R_LightUsesShadowMap( const idRenderLightLocal *light ) {
+	switch ( tr.shadowMapMode ) {
+	case 1:
+		return light->lightShader->TestMaterialFlag( MF_SHADOWMAP );
+	case 2:
+		return true;
+	}
+	return false;
+}
+
+/*
+====================
+R_ShadowMapMatrix
+
+Puts the rows of a transform in the layout the back end uploads
+====================
+*/
+static void R_ShadowMapMatrix( const idPlane rows[4], idMat4 &m ) {
+	for ( int r = 0 ; r < 4 ; r++ ) {
+		for ( int c = 0 ; c < 4 ; c++ ) {
+			m[c][r] = rows[r][c];
+		}
+	}
+}
+
+/*
+====================
+R_ScalePlane
+====================
+*/
+static idPlane R_ScalePlane( const idPlane &p, float scale ) {
+	return idPlane( p[0] * scale, p[1] * scale, p[2] * scale, p[3] * scale );
+}
+
+/*
+====================
+R_ShadowMapTextureMatrix
+
+Maps the clip space of the view to its place in the atlas
+====================
+*/
+static void R_ShadowMapTextureMatrix( const idPlane clip[4], shadowMapView_t *view, int atlasSize ) {
+	idPlane	rows[4];
+	float	scale = 0.5f * view->size / atlasSize;
+
+	rows[0] = R_ScalePlane( clip[0], scale ) + R_ScalePlane( clip[3], ( view->x + 0.5f * view->size ) / atlasSize );
+	rows[1] = R_ScalePlane( clip[1], scale ) + R_ScalePlane( clip[3], ( view->y + 0.5f * view->size ) / atlasSize );
+	rows[2] = R_ScalePlane( clip[2] + clip[3], 0.5f );
+	rows[3] = clip[3];
+
+	R_ShadowMapMatrix( rows, view->textureMatrix );
+}
+
+/*
+====================
+R_SetupProjectedShadowMap
+
+The light projection already maps to the light texture, only the depth
+is missing. Q grows linearly with the distance along the light target.
+====================
+*/
+static void R_SetupProjectedShadowMap( viewLight_t *vLight ) {
+	const idRenderLightLocal *light = vLight->lightDef;
+	const srfTriangles_t *tri = light->frustumTris;
+	const idPlane *project = light->lightProject;
+	shadowMapView_t *view = &vLight->shadowMapViews[0];
+
+	// the depth range of the light frustum
+	float qNear = idMath::INFINITY;
+	float qFar = 0.0f;
+	for ( int i = 0 ; i < tri->numVerts ; i++ ) {
+		float q = project[2].Distance( tri->verts[i].xyz );
+		qNear = Min( qNear, q );
+		qFar = Max( qFar, q );
+	}
+	if ( qFar <= 0.0f ) {
+		vLight->shadowMapType = SHADOWMAP_NONE;
+		return;
+	}
+	qNear = Max( qNear, qFar * 0.001f );
+
+	// z / w goes from -1 at qNear to 1 at qFar
+	float a = ( qFar + qNear ) / ( qFar - qNear );
+	float b = -2.0f * qFar * qNear / ( qFar - qNear );
+
+	idPlane	clip[4];
+	clip[0] = R_ScalePlane( project[0], 2.0f ) - project[2];
+	clip[1] = R_ScalePlane( project[1], 2.0f ) - project[2];
+	clip[2] = R_ScalePlane( project[2], a );
+	clip[2][3] += b;
+	clip[3] = project[2];
+
+	vLight->numShadowMapViews = 1;
+	R_ShadowMapMatrix( clip, view->viewProjection );
+
+	// the casters have already been culled to the light frustum
+	view->numCullPlanes = 0;
+}
+
+/*
+====================
+R_SetupCascadedShadowMap
+
+Each cascade is a box along the light direction around a slice of the view frustum.
+The box has a constant size and moves in whole texels, so the shadow edges don't
+swim when the view turns or moves.
+====================
+*/
+static void R_SetupCascadedShadowMap( viewLight_t *vLight ) {
+	const idRenderLightLocal *light = vLight->lightDef;
+	const srfTriangles_t *tri = light->frustumTris;
+	const renderView_t &rv = tr.viewDef->renderView;
+
+	idVec3 dir = light->parms.origin - light->globalLightOrigin;
+	dir.Normalize();
+	idVec3 right, up;
+	dir.OrthogonalBasis( right, up );
+
+	// the depth range of the light volume, casters can be anywhere in it
+	float zMin = idMath::INFINITY;
+	float zMax = -idMath::INFINITY;
+	for ( int i = 0 ; i < tri->numVerts ; i++ ) {
+		float z = tri->verts[i].xyz * dir;
+		zMin = Min( zMin, z );
+		zMax = Max( zMax, z );
+	}
+	if ( zMax - zMin < 1.0f ) {
+		vLight->shadowMapType = SHADOWMAP_NONE;
+		return;
+	}
+
+	const idVec3 &forward = rv.viewaxis[0];
+	vLight->shadowMapViewPlane.SetNormal( forward );
+	vLight->shadowMapViewPlane.FitThroughPoint( rv.vieworg );
+
+	int numCascades = idMath::ClampInt( 1, MAX_SHADOWMAP_CASCADES, r_shadowMapCascades.GetInteger() );
+	int size = idMath::ClampInt( r_shadowMapMinSize.GetInteger(), r_shadowMapAtlasSize.GetInteger(), r_shadowMapCascadeSize.GetInteger() );
+	float zNear = r_znear.GetFloat();
+	float zFar = Max( zNear * 2.0f, r_shadowMapCascadeDistance.GetFloat() );
+	float tanX = idMath::Tan( DEG2RAD( rv.fov_x * 0.5f ) );
+	float tanY = idMath::Tan( DEG2RAD( rv.fov_y * 0.5f ) );
+
+	float splitStart = zNear;
+	for ( int i = 0 ; i < numCascades ; i++ ) {
+		float frac = (float)( i + 1 ) / numCascades;
+		float splitEnd = SHADOWMAP_CASCADE_LOG_SPLIT * zNear * idMath::Pow( zFar / zNear, frac )
+						+ ( 1.0f - SHADOWMAP_CASCADE_LOG_SPLIT ) * ( zNear + ( zFar - zNear ) * frac );
+
+		// bounding sphere of the slice of the view frustum
+		idVec3 corners[8];
+		idVec3 center = vec3_origin;
+		for ( int j = 0 ; j < 8 ; j++ ) {
+			float d = ( j & 4 ) ? splitEnd : splitStart;
+			corners[j] = rv.vieworg + forward * d
+						+ rv.viewaxis[1] * ( ( j & 1 ) ? d * tanX : -d * tanX )
+						+ rv.viewaxis[2] * ( ( j & 2 ) ? d * tanY : -d * tanY );
+			center += corners[j];
+		}
+		center *= 1.0f / 8;
+		float radius = 0.0f;
+		for ( int j = 0 ; j < 8 ; j++ ) {
+			radius = Max( radius, ( corners[j] - center ).LengthFast() );
+		}
+		radius = idMath::Ceil( radius );
+
+		// snap the center to the texels
+		float texel = 2.0f * radius / size;
+		float cx = idMath::Floor( ( center * right ) / texel ) * texel;
+		float cy = idMath::Floor( ( center * up ) / texel ) * texel;
+
+		idPlane	clip[4];
+		clip[0] = idPlane( right.x / radius, right.y / radius, right.z / radius, -cx / radius );
+		clip[1] = idPlane( up.x / radius, up.y / radius, up.z / radius, -cy / radius );
+		float zScale = 2.0f / ( zMax - zMin );
+		clip[2] = idPlane( dir.x * zScale, dir.y * zScale, dir.z * zScale, -zMin * zScale - 1.0f );
+		clip[3] = idPlane( 0.0f, 0.0f, 0.0f, 1.0f );
+
+		shadowMapView_t *view = &vLight->shadowMapViews[i];
+		R_ShadowMapMatrix( clip, view->viewProjection );
+		view->size = size;
+
+		view->numCullPlanes = 4;
+		view->cullPlanes[0] = idPlane( right.x, right.y, right.z, -( cx + radius ) );
+		view->cullPlanes[1] = idPlane( -right.x, -right.y, -right.z, cx - radius );
+		view->cullPlanes[2] = idPlane( up.x, up.y, up.z, -( cy + radius ) );
+		view->cullPlanes[3] = idPlane( -up.x, -up.y, -up.z, cy - radius );
+
+		vLight->shadowMapCascadeSplits[i] = splitEnd;
+		splitStart = splitEnd;
+	}
+	for ( int i = numCascades ; i < MAX_SHADOWMAP_CASCADES ; i++ ) {
+		vLight->shadowMapCascadeSplits[i] = splitStart;
+	}
+
+	vLight->numShadowMapViews = numCascades;
+}
+
+/*
+====================
+R_SetupCubeShadowMap
+
+The faces are 90 degree perspective views from the light origin
+====================
+*/
+static void R_SetupCubeShadowMap( viewLight_t *vLight ) {
+	const idRenderLightLocal *light = vLight->lightDef;
+	const srfTriangles_t *tri = light->frustumTris;
+	const idVec3 &origin = light->globalLightOrigin;
+
+	float zFar = 0.0f;
+	for ( int i = 0 ; i < tri->numVerts ; i++ ) {
+		zFar = Max( zFar, ( tri->verts[i].xyz - origin ).LengthFast() );
+	}
+	if ( zFar < 1.0f ) {
+		vLight->shadowMapType = SHADOWMAP_NONE;
+		return;
+	}
+	float zNear = Max( 1.0f, zFar * 0.001f );
+	vLight->shadowMapDepthRange[0] = zNear;
+	vLight->shadowMapDepthRange[1] = zFar;
+
+	float a = ( zFar + zNear ) / ( zFar - zNear );
+	float b = -2.0f * zFar * zNear / ( zFar - zNear );
+	int size = idMath::ClampInt( r_shadowMapMinSize.GetInteger(), r_shadowMapAtlasSize.GetInteger(), r_shadowMapCubeSize.GetInteger() );
+
+	for ( int i = 0 ; i < 6 ; i++ ) {
+		idVec3 target( shadowCubeFaces[i][0][0], shadowCubeFaces[i][0][1], shadowCubeFaces[i][0][2] );
+		idVec3 up( shadowCubeFaces[i][1][0], shadowCubeFaces[i][1][1], shadowCubeFaces[i][1][2] );
+		idVec3 side = target.Cross( up );
+		up = side.Cross( target );
+
+		// eye space looks down -z, so w is the distance along the target
+		idPlane	clip[4];
+		clip[0] = idPlane( side.x, side.y, side.z, -( side * origin ) );
+		clip[1] = idPlane( up.x, up.y, up.z, -( up * origin ) );
+		clip[3] = idPlane( target.x, target.y, target.z, -( target * origin ) );
+		clip[2] = R_ScalePlane( clip[3], a );
+		clip[2][3] += b;
+
+		shadowMapView_t *view = &vLight->shadowMapViews[i];
+		R_ShadowMapMatrix( clip, view->viewProjection );
+		view->x = 0;
+		view->y = 0;
+		view->size = size;
+
+		view->numCullPlanes = 4;
+		idVec3 normals[4] = { side - target, -side - target, up - target, -up - target };
+		for ( int j = 0 ; j < 4 ; j++ ) {
+			normals[j].Normalize();
+			view->cullPlanes[j].SetNormal( normals[j] );
+			view->cullPlanes[j].FitThroughPoint( origin );
+		}
+	}
+
+	vLight->numShadowMapViews = 6;
+}
+
+/*
+====================
+R_SetupShadowMapViews
+
+Called for each light that stays in the view, before the interactions are added
+====================
+*/
+void R_SetupShadowMapViews( viewLight_t *vLight ) {
+	const idRenderLightLocal *light = vLight->lightDef;
+
+	vLight->shadowMapType = SHADOWMAP_NONE;
+	vLight->numShadowMapViews = 0;
+	vLight->shadowMapCasters = NULL;
+
+	if ( !R_LightUsesShadowMap( light ) ) {
+		return;
+	}
+	if ( light->parms.noShadows || !light->lightShader->LightCastsShadows() ) {
+		return;
+	}
+
+	vLight->shadowMapViews = (shadowMapView_t *)R_ClearedFrameAlloc( MAX_SHADOWMAP_VIEWS * sizeof( vLight->shadowMapViews[0] ) );
+
+	if ( light->parms.parallel ) {
+		vLight->shadowMapType = SHADOWMAP_CASCADES;
+		R_SetupCascadedShadowMap( vLight );
+	} else if ( light->parms.pointLight ) {
+		vLight->shadowMapType = SHADOWMAP_CUBE;
+		R_SetupCubeShadowMap( vLight );
+	} else {
+		vLight->shadowMapType = SHADOWMAP_PROJECTED;
+
+		// the map shrinks with the part of the screen the light covers
+		const idScreenRect &viewport = tr.viewDef->viewport;
+		const idScreenRect &scissor = vLight->scissorRect;
+		float frac = (float)( ( scissor.x2 + 1 - scissor.x1 ) * ( scissor.y2 + 1 - scissor.y1 ) )
+					/ ( ( viewport.x2 + 1 - viewport.x1 ) * ( viewport.y2 + 1 - viewport.y1 ) );
+		int maxSize = idMath::ClampInt( r_shadowMapMinSize.GetInteger(), r_shadowMapAtlasSize.GetInteger(), r_shadowMapSize.GetInteger() );
+		int size = idMath::CeilPowerOfTwo( (int)( maxSize * idMath::Sqrt( idMath::ClampFloat( 0.0f, 1.0f, frac ) ) ) );
+		vLight->shadowMapViews[0].size = idMath::ClampInt( r_shadowMapMinSize.GetInteger(), maxSize, size );
+
+		R_SetupProjectedShadowMap( vLight );
+	}
+
+	if ( vLight->shadowMapType == SHADOWMAP_NONE ) {
+		vLight->numShadowMapViews = 0;
+	}
+}
+
+/*
+====================
+R_SortShadowMapViews
+
+Largest first, ties are kept in the order of the lights
+====================
+*/
+static int R_SortShadowMapViews( const void *a, const void *b ) {
+	const shadowMapView_t *va = *(const shadowMapView_t **)a;
+	const shadowMapView_t *vb = *(const shadowMapView_t **)b;
+
+	if ( va->size != vb->size ) {
+		return vb->size - va->size;
+	}
+	return ( va < vb ) ? -1 : ( ( va > vb ) ? 1 : 0 );
+}
+
+/*
+====================
+R_ShadowMapTilePosition
+
+Power of two tiles placed largest first along a Z order curve fill the
+atlas without any gaps, offset counts the smallest tiles in front of it
+====================
+*/
+static void R_ShadowMapTilePosition( int offset, int &x, int &y ) {
+	x = y = 0;
+	for ( int bit = 0 ; offset ; bit++ ) {
+		x |= ( offset & 1 ) << bit;
+		offset >>= 1;
+		y |= ( offset & 1 ) << bit;
+		offset >>= 1;
+	}
+}
+
+/*
+====================
+R_AllocShadowMapAtlas
+
+Places the projected and cascaded views of all lights in the atlas.
+If they don't fit, the largest views are halved until they do, and
+the smallest views are left unshadowed when nothing can shrink anymore.
+====================
+*/
+void R_AllocShadowMapAtlas( void ) {
+	viewLight_t *vLight;
+	int numViews = 0;
+
+	for ( vLight = tr.viewDef->viewLights ; vLight ; vLight = vLight->next ) {
+		if ( vLight->shadowMapType == SHADOWMAP_PROJECTED || vLight->shadowMapType == SHADOWMAP_CASCADES ) {
+			numViews += vLight->numShadowMapViews;
+		}
+	}
+
+	int atlasSize = idMath::CeilPowerOfTwo( Max( r_shadowMapAtlasSize.GetInteger(), 64 ) );
+	int minSize = idMath::CeilPowerOfTwo( idMath::ClampInt( 16, atlasSize, r_shadowMapMinSize.GetInteger() ) );
+	tr.viewDef->shadowMapAtlasSize = atlasSize;
+
+	if ( !numViews ) {
+		return;
+	}
+
+	shadowMapView_t **views = (shadowMapView_t **)_alloca( numViews * sizeof( views[0] ) );
+	numViews = 0;
+	for ( vLight = tr.viewDef->viewLights ; vLight ; vLight = vLight->next ) {
+		if ( vLight->shadowMapType == SHADOWMAP_PROJECTED || vLight->shadowMapType == SHADOWMAP_CASCADES ) {
+			for ( int i = 0 ; i < vLight->numShadowMapViews ; i++ ) {
+				shadowMapView_t *view = &vLight->shadowMapViews[i];
+				view->size = idMath::ClampInt( minSize, atlasSize, idMath::CeilPowerOfTwo( view->size ) );
+				views[numViews++] = view;
+			}
+		}
+	}
+
+	// the atlas holds this many of the smallest tiles
+	int capacity = ( atlasSize / minSize ) * ( atlasSize / minSize );
+	int used;
+	while ( 1 ) {
+		used = 0;
+		int largest = minSize;
+		for ( int i = 0 ; i < numViews ; i++ ) {
+			int tiles = views[i]->size / minSize;
+			used += tiles * tiles;
+			largest = Max( largest, views[i]->size );
+		}
+		if ( used <= capacity || largest == minSize ) {
+			break;
+		}
+		for ( int i = 0 ; i < numViews ; i++ ) {
+			if ( views[i]->size == largest ) {
+				views[i]->size >>= 1;
+			}
+		}
+	}
+
+	qsort( views, numViews, sizeof( views[0] ), R_SortShadowMapViews );
+
+	int offset = 0;
+	for ( int i = 0 ; i < numViews ; i++ ) {
+		shadowMapView_t *view = views[i];
+		int tiles = view->size / minSize;
+		if ( offset + tiles * tiles > capacity ) {
+			// out of space, the light gets no shadows this frame
+			view->size = 0;
+			continue;
+		}
+		int x, y;
+		R_ShadowMapTilePosition( offset, x, y );
+		view->x = x * minSize;
+		view->y = y * minSize;
+		offset += tiles * tiles;
+	}
+
+	// a light with a view that didn't fit doesn't get shadows at all
+	for ( vLight = tr.viewDef->viewLights ; vLight ; vLight = vLight->next ) {
+		if ( vLight->shadowMapType != SHADOWMAP_PROJECTED && vLight->shadowMapType != SHADOWMAP_CASCADES ) {
+			continue;
+		}
+		for ( int i = 0 ; i < vLight->numShadowMapViews ; i++ ) {
+			if ( !vLight->shadowMapViews[i].size ) {
+				vLight->numShadowMapViews = 0;
+				break;
+			}
+		}
+		for ( int i = 0 ; i < vLight->numShadowMapViews ; i++ ) {
+			shadowMapView_t *view = &vLight->shadowMapViews[i];
+			idPlane clip[4];
+			for ( int r = 0 ; r < 4 ; r++ ) {
+				for ( int c = 0 ; c < 4 ; c++ ) {
+					clip[r][c] = view->viewProjection[c][r];
+				}
+			}
+			R_ShadowMapTextureMatrix( clip, view, atlasSize );
+		}
+	}
+}
@@ -127,26 +127,49 @@ If a high order bit is clear, the point is outside the plane (definately negativ
 #define	LIGHT_CLIP_EPSILON		0.1f
 
 #define	MAX_CLIP_SIL_EDGES		2048
-static int	numClipSilEdges;
-static int	clipSilEdges[MAX_CLIP_SIL_EDGES][2];
+#define	MAX_SHADOW_INDEXES		0x18000
+#define	MAX_SHADOW_VERTS		0x18000
 
-// facing will be 0 if forward facing, 1 if backwards facing
-// grabbed with alloca
-static byte	*globalFacing;
+typedef struct {
+	int		frontCapStart;
+	int		rearCapStart;
+	int		silStart;
+	int		end;
+} indexRef_t;
 
-// faceCastsShadow will be 1 if the face is in the projection
-// and facing the apropriate direction
-static byte	*faceCastsShadow;
+// everything needed while a shadow volume is being built, every thread
+// that creates shadow volumes gets its own so shadow jobs can run in parallel
+typedef struct {
+	int			numClipSilEdges;
+	int			clipSilEdges[MAX_CLIP_SIL_EDGES][2];
 
-static int	*remap;
+	// facing will be 0 if forward facing, 1 if backwards facing
+	const byte *globalFacing;
 
-#define	MAX_SHADOW_INDEXES		0x18000
-#define	MAX_SHADOW_VERTS		0x18000
-static int	numShadowIndexes;
-static glIndex_t	shadowIndexes[MAX_SHADOW_INDEXES];
-static int	numShadowVerts;
-static idVec4	shadowVerts[MAX_SHADOW_VERTS];
-static bool overflowed;
+	// faceCastsShadow will be 1 if the face is in the projection
+	// and facing the apropriate direction
+	// grabbed with alloca
+	byte *		faceCastsShadow;
+
+	int *		remap;
+
+	int			numShadowIndexes;
+	glIndex_t	shadowIndexes[MAX_SHADOW_INDEXES];
+	int			numShadowVerts;
+	idVec4		shadowVerts[MAX_SHADOW_VERTS];
+	bool		overflowed;
+
+	bool		callOptimizer;			// call the preprocessor optimizer after clipping occluders
+
+	indexRef_t	indexRef[6];
+	int			indexFrustumNumber;		// which shadow generating side of a light the indexRef is for
+	int			capPlaneBits;
+
+	int			c_caps, c_sils;
+} shadowVolumeScratch_t;
+
+// indexed by job thread slot, the last one is used by threads outside the job system
+static shadowVolumeScratch_t *	shadowScratch[MAX_JOB_THREADS + 2];
 
 idPlane	pointLightFrustums[6][6] = {
 	{
@@ -201,19 +224,6 @@ idPlane	pointLightFrustums[6][6] = {
 	},
 };
 
-int	c_caps, c_sils;
-
-static bool	callOptimizer;			// call the preprocessor optimizer after clipping occluders
-
-typedef struct {
-	int		frontCapStart;
-	int		rearCapStart;
-	int		silStart;
-	int		end;
-} indexRef_t;
-static indexRef_t	indexRef[6];
-static int indexFrustumNumber;		// which shadow generating side of a light the indexRef is for
-
 /*
 ===============
 PointsOrdered
@@ -296,7 +306,7 @@ make a projected copy of the even verts into the odd spots
 that is on the far light clip plane
 ===================
 */
-static void R_ProjectPointsToFarPlane( const idRenderEntityLocal *ent, const idRenderLightLocal *light,
+static void R_ProjectPointsToFarPlane( shadowVolumeScratch_t *sv, const idRenderEntityLocal *ent, const idRenderLightLocal *light,
 									const idPlane &lightPlaneLocal,
 									int firstShadowVert, int numShadowVerts ) {
 	idVec3		lv;
@@ -309,7 +319,7 @@ static void R_ProjectPointsToFarPlane( const idRenderEntityLocal *ent, const idR
 
 #if 1
 	// make a projected copy of the even verts into the odd spots
-	in = &shadowVerts[firstShadowVert];
+	in = &sv->shadowVerts[firstShadowVert];
 	for ( i = firstShadowVert ; i < numShadowVerts ; i+= 2, in += 2 ) {
 		float	w, oow;
 
@@ -332,7 +342,7 @@ static void R_ProjectPointsToFarPlane( const idRenderEntityLocal *ent, const idR
 	// messing with W seems to cause some depth precision problems
 
 	// make a projected copy of the even verts into the odd spots
-	in = &shadowVerts[firstShadowVert];
+	in = &sv->shadowVerts[firstShadowVert];
 	for ( i = firstShadowVert ; i < numShadowVerts ; i+= 2, in += 2 ) {
 		in[0].w = 1;
 		in[1].x = *in * mat[0].ToVec3() + mat[0][3];
@@ -454,7 +464,7 @@ R_ClipTriangleToLight
 Returns false if nothing is left after clipping
 ===================
 */
-static bool	R_ClipTriangleToLight( const idVec3 &a, const idVec3 &b, const idVec3 &c, int planeBits,
+static bool	R_ClipTriangleToLight( shadowVolumeScratch_t *sv, const idVec3 &a, const idVec3 &b, const idVec3 &c, int planeBits,
 							  const idPlane frustum[6] ) {
 	int			i;
 	int			base;
@@ -481,26 +491,26 @@ static bool	R_ClipTriangleToLight( const idVec3 &a, const idVec3 &b, const idVec
 	ct = &pingPong[p];
 
 	// copy the clipped points out to shadowVerts
-	if ( numShadowVerts + ct->numVerts * 2 > MAX_SHADOW_VERTS ) {
-		overflowed = true;
+	if ( sv->numShadowVerts + ct->numVerts * 2 > MAX_SHADOW_VERTS ) {
+		sv->overflowed = true;
 		return false;
 	}
 
-	base = numShadowVerts;
+	base = sv->numShadowVerts;
 	for ( i = 0 ; i < ct->numVerts ; i++ ) {
-		shadowVerts[ base + i*2 ].ToVec3() = ct->verts[i];
+		sv->shadowVerts[ base + i*2 ].ToVec3() = ct->verts[i];
 	}
-	numShadowVerts += ct->numVerts * 2;
+	sv->numShadowVerts += ct->numVerts * 2;
 
-	if ( numShadowIndexes + 3 * ( ct->numVerts - 2 ) > MAX_SHADOW_INDEXES ) {
-		overflowed = true;
+	if ( sv->numShadowIndexes + 3 * ( ct->numVerts - 2 ) > MAX_SHADOW_INDEXES ) {
+		sv->overflowed = true;
 		return false;
 	}
 
 	for ( i = 2 ; i < ct->numVerts ; i++ ) {
-		shadowIndexes[numShadowIndexes++] = base + i * 2;
-		shadowIndexes[numShadowIndexes++] = base + ( i - 1 ) * 2;
-		shadowIndexes[numShadowIndexes++] = base;
+		sv->shadowIndexes[sv->numShadowIndexes++] = base + i * 2;
+		sv->shadowIndexes[sv->numShadowIndexes++] = base + ( i - 1 ) * 2;
+		sv->shadowIndexes[sv->numShadowIndexes++] = base;
 	}
 
 	// any edges that were created by the clipping process will
@@ -508,16 +518,16 @@ static bool	R_ClipTriangleToLight( const idVec3 &a, const idVec3 &b, const idVec
 	// of the exterior bounds of the shadow volume
 	for ( i = 0 ; i < ct->numVerts ; i++ ) {
 		if ( ct->edgeFlags[i] ) {
-			if ( numClipSilEdges == MAX_CLIP_SIL_EDGES ) {
+			if ( sv->numClipSilEdges == MAX_CLIP_SIL_EDGES ) {
 				break;
 			}
-			clipSilEdges[ numClipSilEdges ][0] = base + i * 2;
+			sv->clipSilEdges[ sv->numClipSilEdges ][0] = base + i * 2;
 			if ( i == ct->numVerts - 1 ) {
-				clipSilEdges[ numClipSilEdges ][1] = base;
+				sv->clipSilEdges[ sv->numClipSilEdges ][1] = base;
 			} else {
-				clipSilEdges[ numClipSilEdges ][1] = base + ( i + 1 ) * 2;
+				sv->clipSilEdges[ sv->numClipSilEdges ][1] = base + ( i + 1 ) * 2;
 			}
-			numClipSilEdges++;
+			sv->numClipSilEdges++;
 		}
 	}
 
@@ -597,36 +607,36 @@ the frustum.
 Only done for simple projected lights, not point lights.
 ==================
 */
-static void R_AddClipSilEdges( void ) {
+static void R_AddClipSilEdges( shadowVolumeScratch_t *sv ) {
 	int		v1, v2;
 	int		v1_back, v2_back;
 	int		i;
 
 	// don't allow it to overflow
-	if ( numShadowIndexes + numClipSilEdges * 6 > MAX_SHADOW_INDEXES ) {
-		overflowed = true;
+	if ( sv->numShadowIndexes + sv->numClipSilEdges * 6 > MAX_SHADOW_INDEXES ) {
+		sv->overflowed = true;
 		return;
 	}
 
-	for ( i = 0 ; i < numClipSilEdges ; i++ ) {
-		v1 = clipSilEdges[i][0];
-		v2 = clipSilEdges[i][1];
+	for ( i = 0 ; i < sv->numClipSilEdges ; i++ ) {
+		v1 = sv->clipSilEdges[i][0];
+		v2 = sv->clipSilEdges[i][1];
 		v1_back = v1 + 1;
 		v2_back = v2 + 1;
-		if ( PointsOrdered( shadowVerts[ v1 ].ToVec3(), shadowVerts[ v2 ].ToVec3() ) ) {
-			shadowIndexes[numShadowIndexes++] = v1;
-			shadowIndexes[numShadowIndexes++] = v2;
-			shadowIndexes[numShadowIndexes++] = v1_back;
-			shadowIndexes[numShadowIndexes++] = v2;
-			shadowIndexes[numShadowIndexes++] = v2_back;
-			shadowIndexes[numShadowIndexes++] = v1_back;
+		if ( PointsOrdered( sv->shadowVerts[ v1 ].ToVec3(), sv->shadowVerts[ v2 ].ToVec3() ) ) {
+			sv->shadowIndexes[sv->numShadowIndexes++] = v1;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v2;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v1_back;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v2;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v2_back;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v1_back;
 		} else {
-			shadowIndexes[numShadowIndexes++] = v1;
-			shadowIndexes[numShadowIndexes++] = v2;
-			shadowIndexes[numShadowIndexes++] = v2_back;
-			shadowIndexes[numShadowIndexes++] = v1;
-			shadowIndexes[numShadowIndexes++] = v2_back;
-			shadowIndexes[numShadowIndexes++] = v1_back;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v1;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v2;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v2_back;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v1;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v2_back;
+			sv->shadowIndexes[sv->numShadowIndexes++] = v1_back;
 		}
 	}
 }
@@ -637,105 +647,132 @@ R_AddSilEdges
 
 Add quads from the front points to the projected points
 for each silhouette edge in the light
+
+The edges are processed in batches, the edges that cast a silhouette are
+first gathered into separate vertex number and direction streams so the
+emitting loop only touches the few edges that actually generate quads.
 =================
 */
-static void R_AddSilEdges( const srfTriangles_t *tri, unsigned short *pointCull, const idPlane frustum[6] ) {
+#define	SIL_EDGE_BATCH		1024
+
+static void R_AddSilEdges( shadowVolumeScratch_t *sv, const srfTriangles_t *tri, unsigned short *pointCull, const idPlane frustum[6] ) {
 	int		v1, v2;
 	int		i;
-	silEdge_t	*sil;
+	const silEdge_t	*sil;
 	int		numPlanes;
+	int		numSils;
+	int		silV1[SIL_EDGE_BATCH];
+	int		silV2[SIL_EDGE_BATCH];
+	byte	silFront[SIL_EDGE_BATCH];
 
 	numPlanes = tri->numIndexes / 3;
 
-	// add sil edges for any true silhouette boundaries on the surface
-	for ( i = 0 ; i < tri->numSilEdges ; i++ ) {
-		sil = tri->silEdges + i;
-		if ( sil->p1 < 0 || sil->p1 > numPlanes || sil->p2 < 0 || sil->p2 > numPlanes ) {
-			common->Error( "Bad sil planes" );
-		}
+	for ( int first = 0 ; first < tri->numSilEdges ; first += SIL_EDGE_BATCH ) {
+		int last = Min( first + SIL_EDGE_BATCH, tri->numSilEdges );
 
-		// an edge will be a silhouette edge if the face on one side
-		// casts a shadow, but the face on the other side doesn't.
-		// "casts a shadow" means that it has some surface in the projection,
-		// not just that it has the correct facing direction
-		// This will cause edges that are exactly on the frustum plane
-		// to be considered sil edges if the face inside casts a shadow.
-		if ( !( faceCastsShadow[ sil->p1 ] ^ faceCastsShadow[ sil->p2 ] ) ) {
-			continue;
-		}
-
-		// if the edge is completely off the negative side of
-		// a frustum plane, don't add it at all.  This can still
-		// happen even if the face is visible and casting a shadow
-		// if it is partially clipped
-		if ( EDGE_CULLED( sil->v1, sil->v2 ) ) {
-			continue;
-		}
-
-		// see if the edge needs to be clipped
-		if ( EDGE_CLIPPED( sil->v1, sil->v2 ) ) {
-			if ( numShadowVerts + 4 > MAX_SHADOW_VERTS ) {
-				overflowed = true;
-				return;
+		// gather the sil edges for any true silhouette boundaries on the surface
+		numSils = 0;
+		for ( i = first ; i < last ; i++ ) {
+			sil = tri->silEdges + i;
+			if ( sil->p1 < 0 || sil->p1 > numPlanes || sil->p2 < 0 || sil->p2 > numPlanes ) {
+				common->Error( "Bad sil planes" );
 			}
-			v1 = numShadowVerts;
-			v2 = v1 + 2;
-			if ( !R_ClipLineToLight( tri->verts[ sil->v1 ].xyz, tri->verts[ sil->v2 ].xyz, 
-				frustum, shadowVerts[v1].ToVec3(), shadowVerts[v2].ToVec3() ) ) {
-				continue;	// clipped away
+
+			// an edge will be a silhouette edge if the face on one side
+			// casts a shadow, but the face on the other side doesn't.
+			// "casts a shadow" means that it has some surface in the projection,
+			// not just that it has the correct facing direction
+			// This will cause edges that are exactly on the frustum plane
+			// to be considered sil edges if the face inside casts a shadow.
+			if ( !( sv->faceCastsShadow[ sil->p1 ] ^ sv->faceCastsShadow[ sil->p2 ] ) ) {
+				continue;
 			}
 
-			numShadowVerts += 4;
-		} else {
-			// use the entire edge
-			v1 = remap[ sil->v1 ];
-			v2 = remap[ sil->v2 ];
-			if ( v1 < 0 || v2 < 0 ) {
-				common->Error( "R_AddSilEdges: bad remap[]" );
+			// if the edge is completely off the negative side of
+			// a frustum plane, don't add it at all.  This can still
+			// happen even if the face is visible and casting a shadow
+			// if it is partially clipped
+			if ( EDGE_CULLED( sil->v1, sil->v2 ) ) {
+				continue;
 			}
-		}
 
-		// don't overflow
-		if ( numShadowIndexes + 6 > MAX_SHADOW_INDEXES ) {
-			overflowed = true;
-			return;
+			silV1[numSils] = sil->v1;
+			silV2[numSils] = sil->v2;
+			silFront[numSils] = sv->faceCastsShadow[ sil->p2 ];
+			numSils++;
 		}
 
-		// we need to choose the correct way of triangulating the silhouette quad
-		// consistantly between any two points, no matter which order they are specified.
-		// If this wasn't done, slight rasterization cracks would show in the shadow
-		// volume when two sil edges were exactly coincident
-		if ( faceCastsShadow[ sil->p2 ] ) {
-			if ( PointsOrdered( shadowVerts[ v1 ].ToVec3(), shadowVerts[ v2 ].ToVec3() ) ) {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
+		// add a quad for each of them
+		for ( i = 0 ; i < numSils ; i++ ) {
+
+			// see if the edge needs to be clipped
+			if ( EDGE_CLIPPED( silV1[i], silV2[i] ) ) {
+				if ( sv->numShadowVerts + 4 > MAX_SHADOW_VERTS ) {
+					sv->overflowed = true;
+					return;
+				}
+				v1 = sv->numShadowVerts;
+				v2 = v1 + 2;
+				if ( !R_ClipLineToLight( tri->verts[ silV1[i] ].xyz, tri->verts[ silV2[i] ].xyz, 
+					frustum, sv->shadowVerts[v1].ToVec3(), sv->shadowVerts[v2].ToVec3() ) ) {
+					continue;	// clipped away
+				}
+
+				sv->numShadowVerts += 4;
 			} else {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
+				// use the entire edge
+				v1 = sv->remap[ silV1[i] ];
+				v2 = sv->remap[ silV2[i] ];
+				if ( v1 < 0 || v2 < 0 ) {
+					common->Error( "R_AddSilEdges: bad remap[]" );
+				}
 			}
-		} else { 
-			if ( PointsOrdered( shadowVerts[ v1 ].ToVec3(), shadowVerts[ v2 ].ToVec3() ) ) {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
-			} else {
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v1;
-				shadowIndexes[numShadowIndexes++] = v2+1;
-				shadowIndexes[numShadowIndexes++] = v1+1;
+
+			// don't overflow
+			if ( sv->numShadowIndexes + 6 > MAX_SHADOW_INDEXES ) {
+				sv->overflowed = true;
+				return;
+			}
+
+			glIndex_t *indexes = sv->shadowIndexes + sv->numShadowIndexes;
+			sv->numShadowIndexes += 6;
+
+			// we need to choose the correct way of triangulating the silhouette quad
+			// consistantly between any two points, no matter which order they are specified.
+			// If this wasn't done, slight rasterization cracks would show in the shadow
+			// volume when two sil edges were exactly coincident
+			if ( silFront[i] ) {
+				if ( PointsOrdered( sv->shadowVerts[ v1 ].ToVec3(), sv->shadowVerts[ v2 ].ToVec3() ) ) {
+					indexes[0] = v1;
+					indexes[1] = v1+1;
+					indexes[2] = v2;
+					indexes[3] = v2;
+					indexes[4] = v1+1;
+					indexes[5] = v2+1;
+				} else {
+					indexes[0] = v1;
+					indexes[1] = v2+1;
+					indexes[2] = v2;
+					indexes[3] = v1;
+					indexes[4] = v1+1;
+					indexes[5] = v2+1;
+				}
+			} else { 
+				if ( PointsOrdered( sv->shadowVerts[ v1 ].ToVec3(), sv->shadowVerts[ v2 ].ToVec3() ) ) {
+					indexes[0] = v1;
+					indexes[1] = v2;
+					indexes[2] = v1+1;
+					indexes[3] = v2;
+					indexes[4] = v2+1;
+					indexes[5] = v1+1;
+				} else {
+					indexes[0] = v1;
+					indexes[1] = v2;
+					indexes[2] = v2+1;
+					indexes[3] = v1;
+					indexes[4] = v2+1;
+					indexes[5] = v1+1;
+				}
 			}
 		}
 	}
@@ -748,13 +785,11 @@ R_CalcPointCull
 Also inits the remap[] array to all -1
 ================
 */
-static void R_CalcPointCull( const srfTriangles_t *tri, const idPlane frustum[6], unsigned short *pointCull ) {
+static void R_CalcPointCull( shadowVolumeScratch_t *sv, const srfTriangles_t *tri, const idPlane frustum[6], unsigned short *pointCull ) {
 	int i;
 	int frontBits;
-	float *planeSide;
-	byte *side1, *side2;
 
-	SIMDProcessor->Memset( remap, -1, tri->numVerts * sizeof( remap[0] ) );
+	SIMDProcessor->Memset( sv->remap, -1, tri->numVerts * sizeof( sv->remap[0] ) );
 
 	for ( frontBits = 0, i = 0; i < 6; i++ ) {
 		// get front bits for the whole surface
@@ -763,34 +798,23 @@ static void R_CalcPointCull( const srfTriangles_t *tri, const idPlane frustum[6]
 		}
 	}
 
-	// initialize point cull
-	for ( i = 0; i < tri->numVerts; i++ ) {
-		pointCull[i] = frontBits;
-	}
-
-	// if the surface is not completely inside the light frustum
+	// if the surface is completely inside the light frustum
 	if ( frontBits == ( ( ( 1 << 6 ) - 1 ) ) << 6 ) {
+		for ( i = 0; i < tri->numVerts; i++ ) {
+			pointCull[i] = frontBits;
+		}
 		return;
 	}
 
-	planeSide = (float *) _alloca16( tri->numVerts * sizeof( float ) );
-	side1 = (byte *) _alloca16( tri->numVerts * sizeof( byte ) );
-	side2 = (byte *) _alloca16( tri->numVerts * sizeof( byte ) );
-	SIMDProcessor->Memset( side1, 0, tri->numVerts * sizeof( byte ) );
-	SIMDProcessor->Memset( side2, 0, tri->numVerts * sizeof( byte ) );
-
-	for ( i = 0; i < 6; i++ ) {
+	// test all the points against all six planes in a single pass
+	SIMDProcessor->ShadowPointCull( pointCull, frustum, tri->verts, tri->numVerts, LIGHT_CLIP_EPSILON );
 
-		if ( frontBits & (1<<(i+6)) ) {
-			continue;
+	// the planes the bounds are completely in front of don't cull any points
+	if ( frontBits ) {
+		int insideBits = ~( frontBits >> 6 );
+		for ( i = 0; i < tri->numVerts; i++ ) {
+			pointCull[i] = ( pointCull[i] & insideBits ) | frontBits;
 		}
-
-		SIMDProcessor->Dot( planeSide, frustum[i], tri->verts, tri->numVerts );
-		SIMDProcessor->CmpLT( side1, i, planeSide, LIGHT_CLIP_EPSILON, tri->numVerts );
-		SIMDProcessor->CmpGT( side2, i, planeSide, -LIGHT_CLIP_EPSILON, tri->numVerts );
-	}
-	for ( i = 0; i < tri->numVerts; i++ ) {
-		pointCull[i] |= side1[i] | (side2[i] << 6);
 	}
 }
 
@@ -808,7 +832,7 @@ If the frustum is just part of a point light, clipped planes don't
 need to be added.
 =================
 */
-static void R_CreateShadowVolumeInFrustum( const idRenderEntityLocal *ent, 
+static void R_CreateShadowVolumeInFrustum( shadowVolumeScratch_t *sv, const idRenderEntityLocal *ent, 
 										  const srfTriangles_t *tri,
 										  const idRenderLightLocal *light,									
 										  const idVec3 lightOrigin,
@@ -827,23 +851,23 @@ static void R_CreateShadowVolumeInFrustum( const idRenderEntityLocal *ent,
 
 	// test the vertexes for inside the light frustum, which will allow
 	// us to completely cull away some triangles from consideration.
-	R_CalcPointCull( tri, frustum, pointCull );
+	R_CalcPointCull( sv, tri, frustum, pointCull );
 
 	// this may not be the first frustum added to the volume
-	firstShadowIndex = numShadowIndexes;
-	firstShadowVert = numShadowVerts;
+	firstShadowIndex = sv->numShadowIndexes;
+	firstShadowVert = sv->numShadowVerts;
 
 	// decide which triangles front shadow volumes, clipping as needed
-	numClipSilEdges = 0;
+	sv->numClipSilEdges = 0;
 	numTris = tri->numIndexes / 3;
 	for ( i = 0 ; i < numTris ; i++ ) {
 		int		i1, i2, i3;
 
-		faceCastsShadow[i] = 0;	// until shown otherwise
+		sv->faceCastsShadow[i] = 0;	// until shown otherwise
 
 		// if it isn't facing the right way, don't add it
 		// to the shadow volume
-		if ( globalFacing[i] ) {
+		if ( sv->globalFacing[i] ) {
 			continue;
 		}
 
@@ -862,25 +886,25 @@ static void R_CreateShadowVolumeInFrustum( const idRenderEntityLocal *ent,
 		// we need to get the original verts even from clipped triangles
 		// so the edges reference correctly, because an edge may be unclipped
 		// even when a triangle is clipped.
-		if ( numShadowVerts + 6 > MAX_SHADOW_VERTS ) {
-			overflowed = true;
+		if ( sv->numShadowVerts + 6 > MAX_SHADOW_VERTS ) {
+			sv->overflowed = true;
 			return;
 		}
 
-		if ( !POINT_CULLED(i1) && remap[i1] == -1 ) {
-			remap[i1] = numShadowVerts;
-			shadowVerts[ numShadowVerts ].ToVec3() = tri->verts[i1].xyz;
-			numShadowVerts+=2;
+		if ( !POINT_CULLED(i1) && sv->remap[i1] == -1 ) {
+			sv->remap[i1] = sv->numShadowVerts;
+			sv->shadowVerts[ sv->numShadowVerts ].ToVec3() = tri->verts[i1].xyz;
+			sv->numShadowVerts+=2;
 		}
-		if ( !POINT_CULLED(i2) && remap[i2] == -1 ) {
-			remap[i2] = numShadowVerts;
-			shadowVerts[ numShadowVerts ].ToVec3() = tri->verts[i2].xyz;
-			numShadowVerts+=2;
+		if ( !POINT_CULLED(i2) && sv->remap[i2] == -1 ) {
+			sv->remap[i2] = sv->numShadowVerts;
+			sv->shadowVerts[ sv->numShadowVerts ].ToVec3() = tri->verts[i2].xyz;
+			sv->numShadowVerts+=2;
 		}
-		if ( !POINT_CULLED(i3) && remap[i3] == -1 ) {
-			remap[i3] = numShadowVerts;
-			shadowVerts[ numShadowVerts ].ToVec3() = tri->verts[i3].xyz;
-			numShadowVerts+=2;
+		if ( !POINT_CULLED(i3) && sv->remap[i3] == -1 ) {
+			sv->remap[i3] = sv->numShadowVerts;
+			sv->shadowVerts[ sv->numShadowVerts ].ToVec3() = tri->verts[i3].xyz;
+			sv->numShadowVerts+=2;
 		}
 
 		// clip the triangle if any points are on the negative sides
@@ -888,29 +912,29 @@ static void R_CreateShadowVolumeInFrustum( const idRenderEntityLocal *ent,
 			cullBits = ( ( pointCull[ i1 ] ^ 0xfc0 ) | ( pointCull[ i2 ] ^ 0xfc0 ) | ( pointCull[ i3 ] ^ 0xfc0 ) ) >> 6;
 			// this will also define clip edges that will become
 			// silhouette planes
-			if ( R_ClipTriangleToLight( tri->verts[i1].xyz, tri->verts[i2].xyz, 
+			if ( R_ClipTriangleToLight( sv, tri->verts[i1].xyz, tri->verts[i2].xyz, 
 				tri->verts[i3].xyz, cullBits, frustum ) ) {
-				faceCastsShadow[i] = 1;
+				sv->faceCastsShadow[i] = 1;
 			}
 		} else {
 			// instead of overflowing or drawing a streamer shadow, don't draw a shadow at all
-			if ( numShadowIndexes + 3 > MAX_SHADOW_INDEXES ) {
-				overflowed = true;
+			if ( sv->numShadowIndexes + 3 > MAX_SHADOW_INDEXES ) {
+				sv->overflowed = true;
 				return;
 			}
-			if ( remap[i1] == -1 || remap[i2] == -1 || remap[i3] == -1 ) {
+			if ( sv->remap[i1] == -1 || sv->remap[i2] == -1 || sv->remap[i3] == -1 ) {
 				common->Error( "R_CreateShadowVolumeInFrustum: bad remap[]" );
 			}
-			shadowIndexes[numShadowIndexes++] = remap[i3];
-			shadowIndexes[numShadowIndexes++] = remap[i2];
-			shadowIndexes[numShadowIndexes++] = remap[i1];
-			faceCastsShadow[i] = 1;
+			sv->shadowIndexes[sv->numShadowIndexes++] = sv->remap[i3];
+			sv->shadowIndexes[sv->numShadowIndexes++] = sv->remap[i2];
+			sv->shadowIndexes[sv->numShadowIndexes++] = sv->remap[i1];
+			sv->faceCastsShadow[i] = 1;
 		}
 	}
 
 	// add indexes for the back caps, which will just be reversals of the
 	// front caps using the back vertexes
-	numCapIndexes = numShadowIndexes - firstShadowIndex;
+	numCapIndexes = sv->numShadowIndexes - firstShadowIndex;
 
 	// if no faces have been defined for the shadow volume,
 	// there won't be anything at all
@@ -922,52 +946,52 @@ static void R_CreateShadowVolumeInFrustum( const idRenderEntityLocal *ent,
 
 	// if we are running from dmap, perform the (very) expensive shadow optimizations
 	// to remove internal sil edges and optimize the caps
-	if ( callOptimizer ) {
+	if ( sv->callOptimizer ) {
 		optimizedShadow_t opt;
 		
 		// project all of the vertexes to the shadow plane, generating
 		// an equal number of back vertexes
-//		R_ProjectPointsToFarPlane( ent, light, farPlane, firstShadowVert, numShadowVerts );
+//		R_ProjectPointsToFarPlane( sv, ent, light, farPlane, firstShadowVert, sv->numShadowVerts );
 
-		opt = SuperOptimizeOccluders( shadowVerts, shadowIndexes + firstShadowIndex, numCapIndexes, farPlane, lightOrigin );
+		opt = SuperOptimizeOccluders( sv->shadowVerts, sv->shadowIndexes + firstShadowIndex, numCapIndexes, farPlane, lightOrigin );
 
 		// pull off the non-optimized data
-		numShadowIndexes = firstShadowIndex;
-		numShadowVerts = firstShadowVert;
+		sv->numShadowIndexes = firstShadowIndex;
+		sv->numShadowVerts = firstShadowVert;
 
 		// add the optimized data
-		if ( numShadowIndexes + opt.totalIndexes > MAX_SHADOW_INDEXES 
-			|| numShadowVerts + opt.numVerts > MAX_SHADOW_VERTS ) {
-			overflowed = true;
-			common->Printf( "WARNING: overflowed MAX_SHADOW tables, shadow discarded\n" );
+		if ( sv->numShadowIndexes + opt.totalIndexes > MAX_SHADOW_INDEXES 
+			|| sv->numShadowVerts + opt.numVerts > MAX_SHADOW_VERTS ) {
+			sv->overflowed = true;
+			common->Printf( "WARNING: sv->overflowed MAX_SHADOW tables, shadow discarded\n" );
 			Mem_Free( opt.verts );
 			Mem_Free( opt.indexes );
 			return;
 		}
 
 		for ( i = 0 ; i < opt.numVerts ; i++ ) {
-			shadowVerts[numShadowVerts+i][0] = opt.verts[i][0];
-			shadowVerts[numShadowVerts+i][1] = opt.verts[i][1];
-			shadowVerts[numShadowVerts+i][2] = opt.verts[i][2];
-			shadowVerts[numShadowVerts+i][3] = 1;
+			sv->shadowVerts[sv->numShadowVerts+i][0] = opt.verts[i][0];
+			sv->shadowVerts[sv->numShadowVerts+i][1] = opt.verts[i][1];
+			sv->shadowVerts[sv->numShadowVerts+i][2] = opt.verts[i][2];
+			sv->shadowVerts[sv->numShadowVerts+i][3] = 1;
 		}
 		for ( i = 0 ; i < opt.totalIndexes ; i++ ) {
 			int	index = opt.indexes[i];
 			if ( index < 0 || index > opt.numVerts ) {
 				common->Error( "optimized shadow index out of range" );
 			}
-			shadowIndexes[numShadowIndexes+i] = index + numShadowVerts;
+			sv->shadowIndexes[sv->numShadowIndexes+i] = index + sv->numShadowVerts;
 		}
 
-		numShadowVerts += opt.numVerts;
-		numShadowIndexes += opt.totalIndexes;
+		sv->numShadowVerts += opt.numVerts;
+		sv->numShadowIndexes += opt.totalIndexes;
 
 		// note the index distribution so we can sort all the caps after all the sils
-		indexRef[indexFrustumNumber].frontCapStart = firstShadowIndex;
-		indexRef[indexFrustumNumber].rearCapStart = firstShadowIndex+opt.numFrontCapIndexes;
-		indexRef[indexFrustumNumber].silStart = firstShadowIndex+opt.numFrontCapIndexes+opt.numRearCapIndexes;
-		indexRef[indexFrustumNumber].end = numShadowIndexes;
-		indexFrustumNumber++;
+		sv->indexRef[sv->indexFrustumNumber].frontCapStart = firstShadowIndex;
+		sv->indexRef[sv->indexFrustumNumber].rearCapStart = firstShadowIndex+opt.numFrontCapIndexes;
+		sv->indexRef[sv->indexFrustumNumber].silStart = firstShadowIndex+opt.numFrontCapIndexes+opt.numRearCapIndexes;
+		sv->indexRef[sv->indexFrustumNumber].end = sv->numShadowIndexes;
+		sv->indexFrustumNumber++;
 
 		Mem_Free( opt.verts );
 		Mem_Free( opt.indexes );
@@ -979,47 +1003,47 @@ static void R_CreateShadowVolumeInFrustum( const idRenderEntityLocal *ent,
 	// the dangling edge "face" is never considered to cast a shadow,
 	// so any face with dangling edges that casts a shadow will have
 	// it's dangling sil edge trigger a sil plane
-	faceCastsShadow[numTris] = 0;
+	sv->faceCastsShadow[numTris] = 0;
 
 	// instead of overflowing or drawing a streamer shadow, don't draw a shadow at all
 	// if we ran out of space
-	if ( numShadowIndexes + numCapIndexes > MAX_SHADOW_INDEXES ) {
-		overflowed = true;
+	if ( sv->numShadowIndexes + numCapIndexes > MAX_SHADOW_INDEXES ) {
+		sv->overflowed = true;
 		return;
 	}
 	for ( i = 0 ; i < numCapIndexes ; i += 3 ) {
-		shadowIndexes[ numShadowIndexes + i + 0 ] = shadowIndexes[ firstShadowIndex + i + 2 ] + 1;
-		shadowIndexes[ numShadowIndexes + i + 1 ] = shadowIndexes[ firstShadowIndex + i + 1 ] + 1;
-		shadowIndexes[ numShadowIndexes + i + 2 ] = shadowIndexes[ firstShadowIndex + i + 0 ] + 1;
+		sv->shadowIndexes[ sv->numShadowIndexes + i + 0 ] = sv->shadowIndexes[ firstShadowIndex + i + 2 ] + 1;
+		sv->shadowIndexes[ sv->numShadowIndexes + i + 1 ] = sv->shadowIndexes[ firstShadowIndex + i + 1 ] + 1;
+		sv->shadowIndexes[ sv->numShadowIndexes + i + 2 ] = sv->shadowIndexes[ firstShadowIndex + i + 0 ] + 1;
 	}
-	numShadowIndexes += numCapIndexes;
+	sv->numShadowIndexes += numCapIndexes;
 
-c_caps += numCapIndexes * 2;
+sv->c_caps += numCapIndexes * 2;
 
-int preSilIndexes = numShadowIndexes;
+int preSilIndexes = sv->numShadowIndexes;
 
 	// if any triangles were clipped, we will have a list of edges
 	// on the frustum which must now become sil edges
 	if ( makeClippedPlanes ) {
-		R_AddClipSilEdges();
+		R_AddClipSilEdges( sv );
 	}
 
 	// any edges that are a transition between a shadowing and
 	// non-shadowing triangle will cast a silhouette edge
-	R_AddSilEdges( tri, pointCull, frustum );
+	R_AddSilEdges( sv, tri, pointCull, frustum );
 
-c_sils += numShadowIndexes - preSilIndexes;
+sv->c_sils += sv->numShadowIndexes - preSilIndexes;
 
 	// project all of the vertexes to the shadow plane, generating
 	// an equal number of back vertexes
-	R_ProjectPointsToFarPlane( ent, light, farPlane, firstShadowVert, numShadowVerts );
+	R_ProjectPointsToFarPlane( sv, ent, light, farPlane, firstShadowVert, sv->numShadowVerts );
 
 	// note the index distribution so we can sort all the caps after all the sils
-	indexRef[indexFrustumNumber].frontCapStart = firstShadowIndex;
-	indexRef[indexFrustumNumber].rearCapStart = firstShadowIndex+numCapIndexes;
-	indexRef[indexFrustumNumber].silStart = preSilIndexes;
-	indexRef[indexFrustumNumber].end = numShadowIndexes;
-	indexFrustumNumber++;
+	sv->indexRef[sv->indexFrustumNumber].frontCapStart = firstShadowIndex;
+	sv->indexRef[sv->indexFrustumNumber].rearCapStart = firstShadowIndex+numCapIndexes;
+	sv->indexRef[sv->indexFrustumNumber].silStart = preSilIndexes;
+	sv->indexRef[sv->indexFrustumNumber].end = sv->numShadowIndexes;
+	sv->indexFrustumNumber++;
 }
 
 /*
@@ -1190,44 +1214,51 @@ void R_MakeShadowFrustums( idRenderLightLocal *light ) {
 
 /*
 =================
-R_CreateShadowVolume
-
-The returned surface will have a valid bounds and radius for culling.
-
-Triangles are clipped to the light frustum before projecting.
+R_ShadowVolumeScratch
 
-A single triangle can clip to as many as 7 vertexes, so
-the worst case expansion is 2*(numindexes/3)*7 verts when counting both
-the front and back caps, although it will usually only be a modest
-increase in vertexes for closed modesl
+Returns the scratch memory for the calling thread, it is allocated
+the first time a thread builds a shadow volume.
+=================
+*/
+static shadowVolumeScratch_t *R_ShadowVolumeScratch( void ) {
+	int slot = parallelJobManager->GetThreadSlot();
+	if ( slot < 0 ) {
+		slot = MAX_JOB_THREADS + 1;
+	}
+	if ( shadowScratch[slot] == NULL ) {
+		shadowScratch[slot] = (shadowVolumeScratch_t *)Mem_Alloc16( sizeof( shadowVolumeScratch_t ) );
+	}
+	return shadowScratch[slot];
+}
 
-The worst case index count is much larger, when the 7 vertex clipped triangle
-needs 15 indexes for the front, 15 for the back, and 42 (a quad on seven sides)
-for the sides, for a total of 72 indexes from the original 3.  Ouch.
+/*
+=================
+R_ShutdownShadowVolumes
+=================
+*/
+void R_ShutdownShadowVolumes( void ) {
+	for ( int i = 0 ; i < MAX_JOB_THREADS + 2 ; i++ ) {
+		if ( shadowScratch[i] != NULL ) {
+			Mem_Free16( shadowScratch[i] );
+			shadowScratch[i] = NULL;
+		}
+	}
+}
 
-NULL may be returned if the surface doesn't create a shadow volume at all,
-as with a single face that the light is behind.
+/*
+=================
+R_ShadowVolumeAllowed
 
-If an edge is within an epsilon of the border of the volume, it must be treated
-as if it is clipped for triangles, generating a new sil edge, and act
-as if it was culled for edges, because the sil edge will have been
-generated by the triangle irregardless of if it actually was a sil edge.
+Checks shared by the serial and the parallel shadow volume creation
 =================
 */
-srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
-									 const srfTriangles_t *tri, const idRenderLightLocal *light,
-									 shadowGen_t optimize, srfCullInfo_t &cullInfo ) {
-	int		i, j;
-	idVec3	lightOrigin;
-	srfTriangles_t	*newTri;
-	int		capPlaneBits;
-
+static bool R_ShadowVolumeAllowed( const srfTriangles_t *tri ) {
 	if ( !r_shadows.GetBool() ) {
-		return NULL;
+		return false;
 	}
 
 	if ( tri->numSilEdges == 0 || tri->numIndexes == 0 || tri->numVerts == 0 ) {
-		return NULL;
+		return false;
 	}
 
 	if ( tri->numIndexes < 0 ) {
@@ -1238,44 +1269,48 @@ srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
 		common->Error( "R_CreateShadowVolume: tri->numVerts = %i", tri->numVerts );
 	}
 
-	tr.pc.c_createShadowVolumes++;
+	return true;
+}
 
-	// use the fast infinite projection in dynamic situations, which
-	// trades somewhat more overdraw and no cap optimizations for
-	// a very simple generation process
-	if ( optimize == SG_DYNAMIC && r_useTurboShadow.GetBool() ) {
-		if ( tr.backEndRendererHasVertexPrograms && r_useShadowVertexProgram.GetBool() ) {
-			return R_CreateVertexProgramTurboShadowVolume( ent, tri, light, cullInfo );
-		} else {
-			return R_CreateTurboShadowVolume( ent, tri, light, cullInfo );
-		}
-	}
+/*
+=================
+R_BuildShadowVolume
 
-	R_CalcInteractionFacing( ent, tri, light, cullInfo );
+Builds the clipped shadow volume in the scratch memory, returns false
+if the surface doesn't cast a shadow or the volume overflowed.
+
+Doesn't allocate anything, so it can be called from jobs.
+=================
+*/
+static bool R_BuildShadowVolume( shadowVolumeScratch_t *sv, const idRenderEntityLocal *ent,
+								 const srfTriangles_t *tri, const idRenderLightLocal *light,
+								 shadowGen_t optimize, const byte *facing ) {
+	int		i, j;
+	idVec3	lightOrigin;
 
 	int numFaces = tri->numIndexes / 3;
 	int allFront = 1;
 	for ( i = 0; i < numFaces && allFront; i++ ) {
-		allFront &= cullInfo.facing[i];
+		allFront &= facing[i];
 	}
 	if ( allFront ) {
 		// if no faces are the right direction, don't make a shadow at all
-		return NULL;
+		return false;
 	}
 
 	// clear the shadow volume
-	numShadowIndexes = 0;
-	numShadowVerts = 0;
-	overflowed = false;
-	indexFrustumNumber = 0;
-	capPlaneBits = 0;
-	callOptimizer = (optimize == SG_OFFLINE);
+	sv->numShadowIndexes = 0;
+	sv->numShadowVerts = 0;
+	sv->overflowed = false;
+	sv->indexFrustumNumber = 0;
+	sv->capPlaneBits = 0;
+	sv->callOptimizer = (optimize == SG_OFFLINE);
 
 	// the facing information will be the same for all six projections
 	// from a point light, as well as for any directed lights
-	globalFacing = cullInfo.facing;
-	faceCastsShadow = (byte *)_alloca16( tri->numIndexes / 3 + 1 );	// + 1 for fake dangling edge face
-	remap = (int *)_alloca16( tri->numVerts * sizeof( remap[0] ) );
+	sv->globalFacing = facing;
+	sv->faceCastsShadow = (byte *)_alloca16( numFaces + 1 );	// + 1 for fake dangling edge face
+	sv->remap = (int *)_alloca16( tri->numVerts * sizeof( sv->remap[0] ) );
 
 	R_GlobalPointToLocal( ent->modelMatrix, light->globalLightOrigin, lightOrigin );
 
@@ -1306,36 +1341,88 @@ srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
 			continue;
 		}
 		// we need to check all the triangles
-		int		oldFrustumNumber = indexFrustumNumber;
+		int		oldFrustumNumber = sv->indexFrustumNumber;
 
-		R_CreateShadowVolumeInFrustum( ent, tri, light, lightOrigin, frustum, frustum[5], frust->makeClippedPlanes );
+		R_CreateShadowVolumeInFrustum( sv, ent, tri, light, lightOrigin, frustum, frustum[5], frust->makeClippedPlanes );
 
 		// if we couldn't make a complete shadow volume, it is better to
 		// not draw one at all, avoiding streamer problems
-		if ( overflowed ) {
-			return NULL;
+		if ( sv->overflowed ) {
+			return false;
 		}
 
-		if ( indexFrustumNumber != oldFrustumNumber ) {
+		if ( sv->indexFrustumNumber != oldFrustumNumber ) {
 			// note that we have caps projected against this frustum,
 			// which may allow us to skip drawing the caps if all projected
 			// planes face away from the viewer and the viewer is outside the light volume
-			capPlaneBits |= 1<<frustumNum;
+			sv->capPlaneBits |= 1<<frustumNum;
 		}
 	}
 
 	// if no faces have been defined for the shadow volume,
 	// there won't be anything at all
-	if ( numShadowIndexes == 0 ) {
-		return NULL;
+	if ( sv->numShadowIndexes == 0 ) {
+		return false;
 	}
 
 	// this should have been prevented by the overflowed flag, so if it ever happens,
 	// it is a code error
-	if ( numShadowVerts > MAX_SHADOW_VERTS || numShadowIndexes > MAX_SHADOW_INDEXES ) {
+	if ( sv->numShadowVerts > MAX_SHADOW_VERTS || sv->numShadowIndexes > MAX_SHADOW_INDEXES ) {
 		common->FatalError( "Shadow volume exceeded allocation" );
 	}
 
+	return true;
+}
+
+/*
+=================
+R_SortShadowIndexes
+
+Copies the indexes of the shadow volume sorted as sil planes, rear caps
+and front caps, so the caps can be skipped when they aren't needed.
+Returns the total number of indexes.
+=================
+*/
+static int R_SortShadowIndexes( const shadowVolumeScratch_t *sv, glIndex_t *indexes,
+								int &numShadowIndexesNoCaps, int &numShadowIndexesNoFrontCaps ) {
+	int		i, c;
+	int		numIndexes;
+
+	// copy the sil indexes first
+	numIndexes = 0;
+	for ( i = 0 ; i < sv->indexFrustumNumber ; i++ ) {
+		c = sv->indexRef[i].end - sv->indexRef[i].silStart;
+		SIMDProcessor->Memcpy( indexes + numIndexes, sv->shadowIndexes + sv->indexRef[i].silStart, c * sizeof( indexes[0] ) );
+		numIndexes += c;
+	}
+	numShadowIndexesNoCaps = numIndexes;
+
+	// copy rear cap indexes next
+	for ( i = 0 ; i < sv->indexFrustumNumber ; i++ ) {
+		c = sv->indexRef[i].silStart - sv->indexRef[i].rearCapStart;
+		SIMDProcessor->Memcpy( indexes + numIndexes, sv->shadowIndexes + sv->indexRef[i].rearCapStart, c * sizeof( indexes[0] ) );
+		numIndexes += c;
+	}
+	numShadowIndexesNoFrontCaps = numIndexes;
+
+	// copy front cap indexes last
+	for ( i = 0 ; i < sv->indexFrustumNumber ; i++ ) {
+		c = sv->indexRef[i].rearCapStart - sv->indexRef[i].frontCapStart;
+		SIMDProcessor->Memcpy( indexes + numIndexes, sv->shadowIndexes + sv->indexRef[i].frontCapStart, c * sizeof( indexes[0] ) );
+		numIndexes += c;
+	}
+
+	return numIndexes;
+}
+
+/*
+=================
+R_AllocShadowVolume
+=================
+*/
+static srfTriangles_t *R_AllocShadowVolume( int numVerts, int numIndexes ) {
+	srfTriangles_t	*newTri;
+
 	// allocate a new surface for the shadow volume
 	newTri = R_AllocStaticTriSurf();
 
@@ -1343,53 +1430,315 @@ srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
 	// large lights that are partially off screen
 	newTri->bounds.Clear();
 
-	// copy off the verts and indexes
-	newTri->numVerts = numShadowVerts;
-	newTri->numIndexes = numShadowIndexes;
+	newTri->numVerts = numVerts;
+	newTri->numIndexes = numIndexes;
 
 	// the shadow verts will go into a main memory buffer as well as a vertex
 	// cache buffer, so they can be copied back if they are purged
 	R_AllocStaticTriSurfShadowVerts( newTri, newTri->numVerts );
-	SIMDProcessor->Memcpy( newTri->shadowVertexes, shadowVerts, newTri->numVerts * sizeof( newTri->shadowVertexes[0] ) );
-
 	R_AllocStaticTriSurfIndexes( newTri, newTri->numIndexes );
 
-	if ( 1 /* sortCapIndexes */ ) {
-		newTri->shadowCapPlaneBits = capPlaneBits;
+	return newTri;
+}
 
-		// copy the sil indexes first
-		newTri->numShadowIndexesNoCaps = 0;
-		for ( i = 0 ; i < indexFrustumNumber ; i++ ) {
-			int	c = indexRef[i].end - indexRef[i].silStart;
-			SIMDProcessor->Memcpy( newTri->indexes+newTri->numShadowIndexesNoCaps, 
-									shadowIndexes+indexRef[i].silStart, c * sizeof( newTri->indexes[0] ) );
-			newTri->numShadowIndexesNoCaps += c;
-		}
-		// copy rear cap indexes next
-		newTri->numShadowIndexesNoFrontCaps = newTri->numShadowIndexesNoCaps;
-		for ( i = 0 ; i < indexFrustumNumber ; i++ ) {
-			int	c = indexRef[i].silStart - indexRef[i].rearCapStart;
-			SIMDProcessor->Memcpy( newTri->indexes+newTri->numShadowIndexesNoFrontCaps, 
-									shadowIndexes+indexRef[i].rearCapStart, c * sizeof( newTri->indexes[0] ) );
-			newTri->numShadowIndexesNoFrontCaps += c;
-		}
-		// copy front cap indexes last
-		newTri->numIndexes = newTri->numShadowIndexesNoFrontCaps;
-		for ( i = 0 ; i < indexFrustumNumber ; i++ ) {
-			int	c = indexRef[i].rearCapStart - indexRef[i].frontCapStart;
-			SIMDProcessor->Memcpy( newTri->indexes+newTri->numIndexes, 
-									shadowIndexes+indexRef[i].frontCapStart, c * sizeof( newTri->indexes[0] ) );
-			newTri->numIndexes += c;
+/*
+=================
+R_CreateShadowVolume
+
+The returned surface will have a valid bounds and radius for culling.
+
+Triangles are clipped to the light frustum before projecting.
+
+A single triangle can clip to as many as 7 vertexes, so
+the worst case expansion is 2*(numindexes/3)*7 verts when counting both
+the front and back caps, although it will usually only be a modest
+increase in vertexes for closed modesl
+
+The worst case index count is much larger, when the 7 vertex clipped triangle
+needs 15 indexes for the front, 15 for the back, and 42 (a quad on seven sides)
+for the sides, for a total of 72 indexes from the original 3.  Ouch.
+
+NULL may be returned if the surface doesn't create a shadow volume at all,
+as with a single face that the light is behind.
+
+If an edge is within an epsilon of the border of the volume, it must be treated
+as if it is clipped for triangles, generating a new sil edge, and act
+as if it was culled for edges, because the sil edge will have been
+generated by the triangle irregardless of if it actually was a sil edge.
+=================
+*/
+srfTriangles_t *R_CreateShadowVolume( const idRenderEntityLocal *ent,
+									 const srfTriangles_t *tri, const idRenderLightLocal *light,
+									 shadowGen_t optimize, srfCullInfo_t &cullInfo ) {
+	shadowVolumeScratch_t	*sv;
+	srfTriangles_t	*newTri;
+
+	if ( !R_ShadowVolumeAllowed( tri ) ) {
+		return NULL;
+	}
+
+	tr.pc.c_createShadowVolumes++;
+
+	// use the fast infinite projection in dynamic situations, which
+	// trades somewhat more overdraw and no cap optimizations for
+	// a very simple generation process
+	if ( optimize == SG_DYNAMIC && r_useTurboShadow.GetBool() ) {
+		if ( tr.backEndRendererHasVertexPrograms && r_useShadowVertexProgram.GetBool() ) {
+			return R_CreateVertexProgramTurboShadowVolume( ent, tri, light, cullInfo );
+		} else {
+			return R_CreateTurboShadowVolume( ent, tri, light, cullInfo );
 		}
+	}
 
-	} else {
-		newTri->shadowCapPlaneBits = 63;	// we don't have optimized index lists
-		SIMDProcessor->Memcpy( newTri->indexes, shadowIndexes, newTri->numIndexes * sizeof( newTri->indexes[0] ) );
+	R_CalcInteractionFacing( ent, tri, light, cullInfo );
+
+	sv = R_ShadowVolumeScratch();
+	if ( !R_BuildShadowVolume( sv, ent, tri, light, optimize, cullInfo.facing ) ) {
+		return NULL;
 	}
 
+	// copy off the verts and indexes
+	newTri = R_AllocShadowVolume( sv->numShadowVerts, sv->numShadowIndexes );
+	SIMDProcessor->Memcpy( newTri->shadowVertexes, sv->shadowVerts, newTri->numVerts * sizeof( newTri->shadowVertexes[0] ) );
+
+	newTri->shadowCapPlaneBits = sv->capPlaneBits;
+	R_SortShadowIndexes( sv, newTri->indexes, newTri->numShadowIndexesNoCaps, newTri->numShadowIndexesNoFrontCaps );
+
 	if ( optimize == SG_OFFLINE ) {
 		CleanupOptimizedShadowTris( newTri );
 	}
 
 	return newTri;
 }
+
+/*
+=================
+R_ShadowVolumeJob
+
+Builds a shadow volume in the scratch memory of the job thread and moves
+it out, because the triangle allocators may only be used by the main thread.
+=================
+*/
+static void R_ShadowVolumeJob( shadowVolumeJob_t *job ) {
+	shadowVolumeScratch_t *sv = R_ShadowVolumeScratch();
+
+	if ( !R_BuildShadowVolume( sv, job->ent, job->tri, job->light, job->optimize, job->cullInfo->facing ) ) {
+		return;
+	}
+
+	job->numShadowVerts = sv->numShadowVerts;
+	job->shadowVerts = (idVec4 *)Mem_Alloc16( sv->numShadowVerts * sizeof( job->shadowVerts[0] ) );
+	SIMDProcessor->Memcpy( job->shadowVerts, sv->shadowVerts, sv->numShadowVerts * sizeof( job->shadowVerts[0] ) );
+
+	job->shadowIndexes = (glIndex_t *)Mem_Alloc( sv->numShadowIndexes * sizeof( job->shadowIndexes[0] ) );
+	job->numShadowIndexes = R_SortShadowIndexes( sv, job->shadowIndexes, job->numShadowIndexesNoCaps, job->numShadowIndexesNoFrontCaps );
+	job->shadowCapPlaneBits = sv->capPlaneBits;
+}
+
+/*
+=================
+R_CreateShadowVolumes
+
+Same as R_CreateShadowVolume for a number of surfaces. If r_useParallelShadows
+is set, the clipped shadow volumes are built with parallel jobs, the facing
+calculation, the turbo shadows and the surface allocation stay on this thread.
+=================
+*/
+void R_CreateShadowVolumes( shadowVolumeJob_t *jobs, int numJobs ) {
+	int		i;
+
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		jobs[i].shadowTris = NULL;
+		jobs[i].shadowVerts = NULL;
+		jobs[i].shadowIndexes = NULL;
+	}
+
+	if ( numJobs < 2 || !r_useParallelShadows.GetBool() || parallelJobManager->GetNumThreads() == 0 ) {
+		for ( i = 0 ; i < numJobs ; i++ ) {
+			shadowVolumeJob_t *job = &jobs[i];
+			job->shadowTris = R_CreateShadowVolume( job->ent, job->tri, job->light, job->optimize, *job->cullInfo );
+		}
+		return;
+	}
+
+	tr.shadowVolumeJobs->Clear();
+
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		shadowVolumeJob_t *job = &jobs[i];
+
+		// the turbo shadows and the dmap optimizer are not worth or not safe to run in a job
+		if ( job->optimize == SG_OFFLINE || ( job->optimize == SG_DYNAMIC && r_useTurboShadow.GetBool() ) ) {
+			job->shadowTris = R_CreateShadowVolume( job->ent, job->tri, job->light, job->optimize, *job->cullInfo );
+			continue;
+		}
+
+		if ( !R_ShadowVolumeAllowed( job->tri ) ) {
+			continue;
+		}
+
+		tr.pc.c_createShadowVolumes++;
+
+		// this may derive the face planes of the surface
+		R_CalcInteractionFacing( job->ent, job->tri, job->light, *job->cullInfo );
+
+		tr.shadowVolumeJobs->AddJob( (jobRun_t)R_ShadowVolumeJob, job );
+	}
+
+	if ( tr.shadowVolumeJobs->GetNumJobs() == 0 ) {
+		return;
+	}
+
+	tr.shadowVolumeJobs->Submit();
+	tr.shadowVolumeJobs->Wait();
+
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		shadowVolumeJob_t *job = &jobs[i];
+
+		if ( job->shadowVerts == NULL ) {
+			continue;
+		}
+
+		srfTriangles_t *newTri = R_AllocShadowVolume( job->numShadowVerts, job->numShadowIndexes );
+		SIMDProcessor->Memcpy( newTri->shadowVertexes, job->shadowVerts, newTri->numVerts * sizeof( newTri->shadowVertexes[0] ) );
+		SIMDProcessor->Memcpy( newTri->indexes, job->shadowIndexes, newTri->numIndexes * sizeof( newTri->indexes[0] ) );
+		newTri->numShadowIndexesNoCaps = job->numShadowIndexesNoCaps;
+		newTri->numShadowIndexesNoFrontCaps = job->numShadowIndexesNoFrontCaps;
+		newTri->shadowCapPlaneBits = job->shadowCapPlaneBits;
+
+		Mem_Free16( job->shadowVerts );
+		Mem_Free( job->shadowIndexes );
+		job->shadowVerts = NULL;
+		job->shadowIndexes = NULL;
+
+		job->shadowTris = newTri;
+	}
+}
+
+/*
+=================
+R_BenchmarkShadows_f
+
+Regenerates the clipped shadow volumes of all static models in the
+primary world, serially and with parallel jobs, and reports the throughput.
+The interactions themselves are not changed.
+=================
+*/
+void R_BenchmarkShadows_f( const idCmdArgs &args ) {
+	idRenderWorldLocal	*rw;
+	idList<shadowVolumeJob_t> jobs;
+	srfCullInfo_t		*cullInfos;
+	int					numRuns;
+	int					numSourceTris;
+	int					numVolumes;
+	int					numShadowIndexes;
+	double				msec[2];
+
+	rw = tr.primaryWorld;
+	if ( !rw ) {
+		common->Printf( "No primaryWorld.\n" );
+		return;
+	}
+
+	numRuns = 4;
+	if ( args.Argc() > 1 ) {
+		numRuns = Max( 1, atoi( args.Argv( 1 ) ) );
+	}
+
+	// gather every shadow casting surface of the static models touched by a light
+	numSourceTris = 0;
+	for ( int i = 0 ; i < rw->lightDefs.Num() ; i++ ) {
+		idRenderLightLocal *ldef = rw->lightDefs[i];
+		if ( !ldef ) {
+			continue;
+		}
+		for ( idInteraction *inter = ldef->firstInteraction ; inter != NULL ; inter = inter->lightNext ) {
+			const idRenderEntityLocal *edef = inter->entityDef;
+			const idRenderModel *model = edef->parms.hModel;
+
+			if ( model == NULL || model->IsDynamicModel() != DM_STATIC ) {
+				continue;
+			}
+			for ( int c = 0 ; c < model->NumSurfaces() ; c++ ) {
+				const modelSurface_t *surf = model->Surface( c );
+				const srfTriangles_t *tri = surf->geometry;
+
+				if ( tri == NULL || tri->silEdges == NULL ) {
+					continue;
+				}
+				const idMaterial *shader = R_RemapShaderBySkin( surf->shader, edef->parms.customSkin, edef->parms.customShader );
+				if ( shader == NULL || !shader->SurfaceCastsShadow() ) {
+					continue;
+				}
+				if ( R_CullLocalBox( tri->bounds, edef->modelMatrix, 6, ldef->frustum ) ) {
+					continue;
+				}
+
+				shadowVolumeJob_t &job = jobs.Alloc();
+				memset( &job, 0, sizeof( job ) );
+				job.ent = edef;
+				job.tri = tri;
+				job.light = ldef;
+				job.optimize = SG_STATIC;
+
+				numSourceTris += tri->numIndexes / 3;
+			}
+		}
+	}
+
+	if ( jobs.Num() == 0 ) {
+		common->Printf( "No shadow casting surfaces.\n" );
+		return;
+	}
+
+	cullInfos = (srfCullInfo_t *)R_ClearedStaticAlloc( jobs.Num() * sizeof( cullInfos[0] ) );
+	for ( int i = 0 ; i < jobs.Num() ; i++ ) {
+		jobs[i].cullInfo = &cullInfos[i];
+	}
+
+	bool useParallelShadows = r_useParallelShadows.GetBool();
+
+	numVolumes = 0;
+	numShadowIndexes = 0;
+	for ( int pass = 0 ; pass < 2 ; pass++ ) {
+		r_useParallelShadows.SetBool( pass == 1 );
+
+		msec[pass] = idMath::INFINITY;
+		for ( int run = 0 ; run < numRuns ; run++ ) {
+			idTimer timer;
+
+			timer.Start();
+			R_CreateShadowVolumes( jobs.Ptr(), jobs.Num() );
+			timer.Stop();
+
+			msec[pass] = Min( msec[pass], timer.Milliseconds() );
+
+			numVolumes = 0;
+			numShadowIndexes = 0;
+			for ( int i = 0 ; i < jobs.Num() ; i++ ) {
+				if ( jobs[i].shadowTris ) {
+					numVolumes++;
+					numShadowIndexes += jobs[i].shadowTris->numIndexes;
+					R_FreeStaticTriSurf( jobs[i].shadowTris );
+					jobs[i].shadowTris = NULL;
+				}
+				R_FreeInteractionCullInfo( cullInfos[i] );
+			}
+		}
+	}
+
+	r_useParallelShadows.SetBool( useParallelShadows );
+
+	R_StaticFree( cullInfos );
+
+	common->Printf( "%i surfaces with %i triangles, %i shadow volumes with %i indexes, best of %i runs\n",
+					jobs.Num(), numSourceTris, numVolumes, numShadowIndexes, numRuns );
+	common->Printf( "serial:   %7.2f msec, %6.2f Mtris/sec\n", msec[0], numSourceTris / ( msec[0] * 1000.0 ) );
+	if ( parallelJobManager->GetNumThreads() == 0 ) {
+		common->Printf( "parallel: no job threads\n" );
+		return;
+	}
+	const jobListStats_t &stats = tr.shadowVolumeJobs->GetStats();
+	common->Printf( "parallel: %7.2f msec, %6.2f Mtris/sec, %.2fx, %i jobs on %i threads, longest job %.2f msec\n",
+					msec[1], numSourceTris / ( msec[1] * 1000.0 ), msec[0] / msec[1],
+					stats.numJobs, stats.numThreads, stats.maxJobMicroSec * 0.001f );
+}
@@ -342,9 +342,13 @@ R_FreeStaticTriSurfVertexCaches
 */
 void R_FreeStaticTriSurfVertexCaches( srfTriangles_t *tri ) {
 	if ( tri->ambientSurface == NULL ) {
-		// this is a real model surface
-		vertexCache.Free( tri->ambientCache );
+		// this is a real model surface, GPU skinned surfaces
+		// reference the bind pose of the model they came from
+		if ( tri->jointWeightCache == NULL ) {
+			vertexCache.Free( tri->ambientCache );
+		}
 		tri->ambientCache = NULL;
+		tri->jointWeightCache = NULL;
 	} else {
 		// this is a light interaction surface that references
 		// a different ambient model surface
@@ -496,6 +500,10 @@ void R_FreeStaticTriSurf( srfTriangles_t *tri ) {
 	if ( tri->nextDeferredFree ) {
 		common->Error( "R_FreeStaticTriSurf: freed a freed triangle" );
 	}
+
+	// shadow volumes cached for this surface can't be used anymore
+	R_PurgeCachedShadows( tri );
+
 	frame = frameData;
 
 	if ( !frame ) {
@@ -1657,7 +1665,7 @@ void R_DeriveTangents( srfTriangles_t *tri, bool allocFacePlanes ) {
 		return;
 	}
 
-	tr.pc.c_tangentIndexes += tri->numIndexes;
+	R_JobCounters().c_tangentIndexes += tri->numIndexes;
 
 	if ( !tri->facePlanes && allocFacePlanes ) {
 		R_AllocStaticTriSurfPlanes( tri, tri->numIndexes );
@@ -354,3 +354,369 @@ srfTriangles_t *R_CreateTurboShadowVolume( const idRenderEntityLocal *ent,
 
 	return newTri;
 }
+
+/*
+===============================================================================
+
+	Turbo shadow volume cache.
+
+	A turbo shadow volume only depends on the surface, the light origin and
+	the light frustum in surface space and a few flags. When an interaction is
+	created again, because the light was updated without moving, the entity was
+	updated in place or both moved together, or when another entity with the
+	same model has the same place relative to the light, the volume is taken
+	from the cache instead of being built again.
+
+	Interactions reference the cached volumes. Unreferenced volumes stay in
+	the cache and are evicted in least recently used order to keep the cache
+	within r_shadowCacheSize.
+
+===============================================================================
+*/
+
+#define SHADOW_CACHE_HASH_SIZE			4096
+#define SHADOW_CACHE_ORIGIN_EPSILON		0.01f
+#define SHADOW_CACHE_NORMAL_EPSILON		0.0001f
+#define SHADOW_CACHE_DIST_EPSILON		0.01f
+
+struct shadowCacheEntry_s {
+	shadowCacheKey_t		key;
+	srfTriangles_t *		shadowTris;			// NULL if the surface casts no shadow
+	int						memory;
+	int						refCount;
+	bool					purged;				// the surface was freed, not in the hash table
+	shadowCacheEntry_t *	hashNext;
+	shadowCacheEntry_t *	lruPrev;			// only unreferenced entries are on the lru list
+	shadowCacheEntry_t *	lruNext;
+};
+
+static idBlockAlloc<shadowCacheEntry_t, 256>	shadowCacheAllocator;
+static shadowCacheEntry_t *	shadowCacheHash[SHADOW_CACHE_HASH_SIZE];
+static shadowCacheEntry_t *	shadowCacheLRUHead;		// most recently released
+static shadowCacheEntry_t *	shadowCacheLRUTail;
+static int					shadowCacheEntries;
+static int					shadowCacheMemory;
+static int					shadowCacheHits;
+static int					shadowCacheMisses;
+
+/*
+=====================
+R_ShadowCacheHashKey
+=====================
+*/
+static ID_INLINE int R_ShadowCacheHashKey( const srfTriangles_t *tri ) {
+	return (int)( (size_t)tri >> 4 ) & ( SHADOW_CACHE_HASH_SIZE - 1 );
+}
+
+/*
+=====================
+R_ShadowCacheKeysMatch
+=====================
+*/
+static bool R_ShadowCacheKeysMatch( const shadowCacheKey_t &a, const shadowCacheKey_t &b ) {
+	if ( a.tri != b.tri || a.generation != b.generation || a.flags != b.flags ) {
+		return false;
+	}
+	if ( !a.localLightOrigin.Compare( b.localLightOrigin, SHADOW_CACHE_ORIGIN_EPSILON ) ) {
+		return false;
+	}
+	for ( int i = 0 ; i < 6 ; i++ ) {
+		if ( !a.localClipPlanes[i].Compare( b.localClipPlanes[i], SHADOW_CACHE_NORMAL_EPSILON, SHADOW_CACHE_DIST_EPSILON ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+=====================
+R_LinkShadowCacheLRU
+=====================
+*/
+static void R_LinkShadowCacheLRU( shadowCacheEntry_t *entry ) {
+	entry->lruPrev = NULL;
+	entry->lruNext = shadowCacheLRUHead;
+	if ( shadowCacheLRUHead ) {
+		shadowCacheLRUHead->lruPrev = entry;
+	} else {
+		shadowCacheLRUTail = entry;
+	}
+	shadowCacheLRUHead = entry;
+}
+
+/*
+=====================
+R_UnlinkShadowCacheLRU
+=====================
+*/
+static void R_UnlinkShadowCacheLRU( shadowCacheEntry_t *entry ) {
+	if ( entry->lruPrev ) {
+		entry->lruPrev->lruNext = entry->lruNext;
+	} else {
+		shadowCacheLRUHead = entry->lruNext;
+	}
+	if ( entry->lruNext ) {
+		entry->lruNext->lruPrev = entry->lruPrev;
+	} else {
+		shadowCacheLRUTail = entry->lruPrev;
+	}
+	entry->lruPrev = entry->lruNext = NULL;
+}
+
+/*
+=====================
+R_UnlinkShadowCacheHash
+=====================
+*/
+static void R_UnlinkShadowCacheHash( shadowCacheEntry_t *entry ) {
+	shadowCacheEntry_t **prev;
+
+	for ( prev = &shadowCacheHash[ R_ShadowCacheHashKey( entry->key.tri ) ] ; *prev ; prev = &(*prev)->hashNext ) {
+		if ( *prev == entry ) {
+			*prev = entry->hashNext;
+			break;
+		}
+	}
+	entry->hashNext = NULL;
+}
+
+/*
+=====================
+R_FreeCachedShadow
+
+The entry must not be referenced.
+=====================
+*/
+static void R_FreeCachedShadow( shadowCacheEntry_t *entry ) {
+	if ( !entry->purged ) {
+		R_UnlinkShadowCacheHash( entry );
+		R_UnlinkShadowCacheLRU( entry );
+	}
+
+	// the back end may still draw it this frame, so the free is deferred as usual
+	R_FreeStaticTriSurf( entry->shadowTris );
+
+	shadowCacheMemory -= entry->memory;
+	shadowCacheEntries--;
+	shadowCacheAllocator.Free( entry );
+}
+
+/*
+=====================
+R_TrimShadowCache
+
+Evicts the least recently used entries until the cache fits in r_shadowCacheSize.
+=====================
+*/
+static void R_TrimShadowCache( void ) {
+	int budget = r_shadowCacheSize.GetInteger() * 1024 * 1024;
+
+	while ( shadowCacheMemory > budget && shadowCacheLRUTail ) {
+		R_FreeCachedShadow( shadowCacheLRUTail );
+	}
+}
+
+/*
+=====================
+R_ShadowCacheKey
+=====================
+*/
+void R_ShadowCacheKey( const idRenderEntityLocal *ent, const srfTriangles_t *tri, const idRenderLightLocal *light, int flags, shadowCacheKey_t &key ) {
+	key.tri = tri;
+	key.generation = ent->dynamicModelFrameCount;
+	key.flags = flags;
+
+	R_GlobalPointToLocal( ent->modelMatrix, light->globalLightOrigin, key.localLightOrigin );
+
+	// the light frustum only matters if it is used to cull the shadowing triangles
+	for ( int i = 0 ; i < 6 ; i++ ) {
+		if ( flags & SHADOW_CACHE_PROJECTED_CULL ) {
+			R_GlobalPlaneToLocal( ent->modelMatrix, -light->frustum[i], key.localClipPlanes[i] );
+		} else {
+			key.localClipPlanes[i].Zero();
+		}
+	}
+}
+
+/*
+=====================
+R_FindCachedShadow
+=====================
+*/
+shadowCacheEntry_t *R_FindCachedShadow( const shadowCacheKey_t &key ) {
+	shadowCacheEntry_t *entry;
+
+	for ( entry = shadowCacheHash[ R_ShadowCacheHashKey( key.tri ) ] ; entry ; entry = entry->hashNext ) {
+		if ( R_ShadowCacheKeysMatch( entry->key, key ) ) {
+			break;
+		}
+	}
+
+	if ( !entry ) {
+		shadowCacheMisses++;
+		tr.pc.c_shadowCacheMisses++;
+		return NULL;
+	}
+
+	if ( entry->refCount == 0 ) {
+		R_UnlinkShadowCacheLRU( entry );
+	}
+	entry->refCount++;
+
+	shadowCacheHits++;
+	tr.pc.c_shadowCacheHits++;
+
+	return entry;
+}
+
+/*
+=====================
+R_AddCachedShadow
+
+Returns NULL without taking ownership of the shadow volume if the cache is disabled.
+=====================
+*/
+shadowCacheEntry_t *R_AddCachedShadow( const shadowCacheKey_t &key, srfTriangles_t *shadowTris ) {
+	shadowCacheEntry_t *entry, *next;
+
+	if ( !r_useShadowCache.GetBool() ) {
+		return NULL;
+	}
+
+	int hashKey = R_ShadowCacheHashKey( key.tri );
+
+	// the volumes of an older snapshot of a dynamic model will never be used again
+	for ( entry = shadowCacheHash[hashKey] ; entry ; entry = next ) {
+		next = entry->hashNext;
+		if ( entry->key.tri == key.tri && entry->key.generation != key.generation && entry->refCount == 0 ) {
+			R_FreeCachedShadow( entry );
+		}
+	}
+
+	entry = shadowCacheAllocator.Alloc();
+	entry->key = key;
+	entry->shadowTris = shadowTris;
+	entry->memory = R_TriSurfMemory( shadowTris ) + sizeof( *entry );
+	entry->refCount = 1;
+	entry->purged = false;
+	entry->lruPrev = entry->lruNext = NULL;
+	entry->hashNext = shadowCacheHash[hashKey];
+	shadowCacheHash[hashKey] = entry;
+
+	shadowCacheEntries++;
+	shadowCacheMemory += entry->memory;
+
+	R_TrimShadowCache();
+
+	return entry;
+}
+
+/*
+=====================
+R_CachedShadowTris
+=====================
+*/
+srfTriangles_t *R_CachedShadowTris( const shadowCacheEntry_t *entry ) {
+	return entry->shadowTris;
+}
+
+/*
+=====================
+R_ReleaseCachedShadow
+=====================
+*/
+void R_ReleaseCachedShadow( shadowCacheEntry_t *entry ) {
+	assert( entry->refCount > 0 );
+
+	if ( --entry->refCount > 0 ) {
+		return;
+	}
+
+	if ( entry->purged ) {
+		R_FreeCachedShadow( entry );
+		return;
+	}
+
+	R_LinkShadowCacheLRU( entry );
+
+	if ( !r_useShadowCache.GetBool() ) {
+		R_FreeCachedShadow( entry );
+		return;
+	}
+
+	R_TrimShadowCache();
+}
+
+/*
+=====================
+R_PurgeCachedShadows
+
+Called when a triangle surface is freed, so a new surface at
+the same address can't find the shadow volumes of this one.
+=====================
+*/
+void R_PurgeCachedShadows( const srfTriangles_t *tri ) {
+	shadowCacheEntry_t *entry, *next;
+
+	if ( !shadowCacheEntries ) {
+		return;
+	}
+
+	for ( entry = shadowCacheHash[ R_ShadowCacheHashKey( tri ) ] ; entry ; entry = next ) {
+		next = entry->hashNext;
+		if ( entry->key.tri != tri ) {
+			continue;
+		}
+		if ( entry->refCount == 0 ) {
+			R_FreeCachedShadow( entry );
+		} else {
+			// freed when the last interaction releases it
+			R_UnlinkShadowCacheHash( entry );
+			entry->purged = true;
+		}
+	}
+}
+
+/*
+=====================
+R_PurgeShadowCache
+=====================
+*/
+void R_PurgeShadowCache( void ) {
+	shadowCacheEntry_t *entry, *next;
+
+	for ( int i = 0 ; i < SHADOW_CACHE_HASH_SIZE ; i++ ) {
+		for ( entry = shadowCacheHash[i] ; entry ; entry = next ) {
+			next = entry->hashNext;
+			if ( entry->refCount == 0 ) {
+				R_FreeCachedShadow( entry );
+			} else {
+				R_UnlinkShadowCacheHash( entry );
+				entry->purged = true;
+			}
+		}
+	}
+}
+
+/*
+=====================
+R_ShowShadowCache_f
+=====================
+*/
+void R_ShowShadowCache_f( const idCmdArgs &args ) {
+	shadowCacheEntry_t *entry;
+	int		numUnreferenced = 0;
+	int		unreferencedMemory = 0;
+
+	for ( entry = shadowCacheLRUHead ; entry ; entry = entry->lruNext ) {
+		numUnreferenced++;
+		unreferencedMemory += entry->memory;
+	}
+
+	common->Printf( "%5i shadow volumes, %5i kB\n", shadowCacheEntries, shadowCacheMemory / 1024 );
+	common->Printf( "%5i unreferenced, %5i kB\n", numUnreferenced, unreferencedMemory / 1024 );
+	common->Printf( "%5i kB budget\n", r_shadowCacheSize.GetInteger() * 1024 );
+
+	int lookups = shadowCacheHits + shadowCacheMisses;
+	common->Printf( "%i hits, %i misses (%i%%)\n", shadowCacheHits, shadowCacheMisses, lookups ? shadowCacheHits * 100 / lookups : 0 );
+}
@@ -432,6 +432,8 @@ Loads based on name, possibly doing a MakeDefault if necessary
 ===================
 */
 void idSoundSample::Load( void ) {	
+	idScopedMemTag	memTag( MEM_TAG_SOUND );
+
 	defaultSound = false;
 	purged = false;
 	hardwareBuffer = false;
@@ -88,5 +88,15 @@ void GLimp_DeactivateContext( void ) { }
 
 void GLimp_ActivateContext( void ) { }
 
+bool GLimp_SpawnRenderThread( void (*function)( void ) ) { return false; }
+
+void *GLimp_BackEndSleep( void ) { return NULL; }
+
+void GLimp_FrontEndSleep( void ) { }
+
+void GLimp_WakeBackEnd( void *data ) { }
+
+void GLimp_ShutdownRenderThread( void ) { }
+
 bool GLimp_SetScreenParms( glimpParms_t parms ) { return true; }
 
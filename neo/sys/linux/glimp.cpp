@@ -89,6 +89,9 @@ bool GLimp_SpawnRenderThread(void (*a) ()) {
 	return false;
 }
 
+void GLimp_ShutdownRenderThread() {
+}
+
 void GLimp_ActivateContext() {
 	assert( dpy );
 	assert( ctx );
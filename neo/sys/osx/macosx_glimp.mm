@@ -1446,6 +1446,9 @@ bool GLimp_SpawnRenderThread( void (*function)( void ) ) {
 	return false;
 }
 
+void GLimp_ShutdownRenderThread( void ) {
+}
+
 void *GLimp_RendererSleep(void) {
 	return NULL;
 }
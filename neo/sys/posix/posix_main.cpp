@@ -500,6 +500,91 @@ bool Sys_UnlockMemory( void *ptr, int bytes ) {
 	return true;
 }
 
+/*
+================
+Sys_ReserveMemory
+================
+*/
+void *Sys_ReserveMemory( int bytes ) {
+	void *ptr = mmap( NULL, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+	return ( ptr != MAP_FAILED ) ? ptr : NULL;
+}
+
+/*
+================
+Sys_CommitMemory
+
+Committing pages that are already committed is allowed
+================
+*/
+bool Sys_CommitMemory( void *ptr, int bytes ) {
+	return ( mprotect( ptr, bytes, PROT_READ | PROT_WRITE ) == 0 );
+}
+
+/*
+================
+Sys_ReleaseMemory
+================
+*/
+void Sys_ReleaseMemory( void *ptr, int bytes ) {
+	munmap( ptr, bytes );
+}
+
+/*
+================
+Sys_OpenFileMapping
+================
+*/
+void *Sys_OpenFileMapping( const char *path ) {
+	int fd = open( path, O_RDONLY );
+	if ( fd == -1 ) {
+		return NULL;
+	}
+	return new int( fd );
+}
+
+/*
+================
+Sys_CloseFileMapping
+
+Views that are still mapped stay valid
+================
+*/
+void Sys_CloseFileMapping( void *mapping ) {
+	int *fd = (int *)mapping;
+	close( *fd );
+	delete fd;
+}
+
+/*
+================
+Sys_MapFileView
+
+Views have to start at a multiple of the page size
+================
+*/
+const void *Sys_MapFileView( void *mapping, int offset, int length ) {
+	int		skip;
+	void *	view;
+
+	skip = offset % sysconf( _SC_PAGESIZE );
+	view = mmap( NULL, length + skip, PROT_READ, MAP_SHARED, *(int *)mapping, offset - skip );
+	if ( view == MAP_FAILED ) {
+		return NULL;
+	}
+	return (const byte *)view + skip;
+}
+
+/*
+================
+Sys_UnmapFileView
+================
+*/
+void Sys_UnmapFileView( const void *view, int offset, int length ) {
+	int skip = offset % sysconf( _SC_PAGESIZE );
+	munmap( const_cast<byte *>( (const byte *)view - skip ), length + skip );
+}
+
 /*
 ================
 Sys_SetPhysicalWorkMemory
@@ -35,6 +35,7 @@ If you have questions concerning this license or the applicable additional terms
 #include <sys/time.h>
 #include <pwd.h>
 #include <pthread.h>
+#include <sched.h>
 
 #include "../../idlib/precompiled.h"
 #include "posix_public.h"
@@ -142,6 +143,157 @@ void Sys_TriggerEvent( int index ) {
 	Sys_LeaveCriticalSection( MAX_LOCAL_CRITICAL_SECTIONS - 1 );
 }
 
+/*
+======================================================
+processors, interlocked operations and signals
+======================================================
+*/
+
+/*
+==================
+Sys_GetNumLogicalProcessors
+==================
+*/
+int Sys_GetNumLogicalProcessors( void ) {
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return ( count > 0 ) ? (int)count : 1;
+}
+
+/*
+==================
+Sys_Yield
+==================
+*/
+void Sys_Yield( void ) {
+	sched_yield();
+}
+
+/*
+==================
+Sys_InterlockedIncrement
+==================
+*/
+int Sys_InterlockedIncrement( interlockedInt_t &value ) {
+	return __sync_add_and_fetch( &value, 1 );
+}
+
+/*
+==================
+Sys_InterlockedDecrement
+==================
+*/
+int Sys_InterlockedDecrement( interlockedInt_t &value ) {
+	return __sync_sub_and_fetch( &value, 1 );
+}
+
+/*
+==================
+Sys_InterlockedAdd
+==================
+*/
+int Sys_InterlockedAdd( interlockedInt_t &value, int i ) {
+	return __sync_add_and_fetch( &value, i );
+}
+
+/*
+==================
+Sys_InterlockedExchange
+==================
+*/
+int Sys_InterlockedExchange( interlockedInt_t &value, int exchange ) {
+	// __sync_lock_test_and_set is only an acquire barrier
+	__sync_synchronize();
+	return __sync_lock_test_and_set( &value, exchange );
+}
+
+/*
+==================
+Sys_InterlockedCompareExchange
+==================
+*/
+int Sys_InterlockedCompareExchange( interlockedInt_t &value, int comparand, int exchange ) {
+	return __sync_val_compare_and_swap( &value, comparand, exchange );
+}
+
+typedef struct {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	bool			signaled;
+} posixSignal_t;
+
+/*
+==================
+Sys_SignalCreate
+==================
+*/
+signalHandle_t Sys_SignalCreate( void ) {
+	posixSignal_t *signal = new posixSignal_t;
+	pthread_mutex_init( &signal->mutex, NULL );
+	pthread_cond_init( &signal->cond, NULL );
+	signal->signaled = false;
+	return signal;
+}
+
+/*
+==================
+Sys_SignalDestroy
+==================
+*/
+void Sys_SignalDestroy( signalHandle_t handle ) {
+	posixSignal_t *signal = (posixSignal_t *)handle;
+	pthread_cond_destroy( &signal->cond );
+	pthread_mutex_destroy( &signal->mutex );
+	delete signal;
+}
+
+/*
+==================
+Sys_SignalRaise
+==================
+*/
+void Sys_SignalRaise( signalHandle_t handle ) {
+	posixSignal_t *signal = (posixSignal_t *)handle;
+	pthread_mutex_lock( &signal->mutex );
+	signal->signaled = true;
+	pthread_cond_signal( &signal->cond );
+	pthread_mutex_unlock( &signal->mutex );
+}
+
+/*
+==================
+Sys_SignalWait
+==================
+*/
+bool Sys_SignalWait( signalHandle_t handle, int timeout ) {
+	posixSignal_t *signal = (posixSignal_t *)handle;
+	int result = 0;
+
+	pthread_mutex_lock( &signal->mutex );
+	if ( timeout == SIGNAL_WAIT_INFINITE ) {
+		while ( !signal->signaled ) {
+			pthread_cond_wait( &signal->cond, &signal->mutex );
+		}
+	} else {
+		struct timeval now;
+		struct timespec abstime;
+		gettimeofday( &now, NULL );
+		abstime.tv_sec = now.tv_sec + timeout / 1000;
+		abstime.tv_nsec = now.tv_usec * 1000 + ( timeout % 1000 ) * 1000000;
+		if ( abstime.tv_nsec >= 1000000000 ) {
+			abstime.tv_sec++;
+			abstime.tv_nsec -= 1000000000;
+		}
+		while ( !signal->signaled && result != ETIMEDOUT ) {
+			result = pthread_cond_timedwait( &signal->cond, &signal->mutex, &abstime );
+		}
+	}
+	bool passed = signal->signaled;
+	signal->signaled = false;
+	pthread_mutex_unlock( &signal->mutex );
+
+	return passed;
+}
+
 /*
 ======================================================
 thread create and destroy
@@ -149,7 +301,6 @@ thread create and destroy
 */
 
 // not a hard limit, just what we keep track of for debugging
-#define MAX_THREADS 10
 xthreadInfo *g_threads[MAX_THREADS];
 
 int g_thread_count = 0;
@@ -183,18 +334,10 @@ void Sys_CreateThread( xthread_t function, void *parms, xthreadPriority priority
 
 /*
 ==================
-Sys_DestroyThread
+Sys_ForgetThread
 ==================
 */
-void Sys_DestroyThread( xthreadInfo& info ) {
-	// the target thread must have a cancelation point, otherwise pthread_cancel is useless
-	assert( info.threadHandle );
-	if ( pthread_cancel( ( pthread_t )info.threadHandle ) != 0 ) {
-		common->Error( "ERROR: pthread_cancel %s failed\n", info.name );
-	}
-	if ( pthread_join( ( pthread_t )info.threadHandle, NULL ) != 0 ) {
-		common->Error( "ERROR: pthread_join %s failed\n", info.name );
-	}
+static void Sys_ForgetThread( xthreadInfo& info ) {
 	info.threadHandle = 0;
 	Sys_EnterCriticalSection( );
 	for( int i = 0 ; i < g_thread_count ; i++ ) {
@@ -213,6 +356,40 @@ void Sys_DestroyThread( xthreadInfo& info ) {
 	Sys_LeaveCriticalSection( );
 }
 
+/*
+==================
+Sys_DestroyThread
+==================
+*/
+void Sys_DestroyThread( xthreadInfo& info ) {
+	// the target thread must have a cancelation point, otherwise pthread_cancel is useless
+	assert( info.threadHandle );
+	// a thread that already returned from its function can't be canceled anymore, just join it
+	int result = pthread_cancel( ( pthread_t )info.threadHandle );
+	if ( result != 0 && result != ESRCH ) {
+		common->Error( "ERROR: pthread_cancel %s failed\n", info.name );
+	}
+	if ( pthread_join( ( pthread_t )info.threadHandle, NULL ) != 0 ) {
+		common->Error( "ERROR: pthread_join %s failed\n", info.name );
+	}
+	Sys_ForgetThread( info );
+}
+
+/*
+==================
+Sys_WaitThread
+
+The thread has to leave its function by itself, it isn't canceled
+==================
+*/
+void Sys_WaitThread( xthreadInfo& info ) {
+	assert( info.threadHandle );
+	if ( pthread_join( ( pthread_t )info.threadHandle, NULL ) != 0 ) {
+		common->Error( "ERROR: pthread_join %s failed\n", info.name );
+	}
+	Sys_ForgetThread( info );
+}
+
 /*
 ==================
 Sys_GetThreadName
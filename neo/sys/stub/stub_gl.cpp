@@ -384,6 +384,7 @@ void GLimp_FrontEndSleep() {};
 void GLimp_ActivateContext() {};
 void GLimp_DeactivateContext() {};
 bool GLimp_SpawnRenderThread(void (*a)()) {return false;};
+void GLimp_ShutdownRenderThread() {};
 
 static void StubFunction( void ) {};
 GLExtension_t GLimp_ExtensionPointer( const char *a) { return StubFunction; };
@@ -56,6 +56,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #define ID_INLINE						__forceinline
 #define ID_STATIC_TEMPLATE				static
+#define ID_TLS							__declspec( thread )
 
 #define assertmem( x, y )				assert( _CrtIsValidPointer( x, y, true ) )
 
@@ -94,6 +95,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #define ID_INLINE						inline
 #define ID_STATIC_TEMPLATE
+#define ID_TLS							__thread
 
 #define assertmem( x, y )
 
@@ -128,6 +130,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #define ID_INLINE						inline
 #define ID_STATIC_TEMPLATE
+#define ID_TLS							__thread
 
 #define assertmem( x, y )
 
@@ -315,6 +318,18 @@ void			Sys_GetExeLaunchMemoryStatus( sysMemoryStats_t &stats );
 bool			Sys_LockMemory( void *ptr, int bytes );
 bool			Sys_UnlockMemory( void *ptr, int bytes );
 
+// reserve a range of address space, parts of it have to be committed before they can be used
+void *			Sys_ReserveMemory( int bytes );
+bool			Sys_CommitMemory( void *ptr, int bytes );
+void			Sys_ReleaseMemory( void *ptr, int bytes );
+
+// read only file mappings, views of parts of the file are mapped on demand
+// so large files don't take up address space, both return NULL on failure
+void *			Sys_OpenFileMapping( const char *path );
+void			Sys_CloseFileMapping( void *mapping );
+const void *	Sys_MapFileView( void *mapping, int offset, int length );
+void			Sys_UnmapFileView( const void *view, int offset, int length );
+
 // set amount of physical work memory
 void			Sys_SetPhysicalWorkMemory( int minBytes, int maxBytes );
 
@@ -491,24 +506,27 @@ typedef struct {
 	unsigned long	threadId;
 } xthreadInfo;
 
-const int MAX_THREADS				= 10;
+const int MAX_THREADS				= 64;
 extern xthreadInfo *g_threads[MAX_THREADS];
 extern int			g_thread_count;
 
 void				Sys_CreateThread( xthread_t function, void *parms, xthreadPriority priority, xthreadInfo &info, const char *name, xthreadInfo *threads[MAX_THREADS], int *thread_count );
 void				Sys_DestroyThread( xthreadInfo& info ); // sets threadHandle back to 0
+void				Sys_WaitThread( xthreadInfo& info );	// like Sys_DestroyThread, but waits for the thread function to return
 
 // find the name of the calling thread
 // if index != NULL, set the index in g_threads array (use -1 for "main" thread)
 const char *		Sys_GetThreadName( int *index = 0 );
  
-const int MAX_CRITICAL_SECTIONS		= 4;
+const int MAX_CRITICAL_SECTIONS		= 6;
 
 enum {
 	CRITICAL_SECTION_ZERO = 0,
 	CRITICAL_SECTION_ONE,
 	CRITICAL_SECTION_TWO,
-	CRITICAL_SECTION_THREE
+	CRITICAL_SECTION_THREE,
+	CRITICAL_SECTION_FOUR,
+	CRITICAL_SECTION_FIVE
 };
 
 void				Sys_EnterCriticalSection( int index = CRITICAL_SECTION_ZERO );
@@ -526,6 +544,31 @@ enum {
 void				Sys_WaitForEvent( int index = TRIGGER_EVENT_ZERO );
 void				Sys_TriggerEvent( int index = TRIGGER_EVENT_ZERO );
 
+// number of logical processors the OS will schedule threads on
+int					Sys_GetNumLogicalProcessors( void );
+
+// give up the remainder of the time slice to another ready thread
+void				Sys_Yield( void );
+
+// interlocked operations on a 32 bit integer, all of them act as a full memory barrier
+typedef volatile int	interlockedInt_t;
+
+int					Sys_InterlockedIncrement( interlockedInt_t &value );		// returns the new value
+int					Sys_InterlockedDecrement( interlockedInt_t &value );		// returns the new value
+int					Sys_InterlockedAdd( interlockedInt_t &value, int i );		// returns the new value
+int					Sys_InterlockedExchange( interlockedInt_t &value, int exchange );	// returns the old value
+int					Sys_InterlockedCompareExchange( interlockedInt_t &value, int comparand, int exchange );	// returns the old value
+
+// auto-reset signals, a raised signal stays raised until exactly one wait passes through it
+typedef void *		signalHandle_t;
+
+const int SIGNAL_WAIT_INFINITE		= -1;
+
+signalHandle_t		Sys_SignalCreate( void );
+void				Sys_SignalDestroy( signalHandle_t signal );
+void				Sys_SignalRaise( signalHandle_t signal );
+bool				Sys_SignalWait( signalHandle_t signal, int timeout );	// returns false if the wait timed out
+
 /*
 ==============================================================
 
@@ -277,6 +277,36 @@ void GLW_WM_CREATE( HWND hWnd ) {
 
 
 
+/*
+====================
+GLW_CreateContext
+
+Creates a context for win32.hDC, which shares its objects
+with shareContext if that isn't NULL
+====================
+*/
+static HGLRC GLW_CreateContext( HGLRC shareContext ) {
+	HGLRC	hGLRC;
+
+    if (wglCreateContextAttribsARB) {
+        // Create OpenGL 3.3 compatible profile context
+        const int ctxAttribs[] = {
+            WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
+            WGL_CONTEXT_MINOR_VERSION_ARB, 3,
+            WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB,
+            0, 0
+        };
+        return wglCreateContextAttribsARB(win32.hDC, shareContext, ctxAttribs);
+    }
+
+	hGLRC = wglCreateContext( win32.hDC );
+	if ( hGLRC && shareContext && !wglShareLists( shareContext, hGLRC ) ) {
+		wglDeleteContext( hGLRC );
+		hGLRC = NULL;
+	}
+	return hGLRC;
+}
+
 /*
 ====================
 GLW_InitDriver
@@ -394,19 +424,7 @@ static bool GLW_InitDriver( glimpParms_t parms ) {
 	//
 	common->Printf( "...creating GL context: " );
 
-    win32.hGLRC = 0;
-    if (wglCreateContextAttribsARB) {
-        // Create OpenGL 3.3 compatible profile context
-        const int ctxAttribs[] = {
-            WGL_CONTEXT_MAJOR_VERSION_ARB, 3,
-            WGL_CONTEXT_MINOR_VERSION_ARB, 3,
-            WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_COMPATIBILITY_PROFILE_BIT_ARB,
-            0, 0
-        };
-        win32.hGLRC = wglCreateContextAttribsARB(win32.hDC, NULL, ctxAttribs);
-    } else {
-        win32.hGLRC = wglCreateContext(win32.hDC);
-    }
+    win32.hGLRC = GLW_CreateContext( NULL );
 
 	if ( win32.hGLRC == 0 ) {
 		common->Printf( "^3failed^0\n" );
@@ -1023,6 +1041,9 @@ GLimp_RenderThreadWrapper
 ===================
 */
 static void GLimp_RenderThreadWrapper( void ) {
+	// the spawning thread switched to the front end context
+	wglMakeCurrent( win32.hDC, win32.hGLRC );
+
 	win32.glimpRenderThread();
 
 	// unbind the context before we die
@@ -1044,6 +1065,21 @@ bool GLimp_SpawnRenderThread( void (*function)( void ) ) {
 	if ( info.dwNumberOfProcessors < 2 ) {
 		return false;
 	}
+
+	// the front end keeps on uploading buffers and textures, so it gets a
+	// context of its own which shares the objects of the main context
+	win32.hGLRCFrontEnd = GLW_CreateContext( win32.hGLRC );
+	if ( !win32.hGLRCFrontEnd ) {
+		common->Printf( "...^3couldn't create a shared GL context^0\n" );
+		return false;
+	}
+	if ( !wglMakeCurrent( win32.hDC, win32.hGLRCFrontEnd ) ) {
+		wglDeleteContext( win32.hGLRCFrontEnd );
+		win32.hGLRCFrontEnd = NULL;
+		wglMakeCurrent( win32.hDC, win32.hGLRC );
+		common->Printf( "...^3couldn't make the shared GL context current^0\n" );
+		return false;
+	}
 	
 	// create the IPC elements
 	win32.renderCommandsEvent = CreateEvent( NULL, TRUE, FALSE, NULL );
@@ -1074,6 +1110,40 @@ bool GLimp_SpawnRenderThread( void (*function)( void ) ) {
 	return true;
 }
 
+/*
+===========================
+GLimp_ShutdownRenderThread
+
+The render thread function has to return, after
+GLimp_WakeBackEnd handed it NULL
+===========================
+*/
+void GLimp_ShutdownRenderThread( void ) {
+	if ( !win32.renderThreadHandle ) {
+		return;
+	}
+
+	WaitForSingleObject( win32.renderThreadHandle, INFINITE );
+	CloseHandle( win32.renderThreadHandle );
+	win32.renderThreadHandle = NULL;
+
+	CloseHandle( win32.renderCommandsEvent );
+	CloseHandle( win32.renderCompletedEvent );
+	CloseHandle( win32.renderActiveEvent );
+	win32.renderCommandsEvent = NULL;
+	win32.renderCompletedEvent = NULL;
+	win32.renderActiveEvent = NULL;
+
+	// take the main context back from the render thread
+	if ( !wglMakeCurrent( win32.hDC, win32.hGLRC ) ) {
+		win32.wglErrors++;
+	}
+	if ( win32.hGLRCFrontEnd ) {
+		wglDeleteContext( win32.hGLRCFrontEnd );
+		win32.hGLRCFrontEnd = NULL;
+	}
+}
+
 
 //#define	DEBUG_PRINTS
 
@@ -108,6 +108,7 @@ typedef struct {
 
 	HDC				hDC;							// handle to device context
 	HGLRC			hGLRC;						// handle to GL rendering context
+	HGLRC			hGLRCFrontEnd;				// shares objects with hGLRC, used by the front end while the render thread owns hGLRC
 	PIXELFORMATDESCRIPTOR pfd;		
 	int				pixelformat;
 
@@ -122,6 +122,15 @@ void Sys_DestroyThread( xthreadInfo& info ) {
 	info.threadHandle = 0;
 }
 
+/*
+==================
+Sys_WaitThread
+==================
+*/
+void Sys_WaitThread( xthreadInfo& info ) {
+	Sys_DestroyThread( info );
+}
+
 /*
 ==================
 Sys_Sentry
@@ -200,6 +209,112 @@ void Sys_TriggerEvent( int index ) {
 	SetEvent( win32.backgroundDownloadSemaphore );
 }
 
+/*
+==================
+Sys_GetNumLogicalProcessors
+==================
+*/
+int Sys_GetNumLogicalProcessors( void ) {
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return ( info.dwNumberOfProcessors > 0 ) ? info.dwNumberOfProcessors : 1;
+}
+
+/*
+==================
+Sys_Yield
+==================
+*/
+void Sys_Yield( void ) {
+	SwitchToThread();
+}
+
+/*
+==================
+Sys_InterlockedIncrement
+==================
+*/
+int Sys_InterlockedIncrement( interlockedInt_t &value ) {
+	return InterlockedIncrement( (volatile LONG *)&value );
+}
+
+/*
+==================
+Sys_InterlockedDecrement
+==================
+*/
+int Sys_InterlockedDecrement( interlockedInt_t &value ) {
+	return InterlockedDecrement( (volatile LONG *)&value );
+}
+
+/*
+==================
+Sys_InterlockedAdd
+==================
+*/
+int Sys_InterlockedAdd( interlockedInt_t &value, int i ) {
+	return InterlockedExchangeAdd( (volatile LONG *)&value, i ) + i;
+}
+
+/*
+==================
+Sys_InterlockedExchange
+==================
+*/
+int Sys_InterlockedExchange( interlockedInt_t &value, int exchange ) {
+	return InterlockedExchange( (volatile LONG *)&value, exchange );
+}
+
+/*
+==================
+Sys_InterlockedCompareExchange
+==================
+*/
+int Sys_InterlockedCompareExchange( interlockedInt_t &value, int comparand, int exchange ) {
+	return InterlockedCompareExchange( (volatile LONG *)&value, exchange, comparand );
+}
+
+/*
+==================
+Sys_SignalCreate
+==================
+*/
+signalHandle_t Sys_SignalCreate( void ) {
+	HANDLE handle = CreateEvent( NULL, FALSE, FALSE, NULL );
+	if ( handle == NULL ) {
+		common->FatalError( "Sys_SignalCreate: CreateEvent failed" );
+	}
+	return handle;
+}
+
+/*
+==================
+Sys_SignalDestroy
+==================
+*/
+void Sys_SignalDestroy( signalHandle_t signal ) {
+	CloseHandle( (HANDLE)signal );
+}
+
+/*
+==================
+Sys_SignalRaise
+==================
+*/
+void Sys_SignalRaise( signalHandle_t signal ) {
+	SetEvent( (HANDLE)signal );
+}
+
+/*
+==================
+Sys_SignalWait
+==================
+*/
+bool Sys_SignalWait( signalHandle_t signal, int timeout ) {
+	DWORD result = WaitForSingleObject( (HANDLE)signal, ( timeout == SIGNAL_WAIT_INFINITE ) ? INFINITE : timeout );
+	return ( result == WAIT_OBJECT_0 );
+}
+
 
 
 #pragma optimize( "", on )
@@ -222,6 +222,104 @@ bool Sys_UnlockMemory( void *ptr, int bytes ) {
 	return ( VirtualUnlock( ptr, (SIZE_T)bytes ) != FALSE );
 }
 
+/*
+================
+Sys_ReserveMemory
+================
+*/
+void *Sys_ReserveMemory( int bytes ) {
+	return VirtualAlloc( NULL, (SIZE_T)bytes, MEM_RESERVE, PAGE_NOACCESS );
+}
+
+/*
+================
+Sys_CommitMemory
+
+Committing pages that are already committed is allowed
+================
+*/
+bool Sys_CommitMemory( void *ptr, int bytes ) {
+	return ( VirtualAlloc( ptr, (SIZE_T)bytes, MEM_COMMIT, PAGE_READWRITE ) != NULL );
+}
+
+/*
+================
+Sys_ReleaseMemory
+================
+*/
+void Sys_ReleaseMemory( void *ptr, int bytes ) {
+	VirtualFree( ptr, 0, MEM_RELEASE );
+}
+
+/*
+================
+Sys_OpenFileMapping
+================
+*/
+void *Sys_OpenFileMapping( const char *path ) {
+	HANDLE	file, mapping;
+
+	file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+	mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	// the mapping object keeps the file open
+	CloseHandle( file );
+	return mapping;
+}
+
+/*
+================
+Sys_CloseFileMapping
+
+Views that are still mapped stay valid
+================
+*/
+void Sys_CloseFileMapping( void *mapping ) {
+	CloseHandle( mapping );
+}
+
+/*
+================
+Sys_FileViewAlignment
+================
+*/
+static int Sys_FileViewAlignment( void ) {
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+	return info.dwAllocationGranularity;
+}
+
+/*
+================
+Sys_MapFileView
+
+Views have to start at a multiple of the allocation granularity
+================
+*/
+const void *Sys_MapFileView( void *mapping, int offset, int length ) {
+	int		skip;
+	byte *	view;
+
+	skip = offset % Sys_FileViewAlignment();
+	view = (byte *)MapViewOfFile( mapping, FILE_MAP_READ, 0, offset - skip, length + skip );
+	if ( view == NULL ) {
+		return NULL;
+	}
+	return view + skip;
+}
+
+/*
+================
+Sys_UnmapFileView
+================
+*/
+void Sys_UnmapFileView( const void *view, int offset, int length ) {
+	UnmapViewOfFile( (const byte *)view - offset % Sys_FileViewAlignment() );
+}
+
 /*
 ================
 Sys_SetPhysicalWorkMemory
@@ -184,6 +184,8 @@ void idUserInterfaceManagerLocal::DeAlloc( idUserInterface *gui ) {
 idUserInterface *idUserInterfaceManagerLocal::FindGui( const char *qpath, bool autoLoad, bool needUnique, bool forceNOTUnique ) {
 	int c = guis.Num();
 
+	idScopedMemTag	memTag( MEM_TAG_GUI );
+
 	for ( int i = 0; i < c; i++ ) {
 		idUserInterfaceLocal *gui = guis[i];
 		if ( !idStr::Icmp( guis[i]->GetSourceFile(), qpath ) ) {